@@ -3,6 +3,8 @@
  *
  * Android native module for Embedded Timing Fingerprint Authentication.
  * Collects device-specific timing fingerprints and submits to ETFA lattice.
+ * CPU kernels run in the shared native library (libestream_app_jni, see
+ * cpp/src/etfa.cpp); GPU kernels use GLES here.
  *
  * @package io.estream.app
  */
@@ -25,8 +27,10 @@ import android.util.Log
 import com.facebook.react.bridge.*
 import com.facebook.react.modules.core.DeviceEventManagerModule
 import kotlinx.coroutines.*
+import org.json.JSONArray
+import org.json.JSONObject
+import java.io.File
 import java.security.MessageDigest
-import java.security.SecureRandom
 import java.util.UUID
 import java.util.concurrent.CountDownLatch
 import java.util.concurrent.TimeUnit
@@ -47,20 +51,54 @@ class ETFAModule(reactContext: ReactApplicationContext) :
         private const val EVENT_PROGRESS = "onETFAProgress"
         private const val EVENT_COMPLETE = "onETFAComplete"
         private const val EVENT_ERROR = "onETFAError"
+
+        // Reference fingerprints, one snapshot in the app's files dir
+        private const val INDEX_FILE = "etfa_references.idx"
+        private const val INDEX_PROBES = 8
+
+        init {
+            System.loadLibrary("estream_app_jni")
+        }
+    }
+
+    /** Kernel progress from native code: label and fraction done. */
+    fun interface NativeProgressListener {
+        fun onProgress(label: String, progress: Float)
     }
 
+    /**
+     * estream_etfa_collect_parallel(): JSON with per-kernel medians and CPU
+     * ratios of each core cluster (fastest first, also at the top level).
+     */
+    private external fun nativeCollect(sampleCount: Int, listener: NativeProgressListener?): String?
+
+    /** estream_etfa_fingerprint_code(): 32 hex digits of the quantized ratios. */
+    private external fun nativeFingerprintCode(ratios: DoubleArray): String?
+
+    // estream_etfa_index_*: nativeIndexOpen loads the snapshot or starts empty.
+    private external fun nativeIndexOpen(path: String): Long
+    private external fun nativeIndexSave(index: Long, path: String): Int
+    private external fun nativeIndexAdd(index: Long, id: String, ratios: DoubleArray): Int
+    private external fun nativeIndexRemove(index: Long, id: String): Int
+    private external fun nativeIndexSize(index: Long): Int
+    private external fun nativeIndexTrain(index: Long): Int
+    private external fun nativeIndexSearch(index: Long, ratios: DoubleArray, k: Int, probes: Int): String?
+
+    /** CPU ratios computed natively, in stableRatios order. */
+    private val cpuRatioNames = listOf(
+        "r5_mem_seq_to_rand", "r6_mem_copy_to_seq", "r7_int_to_float", "r9_float_to_matrix",
+        "r10_seq_4k_to_64k", "r11_seq_64k_to_1m", "r12_seq_1m_to_4m", "r13_rand_4k_to_64k",
+        "r14_rand_64k_to_1m", "r18_int_mul_32_to_64", "r19_int_div_32_to_64", "r22_int_mul_to_div",
+        "r24_add_chain_to_parallel", "r25_int_to_bitwise"
+    )
+
     private val scope = CoroutineScope(Dispatchers.Default + SupervisorJob())
-    
-    // Pre-allocated buffers
-    private val data1KB = ByteArray(1024) { it.toByte() }
-    private val data64KB = ByteArray(65536) { it.toByte() }
-    private val aesKey = ByteArray(32).also { SecureRandom().nextBytes(it) }
-    private val memBuffer1M = ByteArray(1024 * 1024) { it.toByte() }
-    private val memBuffer4M = ByteArray(4 * 1024 * 1024) { it.toByte() }
-    private val randomIndices1M = (0 until 1024 * 1024).shuffled().toIntArray()
-    
-    @Volatile private var blackhole: Any? = null
 
+    private val indexPath: String
+        get() = File(reactApplicationContext.filesDir, INDEX_FILE).absolutePath
+
+    private var referenceIndex = -1L
+    
     override fun getName(): String = MODULE_NAME
 
     // ==========================================================================
@@ -110,9 +148,25 @@ class ETFAModule(reactContext: ReactApplicationContext) :
                     val ratiosArray = Arguments.createArray()
                     fingerprint.stableRatios.forEach { ratiosArray.pushDouble(it) }
                     putArray("stableRatios", ratiosArray)
+
+                    // CPU ratios per core cluster, fastest first
+                    val clustersArray = Arguments.createArray()
+                    fingerprint.clusters.forEach { cluster ->
+                        val clusterRatios = Arguments.createArray()
+                        cluster.stableRatios.forEach { clusterRatios.pushDouble(it) }
+                        clustersArray.pushMap(Arguments.createMap().apply {
+                            putInt("id", cluster.id)
+                            putInt("cpuCount", cluster.cpuCount)
+                            putBoolean("pinned", cluster.pinned)
+                            putInt("migratedSamples", cluster.migratedSamples)
+                            putArray("stableRatios", clusterRatios)
+                        })
+                    }
+                    putArray("clusters", clustersArray)
                     
                     // Device fingerprint hash
                     putString("fingerprintHash", fingerprint.hash)
+                    putString("fingerprintCode", fingerprint.code)
                 }
                 
                 promise.resolve(result)
@@ -150,6 +204,105 @@ class ETFAModule(reactContext: ReactApplicationContext) :
         promise.resolve(true)
     }
 
+    // ==========================================================================
+    // Reference Index
+    // ==========================================================================
+
+    /**
+     * Store the stable ratios of a known device under `id` (replacing any
+     * previous entry) and persist the index.
+     */
+    @ReactMethod
+    fun addReference(id: String, ratios: ReadableArray, promise: Promise) {
+        scope.launch {
+            try {
+                val index = openIndex()
+                val size = synchronized(this@ETFAModule) {
+                    if (nativeIndexAdd(index, id, ratios.toDoubleArray()) != 0) {
+                        throw IllegalArgumentException("Invalid reference fingerprint")
+                    }
+                    saveIndex(index)
+                }
+                promise.resolve(size)
+            } catch (e: Exception) {
+                promise.reject("ETFA_INDEX_ERROR", e.message, e)
+            }
+        }
+    }
+
+    @ReactMethod
+    fun removeReference(id: String, promise: Promise) {
+        scope.launch {
+            try {
+                val index = openIndex()
+                val removed = synchronized(this@ETFAModule) {
+                    (nativeIndexRemove(index, id) == 0).also { if (it) saveIndex(index) }
+                }
+                promise.resolve(removed)
+            } catch (e: Exception) {
+                promise.reject("ETFA_INDEX_ERROR", e.message, e)
+            }
+        }
+    }
+
+    /**
+     * The `k` stored references closest to `ratios`, closest first. A
+     * re-measured device matches its reference with a small distance even
+     * when individual ratios have drifted.
+     */
+    @ReactMethod
+    fun findNearest(ratios: ReadableArray, k: Int, promise: Promise) {
+        scope.launch {
+            try {
+                val json = nativeIndexSearch(openIndex(), ratios.toDoubleArray(), maxOf(k, 1), INDEX_PROBES)
+                    ?: throw IllegalArgumentException("Invalid fingerprint")
+                val data = JSONObject(json).getJSONObject("data")
+                val matches = data.getJSONArray("matches")
+                val matchesArray = Arguments.createArray()
+                for (i in 0 until matches.length()) {
+                    val match = matches.getJSONObject(i)
+                    matchesArray.pushMap(Arguments.createMap().apply {
+                        putString("id", match.getString("id"))
+                        putDouble("distance", match.getDouble("distance"))
+                        putDouble("similarity", match.getDouble("similarity"))
+                    })
+                }
+                promise.resolve(Arguments.createMap().apply {
+                    putInt("size", data.getInt("size"))
+                    putInt("scanned", data.getInt("scanned"))
+                    putArray("matches", matchesArray)
+                })
+            } catch (e: Exception) {
+                promise.reject("ETFA_INDEX_ERROR", e.message, e)
+            }
+        }
+    }
+
+    @Synchronized
+    private fun openIndex(): Long {
+        if (referenceIndex < 0) {
+            referenceIndex = nativeIndexOpen(indexPath)
+            // Switches to coarse cells once the set is large enough to need them
+            nativeIndexTrain(referenceIndex)
+        }
+        return referenceIndex
+    }
+
+    /** Retrains when the set has doubled since the last save, then saves. */
+    private fun saveIndex(index: Long): Int {
+        val size = nativeIndexSize(index)
+        if (size > 0 && (size and (size - 1)) == 0) {
+            nativeIndexTrain(index)
+        }
+        if (nativeIndexSave(index, indexPath) != 0) {
+            Log.w(TAG, "Failed to save reference index")
+        }
+        return size
+    }
+
+    private fun ReadableArray.toDoubleArray(): DoubleArray =
+        DoubleArray(size()) { i -> getDouble(i) }
+
     // ==========================================================================
     // Fingerprint Generation
     // ==========================================================================
@@ -163,14 +316,24 @@ class ETFAModule(reactContext: ReactApplicationContext) :
         val r18: Double, val r19: Double, val r22: Double, val r24: Double, val r25: Double,
         val r28: Double, val r29: Double,
         val stableRatios: List<Double>,
-        val hash: String
+        val clusters: List<ClusterRatios>,
+        val hash: String,
+        val code: String
+    )
+
+    private data class ClusterRatios(
+        val id: Int,
+        val cpuCount: Int,
+        val pinned: Boolean,
+        val migratedSamples: Int,
+        val stableRatios: List<Double>
     )
 
     private fun generateFingerprint(
         sampleCount: Int,
         onProgress: (String, Float) -> Unit
     ): Fingerprint {
-        val totalOps = 25
+        val totalOps = 22
         var completed = 0
         
         fun report(name: String) {
@@ -178,69 +341,15 @@ class ETFAModule(reactContext: ReactApplicationContext) :
             onProgress(name, completed.toFloat() / totalOps)
         }
         
-        // GC before measurement
-        System.gc()
-        Thread.sleep(100)
-        
         report("Warmup")
         
-        // Phase 1: Memory operations
-        val memSeq = measureMedian(sampleCount) { memSequential() }
-        report("Memory Sequential")
-        
-        val memRand = measureMedian(sampleCount) { memRandom() }
-        report("Memory Random")
-        
-        val memCopy = measureMedian(sampleCount) { memCopy() }
-        report("Memory Copy")
-        
-        // Phase 1: Compute operations
-        val intMult = measureMedian(sampleCount) { intMultiply() }
-        report("Int Multiply")
-        
-        val floatMult = measureMedian(sampleCount) { floatMultiply() }
-        report("Float Multiply")
-        
-        val vecDot = measureMedian(sampleCount) { vectorDot() }
-        report("Vector Dot")
-        
-        val matrixOp = measureMedian(sampleCount) { matrixOp() }
-        report("Matrix Op")
-        
-        // Phase 2: Memory hierarchy
-        val seq4k = measureMedian(sampleCount) { memSequential4K() }
-        report("Seq 4K")
-        
-        val seq64k = measureMedian(sampleCount) { memSequential64K() }
-        report("Seq 64K")
-        
-        val seq4m = measureMedian(sampleCount) { memSequential4M() }
-        report("Seq 4M")
-        
-        val rand4k = measureMedian(sampleCount) { memRandom4K() }
-        report("Rand 4K")
-        
-        val rand64k = measureMedian(sampleCount) { memRandom64K() }
-        report("Rand 64K")
-        
-        // Phase 3: Precision variants
-        val intMul32 = measureMedian(sampleCount) { intMultiply32() }
-        report("Int Mul 32")
-        
-        val intDiv32 = measureMedian(sampleCount) { intDivide32() }
-        report("Int Div 32")
-        
-        val intDiv64 = measureMedian(sampleCount) { intDivide64() }
-        report("Int Div 64")
-        
-        val addChain = measureMedian(sampleCount) { intAddChain() }
-        report("Add Chain")
-        
-        val addParallel = measureMedian(sampleCount) { intAddParallel() }
-        report("Add Parallel")
-        
-        val bitwise = measureMedian(sampleCount) { bitwiseOps() }
-        report("Bitwise")
+        // Phases 1-3: memory, compute and precision kernels (native, all
+        // core clusters in parallel)
+        val nativeResult = collectNativeRatios(sampleCount) { label, fraction ->
+            onProgress(label, (1 + fraction * 18) / totalOps)
+        }
+        val cpuRatios = nativeResult.getJSONObject("ratios")
+        completed += 18
         
         // Phase 4: GPU (fewer samples - slower)
         val gpuVertex = measureMedian(minOf(sampleCount, 50)) { gpuShaderVertex() }
@@ -252,23 +361,23 @@ class ETFAModule(reactContext: ReactApplicationContext) :
         val gpuLink = measureMedian(minOf(sampleCount, 50)) { gpuProgramLink() }
         report("GPU Link")
         
-        // Compute ratios
         fun ratio(a: Long, b: Long) = if (b > 0) a.toDouble() / b else 0.0
-        
-        val r5 = ratio(memSeq, memRand)
-        val r6 = ratio(memCopy, memSeq)
-        val r7 = ratio(intMult, floatMult)
-        val r9 = ratio(floatMult, matrixOp)
-        val r10 = ratio(seq4k, seq64k)
-        val r11 = ratio(seq64k, memSeq)
-        val r12 = ratio(memSeq, seq4m)
-        val r13 = ratio(rand4k, rand64k)
-        val r14 = ratio(rand64k, memRand)
-        val r18 = ratio(intMul32, intMult)
-        val r19 = ratio(intDiv32, intDiv64)
-        val r22 = ratio(intMult, intDiv64)
-        val r24 = ratio(addChain, addParallel)
-        val r25 = ratio(intMult, bitwise)
+        fun cpu(name: String) = cpuRatios.optDouble(name, 0.0)
+        
+        val r5 = cpu("r5_mem_seq_to_rand")
+        val r6 = cpu("r6_mem_copy_to_seq")
+        val r7 = cpu("r7_int_to_float")
+        val r9 = cpu("r9_float_to_matrix")
+        val r10 = cpu("r10_seq_4k_to_64k")
+        val r11 = cpu("r11_seq_64k_to_1m")
+        val r12 = cpu("r12_seq_1m_to_4m")
+        val r13 = cpu("r13_rand_4k_to_64k")
+        val r14 = cpu("r14_rand_64k_to_1m")
+        val r18 = cpu("r18_int_mul_32_to_64")
+        val r19 = cpu("r19_int_div_32_to_64")
+        val r22 = cpu("r22_int_mul_to_div")
+        val r24 = cpu("r24_add_chain_to_parallel")
+        val r25 = cpu("r25_int_to_bitwise")
         val r28 = ratio(gpuVertex, gpuFragment)
         val r29 = ratio(gpuVertex, gpuLink)
         
@@ -286,7 +395,9 @@ class ETFAModule(reactContext: ReactApplicationContext) :
             r18 = r18, r19 = r19, r22 = r22, r24 = r24, r25 = r25,
             r28 = r28, r29 = r29,
             stableRatios = stableRatios,
-            hash = hash
+            clusters = parseClusters(nativeResult.getJSONArray("clusters")),
+            hash = hash,
+            code = codeRatios(stableRatios)
         )
     }
 
@@ -300,10 +411,46 @@ class ETFAModule(reactContext: ReactApplicationContext) :
         return md.digest().joinToString("") { "%02x".format(it) }.take(32)
     }
 
+    /**
+     * Quantized code of the ratios (1/16-octave steps, one byte each). Small
+     * drift moves single bytes rather than the whole value; use findNearest
+     * for tolerant matching.
+     */
+    private fun codeRatios(ratios: List<Double>): String =
+        nativeFingerprintCode(ratios.toDoubleArray())
+            ?: throw IllegalStateException("Native fingerprint code failed")
+
     // ==========================================================================
     // Timing Operations
     // ==========================================================================
 
+    /**
+     * Run the shared C++ CPU kernels on every core cluster at once and return
+     * the report's data object. The JNI glue delivers progress on this thread.
+     */
+    private fun collectNativeRatios(
+        sampleCount: Int,
+        onProgress: (String, Float) -> Unit
+    ): JSONObject {
+        val json = nativeCollect(maxOf(sampleCount, 1)) { label, progress ->
+            onProgress(label, progress)
+        } ?: throw IllegalStateException("Native ETFA kernel collection failed")
+        return JSONObject(json).getJSONObject("data")
+    }
+
+    private fun parseClusters(clusters: JSONArray): List<ClusterRatios> =
+        (0 until clusters.length()).map { i ->
+            val cluster = clusters.getJSONObject(i)
+            val ratios = cluster.getJSONObject("ratios")
+            ClusterRatios(
+                id = cluster.getInt("id"),
+                cpuCount = cluster.getInt("cpu_count"),
+                pinned = cluster.getBoolean("pinned"),
+                migratedSamples = cluster.getInt("migrated_samples"),
+                stableRatios = cpuRatioNames.map { ratios.optDouble(it, 0.0) }
+            )
+        }
+
     private inline fun measureMedian(samples: Int, op: () -> Long): Long {
         val results = LongArray(samples)
         repeat(samples) { i -> results[i] = op() }
@@ -313,197 +460,6 @@ class ETFAModule(reactContext: ReactApplicationContext) :
 
     private fun nowNanos(): Long = System.nanoTime()
 
-    private fun memSequential(): Long {
-        val start = nowNanos()
-        var sum = 0L
-        for (i in memBuffer1M.indices) sum += memBuffer1M[i]
-        blackhole = sum
-        return nowNanos() - start
-    }
-
-    private fun memRandom(): Long {
-        val start = nowNanos()
-        var sum = 0L
-        for (i in randomIndices1M) sum += memBuffer1M[i and 0xFFFFF]
-        blackhole = sum
-        return nowNanos() - start
-    }
-
-    private fun memCopy(): Long {
-        val dest = ByteArray(memBuffer1M.size)
-        val start = nowNanos()
-        System.arraycopy(memBuffer1M, 0, dest, 0, memBuffer1M.size)
-        blackhole = dest[0]
-        return nowNanos() - start
-    }
-
-    private fun memSequential4K(): Long {
-        val start = nowNanos()
-        var sum = 0L
-        for (i in 0 until 4096) sum += memBuffer1M[i]
-        blackhole = sum
-        return nowNanos() - start
-    }
-
-    private fun memSequential64K(): Long {
-        val start = nowNanos()
-        var sum = 0L
-        for (i in 0 until 65536) sum += memBuffer1M[i]
-        blackhole = sum
-        return nowNanos() - start
-    }
-
-    private fun memSequential4M(): Long {
-        val start = nowNanos()
-        var sum = 0L
-        for (i in memBuffer4M.indices) sum += memBuffer4M[i]
-        blackhole = sum
-        return nowNanos() - start
-    }
-
-    private fun memRandom4K(): Long {
-        val start = nowNanos()
-        var sum = 0L
-        for (i in 0 until 4096) sum += memBuffer1M[randomIndices1M[i] and 0xFFF]
-        blackhole = sum
-        return nowNanos() - start
-    }
-
-    private fun memRandom64K(): Long {
-        val start = nowNanos()
-        var sum = 0L
-        for (i in 0 until 65536) sum += memBuffer1M[randomIndices1M[i] and 0xFFFF]
-        blackhole = sum
-        return nowNanos() - start
-    }
-
-    private fun intMultiply(): Long {
-        val start = nowNanos()
-        var result = 1L
-        var multiplier = 7L
-        repeat(1_000_000) {
-            result = result * multiplier
-            result = result and 0x7FFFFFFFFFFFFFFFL
-            multiplier = (multiplier * 31 + 17) and 0x7FFFFFFF
-        }
-        blackhole = result
-        return nowNanos() - start
-    }
-
-    private fun intMultiply32(): Long {
-        val start = nowNanos()
-        var result = 1
-        var multiplier = 7
-        repeat(1_000_000) {
-            result = result * multiplier
-            result = result and 0x7FFFFFFF
-            multiplier = (multiplier * 31 + 17) and 0x7FFF
-        }
-        blackhole = result
-        return nowNanos() - start
-    }
-
-    private fun intDivide32(): Long {
-        val start = nowNanos()
-        var result = Int.MAX_VALUE
-        var divisor = 3
-        repeat(500_000) {
-            result = result / divisor
-            if (result < 1000) result = Int.MAX_VALUE
-            divisor = (divisor * 31 + 17) and 0x7FFF
-            if (divisor < 2) divisor = 3
-        }
-        blackhole = result
-        return nowNanos() - start
-    }
-
-    private fun intDivide64(): Long {
-        val start = nowNanos()
-        var result = Long.MAX_VALUE
-        var divisor = 3L
-        repeat(500_000) {
-            result = result / divisor
-            if (result < 1000) result = Long.MAX_VALUE
-            divisor = (divisor * 31 + 17) and 0x7FFFFFFF
-            if (divisor < 2) divisor = 3
-        }
-        blackhole = result
-        return nowNanos() - start
-    }
-
-    private fun floatMultiply(): Long {
-        val start = nowNanos()
-        var result = 1.0
-        val multiplier = 1.0000001
-        repeat(1_000_000) {
-            result *= multiplier
-            if (result > 1e100) result = 1.0
-        }
-        blackhole = result
-        return nowNanos() - start
-    }
-
-    private fun vectorDot(): Long {
-        val a = FloatArray(65536) { (it % 100) / 100f }
-        val b = FloatArray(65536) { ((it + 37) % 100) / 100f }
-        val start = nowNanos()
-        var result = 0f
-        for (i in a.indices) result += a[i] * b[i]
-        blackhole = result
-        return nowNanos() - start
-    }
-
-    private fun matrixOp(): Long {
-        val n = 128
-        val a = FloatArray(n * n) { (it % 100) / 100f }
-        val b = FloatArray(n * n) { ((it + 17) % 100) / 100f }
-        val c = FloatArray(n * n)
-        val start = nowNanos()
-        for (i in 0 until n) {
-            for (j in 0 until n) {
-                var sum = 0f
-                for (k in 0 until n) sum += a[i * n + k] * b[k * n + j]
-                c[i * n + j] = sum
-            }
-        }
-        blackhole = c
-        return nowNanos() - start
-    }
-
-    private fun intAddChain(): Long {
-        val start = nowNanos()
-        var a = 1L; var b = 2L; var c = 3L; var d = 4L
-        repeat(1_000_000) {
-            a = a + b; b = b + c; c = c + d; d = d + a
-        }
-        blackhole = a + b + c + d
-        return nowNanos() - start
-    }
-
-    private fun intAddParallel(): Long {
-        val start = nowNanos()
-        var a = 1L; var b = 2L; var c = 3L; var d = 4L
-        val x = 5L; val y = 6L; val z = 7L; val w = 8L
-        repeat(1_000_000) {
-            a += x; b += y; c += z; d += w
-        }
-        blackhole = a + b + c + d
-        return nowNanos() - start
-    }
-
-    private fun bitwiseOps(): Long {
-        val start = nowNanos()
-        var a = 0xDEADBEEFL
-        var b = 0xCAFEBABEL
-        repeat(1_000_000) {
-            a = a xor b
-            b = (b and 0xFFFF0000L) or (a and 0x0000FFFFL)
-            a = (a shl 1) or (a shr 63)
-        }
-        blackhole = a xor b
-        return nowNanos() - start
-    }
-
     // GPU operations
     private var eglDisplay: EGLDisplay? = null
     private var eglContext: EGLContext? = null
@@ -0,0 +1,22 @@
+/**
+ * LatticeCodePackage.kt
+ *
+ * React Native package registration for LatticeCodeViewManager.
+ */
+
+package io.estream.app
+
+import com.facebook.react.ReactPackage
+import com.facebook.react.bridge.NativeModule
+import com.facebook.react.bridge.ReactApplicationContext
+import com.facebook.react.uimanager.ViewManager
+
+class LatticeCodePackage : ReactPackage {
+    override fun createNativeModules(reactContext: ReactApplicationContext): List<NativeModule> {
+        return emptyList()
+    }
+
+    override fun createViewManagers(reactContext: ReactApplicationContext): List<ViewManager<*, *>> {
+        return listOf(LatticeCodeViewManager())
+    }
+}
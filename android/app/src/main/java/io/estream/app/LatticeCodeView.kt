@@ -0,0 +1,148 @@
+/**
+ * LatticeCodeView.kt
+ *
+ * Native view for the Lattice Code animation. Frames are rasterized
+ * offscreen by the shared native library (cpp/src/lattice_raster.cpp)
+ * into a direct buffer and blitted through a Bitmap, so animating the
+ * pattern does not re-render React components.
+ *
+ * @package io.estream.app
+ */
+
+package io.estream.app
+
+import android.content.Context
+import android.graphics.Bitmap
+import android.graphics.Canvas
+import android.graphics.Paint
+import android.graphics.Rect
+import android.os.SystemClock
+import android.view.View
+import java.nio.ByteBuffer
+
+class LatticeCodeView(context: Context) : View(context) {
+
+    companion object {
+        /** 20 FPS, as LatticeCodeScreen's SVG renderer. */
+        private const val FRAME_MS = 50L
+
+        /** Larger views are drawn from a frame of this size, scaled up. */
+        private const val MAX_FRAME_PX = 1080
+
+        init {
+            System.loadLibrary("estream_app_jni")
+        }
+
+        @JvmStatic
+        private external fun nativeCreate(size: Int): Long
+
+        @JvmStatic
+        private external fun nativeDestroy(renderer: Long)
+
+        @JvmStatic
+        private external fun nativeSetScene(
+            renderer: Long, baseHue: Double, ringSpeed: Double, heartbeatFreq: Double,
+            hexCells: ByteArray, orbits: DoubleArray, colors: IntArray
+        ): Int
+
+        @JvmStatic
+        private external fun nativeRender(
+            renderer: Long, elapsedMs: Double, buffer: ByteBuffer, size: Int, stride: Int
+        ): Int
+    }
+
+    /** Pattern parameters, as passed to nativeSetScene. */
+    class Scene(
+        val baseHue: Double,
+        val ringSpeed: Double,
+        val heartbeatFreq: Double,
+        val hexCells: ByteArray,
+        val orbits: DoubleArray,
+        val colors: IntArray
+    )
+
+    private var renderer = -1L
+    private var frameSize = 0
+    private var bitmap: Bitmap? = null
+    private var buffer: ByteBuffer? = null
+    private var scene: Scene? = null
+    private var startTime = SystemClock.uptimeMillis()
+    private val paint = Paint(Paint.FILTER_BITMAP_FLAG)
+    private val destination = Rect()
+
+    private val tick = object : Runnable {
+        override fun run() {
+            renderFrame()
+            if (isAttachedToWindow) postOnAnimationDelayed(this, FRAME_MS)
+        }
+    }
+
+    fun setScene(value: Scene) {
+        scene = value
+        startTime = SystemClock.uptimeMillis()
+        applyScene()
+        renderFrame()
+    }
+
+    /** Free the native renderer; the view is not drawn again. */
+    fun release() {
+        removeCallbacks(tick)
+        if (renderer > 0) nativeDestroy(renderer)
+        renderer = -1L
+        bitmap?.recycle()
+        bitmap = null
+        buffer = null
+    }
+
+    override fun onSizeChanged(w: Int, h: Int, oldw: Int, oldh: Int) {
+        super.onSizeChanged(w, h, oldw, oldh)
+        val size = minOf(w, h, MAX_FRAME_PX)
+        if (size <= 0 || size == frameSize) return
+        release()
+        frameSize = size
+        renderer = nativeCreate(size)
+        bitmap = Bitmap.createBitmap(size, size, Bitmap.Config.ARGB_8888)
+        buffer = ByteBuffer.allocateDirect(size * size * 4)
+        applyScene()
+        renderFrame()
+        if (isAttachedToWindow) postOnAnimation(tick)
+    }
+
+    override fun onAttachedToWindow() {
+        super.onAttachedToWindow()
+        removeCallbacks(tick)
+        postOnAnimation(tick)
+    }
+
+    override fun onDetachedFromWindow() {
+        removeCallbacks(tick)
+        super.onDetachedFromWindow()
+    }
+
+    override fun onDraw(canvas: Canvas) {
+        super.onDraw(canvas)
+        val frame = bitmap ?: return
+        val side = minOf(width, height)
+        val left = (width - side) / 2
+        val top = (height - side) / 2
+        destination.set(left, top, left + side, top + side)
+        canvas.drawBitmap(frame, null, destination, paint)
+    }
+
+    private fun applyScene() {
+        val s = scene ?: return
+        if (renderer <= 0) return
+        nativeSetScene(renderer, s.baseHue, s.ringSpeed, s.heartbeatFreq, s.hexCells, s.orbits, s.colors)
+    }
+
+    private fun renderFrame() {
+        val frame = bitmap ?: return
+        val pixels = buffer ?: return
+        if (renderer <= 0 || scene == null) return
+        val elapsed = (SystemClock.uptimeMillis() - startTime).toDouble()
+        if (nativeRender(renderer, elapsed, pixels, frameSize, frameSize * 4) != 0) return
+        pixels.rewind()
+        frame.copyPixelsFromBuffer(pixels)
+        invalidate()
+    }
+}
@@ -0,0 +1,50 @@
+/**
+ * LatticeCodeViewManager.kt
+ *
+ * Exposes LatticeCodeView to React Native as "LatticeCodeView". The
+ * `scene` prop carries what createLatticeCodeState derived:
+ *
+ *   { baseHue, ringSpeed, heartbeatFreq, hexCells: number[],
+ *     orbits: number[] (7 columns of particle orbits, see sparkOrbits.ts),
+ *     colors: number[] (0xRRGGBB per particle) }
+ *
+ * @package io.estream.app
+ */
+
+package io.estream.app
+
+import com.facebook.react.bridge.ReadableMap
+import com.facebook.react.uimanager.SimpleViewManager
+import com.facebook.react.uimanager.ThemedReactContext
+import com.facebook.react.uimanager.annotations.ReactProp
+
+class LatticeCodeViewManager : SimpleViewManager<LatticeCodeView>() {
+
+    override fun getName(): String = "LatticeCodeView"
+
+    override fun createViewInstance(reactContext: ThemedReactContext): LatticeCodeView =
+        LatticeCodeView(reactContext)
+
+    override fun onDropViewInstance(view: LatticeCodeView) {
+        view.release()
+        super.onDropViewInstance(view)
+    }
+
+    @ReactProp(name = "scene")
+    fun setScene(view: LatticeCodeView, scene: ReadableMap?) {
+        if (scene == null) return
+        val hexCells = scene.getArray("hexCells") ?: return
+        val orbits = scene.getArray("orbits") ?: return
+        val colors = scene.getArray("colors") ?: return
+        view.setScene(
+            LatticeCodeView.Scene(
+                baseHue = scene.getDouble("baseHue"),
+                ringSpeed = scene.getDouble("ringSpeed"),
+                heartbeatFreq = scene.getDouble("heartbeatFreq"),
+                hexCells = ByteArray(hexCells.size()) { hexCells.getInt(it).toByte() },
+                orbits = DoubleArray(orbits.size()) { orbits.getDouble(it) },
+                colors = IntArray(colors.size()) { colors.getInt(it) }
+            )
+        )
+    }
+}
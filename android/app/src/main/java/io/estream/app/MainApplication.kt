@@ -36,6 +36,10 @@ class MainApplication : Application(), ReactApplication {
               add(SparkAuthPackage())
               // ETFA (Embedded Timing Fingerprint Authentication) module
               add(ETFAPackage())
+              // Lattice Code frames rendered natively
+              add(LatticeCodePackage())
+              // Fountain-coded animated QR transport for signatures
+              add(QrTransportPackage())
             }
 
         override fun getJSMainModuleName(): String = "index"
@@ -0,0 +1,222 @@
+/**
+ * QrTransportModule.kt
+ *
+ * Fountain-coded animated QR transport for payloads too large for one QR
+ * code (ML-DSA-87 signatures). Encoding and decoding run in the shared
+ * native library (libestream_app_jni, see cpp/src/fountain.cpp); parts
+ * cross the bridge as base64. Also the compact protocol v2 encoding of
+ * signing requests and responses and its Base45 text form
+ * (cpp/src/qr_codec.cpp).
+ *
+ * @package io.estream.app
+ */
+
+package io.estream.app
+
+import android.util.Base64
+import com.facebook.react.bridge.*
+import org.json.JSONObject
+
+class QrTransportModule(reactContext: ReactApplicationContext) :
+    ReactContextBaseJavaModule(reactContext) {
+
+    companion object {
+        private const val MODULE_NAME = "QrTransport"
+
+        init {
+            System.loadLibrary("estream_app_jni")
+        }
+
+        // estream_fountain_*
+        @JvmStatic private external fun nativeEncode(
+            message: ByteArray, fragmentBytes: Int, firstSeq: Long, count: Int
+        ): ByteArray?
+        @JvmStatic private external fun nativeDecoderCreate(): Long
+        @JvmStatic private external fun nativeDecoderDestroy(decoder: Long)
+        @JvmStatic private external fun nativeDecoderReset(decoder: Long)
+        @JvmStatic private external fun nativeDecoderReceive(decoder: Long, part: ByteArray): Int
+        @JvmStatic private external fun nativeDecoderStatus(decoder: Long): String?
+        @JvmStatic private external fun nativeDecoderMessage(decoder: Long): ByteArray?
+
+        // estream_qr_*
+        @JvmStatic private external fun nativeEncodeResponse(
+            requestId: String, signature: ByteArray, signerKeyHash: ByteArray, algorithm: String, timestamp: Long
+        ): ByteArray?
+        @JvmStatic private external fun nativeDecodeRequest(message: ByteArray, payload: ByteArray): String?
+        @JvmStatic private external fun nativeBase45Encode(data: ByteArray): String?
+        @JvmStatic private external fun nativeBase45Decode(text: String): ByteArray?
+    }
+
+    private val decoders = mutableSetOf<Long>()
+
+    override fun getName(): String = MODULE_NAME
+
+    // ==========================================================================
+    // Encoding
+    // ==========================================================================
+
+    /**
+     * Parts `firstSeq` .. `firstSeq + count - 1` of `messageBase64`, split
+     * into fragments of at most `fragmentBytes`. Returns { fragmentCount,
+     * parts } with each part base64, or null on invalid input. Parts up to
+     * fragmentCount carry the message as is; later ones mix fragments.
+     */
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    fun encodeParts(messageBase64: String, fragmentBytes: Int, firstSeq: Double, count: Int): WritableMap? {
+        val message = decodeBase64(messageBase64) ?: return null
+        if (count <= 0) return null
+        val parts = nativeEncode(message, fragmentBytes, firstSeq.toLong(), count) ?: return null
+        val partBytes = parts.size / count
+        val encoded = Arguments.createArray()
+        for (i in 0 until count) {
+            encoded.pushString(Base64.encodeToString(parts, i * partBytes, partBytes, Base64.NO_WRAP))
+        }
+        // Bytes 5-8 of every part: the fragment count, big-endian.
+        val fragmentCount = (parts[5].toInt() and 0xff shl 24) or (parts[6].toInt() and 0xff shl 16) or
+            (parts[7].toInt() and 0xff shl 8) or (parts[8].toInt() and 0xff)
+        return Arguments.createMap().apply {
+            putInt("fragmentCount", fragmentCount)
+            putArray("parts", encoded)
+        }
+    }
+
+    // ==========================================================================
+    // Decoding
+    // ==========================================================================
+
+    /** Start collecting parts of one message; returns the decoder handle. */
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    fun createDecoder(): Double {
+        val decoder = nativeDecoderCreate()
+        synchronized(decoders) { decoders.add(decoder) }
+        return decoder.toDouble()
+    }
+
+    /**
+     * Add a scanned part (base64). Returns the decoder status with `result`:
+     * 1 once the message is recovered, 0 if more parts are needed, -1 if the
+     * part is malformed or from another message. Null for an unknown
+     * decoder.
+     */
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    fun decoderReceive(decoder: Double, partBase64: String): WritableMap? {
+        val handle = known(decoder) ?: return null
+        val result = decodeBase64(partBase64)?.let { nativeDecoderReceive(handle, it) } ?: -1
+        val status = nativeDecoderStatus(handle) ?: return null
+        val data = JSONObject(status).getJSONObject("data")
+        return Arguments.createMap().apply {
+            putInt("result", result)
+            putBoolean("complete", data.getBoolean("complete"))
+            putBoolean("corrupt", data.getBoolean("corrupt"))
+            putInt("fragments", data.getInt("fragments"))
+            putInt("recovered", data.getInt("recovered"))
+            putDouble("partsReceived", data.getDouble("parts_received"))
+            putDouble("partsDuplicate", data.getDouble("parts_duplicate"))
+            putDouble("progress", data.getDouble("progress"))
+        }
+    }
+
+    /** The recovered message as base64, or null until complete. */
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    fun decoderMessage(decoder: Double): String? {
+        val handle = known(decoder) ?: return null
+        val message = nativeDecoderMessage(handle) ?: return null
+        return Base64.encodeToString(message, Base64.NO_WRAP)
+    }
+
+    /** Drop collected parts, to scan another message. */
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    fun resetDecoder(decoder: Double): Boolean {
+        val handle = known(decoder) ?: return false
+        nativeDecoderReset(handle)
+        return true
+    }
+
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    fun destroyDecoder(decoder: Double): Boolean {
+        val handle = decoder.toLong()
+        if (!synchronized(decoders) { decoders.remove(handle) }) return false
+        nativeDecoderDestroy(handle)
+        return true
+    }
+
+    override fun invalidate() {
+        synchronized(decoders) {
+            decoders.forEach { nativeDecoderDestroy(it) }
+            decoders.clear()
+        }
+        super.invalidate()
+    }
+
+    // ==========================================================================
+    // Compact encoding (protocol v2)
+    // ==========================================================================
+
+    /** A v2 signing response message as base64, or null on invalid input. */
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    fun encodeCompactResponse(
+        requestId: String,
+        signatureBase64: String,
+        signerKeyHashBase64: String,
+        algorithm: String,
+        timestamp: Double
+    ): String? {
+        val signature = decodeBase64(signatureBase64) ?: return null
+        val keyHash = decodeBase64(signerKeyHashBase64) ?: return null
+        val message = nativeEncodeResponse(requestId, signature, keyHash, algorithm, timestamp.toLong()) ?: return null
+        return Base64.encodeToString(message, Base64.NO_WRAP)
+    }
+
+    /**
+     * Decode a v2 signing request message (base64) into { id, operation,
+     * description, payload (base64), timestamp, expiresAt, metadata (JSON
+     * text, "" if none) }, or null if malformed.
+     */
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    fun decodeCompactRequest(messageBase64: String): WritableMap? {
+        val message = decodeBase64(messageBase64) ?: return null
+        // The payload is part of the message, so it always fits.
+        val buffer = ByteArray(message.size)
+        val json = nativeDecodeRequest(message, buffer) ?: return null
+        val data = JSONObject(json).getJSONObject("data")
+        val payload = buffer.copyOf(data.getInt("payload_length"))
+        return Arguments.createMap().apply {
+            putString("id", data.getString("id"))
+            putString("operation", data.getString("operation"))
+            putString("description", data.getString("description"))
+            putString("payload", Base64.encodeToString(payload, Base64.NO_WRAP))
+            putDouble("timestamp", data.getDouble("timestamp"))
+            putDouble("expiresAt", data.getDouble("expires_at"))
+            putString("metadata", data.getString("metadata"))
+        }
+    }
+
+    /** Base45 (RFC 9285) text of `dataBase64`. */
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    fun base45Encode(dataBase64: String): String? {
+        val data = decodeBase64(dataBase64) ?: return null
+        return nativeBase45Encode(data)
+    }
+
+    /** Base64 of the bytes in Base45 `text`, or null if it is not Base45. */
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    fun base45Decode(text: String): String? {
+        val data = nativeBase45Decode(text) ?: return null
+        return Base64.encodeToString(data, Base64.NO_WRAP)
+    }
+
+    // ==========================================================================
+    // Helpers
+    // ==========================================================================
+
+    private fun known(decoder: Double): Long? {
+        val handle = decoder.toLong()
+        return if (synchronized(decoders) { handle in decoders }) handle else null
+    }
+
+    private fun decodeBase64(value: String): ByteArray? = try {
+        Base64.decode(value, Base64.DEFAULT)
+    } catch (e: IllegalArgumentException) {
+        null
+    }
+}
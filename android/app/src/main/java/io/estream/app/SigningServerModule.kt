@@ -3,16 +3,19 @@ package io.estream.app
 import android.util.Log
 import com.facebook.react.bridge.*
 import com.facebook.react.modules.core.DeviceEventManagerModule
-import fi.iki.elonen.NanoHTTPD
 import org.json.JSONObject
-import java.util.concurrent.ConcurrentHashMap
-import java.net.InetAddress
 import java.net.NetworkInterface
 
 /**
- * Native HTTP server for receiving signing requests from CLI.
- * Uses NanoHTTPD for a lightweight embedded server.
- * 
+ * Local HTTP server for receiving signing requests from the CLI.
+ *
+ * The server is native (libestream_app_jni, see cpp/src/signing_server.cpp):
+ * one event-loop thread answers /health and /status/<id> on keep-alive
+ * connections without calling into Kotlin or JS. POST /sign bodies are
+ * queued natively; a consumer thread here takes them from the queue and
+ * emits onSigningRequest. Once JS reports the outcome through markSigned
+ * or markRejected, /status serves it from the native queue.
+ *
  * eStream Signing Protocol v1.0
  */
 class SigningServerModule(private val reactContext: ReactApplicationContext) :
@@ -22,17 +25,32 @@ class SigningServerModule(private val reactContext: ReactApplicationContext) :
         private const val TAG = "estream.SigningServer"
         private const val PORT = 8765
         private const val VERSION = "0.3.0"
+        private const val ALGORITHM = "ML-DSA-87"
+        // Longest wait for a request before the consumer rechecks the handle.
+        private const val POLL_MS = 1000
+
+        init {
+            System.loadLibrary("estream_app_jni")
+        }
+
+        // estream_signing_server_*
+        @JvmStatic private external fun nativeStart(port: Int, queueCapacity: Int): Long
+        @JvmStatic private external fun nativeStop(server: Long)
+        @JvmStatic private external fun nativeNextRequest(server: Long, timeoutMs: Int): ByteArray?
+        @JvmStatic private external fun nativePendingRequests(server: Long): ByteArray?
+        @JvmStatic private external fun nativeMarkSigned(
+            server: Long, requestId: String, signature: String, signerKeyHash: String, algorithm: String,
+            timestampMs: Long
+        ): Int
+        @JvmStatic private external fun nativeMarkRejected(server: Long, requestId: String, reason: String): Int
+        @JvmStatic private external fun nativeStatus(server: Long): String?
     }
-    
+
     init {
-        Log.i(TAG, "╔══════════════════════════════════════════════════════╗")
-        Log.i(TAG, "║  eStream SigningServer Module Initialized            ║")
-        Log.i(TAG, "║  Version: $VERSION                                       ║")
-        Log.i(TAG, "║  Port: $PORT                                           ║")
-        Log.i(TAG, "╚══════════════════════════════════════════════════════╝")
+        Log.i(TAG, "eStream SigningServer module initialized (version $VERSION, port $PORT)")
         logNetworkInfo()
     }
-    
+
     private fun logNetworkInfo() {
         try {
             val interfaces = NetworkInterface.getNetworkInterfaces()
@@ -52,10 +70,8 @@ class SigningServerModule(private val reactContext: ReactApplicationContext) :
         }
     }
 
-    private var server: SigningHttpServer? = null
-    private val pendingRequests = ConcurrentHashMap<String, JSONObject>()
-    private val completedSignatures = ConcurrentHashMap<String, JSONObject>()
-    private val rejectedRequests = ConcurrentHashMap<String, String>()
+    @Volatile private var server = -1L
+    private var consumer: Thread? = null
 
     override fun getName(): String = "SigningServerModule"
 
@@ -63,57 +79,45 @@ class SigningServerModule(private val reactContext: ReactApplicationContext) :
      * Start the HTTP server
      */
     @ReactMethod
+    @Synchronized
     fun start(promise: Promise) {
-        Log.i(TAG, "┌─────────────────────────────────────────────────────")
-        Log.i(TAG, "│ START REQUEST RECEIVED")
-        Log.i(TAG, "│ Current server state: ${if (server != null) "RUNNING" else "STOPPED"}")
-        Log.i(TAG, "└─────────────────────────────────────────────────────")
-        
-        try {
-            if (server != null) {
-                Log.i(TAG, "Server already running, returning true")
-                promise.resolve(true)
-                return
-            }
-
-            Log.i(TAG, "Creating new SigningHttpServer on port $PORT...")
-            server = SigningHttpServer()
-            
-            Log.i(TAG, "Starting server...")
-            server?.start()
-            
-            Log.i(TAG, "╔═══════════════════════════════════════════════════════╗")
-            Log.i(TAG, "║  eStream SigningServer STARTED                        ║")
-            Log.i(TAG, "║  Port: $PORT                                           ║")
-            Log.i(TAG, "║  Status: ${if (server?.isAlive == true) "ALIVE" else "NOT ALIVE"}")
-            Log.i(TAG, "╚═══════════════════════════════════════════════════════╝")
-            
-            logNetworkInfo()
-            
+        if (server > 0) {
+            Log.i(TAG, "Server already running")
             promise.resolve(true)
-        } catch (e: Exception) {
-            Log.e(TAG, "╔═══════════════════════════════════════════════════════╗")
-            Log.e(TAG, "║  eStream SigningServer FAILED TO START                ║")
-            Log.e(TAG, "║  Error: ${e.message}")
-            Log.e(TAG, "╚═══════════════════════════════════════════════════════╝")
-            e.printStackTrace()
-            promise.reject("START_ERROR", e.message, e)
+            return
+        }
+        val handle = nativeStart(PORT, 0)
+        if (handle <= 0) {
+            Log.e(TAG, "Signing server failed to start: port $PORT unavailable")
+            promise.reject("START_ERROR", "Cannot listen on port $PORT")
+            return
         }
+        server = handle
+        consumer = Thread({ consume(handle) }, "estream-signing-consumer").apply {
+            isDaemon = true
+            start()
+        }
+        Log.i(TAG, "Signing server started on port $PORT")
+        logNetworkInfo()
+        promise.resolve(true)
     }
 
     /**
      * Stop the HTTP server
      */
     @ReactMethod
+    @Synchronized
     fun stop(promise: Promise) {
-        try {
-            server?.stop()
-            server = null
+        val handle = server
+        server = -1L
+        if (handle > 0) {
+            // Wakes the consumer out of nativeNextRequest.
+            nativeStop(handle)
+            consumer?.join(2L * POLL_MS)
+            consumer = null
             Log.i(TAG, "Signing server stopped")
-            promise.resolve(true)
-        } catch (e: Exception) {
-            promise.reject("STOP_ERROR", e.message, e)
         }
+        promise.resolve(true)
     }
 
     /**
@@ -121,7 +125,7 @@ class SigningServerModule(private val reactContext: ReactApplicationContext) :
      */
     @ReactMethod
     fun isRunning(promise: Promise) {
-        promise.resolve(server?.isAlive == true)
+        promise.resolve(server > 0)
     }
 
     /**
@@ -130,8 +134,12 @@ class SigningServerModule(private val reactContext: ReactApplicationContext) :
     @ReactMethod
     fun getPendingRequests(promise: Promise) {
         val array = Arguments.createArray()
-        pendingRequests.values.forEach { request ->
-            array.pushString(request.toString())
+        val json = server.takeIf { it > 0 }?.let { nativePendingRequests(it) }
+        if (json != null) {
+            val data = JSONObject(String(json, Charsets.UTF_8)).getJSONArray("data")
+            for (i in 0 until data.length()) {
+                array.pushString(data.getString(i))
+            }
         }
         promise.resolve(array)
     }
@@ -146,22 +154,16 @@ class SigningServerModule(private val reactContext: ReactApplicationContext) :
         keyHashB58: String,
         promise: Promise
     ) {
-        try {
-            val result = JSONObject().apply {
-                put("requestId", requestId)
-                put("status", "signed")
-                put("signature", signatureB58)
-                put("signerKeyHash", keyHashB58)
-                put("algorithm", "ML-DSA-87")
-                put("timestamp", System.currentTimeMillis())
-            }
-            completedSignatures[requestId] = result
-            pendingRequests.remove(requestId)
-            Log.i(TAG, "Request $requestId marked as signed")
-            promise.resolve(true)
-        } catch (e: Exception) {
-            promise.reject("SIGN_ERROR", e.message, e)
+        val handle = server
+        if (handle <= 0) {
+            promise.reject("SIGN_ERROR", "Signing server is not running")
+            return
         }
+        val marked = nativeMarkSigned(
+            handle, requestId, signatureB58, keyHashB58, ALGORITHM, System.currentTimeMillis()
+        ) == 0
+        Log.i(TAG, if (marked) "Request $requestId marked as signed" else "Request $requestId is not pending")
+        promise.resolve(marked)
     }
 
     /**
@@ -169,136 +171,55 @@ class SigningServerModule(private val reactContext: ReactApplicationContext) :
      */
     @ReactMethod
     fun markRejected(requestId: String, reason: String, promise: Promise) {
-        rejectedRequests[requestId] = reason
-        pendingRequests.remove(requestId)
+        val handle = server
+        val marked = handle > 0 && nativeMarkRejected(handle, requestId, reason) == 0
         Log.i(TAG, "Request $requestId marked as rejected: $reason")
-        promise.resolve(true)
+        promise.resolve(marked)
     }
 
     /**
-     * Send event to JS layer
+     * Connection, HTTP and request queue counters as a JSON string (the
+     * "data" member of estream_signing_server_status_json), or null when
+     * the server is stopped.
      */
-    private fun sendEvent(eventName: String, params: WritableMap) {
-        reactContext
-            .getJSModule(DeviceEventManagerModule.RCTDeviceEventEmitter::class.java)
-            .emit(eventName, params)
+    @ReactMethod
+    fun getStats(promise: Promise) {
+        val status = server.takeIf { it > 0 }?.let { nativeStatus(it) }
+        promise.resolve(status?.let { JSONObject(it).getJSONObject("data").toString() })
     }
 
     /**
-     * Embedded HTTP server using NanoHTTPD
+     * Hand queued /sign bodies to JS until the server stops. A request that
+     * cannot be forwarded is rejected, so it does not hold a queue slot
+     * until it expires.
      */
-    inner class SigningHttpServer : NanoHTTPD(PORT) {
-
-        override fun serve(session: IHTTPSession): Response {
-            val uri = session.uri
-            val method = session.method
-
-            Log.d(TAG, "Request: $method $uri")
-
-            return try {
-                when {
-                    uri == "/health" && method == Method.GET -> handleHealth()
-                    uri == "/sign" && method == Method.POST -> handleSign(session)
-                    uri.startsWith("/status/") && method == Method.GET -> handleStatus(uri)
-                    else -> newFixedLengthResponse(
-                        Response.Status.NOT_FOUND,
-                        "application/json",
-                        """{"error": "Not found"}"""
-                    )
+    private fun consume(handle: Long) {
+        while (server == handle) {
+            val body = nativeNextRequest(handle, POLL_MS) ?: continue
+            var requestId: String? = null
+            try {
+                val request = JSONObject(String(body, Charsets.UTF_8))
+                requestId = request.getString("id")
+                val params = Arguments.createMap().apply {
+                    putString("requestId", requestId)
+                    putString("operation", request.optString("operation"))
+                    putString("description", request.optString("description"))
+                    putString("payload", request.optString("payload"))
                 }
+                sendEvent("onSigningRequest", params)
             } catch (e: Exception) {
-                Log.e(TAG, "Error handling request", e)
-                newFixedLengthResponse(
-                    Response.Status.INTERNAL_ERROR,
-                    "application/json",
-                    """{"error": "${e.message}"}"""
-                )
+                Log.e(TAG, "Error forwarding signing request", e)
+                requestId?.let { nativeMarkRejected(handle, it, "Request could not be shown") }
             }
         }
+    }
 
-        private fun handleHealth(): Response {
-            val response = JSONObject().apply {
-                put("status", "ok")
-                put("version", "0.3.0")
-                put("keyHash", null as String?) // Will be filled by JS
-                put("trustLevel", "HardwareBacked")
-                put("pendingRequests", pendingRequests.size)
-            }
-            return jsonResponse(response)
-        }
-
-        private fun handleSign(session: IHTTPSession): Response {
-            // Read body
-            val bodyMap = HashMap<String, String>()
-            session.parseBody(bodyMap)
-            val body = bodyMap["postData"] ?: session.queryParameterString ?: "{}"
-            
-            val request = JSONObject(body)
-            val requestId = request.optString("id", "unknown")
-
-            // Store pending request
-            pendingRequests[requestId] = request
-
-            // Notify JS layer
-            val params = Arguments.createMap().apply {
-                putString("requestId", requestId)
-                putString("operation", request.optString("operation"))
-                putString("description", request.optString("description"))
-                putString("payload", request.optString("payload"))
-            }
-            sendEvent("onSigningRequest", params)
-
-            val response = JSONObject().apply {
-                put("success", true)
-                put("requestId", requestId)
-                put("message", "Request added. Waiting for user approval.")
-            }
-            return jsonResponse(response)
-        }
-
-        private fun handleStatus(uri: String): Response {
-            val requestId = uri.removePrefix("/status/")
-
-            // Check if signed
-            completedSignatures[requestId]?.let { sig ->
-                return jsonResponse(sig)
-            }
-
-            // Check if rejected
-            rejectedRequests[requestId]?.let { reason ->
-                val response = JSONObject().apply {
-                    put("requestId", requestId)
-                    put("status", "rejected")
-                    put("reason", reason)
-                }
-                return jsonResponse(response)
-            }
-
-            // Check if pending
-            if (pendingRequests.containsKey(requestId)) {
-                val response = JSONObject().apply {
-                    put("requestId", requestId)
-                    put("status", "pending")
-                }
-                return jsonResponse(response)
-            }
-
-            // Not found
-            val response = JSONObject().apply {
-                put("requestId", requestId)
-                put("status", "not_found")
-            }
-            return jsonResponse(response)
-        }
-
-        private fun jsonResponse(json: JSONObject): Response {
-            return newFixedLengthResponse(
-                Response.Status.OK,
-                "application/json",
-                json.toString()
-            ).apply {
-                addHeader("Access-Control-Allow-Origin", "*")
-            }
-        }
+    /**
+     * Send event to JS layer
+     */
+    private fun sendEvent(eventName: String, params: WritableMap) {
+        reactContext
+            .getJSModule(DeviceEventManagerModule.RCTDeviceEventEmitter::class.java)
+            .emit(eventName, params)
     }
 }
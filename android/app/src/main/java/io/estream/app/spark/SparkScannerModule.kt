@@ -1,14 +1,21 @@
 package io.estream.app.spark
 
+import android.util.Base64
 import com.facebook.react.bridge.*
 import com.facebook.react.module.annotations.ReactModule
-import kotlin.math.*
+import org.json.JSONObject
 
 /**
  * React Native module for Spark scanning
  * 
  * Provides native frame analysis and motion detection for Spark patterns.
  * This analyzes real camera frames for bright particle detection and orbital motion.
+ *
+ * The analysis runs in the native scan engine (estream_spark_engine_*):
+ * SparkFrameProcessor submits frames from the camera thread, and native
+ * detection and trajectory threads analyze the newest frame at a
+ * resolution that keeps detection within LATENCY_TARGET_MS. Frames are
+ * never materialized as Kotlin objects.
  */
 @ReactModule(name = SparkScannerModule.NAME)
 class SparkScannerModule(reactContext: ReactApplicationContext) : 
@@ -22,32 +29,40 @@ class SparkScannerModule(reactContext: ReactApplicationContext) :
         @JvmField
         var isScanning = false
         
-        @Volatile
-        private var frameHistory = mutableListOf<FrameData>()
-        
         @Volatile
         @JvmField
         var startTime: Long = 0
         
-        private const val MIN_FRAMES = 15
-        private const val MAX_FRAMES = 100
-        private const val MOTION_THRESHOLD = 0.03  // Very low for testing - accept any motion
-        private const val MIN_MOTION_SAMPLES = 5
-        
-        // Called from frame processor
-        @JvmStatic
-        fun addFrame(particles: List<ParticleData>, brightness: Float) {
-            if (!isScanning) return
-            
-            val timestamp = System.currentTimeMillis() - startTime
-            
-            synchronized(frameHistory) {
-                if (frameHistory.size >= MAX_FRAMES) {
-                    frameHistory.removeAt(0)
-                }
-                frameHistory.add(FrameData(timestamp, particles, brightness))
-            }
+        private const val BRIGHTNESS_THRESHOLD = 170
+        // Detection time per frame the engine adapts its resolution to hold;
+        // under the 33 ms frame interval at 30 fps.
+        private const val LATENCY_TARGET_MS = 20.0
+
+        init {
+            System.loadLibrary("estream_app_jni")
         }
+
+        @JvmStatic
+        private external fun nativeEngineCreate(threshold: Int, latencyTargetMs: Double): Long
+
+        @JvmStatic
+        private external fun nativeEngineReset(engine: Long): Int
+
+        @JvmStatic
+        private external fun nativeEngineStartLiveness(engine: Long, pubkey: ByteArray, timestamp: Long): Int
+
+        @JvmStatic
+        private external fun nativeEngineStatus(engine: Long, finish: Boolean): String?
+
+        @JvmStatic
+        private external fun nativeDeriveBytes(key: ByteArray, info: String, length: Int): ByteArray?
+
+        @JvmStatic
+        private external fun nativeMotionKey(pubkey: ByteArray, timestamp: Long): ByteArray?
+
+        /** Scan engine shared by every scan; SparkFrameProcessor feeds it. */
+        @JvmField
+        val engine: Long = nativeEngineCreate(BRIGHTNESS_THRESHOLD, LATENCY_TARGET_MS)
         
         @JvmStatic
         fun getProgress(): Double {
@@ -55,28 +70,7 @@ class SparkScannerModule(reactContext: ReactApplicationContext) :
             val elapsed = System.currentTimeMillis() - startTime
             return minOf(1.0, elapsed / 2500.0)
         }
-        
-        @JvmStatic
-        fun getFrameCount(): Int = synchronized(frameHistory) { frameHistory.size }
-        
-        @JvmStatic
-        fun getFramesCopy(): List<FrameData> = synchronized(frameHistory) { frameHistory.toList() }
-        
-        @JvmStatic
-        fun clearFrames() = synchronized(frameHistory) { frameHistory.clear() }
     }
-    
-    data class FrameData(
-        val timestamp: Long,
-        val particles: List<ParticleData>,
-        val brightness: Float
-    )
-    
-    data class ParticleData(
-        val x: Float,
-        val y: Float,
-        val brightness: Float
-    )
 
     override fun getName(): String = NAME
 
@@ -84,8 +78,8 @@ class SparkScannerModule(reactContext: ReactApplicationContext) :
     fun startScanning(promise: Promise) {
         android.util.Log.i("SparkScanner", "startScanning() called")
         try {
+            nativeEngineReset(engine)
             isScanning = true
-            clearFrames()
             startTime = System.currentTimeMillis()
             
             android.util.Log.i("SparkScanner", "isScanning set to TRUE, startTime=$startTime")
@@ -100,23 +94,42 @@ class SparkScannerModule(reactContext: ReactApplicationContext) :
         }
     }
 
+    /**
+     * Verify the scan against the Spark pattern derived from `pubkeyBase64`
+     * and `timestamp` while frames arrive. The decision appears in
+     * getStatus() as soon as it is statistically certain.
+     */
+    @ReactMethod
+    fun startLiveness(pubkeyBase64: String, timestamp: Double, promise: Promise) {
+        try {
+            val pubkey = Base64.decode(pubkeyBase64, Base64.DEFAULT)
+            if (nativeEngineStartLiveness(engine, pubkey, timestamp.toLong()) < 0) {
+                promise.reject("SPARK_ERROR", "Invalid pubkey")
+                return
+            }
+            promise.resolve(true)
+        } catch (e: Exception) {
+            promise.reject("SPARK_ERROR", "Failed to start liveness: ${e.message}")
+        }
+    }
+
     @ReactMethod
     fun stopScanning(promise: Promise) {
         try {
             isScanning = false
             val duration = System.currentTimeMillis() - startTime
-            val frameCount = getFrameCount()
-            
-            val motionResult = analyzeMotion()
-            val success = motionResult.confidence > MOTION_THRESHOLD && frameCount >= MIN_FRAMES
+            val status = engineStatus(finish = true)
+            val success = status.getBoolean("motion_detected")
             
             promise.resolve(WritableNativeMap().apply {
                 putBoolean("success", success)
                 putBoolean("sparkDetected", success)
-                putInt("framesAnalyzed", frameCount)
+                putInt("framesAnalyzed", status.getInt("window_frames"))
                 putDouble("durationMs", duration.toDouble())
-                putDouble("motionScore", motionResult.confidence)
-                putString("direction", motionResult.direction)
+                putDouble("motionScore", status.getDouble("motion_score"))
+                putString("direction", status.getString("direction"))
+                putInt("framesDropped", framesDropped(status))
+                livenessStatus(status)?.let { putMap("liveness", it) }
             })
         } catch (e: Exception) {
             promise.reject("SPARK_ERROR", "Failed to stop: ${e.message}")
@@ -127,111 +140,80 @@ class SparkScannerModule(reactContext: ReactApplicationContext) :
     fun getStatus(promise: Promise) {
         val elapsed = if (startTime > 0) System.currentTimeMillis() - startTime else 0L
         val progress = if (startTime > 0) minOf(1.0, elapsed / 2500.0) else 0.0
-        val frameCount = getFrameCount()
-        
-        // Quick motion check
-        val motionResult = if (frameCount >= MIN_FRAMES) analyzeMotion() else MotionResult(0.0, "scanning")
+        val status = engineStatus(finish = false)
         
         promise.resolve(WritableNativeMap().apply {
             putBoolean("isScanning", isScanning)
-            putInt("frameCount", frameCount)
+            putInt("frameCount", status.getInt("window_frames"))
             putDouble("durationMs", elapsed.toDouble())
             putDouble("progress", progress)
-            putDouble("motionScore", motionResult.confidence)
-            putBoolean("motionDetected", motionResult.confidence > MOTION_THRESHOLD)
+            putDouble("motionScore", status.getDouble("motion_score"))
+            putBoolean("motionDetected", status.getBoolean("motion_detected"))
+            putInt("framesDropped", framesDropped(status))
+            putInt("analysisScale", status.getInt("scale"))
+            putDouble("latencyMs", status.getDouble("latency_ms"))
+            livenessStatus(status)?.let { putMap("liveness", it) }
         })
     }
 
     @ReactMethod
     fun reset(promise: Promise) {
         isScanning = false
-        clearFrames()
+        nativeEngineReset(engine)
         startTime = 0
         promise.resolve(true)
     }
 
-    private data class MotionResult(
-        val confidence: Double,
-        val direction: String
-    )
-
-    private fun analyzeMotion(): MotionResult {
-        val frames = getFramesCopy()
-        
-        android.util.Log.d("SparkMotion", "Analyzing ${frames.size} frames")
-        
-        if (frames.size < MIN_FRAMES) {
-            android.util.Log.d("SparkMotion", "Insufficient frames: ${frames.size} < $MIN_FRAMES")
-            return MotionResult(0.0, "insufficient")
+    /**
+     * deriveMotionSeed of spark.ts, natively: the base64 64-byte motion key
+     * of the pattern for `pubkeyBase64` and `timestamp`, or null on invalid
+     * input. Synchronous, so derivation stays a plain function call in JS.
+     */
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    fun motionKey(pubkeyBase64: String, timestamp: Double): String? {
+        val pubkey = try {
+            Base64.decode(pubkeyBase64, Base64.DEFAULT)
+        } catch (e: IllegalArgumentException) {
+            return null
         }
+        val key = nativeMotionKey(pubkey, timestamp.toLong()) ?: return null
+        return Base64.encodeToString(key, Base64.NO_WRAP)
+    }
 
-        var cwVotes = 0
-        var ccwVotes = 0
-        var totalMotion = 0
-
-        for (i in 1 until frames.size) {
-            val prev = frames[i - 1]
-            val curr = frames[i]
-
-            // Match top particles
-            for (currP in curr.particles.take(6)) {
-                var minDist = Double.MAX_VALUE
-                var bestPrev: ParticleData? = null
-
-                for (prevP in prev.particles) {
-                    val dx = currP.x - prevP.x
-                    val dy = currP.y - prevP.y
-                    val dist = sqrt((dx * dx + dy * dy).toDouble())
-
-                    // Particles shouldn't move too far between frames
-                    if (dist < minDist && dist < 0.12) {
-                        minDist = dist
-                        bestPrev = prevP
-                    }
-                }
-
-                if (bestPrev != null) {
-                    // Calculate angular motion around center
-                    val cx = 0.5f
-                    val cy = 0.5f
-
-                    val prevAngle = atan2((bestPrev.y - cy).toDouble(), (bestPrev.x - cx).toDouble())
-                    val currAngle = atan2((currP.y - cy).toDouble(), (currP.x - cx).toDouble())
-
-                    var angleDelta = currAngle - prevAngle
-                    
-                    // Normalize angle
-                    if (angleDelta > PI) angleDelta -= 2 * PI
-                    if (angleDelta < -PI) angleDelta += 2 * PI
-
-                    // Significant motion
-                    if (abs(angleDelta) > 0.008) {
-                        totalMotion++
-                        if (angleDelta > 0) cwVotes++ else ccwVotes++
-                    }
-                }
-            }
+    /**
+     * deriveBytes of spark.ts / sparkAuth.ts: `length` bytes derived from
+     * `keyBase64` and `info`, base64, or null on invalid input.
+     */
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    fun deriveBytes(keyBase64: String, info: String, length: Int): String? {
+        val key = try {
+            Base64.decode(keyBase64, Base64.DEFAULT)
+        } catch (e: IllegalArgumentException) {
+            return null
         }
+        val bytes = nativeDeriveBytes(key, info, length) ?: return null
+        return Base64.encodeToString(bytes, Base64.NO_WRAP)
+    }
 
-        android.util.Log.d("SparkMotion", "Motion: cwVotes=$cwVotes, ccwVotes=$ccwVotes, total=$totalMotion")
-        
-        if (totalMotion < MIN_MOTION_SAMPLES) {
-            android.util.Log.d("SparkMotion", "Insufficient motion samples: $totalMotion < $MIN_MOTION_SAMPLES")
-            return MotionResult(0.0, "no_motion")
-        }
+    /** Consume the frames queued since the last call; the "data" object. */
+    private fun engineStatus(finish: Boolean): JSONObject {
+        val json = nativeEngineStatus(engine, finish) ?: throw IllegalStateException("Scan engine unavailable")
+        return JSONObject(json).getJSONObject("data")
+    }
 
-        // Consistency = how much motion is in one direction vs mixed
-        val consistency = abs(cwVotes - ccwVotes).toDouble() / totalMotion
-        
-        val direction = when {
-            cwVotes > ccwVotes * 1.2 -> "cw"
-            ccwVotes > cwVotes * 1.2 -> "ccw"
-            else -> "mixed"
+    /** Frames never analyzed: superseded before detection, or queue full. */
+    private fun framesDropped(status: JSONObject): Int =
+        status.getInt("frames_stale") + status.getInt("frames_dropped")
+
+    /** { decision, trajectoryScore, frames, lowerBound, upperBound } or null. */
+    private fun livenessStatus(status: JSONObject): WritableMap? {
+        val data = status.optJSONObject("liveness") ?: return null
+        return WritableNativeMap().apply {
+            putString("decision", data.getString("decision"))
+            putDouble("trajectoryScore", data.getDouble("trajectory_score"))
+            putInt("frames", data.getInt("frames"))
+            putDouble("lowerBound", data.getDouble("lower_bound"))
+            putDouble("upperBound", data.getDouble("upper_bound"))
         }
-
-        android.util.Log.d("SparkMotion", "Result: consistency=$consistency, direction=$direction, threshold=$MOTION_THRESHOLD")
-        android.util.Log.d("SparkMotion", "Spark detected: ${consistency > MOTION_THRESHOLD}")
-
-        return MotionResult(consistency, direction)
     }
 }
@@ -0,0 +1,221 @@
+/**
+ * JNI entry points for io.estream.app.ETFAModule.
+ */
+
+#include "estream_app_native.h"
+
+#include <jni.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace {
+
+// Progress from the native measuring threads, handed to the JNI thread:
+// those threads are not attached to the VM and must not call into Java.
+struct ProgressQueue {
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<std::pair<std::string, float>> events;
+    bool done = false;
+    char* result = nullptr;
+};
+
+void on_progress(void* ctx, const char* label, float progress) {
+    auto* queue = static_cast<ProgressQueue*>(ctx);
+    std::lock_guard<std::mutex> lock(queue->mu);
+    queue->events.emplace_back(label, progress);
+    queue->cv.notify_one();
+}
+
+// Forward to ETFAModule.NativeProgressListener.onProgress. Returns false
+// once the listener throws, which stops further reports.
+bool deliver(JNIEnv* env, jobject listener, jmethodID method, const std::string& label, float progress) {
+    jstring jlabel = env->NewStringUTF(label.c_str());
+    if (jlabel == nullptr) {
+        env->ExceptionClear();
+        return false;
+    }
+    env->CallVoidMethod(listener, method, jlabel, static_cast<jfloat>(progress));
+    env->DeleteLocalRef(jlabel);
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_io_estream_app_ETFAModule_nativeCollect(JNIEnv* env, jobject /* thiz */,
+                                             jint sample_count, jobject listener) {
+    jmethodID method = nullptr;
+    if (listener != nullptr) {
+        jclass cls = env->GetObjectClass(listener);
+        method = env->GetMethodID(cls, "onProgress", "(Ljava/lang/String;F)V");
+        env->DeleteLocalRef(cls);
+        if (method == nullptr) {
+            env->ExceptionClear();
+        }
+    }
+
+    ProgressQueue queue;
+    std::thread collector([&queue, sample_count] {
+        // 0: default number of measuring threads per core cluster.
+        char* result = estream_etfa_collect_parallel(sample_count, 0, on_progress, &queue);
+        std::lock_guard<std::mutex> lock(queue.mu);
+        queue.result = result;
+        queue.done = true;
+        queue.cv.notify_one();
+    });
+
+    bool reporting = method != nullptr;
+    std::unique_lock<std::mutex> lock(queue.mu);
+    for (;;) {
+        queue.cv.wait(lock, [&queue] { return queue.done || !queue.events.empty(); });
+        if (queue.events.empty()) {
+            break;
+        }
+        std::pair<std::string, float> event = std::move(queue.events.front());
+        queue.events.pop_front();
+        lock.unlock();
+        if (reporting) {
+            reporting = deliver(env, listener, method, event.first, event.second);
+        }
+        lock.lock();
+    }
+    char* result = queue.result;
+    lock.unlock();
+    collector.join();
+
+    if (result == nullptr) {
+        return nullptr;
+    }
+    jstring out = env->NewStringUTF(result);
+    estream_app_free_string(result);
+    return out;
+}
+
+// ============================================================================
+// Similarity index
+// ============================================================================
+
+namespace {
+
+// Copies a Java double[] for the duration of a call.
+class Ratios {
+public:
+    Ratios(JNIEnv* env, jdoubleArray array) : env_(env), array_(array) {
+        if (array != nullptr) {
+            count_ = env->GetArrayLength(array);
+            data_ = env->GetDoubleArrayElements(array, nullptr);
+        }
+    }
+    ~Ratios() {
+        if (data_ != nullptr) {
+            env_->ReleaseDoubleArrayElements(array_, data_, JNI_ABORT);
+        }
+    }
+    const double* data() const { return data_; }
+    int count() const { return data_ != nullptr ? static_cast<int>(count_) : 0; }
+
+    Ratios(const Ratios&) = delete;
+    Ratios& operator=(const Ratios&) = delete;
+
+private:
+    JNIEnv* env_;
+    jdoubleArray array_;
+    jsize count_ = 0;
+    jdouble* data_ = nullptr;
+};
+
+// Java string as UTF-8 for the duration of a call.
+class Utf8 {
+public:
+    Utf8(JNIEnv* env, jstring s) : env_(env), s_(s) {
+        if (s != nullptr) {
+            chars_ = env->GetStringUTFChars(s, nullptr);
+        }
+    }
+    ~Utf8() {
+        if (chars_ != nullptr) {
+            env_->ReleaseStringUTFChars(s_, chars_);
+        }
+    }
+    const char* c_str() const { return chars_; }
+
+    Utf8(const Utf8&) = delete;
+    Utf8& operator=(const Utf8&) = delete;
+
+private:
+    JNIEnv* env_;
+    jstring s_;
+    const char* chars_ = nullptr;
+};
+
+jstring take_string(JNIEnv* env, char* s) {
+    if (s == nullptr) {
+        return nullptr;
+    }
+    jstring out = env->NewStringUTF(s);
+    estream_app_free_string(s);
+    return out;
+}
+
+}  // namespace
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_io_estream_app_ETFAModule_nativeFingerprintCode(JNIEnv* env, jobject /* thiz */, jdoubleArray ratios) {
+    Ratios r(env, ratios);
+    return take_string(env, estream_etfa_fingerprint_code(r.data(), r.count()));
+}
+
+/// Load the snapshot at `path`, or create an empty index if there is none.
+extern "C" JNIEXPORT jlong JNICALL
+Java_io_estream_app_ETFAModule_nativeIndexOpen(JNIEnv* env, jobject /* thiz */, jstring path) {
+    Utf8 p(env, path);
+    const long index = p.c_str() != nullptr ? estream_etfa_index_load(p.c_str()) : -1;
+    return index >= 0 ? index : estream_etfa_index_create();
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_io_estream_app_ETFAModule_nativeIndexSave(JNIEnv* env, jobject /* thiz */, jlong index, jstring path) {
+    Utf8 p(env, path);
+    return estream_etfa_index_save(static_cast<long>(index), p.c_str());
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_io_estream_app_ETFAModule_nativeIndexAdd(JNIEnv* env, jobject /* thiz */, jlong index,
+                                              jstring id, jdoubleArray ratios) {
+    Utf8 i(env, id);
+    Ratios r(env, ratios);
+    return estream_etfa_index_add(static_cast<long>(index), i.c_str(), r.data(), r.count());
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_io_estream_app_ETFAModule_nativeIndexRemove(JNIEnv* env, jobject /* thiz */, jlong index, jstring id) {
+    Utf8 i(env, id);
+    return estream_etfa_index_remove(static_cast<long>(index), i.c_str());
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_io_estream_app_ETFAModule_nativeIndexSize(JNIEnv* /* env */, jobject /* thiz */, jlong index) {
+    return estream_etfa_index_size(static_cast<long>(index));
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_io_estream_app_ETFAModule_nativeIndexTrain(JNIEnv* /* env */, jobject /* thiz */, jlong index) {
+    return estream_etfa_index_train(static_cast<long>(index), 0, 0);
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_io_estream_app_ETFAModule_nativeIndexSearch(JNIEnv* env, jobject /* thiz */, jlong index,
+                                                 jdoubleArray ratios, jint k, jint probes) {
+    Ratios r(env, ratios);
+    return take_string(env, estream_etfa_index_search(static_cast<long>(index), r.data(), r.count(), k, probes));
+}
@@ -0,0 +1,63 @@
+/**
+ * JNI entry points for io.estream.app.LatticeCodeView: offscreen rendering
+ * of Lattice Code frames straight into the view's pixel buffer.
+ */
+
+#include "estream_app_native.h"
+
+#include <jni.h>
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_io_estream_app_LatticeCodeView_nativeCreate(JNIEnv* /* env */, jclass /* clazz */, jint size) {
+    return estream_lattice_create(size);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_io_estream_app_LatticeCodeView_nativeDestroy(JNIEnv* /* env */, jclass /* clazz */, jlong renderer) {
+    estream_lattice_destroy(static_cast<long>(renderer));
+}
+
+/// `orbits` holds the seven orbit columns of `colors.length` particles.
+extern "C" JNIEXPORT jint JNICALL
+Java_io_estream_app_LatticeCodeView_nativeSetScene(JNIEnv* env, jclass /* clazz */, jlong renderer,
+                                                   jdouble base_hue, jdouble ring_speed, jdouble heartbeat_freq,
+                                                   jbyteArray hex_cells, jdoubleArray orbits, jintArray colors) {
+    if (hex_cells == nullptr || orbits == nullptr || colors == nullptr) {
+        return -1;
+    }
+    const jsize hex_count = env->GetArrayLength(hex_cells);
+    const jsize particles = env->GetArrayLength(colors);
+    if (env->GetArrayLength(orbits) != static_cast<jlong>(particles) * 7) {
+        return -1;
+    }
+    // No JNI calls between getting and releasing the critical arrays.
+    auto* cells = static_cast<jbyte*>(env->GetPrimitiveArrayCritical(hex_cells, nullptr));
+    auto* o = static_cast<jdouble*>(env->GetPrimitiveArrayCritical(orbits, nullptr));
+    auto* c = static_cast<jint*>(env->GetPrimitiveArrayCritical(colors, nullptr));
+    int result = -1;
+    if (cells != nullptr && o != nullptr && c != nullptr) {
+        result = estream_lattice_set_scene(static_cast<long>(renderer), base_hue, ring_speed, heartbeat_freq,
+                                           reinterpret_cast<const uint8_t*>(cells), hex_count, o,
+                                           reinterpret_cast<const uint32_t*>(c), particles);
+    }
+    if (c != nullptr) env->ReleasePrimitiveArrayCritical(colors, c, JNI_ABORT);
+    if (o != nullptr) env->ReleasePrimitiveArrayCritical(orbits, o, JNI_ABORT);
+    if (cells != nullptr) env->ReleasePrimitiveArrayCritical(hex_cells, cells, JNI_ABORT);
+    return result;
+}
+
+/// Render into a direct ByteBuffer of `stride` * size bytes, ready for
+/// Bitmap.copyPixelsFromBuffer. Returns 0, or -1 if the buffer is not
+/// direct or too small.
+extern "C" JNIEXPORT jint JNICALL
+Java_io_estream_app_LatticeCodeView_nativeRender(JNIEnv* env, jclass /* clazz */, jlong renderer,
+                                                 jdouble elapsed_ms, jobject buffer, jint size, jint stride) {
+    if (buffer == nullptr || size <= 0) {
+        return -1;
+    }
+    auto* data = static_cast<uint8_t*>(env->GetDirectBufferAddress(buffer));
+    if (data == nullptr || env->GetDirectBufferCapacity(buffer) < static_cast<jlong>(stride) * size) {
+        return -1;
+    }
+    return estream_lattice_render(static_cast<long>(renderer), elapsed_ms, data, stride);
+}
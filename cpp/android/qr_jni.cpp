@@ -0,0 +1,225 @@
+/**
+ * JNI entry points for io.estream.app.QrTransportModule: fountain-coded
+ * parts for animated QR codes, decoders that collect scanned parts, and the
+ * compact protocol v2 encoding with its Base45 text form.
+ */
+
+#include "estream_app_native.h"
+
+#include <jni.h>
+
+#include <cstring>
+#include <vector>
+
+/// `count` consecutive parts from `first_seq`, back to back, or null on
+/// invalid arguments.
+extern "C" JNIEXPORT jbyteArray JNICALL
+Java_io_estream_app_QrTransportModule_nativeEncode(JNIEnv* env, jclass /* clazz */, jbyteArray message,
+                                                   jint fragment_bytes, jlong first_seq, jint count) {
+    if (message == nullptr || count <= 0 || first_seq <= 0 || first_seq > 0xffffffffLL) {
+        return nullptr;
+    }
+    const jsize len = env->GetArrayLength(message);
+    jbyte* bytes = env->GetByteArrayElements(message, nullptr);
+    if (bytes == nullptr) {
+        return nullptr;
+    }
+    const auto* data = reinterpret_cast<const uint8_t*>(bytes);
+    const auto seq = static_cast<uint32_t>(first_seq);
+    jbyteArray out = nullptr;
+    const int part_bytes = estream_fountain_encode(data, len, fragment_bytes, seq, 0, nullptr, 0);
+    if (part_bytes > 0 && count <= (1 << 30) / part_bytes) {
+        std::vector<uint8_t> parts(static_cast<size_t>(part_bytes) * static_cast<size_t>(count));
+        const int capacity = static_cast<int>(parts.size());
+        if (estream_fountain_encode(data, len, fragment_bytes, seq, count, parts.data(), capacity) == part_bytes) {
+            out = env->NewByteArray(capacity);
+            if (out != nullptr) {
+                env->SetByteArrayRegion(out, 0, capacity, reinterpret_cast<const jbyte*>(parts.data()));
+            }
+        }
+    }
+    env->ReleaseByteArrayElements(message, bytes, JNI_ABORT);
+    return out;
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_io_estream_app_QrTransportModule_nativeDecoderCreate(JNIEnv* /* env */, jclass /* clazz */) {
+    return estream_fountain_decoder_create();
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_io_estream_app_QrTransportModule_nativeDecoderDestroy(JNIEnv* /* env */, jclass /* clazz */, jlong decoder) {
+    estream_fountain_decoder_destroy(static_cast<long>(decoder));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_io_estream_app_QrTransportModule_nativeDecoderReset(JNIEnv* /* env */, jclass /* clazz */, jlong decoder) {
+    estream_fountain_decoder_reset(static_cast<long>(decoder));
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_io_estream_app_QrTransportModule_nativeDecoderReceive(JNIEnv* env, jclass /* clazz */, jlong decoder,
+                                                           jbyteArray part) {
+    if (part == nullptr) {
+        return -1;
+    }
+    const jsize len = env->GetArrayLength(part);
+    jbyte* bytes = env->GetByteArrayElements(part, nullptr);
+    if (bytes == nullptr) {
+        return -1;
+    }
+    const int result =
+        estream_fountain_decoder_receive(static_cast<long>(decoder), reinterpret_cast<const uint8_t*>(bytes), len);
+    env->ReleaseByteArrayElements(part, bytes, JNI_ABORT);
+    return result;
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_io_estream_app_QrTransportModule_nativeDecoderStatus(JNIEnv* env, jclass /* clazz */, jlong decoder) {
+    char* status = estream_fountain_decoder_status_json(static_cast<long>(decoder));
+    if (status == nullptr) {
+        return nullptr;
+    }
+    jstring out = env->NewStringUTF(status);
+    estream_app_free_string(status);
+    return out;
+}
+
+/// The recovered message, or null until the decoder completes.
+extern "C" JNIEXPORT jbyteArray JNICALL
+Java_io_estream_app_QrTransportModule_nativeDecoderMessage(JNIEnv* env, jclass /* clazz */, jlong decoder) {
+    const int len = estream_fountain_decoder_message(static_cast<long>(decoder), nullptr, 0);
+    if (len < 0) {
+        return nullptr;
+    }
+    std::vector<uint8_t> message(static_cast<size_t>(len));
+    if (estream_fountain_decoder_message(static_cast<long>(decoder), message.data(), len) != len) {
+        return nullptr;
+    }
+    jbyteArray out = env->NewByteArray(len);
+    if (out != nullptr) {
+        env->SetByteArrayRegion(out, 0, len, reinterpret_cast<const jbyte*>(message.data()));
+    }
+    return out;
+}
+
+// ============================================================================
+// Compact encoding (protocol v2)
+// ============================================================================
+
+namespace {
+
+jbyteArray new_byte_array(JNIEnv* env, const uint8_t* data, int len) {
+    jbyteArray out = env->NewByteArray(len);
+    if (out != nullptr) {
+        env->SetByteArrayRegion(out, 0, len, reinterpret_cast<const jbyte*>(data));
+    }
+    return out;
+}
+
+}  // namespace
+
+/// estream_qr_encode_response(), or null on invalid arguments.
+extern "C" JNIEXPORT jbyteArray JNICALL
+Java_io_estream_app_QrTransportModule_nativeEncodeResponse(JNIEnv* env, jclass /* clazz */, jstring request_id,
+                                                           jbyteArray signature, jbyteArray signer_key_hash,
+                                                           jstring algorithm, jlong timestamp) {
+    if (request_id == nullptr || signature == nullptr || signer_key_hash == nullptr || algorithm == nullptr ||
+        timestamp < 0) {
+        return nullptr;
+    }
+    const jsize sig_len = env->GetArrayLength(signature);
+    const jsize key_len = env->GetArrayLength(signer_key_hash);
+    jbyte* sig = env->GetByteArrayElements(signature, nullptr);
+    jbyte* key = env->GetByteArrayElements(signer_key_hash, nullptr);
+    const char* id = env->GetStringUTFChars(request_id, nullptr);
+    const char* alg = env->GetStringUTFChars(algorithm, nullptr);
+    jbyteArray out = nullptr;
+    if (sig != nullptr && key != nullptr && id != nullptr && alg != nullptr) {
+        const auto* s = reinterpret_cast<const uint8_t*>(sig);
+        const auto* k = reinterpret_cast<const uint8_t*>(key);
+        const auto ts = static_cast<uint64_t>(timestamp);
+        const int len = estream_qr_encode_response(id, s, sig_len, k, key_len, alg, ts, nullptr, 0);
+        if (len > 0) {
+            std::vector<uint8_t> encoded(static_cast<size_t>(len));
+            if (estream_qr_encode_response(id, s, sig_len, k, key_len, alg, ts, encoded.data(), len) == len) {
+                out = new_byte_array(env, encoded.data(), len);
+            }
+        }
+    }
+    if (alg != nullptr) env->ReleaseStringUTFChars(algorithm, alg);
+    if (id != nullptr) env->ReleaseStringUTFChars(request_id, id);
+    if (key != nullptr) env->ReleaseByteArrayElements(signer_key_hash, key, JNI_ABORT);
+    if (sig != nullptr) env->ReleaseByteArrayElements(signature, sig, JNI_ABORT);
+    return out;
+}
+
+/// estream_qr_decode_request_json(), or null if malformed. The payload is
+/// written to the start of `payload`, which must be at least as long as
+/// `message`.
+extern "C" JNIEXPORT jstring JNICALL
+Java_io_estream_app_QrTransportModule_nativeDecodeRequest(JNIEnv* env, jclass /* clazz */, jbyteArray message,
+                                                          jbyteArray payload) {
+    if (message == nullptr || payload == nullptr) {
+        return nullptr;
+    }
+    const jsize len = env->GetArrayLength(message);
+    const jsize capacity = env->GetArrayLength(payload);
+    jbyte* bytes = env->GetByteArrayElements(message, nullptr);
+    jbyte* payload_bytes = env->GetByteArrayElements(payload, nullptr);
+    char* json = nullptr;
+    if (bytes != nullptr && payload_bytes != nullptr) {
+        json = estream_qr_decode_request_json(reinterpret_cast<const uint8_t*>(bytes), len,
+                                              reinterpret_cast<uint8_t*>(payload_bytes), capacity);
+    }
+    if (payload_bytes != nullptr) env->ReleaseByteArrayElements(payload, payload_bytes, 0);
+    if (bytes != nullptr) env->ReleaseByteArrayElements(message, bytes, JNI_ABORT);
+    if (json == nullptr) {
+        return nullptr;
+    }
+    // ASCII only, so valid modified UTF-8.
+    jstring out = env->NewStringUTF(json);
+    estream_app_free_string(json);
+    return out;
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_io_estream_app_QrTransportModule_nativeBase45Encode(JNIEnv* env, jclass /* clazz */, jbyteArray data) {
+    if (data == nullptr) {
+        return nullptr;
+    }
+    const jsize len = env->GetArrayLength(data);
+    jbyte* bytes = env->GetByteArrayElements(data, nullptr);
+    if (bytes == nullptr) {
+        return nullptr;
+    }
+    const auto* d = reinterpret_cast<const uint8_t*>(bytes);
+    const int chars = estream_qr_base45_encode(d, len, nullptr, 0);
+    std::vector<char> text(static_cast<size_t>(chars > 0 ? chars : 0) + 1, '\0');
+    const bool ok = chars >= 0 && estream_qr_base45_encode(d, len, text.data(), chars) == chars;
+    env->ReleaseByteArrayElements(data, bytes, JNI_ABORT);
+    return ok ? env->NewStringUTF(text.data()) : nullptr;
+}
+
+/// Null if `text` is not Base45.
+extern "C" JNIEXPORT jbyteArray JNICALL
+Java_io_estream_app_QrTransportModule_nativeBase45Decode(JNIEnv* env, jclass /* clazz */, jstring text) {
+    if (text == nullptr) {
+        return nullptr;
+    }
+    const char* chars = env->GetStringUTFChars(text, nullptr);
+    if (chars == nullptr) {
+        return nullptr;
+    }
+    const int n = static_cast<int>(std::strlen(chars));
+    const int len = estream_qr_base45_decode(chars, n, nullptr, 0);
+    jbyteArray out = nullptr;
+    if (len >= 0) {
+        std::vector<uint8_t> bytes(static_cast<size_t>(len));
+        if (estream_qr_base45_decode(chars, n, bytes.data(), len) == len) {
+            out = new_byte_array(env, bytes.data(), len);
+        }
+    }
+    env->ReleaseStringUTFChars(text, chars);
+    return out;
+}
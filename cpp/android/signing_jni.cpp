@@ -0,0 +1,107 @@
+/**
+ * JNI entry points for io.estream.app.SigningServerModule: the native local
+ * signing endpoint and its request queue.
+ */
+
+#include "estream_app_native.h"
+
+#include <jni.h>
+
+#include <cstring>
+
+namespace {
+
+// Request bodies are UTF-8 as the CLI sent them, which NewStringUTF would
+// reject outside the BMP, so they cross as bytes.
+jbyteArray take_bytes(JNIEnv* env, char* text) {
+    if (text == nullptr) {
+        return nullptr;
+    }
+    const auto len = static_cast<jsize>(std::strlen(text));
+    jbyteArray out = env->NewByteArray(len);
+    if (out != nullptr) {
+        env->SetByteArrayRegion(out, 0, len, reinterpret_cast<const jbyte*>(text));
+    }
+    estream_app_free_string(text);
+    return out;
+}
+
+}  // namespace
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_io_estream_app_SigningServerModule_nativeStart(JNIEnv* /* env */, jclass /* clazz */, jint port,
+                                                    jint queue_capacity) {
+    return estream_signing_server_start(port, queue_capacity);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_io_estream_app_SigningServerModule_nativeStop(JNIEnv* /* env */, jclass /* clazz */, jlong server) {
+    estream_signing_server_stop(static_cast<long>(server));
+}
+
+/// The next request body (UTF-8 JSON), or null on timeout or once stopped.
+extern "C" JNIEXPORT jbyteArray JNICALL
+Java_io_estream_app_SigningServerModule_nativeNextRequest(JNIEnv* env, jclass /* clazz */, jlong server,
+                                                          jint timeout_ms) {
+    return take_bytes(env, estream_signing_server_next_request(static_cast<long>(server), timeout_ms));
+}
+
+/// estream_signing_server_pending_json() as UTF-8.
+extern "C" JNIEXPORT jbyteArray JNICALL
+Java_io_estream_app_SigningServerModule_nativePendingRequests(JNIEnv* env, jclass /* clazz */, jlong server) {
+    return take_bytes(env, estream_signing_server_pending_json(static_cast<long>(server)));
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_io_estream_app_SigningServerModule_nativeMarkSigned(JNIEnv* env, jclass /* clazz */, jlong server,
+                                                         jstring request_id, jstring signature,
+                                                         jstring signer_key_hash, jstring algorithm,
+                                                         jlong timestamp_ms) {
+    if (request_id == nullptr || signature == nullptr || signer_key_hash == nullptr || algorithm == nullptr ||
+        timestamp_ms < 0) {
+        return -1;
+    }
+    const char* id = env->GetStringUTFChars(request_id, nullptr);
+    const char* sig = env->GetStringUTFChars(signature, nullptr);
+    const char* key = env->GetStringUTFChars(signer_key_hash, nullptr);
+    const char* alg = env->GetStringUTFChars(algorithm, nullptr);
+    int result = -1;
+    if (id != nullptr && sig != nullptr && key != nullptr && alg != nullptr) {
+        result = estream_signing_server_mark_signed(static_cast<long>(server), id, sig, key, alg,
+                                                    static_cast<uint64_t>(timestamp_ms));
+    }
+    if (alg != nullptr) env->ReleaseStringUTFChars(algorithm, alg);
+    if (key != nullptr) env->ReleaseStringUTFChars(signer_key_hash, key);
+    if (sig != nullptr) env->ReleaseStringUTFChars(signature, sig);
+    if (id != nullptr) env->ReleaseStringUTFChars(request_id, id);
+    return result;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_io_estream_app_SigningServerModule_nativeMarkRejected(JNIEnv* env, jclass /* clazz */, jlong server,
+                                                           jstring request_id, jstring reason) {
+    if (request_id == nullptr || reason == nullptr) {
+        return -1;
+    }
+    const char* id = env->GetStringUTFChars(request_id, nullptr);
+    const char* why = env->GetStringUTFChars(reason, nullptr);
+    int result = -1;
+    if (id != nullptr && why != nullptr) {
+        result = estream_signing_server_mark_rejected(static_cast<long>(server), id, why);
+    }
+    if (why != nullptr) env->ReleaseStringUTFChars(reason, why);
+    if (id != nullptr) env->ReleaseStringUTFChars(request_id, id);
+    return result;
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_io_estream_app_SigningServerModule_nativeStatus(JNIEnv* env, jclass /* clazz */, jlong server) {
+    char* status = estream_signing_server_status_json(static_cast<long>(server));
+    if (status == nullptr) {
+        return nullptr;
+    }
+    // ASCII only, so valid modified UTF-8.
+    jstring out = env->NewStringUTF(status);
+    estream_app_free_string(status);
+    return out;
+}
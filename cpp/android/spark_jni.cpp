@@ -0,0 +1,131 @@
+/**
+ * JNI entry points for io.estream.app.spark: the scan engine owned by
+ * SparkScannerModule and fed by SparkFrameProcessor, Spark motion-key
+ * derivation, and batch orbit evaluation for the Spark and Lattice Code
+ * renderers.
+ */
+
+#include "estream_app_native.h"
+
+#include <jni.h>
+
+#include <vector>
+
+/// Hand the Y plane of a camera frame to the engine, read from its direct
+/// ByteBuffer. Returns 1 if taken, 0 if dropped, or -1 if the buffer is
+/// not direct or too small for the geometry.
+extern "C" JNIEXPORT jint JNICALL
+Java_io_estream_app_spark_SparkFrameProcessor_nativeSubmit(JNIEnv* env, jobject /* thiz */, jlong engine,
+                                                           jobject y_plane, jint width, jint height,
+                                                           jint row_stride, jint pixel_stride,
+                                                           jdouble timestamp_ms) {
+    if (y_plane == nullptr || width <= 0 || height <= 0 || pixel_stride < 1) {
+        return -1;
+    }
+    const auto* data = static_cast<const uint8_t*>(env->GetDirectBufferAddress(y_plane));
+    const jlong capacity = env->GetDirectBufferCapacity(y_plane);
+    // The last row of an Image plane may stop right after its last pixel.
+    const jlong needed = static_cast<jlong>(height - 1) * row_stride + static_cast<jlong>(width - 1) * pixel_stride + 1;
+    if (data == nullptr || capacity < needed) {
+        return -1;
+    }
+    return estream_spark_engine_submit(static_cast<long>(engine), data, width, height, row_stride, pixel_stride,
+                                       timestamp_ms);
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_io_estream_app_spark_SparkScannerModule_nativeEngineCreate(JNIEnv* /* env */, jclass /* clazz */,
+                                                                jint threshold, jdouble latency_target_ms) {
+    return estream_spark_engine_create(threshold, latency_target_ms);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_io_estream_app_spark_SparkScannerModule_nativeEngineReset(JNIEnv* /* env */, jclass /* clazz */,
+                                                               jlong engine) {
+    return estream_spark_engine_reset(static_cast<long>(engine));
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_io_estream_app_spark_SparkScannerModule_nativeEngineStartLiveness(JNIEnv* env, jclass /* clazz */,
+                                                                       jlong engine, jbyteArray pubkey,
+                                                                       jlong timestamp) {
+    if (pubkey == nullptr) {
+        return -1;
+    }
+    const jsize len = env->GetArrayLength(pubkey);
+    jbyte* bytes = env->GetByteArrayElements(pubkey, nullptr);
+    if (bytes == nullptr) {
+        return -1;
+    }
+    const int result = estream_spark_engine_start_liveness(static_cast<long>(engine),
+                                                           reinterpret_cast<const uint8_t*>(bytes), len,
+                                                           static_cast<int64_t>(timestamp));
+    env->ReleaseByteArrayElements(pubkey, bytes, JNI_ABORT);
+    return result;
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_io_estream_app_spark_SparkScannerModule_nativeEngineStatus(JNIEnv* env, jclass /* clazz */, jlong engine,
+                                                                jboolean finish) {
+    char* status = estream_spark_engine_status(static_cast<long>(engine), finish ? 1 : 0);
+    if (status == nullptr) {
+        return nullptr;
+    }
+    jstring out = env->NewStringUTF(status);
+    estream_app_free_string(status);
+    return out;
+}
+
+/// `length` bytes of estream_spark_derive_bytes(key, info), or null.
+extern "C" JNIEXPORT jbyteArray JNICALL
+Java_io_estream_app_spark_SparkScannerModule_nativeDeriveBytes(JNIEnv* env, jclass /* clazz */, jbyteArray key,
+                                                               jstring info, jint length) {
+    if (key == nullptr || info == nullptr || length < 0) {
+        return nullptr;
+    }
+    const jsize key_len = env->GetArrayLength(key);
+    jbyte* key_bytes = env->GetByteArrayElements(key, nullptr);
+    const char* info_chars = env->GetStringUTFChars(info, nullptr);
+    jbyteArray out = nullptr;
+    if (key_bytes != nullptr && info_chars != nullptr) {
+        // Modified UTF-8 only differs from UTF-8 for NUL and supplementary
+        // characters, which derivation labels do not use.
+        std::vector<uint8_t> bytes(static_cast<size_t>(length));
+        if (estream_spark_derive_bytes(reinterpret_cast<const uint8_t*>(key_bytes), key_len, info_chars,
+                                       bytes.data(), length) == 0) {
+            out = env->NewByteArray(length);
+            if (out != nullptr) {
+                env->SetByteArrayRegion(out, 0, length, reinterpret_cast<const jbyte*>(bytes.data()));
+            }
+        }
+    }
+    if (info_chars != nullptr) env->ReleaseStringUTFChars(info, info_chars);
+    if (key_bytes != nullptr) env->ReleaseByteArrayElements(key, key_bytes, JNI_ABORT);
+    return out;
+}
+
+/// The 64-byte motion key of the pattern for (pubkey, timestamp), or null.
+extern "C" JNIEXPORT jbyteArray JNICALL
+Java_io_estream_app_spark_SparkScannerModule_nativeMotionKey(JNIEnv* env, jclass /* clazz */, jbyteArray pubkey,
+                                                             jlong timestamp) {
+    if (pubkey == nullptr) {
+        return nullptr;
+    }
+    const jsize len = env->GetArrayLength(pubkey);
+    jbyte* bytes = env->GetByteArrayElements(pubkey, nullptr);
+    if (bytes == nullptr) {
+        return nullptr;
+    }
+    uint8_t key[64];
+    const int result = estream_spark_motion_key(reinterpret_cast<const uint8_t*>(bytes), len,
+                                                static_cast<int64_t>(timestamp), key);
+    env->ReleaseByteArrayElements(pubkey, bytes, JNI_ABORT);
+    if (result != 0) {
+        return nullptr;
+    }
+    jbyteArray out = env->NewByteArray(sizeof(key));
+    if (out != nullptr) {
+        env->SetByteArrayRegion(out, 0, sizeof(key), reinterpret_cast<const jbyte*>(key));
+    }
+    return out;
+}
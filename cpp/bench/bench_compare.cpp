@@ -0,0 +1,189 @@
+/**
+ * Baseline store and regression report for estream-bench/1 results.
+ *
+ *   bench_compare save <run.json> [--store DIR]
+ *   bench_compare compare <run.json> [--baseline FILE | --store DIR]
+ *                 [--alpha 0.05] [--threshold 0.05] [--confidence 0.95]
+ *                 [--resamples 5000]
+ *
+ * Baselines are stored per machine as DIR/<machine id>/<bench>.json
+ * (default DIR: bench/baselines). A metric regresses when the Mann-Whitney
+ * test rejects "same distribution" at --alpha, the bootstrap confidence
+ * interval of the median ratio excludes 1, and the median moved in the
+ * worse direction by more than --threshold. Exit status is 1 if any
+ * metric regressed.
+ */
+
+#include "report.h"
+#include "stats.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <sys/stat.h>
+
+using namespace estream::bench;
+
+namespace {
+
+/// Fewer samples than this on either side: report the change, no verdict.
+constexpr size_t kMinSamples = 3;
+
+struct Options {
+    std::string command;
+    std::string run_path;
+    std::string baseline_path;
+    std::string store = ESTREAM_BENCH_DIR "/baselines";
+    double alpha = 0.05;
+    double threshold = 0.05;
+    double confidence = 0.95;
+    int resamples = 5000;
+};
+
+std::string baseline_path_for(const Options& opt, const Report& run) {
+    return opt.store + "/" + run.machine.id + "/" + run.bench + ".json";
+}
+
+bool make_dir(const std::string& path) {
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+int save(const Options& opt, const Report& run) {
+    const std::string dir = opt.store + "/" + run.machine.id;
+    if (run.machine.id.empty() || !make_dir(opt.store) || !make_dir(dir)) {
+        std::fprintf(stderr, "bench_compare: cannot create %s\n", dir.c_str());
+        return 2;
+    }
+    const std::string path = baseline_path_for(opt, run);
+    if (!write_report(path, run)) {
+        std::fprintf(stderr, "bench_compare: cannot write %s\n", path.c_str());
+        return 2;
+    }
+    std::printf("baseline for %s on %s saved to %s\n", run.bench.c_str(), run.machine.id.c_str(),
+                path.c_str());
+    return 0;
+}
+
+const Metric* find_metric(const Report& r, const std::string& name) {
+    for (const Metric& m : r.metrics) {
+        if (m.name == name) {
+            return &m;
+        }
+    }
+    return nullptr;
+}
+
+int compare(const Options& opt, const Report& run) {
+    const std::string path = opt.baseline_path.empty() ? baseline_path_for(opt, run) : opt.baseline_path;
+    Report base;
+    std::string error;
+    if (!read_report(path, base, error)) {
+        std::fprintf(stderr, "bench_compare: no baseline: %s\n", error.c_str());
+        return 2;
+    }
+    if (base.bench != run.bench) {
+        std::fprintf(stderr, "bench_compare: baseline is for %s, run is %s\n", base.bench.c_str(),
+                     run.bench.c_str());
+        return 2;
+    }
+    if (base.machine.id != run.machine.id || base.machine.cpu != run.machine.cpu) {
+        std::printf("warning: baseline from %s (%s), run on %s (%s)\n", base.machine.id.c_str(),
+                    base.machine.cpu.c_str(), run.machine.id.c_str(), run.machine.cpu.c_str());
+    }
+
+    std::printf("%s: %s vs baseline %s (alpha %.3g, threshold %.1f%%, %.0f%% CI)\n\n",
+                run.bench.c_str(), run.label.empty() ? "run" : run.label.c_str(),
+                base.label.empty() ? "" : base.label.c_str(), opt.alpha, opt.threshold * 100,
+                opt.confidence * 100);
+    std::printf("%-36s %14s %14s %8s %9s %19s  %s\n", "metric", "baseline", "current", "change",
+                "p", "ratio CI", "verdict");
+
+    int regressions = 0;
+    int improvements = 0;
+    for (const Metric& cur : run.metrics) {
+        const Metric* prev = find_metric(base, cur.name);
+        const double cur_med = median(cur.samples);
+        if (prev == nullptr) {
+            std::printf("%-36s %14s %14.4g %8s %9s %19s  new\n", cur.name.c_str(), "-", cur_med, "",
+                        "", "");
+            continue;
+        }
+        const double base_med = median(prev->samples);
+        const double ratio = base_med != 0 ? cur_med / base_med : 0;
+        const bool worse = cur.better == Better::Higher ? ratio < 1 : ratio > 1;
+        std::printf("%-36s %14.4g %14.4g %+7.1f%%", cur.name.c_str(), base_med, cur_med,
+                    (ratio - 1) * 100);
+
+        if (cur.samples.size() < kMinSamples || prev->samples.size() < kMinSamples) {
+            std::printf(" %9s %19s  unverified (n=%zu/%zu)\n", "", "", prev->samples.size(),
+                        cur.samples.size());
+            continue;
+        }
+        const double p = mann_whitney_p(prev->samples, cur.samples);
+        const Interval ci = bootstrap_median_ratio(prev->samples, cur.samples, opt.confidence,
+                                                   opt.resamples, 0x5eed);
+        const bool significant = p < opt.alpha && (ci.lo > 1 || ci.hi < 1);
+        const bool material = std::fabs(ratio - 1) > opt.threshold;
+        const char* verdict = "~";
+        if (significant && material) {
+            verdict = worse ? "REGRESSION" : "improved";
+            (worse ? regressions : improvements)++;
+        }
+        std::printf(" %9.2g   [%6.3f, %6.3f]  %s\n", p, ci.lo, ci.hi, verdict);
+    }
+    for (const Metric& prev : base.metrics) {
+        if (find_metric(run, prev.name) == nullptr) {
+            std::printf("%-36s %14.4g %14s %8s %9s %19s  missing\n", prev.name.c_str(),
+                        median(prev.samples), "-", "", "", "");
+        }
+    }
+    std::printf("\n%d regression(s), %d improvement(s)\n", regressions, improvements);
+    return regressions > 0 ? 1 : 0;
+}
+
+bool parse_args(int argc, char** argv, Options& o) {
+    if (argc < 3) {
+        return false;
+    }
+    o.command = argv[1];
+    o.run_path = argv[2];
+    for (int i = 3; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* v = argv[++i];
+        if (arg == "--store") o.store = v;
+        else if (arg == "--baseline") o.baseline_path = v;
+        else if (arg == "--alpha") o.alpha = std::atof(v);
+        else if (arg == "--threshold") o.threshold = std::atof(v);
+        else if (arg == "--confidence") o.confidence = std::atof(v);
+        else if (arg == "--resamples") o.resamples = std::atoi(v);
+        else return false;
+    }
+    return o.command == "save" || o.command == "compare";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::fprintf(stderr,
+                     "usage: bench_compare save <run.json> [--store DIR]\n"
+                     "       bench_compare compare <run.json> [--baseline FILE | --store DIR]\n"
+                     "                     [--alpha 0.05] [--threshold 0.05] [--confidence 0.95]\n"
+                     "                     [--resamples 5000]\n");
+        return 2;
+    }
+    Report run;
+    std::string error;
+    if (!read_report(opt.run_path, run, error)) {
+        std::fprintf(stderr, "bench_compare: %s\n", error.c_str());
+        return 2;
+    }
+    return opt.command == "save" ? save(opt, run) : compare(opt, run);
+}
@@ -0,0 +1,284 @@
+/**
+ * Decrypt throughput regression harness.
+ *
+ * Replays corpus/decrypt.corpus through estream_ratchet_decrypt and
+ * reports messages/sec and bytes/sec per case. --json writes every run as
+ * a sample in the estream-bench/1 schema for bench_compare.
+ *
+ *   decrypt_bench --session keys.json [--corpus file] [--runs 5] [--json out.json]
+ */
+
+#include "harness.h"
+#include "report.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace estream;
+
+namespace {
+
+struct Message {
+    std::string json;
+    size_t plaintext_len;
+};
+
+struct CaseResult {
+    std::string name;
+    uint64_t messages = 0;
+    uint64_t plaintext_bytes = 0;
+    uint64_t wire_bytes = 0;
+    uint64_t decrypt_ns = 0;
+    uint64_t failures = 0;
+
+    double messages_per_sec() const { return decrypt_ns ? messages * 1e9 / decrypt_ns : 0; }
+    double bytes_per_sec() const { return decrypt_ns ? plaintext_bytes * 1e9 / decrypt_ns : 0; }
+};
+
+struct Case {
+    std::string name;
+    std::vector<std::vector<std::string>> steps;
+};
+
+// On failure `error` names the file and, for a bad line, its number.
+bool parse_corpus(const std::string& path, std::vector<Case>& cases, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot read corpus " + path;
+        return false;
+    }
+    std::string line;
+    for (size_t number = 1; std::getline(in, line); ++number) {
+        const std::string at = path + ":" + std::to_string(number) + ": ";
+        const size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.resize(hash);
+        }
+        std::istringstream words(line);
+        std::vector<std::string> step;
+        for (std::string w; words >> w;) {
+            step.push_back(w);
+        }
+        if (step.empty()) {
+            continue;
+        }
+        if (step[0] == "deliver" && step.size() == 3 && step[1] == "drop_every" &&
+            std::strtoul(step[2].c_str(), nullptr, 10) == 0) {
+            error = at + "drop_every needs k > 0: " + line;
+            return false;
+        }
+        if (step[0] == "case" && step.size() == 2) {
+            cases.push_back(Case{step[1], {}});
+        } else if (!cases.empty()) {
+            cases.back().steps.push_back(step);
+        } else {
+            error = at + "directive before first case: " + line;
+            return false;
+        }
+    }
+    if (cases.empty()) {
+        error = path + ": no cases";
+        return false;
+    }
+    return true;
+}
+
+// Runs one case on a fresh ratchet pair.
+class Runner {
+public:
+    Runner(const bench::RatchetPair& pair, const std::string& name, uint64_t seed)
+        : pair_(pair), rng_(seed) {
+        result_.name = name;
+    }
+
+    bool step(const std::vector<std::string>& s) {
+        if (s[0] == "send" && s.size() == 5) {
+            const int from = s[1] == "bob" ? 1 : 0;
+            send(from, std::stoul(s[2]), std::stoul(s[3]), std::stoul(s[4]));
+            last_sender_ = from;
+        } else if (s[0] == "deliver" && s.size() >= 2) {
+            std::vector<Message>& q = queue_[last_sender_];
+            if (s[1] == "reverse") {
+                std::reverse(q.begin(), q.end());
+            } else if (s[1] == "shuffle") {
+                for (size_t i = q.size(); i > 1; --i) {
+                    std::swap(q[i - 1], q[rng_.next() % i]);
+                }
+            } else if (s[1] == "drop_every" && s.size() == 3) {
+                const size_t k = std::stoul(s[2]);
+                std::vector<Message> kept;
+                for (size_t i = 0; i < q.size(); ++i) {
+                    ((i + 1) % k == 0 ? late_[last_sender_] : kept).push_back(std::move(q[i]));
+                }
+                q.swap(kept);
+            } else if (s[1] != "in_order") {
+                return false;
+            }
+            deliver(last_sender_, q);
+        } else if (s[0] == "deliver_late") {
+            deliver(0, late_[0]);
+            deliver(1, late_[1]);
+        } else if (s[0] == "turns" && s.size() == 5) {
+            const unsigned long turns = std::stoul(s[1]);
+            for (unsigned long t = 0; t < turns; ++t) {
+                const int from = int(t % 2);
+                send(from, std::stoul(s[2]), std::stoul(s[3]), std::stoul(s[4]));
+                deliver(from, queue_[from]);
+            }
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    const CaseResult& result() const { return result_; }
+
+private:
+    long handle(int side) const { return side == 0 ? pair_.alice : pair_.bob; }
+
+    void send(int from, size_t count, size_t min_size, size_t max_size) {
+        for (size_t i = 0; i < count; ++i) {
+            const size_t len = rng_.range(min_size, max_size);
+            bench::fill_payload(payload_, len, rng_.next());
+            std::string json = bench::encrypt(handle(from), payload_.data(), len);
+            if (json.empty()) {
+                ++result_.failures;
+                continue;
+            }
+            queue_[from].push_back(Message{std::move(json), len});
+        }
+    }
+
+    void deliver(int from, std::vector<Message>& q) {
+        const long to = handle(1 - from);
+        for (const Message& m : q) {
+            const uint64_t t0 = trace::now_ns();
+            const bool ok = bench::decrypt(to, m.json);
+            result_.decrypt_ns += trace::now_ns() - t0;
+            if (!ok) {
+                ++result_.failures;
+                continue;
+            }
+            ++result_.messages;
+            result_.plaintext_bytes += m.plaintext_len;
+            result_.wire_bytes += m.json.size();
+        }
+        q.clear();
+    }
+
+    bench::RatchetPair pair_;
+    bench::Rng rng_;
+    std::vector<uint8_t> payload_;
+    std::vector<Message> queue_[2];
+    std::vector<Message> late_[2];
+    int last_sender_ = 0;
+    CaseResult result_;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: decrypt_bench --session keys.json [--corpus file] [--runs 5]\n"
+                 "                     [--json out.json]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string session_path;
+    std::string corpus_path = ESTREAM_BENCH_DIR "/corpus/decrypt.corpus";
+    std::string json_path;
+    int runs = 5;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--session" && has_value) {
+            session_path = argv[++i];
+        } else if (arg == "--corpus" && has_value) {
+            corpus_path = argv[++i];
+        } else if (arg == "--json" && has_value) {
+            json_path = argv[++i];
+        } else if (arg == "--runs" && has_value) {
+            runs = std::max(1, std::atoi(argv[++i]));
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (session_path.empty()) {
+        usage();
+        return 2;
+    }
+
+    bench::SessionKeys keys;
+    std::string error;
+    if (!bench::load_session(session_path, keys, error)) {
+        std::fprintf(stderr, "decrypt_bench: %s\n", error.c_str());
+        return 2;
+    }
+    std::vector<Case> cases;
+    if (!parse_corpus(corpus_path, cases, error)) {
+        std::fprintf(stderr, "decrypt_bench: %s\n", error.c_str());
+        return 2;
+    }
+
+    // Every run gets fresh ratchet state; the table shows the median run.
+    bench::Report report = bench::new_report("decrypt_bench");
+    std::vector<CaseResult> results;
+    bool failed = false;
+    for (const Case& c : cases) {
+        std::vector<CaseResult> samples;
+        for (int run = 0; run < runs; ++run) {
+            bench::RatchetPair pair;
+            if (!bench::open_pair(keys, pair, error)) {
+                std::fprintf(stderr, "decrypt_bench: %s\n", error.c_str());
+                return 2;
+            }
+            Runner runner(pair, c.name, std::hash<std::string>{}(c.name));
+            for (const auto& s : c.steps) {
+                if (!runner.step(s)) {
+                    std::fprintf(stderr, "decrypt_bench: bad directive '%s' in case %s\n",
+                                 s[0].c_str(), c.name.c_str());
+                    return 2;
+                }
+            }
+            bench::close_pair(pair);
+            const CaseResult& r = runner.result();
+            report.add(c.name + ".messages_per_sec", "msg/s", bench::Better::Higher,
+                       r.messages_per_sec());
+            report.add(c.name + ".bytes_per_sec", "B/s", bench::Better::Higher, r.bytes_per_sec());
+            samples.push_back(r);
+        }
+        std::sort(samples.begin(), samples.end(), [](const CaseResult& a, const CaseResult& b) {
+            return a.messages_per_sec() < b.messages_per_sec();
+        });
+        const CaseResult& median = samples[samples.size() / 2];
+        if (median.failures > 0) {
+            std::fprintf(stderr, "decrypt_bench: %s: %llu messages failed\n", c.name.c_str(),
+                         static_cast<unsigned long long>(median.failures));
+            failed = true;
+        }
+        results.push_back(median);
+    }
+
+    std::printf("%-22s %10s %12s %12s %12s\n", "case", "messages", "msgs/sec", "MB/sec",
+                "wire MB/sec");
+    for (const CaseResult& r : results) {
+        const double wire = r.decrypt_ns ? r.wire_bytes * 1e9 / r.decrypt_ns : 0;
+        std::printf("%-22s %10llu %12.0f %12.2f %12.2f\n", r.name.c_str(),
+                    static_cast<unsigned long long>(r.messages), r.messages_per_sec(),
+                    r.bytes_per_sec() / 1e6, wire / 1e6);
+    }
+
+    if (!json_path.empty() && !bench::write_report(json_path, report)) {
+        std::fprintf(stderr, "decrypt_bench: cannot write %s\n", json_path.c_str());
+        return 2;
+    }
+    return failed ? 1 : 0;
+}
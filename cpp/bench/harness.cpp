@@ -0,0 +1,265 @@
+#include "harness.h"
+
+#include "estream_app_native.h"
+#include "estream_native.h"
+#include "ffi_util.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <unistd.h>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace estream {
+namespace bench {
+
+namespace {
+
+// Position just past `"key":` (and any whitespace), or npos.
+size_t value_start(const std::string& json, const char* key) {
+    const std::string needle = std::string("\"") + key + "\"";
+    size_t pos = json.find(needle);
+    while (pos != std::string::npos) {
+        size_t p = pos + needle.size();
+        while (p < json.size() && (json[p] == ' ' || json[p] == '\n')) ++p;
+        if (p < json.size() && json[p] == ':') {
+            ++p;
+            while (p < json.size() && (json[p] == ' ' || json[p] == '\n')) ++p;
+            return p;
+        }
+        pos = json.find(needle, pos + 1);
+    }
+    return std::string::npos;
+}
+
+}  // namespace
+
+std::string take(char* s) {
+    if (s == nullptr) {
+        return std::string();
+    }
+    std::string out(s);
+    estream_free_string(s);
+    return out;
+}
+
+std::string to_hex(const uint8_t* data, size_t len) {
+    static const char kDigits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(len * 2);
+    for (size_t i = 0; i < len; ++i) {
+        out.push_back(kDigits[data[i] >> 4]);
+        out.push_back(kDigits[data[i] & 0xf]);
+    }
+    return out;
+}
+
+bool from_hex(const std::string& hex, std::vector<uint8_t>& out) {
+    if (hex.size() % 2 != 0) {
+        return false;
+    }
+    out.resize(hex.size() / 2);
+    for (size_t i = 0; i < out.size(); ++i) {
+        char byte[3] = {hex[2 * i], hex[2 * i + 1], '\0'};
+        char* end = nullptr;
+        out[i] = static_cast<uint8_t>(std::strtoul(byte, &end, 16));
+        if (end != byte + 2) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string json_value(const std::string& json, const char* key) {
+    size_t p = value_start(json, key);
+    if (p == std::string::npos || p >= json.size()) {
+        return std::string();
+    }
+    if (json[p] == '"') {
+        const size_t end = json.find('"', p + 1);
+        return end == std::string::npos ? std::string() : json.substr(p + 1, end - p - 1);
+    }
+    const size_t end = json.find_first_of(",}] \n", p);
+    return json.substr(p, end == std::string::npos ? std::string::npos : end - p);
+}
+
+std::string json_object(const std::string& json, const char* key) {
+    const size_t start = value_start(json, key);
+    if (start == std::string::npos || start >= json.size() || json[start] != '{') {
+        return std::string();
+    }
+    int depth = 0;
+    bool in_string = false;
+    for (size_t p = start; p < json.size(); ++p) {
+        const char c = json[p];
+        if (in_string) {
+            if (c == '\\') {
+                ++p;
+            } else if (c == '"') {
+                in_string = false;
+            }
+        } else if (c == '"') {
+            in_string = true;
+        } else if (c == '{') {
+            ++depth;
+        } else if (c == '}' && --depth == 0) {
+            return json.substr(start, p - start + 1);
+        }
+    }
+    return std::string();
+}
+
+bool json_bytes(const std::string& json, const char* key, std::vector<uint8_t>& out) {
+    size_t p = value_start(json, key);
+    if (p == std::string::npos || p >= json.size() || json[p] != '[') {
+        return false;
+    }
+    out.clear();
+    const char* c = json.c_str() + p + 1;
+    while (*c && *c != ']') {
+        char* end = nullptr;
+        const unsigned long v = std::strtoul(c, &end, 10);
+        if (end == c || v > 255) {
+            return false;
+        }
+        out.push_back(static_cast<uint8_t>(v));
+        c = end;
+        while (*c == ',' || *c == ' ' || *c == '\n') ++c;
+    }
+    return *c == ']';
+}
+
+bool load_session(const std::string& path, SessionKeys& out, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream buf;
+    buf << in.rdbuf();
+    const std::string json = buf.str();
+    if (!from_hex(json_value(json, "shared_secret_hex"), out.shared_secret) ||
+        out.shared_secret.size() != 32) {
+        error = "shared_secret_hex must be 32 bytes of hex";
+        return false;
+    }
+    if (!from_hex(json_value(json, "kem_public_hex"), out.kem_public) || out.kem_public.empty() ||
+        !from_hex(json_value(json, "kem_secret_hex"), out.kem_secret) || out.kem_secret.empty()) {
+        error = "kem_public_hex / kem_secret_hex missing or invalid";
+        return false;
+    }
+    return true;
+}
+
+bool open_pair(const SessionKeys& keys, RatchetPair& out, std::string& error) {
+    return open_pair(keys, keys.shared_secret, out, error);
+}
+
+bool open_pair(const SessionKeys& keys, const std::vector<uint8_t>& shared_secret, RatchetPair& out,
+               std::string& error) {
+    if (shared_secret.size() != 32) {
+        error = "shared secret must be 32 bytes";
+        return false;
+    }
+    const std::string sender = take(estream_app_ratchet_init_sender(
+        shared_secret.data(), keys.kem_public.data(), keys.kem_public.size()));
+    const std::string handle = json_value(sender, "handle");
+    std::vector<uint8_t> initial_ct;
+    std::vector<uint8_t> alice_kem_public;
+    if (handle.empty() ||
+        !from_hex(json_value(sender, "initial_ciphertext"), initial_ct) ||
+        !from_hex(json_value(sender, "our_kem_public"), alice_kem_public)) {
+        error = "ratchet_init_sender: " + sender;
+        return false;
+    }
+    out.alice = std::strtol(handle.c_str(), nullptr, 10);
+
+    const std::string receiver = take(estream_app_ratchet_init_receiver(
+        shared_secret.data(),
+        keys.kem_secret.data(), keys.kem_secret.size(),
+        keys.kem_public.data(), keys.kem_public.size(),
+        initial_ct.data(), initial_ct.size(),
+        alice_kem_public.data(), alice_kem_public.size()));
+    const std::string bob = json_value(receiver, "handle");
+    if (bob.empty()) {
+        error = "ratchet_init_receiver: " + receiver;
+        estream_app_ratchet_dispose(out.alice);
+        out.alice = -1;
+        return false;
+    }
+    out.bob = std::strtol(bob.c_str(), nullptr, 10);
+    return true;
+}
+
+void close_pair(RatchetPair& pair) {
+    if (pair.alice >= 0) {
+        estream_app_ratchet_dispose(pair.alice);
+    }
+    if (pair.bob >= 0) {
+        estream_app_ratchet_dispose(pair.bob);
+    }
+    pair = RatchetPair{};
+}
+
+std::string encrypt(long handle, const uint8_t* plaintext, size_t len) {
+    const std::string result = take(estream_app_ratchet_encrypt(handle, plaintext, len));
+    return json_object(result, "data");
+}
+
+bool decrypt(long handle, const std::string& message_json) {
+    char* result = estream_app_ratchet_decrypt(handle, message_json.c_str());
+    if (result == nullptr) {
+        return false;
+    }
+    const bool ok = !ffi_failed(result);
+    estream_free_string(result);
+    return ok;
+}
+
+uint64_t rss_bytes() {
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (f == nullptr) {
+        return 0;
+    }
+    unsigned long long size = 0;
+    unsigned long long resident = 0;
+    const int n = std::fscanf(f, "%llu %llu", &size, &resident);
+    std::fclose(f);
+    return n == 2 ? resident * uint64_t(sysconf(_SC_PAGESIZE)) : 0;
+}
+
+uint64_t heap_bytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    const struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+void fill_payload(std::vector<uint8_t>& out, size_t len, uint64_t seed) {
+    static const char kText[] =
+        "the quick brown fox jumps over the lazy dog, see you at 7? ok! ";
+    out.resize(len);
+    Rng rng(seed);
+    if (len <= 1024) {
+        const size_t offset = rng.next() % (sizeof(kText) - 1);
+        for (size_t i = 0; i < len; ++i) {
+            out[i] = static_cast<uint8_t>(kText[(offset + i) % (sizeof(kText) - 1)]);
+        }
+        return;
+    }
+    for (size_t i = 0; i < len; i += 8) {
+        const uint64_t v = rng.next();
+        std::memcpy(out.data() + i, &v, len - i < 8 ? len - i : 8);
+    }
+}
+
+}  // namespace bench
+}  // namespace estream
@@ -0,0 +1,100 @@
+/**
+ * Shared helpers for the host benchmarks that drive the Rust core.
+ *
+ * These binaries link a host build of estream-mobile-core (see
+ * ESTREAM_CORE_LIBRARY in ../CMakeLists.txt) and call it through the
+ * instrumented estream_app_* entry points.
+ */
+
+#ifndef ESTREAM_BENCH_HARNESS_H
+#define ESTREAM_BENCH_HARNESS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace estream {
+namespace bench {
+
+/// Take ownership of a string returned by the Rust core ("" for NULL).
+std::string take(char* s);
+
+std::string to_hex(const uint8_t* data, size_t len);
+bool from_hex(const std::string& hex, std::vector<uint8_t>& out);
+
+/// Scalar value of the first `"key":` in `json`: a string's contents or a
+/// number/literal's text. Empty if absent.
+std::string json_value(const std::string& json, const char* key);
+
+/// Raw text of the first `"key": {...}` object in `json`. Empty if absent.
+std::string json_object(const std::string& json, const char* key);
+
+/// Bytes of the first `"key": [n, n, ...]` array of numbers in `json`.
+bool json_bytes(const std::string& json, const char* key, std::vector<uint8_t>& out);
+
+/// Inputs for a Double Ratchet pair: the X3DH shared secret and the
+/// receiver's ML-KEM-1024 key pair. Loaded from a JSON file with
+/// "shared_secret_hex", "kem_public_hex" and "kem_secret_hex".
+struct SessionKeys {
+    std::vector<uint8_t> shared_secret;
+    std::vector<uint8_t> kem_public;
+    std::vector<uint8_t> kem_secret;
+};
+
+bool load_session(const std::string& path, SessionKeys& out, std::string& error);
+
+/// Sender ("alice") and receiver ("bob") ratchet handles.
+struct RatchetPair {
+    long alice = -1;
+    long bob = -1;
+};
+
+bool open_pair(const SessionKeys& keys, RatchetPair& out, std::string& error);
+
+/// As above, keyed from `shared_secret` (e.g. a fresh X3DH result) in
+/// place of keys.shared_secret; the KEM pair still comes from `keys`.
+bool open_pair(const SessionKeys& keys, const std::vector<uint8_t>& shared_secret, RatchetPair& out,
+               std::string& error);
+void close_pair(RatchetPair& pair);
+
+/// Encrypt and return the RatchetMessage JSON accepted by decrypt, or "".
+std::string encrypt(long handle, const uint8_t* plaintext, size_t len);
+
+/// Decrypt a RatchetMessage; false on a NULL or error result.
+bool decrypt(long handle, const std::string& message_json);
+
+/// Resident set size of this process in bytes (0 if unavailable).
+uint64_t rss_bytes();
+
+/// Bytes currently allocated from the C heap, which is also where the
+/// Rust core allocates (0 where mallinfo2 is unavailable).
+uint64_t heap_bytes();
+
+/// Deterministic message payload: printable text for sizes up to 1 KiB,
+/// pseudo-random bytes above (media chunks).
+void fill_payload(std::vector<uint8_t>& out, size_t len, uint64_t seed);
+
+/// Small deterministic generator for sizes, drops and shuffles.
+class Rng {
+public:
+    explicit Rng(uint64_t seed) : state_(seed ? seed : 0x9e3779b97f4a7c15ull) {}
+
+    uint64_t next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+
+    /// Uniform in [lo, hi].
+    uint64_t range(uint64_t lo, uint64_t hi) { return lo + next() % (hi - lo + 1); }
+
+private:
+    uint64_t state_;
+};
+
+}  // namespace bench
+}  // namespace estream
+
+#endif /* ESTREAM_BENCH_HARNESS_H */
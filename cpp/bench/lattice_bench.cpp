@@ -0,0 +1,148 @@
+/**
+ * Lattice Code frame rendering throughput.
+ *
+ *   lattice_bench [--sizes 300,600,1080] [--frames 600] [--passes 5]
+ *                 [--json out.json]
+ *
+ * Renders --frames consecutive 20 fps animation frames of a demo pattern
+ * (37 hexagons in all three states, 12 particles) at each size, one pass
+ * after another. Reports frames per second and the time per frame for
+ * each size, with metric names suffixed by the size (frames_per_sec_600).
+ * The size is the frame's side in pixels: LatticeCodeScreen shows the
+ * pattern at up to 300 dp, so 600 and 1080 cover 2x and 3.6x densities.
+ */
+
+#include "lattice_raster.h"
+#include "report.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace estream;
+
+namespace {
+
+struct Options {
+    std::vector<int> sizes = {300, 600, 1080};
+    std::string json_path;
+    int frames = 600;
+    int passes = 5;
+};
+
+bool parse_sizes(const char* v, std::vector<int>& out) {
+    out.clear();
+    for (const char* p = v; *p != '\0';) {
+        char* end = nullptr;
+        const long size = std::strtol(p, &end, 10);
+        if (end == p || size <= 0 || size > 4096) {
+            return false;
+        }
+        out.push_back(static_cast<int>(size));
+        p = *end == ',' ? end + 1 : end;
+    }
+    return !out.empty();
+}
+
+bool parse_args(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* v = argv[++i];
+        if (arg == "--sizes" && parse_sizes(v, o.sizes)) continue;
+        else if (arg == "--json") o.json_path = v;
+        else if (arg == "--frames") o.frames = std::max(1, std::atoi(v));
+        else if (arg == "--passes") o.passes = std::max(1, std::atoi(v));
+        else return false;
+    }
+    return true;
+}
+
+// A pattern like createLatticeCodeState's: every hexagon state and twelve
+// particles at radii 60..110, alternating direction.
+lattice::Scene demo_scene() {
+    lattice::Scene scene;
+    scene.base_hue = 170.0;
+    scene.ring_speed = 0.4;
+    scene.heartbeat_freq = 1.1;
+    for (int i = 0; i < lattice::kHexCount; ++i) {
+        scene.hex_cells.push_back(static_cast<uint8_t>((i * 7) % 3));
+    }
+    scene.particles.center = lattice::kCanvasSize / 2.0;
+    for (int i = 0; i < 12; ++i) {
+        const double rate = 0.5 + 0.1 * i;
+        scene.particles.add(60.0 + 50.0 * i / 11.0, (0.3 + 0.07 * i) * (i % 2 == 0 ? 1.0 : -1.0), i * 0.52, 3.0,
+                            rate, 2.0, rate);
+        scene.particle_colors.push_back(0x00ffd5u ^ (static_cast<uint32_t>(i) * 0x151515u));
+    }
+    return scene;
+}
+
+double percentile(std::vector<double> values, double q) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(q * values.size()))];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::fprintf(stderr, "usage: lattice_bench [--sizes 300,600,1080] [--frames N] [--passes N] [--json file]\n");
+        return 2;
+    }
+
+    const lattice::Scene scene = demo_scene();
+    bench::Report report = bench::new_report("lattice_bench");
+    uint32_t checksum = 0;
+    for (const int size : opt.sizes) {
+        const auto setup_start = std::chrono::steady_clock::now();
+        lattice::Rasterizer rasterizer(size);
+        const double setup_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - setup_start).count();
+        const size_t stride = static_cast<size_t>(size) * 4;
+        std::vector<uint8_t> frame(stride * size);
+        const std::string suffix = "_" + std::to_string(size);
+        std::vector<double> frame_ms;
+        std::vector<double> fps;
+        // One untimed pass warms the caches.
+        for (int pass = -1; pass < opt.passes; ++pass) {
+            const auto pass_start = std::chrono::steady_clock::now();
+            for (int f = 0; f < opt.frames; ++f) {
+                const auto start = std::chrono::steady_clock::now();
+                rasterizer.render(scene, f * 50.0, frame.data(), stride);
+                const auto end = std::chrono::steady_clock::now();
+                if (pass >= 0) {
+                    const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+                    frame_ms.push_back(ms);
+                    report.add("frame_ms" + suffix, "ms", bench::Better::Lower, ms);
+                }
+                checksum += frame[(stride * size / 2 + stride / 2) & ~size_t{3}];
+            }
+            if (pass >= 0) {
+                const double s =
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - pass_start).count();
+                fps.push_back(opt.frames / s);
+                report.add("frames_per_sec" + suffix, "frames/s", bench::Better::Higher, opt.frames / s);
+            }
+        }
+        report.add("setup_ms" + suffix, "ms", bench::Better::Lower, setup_ms);
+        std::printf("%4dx%-4d  %8.0f frames/s  frame ms p50 %.3f  p99 %.3f  (setup %.1f ms)\n", size, size,
+                    percentile(fps, 0.5), percentile(frame_ms, 0.5), percentile(frame_ms, 0.99), setup_ms);
+    }
+    std::printf("%d frames x %d passes per size (checksum %u)\n", opt.frames, opt.passes, checksum);
+
+    if (!opt.json_path.empty() && !bench::write_report(opt.json_path, report)) {
+        std::fprintf(stderr, "lattice_bench: cannot write %s\n", opt.json_path.c_str());
+        return 1;
+    }
+    return 0;
+}
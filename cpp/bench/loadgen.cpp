@@ -0,0 +1,382 @@
+/**
+ * Multi-client load generator on the native client.
+ *
+ * Simulates many clients, each with its own device keys, an X3DH session
+ * against a shared peer bundle and a ratchet pair keyed from that
+ * session's secret, sending at a fixed rate. Sends are open-loop: latency
+ * is measured from each message's scheduled time, so a stalled client
+ * does not hide queueing delay.
+ *
+ *   loadgen --session keys.json [--clients 1000] [--rate 1] [--duration 30]
+ *           [--threads N] [--mode contexts|shared] [--node host:port]
+ *           [--h3 ip:port] [--post-path /api/v1/messages] [--size 200]
+ *           [--json out.json]
+ *
+ * --mode contexts gives each client its own estream_initialize runtime;
+ * shared uses one runtime for every client. With --h3 each message is
+ * POSTed over HTTP/3 (point it at a local node); without it a send is
+ * encrypt plus the peer's decrypt.
+ *
+ * The core has a single HTTP/3 connection, shared by every client and
+ * taken one request at a time (the "h3_connection" lock), so --h3 measures
+ * serialized sends on one connection, not many concurrent connections,
+ * and --mode does not change how they are sent.
+ */
+
+#include "harness.h"
+#include "histogram.h"
+#include "report.h"
+#include "trace.h"
+
+#include "estream_app_native.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace estream;
+
+namespace {
+
+struct Options {
+    std::string session_path;
+    std::string node_addr;
+    std::string h3_addr;
+    std::string post_path = "/api/v1/messages";
+    std::string json_path;
+    size_t clients = 1000;
+    double rate = 1.0;  // Messages per second per client.
+    uint32_t duration_s = 30;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    bool shared_runtime = false;
+    size_t size = 200;
+};
+
+struct Client {
+    long runtime = -1;
+    bench::RatchetPair pair;
+    uint64_t next_due_ns = 0;
+    uint64_t sent = 0;
+};
+
+/// Uniform random sample of at most kCapacity values (Algorithm R), kept
+/// for the statistical comparison in bench_compare.
+class Reservoir {
+public:
+    static constexpr size_t kCapacity = 4096;
+
+    explicit Reservoir(uint64_t seed = 1) : rng_(seed) {}
+
+    void add(double v) {
+        ++seen_;
+        if (values_.size() < kCapacity) {
+            values_.push_back(v);
+        } else {
+            const uint64_t slot = rng_.next() % seen_;
+            if (slot < kCapacity) {
+                values_[slot] = v;
+            }
+        }
+    }
+
+    const std::vector<double>& values() const { return values_; }
+
+private:
+    bench::Rng rng_;
+    uint64_t seen_ = 0;
+    std::vector<double> values_;
+};
+
+/// Per-worker results; merged after the run.
+struct WorkerStats {
+    Histogram setup;
+    Histogram send;
+    Reservoir send_samples;
+    uint64_t sent = 0;
+    uint64_t bytes = 0;
+    uint64_t errors = 0;
+    uint64_t setup_errors = 0;
+};
+
+struct Shared {
+    const Options* opt;
+    const bench::SessionKeys* keys;
+    std::string peer_bundle;
+    long shared_runtime = -1;
+};
+
+bool ok_result(const std::string& json) {
+    return !json.empty() && json.find("\"error\"") == std::string::npos &&
+           json.find("\"success\":false") == std::string::npos;
+}
+
+// Runtime + connection, device keys, X3DH against the peer, and a ratchet
+// pair keyed from that X3DH's shared secret. The core does not export a
+// KEM secret key, so the receiver's ML-KEM pair comes from --session.
+bool setup_client(Shared& sh, Client& c, size_t index) {
+    const Options& opt = *sh.opt;
+    if (opt.shared_runtime) {
+        c.runtime = sh.shared_runtime;
+    } else {
+        c.runtime = estream_app_initialize();
+        if (c.runtime < 0) {
+            return false;
+        }
+        if (!opt.node_addr.empty() &&
+            !ok_result(bench::take(estream_app_connect(c.runtime, opt.node_addr.c_str())))) {
+            return false;
+        }
+    }
+
+    const std::string scope = "io.estream.loadgen." + std::to_string(index);
+    const std::string keys = bench::take(estream_app_generate_device_keys(scope.c_str()));
+    std::vector<uint8_t> identity;
+    if (!ok_result(keys) || !bench::json_bytes(keys, "signature_public", identity)) {
+        return false;
+    }
+    const std::string x3dh = bench::take(
+        estream_app_x3dh_initiate(identity.data(), identity.size(), sh.peer_bundle.c_str()));
+    std::vector<uint8_t> shared_secret;
+    if (!ok_result(x3dh) || !bench::from_hex(bench::json_value(x3dh, "shared_secret_hex"), shared_secret)) {
+        return false;
+    }
+    std::string error;
+    return bench::open_pair(*sh.keys, shared_secret, c.pair, error);
+}
+
+void setup_worker(Shared& sh, std::vector<Client>& clients, size_t first, size_t count,
+                  WorkerStats& stats) {
+    for (size_t i = first; i < first + count; ++i) {
+        const uint64_t t0 = trace::now_ns();
+        if (!setup_client(sh, clients[i], i)) {
+            ++stats.setup_errors;
+        }
+        stats.setup.record(trace::now_ns() - t0);
+    }
+}
+
+void send_worker(Shared& sh, std::vector<Client>& clients, size_t first, size_t count,
+                 uint64_t start_ns, uint64_t end_ns, WorkerStats& stats) {
+    const Options& opt = *sh.opt;
+    const uint64_t period_ns = uint64_t(1e9 / opt.rate);
+    std::vector<uint8_t> payload;
+
+    // Earliest-due client first. First sends are spread across one period
+    // so clients do not fire in lockstep.
+    using Due = std::pair<uint64_t, Client*>;
+    std::priority_queue<Due, std::vector<Due>, std::greater<Due>> queue;
+    for (size_t i = first; i < first + count; ++i) {
+        Client& c = clients[i];
+        c.next_due_ns = start_ns + period_ns * (i - first) / count;
+        if (c.pair.alice >= 0) {
+            queue.emplace(c.next_due_ns, &c);
+        }
+    }
+
+    while (!queue.empty() && queue.top().first < end_ns) {
+        Client* due = queue.top().second;
+        queue.pop();
+        const uint64_t now = trace::now_ns();
+        if (now < due->next_due_ns) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(due->next_due_ns - now));
+        }
+
+        bench::fill_payload(payload, opt.size, due->sent);
+        const std::string message = bench::encrypt(due->pair.alice, payload.data(), payload.size());
+        bool ok = !message.empty();
+        if (ok && !opt.h3_addr.empty()) {
+            ok = ok_result(bench::take(estream_app_h3_post(opt.post_path.c_str(), message.c_str())));
+        } else if (ok) {
+            ok = bench::decrypt(due->pair.bob, message);
+        }
+        const uint64_t latency_ns = trace::now_ns() - due->next_due_ns;
+        stats.send.record(latency_ns);
+        stats.send_samples.add(double(latency_ns));
+        if (ok) {
+            ++stats.sent;
+            stats.bytes += message.size();
+        } else {
+            ++stats.errors;
+        }
+        ++due->sent;
+        due->next_due_ns += period_ns;
+        queue.emplace(due->next_due_ns, due);
+    }
+}
+
+void print_histogram(const char* label, const Histogram& h) {
+    std::printf("%-8s n=%-9llu p50 %9.3f ms  p90 %9.3f ms  p99 %9.3f ms  p99.9 %9.3f ms  max %9.3f ms\n",
+                label, static_cast<unsigned long long>(h.count()), h.percentile(0.50) / 1e6,
+                h.percentile(0.90) / 1e6, h.percentile(0.99) / 1e6, h.percentile(0.999) / 1e6,
+                h.max() / 1e6);
+}
+
+bool parse_args(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* v = argv[++i];
+        if (arg == "--session") o.session_path = v;
+        else if (arg == "--node") o.node_addr = v;
+        else if (arg == "--h3") o.h3_addr = v;
+        else if (arg == "--post-path") o.post_path = v;
+        else if (arg == "--json") o.json_path = v;
+        else if (arg == "--clients") o.clients = std::max<size_t>(1, std::strtoul(v, nullptr, 10));
+        else if (arg == "--rate") o.rate = std::max(0.001, std::atof(v));
+        else if (arg == "--duration") o.duration_s = std::max(1, std::atoi(v));
+        else if (arg == "--threads") o.threads = std::max(1, std::atoi(v));
+        else if (arg == "--size") o.size = std::max<size_t>(1, std::strtoul(v, nullptr, 10));
+        else if (arg == "--mode" && std::string(v) == "shared") o.shared_runtime = true;
+        else if (arg == "--mode" && std::string(v) == "contexts") o.shared_runtime = false;
+        else return false;
+    }
+    return !o.session_path.empty();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::fprintf(stderr,
+                     "usage: loadgen --session keys.json [--clients N] [--rate msgs/s/client]\n"
+                     "               [--duration s] [--threads N] [--mode contexts|shared]\n"
+                     "               [--node host:port] [--h3 ip:port] [--post-path p] [--size B]\n"
+                     "               [--json file]\n"
+                     "--h3 sends share the core's one HTTP/3 connection and run one at a time.\n");
+        return 2;
+    }
+
+    bench::SessionKeys keys;
+    std::string error;
+    if (!bench::load_session(opt.session_path, keys, error)) {
+        std::fprintf(stderr, "loadgen: %s\n", error.c_str());
+        return 2;
+    }
+
+    Shared sh;
+    sh.opt = &opt;
+    sh.keys = &keys;
+    const std::string bundle = bench::take(
+        estream_app_generate_prekey_bundle("loadgen-peer", int(std::min<size_t>(opt.clients, 1000))));
+    sh.peer_bundle = bench::json_object(bundle, "bundle");
+    if (sh.peer_bundle.empty()) {
+        sh.peer_bundle = bench::json_object(bundle, "data");
+    }
+    if (sh.peer_bundle.empty()) {
+        std::fprintf(stderr, "loadgen: generate_prekey_bundle: %s\n", bundle.c_str());
+        return 2;
+    }
+    if (opt.shared_runtime) {
+        sh.shared_runtime = estream_app_initialize();
+        if (sh.shared_runtime < 0 ||
+            (!opt.node_addr.empty() &&
+             !ok_result(bench::take(estream_app_connect(sh.shared_runtime, opt.node_addr.c_str()))))) {
+            std::fprintf(stderr, "loadgen: cannot create shared runtime\n");
+            return 2;
+        }
+    }
+    if (!opt.h3_addr.empty() && !ok_result(bench::take(estream_app_h3_connect(opt.h3_addr.c_str())))) {
+        std::fprintf(stderr, "loadgen: h3_connect %s failed\n", opt.h3_addr.c_str());
+        return 2;
+    }
+
+    estream_resource_accounting(1);
+    std::vector<Client> clients(opt.clients);
+    const unsigned threads = unsigned(std::min<size_t>(opt.threads, opt.clients));
+    std::vector<WorkerStats> stats(threads);
+    const uint64_t rss_before = bench::rss_bytes();
+
+    // Each worker owns a contiguous slice of clients for both phases.
+    auto run_phase = [&](auto&& body) {
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < threads; ++t) {
+            const size_t first = opt.clients * t / threads;
+            const size_t last = opt.clients * (t + 1) / threads;
+            pool.emplace_back([&, t, first, last] { body(first, last - first, stats[t]); });
+        }
+        for (std::thread& t : pool) {
+            t.join();
+        }
+    };
+    run_phase([&](size_t first, size_t count, WorkerStats& s) {
+        setup_worker(sh, clients, first, count, s);
+    });
+    const uint64_t rss_ready = bench::rss_bytes();
+
+    const uint64_t start_ns = trace::now_ns();
+    const uint64_t end_ns = start_ns + uint64_t(opt.duration_s) * 1000000000ull;
+    run_phase([&](size_t first, size_t count, WorkerStats& s) {
+        send_worker(sh, clients, first, count, start_ns, end_ns, s);
+    });
+    const double elapsed_s = (trace::now_ns() - start_ns) / 1e9;
+    const uint64_t rss_after = bench::rss_bytes();
+
+    WorkerStats total;
+    for (const WorkerStats& s : stats) {
+        total.setup.merge(s.setup);
+        total.send.merge(s.send);
+        total.sent += s.sent;
+        total.bytes += s.bytes;
+        total.errors += s.errors;
+        total.setup_errors += s.setup_errors;
+    }
+    for (Client& c : clients) {
+        bench::close_pair(c.pair);
+        if (!opt.shared_runtime && c.runtime >= 0) {
+            estream_app_dispose(c.runtime);
+        }
+    }
+    if (opt.shared_runtime) {
+        estream_app_dispose(sh.shared_runtime);
+    }
+
+    std::printf("clients %zu (%s runtime), %u threads, %.1f msgs/s/client target, %s\n",
+                opt.clients, opt.shared_runtime ? "shared" : "per-client", threads, opt.rate,
+                opt.h3_addr.empty() ? "crypto only"
+                                    : ("HTTP/3 " + opt.h3_addr + " (one connection, sends serialized)").c_str());
+    std::printf("sent %llu in %.1f s: %.0f msgs/sec, %.2f MB/sec; %llu send errors, %llu setup errors\n",
+                static_cast<unsigned long long>(total.sent), elapsed_s, total.sent / elapsed_s,
+                total.bytes / elapsed_s / 1e6, static_cast<unsigned long long>(total.errors),
+                static_cast<unsigned long long>(total.setup_errors));
+    std::printf("rss %.1f MB -> %.1f MB after setup (%.1f KB per client) -> %.1f MB after run\n",
+                rss_before / 1048576.0, rss_ready / 1048576.0,
+                (double(rss_ready) - double(rss_before)) / 1024.0 / double(opt.clients),
+                rss_after / 1048576.0);
+    print_histogram("setup", total.setup);
+    print_histogram("send", total.send);
+
+    if (!opt.json_path.empty()) {
+        bench::Report report = bench::new_report("loadgen");
+        report.label += (report.label.empty() ? "" : " ") + std::to_string(opt.clients) + " clients";
+        report.add("messages_per_sec", "msg/s", bench::Better::Higher, total.sent / elapsed_s);
+        for (const WorkerStats& s : stats) {
+            for (double v : s.send_samples.values()) {
+                report.add("send_latency_ns", "ns", bench::Better::Lower, v);
+            }
+        }
+        report.add("rss_per_client_kb", "KB", bench::Better::Lower,
+                   (double(rss_ready) - double(rss_before)) / 1024.0 / double(opt.clients));
+        if (!bench::write_report(opt.json_path, report)) {
+            std::fprintf(stderr, "loadgen: cannot write %s\n", opt.json_path.c_str());
+            return 2;
+        }
+    }
+
+    char* per_fn = estream_latency_report();
+    std::printf("per-entry-point latency: %s\n", per_fn);
+    estream_app_free_string(per_fn);
+    char* usage = estream_resource_usage();
+    std::printf("cpu by subsystem: %s\n", usage);
+    estream_app_free_string(usage);
+    return total.errors + total.setup_errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,262 @@
+/**
+ * QR signing payload sizes: protocol v1 (base58 JSON) against v2 (compact
+ * binary as Base45).
+ *
+ *   qr_codec_bench [--iterations 2000] [--json out.json]
+ *
+ * Builds a typical deploy request and an ML-DSA-87 response. Each is
+ * encoded the way QrSigningService does for v1 (JSON with base58 fields,
+ * base58 again behind estream-sign:// / estream-sig://, byte mode) and for
+ * v2 (qr_codec.h, Base45 behind ESTREAM-SIGN:// / ESTREAM-SIG://,
+ * alphanumeric mode). For each it reports characters, QR data bits, the
+ * smallest QR version that holds it at level M (0: none does) and the
+ * animated-QR frames it takes. Fountain fragments are 120 bytes for v1 and
+ * 176 for v2, the most that fit a version 10 frame at level M in each
+ * format. It also times v2 encoding and decoding.
+ */
+
+#include "fountain.h"
+#include "qr_codec.h"
+#include "report.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace estream;
+
+namespace {
+
+struct Options {
+    std::string json_path;
+    int iterations = 2000;
+};
+
+bool parse_args(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* v = argv[++i];
+        if (arg == "--json") o.json_path = v;
+        else if (arg == "--iterations") o.iterations = std::max(1, std::atoi(v));
+        else return false;
+    }
+    return true;
+}
+
+std::string base58(const std::vector<uint8_t>& data) {
+    static const char alphabet[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+    size_t zeros = 0;
+    while (zeros < data.size() && data[zeros] == 0) {
+        ++zeros;
+    }
+    // Base 58 digits, least significant first.
+    std::vector<uint8_t> digits;
+    digits.reserve(data.size() * 138 / 100 + 1);
+    for (size_t i = zeros; i < data.size(); ++i) {
+        uint32_t carry = data[i];
+        for (uint8_t& d : digits) {
+            carry += uint32_t{d} << 8;
+            d = static_cast<uint8_t>(carry % 58);
+            carry /= 58;
+        }
+        while (carry > 0) {
+            digits.push_back(static_cast<uint8_t>(carry % 58));
+            carry /= 58;
+        }
+    }
+    std::string out(zeros, '1');
+    for (size_t i = digits.size(); i-- > 0;) {
+        out.push_back(alphabet[digits[i]]);
+    }
+    return out;
+}
+
+std::vector<uint8_t> bytes_of(const std::string& s) {
+    return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+// Data codewords per QR version at error correction level M.
+const int kDataCodewordsM[40] = {
+    16,   28,   44,   64,   86,   108,  124,  154,  182,  216,  254,  290,  334,  365,
+    415,  453,  507,  563,  627,  669,  714,  782,  860,  914,  1000, 1062, 1128, 1193,
+    1267, 1373, 1455, 1541, 1631, 1725, 1812, 1914, 1992, 2102, 2216, 2334,
+};
+
+// Data bits of `chars` characters in one segment, including the mode and
+// character count indicators.
+int segment_bits(size_t chars, bool alphanumeric, int version) {
+    const int count_bits = alphanumeric ? (version < 10 ? 9 : version < 27 ? 11 : 13) : (version < 10 ? 8 : 16);
+    const size_t payload = alphanumeric ? chars / 2 * 11 + (chars % 2) * 6 : chars * 8;
+    return 4 + count_bits + static_cast<int>(payload);
+}
+
+int smallest_version(size_t chars, bool alphanumeric) {
+    for (int v = 1; v <= 40; ++v) {
+        if (segment_bits(chars, alphanumeric, v) <= kDataCodewordsM[v - 1] * 8) {
+            return v;
+        }
+    }
+    return 0;
+}
+
+struct Encoded {
+    std::string text;
+    bool alphanumeric = false;
+    /// The bytes the fountain codes when animated, and each part's prefix.
+    std::vector<uint8_t> message;
+    std::string part_prefix;
+    size_t fragment_bytes = 0;
+};
+
+// One animated frame: a part of `encoded.message`, as that format writes
+// parts. Characters per frame and frames for every fragment once.
+void animated(const Encoded& encoded, size_t& frame_chars, uint32_t& frames) {
+    fountain::Encoder encoder(encoded.message.data(), encoded.message.size(), encoded.fragment_bytes);
+    std::vector<uint8_t> part(encoder.part_bytes());
+    encoder.part(1, part.data());
+    const std::string body = encoded.alphanumeric ? qr::base45_encode(part.data(), part.size()) : base58(part);
+    frame_chars = encoded.part_prefix.size() + body.size();
+    frames = encoder.fragment_count();
+}
+
+void add_format(bench::Report& report, const std::string& name, const Encoded& encoded) {
+    size_t frame_chars = 0;
+    uint32_t frames = 0;
+    animated(encoded, frame_chars, frames);
+    const int version = smallest_version(encoded.text.size(), encoded.alphanumeric);
+    const int bits = segment_bits(encoded.text.size(), encoded.alphanumeric, 40);
+    const int frame_version = smallest_version(frame_chars, encoded.alphanumeric);
+    report.add(name + "_chars", "chars", bench::Better::Lower, static_cast<double>(encoded.text.size()));
+    report.add(name + "_qr_bits", "bits", bench::Better::Lower, bits);
+    report.add(name + "_qr_version", "version", bench::Better::Lower, version);
+    report.add(name + "_frames", "frames", bench::Better::Lower, frames);
+    report.add(name + "_frame_version", "version", bench::Better::Lower, frame_version);
+    std::printf("%-14s %6zu chars  %6d bits  QR %-4s  animated: %3u frames of %3zu chars (QR %d)\n", name.c_str(),
+                encoded.text.size(), bits, version > 0 ? std::to_string(version).c_str() : "none", frames,
+                frame_chars, frame_version);
+}
+
+qr::SigningRequest demo_request() {
+    qr::SigningRequest request;
+    request.id = "0f8fad5b-d9cb-469f-a165-70867728950e";
+    request.operation = "deploy";
+    request.description = "Deploy release 2026.10 to edge-west (3 nodes)";
+    for (uint8_t i = 0; i < 32; ++i) {
+        request.payload.push_back(static_cast<uint8_t>(i * 73 + 11));
+    }
+    request.timestamp = 1760000000123;
+    request.expires_at = 1760000300123;
+    request.metadata = "{\"releaseId\":\"r-2026.10\",\"targets\":[\"edge-west\"],\"strategy\":\"rolling\"}";
+    return request;
+}
+
+qr::SigningResponse demo_response() {
+    qr::SigningResponse response;
+    response.request_id = "0f8fad5b-d9cb-469f-a165-70867728950e";
+    uint32_t x = 2463534242u;
+    for (size_t i = 0; i < 4627; ++i) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        response.signature.push_back(static_cast<uint8_t>(x));
+    }
+    for (uint8_t i = 0; i < 32; ++i) {
+        response.signer_key_hash.push_back(static_cast<uint8_t>(i * 29 + 3));
+    }
+    response.algorithm = "ML-DSA-87";
+    response.timestamp = 1760000000456;
+    return response;
+}
+
+// QrSigningService v1: JSON, binary fields base58, all of it base58.
+Encoded v1_request(const qr::SigningRequest& r) {
+    const std::string json = "{\"id\":\"" + r.id + "\",\"operation\":\"" + r.operation + "\",\"description\":\"" +
+                             r.description + "\",\"payload\":\"" + base58(r.payload) +
+                             "\",\"timestamp\":" + std::to_string(r.timestamp) +
+                             ",\"expiresAt\":" + std::to_string(r.expires_at) + ",\"metadata\":" + r.metadata + "}";
+    return {"estream-sign://v1/" + base58(bytes_of(json)), false, bytes_of(json), "estream-signp://v1/", 120};
+}
+
+Encoded v1_response(const qr::SigningResponse& r) {
+    const std::string json = "{\"id\":\"" + r.request_id + "\",\"sig\":\"" + base58(r.signature) + "\",\"key\":\"" +
+                             base58(r.signer_key_hash) + "\",\"alg\":\"" + r.algorithm +
+                             "\",\"ts\":" + std::to_string(r.timestamp) + "}";
+    return {"estream-sig://v1/" + base58(bytes_of(json)), false, bytes_of(json), "estream-sigp://v1/", 120};
+}
+
+template <typename Message>
+Encoded v2(const Message& m, const char* scheme, const char* part_scheme) {
+    const std::vector<uint8_t> binary = qr::encode(m);
+    return {std::string(scheme) + qr::base45_encode(binary.data(), binary.size()), true, binary, part_scheme, 176};
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::fprintf(stderr, "usage: qr_codec_bench [--iterations N] [--json file]\n");
+        return 2;
+    }
+
+    const qr::SigningRequest request = demo_request();
+    const qr::SigningResponse response = demo_response();
+    bench::Report report = bench::new_report("qr_codec_bench");
+
+    const Encoded request_v1 = v1_request(request);
+    const Encoded request_v2 = v2(request, "ESTREAM-SIGN://V2/", "ESTREAM-SIGNP://V2/");
+    const Encoded response_v1 = v1_response(response);
+    const Encoded response_v2 = v2(response, "ESTREAM-SIG://V2/", "ESTREAM-SIGP://V2/");
+    add_format(report, "request_v1", request_v1);
+    add_format(report, "request_v2", request_v2);
+    add_format(report, "response_v1", response_v1);
+    add_format(report, "response_v2", response_v2);
+
+    // v2 bits as a share of v1's.
+    const double request_ratio = static_cast<double>(segment_bits(request_v2.text.size(), true, 40)) /
+                                 segment_bits(request_v1.text.size(), false, 40);
+    const double response_ratio = static_cast<double>(segment_bits(response_v2.text.size(), true, 40)) /
+                                  segment_bits(response_v1.text.size(), false, 40);
+    report.add("request_bits_ratio", "ratio", bench::Better::Lower, request_ratio);
+    report.add("response_bits_ratio", "ratio", bench::Better::Lower, response_ratio);
+    std::printf("v2 / v1 QR bits: request %.3f, response %.3f\n", request_ratio, response_ratio);
+
+    // Encode to text and back, as the app does per response and request.
+    size_t checksum = 0;
+    std::vector<double> encode_us;
+    std::vector<double> decode_us;
+    for (int i = 0; i < opt.iterations; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        const std::vector<uint8_t> binary = qr::encode(response);
+        const std::string text = qr::base45_encode(binary.data(), binary.size());
+        const auto mid = std::chrono::steady_clock::now();
+        std::vector<uint8_t> back;
+        qr::SigningRequest decoded;
+        qr::base45_decode(request_v2.text.data() + 18, request_v2.text.size() - 18, back);
+        qr::decode(back.data(), back.size(), decoded);
+        const auto end = std::chrono::steady_clock::now();
+        checksum += text.size() + decoded.payload.size();
+        encode_us.push_back(std::chrono::duration<double, std::micro>(mid - start).count());
+        decode_us.push_back(std::chrono::duration<double, std::micro>(end - mid).count());
+    }
+    std::sort(encode_us.begin(), encode_us.end());
+    std::sort(decode_us.begin(), decode_us.end());
+    const double encode_p50 = encode_us[encode_us.size() / 2];
+    const double decode_p50 = decode_us[decode_us.size() / 2];
+    report.add("response_encode_us", "us", bench::Better::Lower, encode_p50);
+    report.add("request_decode_us", "us", bench::Better::Lower, decode_p50);
+    std::printf("v2 response encode p50 %.2f us, request decode p50 %.2f us (%d iterations, checksum %zu)\n",
+                encode_p50, decode_p50, opt.iterations, checksum);
+
+    if (!opt.json_path.empty() && !bench::write_report(opt.json_path, report)) {
+        std::fprintf(stderr, "qr_codec_bench: cannot write %s\n", opt.json_path.c_str());
+        return 1;
+    }
+    return 0;
+}
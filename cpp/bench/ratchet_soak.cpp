@@ -0,0 +1,273 @@
+/**
+ * Long-running Double Ratchet soak test.
+ *
+ * Drives one ratchet pair through millions of messages with random
+ * direction changes, reordering, late delivery and permanent loss, and
+ * samples RSS, heap usage and throughput at fixed intervals. Fails when
+ * memory keeps growing after warm-up, late-window throughput falls
+ * behind the first post-warm-up window, or the run is too short to take
+ * at least four samples.
+ *
+ *   ratchet_soak --session keys.json [--messages 2000000] [--interval 50000]
+ *                [--loss-rate 0.001] [--late-rate 0.01] [--reorder-window 8]
+ *                [--max-growth-mb 32] [--tolerance 0.15] [--csv out.csv]
+ *                [--json out.json]
+ */
+
+#include "harness.h"
+#include "report.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <vector>
+
+using namespace estream;
+
+namespace {
+
+struct Options {
+    std::string session_path;
+    std::string csv_path;
+    std::string json_path;
+    uint64_t messages = 2000000;
+    uint64_t interval = 50000;
+    double loss_rate = 0.001;
+    double late_rate = 0.01;
+    size_t reorder_window = 8;
+    double max_growth_mb = 32;
+    double tolerance = 0.15;
+};
+
+struct Sample {
+    uint64_t messages;
+    uint64_t elapsed_ms;
+    uint64_t rss;
+    uint64_t heap;
+    double messages_per_sec;  // Over the interval ending here.
+    uint64_t failures;
+};
+
+struct Pending {
+    std::string json;
+    uint64_t due;  // Deliver once this many messages have been sent.
+};
+
+bool parse_args(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* v = argv[++i];
+        if (arg == "--session") o.session_path = v;
+        else if (arg == "--csv") o.csv_path = v;
+        else if (arg == "--json") o.json_path = v;
+        else if (arg == "--messages") o.messages = std::strtoull(v, nullptr, 10);
+        else if (arg == "--interval") o.interval = std::max<uint64_t>(1, std::strtoull(v, nullptr, 10));
+        else if (arg == "--loss-rate") o.loss_rate = std::atof(v);
+        else if (arg == "--late-rate") o.late_rate = std::atof(v);
+        else if (arg == "--reorder-window") o.reorder_window = std::max<size_t>(1, std::strtoul(v, nullptr, 10));
+        else if (arg == "--max-growth-mb") o.max_growth_mb = std::atof(v);
+        else if (arg == "--tolerance") o.tolerance = std::atof(v);
+        else return false;
+    }
+    return !o.session_path.empty();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::fprintf(stderr,
+                     "usage: ratchet_soak --session keys.json [--messages N] [--interval N]\n"
+                     "                    [--loss-rate p] [--late-rate p] [--reorder-window N]\n"
+                     "                    [--max-growth-mb MB] [--tolerance f] [--csv file]\n"
+                     "                    [--json file]\n");
+        return 2;
+    }
+
+    bench::SessionKeys keys;
+    bench::RatchetPair pair;
+    std::string error;
+    if (!bench::load_session(opt.session_path, keys, error) || !bench::open_pair(keys, pair, error)) {
+        std::fprintf(stderr, "ratchet_soak: %s\n", error.c_str());
+        return 2;
+    }
+
+    FILE* csv = opt.csv_path.empty() ? nullptr : std::fopen(opt.csv_path.c_str(), "w");
+    if (csv != nullptr) {
+        std::fprintf(csv, "messages,elapsed_ms,rss_bytes,heap_bytes,messages_per_sec,failures\n");
+    }
+    std::printf("%12s %10s %10s %10s %12s %8s\n", "messages", "elapsed_s", "rss_MB", "heap_MB",
+                "msgs/sec", "failed");
+
+    bench::Rng rng(0x50a4);
+    std::vector<uint8_t> payload;
+    // Messages in flight per direction: a reorder window plus late stragglers.
+    std::deque<Pending> window[2];
+    std::vector<Pending> late[2];
+    std::vector<Sample> samples;
+
+    uint64_t sent = 0;
+    uint64_t failures = 0;
+    uint64_t lost = 0;
+    int from = 0;
+    uint64_t run_left = 0;
+    const uint64_t start_ns = trace::now_ns();
+    uint64_t interval_start_ns = start_ns;
+
+    auto deliver = [&](int side, const Pending& p) {
+        if (!bench::decrypt(side == 0 ? pair.bob : pair.alice, p.json)) {
+            ++failures;
+        }
+    };
+    auto flush = [&](int side) {
+        while (!window[side].empty()) {
+            deliver(side, window[side].front());
+            window[side].pop_front();
+        }
+    };
+
+    while (sent < opt.messages) {
+        if (run_left == 0) {
+            // Direction change: the peer sees everything still in the
+            // window before it replies, as a real conversation would.
+            flush(from);
+            from = rng.next() % 4 == 0 ? from : 1 - from;
+            run_left = rng.range(1, 64);
+        }
+        --run_left;
+
+        const size_t len = rng.range(16, 280);
+        bench::fill_payload(payload, len, rng.next());
+        std::string json = bench::encrypt(from == 0 ? pair.alice : pair.bob, payload.data(), len);
+        ++sent;
+        if (json.empty()) {
+            ++failures;
+        } else {
+            const double roll = double(rng.next() % 1000000) / 1e6;
+            if (roll < opt.loss_rate) {
+                ++lost;  // Never delivered: its skipped key stays with the peer.
+            } else if (roll < opt.loss_rate + opt.late_rate) {
+                late[from].push_back(Pending{std::move(json), sent + rng.range(100, 5000)});
+            } else {
+                // Insert at a random position in the reorder window.
+                std::deque<Pending>& w = window[from];
+                w.insert(w.begin() + rng.next() % (w.size() + 1), Pending{std::move(json), 0});
+                if (w.size() >= opt.reorder_window) {
+                    deliver(from, w.front());
+                    w.pop_front();
+                }
+            }
+        }
+
+        for (int side = 0; side < 2; ++side) {
+            std::vector<Pending>& l = late[side];
+            for (size_t i = 0; i < l.size();) {
+                if (l[i].due <= sent) {
+                    deliver(side, l[i]);
+                    l[i] = std::move(l.back());
+                    l.pop_back();
+                } else {
+                    ++i;
+                }
+            }
+        }
+
+        if (sent % opt.interval == 0 || sent == opt.messages) {
+            const uint64_t now = trace::now_ns();
+            const uint64_t in_interval = sent % opt.interval ? sent % opt.interval : opt.interval;
+            Sample s{sent, (now - start_ns) / 1000000, bench::rss_bytes(), bench::heap_bytes(),
+                     now > interval_start_ns ? in_interval * 1e9 / double(now - interval_start_ns) : 0,
+                     failures};
+            interval_start_ns = now;
+            samples.push_back(s);
+            std::printf("%12llu %10.1f %10.1f %10.1f %12.0f %8llu\n",
+                        static_cast<unsigned long long>(s.messages), s.elapsed_ms / 1e3,
+                        s.rss / 1048576.0, s.heap / 1048576.0, s.messages_per_sec,
+                        static_cast<unsigned long long>(s.failures));
+            if (csv != nullptr) {
+                std::fprintf(csv, "%llu,%llu,%llu,%llu,%.0f,%llu\n",
+                             static_cast<unsigned long long>(s.messages),
+                             static_cast<unsigned long long>(s.elapsed_ms),
+                             static_cast<unsigned long long>(s.rss),
+                             static_cast<unsigned long long>(s.heap), s.messages_per_sec,
+                             static_cast<unsigned long long>(s.failures));
+            }
+        }
+    }
+    flush(0);
+    flush(1);
+    for (int side = 0; side < 2; ++side) {
+        for (const Pending& p : late[side]) {
+            deliver(side, p);
+        }
+    }
+    bench::close_pair(pair);
+    if (csv != nullptr) {
+        std::fclose(csv);
+    }
+
+    // Judge against the first post-warm-up sample (10% of the run), and
+    // compare the average of the last quarter of windows to avoid a single
+    // noisy interval deciding the outcome.
+    bool ok = failures == 0;
+    if (failures > 0) {
+        std::fprintf(stderr, "ratchet_soak: %llu encrypt/decrypt failures\n",
+                     static_cast<unsigned long long>(failures));
+    }
+    // Fewer points than this leave no post-warm-up window to judge.
+    constexpr size_t kMinSamples = 4;
+    if (samples.size() < kMinSamples) {
+        std::fprintf(stderr,
+                     "ratchet_soak: insufficient samples (%zu, need %zu): raise --messages or lower --interval\n",
+                     samples.size(), kMinSamples);
+        return 1;
+    }
+    const size_t warm = samples.size() / 10;
+    const Sample& ref = samples[warm];
+    const Sample& last = samples.back();
+    const double growth_mb =
+        (double(std::max(last.rss, ref.rss)) - double(ref.rss)) / 1048576.0;
+    const double heap_growth_mb =
+        (double(std::max(last.heap, ref.heap)) - double(ref.heap)) / 1048576.0;
+    double tail_rate = 0;
+    const size_t tail_from = samples.size() - std::max<size_t>(1, samples.size() / 4);
+    for (size_t i = tail_from; i < samples.size(); ++i) {
+        tail_rate += samples[i].messages_per_sec;
+    }
+    tail_rate /= double(samples.size() - tail_from);
+
+    std::printf("\nlost %llu, rss growth %.1f MB, heap growth %.1f MB, throughput %.0f -> %.0f msgs/sec\n",
+                static_cast<unsigned long long>(lost), growth_mb, heap_growth_mb,
+                ref.messages_per_sec, tail_rate);
+    if (std::max(growth_mb, heap_growth_mb) > opt.max_growth_mb) {
+        std::fprintf(stderr, "ratchet_soak: memory grew %.1f MB after warm-up (limit %.1f)\n",
+                     std::max(growth_mb, heap_growth_mb), opt.max_growth_mb);
+        ok = false;
+    }
+    if (!opt.json_path.empty()) {
+        bench::Report report = bench::new_report("ratchet_soak");
+        for (size_t i = warm; i < samples.size(); ++i) {
+            report.add("messages_per_sec", "msg/s", bench::Better::Higher,
+                       samples[i].messages_per_sec);
+        }
+        report.add("rss_growth_mb", "MB", bench::Better::Lower, growth_mb);
+        report.add("heap_growth_mb", "MB", bench::Better::Lower, heap_growth_mb);
+        if (!bench::write_report(opt.json_path, report)) {
+            std::fprintf(stderr, "ratchet_soak: cannot write %s\n", opt.json_path.c_str());
+            ok = false;
+        }
+    }
+    if (tail_rate < ref.messages_per_sec * (1.0 - opt.tolerance)) {
+        std::fprintf(stderr, "ratchet_soak: throughput degraded %.1f%% (tolerance %.0f%%)\n",
+                     (1.0 - tail_rate / ref.messages_per_sec) * 100, opt.tolerance * 100);
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
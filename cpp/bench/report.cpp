@@ -0,0 +1,341 @@
+#include "report.h"
+
+#include "json.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <unistd.h>
+
+namespace estream {
+namespace bench {
+
+namespace {
+
+// JSON has no NaN or infinity; such samples are written as null and
+// dropped when read back.
+void append_double(std::string& out, double v) {
+    if (!std::isfinite(v)) {
+        out += "null";
+        return;
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", v);
+    out += buf;
+}
+
+std::string cpu_model() {
+    std::ifstream in("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            const size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                return line.substr(line.find_first_not_of(' ', colon + 1));
+            }
+        }
+    }
+    return std::string();
+}
+
+// Just enough JSON to read reports back: objects, arrays, strings without
+// unicode escapes, numbers and literals.
+class Parser {
+public:
+    explicit Parser(const std::string& text) : s_(text) {}
+
+    bool ok() const { return error_.empty(); }
+    const std::string& error() const { return error_; }
+
+    void ws() {
+        while (p_ < s_.size() && std::isspace(static_cast<unsigned char>(s_[p_]))) ++p_;
+    }
+
+    bool peek(char c) {
+        ws();
+        return p_ < s_.size() && s_[p_] == c;
+    }
+
+    bool consume(char c) {
+        if (!peek(c)) {
+            return false;
+        }
+        ++p_;
+        return true;
+    }
+
+    bool expect(char c) {
+        if (!peek(c)) {
+            fail(std::string("expected '") + c + "'");
+            return false;
+        }
+        ++p_;
+        return true;
+    }
+
+    std::string string() {
+        std::string out;
+        if (!expect('"')) {
+            return out;
+        }
+        while (p_ < s_.size() && s_[p_] != '"') {
+            char c = s_[p_++];
+            if (c == '\\' && p_ < s_.size()) {
+                c = s_[p_++];
+                c = c == 'n' ? '\n' : c == 't' ? '\t' : c == 'r' ? '\r' : c;
+            }
+            out.push_back(c);
+        }
+        if (p_ >= s_.size()) {
+            fail("unterminated string");
+        }
+        ++p_;
+        return out;
+    }
+
+    /// Consume a null literal if one is next.
+    bool null() {
+        ws();
+        if (s_.compare(p_, 4, "null") != 0) {
+            return false;
+        }
+        p_ += 4;
+        return true;
+    }
+
+    double number() {
+        ws();
+        const char* start = s_.c_str() + p_;
+        char* end = nullptr;
+        const double v = std::strtod(start, &end);
+        if (end == start) {
+            fail("expected number");
+            return 0;
+        }
+        p_ += size_t(end - start);
+        return v;
+    }
+
+    /// Skip any value.
+    void skip() {
+        ws();
+        if (p_ >= s_.size()) {
+            fail("unexpected end");
+        } else if (s_[p_] == '"') {
+            string();
+        } else if (s_[p_] == '{' || s_[p_] == '[') {
+            const char close = s_[p_] == '{' ? '}' : ']';
+            ++p_;
+            if (consume(close)) {
+                return;
+            }
+            do {
+                if (close == '}') {
+                    string();
+                    expect(':');
+                }
+                skip();
+            } while (ok() && consume(','));
+            expect(close);
+        } else if (std::isalpha(static_cast<unsigned char>(s_[p_]))) {
+            while (p_ < s_.size() && std::isalpha(static_cast<unsigned char>(s_[p_]))) ++p_;
+        } else {
+            number();
+        }
+    }
+
+    /// Iterate an object's members: fn(key) must consume the value.
+    template <typename Fn>
+    void object(Fn&& fn) {
+        if (!expect('{')) {
+            return;
+        }
+        if (consume('}')) {
+            return;
+        }
+        do {
+            const std::string key = string();
+            if (!expect(':')) {
+                return;
+            }
+            fn(key);
+        } while (ok() && consume(','));
+        expect('}');
+    }
+
+    /// Iterate an array's elements: fn() must consume each value.
+    template <typename Fn>
+    void array(Fn&& fn) {
+        if (!expect('[')) {
+            return;
+        }
+        if (consume(']')) {
+            return;
+        }
+        do {
+            fn();
+        } while (ok() && consume(','));
+        expect(']');
+    }
+
+private:
+    void fail(const std::string& what) {
+        if (error_.empty()) {
+            error_ = what + " at offset " + std::to_string(p_);
+            p_ = s_.size();
+        }
+    }
+
+    const std::string& s_;
+    size_t p_ = 0;
+    std::string error_;
+};
+
+}  // namespace
+
+void Report::add(const std::string& name, const std::string& unit, Better better, double sample) {
+    for (Metric& m : metrics) {
+        if (m.name == name) {
+            m.samples.push_back(sample);
+            return;
+        }
+    }
+    metrics.push_back(Metric{name, unit, better, {sample}});
+}
+
+Machine current_machine() {
+    Machine m;
+    char host[256] = {};
+    if (gethostname(host, sizeof(host) - 1) == 0) {
+        m.hostname = host;
+    }
+    const char* id = std::getenv("ESTREAM_BENCH_MACHINE");
+    m.id = id != nullptr && *id ? id : m.hostname;
+    m.cpu = cpu_model();
+    m.cores = std::thread::hardware_concurrency();
+    return m;
+}
+
+Report new_report(const std::string& bench) {
+    Report r;
+    r.bench = bench;
+    r.machine = current_machine();
+    r.timestamp = int64_t(std::time(nullptr));
+    const char* label = std::getenv("ESTREAM_BENCH_LABEL");
+    r.label = label != nullptr ? label : "";
+    return r;
+}
+
+std::string to_json(const Report& report) {
+    std::string out = "{\"schema\":";
+    json::append_string(out, kReportSchema);
+    out += ",\"bench\":";
+    json::append_string(out, report.bench.c_str());
+    out += ",\"machine\":{\"id\":";
+    json::append_string(out, report.machine.id.c_str());
+    out += ",\"hostname\":";
+    json::append_string(out, report.machine.hostname.c_str());
+    out += ",\"cpu\":";
+    json::append_string(out, report.machine.cpu.c_str());
+    out += ",\"cores\":";
+    json::append_uint(out, report.machine.cores);
+    out += "},\"timestamp\":";
+    out += std::to_string(report.timestamp);
+    out += ",\"label\":";
+    json::append_string(out, report.label.c_str());
+    out += ",\"metrics\":[";
+    for (size_t i = 0; i < report.metrics.size(); ++i) {
+        const Metric& m = report.metrics[i];
+        out += i > 0 ? ",\n" : "\n";
+        out += "{\"name\":";
+        json::append_string(out, m.name.c_str());
+        out += ",\"unit\":";
+        json::append_string(out, m.unit.c_str());
+        out += ",\"better\":";
+        out += m.better == Better::Higher ? "\"higher\"" : "\"lower\"";
+        out += ",\"samples\":[";
+        for (size_t j = 0; j < m.samples.size(); ++j) {
+            if (j > 0) {
+                out.push_back(',');
+            }
+            append_double(out, m.samples[j]);
+        }
+        out += "]}";
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+bool write_report(const std::string& path, const Report& report) {
+    std::ofstream out(path);
+    out << to_json(report);
+    return bool(out);
+}
+
+bool read_report(const std::string& path, Report& out, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream buf;
+    buf << in.rdbuf();
+    const std::string text = buf.str();
+
+    Parser p(text);
+    std::string schema;
+    out = Report{};
+    p.object([&](const std::string& key) {
+        if (key == "schema") {
+            schema = p.string();
+        } else if (key == "bench") {
+            out.bench = p.string();
+        } else if (key == "label") {
+            out.label = p.string();
+        } else if (key == "timestamp") {
+            out.timestamp = int64_t(p.number());
+        } else if (key == "machine") {
+            p.object([&](const std::string& k) {
+                if (k == "id") out.machine.id = p.string();
+                else if (k == "hostname") out.machine.hostname = p.string();
+                else if (k == "cpu") out.machine.cpu = p.string();
+                else if (k == "cores") out.machine.cores = uint32_t(p.number());
+                else p.skip();
+            });
+        } else if (key == "metrics") {
+            p.array([&] {
+                Metric m;
+                p.object([&](const std::string& k) {
+                    if (k == "name") m.name = p.string();
+                    else if (k == "unit") m.unit = p.string();
+                    else if (k == "better") m.better = p.string() == "lower" ? Better::Lower : Better::Higher;
+                    else if (k == "samples") p.array([&] {
+                        if (!p.null()) m.samples.push_back(p.number());
+                    });
+                    else p.skip();
+                });
+                out.metrics.push_back(std::move(m));
+            });
+        } else {
+            p.skip();
+        }
+    });
+    if (!p.ok()) {
+        error = path + ": " + p.error();
+        return false;
+    }
+    if (schema != kReportSchema) {
+        error = path + ": schema \"" + schema + "\" is not " + kReportSchema;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace bench
+}  // namespace estream
@@ -0,0 +1,76 @@
+/**
+ * Common result schema for the host benchmarks.
+ *
+ * Every bench writes one JSON document ("schema": "estream-bench/1") with
+ * the machine it ran on and, per metric, its unit, which direction is
+ * better and the raw samples (one per run, interval or request), so runs
+ * can be compared statistically rather than by single numbers:
+ *
+ *   { "schema": "estream-bench/1", "bench": "decrypt_bench",
+ *     "machine": { "id", "hostname", "cpu", "cores" },
+ *     "timestamp": 1760000000, "label": "...",
+ *     "metrics": [ { "name", "unit", "better": "higher"|"lower",
+ *                    "samples": [ ... ] } ] }
+ */
+
+#ifndef ESTREAM_BENCH_REPORT_H
+#define ESTREAM_BENCH_REPORT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace estream {
+namespace bench {
+
+constexpr const char* kReportSchema = "estream-bench/1";
+
+enum class Better {
+    Higher,
+    Lower,
+};
+
+struct Metric {
+    std::string name;
+    std::string unit;
+    Better better = Better::Higher;
+    std::vector<double> samples;
+};
+
+struct Machine {
+    std::string id;
+    std::string hostname;
+    std::string cpu;
+    uint32_t cores = 0;
+};
+
+struct Report {
+    std::string bench;
+    Machine machine;
+    int64_t timestamp = 0;
+    std::string label;
+    std::vector<Metric> metrics;
+
+    /// Append a sample, creating the metric on first use.
+    void add(const std::string& name, const std::string& unit, Better better, double sample);
+};
+
+/// Describe this host. The id is $ESTREAM_BENCH_MACHINE if set, otherwise
+/// the host name.
+Machine current_machine();
+
+/// New report for `bench` on this host, stamped with the current time and
+/// $ESTREAM_BENCH_LABEL (e.g. a git revision) if set.
+Report new_report(const std::string& bench);
+
+std::string to_json(const Report& report);
+bool write_report(const std::string& path, const Report& report);
+
+/// Parse a report written by write_report(). False with `error` set on
+/// malformed input or a different schema.
+bool read_report(const std::string& path, Report& out, std::string& error);
+
+}  // namespace bench
+}  // namespace estream
+
+#endif /* ESTREAM_BENCH_REPORT_H */
@@ -0,0 +1,298 @@
+/**
+ * Spark particle detection throughput on full-resolution frames.
+ *
+ *   spark_bench [--frames frames.y --size 1920x1080 [--stride N]]
+ *               [--passes 5] [--threshold 170] [--json out.json]
+ *               [--detector full|pyramid]
+ *               [--fps 30 --target-ms 20]
+ *
+ * --frames is raw 8-bit luma, one frame after another, e.g. a recorded
+ * scan converted with
+ *
+ *   ffmpeg -i scan.mp4 -f rawvideo -pix_fmt gray frames.y
+ *
+ * Without it, 240 synthetic 1920x1080 frames are used: sensor noise plus
+ * eight particles orbiting the centre at the Spark pattern's radii.
+ * Reports the time per frame (detect plus center brightness) and frames
+ * per second per pass. --detector pyramid times the coarse-to-fine
+ * PyramidDetector instead of the full-frame Detector and also reports the
+ * fraction of each frame's pixels it read.
+ *
+ * With --fps, the frames are instead replayed at that camera rate through
+ * the threaded FramePipeline with --target-ms as its latency target.
+ * Reports the frames analyzed per second, the stale fraction, capture to
+ * result latency and the analysis scale the pipeline settled on.
+ */
+
+#include "report.h"
+#include "spark_detect.h"
+#include "spark_pipeline.h"
+#include "spark_pyramid.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace estream;
+
+namespace {
+
+struct Options {
+    std::string frames_path;
+    std::string json_path;
+    int width = 1920;
+    int height = 1080;
+    int stride = 0;
+    int passes = 5;
+    int threshold = spark::kBrightnessThreshold;
+    double fps = 0.0;
+    double target_ms = 20.0;
+    bool pyramid = false;
+};
+
+struct Frames {
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    size_t count = 0;
+    std::vector<uint8_t> data;
+
+    const uint8_t* frame(size_t i) const { return data.data() + i * static_cast<size_t>(stride) * height; }
+};
+
+bool parse_args(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* v = argv[++i];
+        if (arg == "--frames") o.frames_path = v;
+        else if (arg == "--json") o.json_path = v;
+        else if (arg == "--size" && std::sscanf(v, "%dx%d", &o.width, &o.height) == 2) continue;
+        else if (arg == "--stride") o.stride = std::atoi(v);
+        else if (arg == "--passes") o.passes = std::max(1, std::atoi(v));
+        else if (arg == "--threshold") o.threshold = std::atoi(v);
+        else if (arg == "--fps") o.fps = std::atof(v);
+        else if (arg == "--target-ms") o.target_ms = std::atof(v);
+        else if (arg == "--detector" && (std::string(v) == "full" || std::string(v) == "pyramid"))
+            o.pyramid = std::string(v) == "pyramid";
+        else return false;
+    }
+    return o.width > 0 && o.height > 0 && o.threshold > 0 && o.threshold < 256 && o.fps >= 0.0 &&
+           o.target_ms > 0.0;
+}
+
+bool load_frames(const Options& o, Frames& out) {
+    FILE* f = std::fopen(o.frames_path.c_str(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    out.width = o.width;
+    out.height = o.height;
+    out.stride = std::max(o.stride, o.width);
+    std::fseek(f, 0, SEEK_END);
+    const long size = std::ftell(f);
+    std::fseek(f, 0, SEEK_SET);
+    const size_t frame_bytes = static_cast<size_t>(out.stride) * out.height;
+    out.count = size > 0 ? static_cast<size_t>(size) / frame_bytes : 0;
+    out.data.resize(out.count * frame_bytes);
+    const bool ok = std::fread(out.data.data(), 1, out.data.size(), f) == out.data.size();
+    std::fclose(f);
+    return ok && out.count > 0;
+}
+
+// Noise and eight soft particles at radii 60..110 of a 300 px pattern,
+// scaled to the frame and turning a little each frame.
+void synthesize(const Options& o, Frames& out) {
+    out.width = o.width;
+    out.height = o.height;
+    out.stride = std::max(o.stride, o.width);
+    out.count = 240;
+    out.data.assign(out.count * static_cast<size_t>(out.stride) * out.height, 0);
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    const double scale = std::min(out.width, out.height) / 300.0;
+    const double cx = out.width / 2.0;
+    const double cy = out.height / 2.0;
+    for (size_t i = 0; i < out.count; ++i) {
+        uint8_t* frame = out.data.data() + i * static_cast<size_t>(out.stride) * out.height;
+        for (int y = 0; y < out.height; ++y) {
+            for (int x = 0; x < out.width; ++x) {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                frame[static_cast<size_t>(y) * out.stride + x] = static_cast<uint8_t>(30 + (state & 63));
+            }
+        }
+        for (int p = 0; p < 8; ++p) {
+            const double radius = (60.0 + 50.0 * p / 7.0) * scale;
+            const double angle = p * 0.785398 + i * 0.05 * (p % 2 == 0 ? 1.0 : -1.0);
+            const double px = cx + radius * std::cos(angle);
+            const double py = cy + radius * std::sin(angle);
+            const int r = std::max(2, static_cast<int>(3.0 * scale));
+            for (int dy = -r; dy <= r; ++dy) {
+                for (int dx = -r; dx <= r; ++dx) {
+                    const int x = static_cast<int>(px) + dx;
+                    const int y = static_cast<int>(py) + dy;
+                    if (x < 0 || y < 0 || x >= out.width || y >= out.height) {
+                        continue;
+                    }
+                    const double falloff = std::exp(-(dx * dx + dy * dy) / (0.5 * r * r));
+                    uint8_t& pixel = frame[static_cast<size_t>(y) * out.stride + x];
+                    pixel = static_cast<uint8_t>(std::max<double>(pixel, 255.0 * falloff));
+                }
+            }
+        }
+    }
+}
+
+// Integer or decimal field `name` of a pipeline status JSON.
+double field(const std::string& json, const char* name) {
+    const std::string key = std::string("\"") + name + "\":";
+    const size_t at = json.find(key);
+    return at == std::string::npos ? 0.0 : std::atof(json.c_str() + at + key.size());
+}
+
+// Replay the frames at opt.fps through a threaded pipeline, one pass per
+// --passes.
+int run_pipeline(const Options& opt, const Frames& frames) {
+    spark::Options options;
+    options.threshold = static_cast<uint8_t>(opt.threshold);
+    spark::PipelineConfig config;
+    config.latency_target_ms = opt.target_ms;
+    spark::FramePipeline pipeline(options, config);
+    spark::Plane plane;
+    plane.width = frames.width;
+    plane.height = frames.height;
+    plane.row_stride = frames.stride;
+
+    bench::Report report = bench::new_report("spark_bench");
+    const auto interval = std::chrono::duration<double>(1.0 / opt.fps);
+    std::string status;
+    for (int pass = 0; pass < opt.passes; ++pass) {
+        pipeline.reset();
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < frames.count; ++i) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                      interval * static_cast<double>(i)));
+            plane.data = frames.frame(i);
+            pipeline.submit(plane, i * 1000.0 / opt.fps);
+        }
+        std::this_thread::sleep_for(interval);
+        status = pipeline.status(false);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const double analyzed = field(status, "frames");
+        report.add("analyzed_per_sec", "frames/s", bench::Better::Higher, analyzed / seconds);
+        report.add("stale_fraction", "ratio", bench::Better::Lower, field(status, "frames_stale") / frames.count);
+        report.add("latency_ms", "ms", bench::Better::Lower, field(status, "latency_ms"));
+        report.add("scale", "factor", bench::Better::Lower, field(status, "scale"));
+        std::printf("pass %d: %.0f of %zu frames analyzed (%.1f/s), %.0f stale, latency %.2f ms, detect %.2f ms "
+                    "at 1/%.0f\n",
+                    pass, analyzed, frames.count, analyzed / seconds, field(status, "frames_stale"),
+                    field(status, "latency_ms"), field(status, "detect_ms"), field(status, "scale"));
+    }
+    if (!opt.json_path.empty() && !bench::write_report(opt.json_path, report)) {
+        std::fprintf(stderr, "spark_bench: cannot write %s\n", opt.json_path.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+double percentile(std::vector<double> values, double q) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(q * values.size()))];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::fprintf(stderr,
+                     "usage: spark_bench [--frames frames.y --size WxH [--stride N]] [--passes N]\n"
+                     "                   [--threshold T] [--json file] [--fps F [--target-ms T]]\n"
+                     "                   [--detector full|pyramid]\n");
+        return 2;
+    }
+
+    Frames frames;
+    if (!opt.frames_path.empty()) {
+        if (!load_frames(opt, frames)) {
+            std::fprintf(stderr, "spark_bench: cannot read %dx%d frames from %s\n", opt.width, opt.height,
+                         opt.frames_path.c_str());
+            return 2;
+        }
+    } else {
+        synthesize(opt, frames);
+    }
+    if (opt.fps > 0.0) {
+        return run_pipeline(opt, frames);
+    }
+
+    spark::Options options;
+    options.threshold = static_cast<uint8_t>(opt.threshold);
+    spark::Detector detector(options);
+    spark::PyramidDetector pyramid(options);
+    spark::Particle found[spark::kMaxParticles];
+    spark::Plane plane;
+    plane.width = frames.width;
+    plane.height = frames.height;
+    plane.row_stride = frames.stride;
+
+    bench::Report report = bench::new_report("spark_bench");
+    std::vector<double> frame_ms;
+    uint64_t particles = 0;
+    uint64_t pixels_read = 0;
+    float brightness = 0.0f;
+    // One untimed pass warms the caches and the detector's buffers.
+    for (int pass = -1; pass < opt.passes; ++pass) {
+        const auto pass_start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < frames.count; ++i) {
+            plane.data = frames.frame(i);
+            const auto start = std::chrono::steady_clock::now();
+            const size_t n = opt.pyramid ? pyramid.detect(plane, found, spark::kMaxParticles)
+                                         : detector.detect(plane, found, spark::kMaxParticles);
+            brightness += spark::center_brightness(plane);
+            const auto end = std::chrono::steady_clock::now();
+            if (pass >= 0) {
+                const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+                frame_ms.push_back(ms);
+                report.add("frame_ms", "ms", bench::Better::Lower, ms);
+                particles += n;
+                pixels_read += opt.pyramid ? pyramid.last_pixels()
+                                           : static_cast<uint64_t>(frames.width) * frames.height;
+            }
+        }
+        if (pass >= 0) {
+            const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - pass_start).count();
+            report.add("frames_per_sec", "frames/s", bench::Better::Higher, frames.count / s);
+        }
+    }
+
+    const double megapixels = frames.width * static_cast<double>(frames.height) / 1e6;
+    const double p50 = percentile(frame_ms, 0.50);
+    const double read_fraction =
+        frame_ms.empty() ? 0.0 : pixels_read / (frame_ms.size() * megapixels * 1e6);
+    report.add("pixels_read_fraction", "ratio", bench::Better::Lower, read_fraction);
+    std::printf("%zu frames %dx%d, %d passes, %s detector\n", frames.count, frames.width, frames.height, opt.passes,
+                opt.pyramid ? "pyramid" : "full");
+    std::printf("frame ms: p50 %.3f  p99 %.3f  max %.3f  (%.0f Mpx/s at p50)\n", p50, percentile(frame_ms, 0.99),
+                percentile(frame_ms, 1.0), p50 > 0.0 ? megapixels / (p50 / 1000.0) : 0.0);
+    std::printf("particles per frame: %.2f  (center brightness checksum %.1f)\n",
+                frame_ms.empty() ? 0.0 : static_cast<double>(particles) / frame_ms.size(), brightness);
+    std::printf("pixels read per frame: %.1f%%\n", 100.0 * read_fraction);
+
+    if (!opt.json_path.empty() && !bench::write_report(opt.json_path, report)) {
+        std::fprintf(stderr, "spark_bench: cannot write %s\n", opt.json_path.c_str());
+        return 1;
+    }
+    return 0;
+}
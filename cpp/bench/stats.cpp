@@ -0,0 +1,114 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace estream {
+namespace bench {
+
+namespace {
+
+uint64_t xorshift(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// Median of a resample of `values` drawn with replacement.
+double resampled_median(const std::vector<double>& values, std::vector<double>& scratch,
+                        uint64_t& state) {
+    scratch.resize(values.size());
+    for (double& v : scratch) {
+        v = values[xorshift(state) % values.size()];
+    }
+    const size_t mid = scratch.size() / 2;
+    std::nth_element(scratch.begin(), scratch.begin() + mid, scratch.end());
+    if (scratch.size() % 2 == 1) {
+        return scratch[mid];
+    }
+    const double upper = scratch[mid];
+    return (*std::max_element(scratch.begin(), scratch.begin() + mid) + upper) / 2;
+}
+
+}  // namespace
+
+double median(std::vector<double> values) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    const size_t mid = values.size() / 2;
+    return values.size() % 2 == 1 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+double mann_whitney_p(const std::vector<double>& a, const std::vector<double>& b) {
+    const size_t n1 = a.size();
+    const size_t n2 = b.size();
+    if (n1 == 0 || n2 == 0) {
+        return 1.0;
+    }
+    std::vector<std::pair<double, int>> all;
+    all.reserve(n1 + n2);
+    for (double v : a) all.emplace_back(v, 0);
+    for (double v : b) all.emplace_back(v, 1);
+    std::sort(all.begin(), all.end());
+
+    // Average ranks over ties; accumulate the tie correction term.
+    const double n = double(n1 + n2);
+    double rank_sum_a = 0;
+    double tie_term = 0;
+    for (size_t i = 0; i < all.size();) {
+        size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first) ++j;
+        const double avg_rank = (double(i + 1) + double(j)) / 2;
+        const double t = double(j - i);
+        tie_term += t * t * t - t;
+        for (size_t k = i; k < j; ++k) {
+            if (all[k].second == 0) {
+                rank_sum_a += avg_rank;
+            }
+        }
+        i = j;
+    }
+
+    const double u = rank_sum_a - double(n1) * double(n1 + 1) / 2;
+    const double mean = double(n1) * double(n2) / 2;
+    const double variance = double(n1) * double(n2) / 12 * ((n + 1) - tie_term / (n * (n - 1)));
+    if (variance <= 0) {
+        return 1.0;  // Every value identical.
+    }
+    const double z = std::max(0.0, std::fabs(u - mean) - 0.5) / std::sqrt(variance);
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+Interval bootstrap_median_ratio(const std::vector<double>& baseline,
+                                const std::vector<double>& current,
+                                double confidence, int resamples, uint64_t seed) {
+    if (baseline.empty() || current.empty() || resamples <= 0) {
+        return Interval{0, 0};
+    }
+    uint64_t state = seed ? seed : 1;
+    std::vector<double> ratios;
+    ratios.reserve(size_t(resamples));
+    std::vector<double> scratch;
+    for (int i = 0; i < resamples; ++i) {
+        const double base = resampled_median(baseline, scratch, state);
+        const double cur = resampled_median(current, scratch, state);
+        if (base != 0) {
+            ratios.push_back(cur / base);
+        }
+    }
+    if (ratios.empty()) {
+        return Interval{0, 0};
+    }
+    std::sort(ratios.begin(), ratios.end());
+    const double tail = (1 - confidence) / 2;
+    const size_t lo = size_t(tail * double(ratios.size() - 1));
+    const size_t hi = size_t((1 - tail) * double(ratios.size() - 1) + 0.5);
+    return Interval{ratios[lo], ratios[std::min(hi, ratios.size() - 1)]};
+}
+
+}  // namespace bench
+}  // namespace estream
@@ -0,0 +1,33 @@
+/**
+ * Statistics for comparing benchmark runs.
+ */
+
+#ifndef ESTREAM_BENCH_STATS_H
+#define ESTREAM_BENCH_STATS_H
+
+#include <cstdint>
+#include <vector>
+
+namespace estream {
+namespace bench {
+
+double median(std::vector<double> values);
+
+/// Two-sided p-value of the Mann-Whitney U test (normal approximation
+/// with tie and continuity correction). 1.0 if either side is empty.
+double mann_whitney_p(const std::vector<double>& a, const std::vector<double>& b);
+
+struct Interval {
+    double lo;
+    double hi;
+};
+
+/// Bootstrap confidence interval of median(current) / median(baseline).
+Interval bootstrap_median_ratio(const std::vector<double>& baseline,
+                                const std::vector<double>& current,
+                                double confidence, int resamples, uint64_t seed);
+
+}  // namespace bench
+}  // namespace estream
+
+#endif /* ESTREAM_BENCH_STATS_H */
@@ -0,0 +1,1174 @@
+/**
+ * eStream App Native Layer - C API
+ *
+ * Native helpers that live in this repository and sit next to the
+ * estream-mobile-core library (see estream_native.h). Callable from Swift
+ * through the bridging header and from Kotlin/Java through JNI.
+ *
+ * Memory Management:
+ * - Strings returned by this header are NOT owned by the Rust core;
+ *   release them with estream_app_free_string(), never estream_free_string()
+ */
+
+#ifndef ESTREAM_APP_NATIVE_H
+#define ESTREAM_APP_NATIVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// Memory Management
+// ============================================================================
+
+/**
+ * Free a string allocated by this header's functions.
+ * @param s String pointer returned by estream_app_* functions. Can be NULL.
+ */
+void estream_app_free_string(char* s);
+
+// ============================================================================
+// Startup Tracing
+// ============================================================================
+
+/**
+ * Open a trace span on the calling thread.
+ * Events go into a fixed-size in-memory buffer; once it is full further
+ * events are counted as dropped.
+ *
+ * @param name Span name (copied, truncated to 39 bytes)
+ */
+void estream_trace_begin(const char* name);
+
+/**
+ * Close the most recent span with the same name on the calling thread.
+ *
+ * @param name Span name passed to estream_trace_begin
+ */
+void estream_trace_end(const char* name);
+
+/**
+ * Record a point-in-time marker.
+ *
+ * @param name Marker name (copied, truncated to 39 bytes)
+ */
+void estream_trace_instant(const char* name);
+
+/**
+ * Record a whole span that ends now, as one complete event on the calling
+ * thread. Use it for spans timed by the caller, e.g. in JS, where the
+ * begin and end calls would arrive on different bridge threads.
+ *
+ * @param name Span name (copied, truncated to 39 bytes)
+ * @param duration_ns Span length; clamped to the time since library load
+ */
+void estream_trace_complete(const char* name, uint64_t duration_ns);
+
+/**
+ * Write the buffered events as a Chrome trace (JSON object format).
+ * The file opens directly in ui.perfetto.dev or chrome://tracing.
+ *
+ * @param path Destination file path (overwritten)
+ * @return Number of events written, or -1 if the file could not be written
+ */
+long estream_trace_dump(const char* path);
+
+// ============================================================================
+// Launch Pre-warming
+// ============================================================================
+
+/**
+ * Pre-warm configuration. All strings are copied by estream_prewarm().
+ */
+typedef struct {
+    /** Node address "host:port" to resolve and pre-connect, or NULL to skip */
+    const char* node_addr;
+    /** HTTP/3 server "ip:port" for estream_h3_connect, or NULL to skip */
+    const char* h3_addr;
+    /** Time budget; steps that would start after it are skipped */
+    uint32_t budget_ms;
+    /** Non-zero to run the ML-KEM/ML-DSA code paths once */
+    int warm_crypto;
+} EstreamPrewarmConfig;
+
+/**
+ * Start pre-warming on a background thread: resolve the node, create the
+ * runtime and connect, open the HTTP/3 connection, and exercise the PQ
+ * crypto paths. Returns immediately. Only the first call per process runs.
+ *
+ * A step already in progress when the budget runs out is not interrupted;
+ * the budget only gates starting the next step.
+ *
+ * @param config Pre-warm configuration
+ * @return 0 if started, -1 if already started or config is NULL
+ */
+int estream_prewarm(const EstreamPrewarmConfig* config);
+
+/**
+ * Take ownership of the runtime handle created by estream_prewarm().
+ * Waits up to timeout_ms for pre-warming to finish. The caller then owns
+ * the handle and must estream_dispose() it as usual.
+ *
+ * @param timeout_ms Maximum time to wait for the pre-warm thread
+ * @return Handle (>= 0), or -1 if none is available in time or the
+ *         pre-warm connect failed (that runtime is disposed)
+ */
+long estream_prewarm_take_handle(uint32_t timeout_ms);
+
+/**
+ * Check whether a handle from estream_prewarm_take_handle() is already
+ * connected to node_addr, so estream_connect() can be skipped.
+ *
+ * @param handle Handle returned by estream_prewarm_take_handle
+ * @param node_addr Node address the caller wants to connect to
+ * @return 1 if already connected, 0 otherwise
+ */
+int estream_prewarm_is_connected(long handle, const char* node_addr);
+
+/**
+ * Per-step timings of the pre-warm run.
+ *
+ * @return JSON string: { "success": true, "data": { "steps": [...] } }
+ *         Caller must free with estream_app_free_string()
+ */
+char* estream_prewarm_report(void);
+
+// ============================================================================
+// Span Callbacks
+// ============================================================================
+
+typedef enum {
+    ESTREAM_SPAN_BEGIN = 0,
+    ESTREAM_SPAN_END = 1
+} EstreamSpanPhase;
+
+/**
+ * A span boundary. Span names are static strings:
+ * "initialize", "connect" (includes the QUIC handshake), "handshake"
+ * (HTTP/3 connect), "h3_request", "keygen", "prekey_bundle",
+ * "x3dh_initiate", "x3dh_accept", "kem_encaps" (ratchet init sender),
+ * "kem_decaps" (ratchet init receiver), "ratchet_encrypt",
+ * "ratchet_decrypt", "ratchet_dispose", "dispose", "h3_disconnect",
+ * "h3_is_connected", "version".
+ */
+typedef struct {
+    /** Unique per process, never 0 */
+    uint64_t span_id;
+    /** Enclosing span on the same thread, 0 if none */
+    uint64_t parent_id;
+    /** Static string, valid for the life of the process */
+    const char* name;
+    /** Monotonic clock, nanoseconds */
+    uint64_t ts_ns;
+    /** OS thread id */
+    uint32_t thread_id;
+    EstreamSpanPhase phase;
+    /** END only: non-zero if the call failed: a NULL result, a JSON result
+     *  with "error" or "success":false, or a negative handle */
+    int failed;
+} EstreamSpanEvent;
+
+/**
+ * Span callback. Called synchronously on the thread making the FFI call,
+ * so it must be fast and must not call back into estream.
+ */
+typedef void (*EstreamTraceCallback)(void* ctx, const EstreamSpanEvent* event);
+
+/**
+ * Install (or with fn = NULL, remove) the span callback.
+ * Spans are emitted by the estream_app_* entry points below. With no
+ * callback installed each span costs one atomic load and a branch.
+ *
+ * Calls already in flight on other threads may still invoke the previous
+ * callback briefly after this returns; keep ctx valid accordingly.
+ *
+ * @param fn Callback, or NULL to disable
+ * @param ctx Opaque pointer passed back to fn
+ */
+void estream_set_trace_callback(EstreamTraceCallback fn, void* ctx);
+
+// ============================================================================
+// Trace File Writer
+// ============================================================================
+
+typedef enum {
+    /** Chrome JSON object format (chrome://tracing, ui.perfetto.dev) */
+    ESTREAM_TRACE_FORMAT_CHROME_JSON = 0,
+    /** Perfetto protobuf (perfetto.protos.Trace, ui.perfetto.dev) */
+    ESTREAM_TRACE_FORMAT_PERFETTO = 1
+} EstreamTraceFormat;
+
+/**
+ * Start writing span events to a trace file.
+ * Each thread records into its own lock-free ring buffer; a background
+ * thread drains the rings every 50 ms and streams them to the file.
+ * Works alongside an installed estream_set_trace_callback().
+ *
+ * @param path Destination file path (overwritten)
+ * @param format Output format
+ * @return 0 on success, -1 if a session is already active or the file
+ *         cannot be created
+ */
+int estream_trace_start(const char* path, EstreamTraceFormat format);
+
+/**
+ * Stop the active trace session, flush remaining events and close the file.
+ *
+ * @return Number of events written, or -1 if no session was active or the
+ *         file could not be written completely
+ */
+long estream_trace_stop(void);
+
+// ============================================================================
+// Instrumented Core Entry Points
+// ============================================================================
+//
+// Drop-in replacements for the estream_native.h functions of the same name
+// without the "app_" infix. Same arguments, return values and ownership:
+// returned strings still come from the Rust core and are released with
+// estream_free_string(). Platform modules call these so that spans (and
+// the other instrumentation in this layer) see every call.
+
+long estream_app_initialize(void);
+char* estream_app_connect(long handle, const char* node_addr);
+void estream_app_dispose(long handle);
+
+char* estream_app_generate_device_keys(const char* app_scope);
+char* estream_app_generate_prekey_bundle(const char* device_id, int num_one_time_keys);
+
+char* estream_app_x3dh_initiate(
+    const uint8_t* our_identity_public,
+    size_t our_identity_len,
+    const char* their_bundle_json
+);
+char* estream_app_x3dh_accept(
+    const uint8_t* our_identity_public,
+    size_t our_identity_len,
+    const uint8_t* spk_secret,
+    size_t spk_secret_len,
+    const uint8_t* opk_secret,
+    size_t opk_secret_len,
+    const char* initial_msg_json
+);
+
+char* estream_app_ratchet_init_sender(
+    const uint8_t* shared_secret,
+    const uint8_t* their_kem_public,
+    size_t their_kem_len
+);
+char* estream_app_ratchet_init_receiver(
+    const uint8_t* shared_secret,
+    const uint8_t* our_kem_secret,
+    size_t our_kem_secret_len,
+    const uint8_t* our_kem_public,
+    size_t our_kem_public_len,
+    const uint8_t* initial_ciphertext,
+    size_t initial_ct_len,
+    const uint8_t* their_kem_public,
+    size_t their_kem_len
+);
+char* estream_app_ratchet_encrypt(long handle, const uint8_t* plaintext, size_t plaintext_len);
+char* estream_app_ratchet_decrypt(long handle, const char* message_json);
+void estream_app_ratchet_dispose(long handle);
+
+char* estream_app_h3_connect(const char* server_addr);
+char* estream_app_h3_post(const char* path, const char* body);
+char* estream_app_h3_get(const char* path);
+char* estream_app_h3_mint_identity_nft(const char* owner, const char* trust_level);
+int estream_app_h3_is_connected(void);
+void estream_app_h3_disconnect(void);
+
+char* estream_app_version(void);
+
+// ============================================================================
+// Latency Histograms
+// ============================================================================
+
+/**
+ * Entry points with a latency histogram, one per estream_native.h function
+ * (the estream_free_* functions are not instrumented).
+ */
+typedef enum {
+    ESTREAM_FN_INITIALIZE = 0,
+    ESTREAM_FN_CONNECT,
+    ESTREAM_FN_DISPOSE,
+    ESTREAM_FN_GENERATE_DEVICE_KEYS,
+    ESTREAM_FN_GENERATE_PREKEY_BUNDLE,
+    ESTREAM_FN_X3DH_INITIATE,
+    ESTREAM_FN_X3DH_ACCEPT,
+    ESTREAM_FN_RATCHET_INIT_SENDER,
+    ESTREAM_FN_RATCHET_INIT_RECEIVER,
+    ESTREAM_FN_RATCHET_ENCRYPT,
+    ESTREAM_FN_RATCHET_DECRYPT,
+    ESTREAM_FN_RATCHET_DISPOSE,
+    ESTREAM_FN_H3_CONNECT,
+    ESTREAM_FN_H3_POST,
+    ESTREAM_FN_H3_GET,
+    ESTREAM_FN_H3_MINT_IDENTITY_NFT,
+    ESTREAM_FN_H3_IS_CONNECTED,
+    ESTREAM_FN_H3_DISCONNECT,
+    ESTREAM_FN_VERSION,
+    ESTREAM_FN_COUNT
+} EstreamFnId;
+
+/**
+ * Latency summary for one entry point. Percentiles are accurate to 1.6%.
+ */
+typedef struct {
+    uint64_t count;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint64_t mean_ns;
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+} EstreamLatencySnapshot;
+
+/**
+ * Snapshot the latency histogram of one entry point.
+ * Every estream_app_* call records into a histogram owned by the calling
+ * thread; this merges all threads' histograms (including exited threads).
+ *
+ * @param out Destination snapshot
+ * @param fn_id EstreamFnId value
+ * @return 0 on success, -1 if out is NULL or fn_id is out of range
+ */
+int estream_latency_snapshot(EstreamLatencySnapshot* out, int fn_id);
+
+/**
+ * Name of an entry point, e.g. "estream_ratchet_encrypt".
+ *
+ * @param fn_id EstreamFnId value
+ * @return Static string, or NULL if fn_id is out of range
+ */
+const char* estream_fn_name(int fn_id);
+
+/**
+ * Reset all latency histograms.
+ */
+void estream_latency_reset(void);
+
+/**
+ * Latency summary of every entry point called at least once.
+ *
+ * @return JSON string: { "success": true, "data": { "estream_ratchet_encrypt":
+ *         { "count", "min_us", "mean_us", "p50_us", "p90_us", "p99_us",
+ *           "p999_us", "max_us" }, ... } }
+ *         Caller must free with estream_app_free_string()
+ */
+char* estream_latency_report(void);
+
+// ============================================================================
+// Runtime Profiling
+// ============================================================================
+
+/**
+ * Enable or disable contention profiling (off by default).
+ * While enabled, this layer's internal locks and the turn on the core's
+ * HTTP/3 connection ("h3_connection") record acquisitions and wait times,
+ * and every estream_app_* call updates the FFI concurrency gauges. Waits on
+ * the core's handle tables happen inside Rust and are not reported.
+ * Disabled, each hook costs one relaxed load and a branch.
+ *
+ * @param enabled Non-zero to enable
+ */
+void estream_runtime_profiling(int enabled);
+
+/**
+ * Lock contention, FFI concurrency and Tokio worker thread statistics.
+ * Worker busy ratios compare against the previous call of this function.
+ *
+ * @return JSON string: { "success": true, "data": {
+ *           "profiling": bool,
+ *           "locks": [ { "name", "acquisitions", "contended", "wait_total_us",
+ *                        "wait_p50_us", "wait_p99_us", "wait_max_us" } ],
+ *           "ffi": { "calls", "in_flight", "max_in_flight",
+ *                    "overlapped_calls", "busy_us" },
+ *           "workers": [ { "tid", "name", "cpu_us", "voluntary_switches",
+ *                          "involuntary_switches", "busy_permille"? } ],
+ *           "threads": n } }
+ *         Context switch counts are 0 on iOS.
+ *         Caller must free with estream_app_free_string()
+ */
+char* estream_runtime_stats(void);
+
+/**
+ * Zero the lock and FFI counters.
+ */
+void estream_runtime_stats_reset(void);
+
+// ============================================================================
+// Resource Accounting
+// ============================================================================
+
+typedef enum {
+    /** Key generation, X3DH and Double Ratchet calls */
+    ESTREAM_SUBSYSTEM_CRYPTO = 0,
+    /** Runtime lifecycle and QUIC connect */
+    ESTREAM_SUBSYSTEM_TRANSPORT,
+    /** HTTP/3 calls */
+    ESTREAM_SUBSYSTEM_H3,
+    ESTREAM_SUBSYSTEM_COUNT
+} EstreamSubsystem;
+
+/**
+ * Enable or disable per-subsystem CPU accounting (off by default).
+ * While enabled every estream_app_* call charges the calling thread's CPU
+ * time and wakeups (voluntary context switches; Linux/Android only) to
+ * its subsystem. Costs two system calls per call boundary while enabled.
+ *
+ * @param enabled Non-zero to enable
+ */
+void estream_resource_accounting(int enabled);
+
+/**
+ * Charge the calling thread's work to a subsystem until the matching
+ * estream_resource_end(). Scopes nest; time is charged to the innermost
+ * one only, including around nested estream_app_* calls.
+ *
+ * @param subsystem EstreamSubsystem value
+ */
+void estream_resource_begin(int subsystem);
+
+/**
+ * Close the innermost scope opened by estream_resource_begin().
+ */
+void estream_resource_end(void);
+
+/**
+ * CPU time and wakeups per subsystem, plus the core's worker threads and
+ * the whole process for comparison.
+ *
+ * @return JSON string: { "success": true, "data": {
+ *           "accounting": bool,
+ *           "subsystems": { "crypto": { "cpu_us", "wakeups", "scopes" },
+ *                           "transport", "h3" },
+ *           "runtime_workers": { "cpu_us", "wakeups", "threads" },
+ *           "process": { "cpu_us", "wakeups" } } }
+ *         Caller must free with estream_app_free_string()
+ */
+char* estream_resource_usage(void);
+
+/**
+ * Zero the per-subsystem totals (worker and process totals are cumulative).
+ */
+void estream_resource_reset(void);
+
+// ============================================================================
+// ETFA Timing Kernels
+// ============================================================================
+
+/**
+ * Progress callback for the ETFA collectors, called after each kernel: on
+ * the calling thread for estream_etfa_collect(), on a measuring thread for
+ * estream_etfa_collect_parallel().
+ *
+ * @param ctx Opaque pointer given to estream_etfa_collect()
+ * @param label Kernel label ("Memory Sequential"), valid during the call
+ * @param progress Fraction of kernels done, (0, 1]
+ */
+typedef void (*EstreamEtfaProgressCallback)(void* ctx, const char* label, float progress);
+
+/**
+ * Time the CPU kernels of an ETFA fingerprint (memory hierarchy, integer,
+ * float, vector and matrix mixes) and compute its CPU ratios. Every kernel
+ * runs once untimed, then `sample_count` times on the hardware counter;
+ * the median is kept. Blocks for the whole collection, so call it off the
+ * main thread. GPU kernels are left to the caller.
+ *
+ * @param sample_count Timed runs per kernel (>= 1)
+ * @param progress Callback, or NULL
+ * @param ctx Opaque pointer passed back to progress
+ * @return JSON string: { "success": true, "data": {
+ *           "sample_count", "timer": "cntvct" | "tsc" | "monotonic_raw",
+ *           "timer_resolution_ns", "duration_us",
+ *           "kernels_ns": { "mem_seq_1m": median, ... },
+ *           "ratios": { "r5_mem_seq_to_rand": ..., ...,
+ *                       "r25_int_to_bitwise": ... } } },
+ *         or NULL if sample_count < 1.
+ *         Caller must free with estream_app_free_string()
+ */
+char* estream_etfa_collect(int sample_count, EstreamEtfaProgressCallback progress, void* ctx);
+
+/**
+ * estream_etfa_collect() on every CPU cluster at once (big.LITTLE tiers on
+ * Android, performance levels on Apple). Each cluster gets its own measuring
+ * threads, pinned to distinct CPUs of the cluster where the OS allows it
+ * (steered by QoS class on Apple), which share out the kernels; kernels
+ * whose working set exceeds the private caches run alone in their cluster.
+ * Samples are tagged with their cluster, and samples that migrated off it
+ * are left out of the medians.
+ *
+ * @param sample_count Timed runs per kernel and cluster (>= 1)
+ * @param threads_per_cluster Measuring threads per cluster, 0 for the default (2)
+ * @param progress Callback, or NULL. Called from the measuring threads,
+ *                 never concurrently
+ * @param ctx Opaque pointer passed back to progress
+ * @return JSON string: as estream_etfa_collect(), with "kernels_ns" and
+ *         "ratios" of the fastest cluster, plus "clusters": [{ "id",
+ *         "cpus", "cpu_count", "max_freq_khz", "threads", "pinned",
+ *         "samples", "migrated_samples", "kernels_ns", "ratios" }]
+ *         (fastest first), or NULL if sample_count < 1.
+ *         Caller must free with estream_app_free_string()
+ */
+char* estream_etfa_collect_parallel(int sample_count, int threads_per_cluster,
+                                    EstreamEtfaProgressCallback progress, void* ctx);
+
+// ============================================================================
+// ETFA Similarity Index
+// ============================================================================
+
+/**
+ * Compact, noise-tolerant form of a stable ratio vector: 16 bytes, each
+ * the ratio's log2 in 1/16-octave steps, as 32 hex digits (unmeasured
+ * ratios - 0 or not finite - as "00"). A ratio that drifts by a few percent
+ * changes one byte by one step, where a hash would change entirely.
+ *
+ * @param ratios stableRatios (r5..r29), up to 16 used
+ * @param count Number of ratios
+ * @return Hex string, or NULL on invalid arguments.
+ *         Caller must free with estream_app_free_string()
+ */
+char* estream_etfa_fingerprint_code(const double* ratios, int count);
+
+/**
+ * Create an empty index of reference fingerprints.
+ *
+ * @return Index handle
+ */
+long estream_etfa_index_create(void);
+
+/**
+ * Load an index written by estream_etfa_index_save().
+ *
+ * @param path Snapshot file
+ * @return Index handle, or -1 if the file is missing or malformed
+ */
+long estream_etfa_index_load(const char* path);
+
+/**
+ * Write the index (codes, ids and trained cells) to `path`, replacing it
+ * atomically.
+ *
+ * @return 0 on success, -1 on error
+ */
+int estream_etfa_index_save(long index, const char* path);
+
+/**
+ * Release an index.
+ */
+void estream_etfa_index_destroy(long index);
+
+/**
+ * Add a reference fingerprint, or replace the one with the same id.
+ *
+ * @param index Index handle
+ * @param id Reference id (e.g. the device id it was recorded for)
+ * @param ratios stableRatios (r5..r29)
+ * @param count Number of ratios
+ * @return 0 on success, -1 on invalid arguments
+ */
+int estream_etfa_index_add(long index, const char* id, const double* ratios, int count);
+
+/**
+ * Remove a reference.
+ *
+ * @return 0 on success, -1 if absent
+ */
+int estream_etfa_index_remove(long index, const char* id);
+
+/**
+ * Number of stored references.
+ *
+ * @return Reference count, -1 on invalid handle
+ */
+int estream_etfa_index_size(long index);
+
+/**
+ * Partition the references into k-means cells for approximate search.
+ * Until then (or with lists = 1) every search is exact. References added
+ * later join their nearest cell; retrain after the set has grown.
+ *
+ * @param index Index handle
+ * @param lists Cells; 0 picks sqrt(size) from 1024 references up, exact below
+ * @param iterations k-means rounds, 0 for the default (10)
+ * @return 0 on success, -1 on invalid arguments
+ */
+int estream_etfa_index_train(long index, int lists, int iterations);
+
+/**
+ * Nearest references to a fingerprint by mean absolute log2 ratio
+ * difference over the ratios both have measured.
+ *
+ * @param index Index handle
+ * @param ratios stableRatios of the query
+ * @param count Number of ratios
+ * @param k Matches to return (>= 1)
+ * @param probes Cells to scan after training, 0 for all (exact)
+ * @return JSON string: { "success": true, "data": { "size", "lists",
+ *           "scanned", "matches": [{ "id", "distance" (octaves),
+ *           "similarity" (1 - distance, floored at 0) }] } } closest first,
+ *         or NULL on invalid arguments.
+ *         Caller must free with estream_app_free_string()
+ */
+char* estream_etfa_index_search(long index, const double* ratios, int count, int k, int probes);
+
+// ============================================================================
+// Spark Particle Detection
+// ============================================================================
+
+/** One bright particle found in a camera frame */
+typedef struct {
+    /** Weighted centroid, normalized to [0, 1] by the frame width */
+    float x;
+    /** Weighted centroid, normalized to [0, 1] by the frame height */
+    float y;
+    /** Peak luma / 255 */
+    float brightness;
+    /** Pixels above the threshold */
+    uint32_t area;
+} EstreamSparkParticle;
+
+/**
+ * Create a particle detector. It keeps scratch buffers between frames, so
+ * use one per camera stream and call it from one thread at a time.
+ *
+ * @param threshold Luma a pixel must exceed, 0 for the default (170)
+ * @param min_area Smallest component reported, 0 for 1 pixel
+ * @return Detector handle, or -1 on invalid arguments
+ */
+long estream_spark_detector_create(int threshold, int min_area);
+
+void estream_spark_detector_destroy(long detector);
+
+/**
+ * Find the bright particles in an 8-bit luma plane: SIMD thresholding,
+ * 8-connected components and brightness-weighted centroids.
+ *
+ * @param detector Detector handle
+ * @param y_plane First byte of the Y plane
+ * @param width Frame width in pixels
+ * @param height Frame height in pixels
+ * @param row_stride Bytes between rows
+ * @param pixel_stride Bytes between pixels (1 for the Y plane)
+ * @param out Receives the particles, brightest first
+ * @param capacity Size of `out`; more particles than this are dropped
+ * @return Particles written, or -1 on invalid arguments
+ */
+int estream_spark_detect(long detector, const uint8_t* y_plane, int width, int height,
+                         int row_stride, int pixel_stride,
+                         EstreamSparkParticle* out, int capacity);
+
+/**
+ * Mean luma / 255 of a radius-15 disc at the frame center.
+ *
+ * @return Brightness in [0, 1], 0 on invalid arguments
+ */
+float estream_spark_center_brightness(const uint8_t* y_plane, int width, int height,
+                                      int row_stride, int pixel_stride);
+
+// ============================================================================
+// Spark Motion Keys
+// ============================================================================
+
+/**
+ * deriveBytes of spark.ts and sparkAuth.ts (Mission Control's derivation):
+ * simpleHash256(key || info || block) for each 32-byte block of output.
+ * key || info is hashed once for all blocks, and each simpleHash256 is a
+ * single pass for all 32 of its lanes.
+ *
+ * @param key Key bytes (may be NULL when key_len is 0)
+ * @param key_len Number of key bytes
+ * @param info NUL-terminated UTF-8 context string
+ * @param out Output, len bytes
+ * @param len Number of bytes to derive
+ * @return 0, or -1 on invalid arguments
+ */
+int estream_spark_derive_bytes(const uint8_t* key, int key_len, const char* info, uint8_t* out, int len);
+
+/**
+ * deriveMotionSeed of spark.ts: the 64-byte motion key of a Spark pattern,
+ * deriveBytes(pubkey[:64], "spark-motion-<timestamp>", 64).
+ *
+ * @param pubkey Decoded pubkey bytes (the first 64 are used)
+ * @param pubkey_len Number of bytes
+ * @param timestamp Pattern creation time (ms)
+ * @param out Output, 64 bytes
+ * @return 0, or -1 on invalid arguments
+ */
+int estream_spark_motion_key(const uint8_t* pubkey, int pubkey_len, int64_t timestamp, uint8_t* out);
+
+/**
+ * deriveParticleParams of spark.ts for all 12 particles of a pattern,
+ * derived from its motion key in one call.
+ *
+ * @param pubkey Decoded pubkey bytes (the first 64 are used)
+ * @param pubkey_len Number of bytes
+ * @param timestamp Pattern creation time (ms)
+ * @param out Output, 5 * 12 doubles, column after column: radius, speed,
+ *            phase, wobble, direction (1 or -1)
+ * @return 0, or -1 on invalid arguments
+ */
+int estream_spark_particle_params(const uint8_t* pubkey, int pubkey_len, int64_t timestamp, double* out);
+
+// ============================================================================
+// Spark Liveness
+// ============================================================================
+
+typedef enum {
+    /** Not yet statistically settled: keep feeding frames */
+    ESTREAM_SPARK_PENDING = 0,
+    /** The particles follow the pattern's trajectories */
+    ESTREAM_SPARK_LIVE = 1,
+    /** They do not, or the capture was too short */
+    ESTREAM_SPARK_NOT_LIVE = 2
+} EstreamSparkDecision;
+
+/**
+ * Start verifying one Spark scan. The particle trajectories are derived
+ * once from the pubkey and timestamp (deriveMotionSeed in spark.ts).
+ *
+ * @param pubkey Decoded pubkey bytes (the first 64 are used)
+ * @param pubkey_len Number of bytes
+ * @param timestamp Pattern creation time (ms), as in "spark-motion-<timestamp>"
+ * @param ordered 1: position i is particle i (spark.ts verifyLiveness);
+ *                0: each position is scored against the nearest particle
+ *                (detector output)
+ * @return Verifier handle, or -1 on invalid arguments
+ */
+long estream_spark_verifier_create(const uint8_t* pubkey, int pubkey_len, int64_t timestamp, int ordered);
+
+void estream_spark_verifier_destroy(long verifier);
+
+/**
+ * Score one captured frame. Cost is proportional to the particle count; no
+ * frames are stored. Safe to call from the camera thread while another
+ * thread reads the status.
+ *
+ * A scan is rejected once a 3-sigma Wilson interval of the match rate lies
+ * below 80% (after 10 frames). It is accepted once the interval lies at or
+ * above 80% and 60 frames over 2 s have been seen. After 6 s the point
+ * estimate decides.
+ *
+ * @param verifier Verifier handle
+ * @param timestamp_ms Capture time of the frame
+ * @param xy Normalized positions as x, y pairs
+ * @param count Number of positions
+ * @return EstreamSparkDecision after this frame, or -1 on invalid arguments
+ */
+int estream_spark_verifier_add_frame(long verifier, double timestamp_ms, const float* xy, int count);
+
+/**
+ * Decide a pending scan as verifyLiveness would: minimum frames and
+ * duration met and at least 80% of observations matching.
+ *
+ * @return EstreamSparkDecision, or -1 on invalid handle
+ */
+int estream_spark_verifier_finish(long verifier);
+
+/**
+ * @return JSON string: { "success": true, "data": { "decision"
+ *           ("pending" | "live" | "not_live"), "frames", "duration_ms",
+ *           "matches", "observations", "trajectory_score", "lower_bound",
+ *           "upper_bound" } }, or NULL on invalid handle.
+ *         Caller must free with estream_app_free_string()
+ */
+char* estream_spark_verifier_status(long verifier);
+
+// ============================================================================
+// Spark Orbits
+// ============================================================================
+
+/**
+ * Evaluate orbiting particles at many times in one call. Particle i at
+ * t = elapsed_ms / 1000 s is at
+ *
+ *   x = (center + cos(phase + t * speed) * radius + sin(t * wobble_x_rate) * wobble_x) / extent
+ *   y = (center + sin(phase + t * speed) * radius + cos(t * wobble_y_rate) * wobble_y) / extent
+ *
+ * which covers getExpectedPosition (center 150, extent 300, rates 2.3 and
+ * 1.7) and the Lattice Code renderer. Sines and cosines are computed two
+ * lanes at a time (SSE2 / NEON), both from one range reduction.
+ *
+ * @param orbits 7 * count doubles, column after column: radius, speed
+ *               (signed), phase, wobble_x, wobble_x_rate, wobble_y,
+ *               wobble_y_rate
+ * @param count Number of particles
+ * @param center Added to both coordinates before dividing by extent
+ * @param extent Divisor for both coordinates (1 for none)
+ * @param elapsed_ms Times to evaluate
+ * @param frames Number of times
+ * @param x Output, frames * count: particle i at elapsed_ms[f] is at
+ *          x[f * count + i]
+ * @param y Output, same layout
+ * @return 0, or -1 on invalid arguments
+ */
+int estream_spark_orbit_positions(const double* orbits, int count, double center, double extent,
+                                  const double* elapsed_ms, int frames, double* x, double* y);
+
+// ============================================================================
+// Lattice Code Rendering
+// ============================================================================
+
+/**
+ * Create an offscreen renderer for Lattice Code animation frames of
+ * size x size pixels. The static geometry (background, timing ring,
+ * hexagons) is rasterized here, once.
+ *
+ * @param size Frame width and height in pixels (1-4096)
+ * @return Renderer handle, or -1 on invalid arguments
+ */
+long estream_lattice_create(int size);
+
+void estream_lattice_destroy(long renderer);
+
+/**
+ * Set the pattern to draw, as derived by createLatticeCodeState. May be
+ * called while another thread renders.
+ *
+ * @param renderer Renderer handle
+ * @param base_hue baseHue (degrees)
+ * @param ring_speed ringSpeed (radians per second)
+ * @param heartbeat_freq heartbeatFreq (Hz)
+ * @param hex_cells hexCells: 0 off, 1 on, other values pulse
+ * @param hex_count Number of cells (37 are drawn; missing ones are off)
+ * @param orbits 7 * particle_count doubles in canvas pixels around the
+ *               center (150, 150), laid out as for
+ *               estream_spark_orbit_positions()
+ * @param colors Particle halo colors, 0xRRGGBB
+ * @param particle_count Number of particles
+ * @return 0, or -1 on invalid arguments
+ */
+int estream_lattice_set_scene(long renderer, double base_hue, double ring_speed, double heartbeat_freq,
+                              const uint8_t* hex_cells, int hex_count, const double* orbits, const uint32_t* colors,
+                              int particle_count);
+
+/**
+ * Draw the frame at `elapsed_ms` since the animation started, as
+ * LatticeCodeScreen's SVG would, minus the center label.
+ *
+ * @param renderer Renderer handle
+ * @param elapsed_ms Animation time
+ * @param rgba Output, 4-byte aligned: size rows of premultiplied RGBA8
+ *             (Android ARGB_8888 memory layout)
+ * @param stride Bytes per row, a multiple of 4 and at least 4 * size
+ * @return 0, or -1 on invalid arguments
+ */
+int estream_lattice_render(long renderer, double elapsed_ms, uint8_t* rgba, int stride);
+
+// ============================================================================
+// Spark Scan Engine
+// ============================================================================
+
+/**
+ * Create a scan pipeline: particle detection, then motion analysis and
+ * liveness. Results pass between them through a lock-free
+ * single-producer/single-consumer queue of fixed-size frame records, so
+ * nothing is allocated per frame.
+ *
+ * With a latency target, capture, detection and trajectory update run on
+ * separate threads. Only the newest captured frame waits for the detector;
+ * older ones are dropped as stale. The analysis resolution is halved or
+ * doubled (max-pooled, down to 1/4) to keep detection within the target.
+ * Without one, frames are detected at full resolution inside
+ * estream_spark_engine_submit() and analyzed when the status is read.
+ *
+ * @param threshold Luma a pixel must exceed, 0 for the default (170)
+ * @param latency_target_ms Detection time per frame to hold, or 0 to run
+ *                          inline
+ * @return Engine handle, or -1 on invalid arguments
+ */
+long estream_spark_engine_create(int threshold, double latency_target_ms);
+
+void estream_spark_engine_destroy(long engine);
+
+/**
+ * Analyze one camera frame. Call from one thread (the camera's). Inline,
+ * the frame is detected in place; threaded, it is shrunk to the current
+ * analysis resolution into a reused buffer and handed to the detection
+ * thread. Neither waits for the consumer.
+ *
+ * @param engine Engine handle
+ * @param y_plane First byte of the Y plane
+ * @param width Frame width in pixels
+ * @param height Frame height in pixels
+ * @param row_stride Bytes between rows
+ * @param pixel_stride Bytes between pixels (1 for the Y plane)
+ * @param timestamp_ms Capture time of the frame
+ * @return 1 if taken, 0 if dropped because the result queue was full
+ *         (inline), -1 on invalid arguments
+ */
+int estream_spark_engine_submit(long engine, const uint8_t* y_plane, int width, int height,
+                                int row_stride, int pixel_stride, double timestamp_ms);
+
+/**
+ * Start a new scan. Frames of the previous scan still queued or being
+ * detected are discarded; liveness is off until
+ * estream_spark_engine_start_liveness().
+ *
+ * @return 0, or -1 on invalid handle
+ */
+int estream_spark_engine_reset(long engine);
+
+/**
+ * Verify the current scan against the Spark pattern of `pubkey` and
+ * `timestamp` (see estream_spark_verifier_create). Positions are scored
+ * against the nearest expected particle.
+ *
+ * @return 0, or -1 on invalid arguments
+ */
+int estream_spark_engine_start_liveness(long engine, const uint8_t* pubkey, int pubkey_len, int64_t timestamp);
+
+/**
+ * Consume the queued frames and report the scan.
+ *
+ * @param engine Engine handle
+ * @param finish Non-zero to decide a pending liveness check now
+ * @return JSON string: { "success": true, "data": { "frames",
+ *           "frames_submitted", "frames_dropped", "window_frames",
+ *           "duration_ms", "particles", "center_brightness",
+ *           "motion_score", "direction" ("insufficient" | "no_motion" |
+ *           "cw" | "ccw" | "mixed"), "motion_detected", "liveness"
+ *           (estream_spark_verifier_status data, or null),
+ *           "frames_captured", "frames_stale", "scale" (1, 2 or 4),
+ *           "detect_ms", "latency_ms" (capture to result, smoothed) } },
+ *         or NULL on invalid handle.
+ *         Caller must free with estream_app_free_string()
+ */
+char* estream_spark_engine_status(long engine, int finish);
+
+// ============================================================================
+// QR Fountain Transport
+// ============================================================================
+
+/**
+ * Split a message into fountain-coded parts for an animated QR code (see
+ * src/fountain.h for the part layout). Parts 1..K carry the K fragments as
+ * they are; later parts mix fragments, so a receiver can decode from any
+ * sufficient subset and the sender can keep generating fresh parts.
+ *
+ * @param message Message bytes
+ * @param len Message length
+ * @param fragment_bytes Largest fragment; fragments are evened out so each
+ *                       is ceil(len / K) bytes
+ * @param first_seq Sequence number of the first part to write (from 1)
+ * @param count Number of consecutive parts to write (0 to only size them)
+ * @param out Output, count parts back to back
+ * @param capacity Size of out
+ * @return Bytes per part (header + fragment), or -1 on invalid arguments.
+ *         The fragment count K is bytes 5-8 of every part, big-endian
+ */
+int estream_fountain_encode(const uint8_t* message, int len, int fragment_bytes, uint32_t first_seq, int count,
+                            uint8_t* out, int capacity);
+
+/**
+ * Create a decoder that collects scanned parts until the message is
+ * recovered.
+ *
+ * @return Decoder handle
+ */
+long estream_fountain_decoder_create(void);
+
+void estream_fountain_decoder_destroy(long decoder);
+
+/**
+ * Add one scanned part. Repeated parts are counted and ignored.
+ *
+ * @param decoder Decoder handle
+ * @param part Part bytes
+ * @param len Part length
+ * @return 1 once the message is recovered and passed its CRC, 0 if more
+ *         parts are needed, -1 if the part is malformed or belongs to
+ *         another message than the parts before it
+ */
+int estream_fountain_decoder_receive(long decoder, const uint8_t* part, int len);
+
+/**
+ * Get decoding progress.
+ *
+ * @param decoder Decoder handle
+ * @return JSON string: { "success": true, "data": { "complete", "corrupt"
+ *           (recovered, but the CRC failed), "fragments", "recovered",
+ *           "parts_received", "parts_duplicate", "progress" (0-1),
+ *           "message_len" (0 until complete) } }, or NULL on invalid
+ *         handle. Caller must free with estream_app_free_string()
+ */
+char* estream_fountain_decoder_status_json(long decoder);
+
+/**
+ * Copy out the recovered message.
+ *
+ * @param decoder Decoder handle
+ * @param out Output, or NULL to only get the length
+ * @param capacity Size of out
+ * @return Message length, or -1 if not complete, out is too small or the
+ *         handle is invalid
+ */
+int estream_fountain_decoder_message(long decoder, uint8_t* out, int capacity);
+
+/**
+ * Forget all parts, to scan another message.
+ *
+ * @param decoder Decoder handle
+ */
+void estream_fountain_decoder_reset(long decoder);
+
+// ============================================================================
+// QR Signing Codec
+// ============================================================================
+
+/**
+ * Encode a signing response in the compact binary format of QR protocol v2
+ * (see src/qr_codec.h): numbered fields, raw bytes and varints.
+ *
+ * @param request_id Id of the request answered (UUIDs take 16 bytes)
+ * @param signature Signature bytes
+ * @param signature_len Signature length
+ * @param signer_key_hash Signer key hash bytes
+ * @param key_hash_len Key hash length
+ * @param algorithm Algorithm name, e.g. "ML-DSA-87"
+ * @param timestamp Signing time, ms since the epoch
+ * @param out Output, or NULL to only get the length
+ * @param capacity Size of out
+ * @return Encoded length, or -1 on invalid arguments or if out is too small
+ */
+int estream_qr_encode_response(const char* request_id, const uint8_t* signature, int signature_len,
+                               const uint8_t* signer_key_hash, int key_hash_len, const char* algorithm,
+                               uint64_t timestamp, uint8_t* out, int capacity);
+
+/**
+ * Decode a signing request in the compact binary format.
+ *
+ * @param data Encoded request
+ * @param len Encoded length
+ * @param payload Output for the payload bytes; `len` bytes always suffice
+ * @param capacity Size of payload
+ * @return JSON string: { "success": true, "data": { "id", "operation",
+ *           "description", "payload_length", "timestamp", "expires_at" (ms
+ *           since the epoch), "metadata" (JSON text, "" if none) } }, or
+ *         NULL if malformed, missing the id or timestamp, or the payload
+ *         does not fit. Caller must free with estream_app_free_string()
+ */
+char* estream_qr_decode_request_json(const uint8_t* data, int len, uint8_t* payload, int capacity);
+
+/**
+ * Base45-encode (RFC 9285) bytes for a QR code's alphanumeric mode.
+ *
+ * @param data Bytes
+ * @param len Byte count
+ * @param out Output characters (not NUL-terminated), or NULL to only get
+ *            the length
+ * @param capacity Size of out
+ * @return Character count, or -1 on invalid arguments or if out is too
+ *         small
+ */
+int estream_qr_base45_encode(const uint8_t* data, int len, char* out, int capacity);
+
+/**
+ * Decode Base45 text.
+ *
+ * @param text Characters
+ * @param len Character count
+ * @param out Output bytes, or NULL to only get the length
+ * @param capacity Size of out
+ * @return Byte count, or -1 if the text is not Base45 or out is too small
+ */
+int estream_qr_base45_decode(const char* text, int len, uint8_t* out, int capacity);
+
+// ============================================================================
+// Local Signing Server
+// ============================================================================
+
+/**
+ * Start the local signing endpoint for the CLI (see src/signing_server.h):
+ * GET /health, POST /sign and GET /status/<id> over keep-alive HTTP/1.1,
+ * served by one event-loop thread.
+ *
+ * @param port TCP port on every interface (8765 for the CLI; 0 picks one)
+ * @param queue_capacity Requests held at once (0 for the default, 32)
+ * @return Server handle, or -1 if the port cannot be bound
+ */
+long estream_signing_server_start(int port, int queue_capacity);
+
+/**
+ * Stop the server and close its connections. Wakes any
+ * estream_signing_server_next_request() caller.
+ *
+ * @param server Server handle
+ */
+void estream_signing_server_stop(long server);
+
+/**
+ * Wait for the next POST /sign request not handed out yet.
+ *
+ * @param server Server handle
+ * @param timeout_ms Longest wait
+ * @return The request body as received (a well-formed JSON object), or
+ *         NULL on timeout, once stopped or on invalid handle. Caller must
+ *         free with estream_app_free_string()
+ */
+char* estream_signing_server_next_request(long server, int timeout_ms);
+
+/**
+ * Get the bodies of the requests awaiting a decision.
+ *
+ * @param server Server handle
+ * @return JSON string: { "success": true, "data": [ body, ... ] } with each
+ *         body a JSON string, oldest first, or NULL on invalid handle.
+ *         Caller must free with estream_app_free_string()
+ */
+char* estream_signing_server_pending_json(long server);
+
+/**
+ * Record a signature for a pending request; GET /status/<id> returns it
+ * from then on.
+ *
+ * @param server Server handle
+ * @param request_id Request id
+ * @param signature Signature as the CLI expects it (base58)
+ * @param signer_key_hash Signer key hash (base58)
+ * @param algorithm Algorithm name, e.g. "ML-DSA-87"
+ * @param timestamp_ms Signing time, ms since the epoch
+ * @return 0, or -1 if the request is not pending (or has expired) or the
+ *         handle is invalid
+ */
+int estream_signing_server_mark_signed(long server, const char* request_id, const char* signature,
+                                       const char* signer_key_hash, const char* algorithm, uint64_t timestamp_ms);
+
+/**
+ * Record that the user rejected a pending request.
+ *
+ * @param server Server handle
+ * @param request_id Request id
+ * @param reason Reason reported to the CLI
+ * @return 0, or -1 if the request is not pending (or has expired) or the
+ *         handle is invalid
+ */
+int estream_signing_server_mark_rejected(long server, const char* request_id, const char* reason);
+
+/**
+ * Get connection, HTTP and queue counters.
+ *
+ * @param server Server handle
+ * @return JSON string: { "success": true, "data": { "running", "port",
+ *           "backend" ("epoll" or "poll"), "connections": { "accepted",
+ *           "refused", "open", "idle_closed" }, "http": { "requests",
+ *           "keep_alive_reuses", "health", "sign", "status", "not_found",
+ *           "bad_request", "handle_us_p50", "handle_us_p99",
+ *           "handle_us_max" }, "queue": { "capacity", "pending",
+ *           "max_pending", "accepted", "duplicate", "full" (refused with
+ *           503), "signed", "rejected", "expired", "oldest_pending_ms",
+ *           "decision_ms_p50", "decision_ms_p99" } } }, or NULL on invalid
+ *         handle. Caller must free with estream_app_free_string()
+ */
+char* estream_signing_server_status_json(long server);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESTREAM_APP_NATIVE_H */
@@ -0,0 +1,164 @@
+/**
+ * Instrumented entry points into the Rust core (estream_app_* in
+ * estream_app_native.h). Each forwards to the estream_native.h function of
+ * the same name inside a Probe (span + latency histogram). Ownership of
+ * returned strings is unchanged: they still come from the Rust allocator.
+ */
+
+#include "estream_app_native.h"
+#include "estream_native.h"
+#include "probe.h"
+#include "runtime_stats.h"
+
+#include <mutex>
+
+using estream::Probe;
+
+namespace {
+
+// The core has one global HTTP/3 connection and runs requests on it one at
+// a time. Taking that turn here first makes the wait show up as the
+// "h3_connection" lock in estream_runtime_stats. estream_app_h3_is_connected
+// stays outside so a status check does not queue behind a request.
+estream::ProfiledMutex g_h3_mu{"h3_connection"};
+
+}  // namespace
+
+extern "C" long estream_app_initialize(void) {
+    Probe probe(ESTREAM_FN_INITIALIZE, "initialize");
+    const long handle = estream_initialize();
+    if (handle < 0) {
+        probe.fail();
+    }
+    return handle;
+}
+
+extern "C" char* estream_app_connect(long handle, const char* node_addr) {
+    Probe probe(ESTREAM_FN_CONNECT, "connect");
+    return probe.check(estream_connect(handle, node_addr));
+}
+
+extern "C" void estream_app_dispose(long handle) {
+    Probe probe(ESTREAM_FN_DISPOSE, "dispose");
+    estream_dispose(handle);
+}
+
+extern "C" char* estream_app_generate_device_keys(const char* app_scope) {
+    Probe probe(ESTREAM_FN_GENERATE_DEVICE_KEYS, "keygen");
+    return probe.check(estream_generate_device_keys(app_scope));
+}
+
+extern "C" char* estream_app_generate_prekey_bundle(const char* device_id, int num_one_time_keys) {
+    Probe probe(ESTREAM_FN_GENERATE_PREKEY_BUNDLE, "prekey_bundle");
+    return probe.check(estream_generate_prekey_bundle(device_id, num_one_time_keys));
+}
+
+extern "C" char* estream_app_x3dh_initiate(
+    const uint8_t* our_identity_public,
+    size_t our_identity_len,
+    const char* their_bundle_json
+) {
+    Probe probe(ESTREAM_FN_X3DH_INITIATE, "x3dh_initiate");
+    return probe.check(estream_x3dh_initiate(our_identity_public, our_identity_len, their_bundle_json));
+}
+
+extern "C" char* estream_app_x3dh_accept(
+    const uint8_t* our_identity_public,
+    size_t our_identity_len,
+    const uint8_t* spk_secret,
+    size_t spk_secret_len,
+    const uint8_t* opk_secret,
+    size_t opk_secret_len,
+    const char* initial_msg_json
+) {
+    Probe probe(ESTREAM_FN_X3DH_ACCEPT, "x3dh_accept");
+    return probe.check(estream_x3dh_accept(
+        our_identity_public, our_identity_len,
+        spk_secret, spk_secret_len,
+        opk_secret, opk_secret_len,
+        initial_msg_json));
+}
+
+extern "C" char* estream_app_ratchet_init_sender(
+    const uint8_t* shared_secret,
+    const uint8_t* their_kem_public,
+    size_t their_kem_len
+) {
+    Probe probe(ESTREAM_FN_RATCHET_INIT_SENDER, "kem_encaps");
+    return probe.check(estream_ratchet_init_sender(shared_secret, their_kem_public, their_kem_len));
+}
+
+extern "C" char* estream_app_ratchet_init_receiver(
+    const uint8_t* shared_secret,
+    const uint8_t* our_kem_secret,
+    size_t our_kem_secret_len,
+    const uint8_t* our_kem_public,
+    size_t our_kem_public_len,
+    const uint8_t* initial_ciphertext,
+    size_t initial_ct_len,
+    const uint8_t* their_kem_public,
+    size_t their_kem_len
+) {
+    Probe probe(ESTREAM_FN_RATCHET_INIT_RECEIVER, "kem_decaps");
+    return probe.check(estream_ratchet_init_receiver(
+        shared_secret,
+        our_kem_secret, our_kem_secret_len,
+        our_kem_public, our_kem_public_len,
+        initial_ciphertext, initial_ct_len,
+        their_kem_public, their_kem_len));
+}
+
+extern "C" char* estream_app_ratchet_encrypt(long handle, const uint8_t* plaintext, size_t plaintext_len) {
+    Probe probe(ESTREAM_FN_RATCHET_ENCRYPT, "ratchet_encrypt");
+    return probe.check(estream_ratchet_encrypt(handle, plaintext, plaintext_len));
+}
+
+extern "C" char* estream_app_ratchet_decrypt(long handle, const char* message_json) {
+    Probe probe(ESTREAM_FN_RATCHET_DECRYPT, "ratchet_decrypt");
+    return probe.check(estream_ratchet_decrypt(handle, message_json));
+}
+
+extern "C" void estream_app_ratchet_dispose(long handle) {
+    Probe probe(ESTREAM_FN_RATCHET_DISPOSE, "ratchet_dispose");
+    estream_ratchet_dispose(handle);
+}
+
+extern "C" char* estream_app_h3_connect(const char* server_addr) {
+    Probe probe(ESTREAM_FN_H3_CONNECT, "handshake");
+    std::lock_guard<estream::ProfiledMutex> lock(g_h3_mu);
+    return probe.check(estream_h3_connect(server_addr));
+}
+
+extern "C" char* estream_app_h3_post(const char* path, const char* body) {
+    Probe probe(ESTREAM_FN_H3_POST, "h3_request");
+    std::lock_guard<estream::ProfiledMutex> lock(g_h3_mu);
+    return probe.check(estream_h3_post(path, body));
+}
+
+extern "C" char* estream_app_h3_get(const char* path) {
+    Probe probe(ESTREAM_FN_H3_GET, "h3_request");
+    std::lock_guard<estream::ProfiledMutex> lock(g_h3_mu);
+    return probe.check(estream_h3_get(path));
+}
+
+extern "C" char* estream_app_h3_mint_identity_nft(const char* owner, const char* trust_level) {
+    Probe probe(ESTREAM_FN_H3_MINT_IDENTITY_NFT, "h3_request");
+    std::lock_guard<estream::ProfiledMutex> lock(g_h3_mu);
+    return probe.check(estream_h3_mint_identity_nft(owner, trust_level));
+}
+
+extern "C" int estream_app_h3_is_connected(void) {
+    Probe probe(ESTREAM_FN_H3_IS_CONNECTED, "h3_is_connected");
+    return estream_h3_is_connected();
+}
+
+extern "C" void estream_app_h3_disconnect(void) {
+    Probe probe(ESTREAM_FN_H3_DISCONNECT, "h3_disconnect");
+    std::lock_guard<estream::ProfiledMutex> lock(g_h3_mu);
+    estream_h3_disconnect();
+}
+
+extern "C" char* estream_app_version(void) {
+    Probe probe(ESTREAM_FN_VERSION, "version");
+    return probe.check(estream_version());
+}
@@ -0,0 +1,219 @@
+#include "cpu_topology.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <dirent.h>
+
+#if defined(__APPLE__)
+#include <pthread.h>
+#include <sys/qos.h>
+#include <sys/sysctl.h>
+#else
+#include <sched.h>
+#endif
+
+namespace estream {
+namespace cpu_topology {
+
+namespace {
+
+bool read_file(const std::string& path, std::string& out) {
+    FILE* f = std::fopen(path.c_str(), "r");
+    if (f == nullptr) {
+        return false;
+    }
+    char buf[512];
+    const size_t n = std::fread(buf, 1, sizeof(buf) - 1, f);
+    std::fclose(f);
+    out.assign(buf, n);
+    return true;
+}
+
+std::vector<int> intersect(const std::vector<int>& cpus, const std::vector<int>& allowed) {
+    if (allowed.empty()) {
+        return cpus;
+    }
+    std::vector<int> out;
+    for (int cpu : cpus) {
+        if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+            out.push_back(cpu);
+        }
+    }
+    return out;
+}
+
+#if !defined(__APPLE__)
+std::vector<int> allowed_cpus() {
+    std::vector<int> out;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return out;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+            out.push_back(cpu);
+        }
+    }
+    return out;
+}
+
+// Affinity mask of the process when first asked, before any pinning.
+const std::vector<int>& process_cpus() {
+    static const std::vector<int> cpus = allowed_cpus();
+    return cpus;
+}
+#endif
+
+}  // namespace
+
+std::vector<int> parse_cpu_list(const std::string& text) {
+    std::vector<int> out;
+    const char* p = text.c_str();
+    while (*p != '\0') {
+        if (*p < '0' || *p > '9') {
+            ++p;
+            continue;
+        }
+        char* end = nullptr;
+        const long first = std::strtol(p, &end, 10);
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = std::strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long cpu = first; cpu <= last && cpu < 4096; ++cpu) {
+            out.push_back(static_cast<int>(cpu));
+        }
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+std::vector<Cluster> clusters_from_sysfs(const std::string& root, const std::vector<int>& allowed) {
+    std::vector<Cluster> out;
+    if (DIR* dir = opendir((root + "/cpufreq").c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            if (std::strncmp(entry->d_name, "policy", 6) != 0) {
+                continue;
+            }
+            const std::string policy = root + "/cpufreq/" + entry->d_name;
+            std::string text;
+            if (!read_file(policy + "/related_cpus", text) && !read_file(policy + "/affected_cpus", text)) {
+                continue;
+            }
+            Cluster c;
+            c.cpus = intersect(parse_cpu_list(text), allowed);
+            if (c.cpus.empty()) {
+                continue;
+            }
+            c.cpu_count = static_cast<int>(c.cpus.size());
+            if (read_file(policy + "/cpuinfo_max_freq", text)) {
+                c.max_freq_khz = std::strtoull(text.c_str(), nullptr, 10);
+            }
+            out.push_back(std::move(c));
+        }
+        closedir(dir);
+    }
+
+    if (out.empty()) {
+        std::string text;
+        Cluster c;
+        c.cpus = read_file(root + "/online", text) ? intersect(parse_cpu_list(text), allowed) : allowed;
+        if (c.cpus.empty()) {
+            c.cpus = allowed;
+        }
+        c.cpu_count = std::max(1, static_cast<int>(c.cpus.size()));
+        out.push_back(std::move(c));
+    }
+
+    // Fastest first; ties keep CPU order.
+    std::stable_sort(out.begin(), out.end(), [](const Cluster& a, const Cluster& b) {
+        if (a.max_freq_khz != b.max_freq_khz) {
+            return a.max_freq_khz > b.max_freq_khz;
+        }
+        return a.cpus.front() < b.cpus.front();
+    });
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i].id = static_cast<int>(i);
+    }
+    return out;
+}
+
+#if defined(__APPLE__)
+
+std::vector<Cluster> clusters() {
+    std::vector<Cluster> out;
+    int levels = 0;
+    size_t size = sizeof(levels);
+    if (sysctlbyname("hw.nperflevels", &levels, &size, nullptr, 0) != 0 || levels < 1) {
+        levels = 0;
+    }
+    // perflevel0 is the highest-performance level.
+    for (int level = 0; level < levels; ++level) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "hw.perflevel%d.logicalcpu", level);
+        int count = 0;
+        size = sizeof(count);
+        if (sysctlbyname(name, &count, &size, nullptr, 0) != 0 || count < 1) {
+            continue;
+        }
+        Cluster c;
+        c.id = static_cast<int>(out.size());
+        c.cpu_count = count;
+        out.push_back(std::move(c));
+    }
+    if (out.empty()) {
+        int count = 1;
+        size = sizeof(count);
+        sysctlbyname("hw.logicalcpu", &count, &size, nullptr, 0);
+        Cluster c;
+        c.cpu_count = std::max(1, count);
+        out.push_back(std::move(c));
+    }
+    return out;
+}
+
+// No thread affinity on Apple silicon: the scheduler keeps user-interactive
+// threads on performance cores and background threads on efficiency cores.
+bool pin_current_thread(const Cluster& cluster, int /* cpu */) {
+    pthread_set_qos_class_self_np(cluster.id == 0 ? QOS_CLASS_USER_INTERACTIVE : QOS_CLASS_BACKGROUND, 0);
+    return false;
+}
+
+int current_cpu() {
+    return -1;
+}
+
+#else
+
+std::vector<Cluster> clusters() {
+    return clusters_from_sysfs("/sys/devices/system/cpu", process_cpus());
+}
+
+bool pin_current_thread(const Cluster& cluster, int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cpu >= 0) {
+        CPU_SET(cpu, &set);
+    } else {
+        for (int c : cluster.cpus) {
+            CPU_SET(c, &set);
+        }
+    }
+    return CPU_COUNT(&set) > 0 && sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+int current_cpu() {
+    return sched_getcpu();
+}
+
+#endif
+
+}  // namespace cpu_topology
+}  // namespace estream
@@ -0,0 +1,53 @@
+/**
+ * CPU cluster discovery and thread placement.
+ *
+ * Linux/Android: CPUs sharing a cpufreq policy form a cluster (one per
+ * big.LITTLE tier), restricted to the CPUs this process may run on; threads
+ * are pinned with sched_setaffinity. Apple: one cluster per performance
+ * level (hw.perflevelN); there is no affinity API, so threads are steered
+ * with QoS classes instead and report themselves as not pinned.
+ */
+
+#ifndef ESTREAM_CPU_TOPOLOGY_H
+#define ESTREAM_CPU_TOPOLOGY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace estream {
+namespace cpu_topology {
+
+struct Cluster {
+    /// 0 is the fastest cluster.
+    int id = 0;
+    /// Logical CPU numbers (empty where the OS does not expose them).
+    std::vector<int> cpus;
+    /// Number of logical CPUs (equals cpus.size() when known).
+    int cpu_count = 0;
+    /// Highest frequency of the cluster, 0 if unknown.
+    uint64_t max_freq_khz = 0;
+};
+
+/// Parse a kernel CPU list ("0-3,6", "4 5 6 7").
+std::vector<int> parse_cpu_list(const std::string& text);
+
+/// Clusters under a sysfs root ("/sys/devices/system/cpu"), fastest first,
+/// limited to `allowed` CPUs (all if empty). Falls back to one cluster of the
+/// allowed (or online) CPUs when cpufreq is not exposed.
+std::vector<Cluster> clusters_from_sysfs(const std::string& root, const std::vector<int>& allowed);
+
+/// Clusters of this device, fastest first; never empty.
+std::vector<Cluster> clusters();
+
+/// Run the calling thread on `cpu` of `cluster` (a CPU number, or -1 for
+/// any CPU of the cluster). Returns true if the OS guarantees placement.
+bool pin_current_thread(const Cluster& cluster, int cpu);
+
+/// CPU the calling thread is running on, -1 if unknown.
+int current_cpu();
+
+}  // namespace cpu_topology
+}  // namespace estream
+
+#endif /* ESTREAM_CPU_TOPOLOGY_H */
@@ -0,0 +1,823 @@
+#include "etfa.h"
+
+#include "estream_app_native.h"
+#include "ffi_util.h"
+#include "json.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace estream {
+namespace etfa {
+
+namespace {
+
+// ----------------------------------------------------------------------------
+// Barriers
+// ----------------------------------------------------------------------------
+
+// Force `v` into a register the optimizer knows nothing about. Used on every
+// loop-carried value, every iteration, so each kernel compiles to the same
+// scalar instruction sequence regardless of compiler version or target.
+#if defined(__GNUC__) || defined(__clang__)
+inline void keep(uint64_t& v) { asm volatile("" : "+r"(v)); }
+inline void keep(uint32_t& v) { asm volatile("" : "+r"(v)); }
+inline void keep(int64_t& v) { asm volatile("" : "+r"(v)); }
+inline void keep(int32_t& v) { asm volatile("" : "+r"(v)); }
+#if defined(__aarch64__)
+inline void keep(double& v) { asm volatile("" : "+w"(v)); }
+inline void keep(float& v) { asm volatile("" : "+w"(v)); }
+#elif defined(__x86_64__)
+inline void keep(double& v) { asm volatile("" : "+x"(v)); }
+inline void keep(float& v) { asm volatile("" : "+x"(v)); }
+#else
+inline void keep(double& v) { asm volatile("" : "+m"(v)); }
+inline void keep(float& v) { asm volatile("" : "+m"(v)); }
+#endif
+// Memory barrier for the compiler only: no loads or stores move across it.
+inline void clobber() { asm volatile("" ::: "memory"); }
+#else
+template <typename T>
+inline void keep(T& v) {
+    volatile T sink = v;
+    v = sink;
+}
+inline void clobber() {}
+#endif
+
+// ----------------------------------------------------------------------------
+// Timer
+// ----------------------------------------------------------------------------
+
+uint64_t monotonic_raw_ns() {
+    timespec ts;
+#if defined(CLOCK_MONOTONIC_RAW)
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Serialized counter read: the ISB / LFENCE keeps earlier instructions from
+// retiring after the read and later ones from starting before it.
+inline uint64_t ticks() {
+#if defined(__aarch64__)
+    uint64_t v;
+    asm volatile("isb\n\tmrs %0, cntvct_el0" : "=r"(v) : : "memory");
+    return v;
+#elif defined(__x86_64__) || defined(__i386__)
+    _mm_lfence();
+    const uint64_t v = __rdtsc();
+    _mm_lfence();
+    return v;
+#else
+    return monotonic_raw_ns();
+#endif
+}
+
+// Nanoseconds per tick.
+double measure_tick_ns() {
+#if defined(__aarch64__)
+    uint64_t freq;
+    asm volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+    return freq != 0 ? 1e9 / static_cast<double>(freq) : 1.0;
+#elif defined(__x86_64__) || defined(__i386__)
+    // The TSC rate is not architecturally visible; calibrate it over 10 ms.
+    const uint64_t ns0 = monotonic_raw_ns();
+    const uint64_t t0 = ticks();
+    while (monotonic_raw_ns() - ns0 < 10000000ull) {
+    }
+    const uint64_t ns1 = monotonic_raw_ns();
+    const uint64_t t1 = ticks();
+    return t1 > t0 ? static_cast<double>(ns1 - ns0) / static_cast<double>(t1 - t0) : 1.0;
+#else
+    return 1.0;
+#endif
+}
+
+double tick_ns() {
+    static const double value = measure_tick_ns();
+    return value;
+}
+
+// ----------------------------------------------------------------------------
+// Buffers
+// ----------------------------------------------------------------------------
+
+constexpr size_t k1M = 1024 * 1024;
+constexpr size_t k4M = 4 * k1M;
+constexpr size_t kVecLen = 65536;
+constexpr size_t kMatrixN = 128;
+
+// Read-only inputs, shared by all measuring threads.
+struct Buffers {
+    std::vector<uint8_t> mem1m;
+    std::vector<uint8_t> mem4m;
+    std::vector<uint32_t> random_indices;
+    std::vector<float> vec_a;
+    std::vector<float> vec_b;
+    std::vector<float> mat_a;
+    std::vector<float> mat_b;
+
+    Buffers()
+        : mem1m(k1M), mem4m(k4M), random_indices(k1M),
+          vec_a(kVecLen), vec_b(kVecLen),
+          mat_a(kMatrixN * kMatrixN), mat_b(kMatrixN * kMatrixN) {
+        for (size_t i = 0; i < k1M; ++i) {
+            mem1m[i] = static_cast<uint8_t>(i);
+        }
+        for (size_t i = 0; i < k4M; ++i) {
+            mem4m[i] = static_cast<uint8_t>(i);
+        }
+        // Seeded Fisher-Yates so every device walks the same permutation.
+        for (size_t i = 0; i < k1M; ++i) {
+            random_indices[i] = static_cast<uint32_t>(i);
+        }
+        uint64_t state = 0x9E3779B97F4A7C15ull;
+        for (size_t i = k1M - 1; i > 0; --i) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            std::swap(random_indices[i], random_indices[state % (i + 1)]);
+        }
+        for (size_t i = 0; i < kVecLen; ++i) {
+            vec_a[i] = static_cast<float>(i % 100) / 100.0f;
+            vec_b[i] = static_cast<float>((i + 37) % 100) / 100.0f;
+        }
+        for (size_t i = 0; i < kMatrixN * kMatrixN; ++i) {
+            mat_a[i] = static_cast<float>(i % 100) / 100.0f;
+            mat_b[i] = static_cast<float>((i + 17) % 100) / 100.0f;
+        }
+    }
+};
+
+// Allocated on first use and kept, like the platform modules' buffers.
+const Buffers& buffers() {
+    static const Buffers* instance = new Buffers();
+    return *instance;
+}
+
+// Kernel outputs. Per thread, so concurrent kernels never write to the same
+// cache lines; freed when the thread exits.
+struct Scratch {
+    std::vector<uint8_t> copy_dest = std::vector<uint8_t>(k1M);
+    std::vector<float> mat_c = std::vector<float>(kMatrixN * kMatrixN);
+};
+
+Scratch& scratch() {
+    thread_local Scratch instance;
+    return instance;
+}
+
+// ----------------------------------------------------------------------------
+// Kernels
+// ----------------------------------------------------------------------------
+
+uint64_t bits(double v) {
+    uint64_t out;
+    std::memcpy(&out, &v, sizeof(out));
+    return out;
+}
+
+uint64_t bits(float v) {
+    uint32_t out;
+    std::memcpy(&out, &v, sizeof(out));
+    return out;
+}
+
+uint64_t mem_sequential(const uint8_t* data, size_t n) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += data[i];
+        keep(sum);
+    }
+    return sum;
+}
+
+uint64_t mem_random(const Buffers& b, size_t n, uint32_t mask) {
+    const uint8_t* data = b.mem1m.data();
+    const uint32_t* idx = b.random_indices.data();
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += data[idx[i] & mask];
+        keep(sum);
+    }
+    return sum;
+}
+
+uint64_t mem_copy(const Buffers& b, Scratch& out) {
+    std::memcpy(out.copy_dest.data(), b.mem1m.data(), k1M);
+    clobber();
+    return uint64_t{out.copy_dest[1]} + out.copy_dest[k1M - 1];
+}
+
+uint64_t int_multiply64() {
+    uint64_t result = 1;
+    uint64_t multiplier = 7;
+    for (int i = 0; i < 1000000; ++i) {
+        result = (result * multiplier) & 0x7FFFFFFFFFFFFFFFull;
+        multiplier = (multiplier * 31 + 17) & 0x7FFFFFFFull;
+        keep(result);
+        keep(multiplier);
+    }
+    return result;
+}
+
+uint64_t int_multiply32() {
+    uint32_t result = 1;
+    uint32_t multiplier = 7;
+    for (int i = 0; i < 1000000; ++i) {
+        result = (result * multiplier) & 0x7FFFFFFFu;
+        multiplier = (multiplier * 31 + 17) & 0x7FFFu;
+        keep(result);
+        keep(multiplier);
+    }
+    return result;
+}
+
+uint64_t int_divide32() {
+    int32_t result = 0x7FFFFFFF;
+    int32_t divisor = 3;
+    for (int i = 0; i < 500000; ++i) {
+        result = result / divisor;
+        if (result < 1000) {
+            result = 0x7FFFFFFF;
+        }
+        divisor = static_cast<int32_t>((static_cast<uint32_t>(divisor) * 31 + 17) & 0x7FFFu);
+        if (divisor < 2) {
+            divisor = 3;
+        }
+        keep(result);
+        keep(divisor);
+    }
+    return static_cast<uint64_t>(result);
+}
+
+uint64_t int_divide64() {
+    int64_t result = 0x7FFFFFFFFFFFFFFFll;
+    int64_t divisor = 3;
+    for (int i = 0; i < 500000; ++i) {
+        result = result / divisor;
+        if (result < 1000) {
+            result = 0x7FFFFFFFFFFFFFFFll;
+        }
+        divisor = static_cast<int64_t>((static_cast<uint64_t>(divisor) * 31 + 17) & 0x7FFFFFFFull);
+        if (divisor < 2) {
+            divisor = 3;
+        }
+        keep(result);
+        keep(divisor);
+    }
+    return static_cast<uint64_t>(result);
+}
+
+uint64_t float_multiply() {
+    double result = 1.0;
+    double multiplier = 1.0000001;
+    keep(multiplier);
+    for (int i = 0; i < 1000000; ++i) {
+        result *= multiplier;
+        if (result > 1e100) {
+            result = 1.0;
+        }
+        keep(result);
+    }
+    return bits(result);
+}
+
+// The product passes through keep() so it is never contracted into an FMA.
+uint64_t vector_dot(const Buffers& b) {
+    const float* a = b.vec_a.data();
+    const float* v = b.vec_b.data();
+    float result = 0.0f;
+    for (size_t i = 0; i < kVecLen; ++i) {
+        float p = a[i] * v[i];
+        keep(p);
+        result += p;
+        keep(result);
+    }
+    return bits(result);
+}
+
+uint64_t matrix_op(const Buffers& b, Scratch& out) {
+    const size_t n = kMatrixN;
+    const float* a = b.mat_a.data();
+    const float* m = b.mat_b.data();
+    float* c = out.mat_c.data();
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            float sum = 0.0f;
+            for (size_t k = 0; k < n; ++k) {
+                float p = a[i * n + k] * m[k * n + j];
+                keep(p);
+                sum += p;
+                keep(sum);
+            }
+            c[i * n + j] = sum;
+        }
+    }
+    clobber();
+    return bits(c[n * n - 1]);
+}
+
+// Four dependent adds per iteration.
+uint64_t int_add_chain() {
+    uint64_t a = 1, b = 2, c = 3, d = 4;
+    for (int i = 0; i < 1000000; ++i) {
+        a += b;
+        b += c;
+        c += d;
+        d += a;
+        keep(a);
+        keep(b);
+        keep(c);
+        keep(d);
+    }
+    return a + b + c + d;
+}
+
+// Four independent adds per iteration.
+uint64_t int_add_parallel() {
+    uint64_t a = 1, b = 2, c = 3, d = 4;
+    uint64_t x = 5, y = 6, z = 7, w = 8;
+    keep(x);
+    keep(y);
+    keep(z);
+    keep(w);
+    for (int i = 0; i < 1000000; ++i) {
+        a += x;
+        b += y;
+        c += z;
+        d += w;
+        keep(a);
+        keep(b);
+        keep(c);
+        keep(d);
+    }
+    return a + b + c + d;
+}
+
+uint64_t bitwise_ops() {
+    uint64_t a = 0xDEADBEEFull;
+    uint64_t b = 0xCAFEBABEull;
+    for (int i = 0; i < 1000000; ++i) {
+        a = a ^ b;
+        b = (b & 0xFFFF0000ull) | (a & 0x0000FFFFull);
+        a = (a << 1) | (a >> 63);
+        keep(a);
+        keep(b);
+    }
+    return a ^ b;
+}
+
+struct KernelInfo {
+    const char* name;
+    const char* label;
+};
+
+constexpr KernelInfo kKernels[kKernelCount] = {
+    {"mem_seq_1m", "Memory Sequential"},
+    {"mem_rand_1m", "Memory Random"},
+    {"mem_copy_1m", "Memory Copy"},
+    {"int_mul_64", "Int Multiply"},
+    {"float_mul", "Float Multiply"},
+    {"vector_dot", "Vector Dot"},
+    {"matrix_op", "Matrix Op"},
+    {"mem_seq_4k", "Seq 4K"},
+    {"mem_seq_64k", "Seq 64K"},
+    {"mem_seq_4m", "Seq 4M"},
+    {"mem_rand_4k", "Rand 4K"},
+    {"mem_rand_64k", "Rand 64K"},
+    {"int_mul_32", "Int Mul 32"},
+    {"int_div_32", "Int Div 32"},
+    {"int_div_64", "Int Div 64"},
+    {"add_chain", "Add Chain"},
+    {"add_parallel", "Add Parallel"},
+    {"bitwise", "Bitwise"},
+};
+
+struct RatioInfo {
+    const char* name;
+    Kernel num;
+    Kernel den;
+};
+
+constexpr RatioInfo kRatios[kRatioCount] = {
+    {"r5_mem_seq_to_rand", Kernel::MemSeq1M, Kernel::MemRand1M},
+    {"r6_mem_copy_to_seq", Kernel::MemCopy1M, Kernel::MemSeq1M},
+    {"r7_int_to_float", Kernel::IntMul64, Kernel::FloatMul},
+    {"r9_float_to_matrix", Kernel::FloatMul, Kernel::MatrixOp},
+    {"r10_seq_4k_to_64k", Kernel::MemSeq4K, Kernel::MemSeq64K},
+    {"r11_seq_64k_to_1m", Kernel::MemSeq64K, Kernel::MemSeq1M},
+    {"r12_seq_1m_to_4m", Kernel::MemSeq1M, Kernel::MemSeq4M},
+    {"r13_rand_4k_to_64k", Kernel::MemRand4K, Kernel::MemRand64K},
+    {"r14_rand_64k_to_1m", Kernel::MemRand64K, Kernel::MemRand1M},
+    {"r18_int_mul_32_to_64", Kernel::IntMul32, Kernel::IntMul64},
+    {"r19_int_div_32_to_64", Kernel::IntDiv32, Kernel::IntDiv64},
+    {"r22_int_mul_to_div", Kernel::IntMul64, Kernel::IntDiv64},
+    {"r24_add_chain_to_parallel", Kernel::AddChain, Kernel::AddParallel},
+    {"r25_int_to_bitwise", Kernel::IntMul64, Kernel::Bitwise},
+};
+
+uint64_t median(std::vector<uint64_t>& values) {
+    if (values.empty()) {
+        return 0;
+    }
+    const size_t mid = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(mid), values.end());
+    return values[mid];
+}
+
+}  // namespace
+
+const char* kernel_name(Kernel kernel) {
+    return kKernels[static_cast<size_t>(kernel)].name;
+}
+
+const char* kernel_label(Kernel kernel) {
+    return kKernels[static_cast<size_t>(kernel)].label;
+}
+
+uint64_t run(Kernel kernel) {
+    const Buffers& b = buffers();
+    switch (kernel) {
+        case Kernel::MemSeq1M: return mem_sequential(b.mem1m.data(), k1M);
+        case Kernel::MemRand1M: return mem_random(b, k1M, 0xFFFFF);
+        case Kernel::MemCopy1M: return mem_copy(b, scratch());
+        case Kernel::IntMul64: return int_multiply64();
+        case Kernel::FloatMul: return float_multiply();
+        case Kernel::VectorDot: return vector_dot(b);
+        case Kernel::MatrixOp: return matrix_op(b, scratch());
+        case Kernel::MemSeq4K: return mem_sequential(b.mem1m.data(), 4096);
+        case Kernel::MemSeq64K: return mem_sequential(b.mem1m.data(), 65536);
+        case Kernel::MemSeq4M: return mem_sequential(b.mem4m.data(), k4M);
+        case Kernel::MemRand4K: return mem_random(b, 4096, 0xFFF);
+        case Kernel::MemRand64K: return mem_random(b, 65536, 0xFFFF);
+        case Kernel::IntMul32: return int_multiply32();
+        case Kernel::IntDiv32: return int_divide32();
+        case Kernel::IntDiv64: return int_divide64();
+        case Kernel::AddChain: return int_add_chain();
+        case Kernel::AddParallel: return int_add_parallel();
+        case Kernel::Bitwise: return bitwise_ops();
+        case Kernel::Count: break;
+    }
+    return 0;
+}
+
+uint64_t time_once(Kernel kernel) {
+    buffers();
+    scratch();
+    const double scale = tick_ns();
+    clobber();
+    const uint64_t t0 = ticks();
+    clobber();
+    uint64_t checksum = run(kernel);
+    keep(checksum);
+    clobber();
+    const uint64_t t1 = ticks();
+    clobber();
+    return static_cast<uint64_t>(static_cast<double>(t1 - t0) * scale + 0.5);
+}
+
+uint64_t measure_median(Kernel kernel, int samples) {
+    if (samples < 1) {
+        samples = 1;
+    }
+    run(kernel);
+    std::vector<uint64_t> results(static_cast<size_t>(samples));
+    for (uint64_t& r : results) {
+        r = time_once(kernel);
+    }
+    return median(results);
+}
+
+const char* timer_name() {
+#if defined(__aarch64__)
+    return "cntvct";
+#elif defined(__x86_64__) || defined(__i386__)
+    return "tsc";
+#else
+    return "monotonic_raw";
+#endif
+}
+
+double timer_resolution_ns() {
+    return tick_ns();
+}
+
+Fingerprint collect(int sample_count, Progress progress, void* ctx) {
+    Fingerprint fp;
+    fp.sample_count = sample_count < 1 ? 1 : sample_count;
+    const uint64_t start = monotonic_raw_ns();
+    for (size_t i = 0; i < kKernelCount; ++i) {
+        const Kernel kernel = static_cast<Kernel>(i);
+        fp.median_ns[i] = measure_median(kernel, fp.sample_count);
+        if (progress != nullptr) {
+            progress(ctx, kernel_label(kernel), static_cast<float>(i + 1) / kKernelCount);
+        }
+    }
+    fp.duration_ns = monotonic_raw_ns() - start;
+    return fp;
+}
+
+const char* ratio_name(size_t index) {
+    return index < kRatioCount ? kRatios[index].name : "";
+}
+
+void ratios(const Fingerprint& fp, double* out) {
+    for (size_t i = 0; i < kRatioCount; ++i) {
+        const uint64_t num = fp.median_ns[static_cast<size_t>(kRatios[i].num)];
+        const uint64_t den = fp.median_ns[static_cast<size_t>(kRatios[i].den)];
+        out[i] = den > 0 ? static_cast<double>(num) / static_cast<double>(den) : 0.0;
+    }
+}
+
+namespace {
+
+void append_header(std::string& out, int sample_count, uint64_t duration_ns) {
+    out += "{\"success\":true,\"data\":{\"sample_count\":";
+    json::append_uint(out, static_cast<unsigned long long>(sample_count));
+    out += ",\"timer\":";
+    json::append_string(out, timer_name());
+    out += ",\"timer_resolution_ns\":";
+    json::append_double(out, timer_resolution_ns());
+    out += ",\"duration_us\":";
+    json::append_micros(out, duration_ns);
+}
+
+// ,"kernels_ns":{...},"ratios":{...}
+void append_medians(std::string& out, const Fingerprint& fp) {
+    out += ",\"kernels_ns\":{";
+    for (size_t i = 0; i < kKernelCount; ++i) {
+        if (i > 0) {
+            out.push_back(',');
+        }
+        json::append_string(out, kKernels[i].name);
+        out.push_back(':');
+        json::append_uint(out, fp.median_ns[i]);
+    }
+    out += "},\"ratios\":{";
+    double values[kRatioCount];
+    ratios(fp, values);
+    for (size_t i = 0; i < kRatioCount; ++i) {
+        if (i > 0) {
+            out.push_back(',');
+        }
+        json::append_string(out, kRatios[i].name);
+        out.push_back(':');
+        json::append_double(out, values[i]);
+    }
+    out.push_back('}');
+}
+
+}  // namespace
+
+std::string to_json(const Fingerprint& fp) {
+    std::string out;
+    append_header(out, fp.sample_count, fp.duration_ns);
+    append_medians(out, fp);
+    out += "}}";
+    return out;
+}
+
+// ----------------------------------------------------------------------------
+// Parallel collection
+// ----------------------------------------------------------------------------
+
+namespace {
+
+// Kernels whose working set spills out of a core's private caches. The L3 (or
+// DSU) and DRAM are shared by every cluster, so these run with no other kernel
+// running anywhere in the process; otherwise another cluster's threads evict
+// their lines and contend for bandwidth.
+bool uses_shared_cache(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::MemSeq1M:
+        case Kernel::MemRand1M:
+        case Kernel::MemCopy1M:
+        case Kernel::MemSeq4M:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool on_cluster(const cpu_topology::Cluster& cluster, int cpu) {
+    return std::find(cluster.cpus.begin(), cluster.cpus.end(), cpu) != cluster.cpus.end();
+}
+
+// Held exclusively by shared-cache kernels and shared by all others, across
+// every cluster's workers.
+std::shared_mutex g_cache_mu;
+
+struct ClusterRun {
+    ClusterFingerprint result;
+    std::atomic<size_t> next{0};
+    std::atomic<int> pinned{0};
+};
+
+struct ProgressState {
+    std::mutex mu;
+    Progress fn;
+    void* ctx;
+    size_t done = 0;
+    size_t total = 0;
+};
+
+void measure_on(ClusterRun& run_state, int worker_cpu, int sample_count,
+                ProgressState& progress, std::vector<Sample>& out) {
+    const cpu_topology::Cluster& cluster = run_state.result.cluster;
+    if (cpu_topology::pin_current_thread(cluster, worker_cpu)) {
+        run_state.pinned.fetch_add(1, std::memory_order_relaxed);
+    }
+    const bool known_cpus = !cluster.cpus.empty();
+
+    for (;;) {
+        const size_t index = run_state.next.fetch_add(1, std::memory_order_relaxed);
+        if (index >= kKernelCount) {
+            break;
+        }
+        const Kernel kernel = static_cast<Kernel>(index);
+        std::vector<uint64_t> kept;
+        std::vector<uint64_t> all;
+        kept.reserve(static_cast<size_t>(sample_count));
+        all.reserve(static_cast<size_t>(sample_count));
+        out.reserve(out.size() + static_cast<size_t>(sample_count));
+        {
+            std::unique_lock<std::shared_mutex> exclusive(g_cache_mu, std::defer_lock);
+            std::shared_lock<std::shared_mutex> shared(g_cache_mu, std::defer_lock);
+            if (uses_shared_cache(kernel)) {
+                exclusive.lock();
+            } else {
+                shared.lock();
+            }
+            run(kernel);
+            for (int i = 0; i < sample_count; ++i) {
+                const int cpu_before = cpu_topology::current_cpu();
+                const uint64_t ns = time_once(kernel);
+                const int cpu_after = cpu_topology::current_cpu();
+                const bool migrated = known_cpus &&
+                    (cpu_before != cpu_after || !on_cluster(cluster, cpu_after));
+                out.push_back(Sample{kernel, cluster.id, cpu_after, ns, migrated});
+                all.push_back(ns);
+                if (!migrated) {
+                    kept.push_back(ns);
+                }
+            }
+        }
+        // Samples taken off the cluster are dropped unless that is all of them.
+        run_state.result.fp.median_ns[index] = kept.empty() ? median(all) : median(kept);
+
+        std::lock_guard<std::mutex> lock(progress.mu);
+        ++progress.done;
+        if (progress.fn != nullptr) {
+            progress.fn(progress.ctx, kernel_label(kernel),
+                        static_cast<float>(progress.done) / static_cast<float>(progress.total));
+        }
+    }
+}
+
+}  // namespace
+
+ParallelFingerprint collect_parallel(int sample_count, int threads_per_cluster,
+                                     Progress progress, void* ctx) {
+    ParallelFingerprint fp;
+    fp.sample_count = sample_count < 1 ? 1 : sample_count;
+    if (threads_per_cluster < 1) {
+        threads_per_cluster = kDefaultThreadsPerCluster;
+    }
+    buffers();
+
+    const std::vector<cpu_topology::Cluster> clusters = cpu_topology::clusters();
+    std::vector<std::unique_ptr<ClusterRun>> runs;
+    for (const cpu_topology::Cluster& cluster : clusters) {
+        auto run_state = std::make_unique<ClusterRun>();
+        run_state->result.cluster = cluster;
+        run_state->result.fp.sample_count = fp.sample_count;
+        run_state->result.threads = std::min(threads_per_cluster, std::max(1, cluster.cpu_count));
+        runs.push_back(std::move(run_state));
+    }
+
+    ProgressState progress_state;
+    progress_state.fn = progress;
+    progress_state.ctx = ctx;
+    progress_state.total = kKernelCount * runs.size();
+
+    const uint64_t start = monotonic_raw_ns();
+    size_t thread_count = 0;
+    for (const auto& run_state : runs) {
+        thread_count += static_cast<size_t>(run_state->result.threads);
+    }
+    // One sample list per thread, merged after the join.
+    std::vector<std::vector<Sample>> samples(thread_count);
+    std::vector<std::thread> workers;
+    size_t slot = 0;
+    for (auto& run_state : runs) {
+        const cpu_topology::Cluster& cluster = run_state->result.cluster;
+        for (int t = 0; t < run_state->result.threads; ++t) {
+            const int cpu = static_cast<size_t>(t) < cluster.cpus.size() ? cluster.cpus[static_cast<size_t>(t)] : -1;
+            workers.emplace_back(measure_on, std::ref(*run_state), cpu, fp.sample_count,
+                                 std::ref(progress_state), std::ref(samples[slot++]));
+        }
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    fp.duration_ns = monotonic_raw_ns() - start;
+
+    for (auto& run_state : runs) {
+        ClusterFingerprint& result = run_state->result;
+        result.pinned = run_state->pinned.load(std::memory_order_relaxed) == result.threads;
+        result.fp.duration_ns = fp.duration_ns;
+        fp.clusters.push_back(result);
+    }
+    for (std::vector<Sample>& worker_samples : samples) {
+        for (const Sample& sample : worker_samples) {
+            ClusterFingerprint& cluster = fp.clusters[static_cast<size_t>(sample.cluster)];
+            ++cluster.samples;
+            if (sample.migrated) {
+                ++cluster.migrated_samples;
+            }
+        }
+        fp.samples.insert(fp.samples.end(), worker_samples.begin(), worker_samples.end());
+    }
+    return fp;
+}
+
+std::string to_json(const ParallelFingerprint& fp) {
+    std::string out;
+    append_header(out, fp.sample_count, fp.duration_ns);
+    if (!fp.clusters.empty()) {
+        append_medians(out, fp.clusters.front().fp);
+    }
+    out += ",\"clusters\":[";
+    for (size_t i = 0; i < fp.clusters.size(); ++i) {
+        const ClusterFingerprint& c = fp.clusters[i];
+        if (i > 0) {
+            out.push_back(',');
+        }
+        out += "{\"id\":";
+        json::append_uint(out, static_cast<unsigned long long>(c.cluster.id));
+        out += ",\"cpus\":[";
+        for (size_t j = 0; j < c.cluster.cpus.size(); ++j) {
+            if (j > 0) {
+                out.push_back(',');
+            }
+            json::append_uint(out, static_cast<unsigned long long>(c.cluster.cpus[j]));
+        }
+        out += "],\"cpu_count\":";
+        json::append_uint(out, static_cast<unsigned long long>(c.cluster.cpu_count));
+        out += ",\"max_freq_khz\":";
+        json::append_uint(out, c.cluster.max_freq_khz);
+        out += ",\"threads\":";
+        json::append_uint(out, static_cast<unsigned long long>(c.threads));
+        out += ",\"pinned\":";
+        out += c.pinned ? "true" : "false";
+        out += ",\"samples\":";
+        json::append_uint(out, c.samples);
+        out += ",\"migrated_samples\":";
+        json::append_uint(out, c.migrated_samples);
+        append_medians(out, c.fp);
+        out.push_back('}');
+    }
+    out += "]}}";
+    return out;
+}
+
+}  // namespace etfa
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" char* estream_etfa_collect(int sample_count, EstreamEtfaProgressCallback progress, void* ctx) {
+    if (sample_count < 1) {
+        return nullptr;
+    }
+    const estream::etfa::Fingerprint fp = estream::etfa::collect(sample_count, progress, ctx);
+    return estream::to_c_string(estream::etfa::to_json(fp));
+}
+
+extern "C" char* estream_etfa_collect_parallel(int sample_count, int threads_per_cluster,
+                                               EstreamEtfaProgressCallback progress, void* ctx) {
+    if (sample_count < 1) {
+        return nullptr;
+    }
+    const estream::etfa::ParallelFingerprint fp =
+        estream::etfa::collect_parallel(sample_count, threads_per_cluster, progress, ctx);
+    return estream::to_c_string(estream::etfa::to_json(fp));
+}
@@ -0,0 +1,152 @@
+/**
+ * ETFA timing fingerprint kernels.
+ *
+ * One set of CPU micro-kernels shared by the iOS and Android ETFA modules.
+ * Each kernel has a fixed instruction mix: loop-carried values pass through
+ * an optimizer barrier every iteration so the compiler cannot fold, hoist
+ * or vectorize the loop differently from one build to the next, and the
+ * timed region is fenced by compiler barriers on both sides. Kernels are
+ * timed with the hardware counter (CNTVCT_EL0 on arm64, the TSC on x86-64)
+ * and reported in nanoseconds.
+ *
+ * GPU kernels (shader compile / program link) stay in the platform modules.
+ */
+
+#ifndef ESTREAM_ETFA_H
+#define ESTREAM_ETFA_H
+
+#include "cpu_topology.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace estream {
+namespace etfa {
+
+enum class Kernel {
+    MemSeq1M = 0,
+    MemRand1M,
+    MemCopy1M,
+    IntMul64,
+    FloatMul,
+    VectorDot,
+    MatrixOp,
+    MemSeq4K,
+    MemSeq64K,
+    MemSeq4M,
+    MemRand4K,
+    MemRand64K,
+    IntMul32,
+    IntDiv32,
+    IntDiv64,
+    AddChain,
+    AddParallel,
+    Bitwise,
+    Count,
+};
+
+constexpr size_t kKernelCount = static_cast<size_t>(Kernel::Count);
+
+/// Stable identifier ("mem_seq_1m").
+const char* kernel_name(Kernel kernel);
+
+/// Progress label shown by the app ("Memory Sequential").
+const char* kernel_label(Kernel kernel);
+
+/// Run `kernel` once, untimed. Returns its checksum, which depends only on
+/// the kernel (the random permutation is seeded), so it can be compared
+/// against a reference implementation.
+uint64_t run(Kernel kernel);
+
+/// Run `kernel` once and return its duration in nanoseconds.
+uint64_t time_once(Kernel kernel);
+
+/// One untimed warm-up run, then the median of `samples` timed runs (ns).
+uint64_t measure_median(Kernel kernel, int samples);
+
+/// Counter behind the timings: "cntvct", "tsc" or "monotonic_raw".
+const char* timer_name();
+
+/// Counter period in nanoseconds (its resolution).
+double timer_resolution_ns();
+
+/// Called after each kernel with its label and the fraction done.
+using Progress = void (*)(void* ctx, const char* label, float progress);
+
+/// Median time per kernel and the CPU ratios of the fingerprint.
+struct Fingerprint {
+    int sample_count = 0;
+    uint64_t median_ns[kKernelCount] = {};
+    uint64_t duration_ns = 0;
+};
+
+Fingerprint collect(int sample_count, Progress progress, void* ctx);
+
+/// Number of CPU ratios (r5..r25 of the app's stable ratio vector).
+constexpr size_t kRatioCount = 14;
+
+/// Ratio names, in stableRatios order ("r5_mem_seq_to_rand").
+const char* ratio_name(size_t index);
+
+/// Compute the CPU ratios of `fp` into `out[kRatioCount]`.
+void ratios(const Fingerprint& fp, double* out);
+
+/// {"success":true,"data":{"sample_count",...,"kernels_ns":{..},"ratios":{..}}}
+std::string to_json(const Fingerprint& fp);
+
+// ----------------------------------------------------------------------------
+// Parallel collection
+// ----------------------------------------------------------------------------
+
+/// Measuring threads per cluster when the caller passes 0.
+constexpr int kDefaultThreadsPerCluster = 2;
+
+/// One timed run, tagged with where it ran.
+struct Sample {
+    Kernel kernel;
+    /// Cluster the measuring thread was assigned to.
+    int cluster;
+    /// CPU after the run, -1 if unknown.
+    int cpu;
+    uint64_t ns;
+    /// The thread left its CPU or cluster during the run; excluded from the
+    /// median unless every sample of the kernel was.
+    bool migrated;
+};
+
+struct ClusterFingerprint {
+    cpu_topology::Cluster cluster;
+    int threads = 0;
+    /// Every thread of the cluster was pinned (never on Apple).
+    bool pinned = false;
+    uint64_t samples = 0;
+    uint64_t migrated_samples = 0;
+    Fingerprint fp;
+};
+
+struct ParallelFingerprint {
+    int sample_count = 0;
+    uint64_t duration_ns = 0;
+    /// Fastest cluster first.
+    std::vector<ClusterFingerprint> clusters;
+    std::vector<Sample> samples;
+};
+
+/// Measure every kernel on every cluster at once. Each cluster gets up to
+/// `threads_per_cluster` threads (0: the default), each pinned to its own
+/// CPU, which take kernels from a shared list; kernels with a working set
+/// beyond the private caches run alone within their cluster. `progress` is
+/// called from the measuring threads, one call at a time.
+ParallelFingerprint collect_parallel(int sample_count, int threads_per_cluster,
+                                     Progress progress, void* ctx);
+
+/// As to_json(Fingerprint), with the fastest cluster's medians and ratios at
+/// the top level and every cluster under "clusters".
+std::string to_json(const ParallelFingerprint& fp);
+
+}  // namespace etfa
+}  // namespace estream
+
+#endif /* ESTREAM_ETFA_H */
@@ -0,0 +1,573 @@
+#include "etfa_index.h"
+
+#include "estream_app_native.h"
+#include "ffi_util.h"
+#include "json.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace estream {
+namespace etfa {
+
+namespace {
+
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+double code_distance(uint32_t sum, uint32_t common) {
+    return common == 0 ? kInfinity : static_cast<double>(sum) / (common * kStepsPerOctave);
+}
+
+// Deterministic seeding for k-means++.
+struct Rng {
+    uint64_t state = 0x2545F4914F6CDD1Dull;
+    uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+    double unit() { return static_cast<double>(next() >> 11) / 9007199254740992.0; }
+};
+
+}  // namespace
+
+Code quantize(const double* ratios, size_t count) {
+    Code code;
+    for (size_t i = 0; i < kCodeDims; ++i) {
+        const double r = i < count ? ratios[i] : 0.0;
+        if (!(r > 0.0) || !std::isfinite(r)) {
+            code.value[i] = 128;
+            code.mask[i] = 0;
+            continue;
+        }
+        const double steps = std::round(std::log2(r) * kStepsPerOctave);
+        const double clamped = std::max(-127.0, std::min(127.0, steps));
+        code.value[i] = static_cast<uint8_t>(static_cast<int>(clamped) + 128);
+        code.mask[i] = 0xFF;
+    }
+    return code;
+}
+
+uint32_t l1(const Code& a, const Code& b, uint32_t* common) {
+#if defined(__SSE2__)
+    const __m128i va = _mm_load_si128(reinterpret_cast<const __m128i*>(a.value));
+    const __m128i vb = _mm_load_si128(reinterpret_cast<const __m128i*>(b.value));
+    const __m128i mask = _mm_and_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(a.mask)),
+                                       _mm_load_si128(reinterpret_cast<const __m128i*>(b.mask)));
+    const __m128i zero = _mm_setzero_si128();
+    // |a - b| on unsigned bytes, then PSADBW sums each 8-byte half.
+    const __m128i diff = _mm_and_si128(_mm_sub_epi8(_mm_max_epu8(va, vb), _mm_min_epu8(va, vb)), mask);
+    const __m128i sad = _mm_sad_epu8(diff, zero);
+    const __m128i dims = _mm_sad_epu8(_mm_and_si128(mask, _mm_set1_epi8(1)), zero);
+    *common = static_cast<uint32_t>(_mm_cvtsi128_si32(dims) + _mm_extract_epi16(dims, 4));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(sad) + _mm_extract_epi16(sad, 4));
+#elif defined(__aarch64__)
+    const uint8x16_t mask = vandq_u8(vld1q_u8(a.mask), vld1q_u8(b.mask));
+    const uint8x16_t diff = vandq_u8(vabdq_u8(vld1q_u8(a.value), vld1q_u8(b.value)), mask);
+    *common = vaddvq_u8(vandq_u8(mask, vdupq_n_u8(1)));
+    return vaddlvq_u8(diff);
+#else
+    uint32_t sum = 0;
+    uint32_t dims = 0;
+    for (size_t i = 0; i < kCodeDims; ++i) {
+        if ((a.mask[i] & b.mask[i]) != 0) {
+            sum += static_cast<uint32_t>(std::abs(int{a.value[i]} - int{b.value[i]}));
+            ++dims;
+        }
+    }
+    *common = dims;
+    return sum;
+#endif
+}
+
+double distance(const Code& a, const Code& b) {
+    uint32_t common = 0;
+    const uint32_t sum = l1(a, b, &common);
+    return code_distance(sum, common);
+}
+
+std::string to_hex(const Code& code) {
+    static const char kDigits[] = "0123456789abcdef";
+    std::string out(kCodeDims * 2, '0');
+    for (size_t i = 0; i < kCodeDims; ++i) {
+        if (code.mask[i] == 0) {
+            continue;
+        }
+        out[2 * i] = kDigits[code.value[i] >> 4];
+        out[2 * i + 1] = kDigits[code.value[i] & 0xF];
+    }
+    return out;
+}
+
+// ----------------------------------------------------------------------------
+// SimilarityIndex
+// ----------------------------------------------------------------------------
+
+void SimilarityIndex::add(const std::string& id, const Code& code) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = slots_.find(id);
+    if (it != slots_.end()) {
+        codes_[it->second] = code;
+        if (!centroids_.empty()) {
+            assignment_[it->second] = static_cast<uint32_t>(nearest_list(code));
+            rebuild_lists();
+        }
+        return;
+    }
+    const uint32_t slot = static_cast<uint32_t>(codes_.size());
+    codes_.push_back(code);
+    ids_.push_back(id);
+    slots_.emplace(id, slot);
+    const size_t list = centroids_.empty() ? 0 : nearest_list(code);
+    assignment_.push_back(static_cast<uint32_t>(list));
+    if (!centroids_.empty()) {
+        lists_[list].push_back(slot);
+    }
+}
+
+bool SimilarityIndex::remove(const std::string& id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = slots_.find(id);
+    if (it == slots_.end()) {
+        return false;
+    }
+    const uint32_t slot = it->second;
+    const uint32_t last = static_cast<uint32_t>(codes_.size() - 1);
+    slots_.erase(it);
+    if (slot != last) {
+        codes_[slot] = codes_[last];
+        ids_[slot] = std::move(ids_[last]);
+        assignment_[slot] = assignment_[last];
+        slots_[ids_[slot]] = slot;
+    }
+    codes_.pop_back();
+    ids_.pop_back();
+    assignment_.pop_back();
+    if (!centroids_.empty()) {
+        rebuild_lists();
+    }
+    return true;
+}
+
+size_t SimilarityIndex::size() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return codes_.size();
+}
+
+size_t SimilarityIndex::lists() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return centroids_.size();
+}
+
+size_t SimilarityIndex::nearest_list(const Code& code) const {
+    size_t best = 0;
+    double best_distance = kInfinity;
+    for (size_t c = 0; c < centroids_.size(); ++c) {
+        const double d = distance(code, centroids_[c]);
+        if (d < best_distance) {
+            best_distance = d;
+            best = c;
+        }
+    }
+    return best;
+}
+
+void SimilarityIndex::rebuild_lists() {
+    lists_.assign(centroids_.size(), {});
+    for (size_t i = 0; i < assignment_.size(); ++i) {
+        lists_[assignment_[i]].push_back(static_cast<uint32_t>(i));
+    }
+}
+
+void SimilarityIndex::train(size_t lists, int iterations) {
+    std::lock_guard<std::mutex> lock(mu_);
+    const size_t n = codes_.size();
+    lists = std::min(lists, n);
+    if (lists <= 1) {
+        centroids_.clear();
+        lists_.clear();
+        std::fill(assignment_.begin(), assignment_.end(), 0);
+        return;
+    }
+
+    // k-means++: each further seed is drawn with probability proportional to
+    // its squared distance from the nearest seed so far.
+    Rng rng;
+    centroids_.clear();
+    centroids_.push_back(codes_[rng.next() % n]);
+    std::vector<double> nearest(n, kInfinity);
+    while (centroids_.size() < lists) {
+        double total = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            const double d = std::min(distance(codes_[i], centroids_.back()), 8.0);
+            nearest[i] = std::min(nearest[i], d * d);
+            total += nearest[i];
+        }
+        size_t pick = rng.next() % n;
+        if (total > 0.0) {
+            double target = rng.unit() * total;
+            for (size_t i = 0; i < n; ++i) {
+                target -= nearest[i];
+                if (target <= 0.0) {
+                    pick = i;
+                    break;
+                }
+            }
+        }
+        centroids_.push_back(codes_[pick]);
+    }
+
+    // Lloyd rounds: per-dimension mean of the members that measured it.
+    assignment_.assign(n, 0);
+    for (int round = 0; round < std::max(1, iterations); ++round) {
+        bool changed = false;
+        for (size_t i = 0; i < n; ++i) {
+            const uint32_t list = static_cast<uint32_t>(nearest_list(codes_[i]));
+            changed = changed || list != assignment_[i] || round == 0;
+            assignment_[i] = list;
+        }
+        if (!changed) {
+            break;
+        }
+        std::vector<int64_t> sums(lists * kCodeDims, 0);
+        std::vector<uint32_t> counts(lists * kCodeDims, 0);
+        for (size_t i = 0; i < n; ++i) {
+            const size_t base = assignment_[i] * kCodeDims;
+            for (size_t d = 0; d < kCodeDims; ++d) {
+                if (codes_[i].mask[d] != 0) {
+                    sums[base + d] += codes_[i].value[d];
+                    ++counts[base + d];
+                }
+            }
+        }
+        for (size_t c = 0; c < lists; ++c) {
+            for (size_t d = 0; d < kCodeDims; ++d) {
+                const uint32_t count = counts[c * kCodeDims + d];
+                if (count == 0) {
+                    continue;  // Keep the previous value of an empty cell.
+                }
+                const int64_t sum = sums[c * kCodeDims + d];
+                centroids_[c].value[d] = static_cast<uint8_t>((sum + count / 2) / count);
+                centroids_[c].mask[d] = 0xFF;
+            }
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        assignment_[i] = static_cast<uint32_t>(nearest_list(codes_[i]));
+    }
+    rebuild_lists();
+}
+
+std::vector<Match> SimilarityIndex::search(const Code& query, size_t k, size_t probes, size_t* scanned) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    using Candidate = std::pair<double, uint32_t>;
+    std::vector<Candidate> heap;  // Max-heap of the best k so far.
+    heap.reserve(k + 1);
+    size_t compared = 0;
+
+    auto consider = [&](uint32_t slot) {
+        ++compared;
+        const double d = distance(query, codes_[slot]);
+        if (d == kInfinity) {
+            return;
+        }
+        if (heap.size() < k) {
+            heap.emplace_back(d, slot);
+            std::push_heap(heap.begin(), heap.end());
+        } else if (k > 0 && d < heap.front().first) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = Candidate(d, slot);
+            std::push_heap(heap.begin(), heap.end());
+        }
+    };
+
+    if (centroids_.empty()) {
+        for (uint32_t slot = 0; slot < codes_.size(); ++slot) {
+            consider(slot);
+        }
+    } else {
+        std::vector<Candidate> cells;
+        cells.reserve(centroids_.size());
+        for (size_t c = 0; c < centroids_.size(); ++c) {
+            cells.emplace_back(distance(query, centroids_[c]), static_cast<uint32_t>(c));
+        }
+        const size_t probe_count = probes == 0 ? cells.size() : std::min(probes, cells.size());
+        std::partial_sort(cells.begin(), cells.begin() + static_cast<std::ptrdiff_t>(probe_count), cells.end());
+        for (size_t p = 0; p < probe_count; ++p) {
+            for (uint32_t slot : lists_[cells[p].second]) {
+                consider(slot);
+            }
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end());
+    std::vector<Match> out;
+    out.reserve(heap.size());
+    for (const Candidate& c : heap) {
+        out.push_back(Match{ids_[c.second], c.first});
+    }
+    if (scanned != nullptr) {
+        *scanned = compared;
+    }
+    return out;
+}
+
+// Snapshot layout (little-endian): "EFIX", u32 version, u32 count,
+// u32 lists, lists x Code, then per reference: u32 cell, u16 id length,
+// id bytes, Code.
+namespace {
+
+constexpr char kMagic[4] = {'E', 'F', 'I', 'X'};
+constexpr uint32_t kVersion = 1;
+
+template <typename T>
+bool write_raw(FILE* f, const T& value) {
+    return std::fwrite(&value, sizeof(T), 1, f) == 1;
+}
+
+template <typename T>
+bool read_raw(FILE* f, T& value) {
+    return std::fread(&value, sizeof(T), 1, f) == 1;
+}
+
+}  // namespace
+
+bool SimilarityIndex::save(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    const std::string tmp = path + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (f == nullptr) {
+        return false;
+    }
+    bool ok = std::fwrite(kMagic, 1, sizeof(kMagic), f) == sizeof(kMagic) &&
+              write_raw(f, kVersion) &&
+              write_raw(f, static_cast<uint32_t>(codes_.size())) &&
+              write_raw(f, static_cast<uint32_t>(centroids_.size()));
+    for (size_t c = 0; ok && c < centroids_.size(); ++c) {
+        ok = write_raw(f, centroids_[c]);
+    }
+    for (size_t i = 0; ok && i < codes_.size(); ++i) {
+        const uint16_t len = static_cast<uint16_t>(std::min<size_t>(ids_[i].size(), 0xFFFF));
+        ok = write_raw(f, assignment_[i]) && write_raw(f, len) &&
+             std::fwrite(ids_[i].data(), 1, len, f) == len && write_raw(f, codes_[i]);
+    }
+    ok = std::fclose(f) == 0 && ok;
+    // Replace the previous snapshot only once the new one is complete.
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SimilarityIndex::load(const std::string& path) {
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    char magic[4];
+    uint32_t version = 0;
+    uint32_t count = 0;
+    uint32_t list_count = 0;
+    bool ok = std::fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+              std::memcmp(magic, kMagic, sizeof(kMagic)) == 0 &&
+              read_raw(f, version) && version == kVersion &&
+              read_raw(f, count) && read_raw(f, list_count) && list_count <= count;
+
+    std::vector<Code> centroids(ok ? list_count : 0);
+    for (size_t c = 0; ok && c < centroids.size(); ++c) {
+        ok = read_raw(f, centroids[c]);
+    }
+    std::vector<Code> codes;
+    std::vector<std::string> ids;
+    std::vector<uint32_t> assignment;
+    std::unordered_map<std::string, uint32_t> slots;
+    for (uint32_t i = 0; ok && i < count; ++i) {
+        uint32_t cell = 0;
+        uint16_t len = 0;
+        ok = read_raw(f, cell) && read_raw(f, len) && (list_count == 0 ? cell == 0 : cell < list_count);
+        std::string id(ok ? len : 0, '\0');
+        Code code;
+        ok = ok && std::fread(&id[0], 1, len, f) == len && read_raw(f, code) &&
+             slots.emplace(id, i).second;
+        if (ok) {
+            codes.push_back(code);
+            ids.push_back(std::move(id));
+            assignment.push_back(cell);
+        }
+    }
+    std::fclose(f);
+    if (!ok) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mu_);
+    codes_ = std::move(codes);
+    ids_ = std::move(ids);
+    slots_ = std::move(slots);
+    assignment_ = std::move(assignment);
+    centroids_ = std::move(centroids);
+    if (centroids_.empty()) {
+        lists_.clear();
+    } else {
+        rebuild_lists();
+    }
+    return true;
+}
+
+}  // namespace etfa
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+namespace {
+
+struct Registry {
+    std::mutex mu;
+    long next = 1;
+    std::unordered_map<long, std::shared_ptr<estream::etfa::SimilarityIndex>> indexes;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+long register_index(std::shared_ptr<estream::etfa::SimilarityIndex> index) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    const long handle = r.next++;
+    r.indexes.emplace(handle, std::move(index));
+    return handle;
+}
+
+std::shared_ptr<estream::etfa::SimilarityIndex> find_index(long handle) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    auto it = r.indexes.find(handle);
+    return it != r.indexes.end() ? it->second : nullptr;
+}
+
+}  // namespace
+
+extern "C" long estream_etfa_index_create(void) {
+    return register_index(std::make_shared<estream::etfa::SimilarityIndex>());
+}
+
+extern "C" long estream_etfa_index_load(const char* path) {
+    if (path == nullptr) {
+        return -1;
+    }
+    auto index = std::make_shared<estream::etfa::SimilarityIndex>();
+    if (!index->load(path)) {
+        return -1;
+    }
+    return register_index(std::move(index));
+}
+
+extern "C" int estream_etfa_index_save(long index, const char* path) {
+    auto target = find_index(index);
+    if (target == nullptr || path == nullptr) {
+        return -1;
+    }
+    return target->save(path) ? 0 : -1;
+}
+
+extern "C" void estream_etfa_index_destroy(long index) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    r.indexes.erase(index);
+}
+
+extern "C" int estream_etfa_index_add(long index, const char* id, const double* ratios, int count) {
+    auto target = find_index(index);
+    if (target == nullptr || id == nullptr || ratios == nullptr || count < 0) {
+        return -1;
+    }
+    target->add(id, estream::etfa::quantize(ratios, static_cast<size_t>(count)));
+    return 0;
+}
+
+extern "C" int estream_etfa_index_remove(long index, const char* id) {
+    auto target = find_index(index);
+    if (target == nullptr || id == nullptr) {
+        return -1;
+    }
+    return target->remove(id) ? 0 : -1;
+}
+
+extern "C" int estream_etfa_index_size(long index) {
+    auto target = find_index(index);
+    return target != nullptr ? static_cast<int>(target->size()) : -1;
+}
+
+extern "C" int estream_etfa_index_train(long index, int lists, int iterations) {
+    auto target = find_index(index);
+    if (target == nullptr || lists < 0) {
+        return -1;
+    }
+    size_t cells = static_cast<size_t>(lists);
+    if (cells == 0) {
+        // Exact search stays cheap up to a few thousand references.
+        const size_t n = target->size();
+        cells = n >= estream::etfa::kAutoTrainThreshold
+                    ? static_cast<size_t>(std::lround(std::sqrt(static_cast<double>(n))))
+                    : 1;
+    }
+    target->train(cells, iterations > 0 ? iterations : 10);
+    return 0;
+}
+
+extern "C" char* estream_etfa_index_search(long index, const double* ratios, int count, int k, int probes) {
+    auto target = find_index(index);
+    if (target == nullptr || ratios == nullptr || count < 0 || k < 1 || probes < 0) {
+        return nullptr;
+    }
+    size_t scanned = 0;
+    const std::vector<estream::etfa::Match> matches = target->search(
+        estream::etfa::quantize(ratios, static_cast<size_t>(count)), static_cast<size_t>(k),
+        static_cast<size_t>(probes), &scanned);
+
+    std::string out = "{\"success\":true,\"data\":{\"size\":";
+    estream::json::append_uint(out, target->size());
+    out += ",\"lists\":";
+    estream::json::append_uint(out, target->lists());
+    out += ",\"scanned\":";
+    estream::json::append_uint(out, scanned);
+    out += ",\"matches\":[";
+    for (size_t i = 0; i < matches.size(); ++i) {
+        if (i > 0) {
+            out.push_back(',');
+        }
+        out += "{\"id\":";
+        estream::json::append_string(out, matches[i].id.c_str());
+        out += ",\"distance\":";
+        estream::json::append_double(out, matches[i].distance);
+        out += ",\"similarity\":";
+        estream::json::append_double(out, std::max(0.0, 1.0 - matches[i].distance));
+        out.push_back('}');
+    }
+    out += "]}}";
+    return estream::to_c_string(out);
+}
+
+extern "C" char* estream_etfa_fingerprint_code(const double* ratios, int count) {
+    if (ratios == nullptr || count < 0) {
+        return nullptr;
+    }
+    return estream::to_c_string(estream::etfa::to_hex(estream::etfa::quantize(ratios, static_cast<size_t>(count))));
+}
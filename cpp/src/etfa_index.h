@@ -0,0 +1,108 @@
+/**
+ * Similarity index over ETFA ratio vectors.
+ *
+ * A fingerprint's 16 stable ratios are stored as one 16-byte code: each
+ * ratio's log2 in 1/16-octave steps, so a ratio that moves by a few percent
+ * moves its byte by one step instead of changing the whole fingerprint.
+ * Distance is the mean absolute step difference over the ratios both sides
+ * have (a ratio of 0 means "not measured"), computed 16 bytes at a time
+ * with SSE2 PSADBW or NEON UABD/UADDLV.
+ *
+ * Search is exact until train() is called; afterwards it is an inverted
+ * file (k-means coarse cells, scanning the `probes` cells nearest to the
+ * query), which trades recall for a scan of roughly probes/lists of the set.
+ */
+
+#ifndef ESTREAM_ETFA_INDEX_H
+#define ESTREAM_ETFA_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace estream {
+namespace etfa {
+
+/// Ratios per code (r5..r29 of the app's stableRatios).
+constexpr size_t kCodeDims = 16;
+
+/// Steps per octave of a code byte.
+constexpr double kStepsPerOctave = 16.0;
+
+/// References before estream_etfa_index_train(.., 0, ..) switches from exact
+/// search to sqrt(n) cells.
+constexpr size_t kAutoTrainThreshold = 1024;
+
+struct alignas(16) Code {
+    /// log2(ratio) * kStepsPerOctave, clamped to [-127, 127], biased by 128.
+    uint8_t value[kCodeDims];
+    /// 0xFF where the ratio was measured, 0 where it was 0 or not finite.
+    uint8_t mask[kCodeDims];
+};
+
+/// Quantize `count` ratios (missing trailing ones count as unmeasured).
+Code quantize(const double* ratios, size_t count);
+
+/// Sum of absolute step differences over the dimensions both codes have;
+/// `common` receives that dimension count.
+uint32_t l1(const Code& a, const Code& b, uint32_t* common);
+
+/// Mean absolute log2 difference (octaves) over the common dimensions;
+/// infinity if there are none.
+double distance(const Code& a, const Code& b);
+
+/// 32 hex digits of the code values (unmeasured ratios as "00").
+std::string to_hex(const Code& code);
+
+struct Match {
+    std::string id;
+    double distance;
+};
+
+class SimilarityIndex {
+public:
+    /// Add or replace the reference `id`.
+    void add(const std::string& id, const Code& code);
+
+    /// Remove `id`; false if absent.
+    bool remove(const std::string& id);
+
+    size_t size() const;
+
+    /// Partition the references into `lists` k-means cells (Lloyd's
+    /// algorithm, `iterations` rounds, seeded k-means++ initialisation).
+    /// lists <= 1 returns to exact search.
+    void train(size_t lists, int iterations = 10);
+
+    /// Cells after train(); 0 when searching exhaustively.
+    size_t lists() const;
+
+    /// Up to `k` nearest references, closest first. `probes` cells are
+    /// scanned (0: all). `scanned`, if set, receives the number of
+    /// references compared.
+    std::vector<Match> search(const Code& query, size_t k, size_t probes, size_t* scanned = nullptr) const;
+
+    /// Binary snapshot: codes, ids and the trained cells.
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+private:
+    size_t nearest_list(const Code& code) const;
+    void rebuild_lists();
+
+    mutable std::mutex mu_;
+    std::vector<Code> codes_;
+    std::vector<std::string> ids_;
+    std::unordered_map<std::string, uint32_t> slots_;
+    std::vector<uint32_t> assignment_;
+    std::vector<Code> centroids_;
+    std::vector<std::vector<uint32_t>> lists_;
+};
+
+}  // namespace etfa
+}  // namespace estream
+
+#endif /* ESTREAM_ETFA_INDEX_H */
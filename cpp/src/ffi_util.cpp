@@ -0,0 +1,7 @@
+#include "estream_app_native.h"
+
+#include <cstdlib>
+
+extern "C" void estream_app_free_string(char* s) {
+    std::free(s);
+}
@@ -0,0 +1,34 @@
+/**
+ * Helpers for the extern "C" surface in estream_app_native.h.
+ */
+
+#ifndef ESTREAM_FFI_UTIL_H
+#define ESTREAM_FFI_UTIL_H
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace estream {
+
+/// Copy `s` into a malloc'd C string for estream_app_free_string().
+inline char* to_c_string(const std::string& s) {
+    char* out = static_cast<char*>(std::malloc(s.size() + 1));
+    if (out == nullptr) {
+        return nullptr;
+    }
+    std::memcpy(out, s.data(), s.size());
+    out[s.size()] = '\0';
+    return out;
+}
+
+/// True if a core result reports failure: NULL, or JSON carrying an
+/// "error" member or "success":false.
+inline bool ffi_failed(const char* result) {
+    return result == nullptr || std::strstr(result, "\"error\"") != nullptr ||
+           std::strstr(result, "\"success\":false") != nullptr;
+}
+
+}  // namespace estream
+
+#endif /* ESTREAM_FFI_UTIL_H */
@@ -0,0 +1,402 @@
+#include "fountain.h"
+
+#include "estream_app_native.h"
+#include "ffi_util.h"
+#include "json.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace estream {
+namespace fountain {
+
+namespace {
+
+std::array<uint32_t, 256> make_crc_table() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1u) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}
+
+// splitmix64 seeding xoshiro256**.
+class Rng {
+public:
+    explicit Rng(uint64_t seed) {
+        for (uint64_t& s : s_) {
+            seed += 0x9e3779b97f4a7c15ull;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            s = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next() {
+        const uint64_t result = rotl(s_[1] * 5, 7) * 9;
+        const uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return result;
+    }
+
+    /// Uniform in [0, n).
+    uint64_t below(uint64_t n) { return next() % n; }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t s_[4];
+};
+
+void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
+}
+
+uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t{p[0]} << 24) | (uint32_t{p[1]} << 16) | (uint32_t{p[2]} << 8) | uint32_t{p[3]};
+}
+
+void xor_into(uint8_t* dst, const uint8_t* src, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] ^= src[i];
+    }
+}
+
+size_t fragment_bytes_for(uint32_t message_len, uint32_t fragment_count) {
+    return std::max<size_t>(1, (size_t{message_len} + fragment_count - 1) / fragment_count);
+}
+
+}  // namespace
+
+uint32_t crc32(const uint8_t* data, size_t len) {
+    static const std::array<uint32_t, 256> table = make_crc_table();
+    uint32_t c = 0xffffffffu;
+    for (size_t i = 0; i < len; ++i) {
+        c = table[(c ^ data[i]) & 0xffu] ^ (c >> 8);
+    }
+    return c ^ 0xffffffffu;
+}
+
+std::vector<uint32_t> part_fragments(uint32_t seq, uint32_t fragment_count, uint32_t checksum) {
+    if (fragment_count == 0) {
+        return {};
+    }
+    if (seq >= 1 && seq <= fragment_count) {
+        return {seq - 1};
+    }
+    // Each fragment with probability 1/2, at least one.
+    Rng rng((uint64_t{seq} << 32) | checksum);
+    std::vector<uint32_t> fragments;
+    uint64_t bits = 0;
+    for (uint32_t i = 0; i < fragment_count; ++i) {
+        if (i % 64 == 0) {
+            bits = rng.next();
+        }
+        if ((bits >> (i % 64)) & 1u) {
+            fragments.push_back(i);
+        }
+    }
+    if (fragments.empty()) {
+        fragments.push_back(static_cast<uint32_t>(rng.below(fragment_count)));
+    }
+    return fragments;
+}
+
+// ============================================================================
+// Encoder
+// ============================================================================
+
+Encoder::Encoder(const uint8_t* message, size_t len, size_t fragment_bytes) {
+    fragment_bytes = std::max<size_t>(1, fragment_bytes);
+    fragment_count_ = static_cast<uint32_t>(std::max<size_t>(1, (len + fragment_bytes - 1) / fragment_bytes));
+    message_len_ = static_cast<uint32_t>(len);
+    // Even out the fragments so the last one is not mostly padding.
+    fragment_bytes_ = fragment_bytes_for(message_len_, fragment_count_);
+    checksum_ = crc32(message, len);
+    data_.assign(size_t{fragment_count_} * fragment_bytes_, 0);
+    if (len > 0) {
+        std::memcpy(data_.data(), message, len);
+    }
+}
+
+void Encoder::part(uint32_t seq, uint8_t* out) const {
+    out[0] = kPartVersion;
+    put_u32(out + 1, seq);
+    put_u32(out + 5, fragment_count_);
+    put_u32(out + 9, message_len_);
+    put_u32(out + 13, checksum_);
+    uint8_t* payload = out + kHeaderBytes;
+    std::memset(payload, 0, fragment_bytes_);
+    for (uint32_t f : part_fragments(seq, fragment_count_, checksum_)) {
+        xor_into(payload, data_.data() + size_t{f} * fragment_bytes_, fragment_bytes_);
+    }
+}
+
+// ============================================================================
+// Decoder
+// ============================================================================
+
+Receive Decoder::receive(const uint8_t* part, size_t len) {
+    if (part == nullptr || len <= kHeaderBytes || part[0] != kPartVersion) {
+        return Receive::Invalid;
+    }
+    const uint32_t seq = get_u32(part + 1);
+    const uint32_t fragment_count = get_u32(part + 5);
+    const uint32_t message_len = get_u32(part + 9);
+    const uint32_t checksum = get_u32(part + 13);
+    const size_t fragment_bytes = len - kHeaderBytes;
+    if (seq == 0 || fragment_count == 0 || fragment_count > kMaxFragments ||
+        fragment_bytes != fragment_bytes_for(message_len, fragment_count)) {
+        return Receive::Invalid;
+    }
+    if (fragment_count_ == 0) {
+        fragment_count_ = fragment_count;
+        fragment_bytes_ = fragment_bytes;
+        message_len_ = message_len;
+        checksum_ = checksum;
+        words_ = (fragment_count + 63) / 64;
+        bits_.assign(fragment_count * words_, 0);
+        data_.assign(fragment_count * fragment_bytes, 0);
+        has_row_.assign(fragment_count, false);
+        scratch_bits_.assign(words_, 0);
+        scratch_data_.assign(fragment_bytes, 0);
+    } else if (fragment_count != fragment_count_ || message_len != message_len_ || checksum != checksum_) {
+        return Receive::Invalid;
+    }
+    if (complete_ || corrupt_) {
+        return complete_ ? Receive::Complete : Receive::Pending;
+    }
+    ++parts_received_;
+    if (!seen_.insert(seq).second) {
+        ++parts_duplicate_;
+        return Receive::Pending;
+    }
+
+    uint64_t* row = scratch_bits_.data();
+    uint8_t* data = scratch_data_.data();
+    std::fill(scratch_bits_.begin(), scratch_bits_.end(), 0);
+    for (uint32_t f : part_fragments(seq, fragment_count_, checksum_)) {
+        row[f / 64] |= uint64_t{1} << (f % 64);
+    }
+    std::memcpy(data, part + kHeaderBytes, fragment_bytes_);
+    // Clear the lowest set bit while a kept row leads with it; the first
+    // column without one makes this part a new row. Kept rows only have
+    // bits at or above their own column, so this terminates.
+    for (size_t w = 0; w < words_; ++w) {
+        while (row[w] != 0) {
+            const size_t c = w * 64 + static_cast<size_t>(__builtin_ctzll(row[w]));
+            if (!has_row_[c]) {
+                std::memcpy(bits_.data() + c * words_, row, words_ * sizeof(uint64_t));
+                std::memcpy(data_.data() + c * fragment_bytes_, data, fragment_bytes_);
+                has_row_[c] = true;
+                if (++rank_ == fragment_count_) {
+                    finish();
+                }
+                return complete_ ? Receive::Complete : Receive::Pending;
+            }
+            const uint64_t* kept = bits_.data() + c * words_;
+            for (size_t v = w; v < words_; ++v) {
+                row[v] ^= kept[v];
+            }
+            xor_into(data, data_.data() + c * fragment_bytes_, fragment_bytes_);
+        }
+    }
+    // Nothing new: a combination of parts already kept.
+    return Receive::Pending;
+}
+
+void Decoder::finish() {
+    // Back substitution: row c becomes fragment c once every higher column
+    // is solved.
+    for (size_t c = fragment_count_; c-- > 0;) {
+        const uint64_t* row = bits_.data() + c * words_;
+        uint8_t* data = data_.data() + c * fragment_bytes_;
+        for (size_t w = c / 64; w < words_; ++w) {
+            uint64_t bits = row[w];
+            if (w == c / 64) {
+                bits &= ~uint64_t{0} << (c % 64) << 1;
+            }
+            while (bits != 0) {
+                const size_t j = w * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+                bits &= bits - 1;
+                xor_into(data, data_.data() + j * fragment_bytes_, fragment_bytes_);
+            }
+        }
+    }
+    if (crc32(data_.data(), message_len_) != checksum_) {
+        corrupt_ = true;
+        return;
+    }
+    message_.assign(data_.begin(), data_.begin() + message_len_);
+    complete_ = true;
+}
+
+void Decoder::reset() {
+    *this = Decoder();
+}
+
+double Decoder::progress() const {
+    return fragment_count_ == 0 ? 0.0 : static_cast<double>(rank_) / fragment_count_;
+}
+
+std::string to_json(const Decoder& decoder) {
+    std::string out;
+    out.reserve(224);
+    out += "{\"success\":true,\"data\":{\"complete\":";
+    out += decoder.complete() ? "true" : "false";
+    out += ",\"corrupt\":";
+    out += decoder.corrupt() ? "true" : "false";
+    out += ",\"fragments\":";
+    json::append_uint(out, decoder.fragment_count());
+    out += ",\"recovered\":";
+    json::append_uint(out, decoder.recovered());
+    out += ",\"parts_received\":";
+    json::append_uint(out, decoder.parts_received());
+    out += ",\"parts_duplicate\":";
+    json::append_uint(out, decoder.parts_duplicate());
+    out += ",\"progress\":";
+    json::append_double(out, decoder.progress());
+    out += ",\"message_len\":";
+    json::append_uint(out, decoder.complete() ? decoder.message().size() : 0);
+    out += "}}";
+    return out;
+}
+
+}  // namespace fountain
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+namespace {
+
+// A decoder is fed from the camera thread and polled from JS.
+struct Session {
+    std::mutex mu;
+    estream::fountain::Decoder decoder;
+};
+
+struct Registry {
+    std::mutex mu;
+    long next = 1;
+    std::unordered_map<long, std::shared_ptr<Session>> sessions;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+std::shared_ptr<Session> find_session(long handle) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    auto it = r.sessions.find(handle);
+    return it != r.sessions.end() ? it->second : nullptr;
+}
+
+}  // namespace
+
+extern "C" int estream_fountain_encode(const uint8_t* message, int len, int fragment_bytes, uint32_t first_seq,
+                                       int count, uint8_t* out, int capacity) {
+    if ((message == nullptr && len > 0) || len < 0 || fragment_bytes <= 0 || first_seq == 0 || count < 0 ||
+        uint64_t{first_seq} + static_cast<uint64_t>(count) > 0x100000000ull) {
+        return -1;
+    }
+    const size_t k = (static_cast<size_t>(len) + fragment_bytes - 1) / static_cast<size_t>(fragment_bytes);
+    if (k > estream::fountain::kMaxFragments) {
+        return -1;
+    }
+    estream::fountain::Encoder encoder(message, static_cast<size_t>(len), static_cast<size_t>(fragment_bytes));
+    const size_t part_bytes = encoder.part_bytes();
+    if (count > 0) {
+        if (out == nullptr || capacity < 0 || static_cast<size_t>(capacity) / part_bytes < static_cast<size_t>(count)) {
+            return -1;
+        }
+        for (int i = 0; i < count; ++i) {
+            encoder.part(first_seq + static_cast<uint32_t>(i), out + static_cast<size_t>(i) * part_bytes);
+        }
+    }
+    return static_cast<int>(part_bytes);
+}
+
+extern "C" long estream_fountain_decoder_create(void) {
+    auto session = std::make_shared<Session>();
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    const long handle = r.next++;
+    r.sessions.emplace(handle, std::move(session));
+    return handle;
+}
+
+extern "C" void estream_fountain_decoder_destroy(long decoder) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    r.sessions.erase(decoder);
+}
+
+extern "C" int estream_fountain_decoder_receive(long decoder, const uint8_t* part, int len) {
+    auto session = find_session(decoder);
+    if (session == nullptr || part == nullptr || len <= 0) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mu);
+    return static_cast<int>(session->decoder.receive(part, static_cast<size_t>(len)));
+}
+
+extern "C" char* estream_fountain_decoder_status_json(long decoder) {
+    auto session = find_session(decoder);
+    if (session == nullptr) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(session->mu);
+    return estream::to_c_string(estream::fountain::to_json(session->decoder));
+}
+
+extern "C" int estream_fountain_decoder_message(long decoder, uint8_t* out, int capacity) {
+    auto session = find_session(decoder);
+    if (session == nullptr) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mu);
+    const estream::fountain::Decoder& d = session->decoder;
+    if (!d.complete()) {
+        return -1;
+    }
+    const size_t n = d.message().size();
+    if (out != nullptr) {
+        if (capacity < 0 || static_cast<size_t>(capacity) < n) {
+            return -1;
+        }
+        if (n > 0) {
+            std::memcpy(out, d.message().data(), n);
+        }
+    }
+    return static_cast<int>(n);
+}
+
+extern "C" void estream_fountain_decoder_reset(long decoder) {
+    auto session = find_session(decoder);
+    if (session == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(session->mu);
+    session->decoder.reset();
+}
@@ -0,0 +1,138 @@
+/**
+ * Fountain-coded transport for animated QR codes.
+ *
+ * An ML-DSA-87 signature response does not fit one scannable QR code, so
+ * the message is split into K equal fragments and sent as an endless
+ * sequence of small parts, one per QR frame. Parts 1..K carry the fragments
+ * themselves. Every later part is the XOR of a pseudo-random half of the
+ * fragments, chosen from the part's sequence number so the receiver can
+ * rebuild the set. Any K independent parts reconstruct the message. Mixed
+ * parts are uniformly random combinations, so whatever frames were missed,
+ * two more parts than there are missing fragments complete the message
+ * with probability ~0.75, five with ~0.97. A scanner that misses frames
+ * keeps collecting instead of waiting for the cycle to come round again.
+ *
+ * Part layout (big-endian):
+ *
+ *   [0]      version (1)
+ *   [1..4]   sequence number, from 1
+ *   [5..8]   fragment count K
+ *   [9..12]  message length
+ *   [13..16] CRC-32 of the message
+ *   [17..]   fragment data, ceil(length / K) bytes (at least 1)
+ *
+ * Fragment sets are drawn with integer arithmetic only (xoshiro256**), so
+ * every platform derives the same set.
+ */
+
+#ifndef ESTREAM_FOUNTAIN_H
+#define ESTREAM_FOUNTAIN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace estream {
+namespace fountain {
+
+constexpr uint8_t kPartVersion = 1;
+constexpr size_t kHeaderBytes = 17;
+/// Fragment size when none is given: a part fits a version 10 QR code at
+/// error correction level M once base58-encoded.
+constexpr size_t kDefaultFragmentBytes = 120;
+/// Most fragments a message may be split into; decoding is O(K^2) per
+/// part.
+constexpr uint32_t kMaxFragments = 1024;
+
+/// CRC-32 (IEEE, as zlib).
+uint32_t crc32(const uint8_t* data, size_t len);
+
+/// Fragments XORed into part `seq` of a message of `fragment_count`
+/// fragments with CRC `checksum`, in increasing order.
+std::vector<uint32_t> part_fragments(uint32_t seq, uint32_t fragment_count, uint32_t checksum);
+
+class Encoder {
+public:
+    /// Split `message` into fragments of at most `fragment_bytes`.
+    Encoder(const uint8_t* message, size_t len, size_t fragment_bytes = kDefaultFragmentBytes);
+
+    uint32_t fragment_count() const { return fragment_count_; }
+    size_t fragment_bytes() const { return fragment_bytes_; }
+    size_t part_bytes() const { return kHeaderBytes + fragment_bytes_; }
+
+    /// Write part `seq` (from 1) to `out`, part_bytes() long.
+    void part(uint32_t seq, uint8_t* out) const;
+
+private:
+    uint32_t fragment_count_ = 1;
+    size_t fragment_bytes_ = 1;
+    uint32_t message_len_ = 0;
+    uint32_t checksum_ = 0;
+    /// The message, zero-padded to fragment_count_ * fragment_bytes_.
+    std::vector<uint8_t> data_;
+};
+
+enum class Receive {
+    /// Malformed, or from a different message than the parts before it.
+    Invalid = -1,
+    Pending = 0,
+    Complete = 1,
+};
+
+/// Online Gaussian elimination over GF(2): each part is reduced against the
+/// ones kept so far and kept if it adds information. Once K are kept, back
+/// substitution yields the fragments.
+class Decoder {
+public:
+    Receive receive(const uint8_t* part, size_t len);
+
+    /// Forget everything, e.g. to scan another message.
+    void reset();
+
+    bool complete() const { return complete_; }
+    /// True if the parts decoded to data that failed the CRC.
+    bool corrupt() const { return corrupt_; }
+    uint32_t fragment_count() const { return fragment_count_; }
+    /// Fragments' worth of information collected: independent parts kept.
+    uint32_t recovered() const { return rank_; }
+    uint64_t parts_received() const { return parts_received_; }
+    uint64_t parts_duplicate() const { return parts_duplicate_; }
+    /// recovered() / fragment_count() (0 before the first part).
+    double progress() const;
+    /// The decoded message once complete().
+    const std::vector<uint8_t>& message() const { return message_; }
+
+private:
+    void finish();
+
+    uint32_t fragment_count_ = 0;
+    size_t fragment_bytes_ = 0;
+    uint32_t message_len_ = 0;
+    uint32_t checksum_ = 0;
+    size_t words_ = 0;
+    /// Row c, if has_row_[c], has its lowest set bit at column c. Bits
+    /// (words_ per row) say which fragments its data (fragment_bytes_) XORs.
+    std::vector<uint64_t> bits_;
+    std::vector<uint8_t> data_;
+    std::vector<bool> has_row_;
+    std::vector<uint64_t> scratch_bits_;
+    std::vector<uint8_t> scratch_data_;
+    std::unordered_set<uint32_t> seen_;
+    std::vector<uint8_t> message_;
+    uint32_t rank_ = 0;
+    uint64_t parts_received_ = 0;
+    uint64_t parts_duplicate_ = 0;
+    bool complete_ = false;
+    bool corrupt_ = false;
+};
+
+/// {"success":true,"data":{"complete","corrupt","fragments","recovered",
+/// "parts_received","parts_duplicate","progress","message_len"}}
+std::string to_json(const Decoder& decoder);
+
+}  // namespace fountain
+}  // namespace estream
+
+#endif /* ESTREAM_FOUNTAIN_H */
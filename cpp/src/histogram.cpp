@@ -0,0 +1,111 @@
+#include "histogram.h"
+
+#include <cmath>
+
+namespace estream {
+
+namespace {
+
+uint32_t msb(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63u - static_cast<uint32_t>(__builtin_clzll(v));
+#else
+    uint32_t n = 0;
+    while (v >>= 1) {
+        ++n;
+    }
+    return n;
+#endif
+}
+
+}  // namespace
+
+size_t Histogram::bucket_index(uint64_t value) {
+    if (value < (uint64_t{1} << kSubBits)) {
+        return static_cast<size_t>(value);
+    }
+    const uint32_t shift = msb(value) - (kSubBits - 1);
+    return (shift + 1) * 64 + static_cast<size_t>(value >> shift) - 64;
+}
+
+uint64_t Histogram::bucket_lower(size_t index) {
+    if (index < (size_t{1} << kSubBits)) {
+        return index;
+    }
+    const uint32_t shift = static_cast<uint32_t>(index / 64) - 1;
+    return static_cast<uint64_t>(index % 64 + 64) << shift;
+}
+
+uint64_t Histogram::bucket_upper(size_t index) {
+    if (index < (size_t{1} << kSubBits)) {
+        return index;
+    }
+    const uint32_t shift = static_cast<uint32_t>(index / 64) - 1;
+    return bucket_lower(index) + (uint64_t{1} << shift) - 1;
+}
+
+void Histogram::merge(const Histogram& other) {
+    const uint64_t n = other.count();
+    if (n == 0) {
+        return;
+    }
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        const uint64_t c = other.counts_[i].load(std::memory_order_relaxed);
+        if (c != 0) {
+            bump(counts_[i], c);
+        }
+    }
+    bump(count_, n);
+    bump(sum_, other.sum());
+    lower_to(min_, other.min_.load(std::memory_order_relaxed));
+    raise_to(max_, other.max());
+}
+
+void Histogram::reset() {
+    for (auto& c : counts_) {
+        c.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(UINT64_MAX, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::percentile(double q) const {
+    // Sum the buckets rather than trusting count_: a concurrent recorder
+    // may have bumped one but not yet the other.
+    uint64_t total = 0;
+    for (const auto& c : counts_) {
+        total += c.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+    if (q < 0.0) {
+        q = 0.0;
+    } else if (q > 1.0) {
+        q = 1.0;
+    }
+    uint64_t target = static_cast<uint64_t>(std::ceil(q * static_cast<double>(total)));
+    if (target == 0) {
+        target = 1;
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += counts_[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            uint64_t v = bucket_upper(i);
+            if (v > max()) {
+                v = max();
+            }
+            if (v < min()) {
+                v = min();
+            }
+            return v;
+        }
+    }
+    return max();
+}
+
+}  // namespace estream
@@ -0,0 +1,98 @@
+/**
+ * High-dynamic-range latency histogram.
+ *
+ * Log-linear buckets: values below 128 ns are exact, every power of two
+ * above is split into 64 buckets, so any recorded value is reported within
+ * 1.6% up to ~2.4 hours (larger values are clamped). Counters are relaxed
+ * atomic read-modify-writes, so one thread can record while another reads,
+ * merges or resets without a reset being undone by a record in flight.
+ */
+
+#ifndef ESTREAM_HISTOGRAM_H
+#define ESTREAM_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace estream {
+
+class Histogram {
+public:
+    static constexpr uint32_t kSubBits = 7;
+    static constexpr uint32_t kMaxBits = 43;
+    static constexpr size_t kBucketCount = (kMaxBits - kSubBits + 1) * 64 + 64;
+    static constexpr uint64_t kMaxValue = (uint64_t{1} << kMaxBits) - 1;
+
+    Histogram() { reset(); }
+    Histogram(const Histogram& other) { reset(); merge(other); }
+    Histogram& operator=(const Histogram& other) {
+        if (this != &other) {
+            reset();
+            merge(other);
+        }
+        return *this;
+    }
+
+    /// Record one value. Only one thread may record into an instance.
+    void record(uint64_t value) {
+        if (value > kMaxValue) {
+            value = kMaxValue;
+        }
+        bump(counts_[bucket_index(value)], 1);
+        bump(count_, 1);
+        bump(sum_, value);
+        lower_to(min_, value);
+        raise_to(max_, value);
+    }
+
+    /// Add `other` into this histogram. `other` may be recording.
+    void merge(const Histogram& other);
+
+    /// Clear all counters. Safe against a concurrent recorder: a record
+    /// that overlaps the reset is either cleared or kept, never the counts
+    /// from before it.
+    void reset();
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t min() const { return count() ? min_.load(std::memory_order_relaxed) : 0; }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+    uint64_t mean() const { return count() ? sum() / count() : 0; }
+
+    /// Value at quantile q in [0, 1] (upper edge of its bucket, clamped
+    /// to [min, max]). 0 when empty.
+    uint64_t percentile(double q) const;
+
+    static size_t bucket_index(uint64_t value);
+    static uint64_t bucket_lower(size_t index);
+    static uint64_t bucket_upper(size_t index);
+
+private:
+    static void bump(std::atomic<uint64_t>& counter, uint64_t n) {
+        counter.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    static void lower_to(std::atomic<uint64_t>& bound, uint64_t value) {
+        uint64_t current = bound.load(std::memory_order_relaxed);
+        while (value < current && !bound.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    static void raise_to(std::atomic<uint64_t>& bound, uint64_t value) {
+        uint64_t current = bound.load(std::memory_order_relaxed);
+        while (value > current && !bound.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::array<std::atomic<uint64_t>, kBucketCount> counts_;
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> min_;
+    std::atomic<uint64_t> max_;
+};
+
+}  // namespace estream
+
+#endif /* ESTREAM_HISTOGRAM_H */
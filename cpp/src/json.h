@@ -0,0 +1,63 @@
+/**
+ * Minimal JSON output helpers shared by the exporters.
+ */
+
+#ifndef ESTREAM_JSON_H
+#define ESTREAM_JSON_H
+
+#include <cstdio>
+#include <string>
+
+namespace estream {
+namespace json {
+
+/// Append `s` as a quoted JSON string literal.
+inline void append_string(std::string& out, const char* s) {
+    out.push_back('"');
+    for (; *s; ++s) {
+        const unsigned char c = static_cast<unsigned char>(*s);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out.push_back(static_cast<char>(c));
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+/// Append an unsigned integer.
+inline void append_uint(std::string& out, unsigned long long v) {
+    out += std::to_string(v);
+}
+
+/// Append a finite double with 9 significant digits (non-finite as 0).
+inline void append_double(std::string& out, double v) {
+    if (!(v == v) || v > 1e300 || v < -1e300) {
+        v = 0.0;
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", v);
+    out += buf;
+}
+
+/// Append a nanosecond value as fractional microseconds ("12.345").
+inline void append_micros(std::string& out, unsigned long long ns) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%llu.%03llu", ns / 1000, ns % 1000);
+    out += buf;
+}
+
+}  // namespace json
+}  // namespace estream
+
+#endif /* ESTREAM_JSON_H */
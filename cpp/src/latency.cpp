@@ -0,0 +1,197 @@
+#include "latency.h"
+
+#include "ffi_util.h"
+#include "json.h"
+#include "runtime_stats.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace estream {
+namespace latency {
+
+namespace {
+
+const char* const kFnNames[ESTREAM_FN_COUNT] = {
+    "estream_initialize",
+    "estream_connect",
+    "estream_dispose",
+    "estream_generate_device_keys",
+    "estream_generate_prekey_bundle",
+    "estream_x3dh_initiate",
+    "estream_x3dh_accept",
+    "estream_ratchet_init_sender",
+    "estream_ratchet_init_receiver",
+    "estream_ratchet_encrypt",
+    "estream_ratchet_decrypt",
+    "estream_ratchet_dispose",
+    "estream_h3_connect",
+    "estream_h3_post",
+    "estream_h3_get",
+    "estream_h3_mint_identity_nft",
+    "estream_h3_is_connected",
+    "estream_h3_disconnect",
+    "estream_version",
+};
+
+struct ThreadHistograms;
+
+// Live per-thread tables plus the merged histograms of exited threads.
+struct Registry {
+    ProfiledMutex mu{"latency_registry"};
+    std::vector<ThreadHistograms*> live;
+    Histogram retired[ESTREAM_FN_COUNT];
+};
+
+Registry& registry() {
+    // Leaked so thread_local destructors running at process exit can
+    // still unregister.
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+struct ThreadHistograms {
+    std::unique_ptr<Histogram> by_fn[ESTREAM_FN_COUNT];
+
+    ThreadHistograms() {
+        Registry& reg = registry();
+        std::lock_guard<ProfiledMutex> lock(reg.mu);
+        reg.live.push_back(this);
+    }
+
+    ~ThreadHistograms() {
+        Registry& reg = registry();
+        std::lock_guard<ProfiledMutex> lock(reg.mu);
+        for (int i = 0; i < ESTREAM_FN_COUNT; ++i) {
+            if (by_fn[i]) {
+                reg.retired[i].merge(*by_fn[i]);
+            }
+        }
+        for (auto it = reg.live.begin(); it != reg.live.end(); ++it) {
+            if (*it == this) {
+                reg.live.erase(it);
+                break;
+            }
+        }
+    }
+};
+
+thread_local ThreadHistograms t_histograms;
+
+}  // namespace
+
+void record(EstreamFnId fn, uint64_t ns) {
+    std::unique_ptr<Histogram>& h = t_histograms.by_fn[fn];
+    if (!h) {
+        // Publish under the registry lock so a concurrent snapshot never
+        // sees a half-constructed histogram.
+        auto fresh = std::make_unique<Histogram>();
+        Registry& reg = registry();
+        std::lock_guard<ProfiledMutex> lock(reg.mu);
+        h = std::move(fresh);
+    }
+    h->record(ns);
+}
+
+Histogram merged(EstreamFnId fn) {
+    Registry& reg = registry();
+    std::lock_guard<ProfiledMutex> lock(reg.mu);
+    Histogram out = reg.retired[fn];
+    for (const ThreadHistograms* t : reg.live) {
+        if (t->by_fn[fn]) {
+            out.merge(*t->by_fn[fn]);
+        }
+    }
+    return out;
+}
+
+void reset() {
+    Registry& reg = registry();
+    std::lock_guard<ProfiledMutex> lock(reg.mu);
+    for (int i = 0; i < ESTREAM_FN_COUNT; ++i) {
+        reg.retired[i].reset();
+        for (ThreadHistograms* t : reg.live) {
+            if (t->by_fn[i]) {
+                t->by_fn[i]->reset();
+            }
+        }
+    }
+}
+
+const char* fn_name(int fn) {
+    if (fn < 0 || fn >= ESTREAM_FN_COUNT) {
+        return nullptr;
+    }
+    return kFnNames[fn];
+}
+
+std::string report_json() {
+    std::string out = "{\"success\":true,\"data\":{";
+    bool first = true;
+    for (int i = 0; i < ESTREAM_FN_COUNT; ++i) {
+        const Histogram h = merged(static_cast<EstreamFnId>(i));
+        if (h.count() == 0) {
+            continue;
+        }
+        if (!first) {
+            out.push_back(',');
+        }
+        first = false;
+        json::append_string(out, kFnNames[i]);
+        out += ":{\"count\":";
+        json::append_uint(out, h.count());
+        out += ",\"min_us\":";
+        json::append_micros(out, h.min());
+        out += ",\"mean_us\":";
+        json::append_micros(out, h.mean());
+        out += ",\"p50_us\":";
+        json::append_micros(out, h.percentile(0.50));
+        out += ",\"p90_us\":";
+        json::append_micros(out, h.percentile(0.90));
+        out += ",\"p99_us\":";
+        json::append_micros(out, h.percentile(0.99));
+        out += ",\"p999_us\":";
+        json::append_micros(out, h.percentile(0.999));
+        out += ",\"max_us\":";
+        json::append_micros(out, h.max());
+        out.push_back('}');
+    }
+    out += "}}";
+    return out;
+}
+
+}  // namespace latency
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" int estream_latency_snapshot(EstreamLatencySnapshot* out, int fn_id) {
+    if (out == nullptr || fn_id < 0 || fn_id >= ESTREAM_FN_COUNT) {
+        return -1;
+    }
+    const estream::Histogram h = estream::latency::merged(static_cast<EstreamFnId>(fn_id));
+    out->count = h.count();
+    out->min_ns = h.min();
+    out->max_ns = h.max();
+    out->mean_ns = h.mean();
+    out->p50_ns = h.percentile(0.50);
+    out->p90_ns = h.percentile(0.90);
+    out->p99_ns = h.percentile(0.99);
+    out->p999_ns = h.percentile(0.999);
+    return 0;
+}
+
+extern "C" const char* estream_fn_name(int fn_id) {
+    return estream::latency::fn_name(fn_id);
+}
+
+extern "C" void estream_latency_reset(void) {
+    estream::latency::reset();
+}
+
+extern "C" char* estream_latency_report(void) {
+    return estream::to_c_string(estream::latency::report_json());
+}
@@ -0,0 +1,40 @@
+/**
+ * Per-entry-point latency recording.
+ *
+ * Each thread that calls into the core records into its own Histogram per
+ * function (allocated on first use). Snapshots merge the live per-thread
+ * histograms with those of threads that have already exited.
+ */
+
+#ifndef ESTREAM_LATENCY_H
+#define ESTREAM_LATENCY_H
+
+#include "estream_app_native.h"
+#include "histogram.h"
+
+#include <cstdint>
+#include <string>
+
+namespace estream {
+namespace latency {
+
+/// Record one call of `fn` that took `ns` nanoseconds.
+void record(EstreamFnId fn, uint64_t ns);
+
+/// Merged histogram for `fn` across all threads.
+Histogram merged(EstreamFnId fn);
+
+/// Zero every histogram.
+void reset();
+
+/// estream_native.h name of `fn` ("estream_ratchet_encrypt"), or nullptr.
+const char* fn_name(int fn);
+
+/// JSON report of all functions with at least one call:
+/// {"success":true,"data":{"estream_ratchet_encrypt":{"count":..,"p50_us":..},...}}
+std::string report_json();
+
+}  // namespace latency
+}  // namespace estream
+
+#endif /* ESTREAM_LATENCY_H */
@@ -0,0 +1,503 @@
+#include "lattice_raster.h"
+
+#include "estream_app_native.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace estream {
+namespace lattice {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kCenter = kCanvasSize / 2.0;
+// TimingRing radii and stroke widths.
+constexpr double kRingInner = 130.0;
+constexpr double kRingOuter = 145.0;
+constexpr double kRingWidth = 2.0;
+constexpr double kMarkerWidth = 3.0;
+constexpr int kMarkers = 8;
+// Hexagon: circumradius and stroke width; getHexCenters spacing.
+constexpr double kHexRadius = 16.0;
+constexpr double kHexStroke = 1.0;
+constexpr double kHexSpacing = 18.0 * 1.8;
+// Particle halo and core radii.
+constexpr double kHaloRadius = 8.0;
+constexpr double kCoreRadius = 4.0;
+// Fully covered runs shorter than this are blended with the edges around
+// them rather than split off.
+constexpr int kMinSolid = 16;
+
+// x / 255 rounded, exact for x <= 255 * 255.
+inline uint32_t div255(uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+inline uint8_t to_byte(double v) {
+    return static_cast<uint8_t>(std::lround(std::min(1.0, std::max(0.0, v)) * 255.0));
+}
+
+Pixel premultiplied(double r, double g, double b, double alpha) {
+    const uint32_t a = to_byte(alpha);
+    return div255(to_byte(r) * a) | div255(to_byte(g) * a) << 8 | div255(to_byte(b) * a) << 16 | a << 24;
+}
+
+double hue_channel(double p, double q, double t) {
+    t -= std::floor(t);
+    if (t < 1.0 / 6.0) return p + (q - p) * 6.0 * t;
+    if (t < 1.0 / 2.0) return q;
+    if (t < 2.0 / 3.0) return p + (q - p) * (2.0 / 3.0 - t) * 6.0;
+    return p;
+}
+
+inline double clamp01(double v) {
+    return std::min(1.0, std::max(0.0, v));
+}
+
+// Anti-aliased coverage of the pixel centered at distance `d` from the
+// middle of a stroke `width` wide. Thinner than a pixel, the stroke fades.
+inline double stroke(double d, double width) {
+    return clamp01(std::min(width, width / 2.0 + 0.5 - std::fabs(d)));
+}
+
+// Signed distance to a pointy-top hexagon of circumradius r (negative
+// inside); exact along the edges, slightly rounded past the corners.
+inline double hexagon(double dx, double dy, double r) {
+    const double ax = std::fabs(dx);
+    const double ay = std::fabs(dy);
+    const double apothem = r * 0.86602540378443865;
+    return std::max(ax, 0.5 * ax + 0.86602540378443865 * ay) - apothem;
+}
+
+// div255 on the two 16-bit halves of x at once.
+inline uint32_t div255x2(uint32_t x) {
+    x += 0x00800080u;
+    return ((x + ((x >> 8) & 0x00ff00ffu)) >> 8) & 0x00ff00ffu;
+}
+
+// One pixel, red/blue and green/alpha as two pairs of 16-bit lanes.
+inline Pixel blend1(Pixel dst, Pixel color, uint32_t m) {
+    const uint32_t rb = div255x2((color & 0x00ff00ffu) * m);
+    const uint32_t ga = div255x2(((color >> 8) & 0x00ff00ffu) * m);
+    const uint32_t inv = 255 - (ga >> 16);
+    const uint32_t out_rb = rb + div255x2((dst & 0x00ff00ffu) * inv);
+    const uint32_t out_ga = ga + div255x2(((dst >> 8) & 0x00ff00ffu) * inv);
+    return out_rb | out_ga << 8;
+}
+
+#if defined(__SSE2__)
+inline __m128i div255x8(__m128i x) {
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Alpha of each of two 16-bit pixels, broadcast to its four lanes.
+inline __m128i alpha16(__m128i v) {
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xFF), 0xFF);
+}
+
+// src + dst * (255 - src alpha) on two unpacked pixels.
+inline __m128i over16(__m128i src, __m128i dst) {
+    const __m128i inv = _mm_sub_epi16(_mm_set1_epi16(255), alpha16(src));
+    return _mm_add_epi16(src, div255x8(_mm_mullo_epi16(dst, inv)));
+}
+#elif defined(__aarch64__)
+inline uint8x8_t div255x8(uint16x8_t x) {
+    return vraddhn_u16(x, vrshrq_n_u16(x, 8));
+}
+
+// src + dst * (255 - src alpha) on four pixels.
+inline uint8x16_t over(uint8x16_t src, uint8x16_t dst) {
+    static const uint8_t kAlpha[16] = {3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15};
+    const uint8x16_t inv = vmvnq_u8(vqtbl1q_u8(src, vld1q_u8(kAlpha)));
+    const uint8x8_t lo = div255x8(vmull_u8(vget_low_u8(dst), vget_low_u8(inv)));
+    const uint8x8_t hi = div255x8(vmull_u8(vget_high_u8(dst), vget_high_u8(inv)));
+    return vaddq_u8(src, vcombine_u8(lo, hi));
+}
+#endif
+
+}  // namespace
+
+Pixel hsla(double hue, double saturation, double lightness, double alpha) {
+    const double h = hue / 360.0;
+    const double s = clamp01(saturation);
+    const double l = clamp01(lightness);
+    const double q = l < 0.5 ? l * (1.0 + s) : l + s - l * s;
+    const double p = 2.0 * l - q;
+    return premultiplied(hue_channel(p, q, h + 1.0 / 3.0), hue_channel(p, q, h), hue_channel(p, q, h - 1.0 / 3.0),
+                         alpha);
+}
+
+Pixel rgb(uint32_t color, double alpha) {
+    return premultiplied(((color >> 16) & 255) / 255.0, ((color >> 8) & 255) / 255.0, (color & 255) / 255.0, alpha);
+}
+
+void blend_span(Pixel* dst, const uint8_t* coverage, size_t n, Pixel color) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i color16 = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(color)), zero);
+    for (; i + 4 <= n; i += 4) {
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i src_lo = color16;
+        __m128i src_hi = color16;
+        if (coverage != nullptr) {
+            uint32_t m4;
+            std::memcpy(&m4, coverage + i, sizeof(m4));
+            __m128i m = _mm_cvtsi32_si128(static_cast<int>(m4));
+            m = _mm_unpacklo_epi8(m, m);
+            m = _mm_unpacklo_epi16(m, m);
+            src_lo = div255x8(_mm_mullo_epi16(color16, _mm_unpacklo_epi8(m, zero)));
+            src_hi = div255x8(_mm_mullo_epi16(color16, _mm_unpackhi_epi8(m, zero)));
+        }
+        const __m128i lo = over16(src_lo, _mm_unpacklo_epi8(d, zero));
+        const __m128i hi = over16(src_hi, _mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#elif defined(__aarch64__)
+    static const uint8_t kSpread[16] = {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3};
+    const uint8x16_t color8 = vreinterpretq_u8_u32(vdupq_n_u32(color));
+    const uint8x16_t spread = vld1q_u8(kSpread);
+    for (; i + 4 <= n; i += 4) {
+        uint8_t* p = reinterpret_cast<uint8_t*>(dst + i);
+        uint8x16_t src = color8;
+        if (coverage != nullptr) {
+            uint32_t m4;
+            std::memcpy(&m4, coverage + i, sizeof(m4));
+            const uint8x16_t m = vqtbl1q_u8(vreinterpretq_u8_u32(vdupq_n_u32(m4)), spread);
+            src = vcombine_u8(div255x8(vmull_u8(vget_low_u8(color8), vget_low_u8(m))),
+                              div255x8(vmull_u8(vget_high_u8(color8), vget_high_u8(m))));
+        }
+        vst1q_u8(p, over(src, vld1q_u8(p)));
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = blend1(dst[i], color, coverage != nullptr ? coverage[i] : 255);
+    }
+}
+
+void fill_span(Pixel* dst, size_t n, Pixel color) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i v = _mm_set1_epi32(static_cast<int>(color));
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+    }
+#elif defined(__aarch64__)
+    const uint32x4_t v = vdupq_n_u32(color);
+    for (; i + 4 <= n; i += 4) {
+        vst1q_u32(dst + i, v);
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = color;
+    }
+}
+
+Rasterizer::Rasterizer(int size) : size_(std::max(1, size)), scale_(size_ / kCanvasSize) {
+    const double c = kCenter * scale_;
+
+    // Radial gradient #0f1520 -> #050810 over the r = 150 disc; clear
+    // outside it.
+    background_.resize(static_cast<size_t>(size_) * size_);
+    for (int y = 0; y < size_; ++y) {
+        for (int x = 0; x < size_; ++x) {
+            const double d = std::hypot(x + 0.5 - c, y + 0.5 - c);
+            const double t = std::min(1.0, d / c);
+            const double alpha = clamp01(c - d + 0.5);
+            background_[static_cast<size_t>(y) * size_ + x] =
+                premultiplied((0x0f + (0x05 - 0x0f) * t) / 255.0, (0x15 + (0x08 - 0x15) * t) / 255.0,
+                              (0x20 + (0x10 - 0x20) * t) / 255.0, alpha);
+        }
+    }
+
+    const double ring_width = kRingWidth * scale_;
+    const double outer = (kRingOuter + kRingWidth) * scale_;
+    rasterize(c - outer, c - outer, c + outer, c + outer,
+              [&](double px, double py) {
+                  const double d = std::hypot(px - c, py - c);
+                  return std::max(stroke(d - kRingInner * scale_, ring_width),
+                                  stroke(d - kRingOuter * scale_, ring_width));
+              },
+              ring_);
+
+    hex_fill_.resize(kHexCount);
+    hex_stroke_.resize(kHexCount);
+    const double r = kHexRadius * scale_;
+    const double w = kHexStroke * scale_;
+    const double reach = r + w / 2.0 + 1.0;
+    for (int i = 0, ring = 0, count = 1; i < kHexCount; ++i) {
+        // getHexCenters: the center, then ring k has 6k hexagons starting
+        // at the top.
+        const int k = i == 0 ? 0 : i - (3 * ring * (ring - 1) + 1);
+        const double angle = ring == 0 ? 0.0 : static_cast<double>(k) / count * 2.0 * kPi - kPi / 2.0;
+        const double hx = c + std::cos(angle) * ring * kHexSpacing * scale_;
+        const double hy = c + std::sin(angle) * ring * kHexSpacing * scale_;
+        rasterize(hx - reach, hy - reach, hx + reach, hy + reach,
+                  [&](double px, double py) { return clamp01(0.5 - hexagon(px - hx, py - hy, r)); }, hex_fill_[i]);
+        rasterize(hx - reach, hy - reach, hx + reach, hy + reach,
+                  [&](double px, double py) { return stroke(hexagon(px - hx, py - hy, r), w); }, hex_stroke_[i]);
+        if (i == 3 * ring * (ring + 1)) {
+            ++ring;
+            count = 6 * ring;
+        }
+    }
+}
+
+template <typename Coverage>
+void Rasterizer::rasterize(double x0, double y0, double x1, double y1, Coverage&& coverage, Mask& mask) const {
+    const int ix0 = std::max(0, static_cast<int>(std::floor(x0)));
+    const int iy0 = std::max(0, static_cast<int>(std::floor(y0)));
+    const int ix1 = std::min(size_, static_cast<int>(std::ceil(x1)));
+    const int iy1 = std::min(size_, static_cast<int>(std::ceil(y1)));
+    mask.x = ix0;
+    mask.y = iy0;
+    mask.width = std::max(0, ix1 - ix0);
+    mask.height = std::max(0, iy1 - iy0);
+    mask.coverage.resize(static_cast<size_t>(mask.width) * mask.height);
+    mask.rows.clear();
+    for (int row = 0; row < mask.height; ++row) {
+        uint8_t* cov = mask.coverage.data() + static_cast<size_t>(row) * mask.width;
+        for (int col = 0; col < mask.width; ++col) {
+            cov[col] = to_byte(coverage(ix0 + col + 0.5, iy0 + row + 0.5));
+        }
+        // One span per run of covered pixels (a ring row has two), with
+        // its longest fully covered stretch.
+        for (int col = 0; col < mask.width;) {
+            if (cov[col] == 0) {
+                ++col;
+                continue;
+            }
+            Span span;
+            span.begin = col;
+            while (col < mask.width && cov[col] != 0) {
+                if (cov[col] == 255) {
+                    int end = col;
+                    while (end < mask.width && cov[end] == 255) {
+                        ++end;
+                    }
+                    if (end - col > span.solid_end - span.solid_begin) {
+                        span.solid_begin = col;
+                        span.solid_end = end;
+                    }
+                    col = end;
+                } else {
+                    ++col;
+                }
+            }
+            span.end = col;
+            if (span.solid_end == span.solid_begin) {
+                span.solid_begin = span.solid_end = span.begin;
+            }
+            span.row = row;
+            mask.rows.push_back(span);
+        }
+    }
+}
+
+void Rasterizer::draw(const Mask& mask, Pixel color, uint8_t* out, size_t stride) const {
+    if ((color >> 24) == 0) {
+        return;
+    }
+    const bool opaque = (color >> 24) == 255;
+    for (const Span& span : mask.rows) {
+        Pixel* row = reinterpret_cast<Pixel*>(out + static_cast<size_t>(mask.y + span.row) * stride) + mask.x;
+        const uint8_t* cov = mask.coverage.data() + static_cast<size_t>(span.row) * mask.width;
+        if (span.solid_end - span.solid_begin < kMinSolid) {
+            // Edges and short runs: one pass over the coverage.
+            blend_span(row + span.begin, cov + span.begin, span.end - span.begin, color);
+            continue;
+        }
+        blend_span(row + span.begin, cov + span.begin, span.solid_begin - span.begin, color);
+        if (opaque) {
+            fill_span(row + span.solid_begin, span.solid_end - span.solid_begin, color);
+        } else {
+            blend_span(row + span.solid_begin, nullptr, span.solid_end - span.solid_begin, color);
+        }
+        blend_span(row + span.solid_end, cov + span.solid_end, span.end - span.solid_end, color);
+    }
+}
+
+void Rasterizer::render(const Scene& scene, double elapsed_ms, uint8_t* out, size_t stride) {
+    for (int y = 0; y < size_; ++y) {
+        std::memcpy(out + static_cast<size_t>(y) * stride, background_.data() + static_cast<size_t>(y) * size_,
+                    static_cast<size_t>(size_) * sizeof(Pixel));
+    }
+    const double t = elapsed_ms / 1000.0;
+    const double hue = std::fmod(scene.base_hue + std::fmod(elapsed_ms / 100.0, 360.0), 360.0);
+    const double c = kCenter * scale_;
+
+    // TimingRing: two circles, then eight markers turning at ring_speed.
+    draw(ring_, hsla(hue, 0.7, 0.5, 0.3), out, stride);
+    const double angle = t * scene.ring_speed;
+    const double half = kMarkerWidth * scale_ / 2.0;
+    for (int i = 0; i < kMarkers; ++i) {
+        const double a = angle + static_cast<double>(i) / kMarkers * 2.0 * kPi;
+        const double ux = std::cos(a);
+        const double uy = std::sin(a);
+        const double x1 = c + ux * kRingInner * scale_;
+        const double y1 = c + uy * kRingInner * scale_;
+        const double x2 = c + ux * kRingOuter * scale_;
+        const double y2 = c + uy * kRingOuter * scale_;
+        const double length = (kRingOuter - kRingInner) * scale_;
+        rasterize(std::min(x1, x2) - half - 1.0, std::min(y1, y2) - half - 1.0, std::max(x1, x2) + half + 1.0,
+                  std::max(y1, y2) + half + 1.0,
+                  [&](double px, double py) {
+                      // Butt caps: the stroke ends at the endpoints.
+                      const double along = (px - x1) * ux + (py - y1) * uy;
+                      const double across = (px - x1) * uy - (py - y1) * ux;
+                      return stroke(across, 2.0 * half) * clamp01(std::min(along, length - along) + 0.5);
+                  },
+                  scratch_);
+        draw(scratch_, hsla(hue, 0.7, 0.6, 0.5 + std::sin(angle * 2.0 + i) * 0.3), out, stride);
+    }
+
+    const double heartbeat = (std::sin(t * scene.heartbeat_freq * kPi * 2.0) + 1.0) / 2.0;
+    const Pixel edge = hsla(hue, 0.6, 0.4, 0.6);
+    for (int i = 0; i < kHexCount; ++i) {
+        const uint8_t state = i < static_cast<int>(scene.hex_cells.size()) ? scene.hex_cells[i] : 0;
+        Pixel fill;
+        if (i == 0 && heartbeat > 0.0) {
+            fill = hsla(hue, 0.9, 0.4 + heartbeat * 0.3, 1.0);
+        } else if (state == 0) {
+            fill = hsla(hue, 0.3, 0.15, 0.8);
+        } else if (state == 1) {
+            fill = hsla(hue, 0.8, 0.5, 0.8);
+        } else {
+            const double pulse = std::sin(elapsed_ms / 200.0 + i) * 0.5 + 0.5;
+            fill = hsla(hue, 0.8, 0.3 + pulse * 0.4, 0.8);
+        }
+        draw(hex_fill_[i], fill, out, stride);
+        draw(hex_stroke_[i], edge, out, stride);
+    }
+
+    const size_t n = scene.particles.size();
+    x_.resize(n);
+    y_.resize(n);
+    spark::orbit_positions(scene.particles, &elapsed_ms, 1, x_.data(), y_.data());
+    for (size_t i = 0; i < n; ++i) {
+        const double px = x_[i] * scale_;
+        const double py = y_[i] * scale_;
+        const uint32_t color = i < scene.particle_colors.size() ? scene.particle_colors[i] : 0xffffff;
+        const struct {
+            double radius;
+            Pixel color;
+        } discs[2] = {{kHaloRadius * scale_, rgb(color, 0.3)}, {kCoreRadius * scale_, rgb(0xffffff, 1.0)}};
+        for (const auto& disc : discs) {
+            const double radius = disc.radius;
+            rasterize(px - radius - 1.0, py - radius - 1.0, px + radius + 1.0, py + radius + 1.0,
+                      [&](double qx, double qy) {
+                          const double dx = qx - px;
+                          const double dy = qy - py;
+                          return clamp01(radius - std::sqrt(dx * dx + dy * dy) + 0.5);
+                      },
+                      scratch_);
+            draw(scratch_, disc.color, out, stride);
+        }
+    }
+}
+
+}  // namespace lattice
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+namespace {
+
+// Scenes are set from the JS thread while the view renders on the UI
+// thread.
+struct Session {
+    std::mutex mu;
+    estream::lattice::Rasterizer rasterizer;
+    estream::lattice::Scene scene;
+
+    explicit Session(int size) : rasterizer(size) {}
+};
+
+struct Registry {
+    std::mutex mu;
+    long next = 1;
+    std::unordered_map<long, std::shared_ptr<Session>> sessions;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+std::shared_ptr<Session> find_session(long handle) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    auto it = r.sessions.find(handle);
+    return it != r.sessions.end() ? it->second : nullptr;
+}
+
+}  // namespace
+
+extern "C" long estream_lattice_create(int size) {
+    if (size <= 0 || size > 4096) {
+        return -1;
+    }
+    auto session = std::make_shared<Session>(size);
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    const long handle = r.next++;
+    r.sessions.emplace(handle, std::move(session));
+    return handle;
+}
+
+extern "C" void estream_lattice_destroy(long renderer) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    r.sessions.erase(renderer);
+}
+
+extern "C" int estream_lattice_set_scene(long renderer, double base_hue, double ring_speed, double heartbeat_freq,
+                                         const uint8_t* hex_cells, int hex_count, const double* orbits,
+                                         const uint32_t* colors, int particle_count) {
+    auto session = find_session(renderer);
+    if (session == nullptr || hex_count < 0 || (hex_count > 0 && hex_cells == nullptr) || particle_count < 0 ||
+        (particle_count > 0 && (orbits == nullptr || colors == nullptr))) {
+        return -1;
+    }
+    estream::lattice::Scene scene;
+    scene.base_hue = base_hue;
+    scene.ring_speed = ring_speed;
+    scene.heartbeat_freq = heartbeat_freq;
+    scene.hex_cells.assign(hex_cells, hex_cells + hex_count);
+    scene.particles.center = estream::lattice::kCanvasSize / 2.0;
+    const size_t n = static_cast<size_t>(particle_count);
+    for (size_t i = 0; i < n; ++i) {
+        scene.particles.add(orbits[i], orbits[n + i], orbits[2 * n + i], orbits[3 * n + i], orbits[4 * n + i],
+                            orbits[5 * n + i], orbits[6 * n + i]);
+    }
+    scene.particle_colors.assign(colors, colors + n);
+    std::lock_guard<std::mutex> lock(session->mu);
+    session->scene = std::move(scene);
+    return 0;
+}
+
+extern "C" int estream_lattice_render(long renderer, double elapsed_ms, uint8_t* rgba, int stride) {
+    auto session = find_session(renderer);
+    if (session == nullptr || rgba == nullptr || reinterpret_cast<uintptr_t>(rgba) % 4 != 0 || stride % 4 != 0 ||
+        stride < session->rasterizer.size() * 4) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mu);
+    session->rasterizer.render(session->scene, elapsed_ms, rgba, static_cast<size_t>(stride));
+    return 0;
+}
@@ -0,0 +1,120 @@
+/**
+ * Offscreen rasterizer for Lattice Code animation frames.
+ *
+ * LatticeCodeScreen draws the pattern as SVG: a gradient disc, a timing
+ * ring with eight rotating markers, 37 hexagons and the orbiting particles.
+ * Re-rendering that through React on every tick is the screen's main cost.
+ * Rasterizer draws the same frame into a premultiplied RGBA buffer instead.
+ *
+ * Everything that does not move is precomputed once per output size. That
+ * covers the background and the anti-aliased coverage of the ring and of
+ * each hexagon's fill and stroke. Coverage is kept as row spans, so fully
+ * covered runs are filled without reading coverage. A frame copies the
+ * background, then fills and blends those spans in the frame's colors four
+ * pixels at a time (SSE2 / NEON). Only the markers and particles are
+ * rasterized per frame. Particle positions come from orbit_positions().
+ *
+ * The "◆ eStream ◆" label is left to the view that shows the frames.
+ */
+
+#ifndef ESTREAM_LATTICE_RASTER_H
+#define ESTREAM_LATTICE_RASTER_H
+
+#include "spark_orbit.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace estream {
+namespace lattice {
+
+/// Side of the canvas the pattern is laid out on (the SVG viewBox).
+constexpr double kCanvasSize = 300.0;
+
+/// Hexagons of getHexCenters: the center, then rings of 6, 12 and 18.
+constexpr int kHexCount = 37;
+
+/// Premultiplied RGBA8, R in the lowest byte (Android ARGB_8888 memory
+/// order).
+using Pixel = uint32_t;
+
+/// CSS hsla(): hue in degrees, saturation, lightness and alpha in [0, 1].
+Pixel hsla(double hue, double saturation, double lightness, double alpha);
+
+/// 0xRRGGBB at `alpha`.
+Pixel rgb(uint32_t color, double alpha);
+
+/// Source-over blend of `color` into `n` pixels, each weighted by its
+/// coverage (0-255). Null `coverage` means fully covered.
+void blend_span(Pixel* dst, const uint8_t* coverage, size_t n, Pixel color);
+
+/// Set `n` pixels to `color`.
+void fill_span(Pixel* dst, size_t n, Pixel color);
+
+/// What createLatticeCodeState derives from the pubkey and nonce; the
+/// screen passes it in so both renderers draw from the same seed.
+struct Scene {
+    double base_hue = 0.0;
+    double ring_speed = 0.0;
+    double heartbeat_freq = 0.0;
+    /// Per hexagon: 0 off, 1 on, anything else pulsing. Missing cells are
+    /// off.
+    std::vector<uint8_t> hex_cells;
+    /// Particle orbits in canvas pixels (center 150, extent 1).
+    spark::Orbits particles;
+    /// Halo color of each particle, 0xRRGGBB.
+    std::vector<uint32_t> particle_colors;
+};
+
+class Rasterizer {
+public:
+    /// Frames of `size` x `size` pixels.
+    explicit Rasterizer(int size);
+
+    int size() const { return size_; }
+
+    /// Draw the frame at `elapsed_ms` into `out`: size() rows of `stride`
+    /// bytes, 4 bytes per pixel.
+    void render(const Scene& scene, double elapsed_ms, uint8_t* out, size_t stride);
+
+private:
+    struct Span {
+        int row = 0;
+        int begin = 0;
+        int end = 0;
+        /// Fully covered part of [begin, end).
+        int solid_begin = 0;
+        int solid_end = 0;
+    };
+
+    /// Coverage of a shape over its bounding box.
+    struct Mask {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> coverage;
+        std::vector<Span> rows;
+    };
+
+    template <typename Coverage>
+    void rasterize(double x0, double y0, double x1, double y1, Coverage&& coverage, Mask& mask) const;
+    void draw(const Mask& mask, Pixel color, uint8_t* out, size_t stride) const;
+
+    int size_;
+    double scale_;
+    std::vector<Pixel> background_;
+    Mask ring_;
+    std::vector<Mask> hex_fill_;
+    std::vector<Mask> hex_stroke_;
+    // Scratch for the shapes that move.
+    Mask scratch_;
+    std::vector<double> x_;
+    std::vector<double> y_;
+};
+
+}  // namespace lattice
+}  // namespace estream
+
+#endif /* ESTREAM_LATTICE_RASTER_H */
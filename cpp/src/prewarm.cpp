@@ -0,0 +1,273 @@
+#include "prewarm.h"
+
+#include "estream_app_native.h"
+#include "estream_native.h"
+#include "ffi_util.h"
+#include "json.h"
+#include "trace.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <netdb.h>
+#include <sys/socket.h>
+
+namespace estream {
+namespace prewarm {
+
+namespace {
+
+struct Step {
+    const char* name;
+    uint64_t duration_ns = 0;
+    bool ran = false;
+    bool ok = false;
+};
+
+struct State {
+    std::mutex mu;
+    std::condition_variable cv;
+    bool started = false;
+    bool done = false;
+    bool abandoned = false;  // Client gave up waiting; worker owns the handle.
+    bool taken = false;
+    long handle = -1;
+    std::string connected_addr;
+    bool budget_exceeded = false;
+    std::vector<Step> steps;
+};
+
+State& state() {
+    static State instance;
+    return instance;
+}
+
+// Split "host:port" / "[v6]:port" into its parts.
+bool split_host_port(const std::string& addr, std::string& host, std::string& port) {
+    const size_t colon = addr.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 >= addr.size()) {
+        return false;
+    }
+    host = addr.substr(0, colon);
+    port = addr.substr(colon + 1);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+        host = host.substr(1, host.size() - 2);
+    }
+    return true;
+}
+
+// Warm the system resolver cache for the node's host name.
+bool resolve(const std::string& addr) {
+    std::string host;
+    std::string port;
+    if (!split_host_port(addr, host, port)) {
+        return false;
+    }
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0) {
+        return false;
+    }
+    freeaddrinfo(result);
+    return true;
+}
+
+bool ffi_succeeded(char* result) {
+    const bool ok = !ffi_failed(result);
+    if (result != nullptr) {
+        estream_free_string(result);
+    }
+    return ok;
+}
+
+// Run the ML-KEM/ML-DSA key generation paths once so their code pages are
+// resident and any lazily built tables exist before the first real message.
+bool warm_crypto() {
+    const bool keys_ok = ffi_succeeded(estream_app_generate_device_keys("io.estream.prewarm"));
+    const bool bundle_ok = ffi_succeeded(estream_app_generate_prekey_bundle("prewarm", 1));
+    return keys_ok && bundle_ok;
+}
+
+void run(Config config) {
+    State& st = state();
+    const uint64_t deadline = trace::now_ns() + uint64_t{config.budget_ms} * 1000000ull;
+
+    long handle = -1;
+    std::string connected;
+    bool exceeded = false;
+    std::vector<Step> steps;
+
+    auto step = [&](const char* name, auto&& body) {
+        Step s{name};
+        if (trace::now_ns() >= deadline) {
+            exceeded = true;
+            steps.push_back(s);
+            return false;
+        }
+        trace::record(trace::Phase::Begin, name);
+        const uint64_t t0 = trace::now_ns();
+        s.ok = body();
+        s.duration_ns = trace::now_ns() - t0;
+        s.ran = true;
+        trace::record(trace::Phase::End, name);
+        steps.push_back(s);
+        return s.ok;
+    };
+
+    if (!config.node_addr.empty()) {
+        step("prewarm_resolve", [&] { return resolve(config.node_addr); });
+        if (step("prewarm_runtime", [&] { handle = estream_app_initialize(); return handle >= 0; })) {
+            if (step("prewarm_connect", [&] {
+                    return ffi_succeeded(estream_app_connect(handle, config.node_addr.c_str()));
+                })) {
+                connected = config.node_addr;
+            } else {
+                // A runtime left mid-connect is not handed over; the client
+                // creates its own.
+                estream_app_dispose(handle);
+                handle = -1;
+            }
+        }
+    }
+    if (!config.h3_addr.empty()) {
+        step("prewarm_h3_connect", [&] {
+            return ffi_succeeded(estream_app_h3_connect(config.h3_addr.c_str()));
+        });
+    }
+    if (config.warm_crypto) {
+        step("prewarm_crypto", [&] { return warm_crypto(); });
+    }
+
+    std::lock_guard<std::mutex> lock(st.mu);
+    st.steps = std::move(steps);
+    st.budget_exceeded = exceeded;
+    st.connected_addr = connected;
+    st.done = true;
+    if (st.abandoned) {
+        if (handle >= 0) {
+            estream_app_dispose(handle);
+        }
+    } else {
+        st.handle = handle;
+    }
+    st.cv.notify_all();
+}
+
+}  // namespace
+
+bool start(const Config& config) {
+    State& st = state();
+    {
+        std::lock_guard<std::mutex> lock(st.mu);
+        if (st.started) {
+            return false;
+        }
+        st.started = true;
+    }
+    std::thread(run, config).detach();
+    return true;
+}
+
+long take_handle(uint32_t timeout_ms) {
+    State& st = state();
+    std::unique_lock<std::mutex> lock(st.mu);
+    if (!st.started || st.taken || st.abandoned) {
+        return -1;
+    }
+    st.cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&] { return st.done; });
+    if (!st.done) {
+        st.abandoned = true;
+        return -1;
+    }
+    st.taken = true;
+    return st.handle;
+}
+
+bool is_connected(long handle, const std::string& node_addr) {
+    State& st = state();
+    std::lock_guard<std::mutex> lock(st.mu);
+    return st.taken && handle >= 0 && st.handle == handle && st.connected_addr == node_addr;
+}
+
+std::string report_json() {
+    State& st = state();
+    std::lock_guard<std::mutex> lock(st.mu);
+
+    std::string out = "{\"success\":true,\"data\":{\"started\":";
+    out += st.started ? "true" : "false";
+    out += ",\"done\":";
+    out += st.done ? "true" : "false";
+    out += ",\"budget_exceeded\":";
+    out += st.budget_exceeded ? "true" : "false";
+    out += ",\"steps\":[";
+    for (size_t i = 0; i < st.steps.size(); ++i) {
+        const Step& s = st.steps[i];
+        if (i > 0) {
+            out.push_back(',');
+        }
+        out += "{\"name\":";
+        json::append_string(out, s.name);
+        out += ",\"ran\":";
+        out += s.ran ? "true" : "false";
+        out += ",\"ok\":";
+        out += s.ok ? "true" : "false";
+        out += ",\"duration_us\":";
+        json::append_micros(out, s.duration_ns);
+        out.push_back('}');
+    }
+    out += "]}}";
+    return out;
+}
+
+void reset() {
+    State& st = state();
+    std::unique_lock<std::mutex> lock(st.mu);
+    st.cv.wait(lock, [&] { return !st.started || st.done; });
+    st.started = false;
+    st.done = false;
+    st.abandoned = false;
+    st.taken = false;
+    st.handle = -1;
+    st.connected_addr.clear();
+    st.budget_exceeded = false;
+    st.steps.clear();
+}
+
+}  // namespace prewarm
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" int estream_prewarm(const EstreamPrewarmConfig* config) {
+    if (config == nullptr) {
+        return -1;
+    }
+    estream::prewarm::Config cfg;
+    cfg.node_addr = config->node_addr != nullptr ? config->node_addr : "";
+    cfg.h3_addr = config->h3_addr != nullptr ? config->h3_addr : "";
+    cfg.budget_ms = config->budget_ms;
+    cfg.warm_crypto = config->warm_crypto != 0;
+    return estream::prewarm::start(cfg) ? 0 : -1;
+}
+
+extern "C" long estream_prewarm_take_handle(uint32_t timeout_ms) {
+    return estream::prewarm::take_handle(timeout_ms);
+}
+
+extern "C" int estream_prewarm_is_connected(long handle, const char* node_addr) {
+    if (node_addr == nullptr) {
+        return 0;
+    }
+    return estream::prewarm::is_connected(handle, node_addr) ? 1 : 0;
+}
+
+extern "C" char* estream_prewarm_report(void) {
+    return estream::to_c_string(estream::prewarm::report_json());
+}
@@ -0,0 +1,47 @@
+/**
+ * Launch-time pre-warming of the connection and crypto paths.
+ *
+ * Runs on a detached background thread so the first user-visible send does
+ * not pay DNS resolution, runtime/endpoint creation, the QUIC handshake or
+ * first-touch page faults in the PQ code. The runtime handle it creates is
+ * handed over to the client through take_handle().
+ */
+
+#ifndef ESTREAM_PREWARM_H
+#define ESTREAM_PREWARM_H
+
+#include <cstdint>
+#include <string>
+
+namespace estream {
+namespace prewarm {
+
+struct Config {
+    std::string node_addr;   // "host:port" for estream_connect; empty skips
+    std::string h3_addr;     // "ip:port" for estream_h3_connect; empty skips
+    uint32_t budget_ms = 2000;
+    bool warm_crypto = true;
+};
+
+/// Start pre-warming. Returns false if a run was already started.
+bool start(const Config& config);
+
+/// Block until the run finishes or `timeout_ms` elapses, then take ownership
+/// of the pre-warmed runtime handle. Returns -1 if there is none or the run
+/// is still in flight; in that case the worker disposes its handle itself.
+long take_handle(uint32_t timeout_ms);
+
+/// True if `handle` came from take_handle() and is already connected to
+/// `node_addr`, so estream_connect can be skipped.
+bool is_connected(long handle, const std::string& node_addr);
+
+/// JSON report: {"success":true,"data":{...per-step timings...}}.
+std::string report_json();
+
+/// Wait for a run in flight, then forget it so start() works again (tests).
+void reset();
+
+}  // namespace prewarm
+}  // namespace estream
+
+#endif /* ESTREAM_PREWARM_H */
@@ -0,0 +1,60 @@
+/**
+ * Instrumentation guard for one call into the Rust core: a span plus a
+ * latency sample for the entry point, plus the FFI concurrency gauge and
+ * per-subsystem CPU accounting while those are enabled.
+ */
+
+#ifndef ESTREAM_PROBE_H
+#define ESTREAM_PROBE_H
+
+#include "estream_app_native.h"
+#include "latency.h"
+#include "resource_usage.h"
+#include "runtime_stats.h"
+#include "spans.h"
+#include "trace.h"
+
+namespace estream {
+
+class Probe {
+public:
+    Probe(EstreamFnId fn, const char* span_name) noexcept
+        : span_(span_name), fn_(fn), start_ns_(trace::now_ns()) {
+        if (ESTREAM_UNLIKELY(runtime_stats::enabled())) {
+            profiled_ = true;
+            runtime_stats::ffi_enter();
+        }
+        if (ESTREAM_UNLIKELY(resource_usage::enabled())) {
+            accounted_ = true;
+            resource_usage::enter(resource_usage::subsystem_of(fn));
+        }
+    }
+
+    ~Probe() {
+        latency::record(fn_, trace::now_ns() - start_ns_);
+        if (ESTREAM_UNLIKELY(profiled_)) {
+            runtime_stats::ffi_exit();
+        }
+        if (ESTREAM_UNLIKELY(accounted_)) {
+            resource_usage::exit();
+        }
+    }
+
+    void fail() { span_.fail(); }
+
+    char* check(char* result) { return span_.check(result); }
+
+    Probe(const Probe&) = delete;
+    Probe& operator=(const Probe&) = delete;
+
+private:
+    Span span_;
+    EstreamFnId fn_;
+    uint64_t start_ns_;
+    bool profiled_ = false;
+    bool accounted_ = false;
+};
+
+}  // namespace estream
+
+#endif /* ESTREAM_PROBE_H */
@@ -0,0 +1,628 @@
+#include "qr_codec.h"
+
+#include "estream_app_native.h"
+#include "ffi_util.h"
+#include "json.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace estream {
+namespace qr {
+
+namespace {
+
+constexpr uint8_t kKindRequest = 1;
+constexpr uint8_t kKindResponse = 2;
+
+constexpr uint32_t kWireVarint = 0;
+constexpr uint32_t kWireBytes = 1;
+constexpr uint32_t kWireUnknown = 0xff;  // field this version does not read
+
+// Fields shared by both kinds.
+constexpr uint32_t kId = 1;
+constexpr uint32_t kIdUuid = 2;
+constexpr uint32_t kTimestamp = 7;
+
+// Request fields.
+constexpr uint32_t kOperation = 3;
+constexpr uint32_t kOperationText = 4;
+constexpr uint32_t kDescription = 5;
+constexpr uint32_t kPayload = 6;
+constexpr uint32_t kExpiresIn = 8;  // expires_at - timestamp
+constexpr uint32_t kExpiresAt = 9;  // when it precedes timestamp
+constexpr uint32_t kMetadata = 10;
+
+// Response fields.
+constexpr uint32_t kAlgorithm = 3;
+constexpr uint32_t kAlgorithmText = 4;
+constexpr uint32_t kSignature = 5;
+constexpr uint32_t kSignerKeyHash = 6;
+
+// Numbered values. Append only: a value's number is part of the format.
+const char* const kOperations[] = {
+    "provision", "deploy", "release", "build", "autoscale",
+    "network_genesis", "lattice_create", "node_approve", "node_revoke", "device_register",
+};
+const char* const kAlgorithms[] = {"ML-DSA-87", "ML-DSA-65", "ML-DSA-44"};
+
+const char kBase45[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ $%*+-./:";
+
+template <size_t N>
+int lookup(const char* const (&names)[N], const std::string& value) {
+    for (size_t i = 0; i < N; ++i) {
+        if (value == names[i]) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/// Lowercase 8-4-4-4-12 UUIDs only, so the text round-trips exactly.
+bool parse_uuid(const std::string& id, uint8_t out[16]) {
+    if (id.size() != 36) {
+        return false;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < 36; ++i) {
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            if (id[i] != '-') {
+                return false;
+            }
+            continue;
+        }
+        const int hi = hex_value(id[i]);
+        const int lo = i + 1 < 36 ? hex_value(id[i + 1]) : -1;
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        out[n++] = static_cast<uint8_t>(hi << 4 | lo);
+        ++i;
+    }
+    return true;
+}
+
+std::string format_uuid(const uint8_t* b) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(36);
+    for (size_t i = 0; i < 16; ++i) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) {
+            out.push_back('-');
+        }
+        out.push_back(digits[b[i] >> 4]);
+        out.push_back(digits[b[i] & 15]);
+    }
+    return out;
+}
+
+class Writer {
+public:
+    Writer(uint8_t kind, size_t reserve) {
+        out_.reserve(reserve);
+        out_.push_back(kFormatVersion);
+        out_.push_back(kind);
+    }
+
+    void varint(uint32_t field, uint64_t v) {
+        put_varint(field << 2 | kWireVarint);
+        put_varint(v);
+    }
+
+    void bytes(uint32_t field, const void* data, size_t len) {
+        put_varint(field << 2 | kWireBytes);
+        put_varint(len);
+        const auto* p = static_cast<const uint8_t*>(data);
+        out_.insert(out_.end(), p, p + len);
+    }
+
+    void text(uint32_t field, const std::string& s) { bytes(field, s.data(), s.size()); }
+
+    /// The id as 16 bytes when it is a UUID.
+    void id(const std::string& s) {
+        uint8_t uuid[16];
+        if (parse_uuid(s, uuid)) {
+            bytes(kIdUuid, uuid, sizeof(uuid));
+        } else {
+            text(kId, s);
+        }
+    }
+
+    std::vector<uint8_t> take() { return std::move(out_); }
+
+private:
+    void put_varint(uint64_t v) {
+        while (v >= 0x80) {
+            out_.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out_.push_back(static_cast<uint8_t>(v));
+    }
+
+    std::vector<uint8_t> out_;
+};
+
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t len) : p_(data), end_(data + len) {}
+
+    /// Check the format and kind bytes.
+    bool header(uint8_t kind) {
+        if (end_ - p_ < 2 || p_[0] != kFormatVersion || p_[1] != kind) {
+            return false;
+        }
+        p_ += 2;
+        return true;
+    }
+
+    bool done() const { return p_ == end_; }
+
+    /// Next field and its wire type; `value` is set for varints,
+    /// `bytes`/`len` for bytes.
+    bool next(uint32_t& field, uint32_t& wire, uint64_t& value, const uint8_t*& bytes, size_t& len) {
+        uint64_t tag = 0;
+        if (!get_varint(tag) || tag >> 2 > 0xffffffffu) {
+            return false;
+        }
+        field = static_cast<uint32_t>(tag >> 2);
+        wire = static_cast<uint32_t>(tag & 3);
+        switch (wire) {
+            case kWireVarint:
+                return get_varint(value);
+            case kWireBytes: {
+                uint64_t n = 0;
+                if (!get_varint(n) || n > static_cast<uint64_t>(end_ - p_)) {
+                    return false;
+                }
+                bytes = p_;
+                len = static_cast<size_t>(n);
+                p_ += len;
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+private:
+    bool get_varint(uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p_ == end_) {
+                return false;
+            }
+            const uint8_t b = *p_++;
+            if (shift == 63 && b > 1) {
+                return false;
+            }
+            v |= uint64_t{b & 0x7fu} << shift;
+            if ((b & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const uint8_t* p_;
+    const uint8_t* end_;
+};
+
+// Decode loop shared by both kinds. A known field sent with the wrong wire
+// type is rejected, so `on_field` only sees the value or bytes it expects;
+// it returns false to reject.
+template <typename WireOf, typename OnField>
+bool read_fields(const uint8_t* data, size_t len, uint8_t kind, WireOf&& wire_of, OnField&& on_field) {
+    if (data == nullptr) {
+        return false;
+    }
+    Reader reader(data, len);
+    if (!reader.header(kind)) {
+        return false;
+    }
+    while (!reader.done()) {
+        uint32_t field = 0;
+        uint32_t wire = 0;
+        uint64_t value = 0;
+        const uint8_t* bytes = nullptr;
+        size_t n = 0;
+        if (!reader.next(field, wire, value, bytes, n)) {
+            return false;
+        }
+        const uint32_t expected = wire_of(field);
+        if ((expected != kWireUnknown && wire != expected) || !on_field(field, value, bytes, n)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t request_wire(uint32_t field) {
+    switch (field) {
+        case kOperation:
+        case kTimestamp:
+        case kExpiresIn:
+        case kExpiresAt:
+            return kWireVarint;
+        case kId:
+        case kIdUuid:
+        case kOperationText:
+        case kDescription:
+        case kPayload:
+        case kMetadata:
+            return kWireBytes;
+        default:
+            return kWireUnknown;
+    }
+}
+
+uint32_t response_wire(uint32_t field) {
+    switch (field) {
+        case kAlgorithm:
+        case kTimestamp:
+            return kWireVarint;
+        case kId:
+        case kIdUuid:
+        case kAlgorithmText:
+        case kSignature:
+        case kSignerKeyHash:
+            return kWireBytes;
+        default:
+            return kWireUnknown;
+    }
+}
+
+/// Code point at `p` (before `end`) and its length, or 0 if `p` does not
+/// start a valid UTF-8 sequence.
+size_t utf8_next(const uint8_t* p, const uint8_t* end, uint32_t& cp) {
+    const uint8_t b = p[0];
+    size_t n = 0;
+    if (b < 0x80) {
+        cp = b;
+        return 1;
+    } else if (b >= 0xc2 && b < 0xe0) {
+        cp = b & 0x1fu;
+        n = 2;
+    } else if (b >= 0xe0 && b < 0xf0) {
+        cp = b & 0x0fu;
+        n = 3;
+    } else if (b >= 0xf0 && b < 0xf5) {
+        cp = b & 0x07u;
+        n = 4;
+    } else {
+        return 0;
+    }
+    if (static_cast<size_t>(end - p) < n) {
+        return 0;
+    }
+    for (size_t i = 1; i < n; ++i) {
+        if ((p[i] & 0xc0) != 0x80) {
+            return 0;
+        }
+        cp = cp << 6 | (p[i] & 0x3fu);
+    }
+    // Overlong forms, surrogates and code points past U+10FFFF.
+    if ((n == 3 && cp < 0x800) || (n == 4 && (cp < 0x10000 || cp > 0x10ffff)) || (cp >= 0xd800 && cp < 0xe000)) {
+        return 0;
+    }
+    return n;
+}
+
+/// Text fields must be UTF-8, so they can be handed on as strings.
+bool as_text(const uint8_t* bytes, size_t n, std::string& out) {
+    if (bytes == nullptr) {
+        out.clear();
+        return true;
+    }
+    for (size_t i = 0; i < n;) {
+        uint32_t cp = 0;
+        const size_t step = utf8_next(bytes + i, bytes + n, cp);
+        if (step == 0 || cp == 0) {
+            return false;
+        }
+        i += step;
+    }
+    out.assign(reinterpret_cast<const char*>(bytes), n);
+    return true;
+}
+
+/// A JSON string literal in printable ASCII, everything else as \u
+/// escapes, so it is also valid modified UTF-8 for JNI. `s` has passed
+/// as_text().
+void append_ascii_string(std::string& out, const std::string& s) {
+    const auto* p = reinterpret_cast<const uint8_t*>(s.data());
+    const uint8_t* end = p + s.size();
+    out.push_back('"');
+    while (p < end) {
+        uint32_t cp = 0;
+        p += utf8_next(p, end, cp);
+        char buf[16];
+        if (cp == '"' || cp == '\\') {
+            out.push_back('\\');
+            out.push_back(static_cast<char>(cp));
+            continue;
+        }
+        if (cp >= 0x20 && cp < 0x7f) {
+            out.push_back(static_cast<char>(cp));
+            continue;
+        }
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            std::snprintf(buf, sizeof(buf), "\\u%04x\\u%04x", 0xd800 + (cp >> 10), 0xdc00 + (cp & 0x3ff));
+        } else {
+            std::snprintf(buf, sizeof(buf), "\\u%04x", cp);
+        }
+        out += buf;
+    }
+    out.push_back('"');
+}
+
+}  // namespace
+
+std::vector<uint8_t> encode(const SigningRequest& request) {
+    Writer w(kKindRequest, 64 + request.description.size() + request.payload.size() + request.metadata.size());
+    w.id(request.id);
+    const int operation = lookup(kOperations, request.operation);
+    if (operation >= 0) {
+        w.varint(kOperation, static_cast<uint64_t>(operation));
+    } else {
+        w.text(kOperationText, request.operation);
+    }
+    if (!request.description.empty()) {
+        w.text(kDescription, request.description);
+    }
+    if (!request.payload.empty()) {
+        w.bytes(kPayload, request.payload.data(), request.payload.size());
+    }
+    w.varint(kTimestamp, request.timestamp);
+    if (request.expires_at >= request.timestamp) {
+        w.varint(kExpiresIn, request.expires_at - request.timestamp);
+    } else {
+        w.varint(kExpiresAt, request.expires_at);
+    }
+    if (!request.metadata.empty()) {
+        w.text(kMetadata, request.metadata);
+    }
+    return w.take();
+}
+
+std::vector<uint8_t> encode(const SigningResponse& response) {
+    Writer w(kKindResponse, 64 + response.signature.size() + response.signer_key_hash.size());
+    w.id(response.request_id);
+    const int algorithm = lookup(kAlgorithms, response.algorithm);
+    if (algorithm >= 0) {
+        w.varint(kAlgorithm, static_cast<uint64_t>(algorithm));
+    } else {
+        w.text(kAlgorithmText, response.algorithm);
+    }
+    w.bytes(kSignature, response.signature.data(), response.signature.size());
+    w.bytes(kSignerKeyHash, response.signer_key_hash.data(), response.signer_key_hash.size());
+    w.varint(kTimestamp, response.timestamp);
+    return w.take();
+}
+
+bool decode(const uint8_t* data, size_t len, SigningRequest& request) {
+    request = SigningRequest();
+    uint64_t expires_in = 0;
+    bool relative = false;
+    bool has_id = false;
+    bool has_timestamp = false;
+    const bool ok = read_fields(data, len, kKindRequest, request_wire, [&](uint32_t field, uint64_t value,
+                                                                                const uint8_t* bytes, size_t n) {
+        switch (field) {
+            case kId:
+                has_id = true;
+                return as_text(bytes, n, request.id);
+            case kIdUuid:
+                if (n != 16) return false;
+                request.id = format_uuid(bytes);
+                has_id = true;
+                break;
+            case kOperation:
+                if (value >= sizeof(kOperations) / sizeof(kOperations[0])) return false;
+                request.operation = kOperations[value];
+                break;
+            case kOperationText: return as_text(bytes, n, request.operation);
+            case kDescription: return as_text(bytes, n, request.description);
+            case kPayload: request.payload.assign(bytes, bytes + n); break;
+            case kTimestamp:
+                request.timestamp = value;
+                has_timestamp = true;
+                break;
+            case kExpiresIn:
+                expires_in = value;
+                relative = true;
+                break;
+            case kExpiresAt:
+                request.expires_at = value;
+                relative = false;
+                break;
+            case kMetadata: return as_text(bytes, n, request.metadata);
+            default: break;
+        }
+        return true;
+    });
+    // Both identify the request the response signs; the expiry is
+    // relative to the timestamp.
+    if (!ok || !has_id || !has_timestamp) {
+        return false;
+    }
+    if (relative) {
+        request.expires_at = request.timestamp + expires_in;
+    }
+    return true;
+}
+
+bool decode(const uint8_t* data, size_t len, SigningResponse& response) {
+    response = SigningResponse();
+    return read_fields(data, len, kKindResponse, response_wire, [&](uint32_t field, uint64_t value,
+                                                                    const uint8_t* bytes, size_t n) {
+        switch (field) {
+            case kId: return as_text(bytes, n, response.request_id);
+            case kIdUuid:
+                if (n != 16) return false;
+                response.request_id = format_uuid(bytes);
+                break;
+            case kAlgorithm:
+                if (value >= sizeof(kAlgorithms) / sizeof(kAlgorithms[0])) return false;
+                response.algorithm = kAlgorithms[value];
+                break;
+            case kAlgorithmText: return as_text(bytes, n, response.algorithm);
+            case kSignature: response.signature.assign(bytes, bytes + n); break;
+            case kSignerKeyHash: response.signer_key_hash.assign(bytes, bytes + n); break;
+            case kTimestamp: response.timestamp = value; break;
+            default: break;
+        }
+        return true;
+    });
+}
+
+std::string base45_encode(const uint8_t* data, size_t len) {
+    std::string out;
+    out.reserve(len / 2 * 3 + 2);
+    size_t i = 0;
+    for (; i + 1 < len; i += 2) {
+        uint32_t n = uint32_t{data[i]} << 8 | data[i + 1];
+        out.push_back(kBase45[n % 45]);
+        n /= 45;
+        out.push_back(kBase45[n % 45]);
+        out.push_back(kBase45[n / 45]);
+    }
+    if (i < len) {
+        out.push_back(kBase45[data[i] % 45]);
+        out.push_back(kBase45[data[i] / 45]);
+    }
+    return out;
+}
+
+bool base45_decode(const char* text, size_t len, std::vector<uint8_t>& out) {
+    out.clear();
+    if (len % 3 == 1 || (text == nullptr && len > 0)) {
+        return false;
+    }
+    int8_t value[256];
+    std::memset(value, -1, sizeof(value));
+    for (int i = 0; i < 45; ++i) {
+        value[static_cast<uint8_t>(kBase45[i])] = static_cast<int8_t>(i);
+    }
+    out.reserve(len / 3 * 2 + 1);
+    for (size_t i = 0; i < len; i += 3) {
+        const size_t group = len - i >= 3 ? 3 : 2;
+        uint32_t n = 0;
+        for (size_t j = group; j-- > 0;) {
+            const int8_t v = value[static_cast<uint8_t>(text[i + j])];
+            if (v < 0) {
+                return false;
+            }
+            n = n * 45 + static_cast<uint32_t>(v);
+        }
+        if (group == 3) {
+            if (n > 0xffff) {
+                return false;
+            }
+            out.push_back(static_cast<uint8_t>(n >> 8));
+        } else if (n > 0xff) {
+            return false;
+        }
+        out.push_back(static_cast<uint8_t>(n));
+    }
+    return true;
+}
+
+std::string to_json(const SigningRequest& request) {
+    std::string out;
+    out.reserve(160 + request.description.size() + request.metadata.size() * 2);
+    out += "{\"success\":true,\"data\":{\"id\":";
+    append_ascii_string(out, request.id);
+    out += ",\"operation\":";
+    append_ascii_string(out, request.operation);
+    out += ",\"description\":";
+    append_ascii_string(out, request.description);
+    out += ",\"payload_length\":";
+    json::append_uint(out, request.payload.size());
+    out += ",\"timestamp\":";
+    json::append_uint(out, request.timestamp);
+    out += ",\"expires_at\":";
+    json::append_uint(out, request.expires_at);
+    out += ",\"metadata\":";
+    append_ascii_string(out, request.metadata);
+    out += "}}";
+    return out;
+}
+
+}  // namespace qr
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" int estream_qr_encode_response(const char* request_id, const uint8_t* signature, int signature_len,
+                                          const uint8_t* signer_key_hash, int key_hash_len, const char* algorithm,
+                                          uint64_t timestamp, uint8_t* out, int capacity) {
+    if (request_id == nullptr || algorithm == nullptr || signature_len < 0 || key_hash_len < 0 ||
+        (signature == nullptr && signature_len > 0) || (signer_key_hash == nullptr && key_hash_len > 0)) {
+        return -1;
+    }
+    estream::qr::SigningResponse response;
+    response.request_id = request_id;
+    response.signature.assign(signature, signature + signature_len);
+    response.signer_key_hash.assign(signer_key_hash, signer_key_hash + key_hash_len);
+    response.algorithm = algorithm;
+    response.timestamp = timestamp;
+    const std::vector<uint8_t> encoded = estream::qr::encode(response);
+    if (out != nullptr) {
+        if (capacity < 0 || static_cast<size_t>(capacity) < encoded.size()) {
+            return -1;
+        }
+        std::memcpy(out, encoded.data(), encoded.size());
+    }
+    return static_cast<int>(encoded.size());
+}
+
+extern "C" char* estream_qr_decode_request_json(const uint8_t* data, int len, uint8_t* payload, int capacity) {
+    estream::qr::SigningRequest request;
+    if (len < 0 || !estream::qr::decode(data, static_cast<size_t>(len), request)) {
+        return nullptr;
+    }
+    if (!request.payload.empty()) {
+        if (payload == nullptr || capacity < 0 || static_cast<size_t>(capacity) < request.payload.size()) {
+            return nullptr;
+        }
+        std::memcpy(payload, request.payload.data(), request.payload.size());
+    }
+    return estream::to_c_string(estream::qr::to_json(request));
+}
+
+extern "C" int estream_qr_base45_encode(const uint8_t* data, int len, char* out, int capacity) {
+    if (len < 0 || (data == nullptr && len > 0)) {
+        return -1;
+    }
+    const std::string text = estream::qr::base45_encode(data, static_cast<size_t>(len));
+    if (out != nullptr) {
+        if (capacity < 0 || static_cast<size_t>(capacity) < text.size()) {
+            return -1;
+        }
+        std::memcpy(out, text.data(), text.size());
+    }
+    return static_cast<int>(text.size());
+}
+
+extern "C" int estream_qr_base45_decode(const char* text, int len, uint8_t* out, int capacity) {
+    std::vector<uint8_t> bytes;
+    if (len < 0 || !estream::qr::base45_decode(text, static_cast<size_t>(len), bytes)) {
+        return -1;
+    }
+    if (out != nullptr) {
+        if (capacity < 0 || static_cast<size_t>(capacity) < bytes.size()) {
+            return -1;
+        }
+        std::memcpy(out, bytes.data(), bytes.size());
+    }
+    return static_cast<int>(bytes.size());
+}
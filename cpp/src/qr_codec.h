@@ -0,0 +1,81 @@
+/**
+ * Compact binary encoding of QR signing requests and responses.
+ *
+ * Protocol v1 QR codes carry JSON whose binary fields are base58, itself
+ * base58-encoded, in byte mode: 8 QR bits per character and about 1.9
+ * characters per signature byte. Protocol v2 carries this encoding instead,
+ * as Base45 (RFC 9285) in alphanumeric mode: 5.5 bits per character and
+ * 1.5 characters per byte.
+ *
+ * A message is a format byte (2), a kind byte (1 request, 2 response) and
+ * fields in any order, each a tag varint (field << 2 | wire type) and a
+ * value:
+ *
+ *   wire 0: unsigned LEB128 varint
+ *   wire 1: varint length, then raw bytes
+ *
+ * Field names are implied by their number. Common values (the operation,
+ * the algorithm) are numbered too, with a text field for anything else.
+ * Canonical UUID ids travel as 16 raw bytes. Decoders skip fields they do
+ * not know, so fields can be added without a new format byte, and reject
+ * known fields sent with the other wire type.
+ */
+
+#ifndef ESTREAM_QR_CODEC_H
+#define ESTREAM_QR_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace estream {
+namespace qr {
+
+constexpr uint8_t kFormatVersion = 2;
+
+/// QrSigningRequest. `metadata` is its JSON text, passed through as is.
+struct SigningRequest {
+    std::string id;
+    std::string operation;
+    std::string description;
+    std::vector<uint8_t> payload;
+    uint64_t timestamp = 0;
+    uint64_t expires_at = 0;
+    std::string metadata;
+};
+
+/// QrSigningResponse.
+struct SigningResponse {
+    std::string request_id;
+    std::vector<uint8_t> signature;
+    std::vector<uint8_t> signer_key_hash;
+    std::string algorithm;
+    uint64_t timestamp = 0;
+};
+
+std::vector<uint8_t> encode(const SigningRequest& request);
+std::vector<uint8_t> encode(const SigningResponse& response);
+
+/// False if `data` is not a well-formed message of that kind. A request
+/// must also carry an id and a timestamp.
+bool decode(const uint8_t* data, size_t len, SigningRequest& request);
+bool decode(const uint8_t* data, size_t len, SigningResponse& response);
+
+/// RFC 9285: every 2 bytes become 3 characters of the QR alphanumeric set
+/// (a trailing byte becomes 2).
+std::string base45_encode(const uint8_t* data, size_t len);
+
+/// False on characters outside the set, a dangling character or a group
+/// out of range.
+bool base45_decode(const char* text, size_t len, std::vector<uint8_t>& out);
+
+/// {"success":true,"data":{"id","operation","description","payload_length",
+/// "timestamp","expires_at","metadata" (JSON text, "" if none)}}. The
+/// payload itself is returned as bytes, not in the JSON.
+std::string to_json(const SigningRequest& request);
+
+}  // namespace qr
+}  // namespace estream
+
+#endif /* ESTREAM_QR_CODEC_H */
@@ -0,0 +1,212 @@
+#include "resource_usage.h"
+
+#include "ffi_util.h"
+#include "json.h"
+#include "thread_stats.h"
+
+#include <cstring>
+
+#include <sys/resource.h>
+
+namespace estream {
+namespace resource_usage {
+
+std::atomic<bool> g_enabled{false};
+
+namespace {
+
+const char* const kSubsystemNames[ESTREAM_SUBSYSTEM_COUNT] = {
+    "crypto",
+    "transport",
+    "h3",
+};
+
+/// Same thread-name prefix as runtime_stats: the core's Tokio workers.
+constexpr const char* kWorkerPrefix = "tokio-runtime";
+
+/// Scopes deeper than this are folded into the innermost tracked one.
+constexpr int kMaxDepth = 16;
+
+struct Totals {
+    std::atomic<uint64_t> cpu_ns{0};
+    std::atomic<uint64_t> wakeups{0};
+    std::atomic<uint64_t> scopes{0};
+};
+
+Totals g_totals[ESTREAM_SUBSYSTEM_COUNT];
+
+// Voluntary context switches of the calling thread: each one is a block
+// followed by a wakeup. Not available per thread on Apple platforms.
+uint64_t thread_wakeups() {
+#if defined(RUSAGE_THREAD)
+    rusage ru{};
+    if (getrusage(RUSAGE_THREAD, &ru) == 0) {
+        return uint64_t(ru.ru_nvcsw);
+    }
+#endif
+    return 0;
+}
+
+struct ThreadScopes {
+    EstreamSubsystem stack[kMaxDepth];
+    int depth = 0;
+    int untracked = 0;  // Open scopes that were not pushed (too deep or disabled).
+    uint64_t last_cpu_ns = 0;
+    uint64_t last_wakeups = 0;
+
+    // Charge everything since the last checkpoint to the current top.
+    void checkpoint() {
+        const uint64_t cpu = thread_stats::current_thread_cpu_ns();
+        const uint64_t wakeups = thread_wakeups();
+        if (depth > 0) {
+            Totals& t = g_totals[stack[depth - 1]];
+            t.cpu_ns.fetch_add(cpu - last_cpu_ns, std::memory_order_relaxed);
+            t.wakeups.fetch_add(wakeups - last_wakeups, std::memory_order_relaxed);
+        }
+        last_cpu_ns = cpu;
+        last_wakeups = wakeups;
+    }
+};
+
+thread_local ThreadScopes t_scopes;
+
+uint64_t timeval_ns(const timeval& tv) {
+    return uint64_t(tv.tv_sec) * 1000000000ull + uint64_t(tv.tv_usec) * 1000ull;
+}
+
+}  // namespace
+
+EstreamSubsystem subsystem_of(EstreamFnId fn) {
+    switch (fn) {
+        case ESTREAM_FN_INITIALIZE:
+        case ESTREAM_FN_CONNECT:
+        case ESTREAM_FN_DISPOSE:
+            return ESTREAM_SUBSYSTEM_TRANSPORT;
+        case ESTREAM_FN_H3_CONNECT:
+        case ESTREAM_FN_H3_POST:
+        case ESTREAM_FN_H3_GET:
+        case ESTREAM_FN_H3_MINT_IDENTITY_NFT:
+        case ESTREAM_FN_H3_IS_CONNECTED:
+        case ESTREAM_FN_H3_DISCONNECT:
+            return ESTREAM_SUBSYSTEM_H3;
+        default:
+            return ESTREAM_SUBSYSTEM_CRYPTO;
+    }
+}
+
+void enter(EstreamSubsystem subsystem) {
+    ThreadScopes& s = t_scopes;
+    if (s.depth == kMaxDepth) {
+        ++s.untracked;
+        return;
+    }
+    s.checkpoint();
+    s.stack[s.depth++] = subsystem;
+    g_totals[subsystem].scopes.fetch_add(1, std::memory_order_relaxed);
+}
+
+void skip() {
+    ++t_scopes.untracked;
+}
+
+void exit() {
+    ThreadScopes& s = t_scopes;
+    if (s.untracked > 0) {
+        --s.untracked;
+        return;
+    }
+    if (s.depth == 0) {
+        return;
+    }
+    s.checkpoint();
+    --s.depth;
+}
+
+std::string report_json() {
+    std::string out = "{\"success\":true,\"data\":{\"accounting\":";
+    out += enabled() ? "true" : "false";
+    out += ",\"subsystems\":{";
+    for (int i = 0; i < ESTREAM_SUBSYSTEM_COUNT; ++i) {
+        if (i > 0) {
+            out.push_back(',');
+        }
+        json::append_string(out, kSubsystemNames[i]);
+        out += ":{\"cpu_us\":";
+        json::append_micros(out, g_totals[i].cpu_ns.load(std::memory_order_relaxed));
+        out += ",\"wakeups\":";
+        json::append_uint(out, g_totals[i].wakeups.load(std::memory_order_relaxed));
+        out += ",\"scopes\":";
+        json::append_uint(out, g_totals[i].scopes.load(std::memory_order_relaxed));
+        out.push_back('}');
+    }
+
+    // Work the core does on its own threads (I/O, timers, H3 streams) is
+    // not inside any FFI call; report the worker pool as a whole.
+    uint64_t worker_cpu = 0;
+    uint64_t worker_wakeups = 0;
+    uint64_t workers = 0;
+    for (const thread_stats::ThreadSample& t : thread_stats::sample_all()) {
+        if (t.name.compare(0, std::strlen(kWorkerPrefix), kWorkerPrefix) == 0) {
+            worker_cpu += t.cpu_ns;
+            worker_wakeups += t.voluntary_switches;
+            ++workers;
+        }
+    }
+    out += "},\"runtime_workers\":{\"cpu_us\":";
+    json::append_micros(out, worker_cpu);
+    out += ",\"wakeups\":";
+    json::append_uint(out, worker_wakeups);
+    out += ",\"threads\":";
+    json::append_uint(out, workers);
+
+    rusage self{};
+    getrusage(RUSAGE_SELF, &self);
+    out += "},\"process\":{\"cpu_us\":";
+    json::append_micros(out, timeval_ns(self.ru_utime) + timeval_ns(self.ru_stime));
+    out += ",\"wakeups\":";
+    json::append_uint(out, uint64_t(self.ru_nvcsw));
+    out += "}}}";
+    return out;
+}
+
+void reset() {
+    for (Totals& t : g_totals) {
+        t.cpu_ns.store(0, std::memory_order_relaxed);
+        t.wakeups.store(0, std::memory_order_relaxed);
+        t.scopes.store(0, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace resource_usage
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" void estream_resource_accounting(int enabled) {
+    estream::resource_usage::g_enabled.store(enabled != 0, std::memory_order_relaxed);
+}
+
+extern "C" void estream_resource_begin(int subsystem) {
+    // Always open a scope so the matching estream_resource_end() stays
+    // balanced if accounting is toggled in between.
+    if (subsystem < 0 || subsystem >= ESTREAM_SUBSYSTEM_COUNT ||
+        !estream::resource_usage::enabled()) {
+        estream::resource_usage::skip();
+        return;
+    }
+    estream::resource_usage::enter(static_cast<EstreamSubsystem>(subsystem));
+}
+
+extern "C" void estream_resource_end(void) {
+    estream::resource_usage::exit();
+}
+
+extern "C" char* estream_resource_usage(void) {
+    return estream::to_c_string(estream::resource_usage::report_json());
+}
+
+extern "C" void estream_resource_reset(void) {
+    estream::resource_usage::reset();
+}
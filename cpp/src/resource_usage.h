@@ -0,0 +1,49 @@
+/**
+ * Per-subsystem CPU time and wakeup accounting.
+ *
+ * Each thread keeps a stack of active subsystems. At every push and pop
+ * the thread CPU time (CLOCK_THREAD_CPUTIME_ID) and voluntary context
+ * switches since the last checkpoint are charged to the subsystem on top,
+ * so nested scopes are accounted exclusively. Instrumented FFI calls push
+ * the subsystem of their entry point; native code can open its own scopes
+ * to charge surrounding work to one of those subsystems.
+ *
+ * With accounting disabled every hook is one relaxed load and a branch.
+ */
+
+#ifndef ESTREAM_RESOURCE_USAGE_H
+#define ESTREAM_RESOURCE_USAGE_H
+
+#include "estream_app_native.h"
+
+#include <atomic>
+#include <string>
+
+namespace estream {
+namespace resource_usage {
+
+extern std::atomic<bool> g_enabled;
+
+inline bool enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+/// Subsystem an instrumented entry point is charged to.
+EstreamSubsystem subsystem_of(EstreamFnId fn);
+
+/// Open / close a scope on the calling thread.
+void enter(EstreamSubsystem subsystem);
+void exit();
+
+/// Open a scope that charges nothing (closed by exit() like any other).
+void skip();
+
+/// JSON report for estream_resource_usage().
+std::string report_json();
+
+void reset();
+
+}  // namespace resource_usage
+}  // namespace estream
+
+#endif /* ESTREAM_RESOURCE_USAGE_H */
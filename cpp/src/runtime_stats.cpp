@@ -0,0 +1,238 @@
+#include "runtime_stats.h"
+
+#include "ffi_util.h"
+#include "json.h"
+#include "thread_stats.h"
+#include "trace.h"
+
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace estream {
+namespace runtime_stats {
+
+std::atomic<bool> g_enabled{false};
+
+namespace {
+
+/// Thread name prefix of the core's Tokio worker pool ("tokio-runtime-worker",
+/// truncated to 15 characters on Linux).
+constexpr const char* kWorkerPrefix = "tokio-runtime";
+
+struct LockTable {
+    std::mutex mu;
+    std::vector<LockStats*> locks;  // Never freed: ProfiledMutex keeps raw pointers.
+};
+
+LockTable& lock_table() {
+    // Leaked: locks owned by leaked or static objects may be used during exit.
+    static LockTable* instance = new LockTable;
+    return *instance;
+}
+
+struct FfiGauge {
+    std::atomic<uint32_t> in_flight{0};
+    std::atomic<uint32_t> max_in_flight{0};
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> overlapped{0};  // Entered while another call was running.
+    std::atomic<uint64_t> busy_since_ns{0};
+    std::atomic<uint64_t> busy_ns{0};
+};
+
+FfiGauge g_ffi;
+
+// Previous worker sample, for busy ratios between two reports.
+struct WorkerBaseline {
+    std::mutex mu;
+    uint64_t wall_ns = 0;
+    std::unordered_map<uint64_t, uint64_t> cpu_ns;
+};
+
+WorkerBaseline& worker_baseline() {
+    static WorkerBaseline instance;
+    return instance;
+}
+
+void append_lock(std::string& out, const LockStats& s) {
+    const uint64_t acquisitions = s.acquisitions.load(std::memory_order_relaxed);
+    const uint64_t contended = s.contended.load(std::memory_order_relaxed);
+    out += "{\"name\":";
+    json::append_string(out, s.name);
+    out += ",\"acquisitions\":";
+    json::append_uint(out, acquisitions);
+    out += ",\"contended\":";
+    json::append_uint(out, contended);
+    out += ",\"wait_total_us\":";
+    json::append_micros(out, s.wait_total_ns.load(std::memory_order_relaxed));
+    out += ",\"wait_p50_us\":";
+    json::append_micros(out, s.wait.percentile(0.50));
+    out += ",\"wait_p99_us\":";
+    json::append_micros(out, s.wait.percentile(0.99));
+    out += ",\"wait_max_us\":";
+    json::append_micros(out, s.wait.max());
+    out.push_back('}');
+}
+
+}  // namespace
+
+LockStats* lock_stats(const char* name) {
+    LockTable& table = lock_table();
+    std::lock_guard<std::mutex> lock(table.mu);
+    for (LockStats* s : table.locks) {
+        if (std::strcmp(s->name, name) == 0) {
+            return s;
+        }
+    }
+    LockStats* s = new LockStats;
+    s->name = name;
+    table.locks.push_back(s);
+    return s;
+}
+
+void ffi_enter() {
+    g_ffi.calls.fetch_add(1, std::memory_order_relaxed);
+    const uint32_t prev = g_ffi.in_flight.fetch_add(1, std::memory_order_acq_rel);
+    if (prev == 0) {
+        g_ffi.busy_since_ns.store(trace::now_ns(), std::memory_order_relaxed);
+    } else {
+        g_ffi.overlapped.fetch_add(1, std::memory_order_relaxed);
+    }
+    uint32_t max = g_ffi.max_in_flight.load(std::memory_order_relaxed);
+    while (prev + 1 > max &&
+           !g_ffi.max_in_flight.compare_exchange_weak(max, prev + 1, std::memory_order_relaxed)) {
+    }
+}
+
+void ffi_exit() {
+    // Busy time is the union of call intervals. An exit racing a fresh
+    // entry can attribute a few nanoseconds to the wrong interval; that is
+    // well below the resolution this is reported at.
+    const uint64_t since = g_ffi.busy_since_ns.load(std::memory_order_relaxed);
+    if (g_ffi.in_flight.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        g_ffi.busy_ns.fetch_add(trace::now_ns() - since, std::memory_order_relaxed);
+    }
+}
+
+std::string report_json() {
+    std::string out = "{\"success\":true,\"data\":{\"profiling\":";
+    out += enabled() ? "true" : "false";
+
+    out += ",\"locks\":[";
+    {
+        LockTable& table = lock_table();
+        std::lock_guard<std::mutex> lock(table.mu);
+        for (size_t i = 0; i < table.locks.size(); ++i) {
+            if (i > 0) {
+                out.push_back(',');
+            }
+            append_lock(out, *table.locks[i]);
+        }
+    }
+
+    out += "],\"ffi\":{\"calls\":";
+    json::append_uint(out, g_ffi.calls.load(std::memory_order_relaxed));
+    out += ",\"in_flight\":";
+    json::append_uint(out, g_ffi.in_flight.load(std::memory_order_relaxed));
+    out += ",\"max_in_flight\":";
+    json::append_uint(out, g_ffi.max_in_flight.load(std::memory_order_relaxed));
+    out += ",\"overlapped_calls\":";
+    json::append_uint(out, g_ffi.overlapped.load(std::memory_order_relaxed));
+    out += ",\"busy_us\":";
+    json::append_micros(out, g_ffi.busy_ns.load(std::memory_order_relaxed));
+
+    out += "},\"workers\":[";
+    const std::vector<thread_stats::ThreadSample> threads = thread_stats::sample_all();
+    WorkerBaseline& base = worker_baseline();
+    std::lock_guard<std::mutex> lock(base.mu);
+    const uint64_t now = trace::now_ns();
+    const uint64_t wall = base.wall_ns != 0 ? now - base.wall_ns : 0;
+    std::unordered_map<uint64_t, uint64_t> next;
+    bool first = true;
+    for (const thread_stats::ThreadSample& t : threads) {
+        if (t.name.compare(0, std::strlen(kWorkerPrefix), kWorkerPrefix) != 0) {
+            continue;
+        }
+        next[t.tid] = t.cpu_ns;
+        if (!first) {
+            out.push_back(',');
+        }
+        first = false;
+        out += "{\"tid\":";
+        json::append_uint(out, t.tid);
+        out += ",\"name\":";
+        json::append_string(out, t.name.c_str());
+        out += ",\"cpu_us\":";
+        json::append_micros(out, t.cpu_ns);
+        out += ",\"voluntary_switches\":";
+        json::append_uint(out, t.voluntary_switches);
+        out += ",\"involuntary_switches\":";
+        json::append_uint(out, t.involuntary_switches);
+        // Share of wall time spent on CPU since the previous report, in
+        // permille; absent on the first report or for new threads.
+        const auto prev = base.cpu_ns.find(t.tid);
+        if (wall > 0 && prev != base.cpu_ns.end() && t.cpu_ns >= prev->second) {
+            out += ",\"busy_permille\":";
+            json::append_uint(out, (t.cpu_ns - prev->second) * 1000 / wall);
+        }
+        out.push_back('}');
+    }
+    base.cpu_ns = std::move(next);
+    base.wall_ns = now;
+    out += "],\"threads\":";
+    json::append_uint(out, threads.size());
+    out += "}}";
+    return out;
+}
+
+void reset() {
+    {
+        LockTable& table = lock_table();
+        std::lock_guard<std::mutex> lock(table.mu);
+        for (LockStats* s : table.locks) {
+            s->acquisitions.store(0, std::memory_order_relaxed);
+            s->contended.store(0, std::memory_order_relaxed);
+            s->wait_total_ns.store(0, std::memory_order_relaxed);
+            s->wait.reset();
+        }
+    }
+    g_ffi.calls.store(0, std::memory_order_relaxed);
+    g_ffi.overlapped.store(0, std::memory_order_relaxed);
+    g_ffi.busy_ns.store(0, std::memory_order_relaxed);
+    g_ffi.max_in_flight.store(g_ffi.in_flight.load(std::memory_order_relaxed),
+                              std::memory_order_relaxed);
+}
+
+}  // namespace runtime_stats
+
+void ProfiledMutex::lock_contended() {
+    if (!runtime_stats::enabled()) {
+        mu_.lock();
+        return;
+    }
+    const uint64_t t0 = trace::now_ns();
+    mu_.lock();
+    const uint64_t waited = trace::now_ns() - t0;
+    stats_->acquisitions.fetch_add(1, std::memory_order_relaxed);
+    stats_->contended.fetch_add(1, std::memory_order_relaxed);
+    stats_->wait_total_ns.fetch_add(waited, std::memory_order_relaxed);
+    stats_->wait.record(waited);  // Serialized by mu_ itself.
+}
+
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" void estream_runtime_profiling(int enabled) {
+    estream::runtime_stats::g_enabled.store(enabled != 0, std::memory_order_relaxed);
+}
+
+extern "C" char* estream_runtime_stats(void) {
+    return estream::to_c_string(estream::runtime_stats::report_json());
+}
+
+extern "C" void estream_runtime_stats_reset(void) {
+    estream::runtime_stats::reset();
+}
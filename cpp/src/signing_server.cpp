@@ -0,0 +1,1456 @@
+#include "signing_server.h"
+
+#include "estream_app_native.h"
+#include "ffi_util.h"
+#include "json.h"
+#include "spans.h"
+#include "trace.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+namespace estream {
+namespace signing {
+
+namespace {
+
+constexpr const char* kVersion = "0.3.0";
+constexpr size_t kInBytes = kMaxHeaderBytes + kMaxBodyBytes;
+/// Room for pipelined responses: one is only started with a whole
+/// kHeadRoom + kMaxResponseBytes free.
+constexpr size_t kOutBytes = 32768;
+constexpr size_t kHeadRoom = 256;
+/// A signed /status body: an ML-DSA-87 signature as hex is 9254 characters.
+constexpr size_t kMaxResponseBytes = 12288;
+constexpr uint32_t kListenToken = 0xfffffffe;
+constexpr uint32_t kWakeToken = 0xffffffff;
+constexpr int kMaxEvents = 64;
+
+#if defined(MSG_NOSIGNAL)
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+uint64_t now_ms() {
+    return trace::now_ns() / 1000000;
+}
+
+char lower(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Case-insensitive comparison with a lower-case literal.
+bool equals_lower(const char* s, size_t len, const char* literal) {
+    const size_t n = std::strlen(literal);
+    if (len != n) {
+        return false;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (lower(s[i]) != literal[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool contains_lower(const char* s, size_t len, const char* literal) {
+    const size_t n = std::strlen(literal);
+    for (size_t i = 0; i + n <= len; ++i) {
+        if (equals_lower(s + i, n, literal)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool equals(const char* s, size_t len, const char* literal) {
+    return len == std::strlen(literal) && std::memcmp(s, literal, len) == 0;
+}
+
+const char* skip_ws(const char* p, const char* end) {
+    while (p != end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+        ++p;
+    }
+    return p;
+}
+
+// `p` at the opening quote; leaves it past the closing one.
+bool skip_string(const char*& p, const char* end, bool& escaped) {
+    escaped = false;
+    for (++p; p != end; ++p) {
+        const unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"') {
+            ++p;
+            return true;
+        }
+        if (c < 0x20) {
+            return false;
+        }
+        if (c == '\\') {
+            escaped = true;
+            if (++p == end) {
+                return false;
+            }
+        }
+    }
+    return false;
+}
+
+bool skip_value(const char*& p, const char* end) {
+    bool escaped = false;
+    if (p == end) {
+        return false;
+    }
+    if (*p == '"') {
+        return skip_string(p, end, escaped);
+    }
+    if (*p == '{' || *p == '[') {
+        int depth = 0;
+        while (p != end) {
+            const char c = *p;
+            if (c == '"') {
+                if (!skip_string(p, end, escaped)) {
+                    return false;
+                }
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                --depth;
+            }
+            ++p;
+            if (depth == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+    const char* start = p;
+    while (p != end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\t' && *p != '\r' &&
+           *p != '\n') {
+        ++p;
+    }
+    return p != start;
+}
+
+constexpr int kMaxJsonDepth = 32;
+
+bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool is_hex(char c) {
+    return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+bool parse_digits(const char*& p, const char* end) {
+    const char* start = p;
+    while (p != end && is_digit(*p)) {
+        ++p;
+    }
+    return p != start;
+}
+
+bool parse_number(const char*& p, const char* end) {
+    if (p != end && *p == '-') {
+        ++p;
+    }
+    if (p != end && *p == '0') {
+        ++p;
+    } else if (!parse_digits(p, end)) {
+        return false;
+    }
+    if (p != end && *p == '.') {
+        ++p;
+        if (!parse_digits(p, end)) {
+            return false;
+        }
+    }
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        if (p != end && (*p == '+' || *p == '-')) {
+            ++p;
+        }
+        if (!parse_digits(p, end)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// As skip_string, but only accepts the escapes JSON defines.
+bool parse_string(const char*& p, const char* end) {
+    for (++p; p != end; ++p) {
+        const unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"') {
+            ++p;
+            return true;
+        }
+        if (c < 0x20) {
+            return false;
+        }
+        if (c != '\\') {
+            continue;
+        }
+        if (++p == end) {
+            return false;
+        }
+        if (*p == 'u') {
+            for (int i = 0; i < 4; ++i) {
+                if (++p == end || !is_hex(*p)) {
+                    return false;
+                }
+            }
+        } else if (*p != '"' && *p != '\\' && *p != '/' && *p != 'b' && *p != 'f' && *p != 'n' && *p != 'r' &&
+                   *p != 't') {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool parse_literal(const char*& p, const char* end, const char* word) {
+    const size_t n = std::strlen(word);
+    if (static_cast<size_t>(end - p) < n || std::memcmp(p, word, n) != 0) {
+        return false;
+    }
+    p += n;
+    return true;
+}
+
+bool parse_value(const char*& p, const char* end, int depth) {
+    if (p == end) {
+        return false;
+    }
+    switch (*p) {
+        case '"': return parse_string(p, end);
+        case 't': return parse_literal(p, end, "true");
+        case 'f': return parse_literal(p, end, "false");
+        case 'n': return parse_literal(p, end, "null");
+        case '{':
+        case '[': break;
+        default: return parse_number(p, end);
+    }
+    if (depth == kMaxJsonDepth) {
+        return false;
+    }
+    const bool object = *p == '{';
+    const char close = object ? '}' : ']';
+    p = skip_ws(p + 1, end);
+    if (p != end && *p == close) {
+        ++p;
+        return true;
+    }
+    for (;;) {
+        if (object) {
+            if (p == end || *p != '"' || !parse_string(p, end)) {
+                return false;
+            }
+            p = skip_ws(p, end);
+            if (p == end || *p != ':') {
+                return false;
+            }
+            p = skip_ws(p + 1, end);
+        }
+        if (!parse_value(p, end, depth + 1)) {
+            return false;
+        }
+        p = skip_ws(p, end);
+        if (p == end) {
+            return false;
+        }
+        if (*p == close) {
+            ++p;
+            return true;
+        }
+        if (*p != ',') {
+            return false;
+        }
+        p = skip_ws(p + 1, end);
+    }
+}
+
+// Leaves `p` at the value of the top-level member `key`.
+bool find_member(const char* json, size_t len, const char* key, const char*& p) {
+    const char* const end = json + len;
+    const size_t key_len = std::strlen(key);
+    p = skip_ws(json, end);
+    if (p == end || *p != '{') {
+        return false;
+    }
+    p = skip_ws(p + 1, end);
+    while (p != end && *p == '"') {
+        const char* name = p + 1;
+        bool escaped = false;
+        if (!skip_string(p, end, escaped)) {
+            return false;
+        }
+        const bool match =
+            !escaped && static_cast<size_t>(p - 1 - name) == key_len && std::memcmp(name, key, key_len) == 0;
+        p = skip_ws(p, end);
+        if (p == end || *p != ':') {
+            return false;
+        }
+        p = skip_ws(p + 1, end);
+        if (match) {
+            return true;
+        }
+        if (!skip_value(p, end)) {
+            return false;
+        }
+        p = skip_ws(p, end);
+        if (p == end || *p != ',') {
+            return false;
+        }
+        p = skip_ws(p + 1, end);
+    }
+    return false;
+}
+
+uint64_t wall_ms() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+            .count());
+}
+
+bool set_nonblocking(int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+void configure_socket(int fd) {
+    const int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+#if defined(SO_NOSIGPIPE)
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+}
+
+const char* reason_phrase(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 413: return "Payload Too Large";
+        case 503: return "Service Unavailable";
+        default: return "Internal Server Error";
+    }
+}
+
+size_t copy_body(char* out, const char* text) {
+    const size_t len = std::strlen(text);
+    std::memcpy(out, text, len);
+    return len;
+}
+
+// snprintf into `capacity`; 0 if it did not fit.
+template <typename... Args>
+size_t format(char* out, size_t capacity, const char* fmt, Args... args) {
+    const int n = std::snprintf(out, capacity, fmt, args...);
+    return n > 0 && static_cast<size_t>(n) < capacity ? static_cast<size_t>(n) : 0;
+}
+
+void append_uint_member(std::string& out, const char* name, unsigned long long v) {
+    out += ",\"";
+    out += name;
+    out += "\":";
+    json::append_uint(out, v);
+}
+
+}  // namespace
+
+// ============================================================================
+// Parsing
+// ============================================================================
+
+ParseResult parse_request(const char* data, size_t len, HttpRequest& request) {
+    // The head ends at the first empty line (CRLF or bare LF).
+    const size_t limit = std::min(len, kMaxHeaderBytes);
+    size_t head = 0;
+    for (size_t i = 1; i < limit; ++i) {
+        if (data[i] == '\n' && (data[i - 1] == '\n' || (i >= 2 && data[i - 1] == '\r' && data[i - 2] == '\n'))) {
+            head = i + 1;
+            break;
+        }
+    }
+    if (head == 0) {
+        return len >= kMaxHeaderBytes ? ParseResult::TooLarge : ParseResult::Incomplete;
+    }
+
+    request = HttpRequest();
+    request.header_bytes = head;
+    const char* p = data;
+    const char* const end = data + head;
+    bool first = true;
+    bool has_length = false;
+    bool too_large = false;
+    while (p != end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        const char* line_end = eol > p && eol[-1] == '\r' ? eol - 1 : eol;
+        const size_t line_len = static_cast<size_t>(line_end - p);
+        if (line_len == 0) {
+            break;
+        }
+        if (first) {
+            // METHOD SP target SP HTTP/1.x
+            const char* sp1 = static_cast<const char*>(std::memchr(p, ' ', line_len));
+            if (sp1 == nullptr) {
+                return ParseResult::Bad;
+            }
+            const char* target = sp1 + 1;
+            const size_t rest = static_cast<size_t>(line_end - target);
+            const char* sp2 = static_cast<const char*>(std::memchr(target, ' ', rest));
+            if (sp2 == nullptr || sp2 == target || *target != '/') {
+                return ParseResult::Bad;
+            }
+            const size_t method_len = static_cast<size_t>(sp1 - p);
+            request.method = equals(p, method_len, "GET")    ? Method::Get
+                             : equals(p, method_len, "POST") ? Method::Post
+                                                             : Method::Other;
+            const char* query = static_cast<const char*>(std::memchr(target, '?', static_cast<size_t>(sp2 - target)));
+            request.path = target;
+            request.path_len = static_cast<size_t>((query != nullptr ? query : sp2) - target);
+            const char* version = sp2 + 1;
+            const size_t version_len = static_cast<size_t>(line_end - version);
+            if (equals(version, version_len, "HTTP/1.1")) {
+                request.keep_alive = true;
+            } else if (equals(version, version_len, "HTTP/1.0")) {
+                request.keep_alive = false;
+            } else {
+                return ParseResult::Bad;
+            }
+            first = false;
+        } else {
+            const char* colon = static_cast<const char*>(std::memchr(p, ':', line_len));
+            if (colon == nullptr || colon == p) {
+                return ParseResult::Bad;
+            }
+            const size_t name_len = static_cast<size_t>(colon - p);
+            const char* value = skip_ws(colon + 1, line_end);
+            const char* value_end = line_end;
+            while (value_end != value && (value_end[-1] == ' ' || value_end[-1] == '\t')) {
+                --value_end;
+            }
+            const size_t value_len = static_cast<size_t>(value_end - value);
+            if (equals_lower(p, name_len, "content-length")) {
+                if (value_len == 0) {
+                    return ParseResult::Bad;
+                }
+                size_t n = 0;
+                for (const char* v = value; v != value_end; ++v) {
+                    if (*v < '0' || *v > '9') {
+                        return ParseResult::Bad;
+                    }
+                    if (n <= kMaxBodyBytes) {
+                        n = n * 10 + static_cast<size_t>(*v - '0');
+                    }
+                }
+                // Two different lengths make the body boundary ambiguous.
+                if (has_length && n != request.content_length) {
+                    return ParseResult::Bad;
+                }
+                has_length = true;
+                request.content_length = n;
+                too_large = too_large || n > kMaxBodyBytes;
+            } else if (equals_lower(p, name_len, "transfer-encoding")) {
+                return ParseResult::Bad;
+            } else if (equals_lower(p, name_len, "connection")) {
+                if (contains_lower(value, value_len, "close")) {
+                    request.keep_alive = false;
+                } else if (contains_lower(value, value_len, "keep-alive")) {
+                    request.keep_alive = true;
+                }
+            }
+        }
+        p = eol + 1;
+    }
+    if (first) {
+        return ParseResult::Bad;
+    }
+    return too_large ? ParseResult::TooLarge : ParseResult::Complete;
+}
+
+bool json_string_member(const char* json, size_t len, const char* key, const char*& value, size_t& value_len) {
+    const char* const end = json + len;
+    const char* p = nullptr;
+    bool escaped = false;
+    if (!find_member(json, len, key, p) || p == end || *p != '"') {
+        return false;
+    }
+    const char* start = p + 1;
+    if (!skip_string(p, end, escaped) || escaped) {
+        return false;
+    }
+    value = start;
+    value_len = static_cast<size_t>(p - 1 - start);
+    return true;
+}
+
+bool json_uint_member(const char* json, size_t len, const char* key, uint64_t& value) {
+    const char* const end = json + len;
+    const char* p = nullptr;
+    if (!find_member(json, len, key, p)) {
+        return false;
+    }
+    const char* start = p;
+    if (!parse_number(p, end)) {
+        return false;
+    }
+    uint64_t v = 0;
+    for (const char* d = start; d != p; ++d) {
+        if (!is_digit(*d) || v > (UINT64_MAX - static_cast<uint64_t>(*d - '0')) / 10) {
+            return false;
+        }
+        v = v * 10 + static_cast<uint64_t>(*d - '0');
+    }
+    value = v;
+    return true;
+}
+
+bool valid_json_object(const char* json, size_t len) {
+    const char* const end = json + len;
+    const char* p = skip_ws(json, end);
+    if (p == end || *p != '{' || !parse_value(p, end, 0)) {
+        return false;
+    }
+    return skip_ws(p, end) == end;
+}
+
+bool valid_request_id(const char* id, size_t len) {
+    if (len == 0 || len > kMaxIdBytes) {
+        return false;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        const char c = id[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' || c == '_' ||
+              c == ':' || c == '-')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// The /status body for an id that cannot have been queued: as for any
+/// unknown id, but escaped since the id is arbitrary path text. 0 if it
+/// does not fit.
+size_t write_unknown_status(const char* id, size_t id_len, char* out, size_t capacity) {
+    static const char kHead[] = "{\"requestId\":\"";
+    static const char kTail[] = "\",\"status\":\"not_found\"}";
+    size_t n = 0;
+    // Like format(), the body must fit with a byte to spare.
+    const auto put = [&](const char* text, size_t len) {
+        if (n + len >= capacity) {
+            return false;
+        }
+        std::memcpy(out + n, text, len);
+        n += len;
+        return true;
+    };
+    if (!put(kHead, sizeof(kHead) - 1)) {
+        return 0;
+    }
+    for (size_t i = 0; i < id_len; ++i) {
+        const unsigned char c = static_cast<unsigned char>(id[i]);
+        char escaped[8];
+        const char* text = escaped;
+        size_t len = 2;
+        escaped[0] = '\\';
+        switch (c) {
+            case '"': escaped[1] = '"'; break;
+            case '\\': escaped[1] = '\\'; break;
+            case '\n': escaped[1] = 'n'; break;
+            case '\r': escaped[1] = 'r'; break;
+            case '\t': escaped[1] = 't'; break;
+            default:
+                if (c < 0x20) {
+                    len = static_cast<size_t>(std::snprintf(escaped, sizeof(escaped), "\\u%04x", c));
+                } else {
+                    text = &id[i];
+                    len = 1;
+                }
+        }
+        if (!put(text, len)) {
+            return 0;
+        }
+    }
+    return put(kTail, sizeof(kTail) - 1) ? n : 0;
+}
+
+// ============================================================================
+// RequestQueue
+// ============================================================================
+
+RequestQueue::RequestQueue(size_t capacity, uint64_t pending_ttl_ms)
+    : entries_(std::max<size_t>(capacity, 1)), pending_ttl_ms_(pending_ttl_ms) {
+    for (Entry& entry : entries_) {
+        entry.id.reserve(kMaxIdBytes);
+    }
+}
+
+RequestQueue::Entry* RequestQueue::find(const char* id, size_t id_len) {
+    for (Entry& entry : entries_) {
+        if (entry.state != State::Free && entry.id.size() == id_len && std::memcmp(entry.id.data(), id, id_len) == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+const RequestQueue::Entry* RequestQueue::find(const char* id, size_t id_len) const {
+    return const_cast<RequestQueue*>(this)->find(id, id_len);
+}
+
+AddResult RequestQueue::add(const char* id, size_t id_len, const char* body, size_t body_len) {
+    const uint64_t now = now_ms();
+    // expiresAt is wall-clock time; the deadline is kept on now_ms().
+    uint64_t ttl = pending_ttl_ms_;
+    uint64_t expires_at = 0;
+    if (json_uint_member(body, body_len, "expiresAt", expires_at)) {
+        const uint64_t wall = wall_ms();
+        ttl = std::min(ttl, expires_at > wall ? expires_at - wall : 0);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        expire(now);
+        if (find(id, id_len) != nullptr) {
+            ++duplicate_;
+            return AddResult::Duplicate;
+        }
+        // A free slot, else the one decided longest ago.
+        Entry* slot = nullptr;
+        for (Entry& entry : entries_) {
+            if (entry.state == State::Free) {
+                slot = &entry;
+                break;
+            }
+            if (entry.state != State::Pending && (slot == nullptr || entry.order < slot->order)) {
+                slot = &entry;
+            }
+        }
+        if (slot == nullptr) {
+            ++full_;
+            return AddResult::Full;
+        }
+        slot->state = State::Pending;
+        slot->delivered = false;
+        slot->order = next_order_++;
+        slot->queued_ms = now;
+        slot->expires_ms = now + ttl;
+        slot->id.assign(id, id_len);
+        slot->body.assign(body, body_len);
+        slot->result.clear();
+        ++accepted_;
+        max_pending_ = std::max(max_pending_, ++pending_);
+    }
+    arrived_.notify_one();
+    return AddResult::Added;
+}
+
+bool RequestQueue::next(int timeout_ms, std::string& body) {
+    std::unique_lock<std::mutex> lock(mu_);
+    Entry* oldest = nullptr;
+    const auto ready = [&] {
+        expire(now_ms());
+        oldest = nullptr;
+        for (Entry& entry : entries_) {
+            if (entry.state != State::Pending || entry.delivered) {
+                continue;
+            }
+            if (oldest == nullptr || entry.order < oldest->order) {
+                oldest = &entry;
+            }
+        }
+        return closed_ || oldest != nullptr;
+    };
+    if (!arrived_.wait_for(lock, std::chrono::milliseconds(std::max(timeout_ms, 0)), ready) || closed_) {
+        return false;
+    }
+    oldest->delivered = true;
+    body = oldest->body;
+    return true;
+}
+
+void RequestQueue::decided(Entry& entry) {
+    --pending_;
+    decision_ms_.record(now_ms() - entry.queued_ms);
+    entry.order = next_order_++;
+}
+
+void RequestQueue::expire(uint64_t now) {
+    for (Entry& entry : entries_) {
+        if (entry.state != State::Pending || now < entry.expires_ms) {
+            continue;
+        }
+        entry.result = "{\"requestId\":\"" + entry.id + "\",\"status\":\"expired\"}";
+        entry.state = State::Expired;
+        entry.order = next_order_++;
+        --pending_;
+        ++expired_;
+    }
+}
+
+bool RequestQueue::mark_signed(const std::string& id, const std::string& signature,
+                               const std::string& signer_key_hash, const std::string& algorithm,
+                               uint64_t timestamp_ms) {
+    std::lock_guard<std::mutex> lock(mu_);
+    expire(now_ms());
+    Entry* entry = find(id.data(), id.size());
+    if (entry == nullptr || entry->state != State::Pending) {
+        return false;
+    }
+    std::string& r = entry->result;
+    r = "{\"requestId\":\"" + entry->id + "\",\"status\":\"signed\",\"signature\":";
+    json::append_string(r, signature.c_str());
+    r += ",\"signerKeyHash\":";
+    json::append_string(r, signer_key_hash.c_str());
+    r += ",\"algorithm\":";
+    json::append_string(r, algorithm.c_str());
+    r += ",\"timestamp\":";
+    json::append_uint(r, timestamp_ms);
+    r += "}";
+    entry->state = State::Signed;
+    ++signed_;
+    decided(*entry);
+    return true;
+}
+
+bool RequestQueue::mark_rejected(const std::string& id, const std::string& reason) {
+    std::lock_guard<std::mutex> lock(mu_);
+    expire(now_ms());
+    Entry* entry = find(id.data(), id.size());
+    if (entry == nullptr || entry->state != State::Pending) {
+        return false;
+    }
+    std::string& r = entry->result;
+    r = "{\"requestId\":\"" + entry->id + "\",\"status\":\"rejected\",\"reason\":";
+    json::append_string(r, reason.c_str());
+    r += "}";
+    entry->state = State::Rejected;
+    ++rejected_;
+    decided(*entry);
+    return true;
+}
+
+size_t RequestQueue::write_status(const char* id, size_t id_len, char* out, size_t capacity) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    expire(now_ms());
+    const Entry* entry = find(id, id_len);
+    if (entry != nullptr && entry->state != State::Pending) {
+        if (entry->result.size() >= capacity) {
+            return 0;
+        }
+        std::memcpy(out, entry->result.data(), entry->result.size());
+        return entry->result.size();
+    }
+    const int n = static_cast<int>(id_len);
+    return format(out, capacity, "{\"requestId\":\"%.*s\",\"status\":\"%s\"}", n, id,
+                  entry != nullptr ? "pending" : "not_found");
+}
+
+std::vector<std::string> RequestQueue::pending_bodies() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    expire(now_ms());
+    std::vector<const Entry*> pending;
+    for (const Entry& entry : entries_) {
+        if (entry.state == State::Pending) {
+            pending.push_back(&entry);
+        }
+    }
+    std::sort(pending.begin(), pending.end(), [](const Entry* a, const Entry* b) { return a->order < b->order; });
+    std::vector<std::string> out;
+    out.reserve(pending.size());
+    for (const Entry* entry : pending) {
+        out.push_back(entry->body);
+    }
+    return out;
+}
+
+size_t RequestQueue::pending() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    expire(now_ms());
+    return pending_;
+}
+
+void RequestQueue::close() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        closed_ = true;
+    }
+    arrived_.notify_all();
+}
+
+void RequestQueue::append_json(std::string& out) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    const uint64_t now = now_ms();
+    expire(now);
+    uint64_t oldest = 0;
+    for (const Entry& entry : entries_) {
+        if (entry.state == State::Pending) {
+            oldest = std::max(oldest, now - entry.queued_ms);
+        }
+    }
+    out += "\"queue\":{\"capacity\":";
+    json::append_uint(out, entries_.size());
+    append_uint_member(out, "pending", pending_);
+    append_uint_member(out, "max_pending", max_pending_);
+    append_uint_member(out, "accepted", accepted_);
+    append_uint_member(out, "duplicate", duplicate_);
+    append_uint_member(out, "full", full_);
+    append_uint_member(out, "signed", signed_);
+    append_uint_member(out, "rejected", rejected_);
+    append_uint_member(out, "expired", expired_);
+    append_uint_member(out, "oldest_pending_ms", oldest);
+    append_uint_member(out, "decision_ms_p50", decision_ms_.percentile(0.5));
+    append_uint_member(out, "decision_ms_p99", decision_ms_.percentile(0.99));
+    out += "}";
+}
+
+// ============================================================================
+// Server
+// ============================================================================
+
+struct Server::Connection {
+    int fd = -1;
+    std::unique_ptr<char[]> in;
+    std::unique_ptr<char[]> out;
+    size_t in_len = 0;
+    size_t out_len = 0;
+    size_t out_sent = 0;
+    uint32_t requests = 0;
+    uint64_t last_active_ms = 0;
+    /// Close once the output is flushed.
+    bool closing = false;
+    /// Output is backed up: waiting for writability, not reading.
+    bool writing = false;
+    /// The peer shut down its side: close once what it sent is answered
+    /// and flushed.
+    bool peer_closed = false;
+};
+
+/// Readiness for the listening socket, the wake pipe and the connections,
+/// each identified by a token: kListenToken, kWakeToken or the slot.
+struct Server::Poller {
+    struct Event {
+        uint32_t token;
+        bool readable;
+        bool writable;
+    };
+
+#if defined(__linux__)
+    static constexpr const char* kName = "epoll";
+
+    Poller() : fd(epoll_create1(EPOLL_CLOEXEC)) {}
+    ~Poller() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    bool ok() const { return fd >= 0; }
+
+    bool add(int socket, uint32_t token) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u32 = token;
+        return epoll_ctl(fd, EPOLL_CTL_ADD, socket, &event) == 0;
+    }
+
+    void watch(int socket, uint32_t token, bool read, bool write) {
+        epoll_event event{};
+        event.events = (read ? EPOLLIN : 0u) | (write ? EPOLLOUT : 0u);
+        event.data.u32 = token;
+        epoll_ctl(fd, EPOLL_CTL_MOD, socket, &event);
+    }
+
+    void remove(int socket) { epoll_ctl(fd, EPOLL_CTL_DEL, socket, nullptr); }
+
+    int wait(Event* events, int timeout_ms) {
+        epoll_event raw[kMaxEvents];
+        const int n = epoll_wait(fd, raw, kMaxEvents, timeout_ms);
+        for (int i = 0; i < n; ++i) {
+            const uint32_t e = raw[i].events;
+            events[i] = {raw[i].data.u32, (e & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0,
+                         (e & (EPOLLOUT | EPOLLHUP | EPOLLERR)) != 0};
+        }
+        return n > 0 ? n : 0;
+    }
+
+    int fd;
+#else
+    static constexpr const char* kName = "poll";
+
+    Poller() {
+        fds.reserve(kMaxConnections + 2);
+        tokens.reserve(kMaxConnections + 2);
+    }
+
+    bool ok() const { return true; }
+
+    bool add(int socket, uint32_t token) {
+        fds.push_back({socket, POLLIN, 0});
+        tokens.push_back(token);
+        return true;
+    }
+
+    void watch(int socket, uint32_t /* token */, bool read, bool write) {
+        for (pollfd& p : fds) {
+            if (p.fd == socket) {
+                p.events = static_cast<short>((read ? POLLIN : 0) | (write ? POLLOUT : 0));
+            }
+        }
+    }
+
+    void remove(int socket) {
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if (fds[i].fd == socket) {
+                fds[i] = fds.back();
+                tokens[i] = tokens.back();
+                fds.pop_back();
+                tokens.pop_back();
+                return;
+            }
+        }
+    }
+
+    int wait(Event* events, int timeout_ms) {
+        if (::poll(fds.data(), static_cast<nfds_t>(fds.size()), timeout_ms) <= 0) {
+            return 0;
+        }
+        int n = 0;
+        for (size_t i = 0; i < fds.size() && n < kMaxEvents; ++i) {
+            const short e = fds[i].revents;
+            if (e != 0) {
+                events[n++] = {tokens[i], (e & (POLLIN | POLLHUP | POLLERR)) != 0,
+                               (e & (POLLOUT | POLLHUP | POLLERR)) != 0};
+            }
+        }
+        return n;
+    }
+
+    std::vector<pollfd> fds;
+    std::vector<uint32_t> tokens;
+#endif
+};
+
+Server::Server(const ServerConfig& config)
+    : config_(config), queue_(config.queue_capacity), connections_(kMaxConnections) {}
+
+Server::~Server() {
+    stop();
+}
+
+bool Server::start() {
+    if (started_) {
+        return false;
+    }
+    started_ = true;
+    poller_.reset(new Poller());
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    bool ok = poller_->ok() && listen_fd_ >= 0;
+    if (ok) {
+        const int on = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(config_.port);
+        addr.sin_addr.s_addr = htonl(config_.loopback_only ? INADDR_LOOPBACK : INADDR_ANY);
+        socklen_t addr_len = sizeof(addr);
+        ok = ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+             ::listen(listen_fd_, 64) == 0 && set_nonblocking(listen_fd_) &&
+             getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &addr_len) == 0;
+        port_ = ntohs(addr.sin_port);
+    }
+    ok = ok && ::pipe(wake_fds_) == 0 && set_nonblocking(wake_fds_[0]) && set_nonblocking(wake_fds_[1]) &&
+         poller_->add(listen_fd_, kListenToken) && poller_->add(wake_fds_[0], kWakeToken);
+    if (!ok) {
+        for (int* fd : {&listen_fd_, &wake_fds_[0], &wake_fds_[1]}) {
+            if (*fd >= 0) {
+                ::close(*fd);
+                *fd = -1;
+            }
+        }
+        poller_.reset();
+        return false;
+    }
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&Server::loop, this);
+    return true;
+}
+
+void Server::stop() {
+    queue_.close();
+    if (!running_.exchange(false)) {
+        return;
+    }
+    const char wake = 1;
+    while (::write(wake_fds_[1], &wake, 1) < 0 && errno == EINTR) {
+    }
+    thread_.join();
+    for (uint32_t slot = 0; slot < connections_.size(); ++slot) {
+        if (connections_[slot].fd >= 0) {
+            close_connection(slot);
+        }
+    }
+    for (int* fd : {&listen_fd_, &wake_fds_[0], &wake_fds_[1]}) {
+        ::close(*fd);
+        *fd = -1;
+    }
+    poller_.reset();
+}
+
+void Server::loop() {
+#if defined(__APPLE__)
+    pthread_setname_np("estream-signing");
+#else
+    pthread_setname_np(pthread_self(), "estream-signing");
+#endif
+    Poller::Event events[kMaxEvents];
+    uint64_t last_sweep = now_ms();
+    while (running_.load(std::memory_order_acquire)) {
+        const int n = poller_->wait(events, 1000);
+        for (int i = 0; i < n; ++i) {
+            const Poller::Event& event = events[i];
+            if (event.token == kWakeToken) {
+                char drain[16];
+                while (::read(wake_fds_[0], drain, sizeof(drain)) > 0) {
+                }
+            } else if (event.token == kListenToken) {
+                accept_all();
+            } else {
+                if (event.writable) {
+                    on_writable(event.token);
+                }
+                if (event.readable) {
+                    on_readable(event.token);
+                }
+            }
+        }
+        const uint64_t now = now_ms();
+        if (now - last_sweep >= 1000) {
+            close_idle(now);
+            last_sweep = now;
+        }
+    }
+}
+
+void Server::accept_all() {
+    for (;;) {
+        const int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        uint32_t slot = 0;
+        while (slot < connections_.size() && connections_[slot].fd >= 0) {
+            ++slot;
+        }
+        if (slot == connections_.size() || !set_nonblocking(fd) || !poller_->add(fd, slot)) {
+            ::close(fd);
+            refused_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        configure_socket(fd);
+        Connection& c = connections_[slot];
+        if (!c.in) {
+            c.in.reset(new char[kInBytes]);
+            c.out.reset(new char[kOutBytes]);
+        }
+        c.fd = fd;
+        c.last_active_ms = now_ms();
+        accepted_.fetch_add(1, std::memory_order_relaxed);
+        open_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Server::on_readable(uint32_t slot) {
+    Connection& c = connections_[slot];
+    if (c.fd < 0 || c.writing) {
+        return;
+    }
+    bool eof = false;
+    while (c.in_len < kInBytes) {
+        const ssize_t n = ::recv(c.fd, c.in.get() + c.in_len, kInBytes - c.in_len, 0);
+        if (n > 0) {
+            c.in_len += static_cast<size_t>(n);
+        } else if (n == 0) {
+            eof = true;
+            break;
+        } else if (errno != EINTR) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                close_connection(slot);
+                return;
+            }
+            break;
+        }
+    }
+    c.last_active_ms = now_ms();
+    c.peer_closed = c.peer_closed || eof;
+    process(slot);
+    // Answer what the peer sent before it shut down, then close; a
+    // backed-up flush finishes in on_writable first.
+    if (c.peer_closed && c.fd >= 0 && !c.writing) {
+        close_connection(slot);
+    }
+}
+
+void Server::on_writable(uint32_t slot) {
+    Connection& c = connections_[slot];
+    if (c.fd < 0) {
+        return;
+    }
+    flush(slot);
+    // Requests that arrived while the output was backed up.
+    if (c.fd >= 0 && !c.writing && c.in_len > 0) {
+        process(slot);
+    }
+    if (c.peer_closed && c.fd >= 0 && !c.writing) {
+        close_connection(slot);
+    }
+}
+
+void Server::process(uint32_t slot) {
+    Connection& c = connections_[slot];
+    for (;;) {
+        size_t offset = 0;
+        bool out_full = false;
+        while (!c.closing && offset < c.in_len) {
+            if (kOutBytes - c.out_len < kHeadRoom + kMaxResponseBytes) {
+                out_full = true;
+                break;
+            }
+            const char* data = c.in.get() + offset;
+            const size_t available = c.in_len - offset;
+            HttpRequest request;
+            const ParseResult parsed = parse_request(data, available, request);
+            if (parsed == ParseResult::Incomplete) {
+                break;
+            }
+            // route() writes the body past room for the head.
+            char* response = c.out.get() + c.out_len + kHeadRoom;
+            if (parsed != ParseResult::Complete) {
+                bad_request_.fetch_add(1, std::memory_order_relaxed);
+                const bool large = parsed == ParseResult::TooLarge;
+                const size_t len =
+                    copy_body(response, large ? "{\"error\":\"Request too large\"}" : "{\"error\":\"Bad request\"}");
+                commit_response(c, large ? 413 : 400, len, false);
+                c.closing = true;
+                break;
+            }
+            if (available < request.header_bytes + request.content_length) {
+                break;
+            }
+            Span span("signing_http");
+            const uint64_t start_ns = trace::now_ns();
+            int code = 200;
+            const size_t len = route(request, data + request.header_bytes, response, code);
+            if (code >= 400) {
+                span.fail();
+            }
+            commit_response(c, code, len, request.keep_alive);
+            handle_ns_.record(trace::now_ns() - start_ns);
+            requests_.fetch_add(1, std::memory_order_relaxed);
+            if (c.requests++ > 0) {
+                reuses_.fetch_add(1, std::memory_order_relaxed);
+            }
+            offset += request.header_bytes + request.content_length;
+            c.closing = !request.keep_alive;
+        }
+        if (offset > 0) {
+            std::memmove(c.in.get(), c.in.get() + offset, c.in_len - offset);
+            c.in_len -= offset;
+        }
+        flush(slot);
+        // Pipelined requests wait for room; carry on if the flush made it.
+        if (!out_full || c.fd < 0 || c.writing) {
+            return;
+        }
+    }
+}
+
+size_t Server::route(const HttpRequest& request, const char* body, char* out, int& code) {
+    const char* path = request.path;
+    const size_t path_len = request.path_len;
+    size_t len = 0;
+    if (request.method == Method::Get && equals(path, path_len, "/health")) {
+        health_.fetch_add(1, std::memory_order_relaxed);
+        len = format(out, kMaxResponseBytes,
+                     "{\"status\":\"ok\",\"version\":\"%s\",\"keyHash\":null,\"trustLevel\":\"HardwareBacked\","
+                     "\"pendingRequests\":%zu}",
+                     kVersion, queue_.pending());
+    } else if (request.method == Method::Post && equals(path, path_len, "/sign")) {
+        sign_.fetch_add(1, std::memory_order_relaxed);
+        const char* id = nullptr;
+        size_t id_len = 0;
+        // The consumer parses the body as JSON, and one it cannot parse
+        // would sit pending, so only well-formed objects are queued.
+        if (!valid_json_object(body, request.content_length)) {
+            code = 400;
+            return copy_body(out, "{\"success\":false,\"requestId\":\"unknown\",\"message\":\"Invalid JSON\"}");
+        }
+        if (!json_string_member(body, request.content_length, "id", id, id_len) || !valid_request_id(id, id_len)) {
+            code = 400;
+            return copy_body(out,
+                             "{\"success\":false,\"requestId\":\"unknown\",\"message\":\"Missing or invalid id\"}");
+        }
+        const AddResult added = queue_.add(id, id_len, body, request.content_length);
+        const char* message = added == AddResult::Added       ? "Request added. Waiting for user approval."
+                              : added == AddResult::Duplicate ? "Request already received."
+                                                              : "Signing queue is full.";
+        code = added == AddResult::Full ? 503 : 200;
+        len = format(out, kMaxResponseBytes, "{\"success\":%s,\"requestId\":\"%.*s\",\"message\":\"%s\"}",
+                     code == 200 ? "true" : "false", static_cast<int>(id_len), id, message);
+    } else if (request.method == Method::Get && path_len >= 8 && std::memcmp(path, "/status/", 8) == 0) {
+        status_.fetch_add(1, std::memory_order_relaxed);
+        const char* id = path + 8;
+        const size_t id_len = path_len - 8;
+        // /sign only queues valid ids, so any other id is simply not found.
+        len = valid_request_id(id, id_len) ? queue_.write_status(id, id_len, out, kMaxResponseBytes)
+                                           : write_unknown_status(id, id_len, out, kMaxResponseBytes);
+    } else {
+        not_found_.fetch_add(1, std::memory_order_relaxed);
+        code = 404;
+        return copy_body(out, "{\"error\":\"Not found\"}");
+    }
+    if (len == 0) {
+        code = 500;
+        return copy_body(out, "{\"error\":\"Response too large\"}");
+    }
+    return len;
+}
+
+void Server::commit_response(Connection& c, int code, size_t len, bool keep_alive) {
+    char* head = c.out.get() + c.out_len;
+    const size_t head_len = format(head, kHeadRoom,
+                                   "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n"
+                                   "Access-Control-Allow-Origin: *\r\nConnection: %s\r\n\r\n",
+                                   code, reason_phrase(code), len, keep_alive ? "keep-alive" : "close");
+    std::memmove(head + head_len, head + kHeadRoom, len);
+    c.out_len += head_len + len;
+}
+
+void Server::flush(uint32_t slot) {
+    Connection& c = connections_[slot];
+    while (c.out_sent < c.out_len) {
+        const ssize_t n = ::send(c.fd, c.out.get() + c.out_sent, c.out_len - c.out_sent, kSendFlags);
+        if (n > 0) {
+            c.out_sent += static_cast<size_t>(n);
+            c.last_active_ms = now_ms();
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!c.writing) {
+                c.writing = true;
+                poller_->watch(c.fd, slot, false, true);
+            }
+            return;
+        } else if (n == 0 || errno != EINTR) {
+            close_connection(slot);
+            return;
+        }
+    }
+    c.out_len = 0;
+    c.out_sent = 0;
+    if (c.closing) {
+        close_connection(slot);
+        return;
+    }
+    if (c.writing) {
+        c.writing = false;
+        poller_->watch(c.fd, slot, true, false);
+    }
+}
+
+void Server::close_connection(uint32_t slot) {
+    Connection& c = connections_[slot];
+    poller_->remove(c.fd);
+    ::close(c.fd);
+    c.fd = -1;
+    c.in_len = 0;
+    c.out_len = 0;
+    c.out_sent = 0;
+    c.requests = 0;
+    c.closing = false;
+    c.writing = false;
+    c.peer_closed = false;
+    open_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void Server::close_idle(uint64_t now_ms) {
+    for (uint32_t slot = 0; slot < connections_.size(); ++slot) {
+        const Connection& c = connections_[slot];
+        if (c.fd >= 0 && now_ms - c.last_active_ms >= static_cast<uint64_t>(kIdleTimeoutMs)) {
+            close_connection(slot);
+            idle_closed_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+std::string Server::status_json() const {
+    const auto load = [](const std::atomic<uint64_t>& v) {
+        return static_cast<unsigned long long>(v.load(std::memory_order_relaxed));
+    };
+    std::string out = "{\"success\":true,\"data\":{\"running\":";
+    out += running() ? "true" : "false";
+    append_uint_member(out, "port", port_);
+    out += ",\"backend\":";
+    json::append_string(out, Poller::kName);
+    out += ",\"connections\":{\"accepted\":";
+    json::append_uint(out, load(accepted_));
+    append_uint_member(out, "refused", load(refused_));
+    append_uint_member(out, "open", load(open_));
+    append_uint_member(out, "idle_closed", load(idle_closed_));
+    out += "},\"http\":{\"requests\":";
+    json::append_uint(out, load(requests_));
+    append_uint_member(out, "keep_alive_reuses", load(reuses_));
+    append_uint_member(out, "health", load(health_));
+    append_uint_member(out, "sign", load(sign_));
+    append_uint_member(out, "status", load(status_));
+    append_uint_member(out, "not_found", load(not_found_));
+    append_uint_member(out, "bad_request", load(bad_request_));
+    out += ",\"handle_us_p50\":";
+    json::append_micros(out, handle_ns_.percentile(0.5));
+    out += ",\"handle_us_p99\":";
+    json::append_micros(out, handle_ns_.percentile(0.99));
+    out += ",\"handle_us_max\":";
+    json::append_micros(out, handle_ns_.max());
+    out += "},";
+    queue_.append_json(out);
+    out += "}}";
+    return out;
+}
+
+}  // namespace signing
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+namespace {
+
+struct Registry {
+    std::mutex mu;
+    long next = 1;
+    std::unordered_map<long, std::shared_ptr<estream::signing::Server>> servers;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+std::shared_ptr<estream::signing::Server> find_server(long handle) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    auto it = r.servers.find(handle);
+    return it != r.servers.end() ? it->second : nullptr;
+}
+
+}  // namespace
+
+extern "C" long estream_signing_server_start(int port, int queue_capacity) {
+    if (port < 0 || port > 65535 || queue_capacity < 0) {
+        return -1;
+    }
+    estream::signing::ServerConfig config;
+    config.port = static_cast<uint16_t>(port);
+    if (queue_capacity > 0) {
+        config.queue_capacity = static_cast<size_t>(queue_capacity);
+    }
+    auto server = std::make_shared<estream::signing::Server>(config);
+    if (!server->start()) {
+        return -1;
+    }
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    const long handle = r.next++;
+    r.servers.emplace(handle, std::move(server));
+    return handle;
+}
+
+extern "C" void estream_signing_server_stop(long server) {
+    std::shared_ptr<estream::signing::Server> stopped;
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mu);
+        auto it = r.servers.find(server);
+        if (it == r.servers.end()) {
+            return;
+        }
+        stopped = std::move(it->second);
+        r.servers.erase(it);
+    }
+    // A thread blocked in next_request() may still hold the server; stopping
+    // here wakes it.
+    stopped->stop();
+}
+
+extern "C" char* estream_signing_server_next_request(long server, int timeout_ms) {
+    auto s = find_server(server);
+    std::string body;
+    if (s == nullptr || !s->queue().next(timeout_ms, body)) {
+        return nullptr;
+    }
+    return estream::to_c_string(body);
+}
+
+extern "C" char* estream_signing_server_pending_json(long server) {
+    auto s = find_server(server);
+    if (s == nullptr) {
+        return nullptr;
+    }
+    std::string out = "{\"success\":true,\"data\":[";
+    bool first = true;
+    for (const std::string& body : s->queue().pending_bodies()) {
+        if (!first) {
+            out += ",";
+        }
+        first = false;
+        estream::json::append_string(out, body.c_str());
+    }
+    out += "]}";
+    return estream::to_c_string(out);
+}
+
+extern "C" int estream_signing_server_mark_signed(long server, const char* request_id, const char* signature,
+                                                  const char* signer_key_hash, const char* algorithm,
+                                                  uint64_t timestamp_ms) {
+    auto s = find_server(server);
+    if (s == nullptr || request_id == nullptr || signature == nullptr || signer_key_hash == nullptr ||
+        algorithm == nullptr) {
+        return -1;
+    }
+    return s->queue().mark_signed(request_id, signature, signer_key_hash, algorithm, timestamp_ms) ? 0 : -1;
+}
+
+extern "C" int estream_signing_server_mark_rejected(long server, const char* request_id, const char* reason) {
+    auto s = find_server(server);
+    if (s == nullptr || request_id == nullptr || reason == nullptr) {
+        return -1;
+    }
+    return s->queue().mark_rejected(request_id, reason) ? 0 : -1;
+}
+
+extern "C" char* estream_signing_server_status_json(long server) {
+    auto s = find_server(server);
+    return s != nullptr ? estream::to_c_string(s->status_json()) : nullptr;
+}
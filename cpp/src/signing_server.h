@@ -0,0 +1,260 @@
+/**
+ * Local signing endpoint for the CLI: HTTP/1.1 on port 8765 with /health,
+ * /sign and /status/<id>.
+ *
+ * One event-loop thread serves every connection: epoll on Linux and
+ * Android, poll() elsewhere. io_uring is not used because Android's app
+ * seccomp policy rejects it. Sockets are non-blocking and connections are
+ * kept alive, so a CLI polling /status reuses one socket. Each connection
+ * slot owns fixed input and output buffers, allocated the first time the
+ * slot is used and kept for later connections. Requests are parsed in
+ * place (parse_request, json_string_member), and /health and /status
+ * responses are formatted straight into the output buffer, so a warm
+ * server does not allocate on those paths.
+ *
+ * POST /sign bodies go into a RequestQueue. The app takes them from
+ * next(), shows them for approval, and reports the outcome with
+ * mark_signed() or mark_rejected(). From then on /status answers from the
+ * queue without reaching the app. The queue and the connections are
+ * counted for status_json().
+ */
+
+#ifndef ESTREAM_SIGNING_SERVER_H
+#define ESTREAM_SIGNING_SERVER_H
+
+#include "histogram.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace estream {
+namespace signing {
+
+constexpr uint16_t kDefaultPort = 8765;
+constexpr size_t kMaxHeaderBytes = 4096;
+constexpr size_t kMaxBodyBytes = 16384;
+/// Request ids: 1-128 characters of [A-Za-z0-9._:-].
+constexpr size_t kMaxIdBytes = 128;
+constexpr size_t kMaxConnections = 32;
+constexpr size_t kDefaultQueueCapacity = 32;
+/// A pending request expires this long after arrival, or at its expiresAt
+/// if that is sooner.
+constexpr uint64_t kPendingTtlMs = 10 * 60 * 1000;
+/// Keep-alive connections idle this long are closed.
+constexpr int kIdleTimeoutMs = 30000;
+
+enum class Method : uint8_t { Get, Post, Other };
+
+/// One request head. `path` points into the parsed buffer.
+struct HttpRequest {
+    Method method = Method::Other;
+    const char* path = nullptr;
+    size_t path_len = 0;
+    /// Request line and headers, through the blank line.
+    size_t header_bytes = 0;
+    size_t content_length = 0;
+    bool keep_alive = true;
+};
+
+enum class ParseResult { Incomplete, Complete, Bad, TooLarge };
+
+/// Parse the request head at the start of `data`. TooLarge if the head
+/// exceeds kMaxHeaderBytes or the body kMaxBodyBytes; Bad for malformed
+/// heads and chunked bodies.
+ParseResult parse_request(const char* data, size_t len, HttpRequest& request);
+
+/// The top-level string member `key` of the JSON object in `json`, as a
+/// view into it. False if the text is not an object, the member is absent
+/// or not a string, or the string has escapes.
+bool json_string_member(const char* json, size_t len, const char* key, const char*& value, size_t& value_len);
+
+/// The top-level member `key` of the JSON object in `json` as an unsigned
+/// integer. False if it is absent, not a number, negative, fractional or
+/// out of range.
+bool json_uint_member(const char* json, size_t len, const char* key, uint64_t& value);
+
+/// True if `json` is exactly one well-formed JSON object (RFC 8259), nested
+/// at most 32 deep, with only whitespace around it.
+bool valid_json_object(const char* json, size_t len);
+
+bool valid_request_id(const char* id, size_t len);
+
+enum class AddResult { Added, Duplicate, Full };
+
+/// Signing requests by id, from arrival until evicted. A decided request
+/// keeps its /status answer and is evicted, oldest decision first, only
+/// when a new request needs its slot. A pending request is never evicted,
+/// but expires after `pending_ttl_ms` (or at its expiresAt) and is then
+/// answered like a decided one, with status "expired".
+class RequestQueue {
+public:
+    explicit RequestQueue(size_t capacity = kDefaultQueueCapacity, uint64_t pending_ttl_ms = kPendingTtlMs);
+
+    /// Queue a /sign body. `id` must pass valid_request_id(). A numeric
+    /// "expiresAt" member (ms since the epoch) shortens the request's TTL.
+    AddResult add(const char* id, size_t id_len, const char* body, size_t body_len);
+
+    /// The body of the oldest request not handed out yet, waiting up to
+    /// `timeout_ms`. False on timeout or once closed.
+    bool next(int timeout_ms, std::string& body);
+
+    /// Record the outcome of a pending request. False if it is not pending
+    /// (including once it has expired).
+    bool mark_signed(const std::string& id, const std::string& signature, const std::string& signer_key_hash,
+                     const std::string& algorithm, uint64_t timestamp_ms);
+    bool mark_rejected(const std::string& id, const std::string& reason);
+
+    /// Write the /status/<id> body into `out`. Returns its length, or 0 if
+    /// `capacity` is too small.
+    size_t write_status(const char* id, size_t id_len, char* out, size_t capacity) const;
+
+    /// Bodies of the pending requests, oldest first.
+    std::vector<std::string> pending_bodies() const;
+    size_t pending() const;
+
+    /// Wake next() callers and make later calls return false.
+    void close();
+
+    /// "queue":{...} member of the server status.
+    void append_json(std::string& out) const;
+
+private:
+    enum class State : uint8_t { Free, Pending, Signed, Rejected, Expired };
+
+    struct Entry {
+        State state = State::Free;
+        bool delivered = false;
+        /// Arrival order, then decision order once decided.
+        uint64_t order = 0;
+        uint64_t queued_ms = 0;
+        /// now_ms() at which a pending request expires.
+        uint64_t expires_ms = 0;
+        std::string id;
+        std::string body;
+        /// The /status body once decided.
+        std::string result;
+    };
+
+    Entry* find(const char* id, size_t id_len);
+    const Entry* find(const char* id, size_t id_len) const;
+    void decided(Entry& entry);
+    /// Expire pending requests past their deadline. Expiry is lazy: every
+    /// method calls this under mu_ first, the const ones included.
+    void expire(uint64_t now);
+    void expire(uint64_t now) const { const_cast<RequestQueue*>(this)->expire(now); }
+
+    mutable std::mutex mu_;
+    std::condition_variable arrived_;
+    std::vector<Entry> entries_;
+    uint64_t pending_ttl_ms_;
+    uint64_t next_order_ = 1;
+    bool closed_ = false;
+
+    size_t pending_ = 0;
+    size_t max_pending_ = 0;
+    uint64_t accepted_ = 0;
+    uint64_t duplicate_ = 0;
+    uint64_t full_ = 0;
+    uint64_t signed_ = 0;
+    uint64_t rejected_ = 0;
+    uint64_t expired_ = 0;
+    /// Time from arrival to decision, ms.
+    Histogram decision_ms_;
+};
+
+struct ServerConfig {
+    /// 0 picks a free port.
+    uint16_t port = kDefaultPort;
+    /// Bind 127.0.0.1 instead of every interface.
+    bool loopback_only = false;
+    size_t queue_capacity = kDefaultQueueCapacity;
+};
+
+class Server {
+public:
+    explicit Server(const ServerConfig& config = ServerConfig());
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    /// Bind, listen and start the event loop. False if the port cannot be
+    /// bound or the server already ran.
+    bool start();
+
+    /// Stop the loop, close every connection and the queue.
+    void stop();
+
+    bool running() const { return running_.load(std::memory_order_acquire); }
+    /// The bound port once started.
+    uint16_t port() const { return port_; }
+
+    RequestQueue& queue() { return queue_; }
+
+    /// {"success":true,"data":{"running","port","backend","connections":{
+    /// "accepted","refused","open","idle_closed"},"http":{"requests",
+    /// "keep_alive_reuses","health","sign","status","not_found",
+    /// "bad_request","handle_us_p50","handle_us_p99","handle_us_max"},
+    /// "queue":{"capacity","pending","max_pending","accepted","duplicate",
+    /// "full","signed","rejected","expired","oldest_pending_ms","decision_ms_p50",
+    /// "decision_ms_p99"}}}
+    std::string status_json() const;
+
+private:
+    struct Connection;
+    struct Poller;
+
+    void loop();
+    void accept_all();
+    void on_readable(uint32_t slot);
+    void on_writable(uint32_t slot);
+    /// Handle every complete request buffered on the connection.
+    void process(uint32_t slot);
+    /// Write the response body for `request` into `out`; returns its
+    /// length and sets `code`.
+    size_t route(const HttpRequest& request, const char* body, char* out, int& code);
+    /// Prefix the body route() left in the connection's output with the
+    /// status line and headers.
+    void commit_response(Connection& c, int code, size_t len, bool keep_alive);
+    void flush(uint32_t slot);
+    void close_connection(uint32_t slot);
+    void close_idle(uint64_t now_ms);
+
+    ServerConfig config_;
+    RequestQueue queue_;
+    uint16_t port_ = 0;
+    int listen_fd_ = -1;
+    int wake_fds_[2] = {-1, -1};
+    std::unique_ptr<Poller> poller_;
+    std::vector<Connection> connections_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    bool started_ = false;
+
+    // Written by the loop thread, read by status_json().
+    std::atomic<uint64_t> accepted_{0};
+    std::atomic<uint64_t> refused_{0};
+    std::atomic<uint64_t> open_{0};
+    std::atomic<uint64_t> idle_closed_{0};
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> reuses_{0};
+    std::atomic<uint64_t> health_{0};
+    std::atomic<uint64_t> sign_{0};
+    std::atomic<uint64_t> status_{0};
+    std::atomic<uint64_t> not_found_{0};
+    std::atomic<uint64_t> bad_request_{0};
+    /// Parse to response queued, ns.
+    Histogram handle_ns_;
+};
+
+}  // namespace signing
+}  // namespace estream
+
+#endif /* ESTREAM_SIGNING_SERVER_H */
@@ -0,0 +1,99 @@
+#include "spans.h"
+
+#include "runtime_stats.h"
+#include "trace.h"
+
+#include <mutex>
+#include <vector>
+
+namespace estream {
+namespace spans {
+
+std::atomic<const Hook*> g_hook{nullptr};
+
+namespace {
+
+std::atomic<uint64_t> g_next_id{1};
+thread_local uint64_t t_current = 0;
+
+// Guards the components below and republishing g_hook. Replaced hooks are
+// kept alive: a span that loaded the old pointer may still be calling
+// through it on another thread.
+ProfiledMutex g_config_mu{"span_hooks"};
+EstreamTraceCallback g_user_fn = nullptr;
+void* g_user_ctx = nullptr;
+Sink g_sink = nullptr;
+std::vector<const Hook*> g_retired;
+
+void republish_locked() {
+    const Hook* hook = nullptr;
+    if (g_user_fn != nullptr || g_sink != nullptr) {
+        hook = new Hook{g_user_fn, g_user_ctx, g_sink};
+    }
+    const Hook* old = g_hook.exchange(hook, std::memory_order_acq_rel);
+    if (old != nullptr) {
+        g_retired.push_back(old);
+    }
+}
+
+void emit(const Hook* hook, const char* name, uint64_t id, uint64_t parent_id,
+          EstreamSpanPhase phase, int failed) {
+    EstreamSpanEvent event;
+    event.span_id = id;
+    event.parent_id = parent_id;
+    event.name = name;
+    event.ts_ns = trace::now_ns();
+    event.thread_id = trace::current_tid();
+    event.phase = phase;
+    event.failed = failed;
+    if (hook->sink != nullptr) {
+        hook->sink(&event);
+    }
+    if (hook->fn != nullptr) {
+        hook->fn(hook->ctx, &event);
+    }
+}
+
+}  // namespace
+
+void set_sink(Sink sink) {
+    std::lock_guard<ProfiledMutex> lock(g_config_mu);
+    g_sink = sink;
+    republish_locked();
+}
+
+uint64_t current() {
+    return t_current;
+}
+
+uint64_t begin(const Hook* hook, const char* name) {
+    const uint64_t id = g_next_id.fetch_add(1, std::memory_order_relaxed);
+    emit(hook, name, id, t_current, ESTREAM_SPAN_BEGIN, 0);
+    t_current = id;
+    return id;
+}
+
+void end(const char* name, uint64_t id, uint64_t parent_id, int failed) {
+    t_current = parent_id;
+    // The hook may have been removed while the span was open; the end event
+    // is then dropped and the consumer sees an unterminated span.
+    const Hook* hook = g_hook.load(std::memory_order_acquire);
+    if (hook != nullptr) {
+        emit(hook, name, id, parent_id, ESTREAM_SPAN_END, failed);
+    }
+}
+
+}  // namespace spans
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" void estream_set_trace_callback(EstreamTraceCallback fn, void* ctx) {
+    using namespace estream::spans;
+    std::lock_guard<estream::ProfiledMutex> lock(g_config_mu);
+    g_user_fn = fn;
+    g_user_ctx = ctx;
+    republish_locked();
+}
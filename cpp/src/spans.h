@@ -0,0 +1,92 @@
+/**
+ * Begin/end spans around calls into the Rust core.
+ *
+ * A Span is a scoped guard. When neither a trace callback nor the trace
+ * file writer is active, its constructor is a single atomic load and a
+ * predictable branch; the destructor tests the span id it did not assign.
+ */
+
+#ifndef ESTREAM_SPANS_H
+#define ESTREAM_SPANS_H
+
+#include "estream_app_native.h"
+#include "ffi_util.h"
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ESTREAM_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define ESTREAM_UNLIKELY(x) (x)
+#endif
+
+namespace estream {
+namespace spans {
+
+/// Built-in consumer of span events (the trace file writer).
+using Sink = void (*)(const EstreamSpanEvent* event);
+
+/// Everything a span reports to. Published as one immutable object so the
+/// fast path is a single load; any field may be null.
+struct Hook {
+    EstreamTraceCallback fn;
+    void* ctx;
+    Sink sink;
+};
+
+extern std::atomic<const Hook*> g_hook;
+
+/// Install or remove (nullptr) the built-in sink alongside the user callback.
+void set_sink(Sink sink);
+
+/// Slow paths, only reached with a hook installed.
+uint64_t begin(const Hook* hook, const char* name);
+void end(const char* name, uint64_t id, uint64_t parent_id, int failed);
+
+/// Id of the innermost open span on this thread (0 if none).
+uint64_t current();
+
+}  // namespace spans
+
+class Span {
+public:
+    explicit Span(const char* name) noexcept : name_(name) {
+        const spans::Hook* hook = spans::g_hook.load(std::memory_order_acquire);
+        if (ESTREAM_UNLIKELY(hook != nullptr)) {
+            parent_ = spans::current();
+            id_ = spans::begin(hook, name);
+        }
+    }
+
+    ~Span() {
+        if (ESTREAM_UNLIKELY(id_ != 0)) {
+            spans::end(name_, id_, parent_, failed_);
+        }
+    }
+
+    /// Mark the span as failed (reported in the end event).
+    void fail() { failed_ = 1; }
+
+    /// Mark failed when an FFI call returned NULL or an error result (see
+    /// ffi_failed). The JSON is only scanned while the span is reported.
+    char* check(char* result) {
+        if (result == nullptr || (ESTREAM_UNLIKELY(id_ != 0) && ffi_failed(result))) {
+            failed_ = 1;
+        }
+        return result;
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* name_;
+    uint64_t id_ = 0;
+    uint64_t parent_ = 0;
+    int failed_ = 0;
+};
+
+}  // namespace estream
+
+#endif /* ESTREAM_SPANS_H */
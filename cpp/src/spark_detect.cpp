@@ -0,0 +1,418 @@
+#include "spark_detect.h"
+
+#include "estream_app_native.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace estream {
+namespace spark {
+
+uint32_t threshold_mask16(const uint8_t* p, uint8_t threshold) {
+    if (threshold == 0xFF) {
+        return 0;
+    }
+#if defined(__SSE2__)
+    // No unsigned byte compare in SSE2: v > t  <=>  max(v, t + 1) == v.
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i above = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(static_cast<char>(threshold + 1))), v);
+    return static_cast<uint32_t>(_mm_movemask_epi8(above));
+#elif defined(__aarch64__)
+    // No movemask on NEON: keep one weight bit per lane and add each half.
+    static const uint8_t kBits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t above = vandq_u8(vcgtq_u8(vld1q_u8(p), vdupq_n_u8(threshold)), vld1q_u8(kBits));
+    return static_cast<uint32_t>(vaddv_u8(vget_low_u8(above))) |
+           (static_cast<uint32_t>(vaddv_u8(vget_high_u8(above))) << 8);
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < 16; ++i) {
+        mask |= static_cast<uint32_t>(p[i] > threshold) << i;
+    }
+    return mask;
+#endif
+}
+
+Detector::Detector(const Options& options) : options_(options) {}
+
+uint32_t Detector::find(uint32_t label) {
+    while (parent_[label] != label) {
+        parent_[label] = parent_[parent_[label]];
+        label = parent_[label];
+    }
+    return label;
+}
+
+void Detector::unite(uint32_t a, uint32_t b) {
+    a = find(a);
+    b = find(b);
+    if (a != b) {
+        parent_[std::max(a, b)] = std::min(a, b);
+    }
+}
+
+void Detector::scan_row(const uint8_t* row, int width, int y) {
+    const uint8_t threshold = options_.threshold;
+    current_.clear();
+    size_t above = 0;  // First run of the previous row that can still touch.
+
+    auto emit = [&](int x0, int x1) {
+        // 8-connectivity: a run on the row above touches [x0, x1) if it
+        // overlaps [x0 - 1, x1 + 1).
+        while (above < previous_.size() && previous_[above].x1 < x0) {
+            ++above;
+        }
+        uint32_t label = UINT32_MAX;
+        for (size_t i = above; i < previous_.size() && previous_[i].x0 <= x1; ++i) {
+            if (label == UINT32_MAX) {
+                label = find(previous_[i].label);
+            } else {
+                unite(label, previous_[i].label);
+                label = find(label);
+            }
+        }
+        if (label == UINT32_MAX) {
+            label = static_cast<uint32_t>(parent_.size());
+            parent_.push_back(label);
+            blobs_.push_back(Blob{});
+        }
+        Blob& blob = blobs_[label];
+        for (int x = x0; x < x1; ++x) {
+            const uint32_t w = static_cast<uint32_t>(row[x] - threshold);
+            blob.weight += w;
+            blob.weight_x += static_cast<uint64_t>(w) * static_cast<uint64_t>(x);
+            blob.weight_y += static_cast<uint64_t>(w) * static_cast<uint64_t>(y);
+            blob.peak = std::max<uint32_t>(blob.peak, row[x]);
+        }
+        blob.area += static_cast<uint64_t>(x1 - x0);
+        current_.push_back(Run{x0, x1, label});
+    };
+
+    int start = -1;
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint32_t mask = threshold_mask16(row + x, threshold);
+        if (mask == 0) {
+            if (start >= 0) {
+                emit(start, x);
+                start = -1;
+            }
+            continue;
+        }
+        if (mask == 0xFFFF) {
+            if (start < 0) {
+                start = x;
+            }
+            continue;
+        }
+        for (int i = 0; i < 16; ++i) {
+            const bool on = (mask >> i) & 1;
+            if (on && start < 0) {
+                start = x + i;
+            } else if (!on && start >= 0) {
+                emit(start, x + i);
+                start = -1;
+            }
+        }
+    }
+    for (; x < width; ++x) {
+        const bool on = row[x] > threshold;
+        if (on && start < 0) {
+            start = x;
+        } else if (!on && start >= 0) {
+            emit(start, x);
+            start = -1;
+        }
+    }
+    if (start >= 0) {
+        emit(start, width);
+    }
+}
+
+size_t Detector::detect(const Plane& plane, Particle* out, size_t capacity) {
+    last_components_ = 0;
+    if (plane.data == nullptr || plane.width <= 0 || plane.height <= 0 || plane.pixel_stride < 1 ||
+        plane.row_stride < plane.width * plane.pixel_stride) {
+        return 0;
+    }
+    previous_.clear();
+    parent_.clear();
+    blobs_.clear();
+
+    for (int y = 0; y < plane.height; ++y) {
+        const uint8_t* row = plane.data + static_cast<size_t>(y) * static_cast<size_t>(plane.row_stride);
+        if (plane.pixel_stride != 1) {
+            gather_.resize(static_cast<size_t>(plane.width));
+            for (int x = 0; x < plane.width; ++x) {
+                gather_[static_cast<size_t>(x)] = row[static_cast<size_t>(x) * static_cast<size_t>(plane.pixel_stride)];
+            }
+            row = gather_.data();
+        }
+        scan_row(row, plane.width, y);
+        std::swap(previous_, current_);
+    }
+
+    // Fold each label's sums into its component's root.
+    roots_.clear();
+    for (uint32_t label = 0; label < parent_.size(); ++label) {
+        const uint32_t root = find(label);
+        if (root == label) {
+            roots_.push_back(label);
+            continue;
+        }
+        Blob& from = blobs_[label];
+        Blob& to = blobs_[root];
+        to.area += from.area;
+        to.weight += from.weight;
+        to.weight_x += from.weight_x;
+        to.weight_y += from.weight_y;
+        to.peak = std::max(to.peak, from.peak);
+    }
+    last_components_ = roots_.size();
+    roots_.erase(std::remove_if(roots_.begin(), roots_.end(),
+                                [&](uint32_t label) { return blobs_[label].area < options_.min_area; }),
+                 roots_.end());
+
+    const size_t count = std::min(capacity, roots_.size());
+    std::partial_sort(roots_.begin(), roots_.begin() + static_cast<std::ptrdiff_t>(count), roots_.end(),
+                      [&](uint32_t a, uint32_t b) {
+                          const Blob& ba = blobs_[a];
+                          const Blob& bb = blobs_[b];
+                          if (ba.peak != bb.peak) {
+                              return ba.peak > bb.peak;
+                          }
+                          if (ba.area != bb.area) {
+                              return ba.area > bb.area;
+                          }
+                          return a < b;
+                      });
+    for (size_t i = 0; i < count; ++i) {
+        const Blob& blob = blobs_[roots_[i]];
+        const double weight = static_cast<double>(blob.weight);
+        // Pixel centers: pixel x spans [x, x + 1).
+        out[i].x = static_cast<float>((blob.weight_x / weight + 0.5) / plane.width);
+        out[i].y = static_cast<float>((blob.weight_y / weight + 0.5) / plane.height);
+        out[i].brightness = static_cast<float>(blob.peak) / 255.0f;
+        out[i].area = static_cast<uint32_t>(std::min<uint64_t>(blob.area, UINT32_MAX));
+    }
+    return count;
+}
+
+float center_brightness(const Plane& plane) {
+    if (plane.data == nullptr || plane.width <= 0 || plane.height <= 0) {
+        return 0.0f;
+    }
+    constexpr int kRadius = 15;
+    const int cx = plane.width / 2;
+    const int cy = plane.height / 2;
+    uint32_t total = 0;
+    uint32_t count = 0;
+    for (int dy = -kRadius; dy <= kRadius; dy += 2) {
+        for (int dx = -kRadius; dx <= kRadius; dx += 2) {
+            const int x = cx + dx;
+            const int y = cy + dy;
+            if (dx * dx + dy * dy > kRadius * kRadius || x < 0 || x >= plane.width || y < 0 || y >= plane.height) {
+                continue;
+            }
+            total += plane.data[static_cast<size_t>(y) * static_cast<size_t>(plane.row_stride) +
+                                static_cast<size_t>(x) * static_cast<size_t>(plane.pixel_stride)];
+            ++count;
+        }
+    }
+    return count > 0 ? static_cast<float>(total) / static_cast<float>(count) / 255.0f : 0.0f;
+}
+
+namespace {
+
+// out[i] = max(p[2i], p[2i + 1]) for the 32 bytes of a then b.
+#if defined(__SSE2__)
+inline __m128i pair_max(__m128i a, __m128i b) {
+    const __m128i low = _mm_set1_epi16(0x00FF);
+    a = _mm_and_si128(_mm_max_epu8(a, _mm_srli_epi16(a, 8)), low);
+    b = _mm_and_si128(_mm_max_epu8(b, _mm_srli_epi16(b, 8)), low);
+    return _mm_packus_epi16(a, b);
+}
+#elif defined(__aarch64__)
+inline uint8x16_t pair_max(uint8x16_t a, uint8x16_t b) { return vpmaxq_u8(a, b); }
+#endif
+
+// 16 output pixels at output column `x` of `factor` contiguous rows.
+void downsample_block16(const uint8_t* const* rows, int factor, int x, uint8_t* out) {
+#if defined(__SSE2__)
+    __m128i v[4];
+    for (int k = 0; k < factor; ++k) {
+        const size_t offset = static_cast<size_t>(x) * factor + 16 * k;
+        v[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[0] + offset));
+        for (int r = 1; r < factor; ++r) {
+            v[k] = _mm_max_epu8(v[k], _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[r] + offset)));
+        }
+    }
+    for (int n = factor; n > 1; n /= 2) {
+        for (int k = 0; k < n / 2; ++k) {
+            v[k] = pair_max(v[2 * k], v[2 * k + 1]);
+        }
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v[0]);
+#elif defined(__aarch64__)
+    uint8x16_t v[4];
+    for (int k = 0; k < factor; ++k) {
+        const size_t offset = static_cast<size_t>(x) * factor + 16 * k;
+        v[k] = vld1q_u8(rows[0] + offset);
+        for (int r = 1; r < factor; ++r) {
+            v[k] = vmaxq_u8(v[k], vld1q_u8(rows[r] + offset));
+        }
+    }
+    for (int n = factor; n > 1; n /= 2) {
+        for (int k = 0; k < n / 2; ++k) {
+            v[k] = pair_max(v[2 * k], v[2 * k + 1]);
+        }
+    }
+    vst1q_u8(out, v[0]);
+#else
+    for (int i = 0; i < 16; ++i) {
+        uint8_t peak = 0;
+        for (int r = 0; r < factor; ++r) {
+            for (int c = 0; c < factor; ++c) {
+                peak = std::max(peak, rows[r][static_cast<size_t>(x + i) * factor + c]);
+            }
+        }
+        out[i] = peak;
+    }
+#endif
+}
+
+}  // namespace
+
+void downsample_max(const Plane& src, int factor, uint8_t* dst, int dst_stride) {
+    const int width = src.width / factor;
+    const int height = src.height / factor;
+    const size_t row_stride = static_cast<size_t>(src.row_stride);
+    const size_t pixel_stride = static_cast<size_t>(src.pixel_stride);
+    for (int y = 0; y < height; ++y) {
+        uint8_t* out = dst + static_cast<size_t>(y) * dst_stride;
+        const uint8_t* rows[4];
+        for (int r = 0; r < factor; ++r) {
+            rows[r] = src.data + (static_cast<size_t>(y) * factor + r) * row_stride;
+        }
+        int x = 0;
+        if (pixel_stride == 1) {
+            if (factor == 1) {
+                std::memcpy(out, rows[0], static_cast<size_t>(width));
+                continue;
+            }
+            for (; x + 16 <= width; x += 16) {
+                downsample_block16(rows, factor, x, out + x);
+            }
+        }
+        for (; x < width; ++x) {
+            uint8_t peak = 0;
+            for (int r = 0; r < factor; ++r) {
+                for (int c = 0; c < factor; ++c) {
+                    peak = std::max(peak, rows[r][(static_cast<size_t>(x) * factor + c) * pixel_stride]);
+                }
+            }
+            out[x] = peak;
+        }
+    }
+}
+
+}  // namespace spark
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+namespace {
+
+struct Registry {
+    std::mutex mu;
+    long next = 1;
+    std::unordered_map<long, std::shared_ptr<estream::spark::Detector>> detectors;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+std::shared_ptr<estream::spark::Detector> find_detector(long handle) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    auto it = r.detectors.find(handle);
+    return it != r.detectors.end() ? it->second : nullptr;
+}
+
+estream::spark::Plane make_plane(const uint8_t* y_plane, int width, int height, int row_stride, int pixel_stride) {
+    estream::spark::Plane plane;
+    plane.data = y_plane;
+    plane.width = width;
+    plane.height = height;
+    plane.row_stride = row_stride;
+    plane.pixel_stride = pixel_stride;
+    return plane;
+}
+
+}  // namespace
+
+extern "C" long estream_spark_detector_create(int threshold, int min_area) {
+    if (threshold < 0 || threshold > 255 || min_area < 0) {
+        return -1;
+    }
+    estream::spark::Options options;
+    if (threshold > 0) {
+        options.threshold = static_cast<uint8_t>(threshold);
+    }
+    if (min_area > 0) {
+        options.min_area = static_cast<uint32_t>(min_area);
+    }
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    const long handle = r.next++;
+    r.detectors.emplace(handle, std::make_shared<estream::spark::Detector>(options));
+    return handle;
+}
+
+extern "C" void estream_spark_detector_destroy(long detector) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    r.detectors.erase(detector);
+}
+
+extern "C" int estream_spark_detect(long detector, const uint8_t* y_plane, int width, int height,
+                                    int row_stride, int pixel_stride,
+                                    EstreamSparkParticle* out, int capacity) {
+    auto target = find_detector(detector);
+    if (target == nullptr || y_plane == nullptr || out == nullptr || capacity < 0 ||
+        width <= 0 || height <= 0 || pixel_stride < 1 || row_stride < width * pixel_stride) {
+        return -1;
+    }
+    thread_local std::vector<estream::spark::Particle> found;
+    found.resize(static_cast<size_t>(capacity));
+    const size_t count = target->detect(make_plane(y_plane, width, height, row_stride, pixel_stride),
+                                        found.data(), found.size());
+    for (size_t i = 0; i < count; ++i) {
+        out[i].x = found[i].x;
+        out[i].y = found[i].y;
+        out[i].brightness = found[i].brightness;
+        out[i].area = found[i].area;
+    }
+    return static_cast<int>(count);
+}
+
+extern "C" float estream_spark_center_brightness(const uint8_t* y_plane, int width, int height,
+                                                 int row_stride, int pixel_stride) {
+    if (y_plane == nullptr || pixel_stride < 1 || row_stride < width * pixel_stride) {
+        return 0.0f;
+    }
+    return estream::spark::center_brightness(make_plane(y_plane, width, height, row_stride, pixel_stride));
+}
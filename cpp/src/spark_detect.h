@@ -0,0 +1,119 @@
+/**
+ * Spark particle detection on the luma (Y) plane of a camera frame.
+ *
+ * A pixel belongs to a particle when its luma is above the threshold. Each
+ * row is thresholded 16 pixels at a time (SSE2 / NEON compare to a bit
+ * mask, all-dark blocks skipped), turned into runs, and runs are joined
+ * into 8-connected components in the same pass with a union-find over run
+ * labels. A particle's position is the centroid of its pixels weighted by
+ * how far they exceed the threshold, so it is sub-pixel and does not snap
+ * to the brightest pixel.
+ *
+ * Scratch buffers live in the Detector and are reused, so after the first
+ * few frames detect() does not allocate.
+ */
+
+#ifndef ESTREAM_SPARK_DETECT_H
+#define ESTREAM_SPARK_DETECT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace estream {
+namespace spark {
+
+/// Luma above which a pixel is part of a particle (SparkFrameProcessor's
+/// BRIGHTNESS_THRESHOLD).
+constexpr uint8_t kBrightnessThreshold = 170;
+
+/// Particles reported per frame when the caller does not say.
+constexpr size_t kMaxParticles = 12;
+
+/// One 8-bit plane. `pixel_stride` is 1 for the Y plane of YUV_420_888 and
+/// NV12 buffers.
+struct Plane {
+    const uint8_t* data = nullptr;
+    int width = 0;
+    int height = 0;
+    int row_stride = 0;
+    int pixel_stride = 1;
+};
+
+struct Particle {
+    /// Weighted centroid, normalized to [0, 1] by the frame size.
+    float x;
+    float y;
+    /// Peak luma / 255.
+    float brightness;
+    /// Pixels above the threshold.
+    uint32_t area;
+};
+
+struct Options {
+    uint8_t threshold = kBrightnessThreshold;
+    /// Components smaller than this are treated as sensor noise.
+    uint32_t min_area = 1;
+};
+
+/// Bit i of the result is set when p[i] > threshold (i < 16).
+uint32_t threshold_mask16(const uint8_t* p, uint8_t threshold);
+
+class Detector {
+public:
+    explicit Detector(const Options& options = Options());
+
+    /// Find particles in `plane`, brightest first (ties: larger first), and
+    /// write up to `capacity` of them to `out`. Returns the number written.
+    /// One thread at a time per Detector.
+    size_t detect(const Plane& plane, Particle* out, size_t capacity);
+
+    /// Components found by the last detect(), before min_area and capacity.
+    size_t last_components() const { return last_components_; }
+
+    const Options& options() const { return options_; }
+
+private:
+    struct Run {
+        int x0;
+        int x1;  // Exclusive.
+        uint32_t label;
+    };
+
+    struct Blob {
+        uint64_t area;
+        uint64_t weight;
+        uint64_t weight_x;
+        uint64_t weight_y;
+        uint32_t peak;
+    };
+
+    void scan_row(const uint8_t* row, int width, int y);
+    uint32_t find(uint32_t label);
+    void unite(uint32_t a, uint32_t b);
+
+    Options options_;
+    std::vector<Run> previous_;
+    std::vector<Run> current_;
+    std::vector<uint32_t> parent_;
+    std::vector<Blob> blobs_;
+    std::vector<uint32_t> roots_;
+    std::vector<uint8_t> gather_;
+    size_t last_components_ = 0;
+};
+
+/// Mean luma / 255 over a disc of radius 15 at the frame center, sampling
+/// every second pixel (the value SparkScannerModule records per frame).
+float center_brightness(const Plane& plane);
+
+/// Shrink `src` by `factor` (1, 2 or 4) into `dst`: each output pixel is
+/// the brightest of its factor x factor block, so a particle smaller than
+/// the block still crosses the threshold. The output is
+/// (width / factor) x (height / factor), `dst_stride` bytes per row; a
+/// partial block at the right or bottom edge is dropped.
+void downsample_max(const Plane& src, int factor, uint8_t* dst, int dst_stride);
+
+}  // namespace spark
+}  // namespace estream
+
+#endif /* ESTREAM_SPARK_DETECT_H */
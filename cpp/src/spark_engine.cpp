@@ -0,0 +1,246 @@
+#include "spark_engine.h"
+
+#include "json.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace estream {
+namespace spark {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+}  // namespace
+
+const char* motion_name(Motion motion) {
+    switch (motion) {
+        case Motion::NoMotion:
+            return "no_motion";
+        case Motion::Clockwise:
+            return "cw";
+        case Motion::CounterClockwise:
+            return "ccw";
+        case Motion::Mixed:
+            return "mixed";
+        default:
+            return "insufficient";
+    }
+}
+
+MotionTracker::MotionTracker(const MotionConfig& config)
+    : config_(config), votes_(std::max<size_t>(config.window, 2)) {}
+
+void MotionTracker::reset() {
+    head_ = 0;
+    size_ = 0;
+    clockwise_ = 0;
+    counter_clockwise_ = 0;
+}
+
+MotionTracker::Votes MotionTracker::compare(const FrameResult& prev, const FrameResult& curr) const {
+    // analyzeMotion: match each of the brightest particles to the nearest
+    // one of the previous frame and vote on its turn around the center.
+    // Same float/double mix as the Kotlin it replaces.
+    Votes votes;
+    const size_t n = std::min<size_t>(curr.count, config_.particles);
+    for (size_t i = 0; i < n; ++i) {
+        const Particle& c = curr.particles[i];
+        double min_dist = std::numeric_limits<double>::max();
+        const Particle* best = nullptr;
+        for (uint32_t j = 0; j < prev.count; ++j) {
+            const Particle& p = prev.particles[j];
+            const float dx = c.x - p.x;
+            const float dy = c.y - p.y;
+            const double dist = std::sqrt(static_cast<double>(dx * dx + dy * dy));
+            if (dist < min_dist && dist < config_.match_distance) {
+                min_dist = dist;
+                best = &p;
+            }
+        }
+        if (best == nullptr) {
+            continue;
+        }
+        const double prev_angle = std::atan2(static_cast<double>(best->y - 0.5f), static_cast<double>(best->x - 0.5f));
+        const double curr_angle = std::atan2(static_cast<double>(c.y - 0.5f), static_cast<double>(c.x - 0.5f));
+        double delta = curr_angle - prev_angle;
+        if (delta > kPi) delta -= 2 * kPi;
+        if (delta < -kPi) delta += 2 * kPi;
+        if (std::fabs(delta) > config_.min_angle) {
+            if (delta > 0) {
+                ++votes.clockwise;
+            } else {
+                ++votes.counter_clockwise;
+            }
+        }
+    }
+    return votes;
+}
+
+void MotionTracker::add(const FrameResult& frame) {
+    const Votes votes = size_ > 0 ? compare(last_, frame) : Votes();
+    last_ = frame;
+    if (size_ == votes_.size()) {
+        // The oldest frame leaves; the next one's votes were against it.
+        head_ = (head_ + 1) % votes_.size();
+        --size_;
+        clockwise_ -= votes_[head_].clockwise;
+        counter_clockwise_ -= votes_[head_].counter_clockwise;
+    }
+    votes_[(head_ + size_) % votes_.size()] = votes;
+    if (size_ > 0) {
+        clockwise_ += votes.clockwise;
+        counter_clockwise_ += votes.counter_clockwise;
+    }
+    ++size_;
+}
+
+double MotionTracker::score() const {
+    const uint32_t total = clockwise_ + counter_clockwise_;
+    if (size_ < config_.min_frames || total < config_.min_samples) {
+        return 0.0;
+    }
+    const double diff = std::abs(static_cast<long long>(clockwise_) - static_cast<long long>(counter_clockwise_));
+    return diff / total;
+}
+
+Motion MotionTracker::direction() const {
+    if (size_ < config_.min_frames) {
+        return Motion::Insufficient;
+    }
+    if (clockwise_ + counter_clockwise_ < config_.min_samples) {
+        return Motion::NoMotion;
+    }
+    if (clockwise_ > counter_clockwise_ * 1.2) {
+        return Motion::Clockwise;
+    }
+    if (counter_clockwise_ > clockwise_ * 1.2) {
+        return Motion::CounterClockwise;
+    }
+    return Motion::Mixed;
+}
+
+ScanEngine::ScanEngine(const Options& options, const MotionConfig& motion)
+    : detector_(options), motion_(motion) {}
+
+bool ScanEngine::submit(const Plane& plane, double timestamp_ms) {
+    return submit(plane, timestamp_ms, center_brightness(plane), generation());
+}
+
+bool ScanEngine::submit(const Plane& plane, double timestamp_ms, float center_brightness, uint32_t generation) {
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    FrameResult* slot = queue_.acquire();
+    if (slot == nullptr) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    slot->timestamp_ms = timestamp_ms;
+    slot->generation = generation;
+    slot->count = static_cast<uint32_t>(detector_.detect(plane, slot->particles, kMaxParticles));
+    slot->center_brightness = center_brightness;
+    queue_.commit();
+    return true;
+}
+
+size_t ScanEngine::poll() {
+    const uint32_t generation = generation_.load(std::memory_order_relaxed);
+    size_t consumed = 0;
+    while (const FrameResult* frame = queue_.front()) {
+        if (frame->generation == generation) {
+            consume(*frame);
+            ++consumed;
+        }
+        queue_.pop();
+    }
+    return consumed;
+}
+
+void ScanEngine::consume(const FrameResult& frame) {
+    if (frames_ == 0) {
+        first_ms_ = frame.timestamp_ms;
+    }
+    last_ms_ = frame.timestamp_ms;
+    ++frames_;
+    last_ = frame;
+    motion_.add(frame);
+    if (verifier_ != nullptr) {
+        float xy[2 * kMaxParticles];
+        for (uint32_t i = 0; i < frame.count; ++i) {
+            xy[2 * i] = frame.particles[i].x;
+            xy[2 * i + 1] = frame.particles[i].y;
+        }
+        verifier_->add_frame(frame.timestamp_ms, xy, frame.count);
+    }
+}
+
+void ScanEngine::reset() {
+    // Frames the camera thread is detecting now carry the old generation
+    // and are skipped by the next poll().
+    generation_.fetch_add(1, std::memory_order_release);
+    poll();
+    motion_.reset();
+    verifier_.reset();
+    frames_ = 0;
+    first_ms_ = 0.0;
+    last_ms_ = 0.0;
+    last_ = FrameResult{};
+    submitted_base_ = submitted_.load(std::memory_order_relaxed);
+    dropped_base_ = dropped_.load(std::memory_order_relaxed);
+}
+
+void ScanEngine::start_liveness(const uint8_t* pubkey, size_t len, int64_t timestamp) {
+    LivenessConfig config;
+    config.ordered = false;
+    verifier_ = std::make_unique<LivenessVerifier>(pubkey, len, timestamp, config);
+}
+
+uint64_t ScanEngine::submitted() const {
+    return submitted_.load(std::memory_order_relaxed) - submitted_base_;
+}
+
+uint64_t ScanEngine::dropped() const {
+    return dropped_.load(std::memory_order_relaxed) - dropped_base_;
+}
+
+void append_fields(std::string& out, const ScanEngine& engine) {
+    const MotionTracker& motion = engine.motion();
+    out += "\"frames\":";
+    json::append_uint(out, engine.frames());
+    out += ",\"frames_submitted\":";
+    json::append_uint(out, engine.submitted());
+    out += ",\"frames_dropped\":";
+    json::append_uint(out, engine.dropped());
+    out += ",\"window_frames\":";
+    json::append_uint(out, motion.frames());
+    out += ",\"duration_ms\":";
+    json::append_double(out, engine.duration_ms());
+    out += ",\"particles\":";
+    json::append_uint(out, engine.last_frame().count);
+    out += ",\"center_brightness\":";
+    json::append_double(out, engine.last_frame().center_brightness);
+    out += ",\"motion_score\":";
+    json::append_double(out, motion.score());
+    out += ",\"direction\":";
+    json::append_string(out, motion_name(motion.direction()));
+    out += ",\"motion_detected\":";
+    out += motion.detected() ? "true" : "false";
+    out += ",\"liveness\":";
+    if (engine.verifier() != nullptr) {
+        append_json(out, *engine.verifier());
+    } else {
+        out += "null";
+    }
+}
+
+std::string to_json(const ScanEngine& engine) {
+    std::string out = "{\"success\":true,\"data\":{";
+    append_fields(out, engine);
+    out += "}}";
+    return out;
+}
+
+}  // namespace spark
+}  // namespace estream
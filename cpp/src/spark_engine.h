@@ -0,0 +1,199 @@
+/**
+ * Native Spark scan pipeline: detection, motion analysis and liveness.
+ *
+ * The camera thread hands each frame's Y plane to ScanEngine::submit() by
+ * pointer and stride, straight from the camera buffer. The particles are
+ * detected coarse to fine (spark_pyramid.h) into a slot of a lock-free
+ * single-producer/single-consumer queue of compact fixed-size results. The
+ * app thread drains the queue when it polls (poll()), folding each frame
+ * into the orbital motion check SparkScannerModule ran over its frame list
+ * and into the liveness verifier. Nothing on the frame path allocates or
+ * takes a lock; when the app falls behind, new frames are dropped and
+ * counted instead of queued. FramePipeline (spark_pipeline.h) runs the
+ * same stages on their own threads.
+ */
+
+#ifndef ESTREAM_SPARK_ENGINE_H
+#define ESTREAM_SPARK_ENGINE_H
+
+#include "spark_detect.h"
+#include "spark_liveness.h"
+#include "spark_pyramid.h"
+#include "spsc_queue.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace estream {
+namespace spark {
+
+/// Frame results buffered between the camera and the app thread (about
+/// two seconds at 30 fps).
+constexpr size_t kFrameQueueSize = 64;
+
+/// What the pipeline keeps of one frame.
+struct FrameResult {
+    double timestamp_ms;
+    /// ScanEngine::reset() count when the frame was submitted.
+    uint32_t generation;
+    uint32_t count;
+    float center_brightness;
+    Particle particles[kMaxParticles];
+};
+
+enum class Motion {
+    Insufficient,
+    NoMotion,
+    Clockwise,
+    CounterClockwise,
+    Mixed,
+};
+
+/// "insufficient", "no_motion", "cw", "ccw" or "mixed".
+const char* motion_name(Motion motion);
+
+/// SparkScannerModule's analyzeMotion constants.
+struct MotionConfig {
+    /// Frames needed before motion is scored (MIN_FRAMES).
+    size_t min_frames = 15;
+    /// Most recent frames analyzed (MAX_FRAMES).
+    size_t window = 100;
+    /// Brightest particles of a frame matched against the previous frame.
+    size_t particles = 6;
+    /// Largest per-frame move of a matched particle.
+    float match_distance = 0.12f;
+    /// Smallest turn around the center (radians) that counts as a vote.
+    double min_angle = 0.008;
+    /// Votes needed before motion is scored (MIN_MOTION_SAMPLES).
+    uint32_t min_samples = 5;
+    /// Score above which motion is detected (MOTION_THRESHOLD).
+    double threshold = 0.03;
+};
+
+/// analyzeMotion over a sliding window, updated per frame. Each frame's
+/// votes against its predecessor are kept, so adding a frame compares two
+/// frames instead of the whole window.
+class MotionTracker {
+public:
+    explicit MotionTracker(const MotionConfig& config = MotionConfig());
+
+    void add(const FrameResult& frame);
+    void reset();
+
+    /// Frames in the window.
+    size_t frames() const { return size_; }
+    uint32_t clockwise() const { return clockwise_; }
+    uint32_t counter_clockwise() const { return counter_clockwise_; }
+    /// |cw - ccw| / votes; 0 before min_frames frames or min_samples votes.
+    double score() const;
+    Motion direction() const;
+    bool detected() const { return score() > config_.threshold; }
+
+    const MotionConfig& config() const { return config_; }
+
+private:
+    struct Votes {
+        uint32_t clockwise = 0;
+        uint32_t counter_clockwise = 0;
+    };
+
+    Votes compare(const FrameResult& prev, const FrameResult& curr) const;
+
+    MotionConfig config_;
+    // Ring over the window; entry i holds frame i's votes against frame
+    // i - 1, so the oldest entry's votes are not counted.
+    std::vector<Votes> votes_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+    uint32_t clockwise_ = 0;
+    uint32_t counter_clockwise_ = 0;
+    FrameResult last_{};
+};
+
+class ScanEngine {
+public:
+    explicit ScanEngine(const Options& options = Options(), const MotionConfig& motion = MotionConfig());
+
+    // Camera thread (one producer).
+
+    /// Detect the particles of one frame and queue the result. Returns
+    /// false, without detecting, when the queue is full.
+    bool submit(const Plane& plane, double timestamp_ms);
+
+    /// As above, for a frame captured earlier (FramePipeline): its center
+    /// brightness was measured on the full frame, and `generation` is
+    /// generation() at capture, so a frame captured before a reset() is
+    /// discarded however late it is detected.
+    bool submit(const Plane& plane, double timestamp_ms, float center_brightness, uint32_t generation);
+
+    /// Incremented by reset().
+    uint32_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+    // App thread (one consumer).
+
+    /// Fold queued frames into the motion and liveness state. Returns the
+    /// number of frames consumed.
+    size_t poll();
+
+    /// Start a new scan: queued and in-flight frames of the previous scan
+    /// are discarded, and liveness is off until start_liveness().
+    void reset();
+
+    /// Verify this scan against the pattern derived from `pubkey` and
+    /// `timestamp`. Detector output is ordered by brightness, so each
+    /// position is scored against the nearest expected particle.
+    void start_liveness(const uint8_t* pubkey, size_t len, int64_t timestamp);
+
+    const MotionTracker& motion() const { return motion_; }
+    /// nullptr unless start_liveness() was called for this scan.
+    LivenessVerifier* verifier() { return verifier_.get(); }
+    const LivenessVerifier* verifier() const { return verifier_.get(); }
+
+    /// Frames consumed this scan (including those that left the window).
+    uint64_t frames() const { return frames_; }
+    /// Frames the camera submitted, and of those dropped on a full queue,
+    /// since the last reset().
+    uint64_t submitted() const;
+    uint64_t dropped() const;
+    double duration_ms() const { return frames_ > 0 ? last_ms_ - first_ms_ : 0.0; }
+    /// The last consumed frame.
+    const FrameResult& last_frame() const { return last_; }
+
+private:
+    void consume(const FrameResult& frame);
+
+    // Producer side.
+    PyramidDetector detector_;
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint32_t> generation_{0};
+    SpscQueue<FrameResult, kFrameQueueSize> queue_;
+
+    // Consumer side.
+    MotionTracker motion_;
+    std::unique_ptr<LivenessVerifier> verifier_;
+    uint64_t frames_ = 0;
+    uint64_t submitted_base_ = 0;
+    uint64_t dropped_base_ = 0;
+    double first_ms_ = 0.0;
+    double last_ms_ = 0.0;
+    FrameResult last_{};
+};
+
+/// Append the status fields "frames", "frames_submitted", "frames_dropped",
+/// "window_frames", "duration_ms", "particles", "center_brightness",
+/// "motion_score", "direction", "motion_detected" and "liveness" (the
+/// verifier status or null) to `out`, without braces.
+void append_fields(std::string& out, const ScanEngine& engine);
+
+/// {"success":true,"data":{append_fields}}
+std::string to_json(const ScanEngine& engine);
+
+}  // namespace spark
+}  // namespace estream
+
+#endif /* ESTREAM_SPARK_ENGINE_H */
@@ -0,0 +1,356 @@
+#include "spark_liveness.h"
+
+#include "estream_app_native.h"
+#include "ffi_util.h"
+#include "json.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace estream {
+namespace spark {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr uint32_t kHashSeed = 0x9e3779b9u;
+constexpr size_t kHashBytes = 32;
+
+// h -> h * 33 + b over `data`, starting from 0. Every simpleHash256 lane
+// is seed * 33^len + this, mod 2^32.
+struct HashState {
+    uint32_t sum = 0;
+    uint32_t scale = 1;  // 33^len
+
+    void update(const uint8_t* data, size_t len) {
+        for (size_t i = 0; i < len; ++i) {
+            sum = sum * 33u + data[i];
+            scale *= 33u;
+        }
+    }
+
+    void finish(uint8_t out[kHashBytes]) const {
+        for (uint32_t i = 0; i < kHashBytes; ++i) {
+            out[i] = static_cast<uint8_t>((i * kHashSeed) * scale + sum);
+        }
+    }
+};
+
+}  // namespace
+
+void simple_hash256(const uint8_t* data, size_t len, uint8_t out[32]) {
+    HashState state;
+    state.update(data, len);
+    state.finish(out);
+}
+
+void derive_bytes(const uint8_t* key, size_t key_len, const std::string& info, uint8_t* out, size_t len) {
+    // The blocks share key || info; only the trailing block byte differs.
+    HashState prefix;
+    prefix.update(key, key_len);
+    prefix.update(reinterpret_cast<const uint8_t*>(info.data()), info.size());
+    uint8_t hash[kHashBytes];
+    for (size_t offset = 0, block = 0; offset < len; offset += kHashBytes, ++block) {
+        HashState state = prefix;
+        const uint8_t index = static_cast<uint8_t>(block);
+        state.update(&index, 1);
+        state.finish(hash);
+        std::copy(hash, hash + std::min(kHashBytes, len - offset), out + offset);
+    }
+}
+
+void derive_motion_key(const uint8_t* pubkey, size_t len, int64_t timestamp, uint8_t out[kMotionKeyBytes]) {
+    char info[48];
+    std::snprintf(info, sizeof(info), "spark-motion-%" PRId64, timestamp);
+    derive_bytes(pubkey, std::min<size_t>(len, 64), info, out, kMotionKeyBytes);
+}
+
+ParticleParams particle_params(const uint8_t* motion_key, int particle_id) {
+    const int offset = (particle_id * 5) % 60;
+    ParticleParams p;
+    p.radius = 60.0 + (motion_key[offset] / 255.0) * 50.0;
+    p.speed = 0.3 + (motion_key[offset + 1] / 255.0) * 0.8;
+    p.phase = (motion_key[offset + 2] / 255.0) * kPi * 2.0;
+    p.wobble = (motion_key[offset + 4] / 255.0) * 0.3;
+    p.direction = particle_id % 2 == 0 ? 1.0 : -1.0;
+    return p;
+}
+
+void expected_position(const ParticleParams& params, double elapsed_ms, double* x, double* y) {
+    const double t = elapsed_ms / 1000.0;
+    const double angle = params.phase + t * params.speed * params.direction;
+    const double wobble_x = std::sin(t * 2.3) * params.wobble * 10.0;
+    const double wobble_y = std::cos(t * 1.7) * params.wobble * 10.0;
+    *x = (150.0 + std::cos(angle) * params.radius + wobble_x) / 300.0;
+    *y = (150.0 + std::sin(angle) * params.radius + wobble_y) / 300.0;
+}
+
+LivenessVerifier::LivenessVerifier(const uint8_t* pubkey, size_t len, int64_t timestamp,
+                                   const LivenessConfig& config)
+    : config_(config) {
+    uint8_t key[kMotionKeyBytes];
+    derive_motion_key(pubkey, len, timestamp, key);
+    orbits_ = spark_orbits(key);
+}
+
+Decision LivenessVerifier::add_frame(double timestamp_ms, const float* xy, size_t count) {
+    if (decision_ != Decision::Pending) {
+        return decision_;
+    }
+    if (frames_ == 0) {
+        first_ms_ = timestamp_ms;
+    }
+    last_ms_ = timestamp_ms;
+    ++frames_;
+
+    const double elapsed = timestamp_ms - first_ms_;
+    double ex[kParticleCount];
+    double ey[kParticleCount];
+    orbit_positions(orbits_, &elapsed, 1, ex, ey);
+    const size_t expected = config_.ordered ? std::min<size_t>(count, kParticleCount) : kParticleCount;
+
+    const size_t observed = config_.ordered ? expected : count;
+    for (size_t i = 0; i < observed; ++i) {
+        const double ox = xy[2 * i];
+        const double oy = xy[2 * i + 1];
+        double best = std::numeric_limits<double>::infinity();
+        const size_t first = config_.ordered ? i : 0;
+        const size_t last = config_.ordered ? i + 1 : expected;
+        for (size_t j = first; j < last; ++j) {
+            const double dx = ox - ex[j];
+            const double dy = oy - ey[j];
+            best = std::min(best, dx * dx + dy * dy);
+        }
+        matches_ += std::sqrt(best) < config_.match_distance ? 1 : 0;
+        ++observations_;
+    }
+
+    update_decision();
+    return decision_;
+}
+
+void LivenessVerifier::update_decision() {
+    const bool enough = frames_ >= config_.min_frames && duration_ms() >= config_.min_duration_ms;
+    const bool timed_out = duration_ms() >= config_.max_duration_ms;
+    if (observations_ > 0 && frames_ >= config_.min_reject_frames && upper_bound() < config_.threshold) {
+        decision_ = Decision::NotLive;
+    } else if (enough && observations_ > 0 && lower_bound() >= config_.threshold) {
+        decision_ = Decision::Live;
+    } else if (timed_out) {
+        finish();
+    }
+}
+
+Decision LivenessVerifier::finish() {
+    if (decision_ == Decision::Pending) {
+        const bool enough = frames_ >= config_.min_frames && duration_ms() >= config_.min_duration_ms;
+        decision_ = enough && score() >= config_.threshold ? Decision::Live : Decision::NotLive;
+    }
+    return decision_;
+}
+
+double LivenessVerifier::score() const {
+    return observations_ > 0 ? static_cast<double>(matches_) / static_cast<double>(observations_) : 0.0;
+}
+
+namespace {
+
+// Wilson score interval: center +/- half.
+void wilson(uint64_t successes, uint64_t n, double z, double* lower, double* upper) {
+    if (n == 0) {
+        *lower = 0.0;
+        *upper = 1.0;
+        return;
+    }
+    const double nn = static_cast<double>(n);
+    const double p = static_cast<double>(successes) / nn;
+    const double z2 = z * z;
+    const double denom = 1.0 + z2 / nn;
+    const double center = (p + z2 / (2.0 * nn)) / denom;
+    const double half = z * std::sqrt(p * (1.0 - p) / nn + z2 / (4.0 * nn * nn)) / denom;
+    *lower = std::max(0.0, center - half);
+    *upper = std::min(1.0, center + half);
+}
+
+}  // namespace
+
+double LivenessVerifier::lower_bound() const {
+    double lower = 0.0;
+    double upper = 1.0;
+    wilson(matches_, observations_, config_.z, &lower, &upper);
+    return lower;
+}
+
+double LivenessVerifier::upper_bound() const {
+    double lower = 0.0;
+    double upper = 1.0;
+    wilson(matches_, observations_, config_.z, &lower, &upper);
+    return upper;
+}
+
+const char* decision_name(Decision decision) {
+    switch (decision) {
+        case Decision::Live:
+            return "live";
+        case Decision::NotLive:
+            return "not_live";
+        default:
+            return "pending";
+    }
+}
+
+void append_json(std::string& out, const LivenessVerifier& verifier) {
+    out += "{\"decision\":";
+    json::append_string(out, decision_name(verifier.decision()));
+    out += ",\"frames\":";
+    json::append_uint(out, verifier.frames());
+    out += ",\"duration_ms\":";
+    json::append_double(out, verifier.duration_ms());
+    out += ",\"matches\":";
+    json::append_uint(out, verifier.matches());
+    out += ",\"observations\":";
+    json::append_uint(out, verifier.observations());
+    out += ",\"trajectory_score\":";
+    json::append_double(out, verifier.score());
+    out += ",\"lower_bound\":";
+    json::append_double(out, verifier.lower_bound());
+    out += ",\"upper_bound\":";
+    json::append_double(out, verifier.upper_bound());
+    out += '}';
+}
+
+std::string to_json(const LivenessVerifier& verifier) {
+    std::string out = "{\"success\":true,\"data\":";
+    append_json(out, verifier);
+    out += '}';
+    return out;
+}
+
+}  // namespace spark
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+namespace {
+
+// Frames arrive on the camera thread while the app polls the status.
+struct Session {
+    std::mutex mu;
+    estream::spark::LivenessVerifier verifier;
+
+    Session(const uint8_t* pubkey, size_t len, int64_t timestamp, const estream::spark::LivenessConfig& config)
+        : verifier(pubkey, len, timestamp, config) {}
+};
+
+struct Registry {
+    std::mutex mu;
+    long next = 1;
+    std::unordered_map<long, std::shared_ptr<Session>> sessions;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+std::shared_ptr<Session> find_session(long handle) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    auto it = r.sessions.find(handle);
+    return it != r.sessions.end() ? it->second : nullptr;
+}
+
+}  // namespace
+
+extern "C" int estream_spark_derive_bytes(const uint8_t* key, int key_len, const char* info, uint8_t* out,
+                                          int len) {
+    if (key_len < 0 || (key_len > 0 && key == nullptr) || info == nullptr || len < 0 ||
+        (len > 0 && out == nullptr)) {
+        return -1;
+    }
+    estream::spark::derive_bytes(key, static_cast<size_t>(key_len), info, out, static_cast<size_t>(len));
+    return 0;
+}
+
+extern "C" int estream_spark_motion_key(const uint8_t* pubkey, int pubkey_len, int64_t timestamp, uint8_t* out) {
+    if (pubkey == nullptr || pubkey_len <= 0 || out == nullptr) {
+        return -1;
+    }
+    estream::spark::derive_motion_key(pubkey, static_cast<size_t>(pubkey_len), timestamp, out);
+    return 0;
+}
+
+extern "C" int estream_spark_particle_params(const uint8_t* pubkey, int pubkey_len, int64_t timestamp,
+                                             double* out) {
+    if (pubkey == nullptr || pubkey_len <= 0 || out == nullptr) {
+        return -1;
+    }
+    using estream::spark::kParticleCount;
+    uint8_t key[estream::spark::kMotionKeyBytes];
+    estream::spark::derive_motion_key(pubkey, static_cast<size_t>(pubkey_len), timestamp, key);
+    for (int i = 0; i < kParticleCount; ++i) {
+        const estream::spark::ParticleParams p = estream::spark::particle_params(key, i);
+        out[i] = p.radius;
+        out[kParticleCount + i] = p.speed;
+        out[2 * kParticleCount + i] = p.phase;
+        out[3 * kParticleCount + i] = p.wobble;
+        out[4 * kParticleCount + i] = p.direction;
+    }
+    return 0;
+}
+
+extern "C" long estream_spark_verifier_create(const uint8_t* pubkey, int pubkey_len, int64_t timestamp,
+                                              int ordered) {
+    if (pubkey == nullptr || pubkey_len <= 0) {
+        return -1;
+    }
+    estream::spark::LivenessConfig config;
+    config.ordered = ordered != 0;
+    auto session = std::make_shared<Session>(pubkey, static_cast<size_t>(pubkey_len), timestamp, config);
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    const long handle = r.next++;
+    r.sessions.emplace(handle, std::move(session));
+    return handle;
+}
+
+extern "C" void estream_spark_verifier_destroy(long verifier) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    r.sessions.erase(verifier);
+}
+
+extern "C" int estream_spark_verifier_add_frame(long verifier, double timestamp_ms, const float* xy, int count) {
+    auto session = find_session(verifier);
+    if (session == nullptr || count < 0 || (count > 0 && xy == nullptr)) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mu);
+    return static_cast<int>(session->verifier.add_frame(timestamp_ms, xy, static_cast<size_t>(count)));
+}
+
+extern "C" int estream_spark_verifier_finish(long verifier) {
+    auto session = find_session(verifier);
+    if (session == nullptr) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mu);
+    return static_cast<int>(session->verifier.finish());
+}
+
+extern "C" char* estream_spark_verifier_status(long verifier) {
+    auto session = find_session(verifier);
+    if (session == nullptr) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(session->mu);
+    return estream::to_c_string(estream::spark::to_json(session->verifier));
+}
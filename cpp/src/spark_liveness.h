@@ -0,0 +1,135 @@
+/**
+ * Streaming liveness verification for Spark scans.
+ *
+ * The Spark pattern's particles orbit on parameters derived from the
+ * pubkey and creation timestamp (spark.ts / Mission Control). The verifier
+ * derives them once, then scores each captured frame's particle positions
+ * against the expected orbits as the frame arrives: O(particles) per frame
+ * and no stored history. After every frame it checks a Wilson confidence
+ * interval of the match rate against the liveness threshold, so a scan can
+ * stop as soon as the outcome is statistically settled instead of after a
+ * fixed capture window.
+ */
+
+#ifndef ESTREAM_SPARK_LIVENESS_H
+#define ESTREAM_SPARK_LIVENESS_H
+
+#include "spark_orbit.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace estream {
+namespace spark {
+
+/// Particles in the pattern (PARTICLE_COUNT).
+constexpr int kParticleCount = 12;
+
+/// Bytes of motion key derived per scan.
+constexpr size_t kMotionKeyBytes = 64;
+
+/// simpleHash256 of spark.ts: 32 multiplicative (h * 33 + b) hashes that
+/// differ only in their seed, computed in one pass over `data`.
+void simple_hash256(const uint8_t* data, size_t len, uint8_t out[32]);
+
+/// deriveBytes of spark.ts: simpleHash256(key || info || block) per 32-byte
+/// block.
+void derive_bytes(const uint8_t* key, size_t key_len, const std::string& info, uint8_t* out, size_t len);
+
+/// deriveMotionSeed: derive_bytes(pubkey[:64], "spark-motion-<timestamp>", 64).
+void derive_motion_key(const uint8_t* pubkey, size_t len, int64_t timestamp, uint8_t out[kMotionKeyBytes]);
+
+struct ParticleParams {
+    double radius;
+    double speed;
+    double phase;
+    double wobble;
+    double direction;
+};
+
+/// deriveParticleParams of spark.ts.
+ParticleParams particle_params(const uint8_t* motion_key, int particle_id);
+
+/// getExpectedPosition of spark.ts: position at `elapsed_ms`, normalized to
+/// the 300 px canvas.
+void expected_position(const ParticleParams& params, double elapsed_ms, double* x, double* y);
+
+enum class Decision {
+    Pending = 0,
+    Live = 1,
+    NotLive = 2,
+};
+
+struct LivenessConfig {
+    /// verifyLiveness minimums (MIN_CAPTURE_FRAMES, MIN_CAPTURE_DURATION_MS).
+    size_t min_frames = 60;
+    double min_duration_ms = 2000.0;
+    /// LIVENESS_THRESHOLD: required fraction of matching observations.
+    double threshold = 0.80;
+    /// An observation matches within this distance (10% of the canvas).
+    double match_distance = 0.1;
+    /// Width of the confidence interval (standard deviations).
+    double z = 3.0;
+    /// Frames before a scan may be rejected early.
+    size_t min_reject_frames = 10;
+    /// Past this the point estimate decides.
+    double max_duration_ms = 6000.0;
+    /// true: observation i is particle i (verifyLiveness). false: each
+    /// observation is scored against the nearest expected particle, for
+    /// detector output ordered by brightness.
+    bool ordered = true;
+};
+
+class LivenessVerifier {
+public:
+    LivenessVerifier(const uint8_t* pubkey, size_t len, int64_t timestamp,
+                     const LivenessConfig& config = LivenessConfig());
+
+    /// Score one frame: `count` positions as x, y pairs in `xy`. Frames
+    /// after a decision are ignored. Returns the decision so far.
+    Decision add_frame(double timestamp_ms, const float* xy, size_t count);
+
+    /// Decide a pending scan the way verifyLiveness does: minimums met and
+    /// match rate at or above the threshold.
+    Decision finish();
+
+    Decision decision() const { return decision_; }
+    size_t frames() const { return frames_; }
+    double duration_ms() const { return frames_ > 0 ? last_ms_ - first_ms_ : 0.0; }
+    uint64_t matches() const { return matches_; }
+    uint64_t observations() const { return observations_; }
+    /// matches / observations (0 with none).
+    double score() const;
+    /// Wilson interval of the match rate.
+    double lower_bound() const;
+    double upper_bound() const;
+
+    const LivenessConfig& config() const { return config_; }
+
+private:
+    void update_decision();
+
+    LivenessConfig config_;
+    Orbits orbits_;
+    Decision decision_ = Decision::Pending;
+    size_t frames_ = 0;
+    double first_ms_ = 0.0;
+    double last_ms_ = 0.0;
+    uint64_t matches_ = 0;
+    uint64_t observations_ = 0;
+};
+
+const char* decision_name(Decision decision);
+
+/// Append the status object {"decision", ..., "upper_bound"} to `out`.
+void append_json(std::string& out, const LivenessVerifier& verifier);
+
+/// {"success":true,"data":{"decision","frames","duration_ms","matches",
+/// "observations","trajectory_score","lower_bound","upper_bound"}}
+std::string to_json(const LivenessVerifier& verifier);
+
+}  // namespace spark
+}  // namespace estream
+
+#endif /* ESTREAM_SPARK_LIVENESS_H */
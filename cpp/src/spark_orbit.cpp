@@ -0,0 +1,260 @@
+#include "spark_orbit.h"
+
+#include "estream_app_native.h"
+#include "spark_liveness.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace estream {
+namespace spark {
+
+namespace {
+
+// Cephes minimax polynomials for sin and cos on [-pi/4, pi/4].
+constexpr double kSin[6] = {1.58962301576546568060e-10, -2.50507477628578072866e-8, 2.75573136213857245213e-6,
+                            -1.98412698295895385996e-4, 8.33333333332211858878e-3,  -1.66666666666666307295e-1};
+constexpr double kCos[6] = {-1.13585365213876817300e-11, 2.08757008419747316778e-9, -2.75573141792967388112e-7,
+                            2.48015872888517045348e-5,   -1.38888888888730564116e-3, 4.16666666666665929218e-2};
+
+// pi/2 in three parts; q times either of the first two is exact for
+// |q| < 2^29, which keeps the reduced argument accurate.
+constexpr double kPio2A = 1.57079625129699707031e+0;
+constexpr double kPio2B = 7.54978941586159635336e-8;
+constexpr double kPio2C = 5.39030285815811905290e-15;
+constexpr double kTwoOverPi = 0.63661977236758134308;
+// Adding 1.5 * 2^52 rounds to an integer, which lands in the low mantissa
+// bits.
+constexpr double kRoundMagic = 6755399441055744.0;
+
+// v = q * pi/2 + r with |r| <= pi/4: sin and cos of r, then rotated by
+// the quadrant.
+void sincos1(double v, double* s, double* c) {
+    const double shifted = v * kTwoOverPi + kRoundMagic;
+    const double q = shifted - kRoundMagic;
+    const double r = ((v - q * kPio2A) - q * kPio2B) - q * kPio2C;
+    const double z = r * r;
+    double ps = kSin[0];
+    double pc = kCos[0];
+    for (int k = 1; k < 6; ++k) {
+        ps = ps * z + kSin[k];
+        pc = pc * z + kCos[k];
+    }
+    const double sr = r + r * z * ps;
+    const double cr = 1.0 - 0.5 * z + z * z * pc;
+    uint64_t bits;
+    std::memcpy(&bits, &shifted, sizeof(bits));
+    switch (bits & 3) {
+        case 0:
+            *s = sr;
+            *c = cr;
+            break;
+        case 1:
+            *s = cr;
+            *c = -sr;
+            break;
+        case 2:
+            *s = -sr;
+            *c = -cr;
+            break;
+        default:
+            *s = -cr;
+            *c = sr;
+            break;
+    }
+}
+
+// An Orbits set or the C API's packed columns, without copying.
+struct Columns {
+    double center;
+    double extent;
+    const double* radius;
+    const double* speed;
+    const double* phase;
+    const double* wobble_x;
+    const double* wobble_x_rate;
+    const double* wobble_y;
+    const double* wobble_y_rate;
+};
+
+void orbit1(const Columns& o, size_t i, double t, double* x, double* y) {
+    double sa, ca, swx, cwx, swy, cwy;
+    sincos1(o.phase[i] + t * o.speed[i], &sa, &ca);
+    sincos1(t * o.wobble_x_rate[i], &swx, &cwx);
+    sincos1(t * o.wobble_y_rate[i], &swy, &cwy);
+    *x = (o.center + ca * o.radius[i] + swx * o.wobble_x[i]) / o.extent;
+    *y = (o.center + sa * o.radius[i] + cwy * o.wobble_y[i]) / o.extent;
+}
+
+#if defined(__SSE2__) || defined(__aarch64__)
+#define ESTREAM_ORBIT_SIMD 1
+
+#if defined(__SSE2__)
+using Vec = __m128d;
+inline Vec load(const double* p) { return _mm_loadu_pd(p); }
+inline void store(double* p, Vec v) { _mm_storeu_pd(p, v); }
+inline Vec splat(double v) { return _mm_set1_pd(v); }
+inline Vec add(Vec a, Vec b) { return _mm_add_pd(a, b); }
+inline Vec sub(Vec a, Vec b) { return _mm_sub_pd(a, b); }
+inline Vec mul(Vec a, Vec b) { return _mm_mul_pd(a, b); }
+inline Vec div(Vec a, Vec b) { return _mm_div_pd(a, b); }
+
+// Quadrant q in the low bits of `shifted`: swap sin and cos when q is
+// odd, negate sin when bit 1 of q is set and cos when bit 1 of q + 1 is.
+inline void rotate(Vec shifted, Vec sr, Vec cr, Vec* s, Vec* c) {
+    const __m128i q = _mm_castpd_si128(shifted);
+    const __m128i one = _mm_set1_epi64x(1);
+    const __m128i two = _mm_set1_epi64x(2);
+    const __m128d swap = _mm_castsi128_pd(_mm_sub_epi64(_mm_setzero_si128(), _mm_and_si128(q, one)));
+    const __m128d sin_sign = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(q, two), 62));
+    const __m128d cos_sign = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(_mm_add_epi64(q, one), two), 62));
+    const __m128d ss = _mm_or_pd(_mm_and_pd(swap, cr), _mm_andnot_pd(swap, sr));
+    const __m128d cc = _mm_or_pd(_mm_and_pd(swap, sr), _mm_andnot_pd(swap, cr));
+    *s = _mm_xor_pd(ss, sin_sign);
+    *c = _mm_xor_pd(cc, cos_sign);
+}
+#else
+using Vec = float64x2_t;
+inline Vec load(const double* p) { return vld1q_f64(p); }
+inline void store(double* p, Vec v) { vst1q_f64(p, v); }
+inline Vec splat(double v) { return vdupq_n_f64(v); }
+inline Vec add(Vec a, Vec b) { return vaddq_f64(a, b); }
+inline Vec sub(Vec a, Vec b) { return vsubq_f64(a, b); }
+inline Vec mul(Vec a, Vec b) { return vmulq_f64(a, b); }
+inline Vec div(Vec a, Vec b) { return vdivq_f64(a, b); }
+
+inline void rotate(Vec shifted, Vec sr, Vec cr, Vec* s, Vec* c) {
+    const uint64x2_t q = vreinterpretq_u64_f64(shifted);
+    const uint64x2_t one = vdupq_n_u64(1);
+    const uint64x2_t two = vdupq_n_u64(2);
+    const uint64x2_t swap = vtstq_u64(q, one);
+    const uint64x2_t sin_sign = vshlq_n_u64(vandq_u64(q, two), 62);
+    const uint64x2_t cos_sign = vshlq_n_u64(vandq_u64(vaddq_u64(q, one), two), 62);
+    *s = vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(vbslq_f64(swap, cr, sr)), sin_sign));
+    *c = vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(vbslq_f64(swap, sr, cr)), cos_sign));
+}
+#endif
+
+// sincos1 on two lanes.
+inline void sincos2(Vec v, Vec* s, Vec* c) {
+    const Vec magic = splat(kRoundMagic);
+    const Vec shifted = add(mul(v, splat(kTwoOverPi)), magic);
+    const Vec q = sub(shifted, magic);
+    const Vec r = sub(sub(sub(v, mul(q, splat(kPio2A))), mul(q, splat(kPio2B))), mul(q, splat(kPio2C)));
+    const Vec z = mul(r, r);
+    Vec ps = splat(kSin[0]);
+    Vec pc = splat(kCos[0]);
+    for (int k = 1; k < 6; ++k) {
+        ps = add(mul(ps, z), splat(kSin[k]));
+        pc = add(mul(pc, z), splat(kCos[k]));
+    }
+    const Vec sr = add(r, mul(mul(r, z), ps));
+    const Vec cr = add(sub(splat(1.0), mul(splat(0.5), z)), mul(mul(z, z), pc));
+    rotate(shifted, sr, cr, s, c);
+}
+#endif
+
+void evaluate(const Columns& o, size_t n, const double* elapsed_ms, size_t frames, double* x, double* y) {
+    for (size_t f = 0; f < frames; ++f) {
+        const double t = elapsed_ms[f] / 1000.0;
+        double* xs = x + f * n;
+        double* ys = y + f * n;
+        size_t i = 0;
+#if defined(ESTREAM_ORBIT_SIMD)
+        const Vec tv = splat(t);
+        const Vec center = splat(o.center);
+        const Vec extent = splat(o.extent);
+        for (; i + 2 <= n; i += 2) {
+            Vec sa, ca, swx, cwx, swy, cwy;
+            sincos2(add(load(o.phase + i), mul(tv, load(o.speed + i))), &sa, &ca);
+            sincos2(mul(tv, load(o.wobble_x_rate + i)), &swx, &cwx);
+            sincos2(mul(tv, load(o.wobble_y_rate + i)), &swy, &cwy);
+            const Vec radius = load(o.radius + i);
+            store(xs + i, div(add(add(center, mul(ca, radius)), mul(swx, load(o.wobble_x + i))), extent));
+            store(ys + i, div(add(add(center, mul(sa, radius)), mul(cwy, load(o.wobble_y + i))), extent));
+        }
+#endif
+        for (; i < n; ++i) {
+            orbit1(o, i, t, xs + i, ys + i);
+        }
+    }
+}
+
+}  // namespace
+
+void Orbits::add(double r, double s, double p, double wx, double wx_rate, double wy, double wy_rate) {
+    radius.push_back(r);
+    speed.push_back(s);
+    phase.push_back(p);
+    wobble_x.push_back(wx);
+    wobble_x_rate.push_back(wx_rate);
+    wobble_y.push_back(wy);
+    wobble_y_rate.push_back(wy_rate);
+}
+
+Orbits spark_orbits(const uint8_t* motion_key) {
+    // getExpectedPosition: 150 + cos(angle) * radius + sin(t * 2.3) *
+    // wobble * 10, over 300.
+    Orbits orbits;
+    orbits.center = 150.0;
+    orbits.extent = 300.0;
+    for (int i = 0; i < kParticleCount; ++i) {
+        const ParticleParams p = particle_params(motion_key, i);
+        orbits.add(p.radius, p.speed * p.direction, p.phase, p.wobble * 10.0, 2.3, p.wobble * 10.0, 1.7);
+    }
+    return orbits;
+}
+
+void sincos(const double* v, size_t n, double* sin_out, double* cos_out) {
+    size_t i = 0;
+#if defined(ESTREAM_ORBIT_SIMD)
+    for (; i + 2 <= n; i += 2) {
+        Vec s, c;
+        sincos2(load(v + i), &s, &c);
+        store(sin_out + i, s);
+        store(cos_out + i, c);
+    }
+#endif
+    for (; i < n; ++i) {
+        sincos1(v[i], sin_out + i, cos_out + i);
+    }
+}
+
+void orbit_positions(const Orbits& orbits, const double* elapsed_ms, size_t frames, double* x, double* y) {
+    const Columns columns{orbits.center,
+                          orbits.extent,
+                          orbits.radius.data(),
+                          orbits.speed.data(),
+                          orbits.phase.data(),
+                          orbits.wobble_x.data(),
+                          orbits.wobble_x_rate.data(),
+                          orbits.wobble_y.data(),
+                          orbits.wobble_y_rate.data()};
+    evaluate(columns, orbits.size(), elapsed_ms, frames, x, y);
+}
+
+}  // namespace spark
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" int estream_spark_orbit_positions(const double* orbits, int count, double center, double extent,
+                                             const double* elapsed_ms, int frames, double* x, double* y) {
+    if (orbits == nullptr || count < 0 || extent == 0.0 || frames < 0 ||
+        (frames > 0 && (elapsed_ms == nullptr || x == nullptr || y == nullptr))) {
+        return -1;
+    }
+    const size_t n = static_cast<size_t>(count);
+    const estream::spark::Columns columns{center,         extent,         orbits,         orbits + n,
+                                          orbits + 2 * n, orbits + 3 * n, orbits + 4 * n, orbits + 5 * n,
+                                          orbits + 6 * n};
+    estream::spark::evaluate(columns, n, elapsed_ms, static_cast<size_t>(frames), x, y);
+    return 0;
+}
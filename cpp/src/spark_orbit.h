@@ -0,0 +1,65 @@
+/**
+ * Batch evaluation of orbiting particle positions.
+ *
+ * The Spark pattern (spark.ts getExpectedPosition), the Spark auth
+ * challenge and LatticeCodeScreen all move particles on circles with a
+ * small periodic wobble. Orbits holds such a set as structure of arrays,
+ * and orbit_positions() evaluates every particle at a whole array of
+ * elapsed times in one call, writing x and y to two flat arrays. The sines
+ * and cosines come from a polynomial sincos that computes both from one
+ * range reduction, two lanes at a time (SSE2 / NEON), instead of separate
+ * libm calls per coordinate.
+ */
+
+#ifndef ESTREAM_SPARK_ORBIT_H
+#define ESTREAM_SPARK_ORBIT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace estream {
+namespace spark {
+
+/// Columns of an Orbits set, in the order of the C API's packed layout.
+constexpr int kOrbitColumns = 7;
+
+/// Entry i of each column describes particle i. At t seconds it is at
+///
+///   x = (center + cos(phase + t * speed) * radius + sin(t * wobble_x_rate) * wobble_x) / extent
+///   y = (center + sin(phase + t * speed) * radius + cos(t * wobble_y_rate) * wobble_y) / extent
+///
+/// `speed` is signed: negative turns the other way.
+struct Orbits {
+    double center = 0.0;
+    double extent = 1.0;
+    std::vector<double> radius;
+    std::vector<double> speed;
+    std::vector<double> phase;
+    std::vector<double> wobble_x;
+    std::vector<double> wobble_x_rate;
+    std::vector<double> wobble_y;
+    std::vector<double> wobble_y_rate;
+
+    size_t size() const { return radius.size(); }
+
+    void add(double radius, double speed, double phase, double wobble_x, double wobble_x_rate, double wobble_y,
+             double wobble_y_rate);
+};
+
+/// The Spark pattern of `motion_key` (derive_motion_key) on the 300 px
+/// canvas, normalized to [0, 1].
+Orbits spark_orbits(const uint8_t* motion_key);
+
+/// sin and cos of each of `n` values. Within a few ulp of libm for
+/// |v| < 1e6; larger values lose precision in the range reduction.
+void sincos(const double* v, size_t n, double* sin_out, double* cos_out);
+
+/// Particle i at elapsed_ms[f] is written to x[f * orbits.size() + i] and
+/// y[f * orbits.size() + i].
+void orbit_positions(const Orbits& orbits, const double* elapsed_ms, size_t frames, double* x, double* y);
+
+}  // namespace spark
+}  // namespace estream
+
+#endif /* ESTREAM_SPARK_ORBIT_H */
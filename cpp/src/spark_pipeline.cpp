@@ -0,0 +1,300 @@
+#include "spark_pipeline.h"
+
+#include "estream_app_native.h"
+#include "ffi_util.h"
+#include "json.h"
+
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+
+namespace estream {
+namespace spark {
+
+namespace {
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+}  // namespace
+
+ResolutionController::ResolutionController(const PipelineConfig& config) : config_(config) {
+    config_.max_scale = config.max_scale >= 4 ? 4 : config.max_scale >= 2 ? 2 : 1;
+}
+
+int ResolutionController::update(double detect_ms) {
+    if (config_.latency_target_ms <= 0.0) {
+        return scale_;
+    }
+    smoothed_ = smoothed_ > 0.0 ? smoothed_ + config_.smoothing * (detect_ms - smoothed_) : detect_ms;
+    if (++since_change_ < config_.settle_frames) {
+        return scale_;
+    }
+    // Each step changes the pixel count, and roughly the cost, by 4x; the
+    // smoothed time is rescaled so the next decision starts from a guess.
+    const double target = config_.latency_target_ms;
+    if (smoothed_ > target && scale_ < config_.max_scale) {
+        scale_ *= 2;
+        smoothed_ /= 4.0;
+        since_change_ = 0;
+    } else if (scale_ > 1 && smoothed_ * 4.0 < target * 0.7) {
+        scale_ /= 2;
+        smoothed_ *= 4.0;
+        since_change_ = 0;
+    }
+    return scale_;
+}
+
+FramePipeline::FramePipeline(const Options& options, const PipelineConfig& config)
+    : config_(config), engine_(options), controller_(config) {
+    if (threaded()) {
+        detection_ = std::thread(&FramePipeline::detection_loop, this);
+        trajectory_ = std::thread(&FramePipeline::trajectory_loop, this);
+    }
+}
+
+FramePipeline::~FramePipeline() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mu_);
+        stopping_ = true;
+    }
+    frame_ready_.notify_all();
+    result_ready_.notify_all();
+    if (detection_.joinable()) {
+        detection_.join();
+    }
+    if (trajectory_.joinable()) {
+        trajectory_.join();
+    }
+}
+
+bool FramePipeline::submit(const Plane& plane, double timestamp_ms) {
+    captured_.fetch_add(1, std::memory_order_relaxed);
+    if (!threaded()) {
+        return engine_.submit(plane, timestamp_ms);
+    }
+
+    const int scale = scale_.load(std::memory_order_relaxed);
+    const int width = plane.width / scale;
+    const int height = plane.height / scale;
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+    Slot& slot = slots_[back_];
+    const size_t bytes = static_cast<size_t>(width) * static_cast<size_t>(height);
+    if (slot.pixels.size() < bytes) {
+        // Only until each slot has held a full-resolution frame.
+        slot.pixels.resize(bytes);
+    }
+    downsample_max(plane, scale, slot.pixels.data(), width);
+    slot.plane.data = slot.pixels.data();
+    slot.plane.width = width;
+    slot.plane.height = height;
+    slot.plane.row_stride = width;
+    slot.plane.pixel_stride = 1;
+    slot.timestamp_ms = timestamp_ms;
+    slot.center_brightness = center_brightness(plane);
+    slot.generation = engine_.generation();
+    slot.captured_ns = now_ns();
+
+    const uint32_t previous = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel);
+    back_ = previous & ~kFresh;
+    if (previous & kFresh) {
+        stale_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Empty critical section: the detection thread is either before its
+    // check of middle_ or already waiting, so the wake-up is not lost.
+    { std::lock_guard<std::mutex> lock(wake_mu_); }
+    frame_ready_.notify_one();
+    return true;
+}
+
+void FramePipeline::detection_loop() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mu_);
+            frame_ready_.wait(lock, [this] {
+                return stopping_ || (middle_.load(std::memory_order_acquire) & kFresh) != 0;
+            });
+            if (stopping_) {
+                return;
+            }
+        }
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & ~kFresh;
+        const Slot& slot = slots_[front_];
+
+        const int64_t start = now_ns();
+        engine_.submit(slot.plane, slot.timestamp_ms, slot.center_brightness, slot.generation);
+        const int64_t end = now_ns();
+
+        const double latency = static_cast<double>(end - slot.captured_ns) / 1e6;
+        latency_smoothed_ = latency_smoothed_ > 0.0
+                                ? latency_smoothed_ + config_.smoothing * (latency - latency_smoothed_)
+                                : latency;
+        scale_.store(controller_.update(static_cast<double>(end - start) / 1e6), std::memory_order_relaxed);
+        detect_ms_.store(controller_.detect_ms(), std::memory_order_relaxed);
+        latency_ms_.store(latency_smoothed_, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(wake_mu_);
+            has_result_ = true;
+        }
+        result_ready_.notify_one();
+    }
+}
+
+void FramePipeline::trajectory_loop() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mu_);
+            result_ready_.wait(lock, [this] { return stopping_ || has_result_; });
+            if (stopping_) {
+                return;
+            }
+            has_result_ = false;
+        }
+        std::lock_guard<std::mutex> lock(state_mu_);
+        engine_.poll();
+    }
+}
+
+void FramePipeline::reset() {
+    std::lock_guard<std::mutex> lock(state_mu_);
+    engine_.reset();
+    captured_base_ = captured_.load(std::memory_order_relaxed);
+    stale_base_ = stale_.load(std::memory_order_relaxed);
+}
+
+void FramePipeline::start_liveness(const uint8_t* pubkey, size_t len, int64_t timestamp) {
+    std::lock_guard<std::mutex> lock(state_mu_);
+    engine_.start_liveness(pubkey, len, timestamp);
+}
+
+std::string FramePipeline::status(bool finish) {
+    std::lock_guard<std::mutex> lock(state_mu_);
+    engine_.poll();
+    if (finish && engine_.verifier() != nullptr) {
+        engine_.verifier()->finish();
+    }
+    std::string out = "{\"success\":true,\"data\":{";
+    append_fields(out, engine_);
+    out += ",\"frames_captured\":";
+    json::append_uint(out, captured_.load(std::memory_order_relaxed) - captured_base_);
+    out += ",\"frames_stale\":";
+    json::append_uint(out, stale_.load(std::memory_order_relaxed) - stale_base_);
+    out += ",\"scale\":";
+    json::append_uint(out, static_cast<unsigned long long>(scale()));
+    out += ",\"detect_ms\":";
+    json::append_double(out, detect_ms_.load(std::memory_order_relaxed));
+    out += ",\"latency_ms\":";
+    json::append_double(out, latency_ms_.load(std::memory_order_relaxed));
+    out += "}}";
+    return out;
+}
+
+}  // namespace spark
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+namespace {
+
+struct Registry {
+    std::mutex mu;
+    long next = 1;
+    std::unordered_map<long, std::shared_ptr<estream::spark::FramePipeline>> pipelines;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+std::shared_ptr<estream::spark::FramePipeline> find_pipeline(long handle) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    auto it = r.pipelines.find(handle);
+    return it != r.pipelines.end() ? it->second : nullptr;
+}
+
+}  // namespace
+
+extern "C" long estream_spark_engine_create(int threshold, double latency_target_ms) {
+    if (threshold < 0 || threshold > 255 || latency_target_ms < 0.0) {
+        return -1;
+    }
+    estream::spark::Options options;
+    if (threshold > 0) {
+        options.threshold = static_cast<uint8_t>(threshold);
+    }
+    estream::spark::PipelineConfig config;
+    config.latency_target_ms = latency_target_ms;
+    auto pipeline = std::make_shared<estream::spark::FramePipeline>(options, config);
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    const long handle = r.next++;
+    r.pipelines.emplace(handle, std::move(pipeline));
+    return handle;
+}
+
+extern "C" void estream_spark_engine_destroy(long engine) {
+    std::shared_ptr<estream::spark::FramePipeline> pipeline;
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mu);
+        auto it = r.pipelines.find(engine);
+        if (it == r.pipelines.end()) {
+            return;
+        }
+        pipeline = std::move(it->second);
+        r.pipelines.erase(it);
+    }
+    // Joining the stage threads happens here, outside the registry lock.
+}
+
+extern "C" int estream_spark_engine_submit(long engine, const uint8_t* y_plane, int width, int height,
+                                           int row_stride, int pixel_stride, double timestamp_ms) {
+    auto pipeline = find_pipeline(engine);
+    if (pipeline == nullptr || y_plane == nullptr || width <= 0 || height <= 0 || pixel_stride < 1 ||
+        row_stride < width * pixel_stride) {
+        return -1;
+    }
+    estream::spark::Plane plane;
+    plane.data = y_plane;
+    plane.width = width;
+    plane.height = height;
+    plane.row_stride = row_stride;
+    plane.pixel_stride = pixel_stride;
+    return pipeline->submit(plane, timestamp_ms) ? 1 : 0;
+}
+
+extern "C" int estream_spark_engine_reset(long engine) {
+    auto pipeline = find_pipeline(engine);
+    if (pipeline == nullptr) {
+        return -1;
+    }
+    pipeline->reset();
+    return 0;
+}
+
+extern "C" int estream_spark_engine_start_liveness(long engine, const uint8_t* pubkey, int pubkey_len,
+                                                   int64_t timestamp) {
+    auto pipeline = find_pipeline(engine);
+    if (pipeline == nullptr || pubkey == nullptr || pubkey_len <= 0) {
+        return -1;
+    }
+    pipeline->start_liveness(pubkey, static_cast<size_t>(pubkey_len), timestamp);
+    return 0;
+}
+
+extern "C" char* estream_spark_engine_status(long engine, int finish) {
+    auto pipeline = find_pipeline(engine);
+    if (pipeline == nullptr) {
+        return nullptr;
+    }
+    return estream::to_c_string(pipeline->status(finish != 0));
+}
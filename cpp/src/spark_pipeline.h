@@ -0,0 +1,159 @@
+/**
+ * Threaded Spark frame pipeline with latest-frame dropping and adaptive
+ * analysis resolution.
+ *
+ * Three stages run on separate threads:
+ *
+ *   capture     camera thread: measures the center brightness and copies
+ *               the Y plane, shrunk by the current scale factor
+ *               (downsample_max), into a triple buffer, then returns.
+ *   detection   takes the newest captured frame, detects its particles and
+ *               queues the result (ScanEngine::submit).
+ *   trajectory  drains the results into the motion and liveness state
+ *               (ScanEngine::poll).
+ *
+ * The triple buffer holds one frame between capture and detection. A frame
+ * the detector has not taken by the time the next one arrives is stale: it
+ * is overwritten and counted, so latency never builds up behind a slow
+ * detector. After each frame the detection stage feeds its own time to a
+ * ResolutionController, which raises the scale factor when detection no
+ * longer fits the latency target and lowers it again when there is room.
+ * Fast devices analyze every frame at full resolution; slow ones analyze
+ * fewer, smaller frames.
+ *
+ * With no latency target the pipeline runs inline: submit() detects on the
+ * caller's thread at full resolution and status() drains the results.
+ */
+
+#ifndef ESTREAM_SPARK_PIPELINE_H
+#define ESTREAM_SPARK_PIPELINE_H
+
+#include "spark_engine.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace estream {
+namespace spark {
+
+struct PipelineConfig {
+    /// Detection time per frame to stay under; 0 runs the stages inline.
+    double latency_target_ms = 0.0;
+    /// Largest scale factor (1, 2 or 4).
+    int max_scale = 4;
+    /// Weight of the newest frame in the smoothed detection time.
+    double smoothing = 0.2;
+    /// Frames after a change before the scale may change again.
+    size_t settle_frames = 8;
+};
+
+/// Picks the scale factor from measured detection times. Halving the
+/// resolution quarters the pixels, so a finer scale is only chosen when
+/// four times the current cost still leaves a margin under the target.
+class ResolutionController {
+public:
+    explicit ResolutionController(const PipelineConfig& config = PipelineConfig());
+
+    /// Record one frame's detection time; returns the scale for the next.
+    int update(double detect_ms);
+
+    int scale() const { return scale_; }
+    /// Smoothed detection time at the current scale.
+    double detect_ms() const { return smoothed_; }
+
+private:
+    PipelineConfig config_;
+    int scale_ = 1;
+    double smoothed_ = 0.0;
+    size_t since_change_ = 0;
+};
+
+class FramePipeline {
+public:
+    explicit FramePipeline(const Options& options = Options(), const PipelineConfig& config = PipelineConfig());
+    ~FramePipeline();
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    /// Camera thread: hand over one frame. Inline, returns false if the
+    /// result queue was full. Threaded, the frame is always taken; an
+    /// older one the detector never reached may be dropped instead.
+    bool submit(const Plane& plane, double timestamp_ms);
+
+    // Any other thread.
+
+    void reset();
+    void start_liveness(const uint8_t* pubkey, size_t len, int64_t timestamp);
+
+    /// {"success":true,"data":{ScanEngine fields, "frames_captured",
+    /// "frames_stale","scale","detect_ms","latency_ms"}}. `finish` decides
+    /// a pending liveness check.
+    std::string status(bool finish);
+
+    bool threaded() const { return config_.latency_target_ms > 0.0; }
+    /// Scale factor the next frame is captured at.
+    int scale() const { return scale_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::vector<uint8_t> pixels;
+        Plane plane;
+        double timestamp_ms = 0.0;
+        float center_brightness = 0.0f;
+        uint32_t generation = 0;
+        int64_t captured_ns = 0;
+    };
+
+    void detection_loop();
+    void trajectory_loop();
+
+    PipelineConfig config_;
+    ScanEngine engine_;
+
+    // Triple buffer: capture owns slots_[back_], detection owns
+    // slots_[front_], and middle_ holds the third index, with kFresh set
+    // while it holds a frame detection has not taken.
+    static constexpr uint32_t kFresh = 4;
+    Slot slots_[3];
+    uint32_t back_ = 0;
+    uint32_t front_ = 1;
+    std::atomic<uint32_t> middle_{2};
+    std::atomic<int> scale_{1};
+    std::atomic<uint64_t> captured_{0};
+    std::atomic<uint64_t> stale_{0};
+    uint64_t captured_base_ = 0;
+    uint64_t stale_base_ = 0;
+
+    // Detection thread only.
+    ResolutionController controller_;
+    double latency_smoothed_ = 0.0;
+
+    // Read by status().
+    std::atomic<double> detect_ms_{0.0};
+    std::atomic<double> latency_ms_{0.0};
+
+    // Consumer state of engine_ (poll, reset, liveness, status).
+    std::mutex state_mu_;
+
+    // Wake-ups. Detection waits for kFresh in middle_; the flags are
+    // guarded by wake_mu_.
+    std::mutex wake_mu_;
+    std::condition_variable frame_ready_;
+    std::condition_variable result_ready_;
+    bool has_result_ = false;
+    bool stopping_ = false;
+    std::thread detection_;
+    std::thread trajectory_;
+};
+
+}  // namespace spark
+}  // namespace estream
+
+#endif /* ESTREAM_SPARK_PIPELINE_H */
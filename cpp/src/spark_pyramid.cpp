@@ -0,0 +1,256 @@
+#include "spark_pyramid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace estream {
+namespace spark {
+
+namespace {
+
+bool valid(const Plane& plane) {
+    return plane.data != nullptr && plane.width > 0 && plane.height > 0 && plane.pixel_stride >= 1 &&
+           plane.row_stride >= plane.width * plane.pixel_stride;
+}
+
+/// Detector::detect's order: brightest first, then larger, then top to
+/// bottom.
+bool brighter(const Particle& a, const Particle& b) {
+    if (a.brightness != b.brightness) {
+        return a.brightness > b.brightness;
+    }
+    if (a.area != b.area) {
+        return a.area > b.area;
+    }
+    if (a.y != b.y) {
+        return a.y < b.y;
+    }
+    return a.x < b.x;
+}
+
+/// max-pooling shrinks a particle to a pixel or two, so min_area applies
+/// to the refined particle only.
+Options coarse_options(const Options& options) {
+    Options coarse = options;
+    coarse.min_area = 1;
+    return coarse;
+}
+
+}  // namespace
+
+PyramidDetector::PyramidDetector(const Options& options, const PyramidConfig& config)
+    : options_(options), config_(config), detector_(options), coarse_detector_(coarse_options(options)) {
+    config_.levels = std::min(std::max(config_.levels, 1), 4);
+    config_.max_tracked = std::max<size_t>(config_.max_tracked, 1);
+    candidates_.resize(config_.max_tracked);
+    window_.resize(config_.max_tracked);
+    found_.reserve(config_.max_tracked);
+    rects_.reserve(config_.max_tracked);
+    tracks_.reserve(config_.max_tracked);
+    next_tracks_.reserve(config_.max_tracked);
+}
+
+void PyramidDetector::reset() {
+    tracks_.clear();
+    since_search_ = 0;
+}
+
+int PyramidDetector::window_radius(const Plane& plane) const {
+    const int size = std::max(plane.width, plane.height);
+    return std::max(config_.min_window, static_cast<int>(std::lround(config_.window_fraction * size)));
+}
+
+size_t PyramidDetector::detect(const Plane& plane, Particle* out, size_t capacity) {
+    last_pixels_ = 0;
+    last_tracked_ = false;
+    if (!valid(plane)) {
+        return 0;
+    }
+    last_tracked_ = track(plane);
+    if (!last_tracked_) {
+        search(plane);
+    }
+    update_tracks(plane);
+
+    std::sort(found_.begin(), found_.end(), brighter);
+    const size_t count = std::min(capacity, found_.size());
+    std::copy(found_.begin(), found_.begin() + static_cast<std::ptrdiff_t>(count), out);
+    return count;
+}
+
+bool PyramidDetector::track(const Plane& plane) {
+    if (tracks_.empty() || since_search_ >= config_.refresh_frames) {
+        return false;
+    }
+    const int radius = window_radius(plane);
+    rects_.clear();
+    for (const Track& t : tracks_) {
+        add_window(plane, t.x + t.vx, t.y + t.vy, radius);
+    }
+    if (!refine(plane)) {
+        return false;
+    }
+    // Every tracked particle has to be in its window; a missing one may
+    // have moved further than predicted.
+    const float rx = static_cast<float>(radius) / plane.width;
+    const float ry = static_cast<float>(radius) / plane.height;
+    for (const Track& t : tracks_) {
+        const bool seen = std::any_of(found_.begin(), found_.end(), [&](const Particle& p) {
+            return std::fabs(p.x - (t.x + t.vx)) <= rx && std::fabs(p.y - (t.y + t.vy)) <= ry;
+        });
+        if (!seen) {
+            return false;
+        }
+    }
+    ++since_search_;
+    return true;
+}
+
+void PyramidDetector::search(const Plane& plane) {
+    since_search_ = 0;
+    const int factor = 1 << config_.levels;
+    if (plane.width / factor < 1 || plane.height / factor < 1) {
+        found_.resize(config_.max_tracked);
+        found_.resize(detector_.detect(plane, found_.data(), found_.size()));
+        last_pixels_ += static_cast<uint64_t>(plane.width) * static_cast<uint64_t>(plane.height);
+        return;
+    }
+
+    // Build the coarse level 4x (then 2x) at a time, ping-ponging between
+    // two buffers.
+    Plane level = plane;
+    int remaining = factor;
+    int buffer = 0;
+    while (remaining > 1) {
+        const int step = remaining >= 4 ? 4 : 2;
+        const int width = level.width / step;
+        const int height = level.height / step;
+        std::vector<uint8_t>& pixels = levels_[buffer];
+        if (pixels.size() < static_cast<size_t>(width) * static_cast<size_t>(height)) {
+            pixels.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+        }
+        downsample_max(level, step, pixels.data(), width);
+        last_pixels_ += static_cast<uint64_t>(level.width) * static_cast<uint64_t>(level.height);
+        level.data = pixels.data();
+        level.width = width;
+        level.height = height;
+        level.row_stride = width;
+        level.pixel_stride = 1;
+        remaining /= step;
+        buffer ^= 1;
+    }
+    const size_t candidates = coarse_detector_.detect(level, candidates_.data(), candidates_.size());
+    last_pixels_ += static_cast<uint64_t>(level.width) * static_cast<uint64_t>(level.height);
+
+    // A coarse pixel stands for a factor x factor block, and pooled
+    // neighbours may have merged, so each window also covers the
+    // candidate's coarse extent.
+    const int radius = window_radius(plane);
+    rects_.clear();
+    for (size_t i = 0; i < candidates; ++i) {
+        const Particle& c = candidates_[i];
+        const int extent = factor * (static_cast<int>(std::ceil(std::sqrt(static_cast<double>(c.area)))) + 1);
+        add_window(plane, c.x, c.y, std::max(radius, extent));
+    }
+    if (!refine(plane)) {
+        // A component reaches past its window: fall back to the whole frame.
+        found_.resize(config_.max_tracked);
+        found_.resize(detector_.detect(plane, found_.data(), found_.size()));
+        last_pixels_ += static_cast<uint64_t>(plane.width) * static_cast<uint64_t>(plane.height);
+    }
+}
+
+void PyramidDetector::add_window(const Plane& plane, float x, float y, int radius) {
+    const int cx = static_cast<int>(std::floor(x * plane.width));
+    const int cy = static_cast<int>(std::floor(y * plane.height));
+    Rect rect{std::max(cx - radius, 0), std::max(cy - radius, 0), std::min(cx + radius + 1, plane.width),
+              std::min(cy + radius + 1, plane.height)};
+    if (rect.x0 >= rect.x1 || rect.y0 >= rect.y1) {
+        return;
+    }
+    // Merge with every window it overlaps or touches, so no component is
+    // split between two windows and none is reported twice.
+    for (size_t i = 0; i < rects_.size();) {
+        const Rect& r = rects_[i];
+        if (r.x0 <= rect.x1 && rect.x0 <= r.x1 && r.y0 <= rect.y1 && rect.y0 <= r.y1) {
+            rect = Rect{std::min(r.x0, rect.x0), std::min(r.y0, rect.y0), std::max(r.x1, rect.x1),
+                        std::max(r.y1, rect.y1)};
+            rects_[i] = rects_.back();
+            rects_.pop_back();
+            i = 0;
+        } else {
+            ++i;
+        }
+    }
+    rects_.push_back(rect);
+}
+
+bool PyramidDetector::refine(const Plane& plane) {
+    found_.clear();
+    for (const Rect& rect : rects_) {
+        if (!border_clear(plane, rect)) {
+            return false;
+        }
+        Plane sub = plane;
+        sub.data = plane.data + static_cast<size_t>(rect.y0) * static_cast<size_t>(plane.row_stride) +
+                   static_cast<size_t>(rect.x0) * static_cast<size_t>(plane.pixel_stride);
+        sub.width = rect.x1 - rect.x0;
+        sub.height = rect.y1 - rect.y0;
+        last_pixels_ += static_cast<uint64_t>(sub.width) * static_cast<uint64_t>(sub.height);
+        const size_t count = detector_.detect(sub, window_.data(), window_.size());
+        for (size_t i = 0; i < count && found_.size() < config_.max_tracked; ++i) {
+            Particle p = window_[i];
+            p.x = (p.x * sub.width + rect.x0) / plane.width;
+            p.y = (p.y * sub.height + rect.y0) / plane.height;
+            found_.push_back(p);
+        }
+    }
+    return true;
+}
+
+bool PyramidDetector::border_clear(const Plane& plane, const Rect& rect) const {
+    // Only window edges inside the frame can cut a component.
+    const uint8_t threshold = options_.threshold;
+    auto at = [&](int x, int y) {
+        return plane.data[static_cast<size_t>(y) * static_cast<size_t>(plane.row_stride) +
+                          static_cast<size_t>(x) * static_cast<size_t>(plane.pixel_stride)];
+    };
+    for (int x = rect.x0; x < rect.x1; ++x) {
+        if ((rect.y0 > 0 && at(x, rect.y0) > threshold) || (rect.y1 < plane.height && at(x, rect.y1 - 1) > threshold)) {
+            return false;
+        }
+    }
+    for (int y = rect.y0; y < rect.y1; ++y) {
+        if ((rect.x0 > 0 && at(rect.x0, y) > threshold) || (rect.x1 < plane.width && at(rect.x1 - 1, y) > threshold)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PyramidDetector::update_tracks(const Plane& plane) {
+    // Each particle continues the nearest track within a window radius;
+    // its velocity is the move since that track's last position.
+    const float rx = static_cast<float>(window_radius(plane)) / plane.width;
+    const float ry = static_cast<float>(window_radius(plane)) / plane.height;
+    next_tracks_.clear();
+    for (const Particle& p : found_) {
+        Track next{p.x, p.y, 0.0f, 0.0f};
+        float best = INFINITY;
+        for (const Track& t : tracks_) {
+            const float dx = p.x - t.x;
+            const float dy = p.y - t.y;
+            const float dist = dx * dx + dy * dy;
+            if (std::fabs(dx) <= rx && std::fabs(dy) <= ry && dist < best) {
+                best = dist;
+                next.vx = dx;
+                next.vy = dy;
+            }
+        }
+        next_tracks_.push_back(next);
+    }
+    std::swap(tracks_, next_tracks_);
+}
+
+}  // namespace spark
+}  // namespace estream
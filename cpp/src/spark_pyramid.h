@@ -0,0 +1,105 @@
+/**
+ * Coarse-to-fine Spark particle detection.
+ *
+ * Spark particles are a few pixels across and few in number, so almost all
+ * of a frame is dark background. PyramidDetector searches a max-pooled
+ * pyramid level (1/4 or smaller per direction) for candidates, then runs
+ * the full-resolution Detector only in small windows around them. Once
+ * the particles are found, later frames skip the coarse search: each
+ * particle's next position is predicted from its last two, and only the
+ * windows around those predictions are read. A full search runs again
+ * periodically, and immediately when a tracked particle is missing or a
+ * component reaches the edge of its window, so a particle is never
+ * reported cut in half.
+ *
+ * A particle found in a window is the full-frame Detector's particle, up
+ * to float rounding of the position.
+ */
+
+#ifndef ESTREAM_SPARK_PYRAMID_H
+#define ESTREAM_SPARK_PYRAMID_H
+
+#include "spark_detect.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace estream {
+namespace spark {
+
+struct PyramidConfig {
+    /// The coarse level is 2^levels smaller in each direction (1 to 4).
+    int levels = 2;
+    /// Window half-size around a predicted position, as a fraction of the
+    /// larger frame dimension; covers a fast particle's prediction error.
+    float window_fraction = 0.02f;
+    /// Smallest window half-size in pixels.
+    int min_window = 8;
+    /// Frames between full searches, which pick up new particles.
+    size_t refresh_frames = 30;
+    /// Most particles refined and tracked per frame.
+    size_t max_tracked = 32;
+};
+
+class PyramidDetector {
+public:
+    explicit PyramidDetector(const Options& options = Options(), const PyramidConfig& config = PyramidConfig());
+
+    /// Same contract as Detector::detect: up to `capacity` particles,
+    /// brightest first. One thread at a time.
+    size_t detect(const Plane& plane, Particle* out, size_t capacity);
+
+    /// Forget the tracks; the next frame is searched in full.
+    void reset();
+
+    /// Pixels the last detect() read, to compare with width * height.
+    uint64_t last_pixels() const { return last_pixels_; }
+    /// Whether the last detect() used the predicted windows alone.
+    bool last_tracked() const { return last_tracked_; }
+
+    const PyramidConfig& config() const { return config_; }
+
+private:
+    struct Rect {
+        int x0;
+        int y0;
+        int x1;  // Exclusive.
+        int y1;
+    };
+
+    struct Track {
+        float x;
+        float y;
+        float vx;
+        float vy;
+    };
+
+    bool track(const Plane& plane);
+    void search(const Plane& plane);
+    void add_window(const Plane& plane, float x, float y, int radius);
+    bool refine(const Plane& plane);
+    bool border_clear(const Plane& plane, const Rect& rect) const;
+    void update_tracks(const Plane& plane);
+    int window_radius(const Plane& plane) const;
+
+    Options options_;
+    PyramidConfig config_;
+    Detector detector_;
+    Detector coarse_detector_;
+    std::vector<uint8_t> levels_[2];
+    std::vector<Particle> candidates_;
+    std::vector<Particle> window_;
+    std::vector<Particle> found_;
+    std::vector<Rect> rects_;
+    std::vector<Track> tracks_;
+    std::vector<Track> next_tracks_;
+    size_t since_search_ = 0;
+    uint64_t last_pixels_ = 0;
+    bool last_tracked_ = false;
+};
+
+}  // namespace spark
+}  // namespace estream
+
+#endif /* ESTREAM_SPARK_PYRAMID_H */
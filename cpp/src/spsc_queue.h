@@ -0,0 +1,72 @@
+/**
+ * Bounded lock-free queue for one producer thread and one consumer thread.
+ *
+ * Slots are written in place: the producer fills the slot acquire() hands
+ * out and publishes it with commit(); the consumer reads front() and frees
+ * it with pop(). Each index is written by one side only and published with
+ * a release store, so neither side locks, waits or allocates.
+ */
+
+#ifndef ESTREAM_SPSC_QUEUE_H
+#define ESTREAM_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace estream {
+
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    /// Producer: the next free slot, or nullptr when the queue is full.
+    T* acquire() {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ == Capacity) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == Capacity) {
+                return nullptr;
+            }
+        }
+        return &slots_[tail & (Capacity - 1)];
+    }
+
+    /// Producer: publish the slot returned by acquire().
+    void commit() { tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    /// Consumer: the oldest published slot, or nullptr when empty.
+    T* front() {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return nullptr;
+            }
+        }
+        return &slots_[head & (Capacity - 1)];
+    }
+
+    /// Consumer: release the slot returned by front().
+    void pop() { head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    /// Published slots; exact only on the consumer thread.
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_relaxed);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    // Producer and consumer indices on separate cache lines, each next to
+    // the owner's cached copy of the other side's index.
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t head_cache_ = 0;
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t tail_cache_ = 0;
+    alignas(64) T slots_[Capacity];
+};
+
+}  // namespace estream
+
+#endif /* ESTREAM_SPSC_QUEUE_H */
@@ -0,0 +1,155 @@
+#include "thread_stats.h"
+
+#include <ctime>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#include <pthread.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+namespace estream {
+namespace thread_stats {
+
+uint64_t current_thread_cpu_ns() {
+    timespec ts{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+}
+
+#if defined(__APPLE__)
+
+std::vector<ThreadSample> sample_all() {
+    std::vector<ThreadSample> out;
+    thread_act_array_t threads = nullptr;
+    mach_msg_type_number_t count = 0;
+    if (task_threads(mach_task_self(), &threads, &count) != KERN_SUCCESS) {
+        return out;
+    }
+    out.reserve(count);
+    for (mach_msg_type_number_t i = 0; i < count; ++i) {
+        ThreadSample s;
+        thread_basic_info_data_t basic{};
+        mach_msg_type_number_t basic_count = THREAD_BASIC_INFO_COUNT;
+        if (thread_info(threads[i], THREAD_BASIC_INFO,
+                        reinterpret_cast<thread_info_t>(&basic), &basic_count) == KERN_SUCCESS) {
+            s.cpu_ns = (uint64_t(basic.user_time.seconds) + basic.system_time.seconds) * 1000000000ull +
+                       (uint64_t(basic.user_time.microseconds) + basic.system_time.microseconds) * 1000ull;
+        }
+        thread_identifier_info_data_t ident{};
+        mach_msg_type_number_t ident_count = THREAD_IDENTIFIER_INFO_COUNT;
+        if (thread_info(threads[i], THREAD_IDENTIFIER_INFO,
+                        reinterpret_cast<thread_info_t>(&ident), &ident_count) == KERN_SUCCESS) {
+            s.tid = ident.thread_id;
+        }
+        if (pthread_t pt = pthread_from_mach_thread_np(threads[i])) {
+            char name[64] = {};
+            if (pthread_getname_np(pt, name, sizeof(name)) == 0) {
+                s.name = name;
+            }
+        }
+        out.push_back(std::move(s));
+        mach_port_deallocate(mach_task_self(), threads[i]);
+    }
+    vm_deallocate(mach_task_self(), reinterpret_cast<vm_address_t>(threads),
+                  count * sizeof(thread_act_t));
+    return out;
+}
+
+#else
+
+namespace {
+
+bool read_file(const char* path, char* buf, size_t size) {
+    FILE* f = std::fopen(path, "r");
+    if (f == nullptr) {
+        return false;
+    }
+    const size_t n = std::fread(buf, 1, size - 1, f);
+    std::fclose(f);
+    buf[n] = '\0';
+    return n > 0;
+}
+
+// utime + stime from /proc/<pid>/task/<tid>/stat. The comm field may
+// contain spaces, so fields are counted from the closing parenthesis.
+uint64_t parse_stat_cpu_ns(const char* stat) {
+    const char* p = std::strrchr(stat, ')');
+    if (p == nullptr) {
+        return 0;
+    }
+    ++p;
+    // After ')' come fields 3.. ; utime and stime are fields 14 and 15.
+    for (int field = 3; field < 14 && *p; ++field) {
+        while (*p == ' ') ++p;
+        while (*p && *p != ' ') ++p;
+    }
+    char* end = nullptr;
+    const unsigned long long utime = std::strtoull(p, &end, 10);
+    const unsigned long long stime = std::strtoull(end, nullptr, 10);
+    static const long ticks = sysconf(_SC_CLK_TCK);
+    return (utime + stime) * (1000000000ull / uint64_t(ticks > 0 ? ticks : 100));
+}
+
+uint64_t status_field(const char* status, const char* key) {
+    const char* p = std::strstr(status, key);
+    if (p == nullptr) {
+        return 0;
+    }
+    return std::strtoull(p + std::strlen(key), nullptr, 10);
+}
+
+}  // namespace
+
+std::vector<ThreadSample> sample_all() {
+    std::vector<ThreadSample> out;
+    DIR* dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        return out;
+    }
+    char path[64];
+    char buf[4096];
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') {
+            continue;
+        }
+        ThreadSample s;
+        s.tid = std::strtoull(entry->d_name, nullptr, 10);
+
+        std::snprintf(path, sizeof(path), "/proc/self/task/%llu/comm",
+                      static_cast<unsigned long long>(s.tid));
+        if (read_file(path, buf, sizeof(buf))) {
+            s.name = buf;
+            if (!s.name.empty() && s.name.back() == '\n') {
+                s.name.pop_back();
+            }
+        }
+        std::snprintf(path, sizeof(path), "/proc/self/task/%llu/stat",
+                      static_cast<unsigned long long>(s.tid));
+        if (read_file(path, buf, sizeof(buf))) {
+            s.cpu_ns = parse_stat_cpu_ns(buf);
+        }
+        std::snprintf(path, sizeof(path), "/proc/self/task/%llu/status",
+                      static_cast<unsigned long long>(s.tid));
+        if (read_file(path, buf, sizeof(buf))) {
+            s.voluntary_switches = status_field(buf, "\nvoluntary_ctxt_switches:");
+            s.involuntary_switches = status_field(buf, "\nnonvoluntary_ctxt_switches:");
+        }
+        out.push_back(std::move(s));
+    }
+    closedir(dir);
+    return out;
+}
+
+#endif
+
+}  // namespace thread_stats
+}  // namespace estream
@@ -0,0 +1,35 @@
+/**
+ * Per-thread CPU time and context switches of the current process.
+ *
+ * Linux/Android read /proc/self/task; Apple platforms use task_threads()
+ * and thread_info(). Context switch counts are only available on Linux.
+ */
+
+#ifndef ESTREAM_THREAD_STATS_H
+#define ESTREAM_THREAD_STATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace estream {
+namespace thread_stats {
+
+struct ThreadSample {
+    uint64_t tid = 0;
+    std::string name;
+    uint64_t cpu_ns = 0;                 // user + system
+    uint64_t voluntary_switches = 0;     // blocked / yielded (Linux)
+    uint64_t involuntary_switches = 0;   // preempted (Linux)
+};
+
+/// Snapshot every thread in the process.
+std::vector<ThreadSample> sample_all();
+
+/// CPU time of the calling thread (CLOCK_THREAD_CPUTIME_ID), nanoseconds.
+uint64_t current_thread_cpu_ns();
+
+}  // namespace thread_stats
+}  // namespace estream
+
+#endif /* ESTREAM_THREAD_STATS_H */
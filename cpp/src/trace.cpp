@@ -0,0 +1,225 @@
+#include "trace.h"
+
+#include "estream_app_native.h"
+#include "json.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#if defined(__APPLE__)
+#include <pthread.h>
+#elif defined(__linux__) || defined(__ANDROID__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace estream {
+namespace trace {
+
+namespace {
+
+struct Slot {
+    std::atomic<bool> ready{false};
+    Event event;
+};
+
+struct Buffer {
+    std::array<Slot, kEventCapacity> slots;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> dropped{0};
+};
+
+Buffer& buffer() {
+    static Buffer instance;
+    return instance;
+}
+
+uint64_t process_pid() {
+#if defined(__APPLE__) || defined(__linux__) || defined(__ANDROID__)
+    return static_cast<uint64_t>(getpid());
+#else
+    return 0;
+#endif
+}
+
+// Captured by the static initializer below, i.e. when the image containing
+// this library is loaded. All exported timestamps are relative to it.
+uint64_t g_epoch_ns = 0;
+
+struct LoadMarker {
+    LoadMarker() {
+        g_epoch_ns = now_ns();
+        record(Phase::Instant, "library_load");
+    }
+};
+LoadMarker g_load_marker;
+
+}  // namespace
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+uint32_t current_tid() {
+    thread_local uint32_t tid = [] {
+#if defined(__APPLE__)
+        uint64_t id = 0;
+        pthread_threadid_np(nullptr, &id);
+        return static_cast<uint32_t>(id);
+#elif defined(__linux__) || defined(__ANDROID__)
+        return static_cast<uint32_t>(syscall(SYS_gettid));
+#else
+        return static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+#endif
+    }();
+    return tid;
+}
+
+namespace {
+
+void append(Phase phase, const char* name, uint64_t ts_ns, uint64_t dur_ns) {
+    Buffer& buf = buffer();
+    const size_t index = buf.next.fetch_add(1, std::memory_order_relaxed);
+    if (index >= kEventCapacity) {
+        buf.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Slot& slot = buf.slots[index];
+    slot.event.ts_ns = ts_ns;
+    slot.event.dur_ns = dur_ns;
+    slot.event.tid = current_tid();
+    slot.event.phase = phase;
+    std::strncpy(slot.event.name, name != nullptr ? name : "", kNameCapacity - 1);
+    slot.event.name[kNameCapacity - 1] = '\0';
+    slot.ready.store(true, std::memory_order_release);
+}
+
+}  // namespace
+
+void record(Phase phase, const char* name) {
+    append(phase, name, now_ns(), 0);
+}
+
+void record_complete(const char* name, uint64_t duration_ns) {
+    const uint64_t end = now_ns();
+    // Never start before the library was loaded.
+    const uint64_t start = end - std::min(duration_ns, end - g_epoch_ns);
+    append(Phase::Complete, name, start, end - start);
+}
+
+size_t event_count() {
+    const size_t next = buffer().next.load(std::memory_order_relaxed);
+    return next < kEventCapacity ? next : kEventCapacity;
+}
+
+size_t dropped_count() {
+    return buffer().dropped.load(std::memory_order_relaxed);
+}
+
+std::string to_chrome_json() {
+    const Buffer& buf = buffer();
+    const size_t count = event_count();
+    const uint64_t pid = process_pid();
+
+    std::string out;
+    out.reserve(64 + count * 96);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first = true;
+    for (size_t i = 0; i < count; ++i) {
+        const Slot& slot = buf.slots[i];
+        if (!slot.ready.load(std::memory_order_acquire)) {
+            continue;  // Still being written by another thread.
+        }
+        const Event& ev = slot.event;
+        const uint64_t rel = ev.ts_ns > g_epoch_ns ? ev.ts_ns - g_epoch_ns : 0;
+
+        if (!first) {
+            out.push_back(',');
+        }
+        first = false;
+
+        out += "{\"name\":";
+        json::append_string(out, ev.name);
+        out += ",\"cat\":\"estream\",\"ph\":\"";
+        out.push_back(static_cast<char>(ev.phase));
+        out += "\",\"ts\":";
+        json::append_micros(out, rel);
+        out += ",\"pid\":";
+        json::append_uint(out, pid);
+        out += ",\"tid\":";
+        json::append_uint(out, ev.tid);
+        if (ev.phase == Phase::Instant) {
+            out += ",\"s\":\"p\"";
+        } else if (ev.phase == Phase::Complete) {
+            out += ",\"dur\":";
+            json::append_micros(out, ev.dur_ns);
+        }
+        out.push_back('}');
+    }
+
+    out += "],\"otherData\":{\"dropped_events\":";
+    json::append_uint(out, dropped_count());
+    out += "}}";
+    return out;
+}
+
+void reset() {
+    Buffer& buf = buffer();
+    const size_t count = event_count();
+    for (size_t i = 0; i < count; ++i) {
+        buf.slots[i].ready.store(false, std::memory_order_relaxed);
+    }
+    buf.dropped.store(0, std::memory_order_relaxed);
+    buf.next.store(0, std::memory_order_release);
+}
+
+}  // namespace trace
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+using estream::trace::Phase;
+
+extern "C" void estream_trace_begin(const char* name) {
+    estream::trace::record(Phase::Begin, name);
+}
+
+extern "C" void estream_trace_end(const char* name) {
+    estream::trace::record(Phase::End, name);
+}
+
+extern "C" void estream_trace_instant(const char* name) {
+    estream::trace::record(Phase::Instant, name);
+}
+
+extern "C" void estream_trace_complete(const char* name, uint64_t duration_ns) {
+    estream::trace::record_complete(name, duration_ns);
+}
+
+extern "C" long estream_trace_dump(const char* path) {
+    if (path == nullptr) {
+        return -1;
+    }
+    const std::string json = estream::trace::to_chrome_json();
+
+    std::FILE* file = std::fopen(path, "wb");
+    if (file == nullptr) {
+        return -1;
+    }
+    const bool ok = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+    if (std::fclose(file) != 0 || !ok) {
+        return -1;
+    }
+    return static_cast<long>(estream::trace::event_count());
+}
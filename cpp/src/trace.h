@@ -0,0 +1,68 @@
+/**
+ * In-memory trace buffer.
+ *
+ * Append-only array of fixed-size events. Recording is one atomic
+ * fetch_add plus a copy of the name, so it is cheap enough to leave enabled
+ * on the cold-start path. Events are exported as a Chrome JSON trace.
+ */
+
+#ifndef ESTREAM_TRACE_H
+#define ESTREAM_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace estream {
+namespace trace {
+
+constexpr size_t kNameCapacity = 40;
+constexpr size_t kEventCapacity = 4096;
+
+enum class Phase : char {
+    Begin = 'B',
+    End = 'E',
+    Instant = 'i',
+    /// A whole span in one event, `dur_ns` long.
+    Complete = 'X',
+};
+
+struct Event {
+    uint64_t ts_ns;
+    uint64_t dur_ns;
+    uint32_t tid;
+    Phase phase;
+    char name[kNameCapacity];
+};
+
+/// Monotonic clock in nanoseconds.
+uint64_t now_ns();
+
+/// OS thread id of the caller, cached per thread.
+uint32_t current_tid();
+
+/// Append an event for the calling thread. Never blocks.
+void record(Phase phase, const char* name);
+
+/// Append a Complete event for a span that ends now and lasted
+/// `duration_ns`. For spans timed elsewhere, such as JS code whose begin
+/// and end reach native code on different threads.
+void record_complete(const char* name, uint64_t duration_ns);
+
+/// Number of events currently held in the buffer.
+size_t event_count();
+
+/// Number of events rejected because the buffer was full.
+size_t dropped_count();
+
+/// Serialize all completed events as a Chrome trace JSON object.
+/// Timestamps are relative to when the library was loaded.
+std::string to_chrome_json();
+
+/// Discard all events (tests and re-arming after a dump).
+void reset();
+
+}  // namespace trace
+}  // namespace estream
+
+#endif /* ESTREAM_TRACE_H */
@@ -0,0 +1,390 @@
+#include "trace_writer.h"
+
+#include "estream_app_native.h"
+#include "json.h"
+#include "runtime_stats.h"
+#include "spans.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <unistd.h>
+
+namespace estream {
+namespace trace_writer {
+
+namespace {
+
+struct Record {
+    uint64_t ts_ns;
+    uint64_t id;
+    uint64_t parent_id;
+    const char* name;
+    uint32_t tid;
+    uint8_t phase;
+    uint8_t failed;
+};
+
+// Events rejected by full rings, across all threads and sessions.
+std::atomic<uint64_t> g_dropped{0};
+std::atomic<uint64_t> g_dropped_at_start{0};
+
+static_assert((kRingCapacity & (kRingCapacity - 1)) == 0, "ring capacity must be a power of two");
+
+// Single producer (the owning thread), single consumer (the flush thread).
+struct Ring {
+    explicit Ring(uint32_t owner) : tid(owner) {}
+
+    bool push(const Record& r) {
+        const uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == kRingCapacity) {
+            g_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots[h & (kRingCapacity - 1)] = r;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename Fn>
+    void drain(Fn&& fn) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        const uint64_t h = head.load(std::memory_order_acquire);
+        for (; t != h; ++t) {
+            fn(slots[t & (kRingCapacity - 1)]);
+        }
+        tail.store(t, std::memory_order_release);
+    }
+
+    /// Consumer side only, with no flush thread running.
+    void discard() {
+        tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    std::unique_ptr<Record[]> slots{new Record[kRingCapacity]};
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    std::atomic<bool> exited{false};
+    const uint32_t tid;
+};
+
+ProfiledMutex g_rings_mu{"trace_rings"};
+std::vector<std::shared_ptr<Ring>> g_rings;
+
+struct LocalRing {
+    std::shared_ptr<Ring> ring;
+    ~LocalRing() {
+        if (ring) {
+            ring->exited.store(true, std::memory_order_release);
+        }
+    }
+};
+thread_local LocalRing t_ring;
+
+Ring& local_ring() {
+    if (!t_ring.ring) {
+        t_ring.ring = std::make_shared<Ring>(trace::current_tid());
+        std::lock_guard<ProfiledMutex> lock(g_rings_mu);
+        g_rings.push_back(t_ring.ring);
+    }
+    return *t_ring.ring;
+}
+
+void on_span(const EstreamSpanEvent* ev) {
+    local_ring().push(Record{
+        ev->ts_ns, ev->span_id, ev->parent_id, ev->name, ev->thread_id,
+        static_cast<uint8_t>(ev->phase), static_cast<uint8_t>(ev->failed != 0),
+    });
+}
+
+// ---------------------------------------------------------------------------
+// Protobuf encoding (perfetto.protos.Trace / TracePacket / TrackEvent)
+// ---------------------------------------------------------------------------
+
+namespace pb {
+
+void varint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+void uint_field(std::string& out, uint32_t field, uint64_t v) {
+    varint(out, (uint64_t{field} << 3) | 0);
+    varint(out, v);
+}
+
+void bytes_field(std::string& out, uint32_t field, const std::string& bytes) {
+    varint(out, (uint64_t{field} << 3) | 2);
+    varint(out, bytes.size());
+    out += bytes;
+}
+
+// Field numbers from perfetto/protos/perfetto/trace/.
+constexpr uint32_t kTracePacket = 1;
+constexpr uint32_t kPacketTimestamp = 8;
+constexpr uint32_t kPacketSequenceId = 10;
+constexpr uint32_t kPacketTrackEvent = 11;
+constexpr uint32_t kPacketSequenceFlags = 13;
+constexpr uint32_t kPacketTimestampClockId = 58;
+constexpr uint32_t kPacketTrackDescriptor = 60;
+constexpr uint32_t kTrackUuid = 1;
+constexpr uint32_t kTrackThread = 4;
+constexpr uint32_t kThreadPid = 1;
+constexpr uint32_t kThreadTid = 2;
+constexpr uint32_t kEventDebugAnnotations = 4;
+constexpr uint32_t kEventType = 9;
+constexpr uint32_t kEventTrackUuid = 11;
+constexpr uint32_t kEventCategories = 22;
+constexpr uint32_t kEventName = 23;
+constexpr uint32_t kAnnotationBool = 2;
+constexpr uint32_t kAnnotationName = 10;
+constexpr uint64_t kSliceBegin = 1;
+constexpr uint64_t kSliceEnd = 2;
+constexpr uint64_t kClockMonotonic = 3;
+constexpr uint64_t kSeqIncrementalStateCleared = 1;
+constexpr uint64_t kSequenceId = 1;
+
+}  // namespace pb
+
+struct Session {
+    std::FILE* file = nullptr;
+    Format format = Format::ChromeJson;
+    uint64_t pid = 0;
+    uint64_t written = 0;
+    bool io_error = false;
+    bool first_event = true;
+    std::unordered_set<uint32_t> described_threads;
+    std::string scratch;
+
+    std::thread flusher;
+    std::mutex mu;
+    std::condition_variable cv;
+    bool stopping = false;
+};
+
+std::mutex g_session_mu;  // start/stop
+std::unique_ptr<Session> g_session;
+
+void write_raw(Session& s, const std::string& bytes) {
+    if (!bytes.empty() && std::fwrite(bytes.data(), 1, bytes.size(), s.file) != bytes.size()) {
+        s.io_error = true;
+    }
+}
+
+uint64_t thread_track_uuid(const Session& s, uint32_t tid) {
+    return (s.pid << 32) ^ tid ^ 0x5eed0000ull;
+}
+
+void encode_json(Session& s, const Record& r, std::string& out) {
+    if (!s.first_event) {
+        out.push_back(',');
+    }
+    s.first_event = false;
+    out += "{\"name\":";
+    json::append_string(out, r.name);
+    out += ",\"cat\":\"estream\",\"ph\":\"";
+    out.push_back(r.phase == ESTREAM_SPAN_BEGIN ? 'B' : 'E');
+    out += "\",\"ts\":";
+    json::append_micros(out, r.ts_ns);
+    out += ",\"pid\":";
+    json::append_uint(out, s.pid);
+    out += ",\"tid\":";
+    json::append_uint(out, r.tid);
+    out += ",\"args\":{\"span_id\":";
+    json::append_uint(out, r.id);
+    if (r.phase == ESTREAM_SPAN_BEGIN) {
+        out += ",\"parent_id\":";
+        json::append_uint(out, r.parent_id);
+    } else if (r.failed) {
+        out += ",\"failed\":true";
+    }
+    out += "}}";
+}
+
+void encode_proto(Session& s, const Record& r, std::string& out) {
+    const uint64_t track = thread_track_uuid(s, r.tid);
+    std::string packet;
+
+    if (s.described_threads.insert(r.tid).second) {
+        std::string thread;
+        pb::uint_field(thread, pb::kThreadPid, s.pid);
+        pb::uint_field(thread, pb::kThreadTid, r.tid);
+        std::string desc;
+        pb::uint_field(desc, pb::kTrackUuid, track);
+        pb::bytes_field(desc, pb::kTrackThread, thread);
+        pb::bytes_field(packet, pb::kPacketTrackDescriptor, desc);
+        pb::uint_field(packet, pb::kPacketSequenceId, pb::kSequenceId);
+        if (s.described_threads.size() == 1) {
+            pb::uint_field(packet, pb::kPacketSequenceFlags, pb::kSeqIncrementalStateCleared);
+        }
+        pb::bytes_field(out, pb::kTracePacket, packet);
+        packet.clear();
+    }
+
+    std::string event;
+    pb::uint_field(event, pb::kEventType,
+                   r.phase == ESTREAM_SPAN_BEGIN ? pb::kSliceBegin : pb::kSliceEnd);
+    pb::uint_field(event, pb::kEventTrackUuid, track);
+    if (r.phase == ESTREAM_SPAN_BEGIN) {
+        pb::bytes_field(event, pb::kEventCategories, "estream");
+        pb::bytes_field(event, pb::kEventName, r.name);
+    } else if (r.failed) {
+        std::string annotation;
+        pb::bytes_field(annotation, pb::kAnnotationName, "failed");
+        pb::uint_field(annotation, pb::kAnnotationBool, 1);
+        pb::bytes_field(event, pb::kEventDebugAnnotations, annotation);
+    }
+
+    pb::uint_field(packet, pb::kPacketTimestamp, r.ts_ns);
+    pb::uint_field(packet, pb::kPacketTimestampClockId, pb::kClockMonotonic);
+    pb::uint_field(packet, pb::kPacketSequenceId, pb::kSequenceId);
+    pb::bytes_field(packet, pb::kPacketTrackEvent, event);
+    pb::bytes_field(out, pb::kTracePacket, packet);
+}
+
+void flush_once(Session& s) {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<ProfiledMutex> lock(g_rings_mu);
+        rings = g_rings;
+    }
+
+    for (const auto& ring : rings) {
+        s.scratch.clear();
+        ring->drain([&](const Record& r) {
+            if (s.format == Format::ChromeJson) {
+                encode_json(s, r, s.scratch);
+            } else {
+                encode_proto(s, r, s.scratch);
+            }
+            ++s.written;
+        });
+        write_raw(s, s.scratch);
+    }
+    std::fflush(s.file);
+
+    // Forget rings of threads that have exited once they are empty.
+    std::lock_guard<ProfiledMutex> lock(g_rings_mu);
+    g_rings.erase(std::remove_if(g_rings.begin(), g_rings.end(),
+                                 [](const std::shared_ptr<Ring>& ring) {
+                                     return ring->exited.load(std::memory_order_acquire) &&
+                                            ring->empty();
+                                 }),
+                  g_rings.end());
+}
+
+void flush_loop(Session* s) {
+    std::unique_lock<std::mutex> lock(s->mu);
+    while (!s->stopping) {
+        s->cv.wait_for(lock, std::chrono::milliseconds(kFlushIntervalMs),
+                       [&] { return s->stopping; });
+        lock.unlock();
+        flush_once(*s);
+        lock.lock();
+    }
+}
+
+}  // namespace
+
+bool start(const std::string& path, Format format) {
+    std::lock_guard<std::mutex> lock(g_session_mu);
+    if (g_session) {
+        return false;
+    }
+
+    auto s = std::make_unique<Session>();
+    s->file = std::fopen(path.c_str(), "wb");
+    if (s->file == nullptr) {
+        return false;
+    }
+    s->format = format;
+    s->pid = static_cast<uint64_t>(getpid());
+
+    // Drop anything left over from spans that ended after the last stop.
+    {
+        std::lock_guard<ProfiledMutex> rings_lock(g_rings_mu);
+        for (const auto& ring : g_rings) {
+            ring->discard();
+        }
+    }
+    g_dropped_at_start.store(g_dropped.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    if (format == Format::ChromeJson) {
+        write_raw(*s, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    }
+
+    Session* raw = s.get();
+    s->flusher = std::thread(flush_loop, raw);
+    g_session = std::move(s);
+    spans::set_sink(on_span);
+    return true;
+}
+
+long stop() {
+    std::lock_guard<std::mutex> lock(g_session_mu);
+    if (!g_session) {
+        return -1;
+    }
+    spans::set_sink(nullptr);
+
+    Session& s = *g_session;
+    {
+        std::lock_guard<std::mutex> session_lock(s.mu);
+        s.stopping = true;
+    }
+    s.cv.notify_all();
+    s.flusher.join();
+    flush_once(s);
+
+    if (s.format == Format::ChromeJson) {
+        std::string footer = "],\"otherData\":{\"dropped_events\":";
+        json::append_uint(footer, dropped());
+        footer += "}}";
+        write_raw(s, footer);
+    }
+    const bool ok = std::fclose(s.file) == 0 && !s.io_error;
+    const long written = static_cast<long>(s.written);
+    g_session.reset();
+    return ok ? written : -1;
+}
+
+uint64_t dropped() {
+    return g_dropped.load(std::memory_order_relaxed) -
+           g_dropped_at_start.load(std::memory_order_relaxed);
+}
+
+}  // namespace trace_writer
+}  // namespace estream
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" int estream_trace_start(const char* path, EstreamTraceFormat format) {
+    if (path == nullptr) {
+        return -1;
+    }
+    const auto fmt = format == ESTREAM_TRACE_FORMAT_PERFETTO
+                         ? estream::trace_writer::Format::PerfettoProto
+                         : estream::trace_writer::Format::ChromeJson;
+    return estream::trace_writer::start(path, fmt) ? 0 : -1;
+}
+
+extern "C" long estream_trace_stop(void) {
+    return estream::trace_writer::stop();
+}
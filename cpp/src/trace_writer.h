@@ -0,0 +1,47 @@
+/**
+ * Span trace file writer.
+ *
+ * While a session is active every span event is pushed into a lock-free
+ * single-producer ring owned by the emitting thread. A background thread
+ * drains all rings and streams the events to disk as Chrome JSON or as a
+ * Perfetto protobuf trace, so either opens directly in ui.perfetto.dev.
+ */
+
+#ifndef ESTREAM_TRACE_WRITER_H
+#define ESTREAM_TRACE_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace estream {
+namespace trace_writer {
+
+enum class Format {
+    ChromeJson = 0,
+    PerfettoProto = 1,
+};
+
+/// Events per thread ring (40 bytes each); a full ring drops new events
+/// until the next flush drains it.
+constexpr size_t kRingCapacity = 2048;
+
+/// Background flush interval.
+constexpr uint32_t kFlushIntervalMs = 50;
+
+/// Open `path` and start recording. False if a session is already active
+/// or the file cannot be created.
+bool start(const std::string& path, Format format);
+
+/// Stop recording, flush remaining events and close the file.
+/// Returns the number of events written, or -1 if no session was active or
+/// the file could not be finalized.
+long stop();
+
+/// Events dropped because a ring was full (current or last session).
+uint64_t dropped();
+
+}  // namespace trace_writer
+}  // namespace estream
+
+#endif /* ESTREAM_TRACE_WRITER_H */
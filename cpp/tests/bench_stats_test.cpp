@@ -0,0 +1,92 @@
+#include "check.h"
+#include "report.h"
+#include "stats.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace estream::bench;
+
+static void test_median() {
+    CHECK_EQ(median({3, 1, 2}), 2.0);
+    CHECK_EQ(median({4, 1, 3, 2}), 2.5);
+    CHECK_EQ(median({}), 0.0);
+}
+
+static void test_mann_whitney() {
+    // Fully separated 5 vs 5: U = 0, z = 12 / sqrt(22.917), p = 0.0122.
+    const double p = mann_whitney_p({1, 2, 3, 4, 5}, {6, 7, 8, 9, 10});
+    CHECK(std::fabs(p - 0.0122) < 0.0005);
+    CHECK_EQ(mann_whitney_p({1, 2, 3, 4, 5}, {6, 7, 8, 9, 10}),
+             mann_whitney_p({6, 7, 8, 9, 10}, {1, 2, 3, 4, 5}));
+    CHECK(mann_whitney_p({1, 2, 3, 4, 5}, {1, 2, 3, 4, 5}) > 0.9);
+    CHECK_EQ(mann_whitney_p({7, 7, 7}, {7, 7, 7}), 1.0);
+    CHECK_EQ(mann_whitney_p({}, {1}), 1.0);
+}
+
+static void test_bootstrap_ratio() {
+    std::vector<double> base;
+    std::vector<double> doubled;
+    for (int i = 0; i < 50; ++i) {
+        base.push_back(100 + i % 7);
+        doubled.push_back(2 * (100 + i % 7));
+    }
+    const Interval ci = bootstrap_median_ratio(base, doubled, 0.95, 2000, 42);
+    CHECK(ci.lo > 1.85 && ci.hi < 2.15);
+    CHECK(ci.lo <= ci.hi);
+
+    const Interval same = bootstrap_median_ratio(base, base, 0.95, 2000, 42);
+    CHECK(same.lo <= 1.0 && same.hi >= 1.0);
+}
+
+static void test_report_round_trip() {
+    Report r = new_report("unit_bench");
+    r.label = "abc \"quoted\"";
+    r.add("case.messages_per_sec", "msg/s", Better::Higher, 1234.5);
+    r.add("case.messages_per_sec", "msg/s", Better::Higher, 1e9);
+    r.add("latency_ns", "ns", Better::Lower, 42);
+    r.add("latency_ns", "ns", Better::Lower, std::nan(""));
+    r.add("latency_ns", "ns", Better::Lower, HUGE_VAL);
+
+    const std::string path = "bench_stats_test_report.json";
+    CHECK(write_report(path, r));
+    Report back;
+    std::string error;
+    CHECK(read_report(path, back, error));
+    std::remove(path.c_str());
+
+    CHECK_EQ(back.bench, "unit_bench");
+    CHECK_EQ(back.label, r.label);
+    CHECK_EQ(back.machine.id, r.machine.id);
+    CHECK_EQ(back.metrics.size(), 2u);
+    CHECK_EQ(back.metrics[0].samples.size(), 2u);
+    CHECK_EQ(back.metrics[0].samples[0], 1234.5);
+    CHECK_EQ(back.metrics[0].samples[1], 1e9);
+    CHECK(back.metrics[1].better == Better::Lower);
+    // Non-finite samples are written as null and dropped on reading.
+    CHECK(back.metrics[1].samples == std::vector<double>{42});
+}
+
+static void test_rejects_other_schema() {
+    const std::string path = "bench_stats_test_bad.json";
+    FILE* f = std::fopen(path.c_str(), "w");
+    std::fputs("{\"schema\":\"other/1\",\"metrics\":[]}", f);
+    std::fclose(f);
+    Report r;
+    std::string error;
+    CHECK(!read_report(path, r, error));
+    CHECK(!error.empty());
+    std::remove(path.c_str());
+}
+
+int main() {
+    test_median();
+    test_mann_whitney();
+    test_bootstrap_ratio();
+    test_report_round_trip();
+    test_rejects_other_schema();
+    std::puts("bench_stats_test: OK");
+    return 0;
+}
@@ -0,0 +1,22 @@
+/**
+ * Tiny assertion helpers for the host unit tests.
+ */
+
+#ifndef ESTREAM_TEST_CHECK_H
+#define ESTREAM_TEST_CHECK_H
+
+#include <cstdio>
+#include <cstdlib>
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,    \
+                         __LINE__, #cond);                                 \
+            std::exit(1);                                                  \
+        }                                                                  \
+    } while (0)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
+
+#endif /* ESTREAM_TEST_CHECK_H */
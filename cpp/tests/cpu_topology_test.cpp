@@ -0,0 +1,93 @@
+#include "check.h"
+#include "cpu_topology.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace estream;
+
+namespace {
+
+void write_file(const std::string& path, const char* text) {
+    FILE* f = std::fopen(path.c_str(), "w");
+    CHECK(f != nullptr);
+    std::fputs(text, f);
+    std::fclose(f);
+}
+
+void add_policy(const std::string& root, const char* name, const char* cpus, const char* khz) {
+    const std::string dir = root + "/cpufreq/" + name;
+    CHECK(mkdir(dir.c_str(), 0755) == 0);
+    write_file(dir + "/related_cpus", cpus);
+    write_file(dir + "/cpuinfo_max_freq", khz);
+}
+
+void remove_tree(const std::string& root) {
+    const std::string cmd = "rm -rf '" + root + "'";
+    CHECK(std::system(cmd.c_str()) == 0);
+}
+
+}  // namespace
+
+static void test_parse_cpu_list() {
+    CHECK(cpu_topology::parse_cpu_list("0-3,6\n") == (std::vector<int>{0, 1, 2, 3, 6}));
+    CHECK(cpu_topology::parse_cpu_list("4 5 6 7") == (std::vector<int>{4, 5, 6, 7}));
+    CHECK(cpu_topology::parse_cpu_list("7 2-3 2") == (std::vector<int>{2, 3, 7}));
+    CHECK(cpu_topology::parse_cpu_list("").empty());
+}
+
+static void test_big_little_clusters() {
+    char tmpl[] = "/tmp/estream_topology_XXXXXX";
+    const std::string root = mkdtemp(tmpl);
+    CHECK(mkdir((root + "/cpufreq").c_str(), 0755) == 0);
+    add_policy(root, "policy0", "0 1 2 3\n", "1800000\n");
+    add_policy(root, "policy4", "4 5 6\n", "2400000\n");
+    add_policy(root, "policy7", "7\n", "3000000\n");
+
+    std::vector<cpu_topology::Cluster> clusters = cpu_topology::clusters_from_sysfs(root, {});
+    CHECK_EQ(clusters.size(), 3u);
+    CHECK_EQ(clusters[0].id, 0);
+    CHECK(clusters[0].cpus == std::vector<int>{7});
+    CHECK_EQ(clusters[0].max_freq_khz, 3000000u);
+    CHECK(clusters[1].cpus == (std::vector<int>{4, 5, 6}));
+    CHECK_EQ(clusters[2].id, 2);
+    CHECK_EQ(clusters[2].cpu_count, 4);
+
+    // A background cpuset limits the process to some little cores.
+    clusters = cpu_topology::clusters_from_sysfs(root, {1, 2});
+    CHECK_EQ(clusters.size(), 1u);
+    CHECK_EQ(clusters[0].id, 0);
+    CHECK(clusters[0].cpus == (std::vector<int>{1, 2}));
+    remove_tree(root);
+}
+
+static void test_fallback_without_cpufreq() {
+    char tmpl[] = "/tmp/estream_topology_XXXXXX";
+    const std::string root = mkdtemp(tmpl);
+    write_file(root + "/online", "0-5\n");
+    std::vector<cpu_topology::Cluster> clusters = cpu_topology::clusters_from_sysfs(root, {});
+    CHECK_EQ(clusters.size(), 1u);
+    CHECK_EQ(clusters[0].cpu_count, 6);
+    clusters = cpu_topology::clusters_from_sysfs(root, {0, 3, 9});
+    CHECK(clusters[0].cpus == (std::vector<int>{0, 3}));
+    remove_tree(root);
+}
+
+static void test_this_host() {
+    const std::vector<cpu_topology::Cluster> clusters = cpu_topology::clusters();
+    CHECK(!clusters.empty());
+    CHECK(clusters[0].cpu_count >= 1);
+}
+
+int main() {
+    test_parse_cpu_list();
+    test_big_little_clusters();
+    test_fallback_without_cpufreq();
+    test_this_host();
+    std::puts("cpu_topology_test: OK");
+    return 0;
+}
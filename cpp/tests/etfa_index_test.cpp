@@ -0,0 +1,202 @@
+#include "check.h"
+#include "fixtures.h"
+#include "etfa_index.h"
+
+#include "estream_app_native.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace estream;
+using test::Rng;
+
+namespace {
+
+// A device: 16 ratios spread over 1/64 .. 4, like real fingerprints.
+std::vector<double> random_device(Rng& rng) {
+    std::vector<double> ratios(etfa::kCodeDims);
+    for (double& r : ratios) {
+        r = std::exp2(rng.unit() * 8.0 - 6.0);
+    }
+    return ratios;
+}
+
+// The same device measured again: every ratio off by up to +/-4%.
+std::vector<double> remeasure(const std::vector<double>& ratios, Rng& rng) {
+    std::vector<double> out(ratios);
+    for (double& r : out) {
+        r *= 1.0 + (rng.unit() - 0.5) * 0.08;
+    }
+    return out;
+}
+
+uint32_t scalar_l1(const etfa::Code& a, const etfa::Code& b, uint32_t* common) {
+    uint32_t sum = 0;
+    *common = 0;
+    for (size_t i = 0; i < etfa::kCodeDims; ++i) {
+        if ((a.mask[i] & b.mask[i]) != 0) {
+            sum += static_cast<uint32_t>(std::abs(int{a.value[i]} - int{b.value[i]}));
+            ++*common;
+        }
+    }
+    return sum;
+}
+
+std::string device_id(size_t i) {
+    return "device-" + std::to_string(i);
+}
+
+}  // namespace
+
+static void test_quantize() {
+    const double ratios[] = {1.0, 2.0, 0.5, 0.0, NAN, 1e9};
+    const etfa::Code code = etfa::quantize(ratios, 6);
+    CHECK_EQ(code.value[0], 128);
+    CHECK_EQ(code.value[1], 144);
+    CHECK_EQ(code.value[2], 112);
+    CHECK_EQ(code.mask[3], 0);
+    CHECK_EQ(code.mask[4], 0);
+    CHECK_EQ(code.value[5], 255);  // Clamped at +127 steps.
+    CHECK_EQ(code.mask[6], 0);     // Beyond `count`.
+    CHECK_EQ(etfa::to_hex(code).substr(0, 10), std::string("8090700000"));
+}
+
+static void test_simd_distance_matches_scalar() {
+    Rng rng;
+    for (int i = 0; i < 1000; ++i) {
+        etfa::Code a;
+        etfa::Code b;
+        for (size_t d = 0; d < etfa::kCodeDims; ++d) {
+            a.value[d] = static_cast<uint8_t>(rng.next());
+            b.value[d] = static_cast<uint8_t>(rng.next());
+            a.mask[d] = rng.next() % 8 == 0 ? 0 : 0xFF;
+            b.mask[d] = rng.next() % 8 == 0 ? 0 : 0xFF;
+        }
+        uint32_t common = 0;
+        uint32_t expected_common = 0;
+        CHECK_EQ(etfa::l1(a, b, &common), scalar_l1(a, b, &expected_common));
+        CHECK_EQ(common, expected_common);
+    }
+}
+
+static void test_noise_tolerance() {
+    Rng rng;
+    const std::vector<double> device = random_device(rng);
+    const etfa::Code first = etfa::quantize(device.data(), device.size());
+    const etfa::Code again = etfa::quantize(remeasure(device, rng).data(), device.size());
+    CHECK(etfa::distance(first, again) < 0.1);
+
+    const std::vector<double> other = random_device(rng);
+    CHECK(etfa::distance(first, etfa::quantize(other.data(), other.size())) > 0.5);
+
+    // An unmeasured GPU ratio is ignored rather than counted as a mismatch.
+    std::vector<double> no_gpu(device);
+    no_gpu[14] = 0.0;
+    no_gpu[15] = 0.0;
+    CHECK(etfa::distance(first, etfa::quantize(no_gpu.data(), no_gpu.size())) == 0.0);
+}
+
+static void test_exact_and_approximate_search() {
+    Rng rng;
+    const size_t n = 4096;
+    std::vector<std::vector<double>> devices;
+    etfa::SimilarityIndex index;
+    for (size_t i = 0; i < n; ++i) {
+        devices.push_back(random_device(rng));
+        index.add(device_id(i), etfa::quantize(devices.back().data(), etfa::kCodeDims));
+    }
+    CHECK_EQ(index.size(), n);
+
+    size_t scanned = 0;
+    const std::vector<double> query = remeasure(devices[1234], rng);
+    std::vector<etfa::Match> matches = index.search(etfa::quantize(query.data(), query.size()), 3, 0, &scanned);
+    CHECK_EQ(matches.size(), 3u);
+    CHECK_EQ(matches[0].id, device_id(1234));
+    CHECK(matches[0].distance <= matches[1].distance);
+    CHECK_EQ(scanned, n);
+
+    index.train(64);
+    CHECK_EQ(index.lists(), 64u);
+    size_t found = 0;
+    size_t total_scanned = 0;
+    for (size_t q = 0; q < 200; ++q) {
+        const size_t target = (q * 97) % n;
+        const std::vector<double> noisy = remeasure(devices[target], rng);
+        matches = index.search(etfa::quantize(noisy.data(), noisy.size()), 1, 8, &scanned);
+        total_scanned += scanned;
+        if (!matches.empty() && matches[0].id == device_id(target)) {
+            ++found;
+        }
+    }
+    CHECK(found >= 180);                       // >= 90% recall
+    CHECK(total_scanned < 200 * n / 3);         // well under an exhaustive scan
+
+    // Added after training: joins its nearest cell and is still found.
+    const std::vector<double> late = random_device(rng);
+    index.add("late", etfa::quantize(late.data(), late.size()));
+    const std::vector<double> late_again = remeasure(late, rng);
+    matches = index.search(etfa::quantize(late_again.data(), late_again.size()), 1, 8);
+    CHECK(!matches.empty() && matches[0].id == "late");
+    CHECK(index.remove("late"));
+    CHECK(!index.remove("late"));
+    CHECK_EQ(index.size(), n);
+}
+
+static void test_save_load_and_c_api() {
+    Rng rng;
+    char path[] = "/tmp/estream_etfa_index_XXXXXX";
+    const int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+
+    const long index = estream_etfa_index_create();
+    std::vector<std::vector<double>> devices;
+    for (size_t i = 0; i < 1100; ++i) {
+        devices.push_back(random_device(rng));
+        CHECK_EQ(estream_etfa_index_add(index, device_id(i).c_str(), devices.back().data(), 16), 0);
+    }
+    CHECK_EQ(estream_etfa_index_size(index), 1100);
+    CHECK_EQ(estream_etfa_index_remove(index, "absent"), -1);
+    CHECK_EQ(estream_etfa_index_train(index, 0, 0), 0);  // Auto: sqrt(1100) cells.
+    CHECK_EQ(estream_etfa_index_save(index, path), 0);
+    estream_etfa_index_destroy(index);
+    CHECK(estream_etfa_index_search(index, devices[0].data(), 16, 1, 0) == nullptr);
+    CHECK_EQ(estream_etfa_index_size(index), -1);
+
+    const long loaded = estream_etfa_index_load(path);
+    CHECK(loaded > 0);
+    const std::vector<double> query = remeasure(devices[7], rng);
+    char* json = estream_etfa_index_search(loaded, query.data(), 16, 2, 0);
+    CHECK(json != nullptr);
+    const std::string report(json);
+    estream_app_free_string(json);
+    CHECK(report.find("\"size\":1100,\"lists\":33,\"scanned\":1100,") != std::string::npos);
+    CHECK(report.find("\"matches\":[{\"id\":\"device-7\",\"distance\":") != std::string::npos);
+    estream_etfa_index_destroy(loaded);
+
+    std::FILE* f = std::fopen(path, "wb");
+    std::fputs("not an index", f);
+    std::fclose(f);
+    CHECK_EQ(estream_etfa_index_load(path), -1);
+    std::remove(path);
+
+    char* code = estream_etfa_fingerprint_code(devices[0].data(), 16);
+    CHECK(code != nullptr);
+    CHECK_EQ(std::string(code).size(), 32u);
+    estream_app_free_string(code);
+}
+
+int main() {
+    test_quantize();
+    test_simd_distance_matches_scalar();
+    test_noise_tolerance();
+    test_exact_and_approximate_search();
+    test_save_load_and_c_api();
+    std::puts("etfa_index_test: OK");
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include "check.h"
+#include "etfa.h"
+
+#include "estream_app_native.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace estream;
+
+namespace {
+
+// Plain versions of the integer kernels; the barriers in etfa.cpp must not
+// change what the kernels compute.
+uint64_t reference_int_mul64() {
+    uint64_t result = 1;
+    uint64_t multiplier = 7;
+    for (int i = 0; i < 1000000; ++i) {
+        result = (result * multiplier) & 0x7FFFFFFFFFFFFFFFull;
+        multiplier = (multiplier * 31 + 17) & 0x7FFFFFFFull;
+    }
+    return result;
+}
+
+uint64_t reference_add_parallel() {
+    return (1 + 5000000ull) + (2 + 6000000ull) + (3 + 7000000ull) + (4 + 8000000ull);
+}
+
+uint64_t reference_bitwise() {
+    uint64_t a = 0xDEADBEEFull;
+    uint64_t b = 0xCAFEBABEull;
+    for (int i = 0; i < 1000000; ++i) {
+        a = a ^ b;
+        b = (b & 0xFFFF0000ull) | (a & 0x0000FFFFull);
+        a = (a << 1) | (a >> 63);
+    }
+    return a ^ b;
+}
+
+struct ProgressLog {
+    std::vector<std::string> labels;
+    float last = 0.0f;
+};
+
+void on_progress(void* ctx, const char* label, float progress) {
+    auto* log = static_cast<ProgressLog*>(ctx);
+    CHECK(progress > log->last);
+    log->labels.emplace_back(label);
+    log->last = progress;
+}
+
+}  // namespace
+
+static void test_kernels_compute_reference_values() {
+    CHECK_EQ(etfa::run(etfa::Kernel::IntMul64), reference_int_mul64());
+    CHECK_EQ(etfa::run(etfa::Kernel::AddParallel), reference_add_parallel());
+    CHECK_EQ(etfa::run(etfa::Kernel::Bitwise), reference_bitwise());
+    // Byte i of the buffers is (i & 0xff): every 256 bytes sum to 32640.
+    CHECK_EQ(etfa::run(etfa::Kernel::MemSeq4K), 16u * 32640u);
+    CHECK_EQ(etfa::run(etfa::Kernel::MemSeq1M), 4096u * 32640u);
+    // The random walk over the full 1 MiB visits every byte exactly once.
+    CHECK_EQ(etfa::run(etfa::Kernel::MemRand1M), 4096u * 32640u);
+    // Float kernels are deterministic.
+    CHECK_EQ(etfa::run(etfa::Kernel::MatrixOp), etfa::run(etfa::Kernel::MatrixOp));
+    CHECK_EQ(etfa::run(etfa::Kernel::VectorDot), etfa::run(etfa::Kernel::VectorDot));
+}
+
+static void test_timer_and_median() {
+    CHECK(etfa::timer_resolution_ns() > 0.0);
+    CHECK(etfa::timer_resolution_ns() < 1000.0);
+    const uint64_t small = etfa::measure_median(etfa::Kernel::MemSeq4K, 5);
+    const uint64_t large = etfa::measure_median(etfa::Kernel::MemSeq4M, 5);
+    CHECK(small > 0);
+    CHECK(large > small * 16);
+}
+
+static void test_collect_reports_progress_and_ratios() {
+    CHECK(estream_etfa_collect(0, nullptr, nullptr) == nullptr);
+
+    ProgressLog log;
+    char* json = estream_etfa_collect(1, on_progress, &log);
+    CHECK(json != nullptr);
+    const std::string report(json);
+    estream_app_free_string(json);
+
+    CHECK_EQ(log.labels.size(), etfa::kKernelCount);
+    CHECK_EQ(log.labels.front(), std::string("Memory Sequential"));
+    CHECK(log.last == 1.0f);
+
+    CHECK(report.find("\"success\":true") != std::string::npos);
+    CHECK(report.find("\"sample_count\":1,") != std::string::npos);
+    for (size_t i = 0; i < etfa::kKernelCount; ++i) {
+        const std::string key = std::string("\"") + etfa::kernel_name(static_cast<etfa::Kernel>(i)) + "\":";
+        CHECK(report.find(key) != std::string::npos);
+    }
+    for (size_t i = 0; i < etfa::kRatioCount; ++i) {
+        const std::string key = std::string("\"") + etfa::ratio_name(i) + "\":";
+        const size_t pos = report.find(key);
+        CHECK(pos != std::string::npos);
+        CHECK(std::atof(report.c_str() + pos + key.size()) > 0.0);
+    }
+}
+
+static void test_parallel_tags_samples_by_cluster() {
+    const etfa::ParallelFingerprint fp = etfa::collect_parallel(2, 0, nullptr, nullptr);
+    CHECK(!fp.clusters.empty());
+    CHECK_EQ(fp.samples.size(), fp.clusters.size() * etfa::kKernelCount * 2);
+    uint64_t tagged = 0;
+    for (size_t i = 0; i < fp.clusters.size(); ++i) {
+        const etfa::ClusterFingerprint& c = fp.clusters[i];
+        CHECK_EQ(c.cluster.id, static_cast<int>(i));
+        CHECK(c.threads >= 1 && c.threads <= etfa::kDefaultThreadsPerCluster);
+        CHECK_EQ(c.samples, etfa::kKernelCount * 2);
+        for (uint64_t ns : c.fp.median_ns) {
+            CHECK(ns > 0);
+        }
+        tagged += c.samples;
+    }
+    for (const etfa::Sample& s : fp.samples) {
+        CHECK(s.cluster >= 0 && static_cast<size_t>(s.cluster) < fp.clusters.size());
+    }
+    CHECK_EQ(tagged, fp.samples.size());
+
+    ProgressLog log;
+    char* json = estream_etfa_collect_parallel(1, 1, on_progress, &log);
+    CHECK(json != nullptr);
+    const std::string report(json);
+    estream_app_free_string(json);
+    CHECK_EQ(log.labels.size(), etfa::kKernelCount * fp.clusters.size());
+    CHECK(log.last == 1.0f);
+    CHECK(report.find("\"clusters\":[{\"id\":0,") != std::string::npos);
+    CHECK(report.find("\"migrated_samples\":") != std::string::npos);
+    CHECK(report.find("\"r5_mem_seq_to_rand\":") < report.find("\"clusters\":"));
+}
+
+int main() {
+    test_kernels_compute_reference_values();
+    test_timer_and_median();
+    test_collect_reports_progress_and_ratios();
+    test_parallel_tags_samples_by_cluster();
+    std::puts("etfa_test: OK");
+    return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * Shared fixtures for the host unit tests: a seeded random source and
+ * synthetic camera planes for the spark tests.
+ */
+
+#ifndef ESTREAM_TEST_FIXTURES_H
+#define ESTREAM_TEST_FIXTURES_H
+
+#include "spark_detect.h"
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace estream {
+namespace test {
+
+/// xorshift64 with a fixed seed, so every run sees the same inputs.
+struct Rng {
+    uint64_t state = 88172645463325252ull;
+
+    uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+    /// The high 32 bits of the next state.
+    uint32_t next32() { return static_cast<uint32_t>(next() >> 32); }
+    /// Uniform in [0, 1).
+    double unit() { return static_cast<double>(next() >> 11) / 9007199254740992.0; }
+};
+
+/// A grey luma plane with `padding` bytes past each row.
+struct Image {
+    int width;
+    int height;
+    int stride;
+    std::vector<uint8_t> pixels;
+
+    Image(int w, int h, int padding = 0) : width(w), height(h), stride(w + padding),
+                                           pixels(static_cast<size_t>(stride) * h, 40) {}
+    uint8_t& at(int x, int y) { return pixels[static_cast<size_t>(y) * stride + x]; }
+    /// Fill a `size` x `size` square centered on the normalized point (x, y).
+    void square(double x, double y, int size, uint8_t value) {
+        const int x0 = static_cast<int>(x * width) - size / 2;
+        const int y0 = static_cast<int>(y * height) - size / 2;
+        for (int py = y0; py < y0 + size; ++py) {
+            for (int px = x0; px < x0 + size; ++px) {
+                at(px, py) = value;
+            }
+        }
+    }
+    spark::Plane plane() const {
+        spark::Plane p;
+        p.data = pixels.data();
+        p.width = width;
+        p.height = height;
+        p.row_stride = stride;
+        return p;
+    }
+};
+
+/// A dark 160x120 frame with a 3x3 particle at each normalized position.
+struct Frame {
+    int width = 160;
+    int height = 120;
+    std::vector<uint8_t> pixels;
+
+    explicit Frame(const std::vector<std::pair<double, double>>& particles)
+        : pixels(static_cast<size_t>(width) * height, 30) {
+        for (const auto& p : particles) {
+            const int cx = static_cast<int>(p.first * width);
+            const int cy = static_cast<int>(p.second * height);
+            for (int y = cy - 1; y <= cy + 1; ++y) {
+                for (int x = cx - 1; x <= cx + 1; ++x) {
+                    pixels[static_cast<size_t>(y) * width + x] = 240;
+                }
+            }
+        }
+    }
+
+    spark::Plane plane() const {
+        spark::Plane p;
+        p.data = pixels.data();
+        p.width = width;
+        p.height = height;
+        p.row_stride = width;
+        return p;
+    }
+};
+
+/// Four particles at radius 0.3 around the center, turned by `angle`.
+inline Frame orbit_frame(double angle) {
+    std::vector<std::pair<double, double>> particles;
+    for (int i = 0; i < 4; ++i) {
+        const double a = angle + i * 1.5707963267948966;
+        particles.emplace_back(0.5 + 0.3 * std::cos(a), 0.5 + 0.3 * std::sin(a));
+    }
+    return Frame(particles);
+}
+
+}  // namespace test
+}  // namespace estream
+
+#endif /* ESTREAM_TEST_FIXTURES_H */
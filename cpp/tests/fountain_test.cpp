@@ -0,0 +1,251 @@
+#include "check.h"
+#include "fixtures.h"
+#include "fountain.h"
+
+#include "estream_app_native.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace estream;
+using test::Rng;
+
+namespace {
+
+std::vector<uint8_t> random_message(Rng& rng, size_t len) {
+    std::vector<uint8_t> message(len);
+    for (uint8_t& b : message) {
+        b = static_cast<uint8_t>(rng.next32());
+    }
+    return message;
+}
+
+std::vector<uint8_t> make_part(const fountain::Encoder& encoder, uint32_t seq) {
+    std::vector<uint8_t> part(encoder.part_bytes());
+    encoder.part(seq, part.data());
+    return part;
+}
+
+// Feed parts from `first_seq` on, dropping each with probability
+// `loss_percent`; returns how many parts the decoder was given.
+uint32_t decode_with_loss(const std::vector<uint8_t>& message, uint32_t first_seq, uint32_t loss_percent, Rng& rng) {
+    fountain::Encoder encoder(message.data(), message.size(), 120);
+    fountain::Decoder decoder;
+    uint32_t given = 0;
+    for (uint32_t seq = first_seq; given < 20 * encoder.fragment_count() + 100; ++seq) {
+        if (rng.next32() % 100 < loss_percent) {
+            continue;
+        }
+        ++given;
+        const std::vector<uint8_t> part = make_part(encoder, seq);
+        if (decoder.receive(part.data(), part.size()) == fountain::Receive::Complete) {
+            CHECK(decoder.message() == message);
+            return given;
+        }
+    }
+    CHECK(false);
+    return given;
+}
+
+}  // namespace
+
+static void test_crc32() {
+    const char* check = "123456789";
+    CHECK_EQ(fountain::crc32(reinterpret_cast<const uint8_t*>(check), 9), 0xcbf43926u);
+    CHECK_EQ(fountain::crc32(nullptr, 0), 0u);
+}
+
+static void test_part_fragments() {
+    for (uint32_t seq = 1; seq <= 40; ++seq) {
+        CHECK(fountain::part_fragments(seq, 40, 0x1234) == std::vector<uint32_t>{seq - 1});
+    }
+    uint64_t degrees = 0;
+    for (uint32_t seq = 41; seq < 1041; ++seq) {
+        const std::vector<uint32_t> f = fountain::part_fragments(seq, 40, 0x1234);
+        CHECK(!f.empty());
+        for (size_t i = 0; i < f.size(); ++i) {
+            CHECK(f[i] < 40);
+            CHECK(i == 0 || f[i - 1] < f[i]);
+        }
+        CHECK(f == fountain::part_fragments(seq, 40, 0x1234));
+        degrees += f.size();
+    }
+    // Half the fragments on average.
+    CHECK(degrees > 19000 && degrees < 21000);
+    // The checksum seeds the choice.
+    CHECK(fountain::part_fragments(41, 40, 1) != fountain::part_fragments(41, 40, 2) ||
+          fountain::part_fragments(42, 40, 1) != fountain::part_fragments(42, 40, 2));
+}
+
+static void test_encoder_layout() {
+    Rng rng;
+    const std::vector<uint8_t> message = random_message(rng, 1000);
+    fountain::Encoder encoder(message.data(), message.size(), 120);
+    // 9 fragments, evened out to 112 bytes.
+    CHECK_EQ(encoder.fragment_count(), 9u);
+    CHECK_EQ(encoder.fragment_bytes(), size_t{112});
+    const std::vector<uint8_t> part = make_part(encoder, 2);
+    CHECK_EQ(part.size(), size_t{129});
+    const uint8_t header[] = {1, 0, 0, 0, 2, 0, 0, 0, 9, 0, 0, 3, 0xe8};
+    CHECK(std::memcmp(part.data(), header, sizeof(header)) == 0);
+    const uint32_t crc = fountain::crc32(message.data(), message.size());
+    CHECK_EQ(part[13], crc >> 24);
+    CHECK_EQ(part[16], crc & 0xff);
+    CHECK(std::memcmp(part.data() + 17, message.data() + 112, 112) == 0);
+    // The last fragment is zero-padded.
+    const std::vector<uint8_t> last = make_part(encoder, 9);
+    CHECK(std::memcmp(last.data() + 17, message.data() + 896, 104) == 0);
+    CHECK_EQ(last[17 + 104], 0);
+}
+
+static void test_systematic_round_trip() {
+    Rng rng;
+    for (size_t len : {size_t{0}, size_t{1}, size_t{119}, size_t{120}, size_t{121}, size_t{4627}}) {
+        const std::vector<uint8_t> message = random_message(rng, len);
+        fountain::Encoder encoder(message.data(), message.size(), 120);
+        fountain::Decoder decoder;
+        for (uint32_t seq = 1; seq <= encoder.fragment_count(); ++seq) {
+            const std::vector<uint8_t> part = make_part(encoder, seq);
+            const fountain::Receive want = seq == encoder.fragment_count() ? fountain::Receive::Complete
+                                                                             : fountain::Receive::Pending;
+            CHECK(decoder.receive(part.data(), part.size()) == want);
+        }
+        CHECK(decoder.complete());
+        CHECK(decoder.message() == message);
+        CHECK_EQ(decoder.progress(), 1.0);
+    }
+}
+
+static void test_recovers_through_loss() {
+    // An ML-DSA-87 response: 39 fragments.
+    Rng rng;
+    uint64_t given = 0;
+    uint64_t fragments = 0;
+    for (int trial = 0; trial < 50; ++trial) {
+        const std::vector<uint8_t> message = random_message(rng, 4627);
+        given += decode_with_loss(message, 1, 30, rng);
+        fragments += 39;
+    }
+    // Missed frames are made up by about as many mixed parts, plus one or
+    // two.
+    CHECK(given < fragments + 50 * 4);
+}
+
+static void test_recovers_from_mixed_parts_only() {
+    // Joining after the systematic parts went by.
+    Rng rng;
+    uint64_t given = 0;
+    uint64_t fragments = 0;
+    for (int trial = 0; trial < 20; ++trial) {
+        const std::vector<uint8_t> message = random_message(rng, 2000 + trial * 37);
+        given += decode_with_loss(message, 1000 + trial * 100, 0, rng);
+        fragments += (message.size() + 119) / 120;
+    }
+    CHECK(given < fragments + 20 * 4);
+}
+
+static void test_rejects_foreign_and_bad_parts() {
+    Rng rng;
+    const std::vector<uint8_t> a = random_message(rng, 500);
+    const std::vector<uint8_t> b = random_message(rng, 500);
+    fountain::Encoder ea(a.data(), a.size(), 120);
+    fountain::Encoder eb(b.data(), b.size(), 120);
+    fountain::Decoder decoder;
+
+    std::vector<uint8_t> part = make_part(ea, 1);
+    CHECK(decoder.receive(part.data(), part.size()) == fountain::Receive::Pending);
+    CHECK(decoder.receive(part.data(), part.size()) == fountain::Receive::Pending);
+    CHECK_EQ(decoder.parts_duplicate(), 1u);
+    CHECK_EQ(decoder.recovered(), 1u);
+
+    const std::vector<uint8_t> other = make_part(eb, 2);
+    CHECK(decoder.receive(other.data(), other.size()) == fountain::Receive::Invalid);
+    CHECK(decoder.receive(part.data(), 17) == fountain::Receive::Invalid);
+    CHECK(decoder.receive(part.data(), part.size() - 1) == fountain::Receive::Invalid);
+    part[0] = 2;
+    CHECK(decoder.receive(part.data(), part.size()) == fountain::Receive::Invalid);
+    std::vector<uint8_t> zero_seq = make_part(ea, 2);
+    std::memset(zero_seq.data() + 1, 0, 4);
+    CHECK(decoder.receive(zero_seq.data(), zero_seq.size()) == fountain::Receive::Invalid);
+    CHECK_EQ(decoder.parts_received(), 2u);
+
+    // A damaged fragment fails the CRC instead of yielding a bad message.
+    for (uint32_t seq = 2; seq <= ea.fragment_count(); ++seq) {
+        std::vector<uint8_t> p = make_part(ea, seq);
+        if (seq == 3) {
+            p[20] ^= 0x40;
+        }
+        CHECK(decoder.receive(p.data(), p.size()) == fountain::Receive::Pending);
+    }
+    CHECK(decoder.corrupt());
+    CHECK(!decoder.complete());
+
+    decoder.reset();
+    CHECK_EQ(decoder.fragment_count(), 0u);
+    CHECK_EQ(decoder.progress(), 0.0);
+    for (uint32_t seq = 1; seq <= eb.fragment_count(); ++seq) {
+        const std::vector<uint8_t> p = make_part(eb, seq);
+        decoder.receive(p.data(), p.size());
+    }
+    CHECK(decoder.message() == b);
+}
+
+static void test_c_api() {
+    Rng rng;
+    const std::vector<uint8_t> message = random_message(rng, 700);
+    const int part_bytes = estream_fountain_encode(message.data(), 700, 100, 1, 0, nullptr, 0);
+    CHECK_EQ(part_bytes, 17 + 100);
+    std::vector<uint8_t> parts(static_cast<size_t>(part_bytes) * 12);
+    CHECK_EQ(estream_fountain_encode(message.data(), 700, 100, 5, 12, parts.data(), static_cast<int>(parts.size())),
+             part_bytes);
+    CHECK_EQ(estream_fountain_encode(message.data(), 700, 100, 5, 12, parts.data(), 100), -1);
+    CHECK_EQ(estream_fountain_encode(message.data(), 700, 0, 1, 0, nullptr, 0), -1);
+    CHECK_EQ(estream_fountain_encode(message.data(), 700, 100, 0, 0, nullptr, 0), -1);
+    fountain::Encoder encoder(message.data(), message.size(), 100);
+    CHECK(std::memcmp(parts.data() + part_bytes, make_part(encoder, 6).data(), static_cast<size_t>(part_bytes)) == 0);
+
+    const long decoder = estream_fountain_decoder_create();
+    CHECK(decoder > 0);
+    CHECK_EQ(estream_fountain_decoder_message(decoder, nullptr, 0), -1);
+    int result = 0;
+    for (uint32_t seq = 1; result == 0; ++seq) {
+        const std::vector<uint8_t> p = make_part(encoder, seq);
+        result = estream_fountain_decoder_receive(decoder, p.data(), part_bytes);
+    }
+    CHECK_EQ(result, 1);
+    CHECK_EQ(estream_fountain_decoder_receive(decoder, parts.data(), 3), -1);
+
+    char* status = estream_fountain_decoder_status_json(decoder);
+    CHECK(status != nullptr);
+    CHECK(std::string(status).find("\"complete\":true") != std::string::npos);
+    CHECK(std::string(status).find("\"fragments\":7,\"recovered\":7") != std::string::npos);
+    CHECK(std::string(status).find("\"message_len\":700") != std::string::npos);
+    estream_app_free_string(status);
+
+    CHECK_EQ(estream_fountain_decoder_message(decoder, nullptr, 0), 700);
+    std::vector<uint8_t> out(700);
+    CHECK_EQ(estream_fountain_decoder_message(decoder, out.data(), 699), -1);
+    CHECK_EQ(estream_fountain_decoder_message(decoder, out.data(), 700), 700);
+    CHECK(out == message);
+
+    estream_fountain_decoder_reset(decoder);
+    CHECK_EQ(estream_fountain_decoder_message(decoder, nullptr, 0), -1);
+    estream_fountain_decoder_destroy(decoder);
+    CHECK_EQ(estream_fountain_decoder_receive(decoder, parts.data(), part_bytes), -1);
+    CHECK(estream_fountain_decoder_status_json(decoder) == nullptr);
+}
+
+int main() {
+    test_crc32();
+    test_part_fragments();
+    test_encoder_layout();
+    test_systematic_round_trip();
+    test_recovers_through_loss();
+    test_recovers_from_mixed_parts_only();
+    test_rejects_foreign_and_bad_parts();
+    test_c_api();
+    std::puts("fountain_test: OK");
+    return 0;
+}
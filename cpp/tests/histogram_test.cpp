@@ -0,0 +1,123 @@
+#include "check.h"
+#include "histogram.h"
+#include "latency.h"
+
+#include "estream_app_native.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace estream;
+
+static void test_buckets_are_contiguous() {
+    for (size_t i = 1; i < Histogram::kBucketCount; ++i) {
+        CHECK_EQ(Histogram::bucket_lower(i), Histogram::bucket_upper(i - 1) + 1);
+    }
+    const uint64_t values[] = {0, 1, 127, 128, 129, 1000, 123456789, Histogram::kMaxValue};
+    for (uint64_t v : values) {
+        const size_t i = Histogram::bucket_index(v);
+        CHECK(i < Histogram::kBucketCount);
+        CHECK(Histogram::bucket_lower(i) <= v);
+        CHECK(v <= Histogram::bucket_upper(i));
+    }
+}
+
+static void test_percentiles_within_precision() {
+    Histogram h;
+    for (uint64_t v = 1; v <= 100000; ++v) {
+        h.record(v * 1000);  // 1 us .. 100 ms
+    }
+    CHECK_EQ(h.count(), 100000u);
+    CHECK_EQ(h.min(), 1000u);
+    CHECK_EQ(h.max(), 100000000u);
+
+    const struct { double q; double expected; } cases[] = {
+        {0.5, 50000000.0}, {0.9, 90000000.0}, {0.99, 99000000.0},
+    };
+    for (const auto& c : cases) {
+        const double got = static_cast<double>(h.percentile(c.q));
+        CHECK(got >= c.expected * 0.984 && got <= c.expected * 1.016);
+    }
+    CHECK_EQ(h.percentile(1.0), h.max());
+}
+
+static void test_merge_and_clamp() {
+    Histogram a;
+    Histogram b;
+    a.record(10);
+    b.record(Histogram::kMaxValue + 12345);
+    a.merge(b);
+    CHECK_EQ(a.count(), 2u);
+    CHECK_EQ(a.min(), 10u);
+    CHECK_EQ(a.max(), Histogram::kMaxValue);
+    CHECK_EQ(Histogram().percentile(0.5), 0u);
+}
+
+static void test_reset_while_recording() {
+    // A reset partway through must not be undone by records in flight.
+    constexpr uint64_t kRecords = 1000000;
+    Histogram h;
+    std::atomic<bool> halfway{false};
+    std::thread recorder([&] {
+        for (uint64_t i = 0; i < kRecords; ++i) {
+            h.record(1);
+            if (i == kRecords / 2) {
+                halfway.store(true, std::memory_order_release);
+            }
+        }
+    });
+    while (!halfway.load(std::memory_order_acquire)) {
+    }
+    h.reset();
+    recorder.join();
+    CHECK(h.count() < kRecords / 2);
+    CHECK(h.sum() < kRecords / 2);
+}
+
+static void test_per_thread_merge_on_read() {
+    estream_latency_reset();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 1000; ++i) {
+                latency::record(ESTREAM_FN_RATCHET_ENCRYPT, 2000);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();  // Exited threads fold into the retired histogram.
+    }
+    latency::record(ESTREAM_FN_RATCHET_ENCRYPT, 4000);
+
+    EstreamLatencySnapshot snap;
+    CHECK_EQ(estream_latency_snapshot(&snap, ESTREAM_FN_RATCHET_ENCRYPT), 0);
+    CHECK_EQ(snap.count, 4001u);
+    CHECK_EQ(snap.min_ns, 2000u);
+    CHECK_EQ(snap.max_ns, 4000u);
+    CHECK(snap.p50_ns >= 2000 && snap.p50_ns < 2032);
+
+    CHECK_EQ(estream_latency_snapshot(&snap, ESTREAM_FN_COUNT), -1);
+    CHECK(std::strcmp(estream_fn_name(ESTREAM_FN_RATCHET_DECRYPT), "estream_ratchet_decrypt") == 0);
+
+    char* report = estream_latency_report();
+    CHECK(std::strstr(report, "\"estream_ratchet_encrypt\":{\"count\":4001") != nullptr);
+    CHECK(std::strstr(report, "estream_ratchet_decrypt") == nullptr);
+    estream_app_free_string(report);
+
+    estream_latency_reset();
+    CHECK_EQ(estream_latency_snapshot(&snap, ESTREAM_FN_RATCHET_ENCRYPT), 0);
+    CHECK_EQ(snap.count, 0u);
+}
+
+int main() {
+    test_buckets_are_contiguous();
+    test_percentiles_within_precision();
+    test_merge_and_clamp();
+    test_reset_while_recording();
+    test_per_thread_merge_on_read();
+    std::puts("histogram_test: OK");
+    return 0;
+}
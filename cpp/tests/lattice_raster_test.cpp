@@ -0,0 +1,190 @@
+#include "check.h"
+#include "fixtures.h"
+#include "lattice_raster.h"
+
+#include "estream_app_native.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace estream;
+using test::Rng;
+
+namespace {
+
+uint32_t div255(uint32_t x) {
+    return (x + 128 + ((x + 128) >> 8)) >> 8;
+}
+
+// Source-over of a premultiplied color at coverage m, one channel at a
+// time.
+lattice::Pixel reference_blend(lattice::Pixel dst, lattice::Pixel color, uint32_t m) {
+    const uint32_t inv = 255 - div255((color >> 24) * m);
+    lattice::Pixel out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        out |= (div255(((color >> shift) & 255) * m) + div255(((dst >> shift) & 255) * inv)) << shift;
+    }
+    return out;
+}
+
+lattice::Scene demo_scene() {
+    lattice::Scene scene;
+    scene.base_hue = 200.0;
+    scene.ring_speed = 0.5;
+    scene.heartbeat_freq = 1.2;
+    for (int i = 0; i < lattice::kHexCount; ++i) {
+        scene.hex_cells.push_back(static_cast<uint8_t>(i % 3));
+    }
+    scene.particles.center = 150.0;
+    // Particle 0 stands still at (250, 150).
+    scene.particles.add(100.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+    scene.particles.add(80.0, -0.7, 1.0, 2.0, 1.3, 2.0, 1.3);
+    scene.particle_colors = {0x00ffd5, 0xff00aa};
+    return scene;
+}
+
+lattice::Pixel pixel_at(const std::vector<uint8_t>& frame, size_t stride, int x, int y) {
+    lattice::Pixel p;
+    std::memcpy(&p, frame.data() + static_cast<size_t>(y) * stride + x * 4, sizeof(p));
+    return p;
+}
+
+}  // namespace
+
+static void test_hsla() {
+    CHECK_EQ(lattice::hsla(0.0, 1.0, 0.5, 1.0), 0xff0000ffu);
+    CHECK_EQ(lattice::hsla(120.0, 1.0, 0.5, 1.0), 0xff00ff00u);
+    CHECK_EQ(lattice::hsla(240.0, 1.0, 0.5, 1.0), 0xffff0000u);
+    CHECK_EQ(lattice::hsla(600.0, 1.0, 0.5, 1.0), 0xffff0000u);
+    // Premultiplied: half-transparent white.
+    CHECK_EQ(lattice::hsla(0.0, 0.0, 1.0, 0.5), 0x80808080u);
+    CHECK_EQ(lattice::rgb(0x00ffd5, 1.0), 0xffd5ff00u);
+}
+
+static void test_blend_matches_reference() {
+    // Every length up to a few vector widths, so both the SIMD loop and
+    // the scalar tail are covered.
+    Rng rng;
+    for (size_t n = 0; n < 19; ++n) {
+        for (int trial = 0; trial < 200; ++trial) {
+            const uint32_t alpha = trial % 4 == 0 ? 255 : rng.next32() & 255;
+            const lattice::Pixel color =
+                lattice::rgb(rng.next32() & 0xffffff, alpha / 255.0);
+            std::vector<lattice::Pixel> dst(n);
+            std::vector<uint8_t> coverage(n);
+            for (size_t i = 0; i < n; ++i) {
+                dst[i] = lattice::rgb(rng.next32() & 0xffffff, (rng.next32() & 255) / 255.0);
+                coverage[i] = static_cast<uint8_t>(i % 5 == 0 ? 255 : (i % 5 == 1 ? 0 : rng.next32()));
+            }
+            std::vector<lattice::Pixel> masked = dst;
+            std::vector<lattice::Pixel> full = dst;
+            lattice::blend_span(masked.data(), coverage.data(), n, color);
+            lattice::blend_span(full.data(), nullptr, n, color);
+            for (size_t i = 0; i < n; ++i) {
+                CHECK_EQ(masked[i], reference_blend(dst[i], color, coverage[i]));
+                CHECK_EQ(full[i], reference_blend(dst[i], color, 255));
+            }
+        }
+    }
+    std::vector<lattice::Pixel> filled(11, 0);
+    lattice::fill_span(filled.data() + 1, 9, 0x12345678u);
+    CHECK_EQ(filled[0], 0u);
+    CHECK_EQ(filled[1], 0x12345678u);
+    CHECK_EQ(filled[9], 0x12345678u);
+    CHECK_EQ(filled[10], 0u);
+}
+
+static void test_frame_content() {
+    const lattice::Scene scene = demo_scene();
+    lattice::Rasterizer rasterizer(300);
+    const size_t stride = 300 * 4;
+    std::vector<uint8_t> frame(stride * 300);
+    rasterizer.render(scene, 0.0, frame.data(), stride);
+
+    // Outside the disc stays clear.
+    CHECK_EQ(pixel_at(frame, stride, 0, 0), 0u);
+    CHECK_EQ(pixel_at(frame, stride, 299, 0), 0u);
+    // Inside it everything is opaque.
+    CHECK_EQ(pixel_at(frame, stride, 150, 20) >> 24, 255u);
+    // The center hexagon carries the heartbeat, opaque: at t = 0 it is
+    // halfway, hsl(hue, 90%, 55%).
+    CHECK_EQ(pixel_at(frame, stride, 150, 150), lattice::hsla(200.0, 0.9, 0.55, 1.0));
+    // The white core of the still particle.
+    CHECK_EQ(pixel_at(frame, stride, 250, 150), 0xffffffffu);
+    // The timing ring is drawn over the background between the markers
+    // (22.5 degrees off the first one).
+    const double a = 0.3926990816987241;
+    const int ring_x = static_cast<int>(150.0 + std::cos(a) * 145.0);
+    const int ring_y = static_cast<int>(150.0 + std::sin(a) * 145.0);
+    const int gap_x = static_cast<int>(150.0 + std::cos(a) * 137.5);
+    const int gap_y = static_cast<int>(150.0 + std::sin(a) * 137.5);
+    CHECK(pixel_at(frame, stride, ring_x, ring_y) != pixel_at(frame, stride, gap_x, gap_y));
+
+    // The same elapsed time draws the same frame; a later one differs.
+    std::vector<uint8_t> again(frame.size());
+    rasterizer.render(scene, 0.0, again.data(), stride);
+    CHECK(again == frame);
+    rasterizer.render(scene, 1234.0, again.data(), stride);
+    CHECK(again != frame);
+}
+
+static void test_scales_with_size() {
+    const lattice::Scene scene = demo_scene();
+    lattice::Rasterizer small(150);
+    lattice::Rasterizer large(600);
+    std::vector<uint8_t> a(150 * 150 * 4);
+    std::vector<uint8_t> b(600 * 600 * 4);
+    small.render(scene, 500.0, a.data(), 150 * 4);
+    large.render(scene, 500.0, b.data(), 600 * 4);
+    CHECK_EQ(pixel_at(a, 150 * 4, 75, 75), pixel_at(b, 600 * 4, 300, 300));
+    CHECK_EQ(pixel_at(a, 150 * 4, 125, 75), 0xffffffffu);
+    CHECK_EQ(pixel_at(b, 600 * 4, 500, 300), 0xffffffffu);
+}
+
+static void test_c_api() {
+    const lattice::Scene scene = demo_scene();
+    lattice::Rasterizer rasterizer(120);
+    std::vector<uint8_t> want(120 * 120 * 4);
+    rasterizer.render(scene, 2000.0, want.data(), 120 * 4);
+
+    const long renderer = estream_lattice_create(120);
+    CHECK(renderer > 0);
+    std::vector<double> orbits;
+    for (const std::vector<double>* column :
+         {&scene.particles.radius, &scene.particles.speed, &scene.particles.phase, &scene.particles.wobble_x,
+          &scene.particles.wobble_x_rate, &scene.particles.wobble_y, &scene.particles.wobble_y_rate}) {
+        orbits.insert(orbits.end(), column->begin(), column->end());
+    }
+    CHECK_EQ(estream_lattice_set_scene(renderer, scene.base_hue, scene.ring_speed, scene.heartbeat_freq,
+                                       scene.hex_cells.data(), static_cast<int>(scene.hex_cells.size()),
+                                       orbits.data(), scene.particle_colors.data(), 2),
+             0);
+    // Rows padded past the frame width.
+    const int stride = 130 * 4;
+    std::vector<uint32_t> buffer(130 * 120, 0xdeadbeefu);
+    uint8_t* rgba = reinterpret_cast<uint8_t*>(buffer.data());
+    CHECK_EQ(estream_lattice_render(renderer, 2000.0, rgba, stride), 0);
+    for (int y = 0; y < 120; ++y) {
+        CHECK(std::memcmp(rgba + y * stride, want.data() + y * 120 * 4, 120 * 4) == 0);
+        CHECK_EQ(buffer[y * 130 + 125], 0xdeadbeefu);
+    }
+
+    CHECK_EQ(estream_lattice_render(renderer, 0.0, rgba, 100), -1);
+    CHECK_EQ(estream_lattice_render(renderer, 0.0, rgba + 1, stride), -1);
+    CHECK_EQ(estream_lattice_set_scene(renderer, 0.0, 0.0, 0.0, nullptr, 3, nullptr, nullptr, 0), -1);
+    CHECK_EQ(estream_lattice_create(0), -1);
+    estream_lattice_destroy(renderer);
+    CHECK_EQ(estream_lattice_render(renderer, 0.0, rgba, stride), -1);
+}
+
+int main() {
+    test_hsla();
+    test_blend_matches_reference();
+    test_frame_content();
+    test_scales_with_size();
+    test_c_api();
+    std::puts("lattice_raster_test: OK");
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include "check.h"
+#include "prewarm.h"
+
+#include "estream_app_native.h"
+#include "estream_native.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace estream;
+
+// The core entry points prewarm.cpp calls, replaced so the test controls
+// each step. Defining them here keeps core_api.o (and the Rust core) out of
+// the link.
+namespace {
+
+constexpr long kHandle = 7;
+
+struct Core {
+    std::mutex mu;
+    std::condition_variable cv;
+    std::vector<std::string> calls;
+    std::vector<long> disposed;
+    bool fail_connect = false;
+    bool fail_keys = false;
+    bool hold_connect = false;
+};
+
+Core& core() {
+    static Core instance;
+    return instance;
+}
+
+void called(const char* name) {
+    std::lock_guard<std::mutex> lock(core().mu);
+    core().calls.push_back(name);
+}
+
+char* c_string(const char* s) {
+    char* out = static_cast<char*>(std::malloc(std::strlen(s) + 1));
+    std::strcpy(out, s);
+    return out;
+}
+
+void reset_core() {
+    prewarm::reset();
+    std::lock_guard<std::mutex> lock(core().mu);
+    core().calls.clear();
+    core().disposed.clear();
+    core().fail_connect = false;
+    core().fail_keys = false;
+    core().hold_connect = false;
+}
+
+void release_connect() {
+    std::lock_guard<std::mutex> lock(core().mu);
+    core().hold_connect = false;
+    core().cv.notify_all();
+}
+
+std::vector<std::string> calls() {
+    std::lock_guard<std::mutex> lock(core().mu);
+    return core().calls;
+}
+
+std::vector<long> disposed() {
+    std::lock_guard<std::mutex> lock(core().mu);
+    return core().disposed;
+}
+
+EstreamPrewarmConfig full_config() {
+    EstreamPrewarmConfig config{};
+    config.node_addr = "127.0.0.1:4433";
+    config.h3_addr = "127.0.0.1:8443";
+    config.budget_ms = 10000;
+    config.warm_crypto = 1;
+    return config;
+}
+
+std::string report() {
+    char* json = estream_prewarm_report();
+    const std::string out(json);
+    estream_app_free_string(json);
+    return out;
+}
+
+}  // namespace
+
+extern "C" void estream_free_string(char* s) {
+    std::free(s);
+}
+
+extern "C" long estream_app_initialize(void) {
+    called("initialize");
+    return kHandle;
+}
+
+extern "C" char* estream_app_connect(long handle, const char* /* node_addr */) {
+    called("connect");
+    std::unique_lock<std::mutex> lock(core().mu);
+    core().cv.wait(lock, [] { return !core().hold_connect; });
+    CHECK_EQ(handle, kHandle);
+    return c_string(core().fail_connect ? "{\"error\":\"unreachable\"}" : "{\"success\":true}");
+}
+
+extern "C" void estream_app_dispose(long handle) {
+    called("dispose");
+    std::lock_guard<std::mutex> lock(core().mu);
+    core().disposed.push_back(handle);
+}
+
+extern "C" char* estream_app_h3_connect(const char* /* server_addr */) {
+    called("h3_connect");
+    return c_string("{\"success\":true}");
+}
+
+extern "C" char* estream_app_generate_device_keys(const char* /* app_scope */) {
+    called("device_keys");
+    return c_string(core().fail_keys ? "{\"error\":\"keystore\"}" : "{}");
+}
+
+extern "C" char* estream_app_generate_prekey_bundle(const char* /* device_id */, int /* num_one_time_keys */) {
+    called("prekey_bundle");
+    return c_string("{}");
+}
+
+static void test_step_order() {
+    reset_core();
+    const EstreamPrewarmConfig config = full_config();
+    CHECK_EQ(estream_prewarm(&config), 0);
+    CHECK_EQ(estream_prewarm(&config), -1);
+
+    CHECK_EQ(estream_prewarm_take_handle(10000), kHandle);
+    CHECK_EQ(estream_prewarm_take_handle(0), -1);
+    CHECK_EQ(estream_prewarm_is_connected(kHandle, "127.0.0.1:4433"), 1);
+    CHECK_EQ(estream_prewarm_is_connected(kHandle, "127.0.0.1:9999"), 0);
+
+    const std::vector<std::string> expected = {"initialize", "connect", "h3_connect", "device_keys", "prekey_bundle"};
+    CHECK(calls() == expected);
+    CHECK(disposed().empty());
+
+    const std::string json = report();
+    const char* steps[] = {"prewarm_resolve", "prewarm_runtime", "prewarm_connect", "prewarm_h3_connect",
+                           "prewarm_crypto"};
+    size_t at = 0;
+    for (const char* step : steps) {
+        at = json.find(std::string("{\"name\":\"") + step + "\",\"ran\":true,\"ok\":true", at);
+        CHECK(at != std::string::npos);
+    }
+    CHECK(json.find("\"done\":true,\"budget_exceeded\":false") != std::string::npos);
+}
+
+static void test_failed_step() {
+    reset_core();
+    core().fail_connect = true;
+    core().fail_keys = true;
+    const EstreamPrewarmConfig config = full_config();
+    CHECK_EQ(estream_prewarm(&config), 0);
+
+    // The half-connected runtime is disposed, not handed over.
+    CHECK_EQ(estream_prewarm_take_handle(10000), -1);
+    CHECK(disposed() == std::vector<long>{kHandle});
+    CHECK_EQ(estream_prewarm_is_connected(kHandle, "127.0.0.1:4433"), 0);
+
+    const std::string json = report();
+    CHECK(json.find("{\"name\":\"prewarm_connect\",\"ran\":true,\"ok\":false") != std::string::npos);
+    // Later steps still run, and an error result counts as a failure.
+    CHECK(json.find("{\"name\":\"prewarm_h3_connect\",\"ran\":true,\"ok\":true") != std::string::npos);
+    CHECK(json.find("{\"name\":\"prewarm_crypto\",\"ran\":true,\"ok\":false") != std::string::npos);
+}
+
+static void test_take_handle_timeout() {
+    reset_core();
+    core().hold_connect = true;
+    const EstreamPrewarmConfig config = full_config();
+    CHECK_EQ(estream_prewarm(&config), 0);
+
+    const auto start = std::chrono::steady_clock::now();
+    CHECK_EQ(estream_prewarm_take_handle(50), -1);
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+    CHECK(report().find("\"done\":false") != std::string::npos);
+
+    // The client gave up, so the worker disposes the handle when it ends
+    // and nobody can take it afterwards.
+    release_connect();
+    prewarm::reset();
+    CHECK(disposed() == std::vector<long>{kHandle});
+}
+
+static void test_late_take_after_timeout() {
+    reset_core();
+    core().hold_connect = true;
+    const EstreamPrewarmConfig config = full_config();
+    CHECK_EQ(estream_prewarm(&config), 0);
+    CHECK_EQ(estream_prewarm_take_handle(10), -1);
+    release_connect();
+    CHECK_EQ(estream_prewarm_take_handle(10000), -1);
+    prewarm::reset();
+    CHECK(disposed() == std::vector<long>{kHandle});
+}
+
+static void test_invalid_config() {
+    reset_core();
+    CHECK_EQ(estream_prewarm(nullptr), -1);
+    CHECK_EQ(estream_prewarm_take_handle(0), -1);
+    CHECK_EQ(estream_prewarm_is_connected(kHandle, nullptr), 0);
+    CHECK(report().find("\"started\":false") != std::string::npos);
+}
+
+int main() {
+    test_step_order();
+    test_failed_step();
+    test_take_handle_timeout();
+    test_late_take_after_timeout();
+    test_invalid_config();
+    std::puts("prewarm_test: OK");
+    return 0;
+}
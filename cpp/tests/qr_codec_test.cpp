@@ -0,0 +1,267 @@
+#include "check.h"
+#include "qr_codec.h"
+
+#include "estream_app_native.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace estream;
+
+namespace {
+
+std::vector<uint8_t> bytes_of(const char* s) {
+    return std::vector<uint8_t>(s, s + std::strlen(s));
+}
+
+std::string base45(const char* s) {
+    const std::vector<uint8_t> b = bytes_of(s);
+    return qr::base45_encode(b.data(), b.size());
+}
+
+qr::SigningRequest demo_request() {
+    qr::SigningRequest request;
+    request.id = "0f8fad5b-d9cb-469f-a165-70867728950e";
+    request.operation = "deploy";
+    request.description = "Deploy release 2026.10 to edge-west (3 nodes)";
+    request.payload.assign(32, 0xab);
+    request.timestamp = 1760000000123;
+    request.expires_at = 1760000300123;
+    request.metadata = "{\"releaseId\":\"r-2026.10\",\"targets\":[\"edge-west\"]}";
+    return request;
+}
+
+qr::SigningResponse demo_response() {
+    qr::SigningResponse response;
+    response.request_id = "0f8fad5b-d9cb-469f-a165-70867728950e";
+    for (size_t i = 0; i < 4627; ++i) {
+        response.signature.push_back(static_cast<uint8_t>(i * 31 + 7));
+    }
+    response.signer_key_hash.assign(32, 0x5c);
+    response.algorithm = "ML-DSA-87";
+    response.timestamp = 1760000000456;
+    return response;
+}
+
+}  // namespace
+
+static void test_base45_rfc9285() {
+    CHECK(base45("AB") == "BB8");
+    CHECK(base45("Hello!!") == "%69 VD92EX0");
+    CHECK(base45("base-45") == "UJCLQE7W581");
+    CHECK(base45("ietf!") == "QED8WEX0");
+    CHECK(base45("") == "");
+
+    std::vector<uint8_t> out;
+    CHECK(qr::base45_decode("QED8WEX0", 8, out));
+    CHECK(out == bytes_of("ietf!"));
+    CHECK(qr::base45_decode("%69 VD92EX0", 11, out));
+    CHECK(out == bytes_of("Hello!!"));
+    // 65536, past two bytes; a dangling character; outside the set.
+    CHECK(!qr::base45_decode("GGW", 3, out));
+    CHECK(!qr::base45_decode("BB8B", 4, out));
+    CHECK(!qr::base45_decode("bb8", 3, out));
+
+    std::vector<uint8_t> all(256);
+    for (int i = 0; i < 256; ++i) {
+        all[i] = static_cast<uint8_t>(255 - i);
+    }
+    for (size_t len : {size_t{1}, size_t{2}, size_t{255}, size_t{256}}) {
+        const std::string text = qr::base45_encode(all.data(), len);
+        CHECK_EQ(text.size(), len / 2 * 3 + (len % 2) * 2);
+        CHECK(qr::base45_decode(text.data(), text.size(), out));
+        CHECK(out == std::vector<uint8_t>(all.begin(), all.begin() + len));
+    }
+}
+
+static void test_request_round_trip() {
+    const qr::SigningRequest request = demo_request();
+    const std::vector<uint8_t> encoded = qr::encode(request);
+    CHECK_EQ(encoded[0], qr::kFormatVersion);
+    CHECK_EQ(encoded[1], 1);
+    qr::SigningRequest decoded;
+    CHECK(qr::decode(encoded.data(), encoded.size(), decoded));
+    CHECK(decoded.id == request.id);
+    CHECK(decoded.operation == "deploy");
+    CHECK(decoded.description == request.description);
+    CHECK(decoded.payload == request.payload);
+    CHECK_EQ(decoded.timestamp, request.timestamp);
+    CHECK_EQ(decoded.expires_at, request.expires_at);
+    CHECK(decoded.metadata == request.metadata);
+    // A request is not a response.
+    qr::SigningResponse response;
+    CHECK(!qr::decode(encoded.data(), encoded.size(), response));
+
+    // Values outside the dictionaries, a non-UUID id, expiry before the
+    // timestamp and no optional fields.
+    qr::SigningRequest odd;
+    odd.id = "0F8FAD5B-D9CB-469F-A165-70867728950E";
+    odd.operation = "rotate_keys";
+    odd.timestamp = 1000;
+    odd.expires_at = 10;
+    const std::vector<uint8_t> odd_encoded = qr::encode(odd);
+    CHECK(qr::decode(odd_encoded.data(), odd_encoded.size(), decoded));
+    CHECK(decoded.id == odd.id);
+    CHECK(decoded.operation == "rotate_keys");
+    CHECK(decoded.description.empty() && decoded.payload.empty() && decoded.metadata.empty());
+    CHECK_EQ(decoded.expires_at, 10u);
+}
+
+static void test_response_round_trip_and_size() {
+    const qr::SigningResponse response = demo_response();
+    const std::vector<uint8_t> encoded = qr::encode(response);
+    // Header 2, UUID 18, algorithm 2, signature 3 + 4627, key hash 34,
+    // timestamp 7.
+    CHECK_EQ(encoded.size(), size_t{4693});
+    qr::SigningResponse decoded;
+    CHECK(qr::decode(encoded.data(), encoded.size(), decoded));
+    CHECK(decoded.request_id == response.request_id);
+    CHECK(decoded.signature == response.signature);
+    CHECK(decoded.signer_key_hash == response.signer_key_hash);
+    CHECK(decoded.algorithm == "ML-DSA-87");
+    CHECK_EQ(decoded.timestamp, response.timestamp);
+    // 1.5 alphanumeric characters per byte.
+    CHECK_EQ(qr::base45_encode(encoded.data(), encoded.size()).size(), size_t{7040});
+}
+
+static void test_rejects_malformed() {
+    const std::vector<uint8_t> encoded = qr::encode(demo_request());
+    qr::SigningRequest decoded;
+    // Cut inside the header, and inside the last field.
+    CHECK(!qr::decode(encoded.data(), 1, decoded));
+    CHECK(!qr::decode(encoded.data(), encoded.size() - 1, decoded));
+    CHECK(!qr::decode(nullptr, 0, decoded));
+
+    std::vector<uint8_t> bad = encoded;
+    bad[0] = 1;
+    CHECK(!qr::decode(bad.data(), bad.size(), decoded));
+
+    // Unknown fields are skipped; unknown wire types are not.
+    std::vector<uint8_t> extended = encoded;
+    const uint8_t unknown[] = {20 << 2 | 1, 3, 'x', 'y', 'z', 21 << 2, 0x7f};
+    extended.insert(extended.end(), unknown, unknown + sizeof(unknown));
+    CHECK(qr::decode(extended.data(), extended.size(), decoded));
+    CHECK(decoded.description == demo_request().description);
+    extended.push_back(static_cast<uint8_t>(22 << 2 | 2));
+    extended.push_back(0);
+    CHECK(!qr::decode(extended.data(), extended.size(), decoded));
+
+    // Operation number past the dictionary; text that is not UTF-8.
+    const uint8_t operation[] = {2, 1, 3 << 2, 99};
+    CHECK(!qr::decode(operation, sizeof(operation), decoded));
+    const uint8_t text[] = {2, 1, 5 << 2 | 1, 2, 0xc3, 0x28};
+    CHECK(!qr::decode(text, sizeof(text), decoded));
+    const uint8_t nul[] = {2, 1, 5 << 2 | 1, 1, 0};
+    CHECK(!qr::decode(nul, sizeof(nul), decoded));
+}
+
+static void test_request_requires_id_and_timestamp() {
+    // id "r1", operation 0, timestamp 5.
+    const uint8_t complete[] = {2, 1, 1 << 2 | 1, 2, 'r', '1', 3 << 2, 0, 7 << 2, 5};
+    qr::SigningRequest decoded;
+    CHECK(qr::decode(complete, sizeof(complete), decoded));
+    CHECK(decoded.id == "r1");
+    CHECK_EQ(decoded.timestamp, uint64_t{5});
+
+    const uint8_t no_id[] = {2, 1, 3 << 2, 0, 7 << 2, 5};
+    CHECK(!qr::decode(no_id, sizeof(no_id), decoded));
+    const uint8_t no_timestamp[] = {2, 1, 1 << 2 | 1, 2, 'r', '1', 3 << 2, 0};
+    CHECK(!qr::decode(no_timestamp, sizeof(no_timestamp), decoded));
+    // A zero timestamp is present, not missing.
+    const uint8_t zero_timestamp[] = {2, 1, 1 << 2 | 1, 2, 'r', '1', 7 << 2, 0};
+    CHECK(qr::decode(zero_timestamp, sizeof(zero_timestamp), decoded));
+}
+
+static void test_rejects_wrong_wire_type() {
+    // id "r1", then timestamp sent as bytes, or payload sent as a varint.
+    const uint8_t timestamp_bytes[] = {2, 1, 1 << 2 | 1, 2, 'r', '1', 7 << 2 | 1, 1, 5};
+    qr::SigningRequest request;
+    CHECK(!qr::decode(timestamp_bytes, sizeof(timestamp_bytes), request));
+    const uint8_t payload_varint[] = {2, 1, 1 << 2 | 1, 2, 'r', '1', 7 << 2, 5, 6 << 2, 9};
+    CHECK(!qr::decode(payload_varint, sizeof(payload_varint), request));
+    const uint8_t id_varint[] = {2, 1, 1 << 2, 4, 7 << 2, 5};
+    CHECK(!qr::decode(id_varint, sizeof(id_varint), request));
+
+    // Response: algorithm sent as bytes, signature sent as a varint.
+    const uint8_t algorithm_bytes[] = {2, 2, 1 << 2 | 1, 2, 'r', '1', 3 << 2 | 1, 1, 0};
+    qr::SigningResponse response;
+    CHECK(!qr::decode(algorithm_bytes, sizeof(algorithm_bytes), response));
+    const uint8_t signature_varint[] = {2, 2, 1 << 2 | 1, 2, 'r', '1', 5 << 2, 1};
+    CHECK(!qr::decode(signature_varint, sizeof(signature_varint), response));
+    const uint8_t valid[] = {2, 2, 1 << 2 | 1, 2, 'r', '1', 3 << 2, 0, 5 << 2 | 1, 1, 0xab};
+    CHECK(qr::decode(valid, sizeof(valid), response));
+    CHECK(response.algorithm == "ML-DSA-87");
+}
+
+static void test_request_json() {
+    qr::SigningRequest request = demo_request();
+    request.description = "Caf\xc3\xa9 \"quoted\" \xf0\x9f\x94\x91\n";
+    request.payload = {0x01, 0xfe};
+    const std::string json = qr::to_json(request);
+    CHECK(json.find("\"id\":\"0f8fad5b-d9cb-469f-a165-70867728950e\"") != std::string::npos);
+    CHECK(json.find("\"description\":\"Caf\\u00e9 \\\"quoted\\\" \\ud83d\\udd11\\u000a\"") != std::string::npos);
+    CHECK(json.find("\"payload_length\":2,") != std::string::npos);
+    CHECK(json.find("\"expires_at\":1760000300123") != std::string::npos);
+    CHECK(json.find("\"metadata\":\"{\\\"releaseId\\\"") != std::string::npos);
+    for (char c : json) {
+        CHECK(static_cast<unsigned char>(c) >= 0x20 && static_cast<unsigned char>(c) < 0x7f);
+    }
+}
+
+static void test_c_api() {
+    const qr::SigningResponse response = demo_response();
+    const int len = estream_qr_encode_response(response.request_id.c_str(), response.signature.data(), 4627,
+                                               response.signer_key_hash.data(), 32, "ML-DSA-87",
+                                               response.timestamp, nullptr, 0);
+    CHECK_EQ(len, 4693);
+    std::vector<uint8_t> out(static_cast<size_t>(len));
+    CHECK_EQ(estream_qr_encode_response(response.request_id.c_str(), response.signature.data(), 4627,
+                                        response.signer_key_hash.data(), 32, "ML-DSA-87", response.timestamp,
+                                        out.data(), len - 1),
+             -1);
+    CHECK_EQ(estream_qr_encode_response(response.request_id.c_str(), response.signature.data(), 4627,
+                                        response.signer_key_hash.data(), 32, "ML-DSA-87", response.timestamp,
+                                        out.data(), len),
+             len);
+    CHECK(out == qr::encode(response));
+    CHECK_EQ(estream_qr_encode_response(nullptr, nullptr, 0, nullptr, 0, "x", 0, nullptr, 0), -1);
+
+    const std::vector<uint8_t> request = qr::encode(demo_request());
+    std::vector<uint8_t> payload(request.size());
+    char* json = estream_qr_decode_request_json(request.data(), static_cast<int>(request.size()), payload.data(),
+                                                static_cast<int>(payload.size()));
+    CHECK(json != nullptr);
+    CHECK(std::string(json) == qr::to_json(demo_request()));
+    estream_app_free_string(json);
+    payload.resize(demo_request().payload.size());
+    CHECK(payload == demo_request().payload);
+    CHECK(estream_qr_decode_request_json(request.data(), 3, payload.data(), 0) == nullptr);
+    CHECK(estream_qr_decode_request_json(request.data(), static_cast<int>(request.size()), payload.data(),
+                                         static_cast<int>(payload.size()) - 1) == nullptr);
+
+    const uint8_t hello[] = {'H', 'e', 'l', 'l', 'o', '!', '!'};
+    char text[16];
+    CHECK_EQ(estream_qr_base45_encode(hello, 7, nullptr, 0), 11);
+    CHECK_EQ(estream_qr_base45_encode(hello, 7, text, 10), -1);
+    CHECK_EQ(estream_qr_base45_encode(hello, 7, text, sizeof(text)), 11);
+    CHECK(std::memcmp(text, "%69 VD92EX0", 11) == 0);
+    uint8_t back[8];
+    CHECK_EQ(estream_qr_base45_decode(text, 11, back, sizeof(back)), 7);
+    CHECK(std::memcmp(back, hello, 7) == 0);
+    CHECK_EQ(estream_qr_base45_decode("GGW", 3, nullptr, 0), -1);
+}
+
+int main() {
+    test_base45_rfc9285();
+    test_request_round_trip();
+    test_response_round_trip_and_size();
+    test_rejects_malformed();
+    test_request_requires_id_and_timestamp();
+    test_rejects_wrong_wire_type();
+    test_request_json();
+    test_c_api();
+    std::puts("qr_codec_test: OK");
+    return 0;
+}
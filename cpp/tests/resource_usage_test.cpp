@@ -0,0 +1,89 @@
+#include "check.h"
+#include "resource_usage.h"
+#include "thread_stats.h"
+
+#include "estream_app_native.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace estream;
+
+namespace {
+
+void burn_cpu_ms(uint64_t ms) {
+    const uint64_t start = thread_stats::current_thread_cpu_ns();
+    volatile uint64_t sink = 0;
+    while (thread_stats::current_thread_cpu_ns() - start < ms * 1000000u) {
+        sink = sink + 1;
+    }
+}
+
+// cpu_us of one subsystem in the report, in milliseconds.
+double subsystem_cpu_ms(const char* name) {
+    char* json = estream_resource_usage();
+    const std::string report(json);
+    estream_app_free_string(json);
+    const std::string key = std::string("\"") + name + "\":{\"cpu_us\":";
+    const size_t pos = report.find(key);
+    CHECK(pos != std::string::npos);
+    return std::atof(report.c_str() + pos + key.size()) / 1000.0;
+}
+
+}  // namespace
+
+static void test_disabled_charges_nothing() {
+    estream_resource_reset();
+    estream_resource_accounting(0);
+    estream_resource_begin(ESTREAM_SUBSYSTEM_TRANSPORT);
+    burn_cpu_ms(5);
+    estream_resource_end();
+    CHECK(subsystem_cpu_ms("transport") == 0.0);
+}
+
+static void test_nested_scopes_are_exclusive() {
+    estream_resource_reset();
+    estream_resource_accounting(1);
+    estream_resource_begin(ESTREAM_SUBSYSTEM_TRANSPORT);
+    burn_cpu_ms(20);
+    estream_resource_begin(ESTREAM_SUBSYSTEM_H3);
+    burn_cpu_ms(10);
+    estream_resource_end();
+    estream_resource_end();
+    estream_resource_accounting(0);
+
+    const double transport = subsystem_cpu_ms("transport");
+    const double h3 = subsystem_cpu_ms("h3");
+    CHECK(transport >= 19.0 && transport < 28.0);
+    CHECK(h3 >= 9.0 && h3 < 18.0);
+    CHECK(subsystem_cpu_ms("crypto") == 0.0);
+}
+
+static void test_toggle_inside_scope_stays_balanced() {
+    estream_resource_reset();
+    estream_resource_begin(ESTREAM_SUBSYSTEM_TRANSPORT);  // Disabled: untracked.
+    estream_resource_accounting(1);
+    estream_resource_end();
+    estream_resource_begin(ESTREAM_SUBSYSTEM_H3);
+    burn_cpu_ms(5);
+    estream_resource_end();
+    estream_resource_accounting(0);
+    CHECK(subsystem_cpu_ms("transport") == 0.0);
+    CHECK(subsystem_cpu_ms("h3") >= 4.0);
+}
+
+static void test_entry_point_mapping() {
+    CHECK_EQ(resource_usage::subsystem_of(ESTREAM_FN_RATCHET_DECRYPT), ESTREAM_SUBSYSTEM_CRYPTO);
+    CHECK_EQ(resource_usage::subsystem_of(ESTREAM_FN_H3_POST), ESTREAM_SUBSYSTEM_H3);
+    CHECK_EQ(resource_usage::subsystem_of(ESTREAM_FN_CONNECT), ESTREAM_SUBSYSTEM_TRANSPORT);
+}
+
+int main() {
+    test_disabled_charges_nothing();
+    test_nested_scopes_are_exclusive();
+    test_toggle_inside_scope_stays_balanced();
+    test_entry_point_mapping();
+    std::puts("resource_usage_test: OK");
+    return 0;
+}
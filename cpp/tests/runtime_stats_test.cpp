@@ -0,0 +1,94 @@
+#include "check.h"
+#include "runtime_stats.h"
+#include "thread_stats.h"
+#include "trace.h"
+
+#include "estream_app_native.h"
+
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <string>
+#include <thread>
+
+#include <pthread.h>
+
+using namespace estream;
+
+static void test_disabled_records_nothing() {
+    estream_runtime_profiling(0);
+    ProfiledMutex mu("test_disabled");
+    mu.lock();
+    mu.unlock();
+    CHECK_EQ(runtime_stats::lock_stats("test_disabled")->acquisitions.load(), 0u);
+}
+
+static void test_contended_wait_is_recorded() {
+    estream_runtime_profiling(1);
+    ProfiledMutex mu("test_contended");
+    mu.lock();
+    std::thread waiter([&] {
+        mu.lock();
+        mu.unlock();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    mu.unlock();
+    waiter.join();
+    estream_runtime_profiling(0);
+
+    const runtime_stats::LockStats* s = runtime_stats::lock_stats("test_contended");
+    CHECK_EQ(s->acquisitions.load(), 2u);
+    CHECK_EQ(s->contended.load(), 1u);
+    CHECK(s->wait_total_ns.load() >= 10000000u);
+    CHECK_EQ(s->wait.count(), 1u);
+}
+
+static void test_ffi_overlap() {
+    estream_runtime_stats_reset();
+    runtime_stats::ffi_enter();
+    runtime_stats::ffi_enter();
+    runtime_stats::ffi_exit();
+    runtime_stats::ffi_exit();
+    const std::string report = runtime_stats::report_json();
+    CHECK(report.find("\"calls\":2,\"in_flight\":0,\"max_in_flight\":2,\"overlapped_calls\":1") !=
+          std::string::npos);
+}
+
+static void test_worker_threads_sampled() {
+    // The worker publishes its TID once named, then blocks until released,
+    // so it stays visible for as long as the sampling below takes.
+    std::promise<uint32_t> named;
+    std::promise<void> release;
+    std::thread worker([&named, done = release.get_future()] {
+#if defined(__APPLE__)
+        pthread_setname_np("tokio-runtime-worker");
+#else
+        pthread_setname_np(pthread_self(), "tokio-runtime-w");
+#endif
+        named.set_value(trace::current_tid());
+        done.wait();
+    });
+    const std::string entry = "{\"tid\":" + std::to_string(named.get_future().get()) + ",\"name\":\"tokio-runtime-w";
+
+    std::string report;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    do {
+        char* json = estream_runtime_stats();
+        report = json;
+        estream_app_free_string(json);
+    } while (report.find(entry) == std::string::npos && std::chrono::steady_clock::now() < deadline);
+    release.set_value();
+    worker.join();
+
+    CHECK(report.find(entry) != std::string::npos);
+    CHECK(report.find("\"locks\":[") != std::string::npos);
+}
+
+int main() {
+    test_disabled_records_nothing();
+    test_contended_wait_is_recorded();
+    test_ffi_overlap();
+    test_worker_threads_sampled();
+    std::puts("runtime_stats_test: OK");
+    return 0;
+}
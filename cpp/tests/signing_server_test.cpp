@@ -0,0 +1,482 @@
+#include "check.h"
+#include "signing_server.h"
+
+#include "estream_app_native.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace estream::signing;
+
+namespace {
+
+ParseResult parse(const std::string& text, HttpRequest& request) {
+    return parse_request(text.data(), text.size(), request);
+}
+
+std::string path_of(const HttpRequest& request) {
+    return std::string(request.path, request.path_len);
+}
+
+std::string member(const std::string& json, const char* key) {
+    const char* value = nullptr;
+    size_t len = 0;
+    if (!json_string_member(json.data(), json.size(), key, value, len)) {
+        return "<none>";
+    }
+    return std::string(value, len);
+}
+
+std::string sign_body(const std::string& id) {
+    return "{\"id\":\"" + id + "\",\"operation\":\"deploy\",\"payload\":\"3yZe7d\"}";
+}
+
+// `receive_buffer` > 0 shrinks the socket's receive buffer (set before
+// connecting so the advertised window follows).
+int connect_to(uint16_t port, int receive_buffer = 0) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (receive_buffer > 0) {
+        CHECK(::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer)) == 0);
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    return fd;
+}
+
+void send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, 0);
+        CHECK(n > 0);
+        sent += static_cast<size_t>(n);
+    }
+}
+
+struct Response {
+    int code = 0;
+    bool close = false;
+    std::string body;
+};
+
+// Read one response off `fd`, keeping anything after it in `pending`.
+// Code 0 if the connection closed first.
+Response read_response(int fd, std::string& pending) {
+    Response response;
+    for (;;) {
+        const size_t head_end = pending.find("\r\n\r\n");
+        if (head_end != std::string::npos) {
+            const size_t length_at = pending.find("Content-Length: ");
+            CHECK(length_at != std::string::npos && length_at < head_end);
+            const size_t length = std::strtoul(pending.c_str() + length_at + 16, nullptr, 10);
+            if (pending.size() >= head_end + 4 + length) {
+                response.code = std::atoi(pending.c_str() + 9);
+                response.close = pending.find("Connection: close") < head_end;
+                response.body = pending.substr(head_end + 4, length);
+                pending.erase(0, head_end + 4 + length);
+                return response;
+            }
+        }
+        char buf[4096];
+        const ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            return response;
+        }
+        pending.append(buf, static_cast<size_t>(n));
+    }
+}
+
+std::string post(const std::string& path, const std::string& body) {
+    return "POST " + path + " HTTP/1.1\r\nHost: phone\r\nContent-Type: application/json\r\nContent-Length: " +
+           std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+}  // namespace
+
+static void test_parse_request() {
+    HttpRequest r;
+    const std::string get = "GET /health HTTP/1.1\r\nHost: x\r\n\r\n";
+    CHECK(parse(get, r) == ParseResult::Complete);
+    CHECK(r.method == Method::Get);
+    CHECK(path_of(r) == "/health");
+    CHECK(r.keep_alive);
+    CHECK_EQ(r.content_length, 0u);
+    CHECK_EQ(r.header_bytes, 33u);
+
+    // Split anywhere before the blank line: incomplete.
+    const std::string full = post("/sign?x=1", "{\"id\":\"a\"}");
+    for (size_t cut = 0; cut < full.find("\r\n\r\n") + 3; ++cut) {
+        CHECK(parse(full.substr(0, cut), r) == ParseResult::Incomplete);
+    }
+    CHECK(parse(full, r) == ParseResult::Complete);
+    CHECK(r.method == Method::Post);
+    CHECK(path_of(r) == "/sign");
+    CHECK_EQ(r.content_length, 10u);
+    CHECK_EQ(r.header_bytes + r.content_length, full.size());
+
+    CHECK(parse("GET / HTTP/1.0\r\n\r\n", r) == ParseResult::Complete && !r.keep_alive);
+    CHECK(parse("GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n", r) == ParseResult::Complete && r.keep_alive);
+    CHECK(parse("GET / HTTP/1.1\r\nCONNECTION: close\r\n\r\n", r) == ParseResult::Complete && !r.keep_alive);
+    CHECK(parse("GET / HTTP/1.1\ncontent-length:  3 \n\n", r) == ParseResult::Complete);
+    CHECK_EQ(r.content_length, 3u);
+    CHECK(parse("DELETE /sign HTTP/1.1\r\n\r\n", r) == ParseResult::Complete && r.method == Method::Other);
+
+    CHECK(parse("GET /health\r\n\r\n", r) == ParseResult::Bad);
+    CHECK(parse("GET health HTTP/1.1\r\n\r\n", r) == ParseResult::Bad);
+    CHECK(parse("GET / HTTP/2\r\n\r\n", r) == ParseResult::Bad);
+    CHECK(parse("GET / HTTP/1.1\r\nno colon\r\n\r\n", r) == ParseResult::Bad);
+    CHECK(parse("POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n", r) == ParseResult::Bad);
+    CHECK(parse("POST / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n", r) == ParseResult::Bad);
+    CHECK(parse("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n", r) == ParseResult::Bad);
+
+    CHECK(parse("POST / HTTP/1.1\r\nContent-Length: 16385\r\n\r\n", r) == ParseResult::TooLarge);
+    CHECK(parse("POST / HTTP/1.1\r\nContent-Length: 99999999999999999999999\r\n\r\n", r) == ParseResult::TooLarge);
+    CHECK(parse("GET / HTTP/1.1\r\nX: " + std::string(kMaxHeaderBytes, 'a') + "\r\n\r\n", r) ==
+          ParseResult::TooLarge);
+}
+
+static void test_json_string_member() {
+    CHECK(member("{\"id\":\"abc\"}", "id") == "abc");
+    CHECK(member(" { \"x\" : {\"id\":\"inner\",\"a\":[1,{\"b\":\"}\"}]}, \"s\":\"q\\\"}\", \"n\": -1.5e3,"
+                 " \"t\":true, \"id\" : \"outer\" } ",
+                 "id") == "outer");
+    CHECK(member("{\"id\":\"\"}", "id") == "");
+    CHECK(member("{\"i\\u0064\":\"escaped key\"}", "id") == "<none>");
+    CHECK(member("{\"id\":\"a\\\"b\"}", "id") == "<none>");
+    CHECK(member("{\"id\":7}", "id") == "<none>");
+    CHECK(member("{\"other\":\"x\"}", "id") == "<none>");
+    CHECK(member("[\"id\",\"x\"]", "id") == "<none>");
+    CHECK(member("{\"id\"", "id") == "<none>");
+    CHECK(member("{\"a\":1 \"id\":\"x\"}", "id") == "<none>");
+    CHECK(member("", "id") == "<none>");
+
+    uint64_t n = 0;
+    const std::string numbers = "{\"a\":\"1\",\"b\":1760000000123,\"c\":-1,\"d\":1.5,\"e\":18446744073709551616}";
+    CHECK(json_uint_member(numbers.data(), numbers.size(), "b", n) && n == 1760000000123ull);
+    CHECK(!json_uint_member(numbers.data(), numbers.size(), "a", n));
+    CHECK(!json_uint_member(numbers.data(), numbers.size(), "c", n));
+    CHECK(!json_uint_member(numbers.data(), numbers.size(), "d", n));
+    CHECK(!json_uint_member(numbers.data(), numbers.size(), "e", n));
+    CHECK(!json_uint_member(numbers.data(), numbers.size(), "f", n));
+
+    for (const char* valid : {"{}", " {\"a\":[1,-0.5e+3,true,false,null,{\"b\":\"\\u00e9\\n\"}],\"c\":{}} ",
+                              "{\"id\":\"x\",\"s\":\"\\\"\\\\\\/\\b\\f\\r\\t\"}"}) {
+        CHECK(valid_json_object(valid, std::strlen(valid)));
+    }
+    for (const char* invalid : {"", "[]", "\"x\"", "{\"id\":\"x0\" garbage", "{\"id\":\"x0\"} garbage", "{\"a\":01}",
+                                "{\"a\":1,}", "{\"a\":.5}", "{\"a\":tru}", "{\"a\":\"\\x\"}", "{\"a\":\"\\u12\"}",
+                                "{\"a\" 1}", "{a:1}", "{\"a\":[1 2]}", "{\"a\":\"\t\"}"}) {
+        CHECK(!valid_json_object(invalid, std::strlen(invalid)));
+    }
+    const std::string deep = std::string(40, '[');
+    CHECK(!valid_json_object(("{\"a\":" + deep + std::string(40, ']') + "}").c_str(), deep.size() * 2 + 6));
+
+    CHECK(valid_request_id("0f8fad5b-d9cb-469f-a165-70867728950e", 36));
+    CHECK(valid_request_id("req_1.a:b", 9));
+    CHECK(!valid_request_id("", 0));
+    CHECK(!valid_request_id("a/b", 3));
+    CHECK(!valid_request_id("a b", 3));
+    CHECK(!valid_request_id(std::string(kMaxIdBytes + 1, 'a').c_str(), kMaxIdBytes + 1));
+}
+
+static void test_queue() {
+    RequestQueue queue(2);
+    char out[512];
+    std::string body;
+    CHECK(!queue.next(0, body));
+
+    CHECK(queue.add("a", 1, "{\"id\":\"a\"}", 10) == AddResult::Added);
+    CHECK(queue.add("b", 1, "{\"id\":\"b\"}", 10) == AddResult::Added);
+    CHECK(queue.add("a", 1, "{}", 2) == AddResult::Duplicate);
+    // Both slots pending: nothing to evict.
+    CHECK(queue.add("c", 1, "{}", 2) == AddResult::Full);
+    CHECK_EQ(queue.pending(), 2u);
+
+    // Handed out once each, oldest first.
+    CHECK(queue.next(0, body) && body == "{\"id\":\"a\"}");
+    CHECK(queue.next(0, body) && body == "{\"id\":\"b\"}");
+    CHECK(!queue.next(0, body));
+    CHECK_EQ(queue.pending_bodies().size(), 2u);
+
+    std::string status(out, queue.write_status("a", 1, out, sizeof(out)));
+    CHECK(status == "{\"requestId\":\"a\",\"status\":\"pending\"}");
+    status.assign(out, queue.write_status("zz", 2, out, sizeof(out)));
+    CHECK(status == "{\"requestId\":\"zz\",\"status\":\"not_found\"}");
+
+    CHECK(queue.mark_signed("a", "5sig", "7key", "ML-DSA-87", 1760000000456));
+    CHECK(!queue.mark_signed("a", "5sig", "7key", "ML-DSA-87", 1));
+    CHECK(!queue.mark_rejected("nope", "x"));
+    status.assign(out, queue.write_status("a", 1, out, sizeof(out)));
+    CHECK(status == "{\"requestId\":\"a\",\"status\":\"signed\",\"signature\":\"5sig\",\"signerKeyHash\":\"7key\","
+                    "\"algorithm\":\"ML-DSA-87\",\"timestamp\":1760000000456}");
+    CHECK_EQ(queue.write_status("a", 1, out, 20), 0u);
+    CHECK(queue.mark_rejected("b", "User \"rejected\""));
+    status.assign(out, queue.write_status("b", 1, out, sizeof(out)));
+    CHECK(status == "{\"requestId\":\"b\",\"status\":\"rejected\",\"reason\":\"User \\\"rejected\\\"\"}");
+    CHECK_EQ(queue.pending(), 0u);
+    CHECK(queue.pending_bodies().empty());
+
+    // The decision made longest ago goes first.
+    CHECK(queue.add("c", 1, "{}", 2) == AddResult::Added);
+    status.assign(out, queue.write_status("a", 1, out, sizeof(out)));
+    CHECK(status.find("not_found") != std::string::npos);
+    status.assign(out, queue.write_status("b", 1, out, sizeof(out)));
+    CHECK(status.find("rejected") != std::string::npos);
+
+    std::string json;
+    queue.append_json(json);
+    CHECK(json.find("\"capacity\":2,\"pending\":1,\"max_pending\":2,\"accepted\":3,\"duplicate\":1,\"full\":1,"
+                    "\"signed\":1,\"rejected\":1") != std::string::npos);
+
+    // close() wakes a waiting consumer.
+    CHECK(queue.next(0, body) && body == "{}");
+    std::thread closer([&queue] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        queue.close();
+    });
+    CHECK(!queue.next(10000, body));
+    closer.join();
+}
+
+static void test_server_keep_alive() {
+    ServerConfig config;
+    config.port = 0;
+    config.loopback_only = true;
+    Server server(config);
+    CHECK(server.start());
+    CHECK(!server.start());
+    CHECK(server.running());
+    CHECK(server.port() != 0);
+
+    const int fd = connect_to(server.port());
+    std::string pending;
+    // Pipelined on one connection.
+    send_all(fd, "GET /health HTTP/1.1\r\n\r\n" + post("/sign", sign_body("req-1")) +
+                     "GET /status/req-1 HTTP/1.1\r\n\r\n");
+    Response health = read_response(fd, pending);
+    CHECK_EQ(health.code, 200);
+    CHECK(!health.close);
+    CHECK(health.body.find("\"status\":\"ok\"") != std::string::npos);
+    CHECK(health.body.find("\"pendingRequests\":0") != std::string::npos);
+    Response sign = read_response(fd, pending);
+    CHECK_EQ(sign.code, 200);
+    CHECK(sign.body == "{\"success\":true,\"requestId\":\"req-1\",\"message\":\"Request added. Waiting for user "
+                       "approval.\"}");
+    CHECK(read_response(fd, pending).body.find("\"status\":\"pending\"") != std::string::npos);
+
+    std::string body;
+    CHECK(server.queue().next(1000, body));
+    CHECK(body == sign_body("req-1"));
+
+    // A response larger than the socket buffers, sent in pieces.
+    const std::string signature(9254, 'f');
+    CHECK(server.queue().mark_signed("req-1", signature, "key", "ML-DSA-87", 5));
+    send_all(fd, "GET /status/req-1 HTTP/1.1\r\n\r\n");
+    Response status = read_response(fd, pending);
+    CHECK_EQ(status.code, 200);
+    CHECK(status.body.find("\"signature\":\"" + signature + "\"") != std::string::npos);
+
+    // Errors, then an explicit close.
+    send_all(fd, post("/sign", "{\"operation\":\"deploy\"}") + post("/sign", "{\"id\":\"x0\" garbage") +
+                     "GET /status/req-9 HTTP/1.1\r\n\r\n" + "GET /nope HTTP/1.1\r\n\r\n" +
+                     "GET /status/a%2Fb HTTP/1.1\r\n\r\n" + "GET /status/a\"b\\\x01 HTTP/1.1\r\n\r\n" +
+                     "GET /health HTTP/1.1\r\nConnection: close\r\n\r\n");
+    CHECK_EQ(read_response(fd, pending).code, 400);
+    // Not JSON, though the id can be picked out of it: never queued.
+    Response junk = read_response(fd, pending);
+    CHECK_EQ(junk.code, 400);
+    CHECK(junk.body.find("Invalid JSON") != std::string::npos);
+    CHECK(read_response(fd, pending).body == "{\"requestId\":\"req-9\",\"status\":\"not_found\"}");
+    CHECK_EQ(read_response(fd, pending).code, 404);
+    // An id /sign would refuse is still just not found, escaped.
+    Response invalid = read_response(fd, pending);
+    CHECK_EQ(invalid.code, 200);
+    CHECK(invalid.body == "{\"requestId\":\"a%2Fb\",\"status\":\"not_found\"}");
+    invalid = read_response(fd, pending);
+    CHECK_EQ(invalid.code, 200);
+    CHECK(invalid.body == "{\"requestId\":\"a\\\"b\\\\\\u0001\",\"status\":\"not_found\"}");
+    Response last = read_response(fd, pending);
+    CHECK_EQ(last.code, 200);
+    CHECK(last.close);
+    CHECK_EQ(read_response(fd, pending).code, 0);
+    ::close(fd);
+
+    // A malformed request is answered and the connection closed.
+    const int bad = connect_to(server.port());
+    send_all(bad, "GET / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n");
+    pending.clear();
+    Response rejected = read_response(bad, pending);
+    CHECK_EQ(rejected.code, 400);
+    CHECK(rejected.close);
+    CHECK_EQ(read_response(bad, pending).code, 0);
+    ::close(bad);
+
+    const std::string json = server.status_json();
+    CHECK(json.find("\"running\":true") != std::string::npos);
+    CHECK(json.find("\"accepted\":2,\"refused\":0") != std::string::npos);
+    CHECK(json.find("\"requests\":11,\"keep_alive_reuses\":10,\"health\":2,\"sign\":3,\"status\":5,\"not_found\":1,"
+                    "\"bad_request\":1") != std::string::npos);
+    CHECK(json.find("\"signed\":1") != std::string::npos);
+
+    server.stop();
+    CHECK(!server.running());
+    CHECK(!server.queue().next(0, body));
+}
+
+static void test_server_half_close() {
+    ServerConfig config;
+    config.port = 0;
+    config.loopback_only = true;
+    Server server(config);
+    CHECK(server.start());
+    std::string body;
+    const int sign = connect_to(server.port());
+    std::string pending;
+    send_all(sign, post("/sign", sign_body("req-h")));
+    CHECK_EQ(read_response(sign, pending).code, 200);
+    ::close(sign);
+    CHECK(server.queue().next(1000, body));
+    CHECK(server.queue().mark_signed("req-h", std::string(9254, 'f'), "key", "ML-DSA-87", 5));
+
+    // The CLI's side ends with the last request; the answers (a few MB,
+    // well past the socket buffers) are still owed and must all arrive.
+    const int kRequests = 400;
+    std::string requests;
+    for (int i = 0; i < kRequests; ++i) {
+        requests += "GET /status/req-h HTTP/1.1\r\n\r\n";
+    }
+    const int fd = connect_to(server.port(), 4096);
+#if defined(TCP_CORK)
+    // Hold the requests back so they reach the server together with the
+    // FIN: it then sees the end of input while its output is backed up.
+    const int cork = 1;
+    CHECK(::setsockopt(fd, IPPROTO_TCP, TCP_CORK, &cork, sizeof(cork)) == 0);
+#endif
+    send_all(fd, requests);
+    CHECK(::shutdown(fd, SHUT_WR) == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    pending.clear();
+    for (int i = 0; i < kRequests; ++i) {
+        const Response status = read_response(fd, pending);
+        CHECK_EQ(status.code, 200);
+        CHECK(status.body.find("\"status\":\"signed\"") != std::string::npos);
+    }
+    CHECK_EQ(read_response(fd, pending).code, 0);
+    ::close(fd);
+    server.stop();
+}
+
+static void test_c_api() {
+    const long server = estream_signing_server_start(0, 4);
+    CHECK(server > 0);
+    CHECK_EQ(estream_signing_server_start(70000, 0), -1);
+
+    char* status = estream_signing_server_status_json(server);
+    CHECK(status != nullptr);
+    const std::string json(status);
+    estream_app_free_string(status);
+    const size_t port_at = json.find("\"port\":");
+    CHECK(port_at != std::string::npos);
+    const uint16_t port = static_cast<uint16_t>(std::atoi(json.c_str() + port_at + 7));
+    CHECK(json.find("\"capacity\":4") != std::string::npos);
+
+    CHECK(estream_signing_server_next_request(server, 0) == nullptr);
+    const int fd = connect_to(port);
+    std::string pending;
+    send_all(fd, post("/sign", sign_body("cli-7")));
+    CHECK_EQ(read_response(fd, pending).code, 200);
+    char* next = estream_signing_server_next_request(server, 1000);
+    CHECK(next != nullptr && std::string(next) == sign_body("cli-7"));
+    estream_app_free_string(next);
+
+    char* list = estream_signing_server_pending_json(server);
+    CHECK(list != nullptr);
+    CHECK(std::string(list) == "{\"success\":true,\"data\":[\"{\\\"id\\\":\\\"cli-7\\\",\\\"operation\\\":"
+                               "\\\"deploy\\\",\\\"payload\\\":\\\"3yZe7d\\\"}\"]}");
+    estream_app_free_string(list);
+
+    CHECK_EQ(estream_signing_server_mark_rejected(server, "cli-7", "User rejected"), 0);
+    CHECK_EQ(estream_signing_server_mark_rejected(server, "cli-7", "again"), -1);
+    CHECK_EQ(estream_signing_server_mark_signed(server, "cli-7", "s", "k", "ML-DSA-87", 1), -1);
+    CHECK_EQ(estream_signing_server_mark_signed(server, nullptr, "s", "k", "ML-DSA-87", 1), -1);
+    send_all(fd, "GET /status/cli-7 HTTP/1.1\r\n\r\n");
+    CHECK(read_response(fd, pending).body ==
+          "{\"requestId\":\"cli-7\",\"status\":\"rejected\",\"reason\":\"User rejected\"}");
+
+    // A consumer blocked in next_request wakes on stop.
+    std::thread consumer([server] { CHECK(estream_signing_server_next_request(server, 10000) == nullptr); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    estream_signing_server_stop(server);
+    consumer.join();
+    CHECK_EQ(read_response(fd, pending).code, 0);
+    ::close(fd);
+    CHECK(estream_signing_server_status_json(server) == nullptr);
+    CHECK_EQ(estream_signing_server_mark_rejected(server, "cli-7", "x"), -1);
+    estream_signing_server_stop(server);
+}
+
+static void test_queue_expiry() {
+    RequestQueue queue(2, 50);
+    char out[512];
+    std::string body;
+    CHECK(queue.add("a", 1, "{}", 2) == AddResult::Added);
+    CHECK(queue.add("b", 1, "{}", 2) == AddResult::Added);
+    CHECK(queue.add("c", 1, "{}", 2) == AddResult::Full);
+    CHECK(queue.next(0, body));
+
+    // Nobody decided a or b: once they expire the queue takes requests again.
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    CHECK(queue.add("c", 1, "{}", 2) == AddResult::Added);
+    CHECK_EQ(queue.pending(), 1u);
+    // a expired first, so its slot went to c; b keeps its answer.
+    std::string status(out, queue.write_status("b", 1, out, sizeof(out)));
+    CHECK(status == "{\"requestId\":\"b\",\"status\":\"expired\"}");
+    status.assign(out, queue.write_status("a", 1, out, sizeof(out)));
+    CHECK(status.find("not_found") != std::string::npos);
+    CHECK(!queue.mark_signed("b", "5sig", "7key", "ML-DSA-87", 1));
+    CHECK(!queue.mark_rejected("b", "late"));
+    // b was never handed out, and is not now; c is.
+    CHECK(queue.next(0, body) && body == "{}");
+    CHECK(!queue.next(0, body));
+
+    // An expiresAt already past expires the request at once; one far ahead
+    // does not outlive the TTL.
+    RequestQueue dated(2);
+    const std::string past = "{\"id\":\"d\",\"expiresAt\":1}";
+    CHECK(dated.add("d", 1, past.data(), past.size()) == AddResult::Added);
+    CHECK(!dated.next(0, body));
+    status.assign(out, dated.write_status("d", 1, out, sizeof(out)));
+    CHECK(status.find("\"expired\"") != std::string::npos);
+    const std::string future = "{\"id\":\"e\",\"expiresAt\":18446744073709551615}";
+    CHECK(dated.add("e", 1, future.data(), future.size()) == AddResult::Added);
+    CHECK(dated.next(0, body) && body == future);
+
+    std::string json;
+    queue.append_json(json);
+    CHECK(json.find("\"rejected\":0,\"expired\":2") != std::string::npos);
+}
+
+int main() {
+    test_parse_request();
+    test_json_string_member();
+    test_queue();
+    test_queue_expiry();
+    test_server_keep_alive();
+    test_server_half_close();
+    test_c_api();
+    std::puts("signing_server_test: OK");
+    return 0;
+}
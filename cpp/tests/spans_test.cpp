@@ -0,0 +1,97 @@
+#include "check.h"
+#include "spans.h"
+
+#include "estream_app_native.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace estream;
+
+namespace {
+
+struct Recorded {
+    uint64_t id;
+    uint64_t parent;
+    std::string name;
+    EstreamSpanPhase phase;
+    int failed;
+};
+
+void on_span(void* ctx, const EstreamSpanEvent* ev) {
+    auto* events = static_cast<std::vector<Recorded>*>(ctx);
+    events->push_back({ev->span_id, ev->parent_id, ev->name, ev->phase, ev->failed});
+}
+
+}  // namespace
+
+static void test_no_callback_emits_nothing() {
+    estream_set_trace_callback(nullptr, nullptr);
+    Span span("connect");
+    CHECK_EQ(spans::current(), 0u);
+}
+
+static void test_nested_spans() {
+    std::vector<Recorded> events;
+    estream_set_trace_callback(on_span, &events);
+    {
+        Span outer("connect");
+        {
+            Span inner("handshake");
+            inner.check(static_cast<char*>(nullptr));
+        }
+    }
+    estream_set_trace_callback(nullptr, nullptr);
+
+    CHECK_EQ(events.size(), 4u);
+    CHECK_EQ(events[0].name, "connect");
+    CHECK_EQ(events[0].phase, ESTREAM_SPAN_BEGIN);
+    CHECK_EQ(events[0].parent, 0u);
+    CHECK_EQ(events[1].name, "handshake");
+    CHECK_EQ(events[1].parent, events[0].id);
+    CHECK_EQ(events[2].phase, ESTREAM_SPAN_END);
+    CHECK_EQ(events[2].id, events[1].id);
+    CHECK_EQ(events[2].failed, 1);
+    CHECK_EQ(events[3].id, events[0].id);
+    CHECK_EQ(events[3].failed, 0);
+    CHECK_EQ(spans::current(), 0u);
+}
+
+static void test_error_results() {
+    std::vector<Recorded> events;
+    estream_set_trace_callback(on_span, &events);
+    char ok[] = "{\"success\":true,\"handle\":3}";
+    char error[] = "{\"error\":\"bad bundle\"}";
+    char refused[] = "{\"success\":false}";
+    for (char* result : {ok, error, refused}) {
+        Span span("x3dh_initiate");
+        CHECK(span.check(result) == result);
+    }
+    estream_set_trace_callback(nullptr, nullptr);
+
+    CHECK_EQ(events.size(), 6u);
+    CHECK_EQ(events[1].failed, 0);
+    CHECK_EQ(events[3].failed, 1);
+    CHECK_EQ(events[5].failed, 1);
+}
+
+static void test_callback_removed_mid_span() {
+    std::vector<Recorded> events;
+    estream_set_trace_callback(on_span, &events);
+    {
+        Span span("ratchet_encrypt");
+        estream_set_trace_callback(nullptr, nullptr);
+    }
+    CHECK_EQ(events.size(), 1u);
+    CHECK_EQ(spans::current(), 0u);
+}
+
+int main() {
+    test_no_callback_emits_nothing();
+    test_nested_spans();
+    test_error_results();
+    test_callback_removed_mid_span();
+    std::puts("spans_test: OK");
+    return 0;
+}
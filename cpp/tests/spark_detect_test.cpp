@@ -0,0 +1,265 @@
+#include "check.h"
+#include "fixtures.h"
+#include "spark_detect.h"
+
+#include "estream_app_native.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace estream;
+using test::Image;
+using test::Rng;
+
+namespace {
+
+// Flood fill over 8-neighbours: the components detect() must find.
+size_t reference_components(const Image& image, uint8_t threshold) {
+    std::vector<uint8_t> seen(static_cast<size_t>(image.width) * image.height, 0);
+    std::vector<int> stack;
+    size_t count = 0;
+    for (int y = 0; y < image.height; ++y) {
+        for (int x = 0; x < image.width; ++x) {
+            const size_t i = static_cast<size_t>(y) * image.width + x;
+            if (seen[i] || image.pixels[static_cast<size_t>(y) * image.stride + x] <= threshold) {
+                continue;
+            }
+            ++count;
+            seen[i] = 1;
+            stack.assign(1, static_cast<int>(i));
+            while (!stack.empty()) {
+                const int cx = stack.back() % image.width;
+                const int cy = stack.back() / image.width;
+                stack.pop_back();
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        const int nx = cx + dx;
+                        const int ny = cy + dy;
+                        if (nx < 0 || ny < 0 || nx >= image.width || ny >= image.height) {
+                            continue;
+                        }
+                        const size_t n = static_cast<size_t>(ny) * image.width + nx;
+                        if (!seen[n] && image.pixels[static_cast<size_t>(ny) * image.stride + nx] > threshold) {
+                            seen[n] = 1;
+                            stack.push_back(static_cast<int>(n));
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return count;
+}
+
+}  // namespace
+
+static void test_threshold_mask_matches_scalar() {
+    Rng rng;
+    uint8_t block[16];
+    for (int round = 0; round < 1000; ++round) {
+        for (uint8_t& b : block) {
+            b = static_cast<uint8_t>(rng.next());
+        }
+        const uint8_t threshold = static_cast<uint8_t>(rng.next());
+        uint32_t expected = 0;
+        for (int i = 0; i < 16; ++i) {
+            expected |= static_cast<uint32_t>(block[i] > threshold) << i;
+        }
+        CHECK_EQ(spark::threshold_mask16(block, threshold), expected);
+    }
+    const uint8_t bright[16] = {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255};
+    CHECK_EQ(spark::threshold_mask16(bright, 255), 0u);
+    CHECK_EQ(spark::threshold_mask16(bright, 254), 0xFFFFu);
+}
+
+static void test_centroids_and_order() {
+    // Row padding and a width that is not a multiple of 16.
+    Image image(203, 101, 13);
+    // A 5x5 square centred on (20, 30), uniformly bright.
+    for (int y = 28; y <= 32; ++y) {
+        for (int x = 18; x <= 22; ++x) {
+            image.at(x, y) = 200;
+        }
+    }
+    // A brighter 3x3 block in the last partial 16-byte chunk, weighted
+    // towards its right column.
+    for (int y = 70; y <= 72; ++y) {
+        image.at(198, y) = 180;
+        image.at(199, y) = 180;
+        image.at(200, y) = 250;
+    }
+
+    spark::Detector detector;
+    spark::Particle found[4];
+    CHECK_EQ(detector.detect(image.plane(), found, 4), 2u);
+    CHECK(found[0].brightness == 250.0f / 255.0f);
+    CHECK_EQ(found[0].area, 9u);
+    // Weights 10, 10, 80 on x = 198, 199, 200.
+    const double cx = (198.0 * 10 + 199.0 * 10 + 200.0 * 80) / 100.0;
+    CHECK(std::fabs(found[0].x * 203.0 - (cx + 0.5)) < 1e-3);
+    CHECK(std::fabs(found[0].y * 101.0 - 71.5) < 1e-3);
+    CHECK_EQ(found[1].area, 25u);
+    CHECK(std::fabs(found[1].x * 203.0 - 20.5) < 1e-3);
+    CHECK(std::fabs(found[1].y * 101.0 - 30.5) < 1e-3);
+
+    // Capacity limits the output, not the search.
+    CHECK_EQ(detector.detect(image.plane(), found, 1), 1u);
+    CHECK(found[0].brightness == 250.0f / 255.0f);
+    CHECK_EQ(detector.last_components(), 2u);
+}
+
+static void test_components_join_diagonally_and_late() {
+    // A U shape: the two arms are separate runs until the bottom row joins
+    // them, and a diagonal step only touches at a corner.
+    Image image(64, 16);
+    for (int y = 2; y <= 8; ++y) {
+        image.at(10, y) = 220;
+        image.at(20, y) = 220;
+    }
+    for (int x = 10; x <= 20; ++x) {
+        image.at(x, 9) = 220;
+    }
+    image.at(40, 4) = 220;
+    image.at(41, 5) = 220;
+    image.at(42, 6) = 220;
+
+    spark::Detector detector;
+    spark::Particle found[4];
+    CHECK_EQ(detector.detect(image.plane(), found, 4), 2u);
+    CHECK_EQ(found[0].area, 7u * 2u + 11u);
+    CHECK_EQ(found[1].area, 3u);
+
+    spark::Options options;
+    options.min_area = 4;
+    spark::Detector filtered(options);
+    CHECK_EQ(filtered.detect(image.plane(), found, 4), 1u);
+    CHECK_EQ(found[0].area, 25u);
+}
+
+static void test_random_frames_match_flood_fill() {
+    Rng rng;
+    spark::Detector detector;
+    std::vector<spark::Particle> found(4096);
+    for (int round = 0; round < 20; ++round) {
+        Image image(17 + static_cast<int>(rng.next() % 120), 5 + static_cast<int>(rng.next() % 60),
+                    static_cast<int>(rng.next() % 8));
+        for (uint8_t& p : image.pixels) {
+            p = static_cast<uint8_t>(rng.next() % 4 == 0 ? 171 + rng.next() % 85 : rng.next() % 171);
+        }
+        const size_t expected = reference_components(image, spark::kBrightnessThreshold);
+        CHECK_EQ(detector.detect(image.plane(), found.data(), found.size()), expected);
+        CHECK_EQ(detector.last_components(), expected);
+        for (size_t i = 1; i < expected; ++i) {
+            CHECK(found[i - 1].brightness >= found[i].brightness);
+        }
+    }
+}
+
+static void test_downsample_keeps_peaks() {
+    Rng rng;
+    for (int round = 0; round < 40; ++round) {
+        const int factor = 1 << (round % 3);
+        const int pixel_stride = round % 4 == 3 ? 2 : 1;
+        const int width = 8 + static_cast<int>(rng.next() % 200);
+        const int height = 4 + static_cast<int>(rng.next() % 40);
+        const int row_stride = width * pixel_stride + static_cast<int>(rng.next() % 8);
+        std::vector<uint8_t> pixels(static_cast<size_t>(row_stride) * height);
+        for (uint8_t& p : pixels) {
+            p = static_cast<uint8_t>(rng.next());
+        }
+        spark::Plane src;
+        src.data = pixels.data();
+        src.width = width;
+        src.height = height;
+        src.row_stride = row_stride;
+        src.pixel_stride = pixel_stride;
+
+        const int out_width = width / factor;
+        const int out_height = height / factor;
+        const int out_stride = out_width + 3;
+        std::vector<uint8_t> out(static_cast<size_t>(out_stride) * out_height, 0);
+        spark::downsample_max(src, factor, out.data(), out_stride);
+        for (int y = 0; y < out_height; ++y) {
+            for (int x = 0; x < out_width; ++x) {
+                uint8_t peak = 0;
+                for (int dy = 0; dy < factor; ++dy) {
+                    for (int dx = 0; dx < factor; ++dx) {
+                        const size_t i = static_cast<size_t>(y * factor + dy) * row_stride +
+                                         static_cast<size_t>(x * factor + dx) * pixel_stride;
+                        peak = std::max(peak, pixels[i]);
+                    }
+                }
+                CHECK_EQ(out[static_cast<size_t>(y) * out_stride + x], peak);
+            }
+        }
+    }
+
+    // A one-pixel particle survives 4x and lands in the same place.
+    Image image(256, 128);
+    image.at(101, 66) = 230;
+    std::vector<uint8_t> small(64 * 32);
+    spark::downsample_max(image.plane(), 4, small.data(), 64);
+    spark::Plane plane;
+    plane.data = small.data();
+    plane.width = 64;
+    plane.height = 32;
+    plane.row_stride = 64;
+    spark::Detector detector;
+    spark::Particle found[2];
+    CHECK_EQ(detector.detect(plane, found, 2), 1u);
+    CHECK(std::fabs(found[0].x - 101.0f / 256.0f) < 4.0f / 256.0f);
+    CHECK(std::fabs(found[0].y - 66.0f / 128.0f) < 4.0f / 128.0f);
+}
+
+static void test_c_api_and_pixel_stride() {
+    // Interleaved plane (pixel stride 2) with a dark second channel.
+    const int width = 48;
+    const int height = 32;
+    std::vector<uint8_t> plane(static_cast<size_t>(width) * 2 * height, 0);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            plane[static_cast<size_t>(y) * width * 2 + x * 2] = 60;
+        }
+    }
+    plane[static_cast<size_t>(10) * width * 2 + 30 * 2] = 230;
+    for (int y = 13; y <= 19; ++y) {
+        for (int x = 21; x <= 27; ++x) {
+            plane[static_cast<size_t>(y) * width * 2 + x * 2] = 140;
+        }
+    }
+
+    CHECK_EQ(estream_spark_detector_create(256, 0), -1);
+    const long detector = estream_spark_detector_create(0, 0);
+    CHECK(detector > 0);
+    EstreamSparkParticle out[4];
+    CHECK_EQ(estream_spark_detect(detector, plane.data(), width, height, width * 2, 2, out, 4), 1);
+    CHECK(std::fabs(out[0].x * width - 30.5f) < 1e-3f);
+    CHECK(std::fabs(out[0].y * height - 10.5f) < 1e-3f);
+    CHECK_EQ(out[0].area, 1u);
+    CHECK_EQ(estream_spark_detect(detector, plane.data(), width, height, width, 2, out, 4), -1);
+
+    // The 7x7 block covers the radius-15 samples near the centre only.
+    const float center = estream_spark_center_brightness(plane.data(), width, height, width * 2, 2);
+    CHECK(center > 60.0f / 255.0f && center < 140.0f / 255.0f);
+
+    const long dim = estream_spark_detector_create(100, 0);
+    CHECK_EQ(estream_spark_detect(dim, plane.data(), width, height, width * 2, 2, out, 4), 2);
+    CHECK_EQ(out[1].area, 49u);
+    estream_spark_detector_destroy(dim);
+    estream_spark_detector_destroy(detector);
+    CHECK_EQ(estream_spark_detect(detector, plane.data(), width, height, width * 2, 2, out, 4), -1);
+}
+
+int main() {
+    test_threshold_mask_matches_scalar();
+    test_centroids_and_order();
+    test_components_join_diagonally_and_late();
+    test_random_frames_match_flood_fill();
+    test_downsample_keeps_peaks();
+    test_c_api_and_pixel_stride();
+    std::puts("spark_detect_test: OK");
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include "check.h"
+#include "fixtures.h"
+#include "spark_engine.h"
+#include "spsc_queue.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace estream;
+using test::Frame;
+using test::orbit_frame;
+
+namespace {
+
+spark::FrameResult frame_with(std::vector<std::pair<float, float>> xy) {
+    spark::FrameResult frame{};
+    for (const auto& p : xy) {
+        frame.particles[frame.count].x = p.first;
+        frame.particles[frame.count].y = p.second;
+        ++frame.count;
+    }
+    return frame;
+}
+
+}  // namespace
+
+static void test_queue_wraps_and_fills() {
+    SpscQueue<int, 4> queue;
+    CHECK(queue.front() == nullptr);
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 4; ++i) {
+            int* slot = queue.acquire();
+            CHECK(slot != nullptr);
+            *slot = round * 10 + i;
+            queue.commit();
+        }
+        CHECK(queue.acquire() == nullptr);
+        CHECK_EQ(queue.size(), 4u);
+        for (int i = 0; i < 4; ++i) {
+            CHECK_EQ(*queue.front(), round * 10 + i);
+            queue.pop();
+        }
+        CHECK(queue.front() == nullptr);
+    }
+}
+
+static void test_queue_across_threads() {
+    // Every value arrives once and in order.
+    SpscQueue<uint64_t, 16> queue;
+    const uint64_t count = 200000;
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < count;) {
+            if (uint64_t* slot = queue.acquire()) {
+                *slot = i++;
+                queue.commit();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint64_t expected = 0;
+    while (expected < count) {
+        if (const uint64_t* value = queue.front()) {
+            CHECK_EQ(*value, expected);
+            ++expected;
+            queue.pop();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    CHECK(queue.front() == nullptr);
+}
+
+static void test_motion_votes_over_window() {
+    spark::MotionConfig config;
+    config.window = 20;
+    spark::MotionTracker tracker(config);
+    // Turning by +0.05 rad per frame around the center: 2 particles vote
+    // clockwise (in image coordinates) each frame after the first.
+    for (int i = 0; i < 14; ++i) {
+        const float a = 0.05f * i;
+        tracker.add(frame_with({{0.5f + 0.3f * std::cos(a), 0.5f + 0.3f * std::sin(a)},
+                                {0.5f - 0.3f * std::cos(a), 0.5f - 0.3f * std::sin(a)}}));
+    }
+    CHECK(tracker.direction() == spark::Motion::Insufficient);
+    CHECK(tracker.score() == 0.0);
+    CHECK_EQ(tracker.clockwise(), 26u);
+    for (int i = 14; i < 20; ++i) {
+        const float a = 0.05f * i;
+        tracker.add(frame_with({{0.5f + 0.3f * std::cos(a), 0.5f + 0.3f * std::sin(a)},
+                                {0.5f - 0.3f * std::cos(a), 0.5f - 0.3f * std::sin(a)}}));
+    }
+    CHECK(tracker.direction() == spark::Motion::Clockwise);
+    CHECK(tracker.score() == 1.0);
+    CHECK(tracker.detected());
+
+    // Twenty still frames push the turning ones out of the window.
+    for (int i = 0; i < 20; ++i) {
+        tracker.add(frame_with({{0.8f, 0.5f}, {0.2f, 0.5f}}));
+    }
+    CHECK_EQ(tracker.frames(), 20u);
+    CHECK_EQ(tracker.clockwise(), 0u);
+    CHECK(tracker.direction() == spark::Motion::NoMotion);
+    CHECK(!tracker.detected());
+}
+
+static void test_engine_scan_and_reset() {
+    spark::ScanEngine engine;
+    for (int i = 0; i < 30; ++i) {
+        const Frame frame = orbit_frame(-0.04 * i);
+        CHECK(engine.submit(frame.plane(), i * 33.0));
+    }
+    CHECK_EQ(engine.poll(), 30u);
+    CHECK_EQ(engine.frames(), 30u);
+    CHECK_EQ(engine.last_frame().count, 4u);
+    CHECK(engine.motion().direction() == spark::Motion::CounterClockwise);
+    CHECK(engine.motion().detected());
+    CHECK(std::fabs(engine.duration_ms() - 29 * 33.0) < 1e-9);
+
+    // A consumer that stops polling costs frames, not memory.
+    const Frame still = orbit_frame(0.0);
+    for (size_t i = 0; i < spark::kFrameQueueSize + 5; ++i) {
+        engine.submit(still.plane(), 1000.0 + i);
+    }
+    CHECK_EQ(engine.dropped(), 5u);
+    CHECK_EQ(engine.submitted(), 30u + spark::kFrameQueueSize + 5);
+
+    // Queued frames of the old scan are discarded.
+    engine.reset();
+    CHECK_EQ(engine.poll(), 0u);
+    CHECK_EQ(engine.frames(), 0u);
+    CHECK_EQ(engine.submitted(), 0u);
+    CHECK_EQ(engine.dropped(), 0u);
+    CHECK(engine.motion().direction() == spark::Motion::Insufficient);
+    CHECK(engine.submit(still.plane(), 0.0));
+    CHECK_EQ(engine.poll(), 1u);
+}
+
+static void test_engine_on_camera_thread() {
+    spark::ScanEngine engine;
+    const Frame frame = orbit_frame(0.3);
+    const int count = 2000;
+    std::thread camera([&] {
+        for (int i = 0; i < count; ++i) {
+            engine.submit(frame.plane(), i);
+        }
+    });
+    uint64_t consumed = 0;
+    while (consumed + engine.dropped() < static_cast<uint64_t>(count)) {
+        consumed += engine.poll();
+        std::this_thread::yield();
+    }
+    camera.join();
+    consumed += engine.poll();
+    CHECK_EQ(consumed + engine.dropped(), static_cast<uint64_t>(count));
+    CHECK_EQ(engine.frames(), consumed);
+    CHECK_EQ(engine.last_frame().count, 4u);
+}
+
+int main() {
+    test_queue_wraps_and_fills();
+    test_queue_across_threads();
+    test_motion_votes_over_window();
+    test_engine_scan_and_reset();
+    test_engine_on_camera_thread();
+    std::puts("spark_engine_test: OK");
+    return 0;
+}
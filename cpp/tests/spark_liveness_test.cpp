@@ -0,0 +1,294 @@
+#include "check.h"
+#include "fixtures.h"
+#include "spark_liveness.h"
+
+#include "estream_app_native.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace estream;
+using test::Rng;
+
+namespace {
+
+// Outputs of spark.ts (node) for the inputs below.
+const char* kHashEmpty = "00b9722be49d560fc8813af3ac651ed7904902bb742de69f5811ca833cf5ae67";
+const char* kHashAbc = "a6bfd8f10a233c556e87a0b9d2eb041d364f68819ab3cce5fe173049627b94ad";
+const char* kMotionKey =
+    "ef08213a536c859eb7d0e9021b344d667f98b1cae3fc152e47607992abc4ddf6"
+    "f009223b546d869fb8d1ea031c354e678099b2cbe4fd162f48617a93acc5def7";
+const int64_t kTimestamp = 1760000000000;
+
+std::string hex(const uint8_t* data, size_t len) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    for (size_t i = 0; i < len; ++i) {
+        out.push_back(digits[data[i] >> 4]);
+        out.push_back(digits[data[i] & 15]);
+    }
+    return out;
+}
+
+std::vector<uint8_t> test_pubkey() {
+    std::vector<uint8_t> pubkey(80);
+    for (size_t i = 0; i < pubkey.size(); ++i) {
+        pubkey[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    return pubkey;
+}
+
+// Positions of all particles at `ms`, each pushed off its orbit by up to
+// `noise` (normalized) in a random direction; `wrong` of them are moved
+// far away.
+std::vector<float> observe(const spark::ParticleParams* params, double ms, double noise, int wrong, Rng& rng) {
+    std::vector<float> xy;
+    for (int i = 0; i < spark::kParticleCount; ++i) {
+        double x = 0.0;
+        double y = 0.0;
+        spark::expected_position(params[i], ms, &x, &y);
+        const double angle = rng.unit() * 6.283185307179586;
+        const double r = i < wrong ? 0.3 : rng.unit() * noise;
+        xy.push_back(static_cast<float>(x + r * std::cos(angle)));
+        xy.push_back(static_cast<float>(y + r * std::sin(angle)));
+    }
+    return xy;
+}
+
+void derive_params(const std::vector<uint8_t>& pubkey, spark::ParticleParams* out) {
+    uint8_t key[spark::kMotionKeyBytes];
+    spark::derive_motion_key(pubkey.data(), pubkey.size(), kTimestamp, key);
+    for (int i = 0; i < spark::kParticleCount; ++i) {
+        out[i] = spark::particle_params(key, i);
+    }
+}
+
+}  // namespace
+
+static void test_derivation_matches_spark_ts() {
+    uint8_t hash[32];
+    spark::simple_hash256(nullptr, 0, hash);
+    CHECK_EQ(hex(hash, 32), std::string(kHashEmpty));
+    spark::simple_hash256(reinterpret_cast<const uint8_t*>("abc"), 3, hash);
+    CHECK_EQ(hex(hash, 32), std::string(kHashAbc));
+
+    const std::vector<uint8_t> pubkey = test_pubkey();
+    uint8_t key[spark::kMotionKeyBytes];
+    spark::derive_motion_key(pubkey.data(), pubkey.size(), kTimestamp, key);
+    CHECK_EQ(hex(key, sizeof(key)), std::string(kMotionKey));
+
+    const spark::ParticleParams p = spark::particle_params(key, 3);
+    CHECK(p.radius == 80.0);
+    CHECK(std::fabs(p.speed - 0.6984313725490197) < 1e-15);
+    CHECK(std::fabs(p.phase - 3.7452712419266554) < 1e-15);
+    CHECK(std::fabs(p.wobble - 0.23764705882352938) < 1e-15);
+    CHECK(p.direction == -1.0);
+    double x = 0.0;
+    double y = 0.0;
+    spark::expected_position(p, 1234.0, &x, &y);
+    CHECK(std::fabs(x - 0.24453869764529165) < 1e-12);
+    CHECK(std::fabs(y - 0.5641030355942065) < 1e-12);
+}
+
+static void test_derivation_c_api_matches_mission_control() {
+    // An ML-DSA-87 sized pubkey: (i * 7 + 42) % 256, as LatticeCodeScreen
+    // generates it.
+    std::vector<uint8_t> pubkey(2592);
+    for (size_t i = 0; i < pubkey.size(); ++i) {
+        pubkey[i] = static_cast<uint8_t>(i * 7 + 42);
+    }
+    const int64_t timestamp = 1760000000123;
+    uint8_t key[spark::kMotionKeyBytes];
+    CHECK_EQ(estream_spark_motion_key(pubkey.data(), static_cast<int>(pubkey.size()), timestamp, key), 0);
+    CHECK_EQ(hex(key, sizeof(key)), std::string("f50e274059728ba4bdd6ef08213a536c859eb7d0e9021b344d667f98b1cae3fc"
+                                                "f60f28415a738ca5bed7f009223b546d869fb8d1ea031c354e678099b2cbe4fd"));
+
+    double params[5 * spark::kParticleCount];
+    CHECK_EQ(estream_spark_particle_params(pubkey.data(), static_cast<int>(pubkey.size()), timestamp, params), 0);
+    const double* p7 = params + 7;
+    CHECK(p7[0] == 72.74509803921569);
+    CHECK(p7[12] == 0.5823529411764706);
+    CHECK(p7[24] == 2.833593373826088);
+    CHECK(p7[36] == 0.19411764705882353);
+    CHECK(p7[48] == -1.0);
+    const double* p11 = params + 11;
+    CHECK(p11[0] == 70.3921568627451);
+    CHECK(p11[12] == 0.5447058823529412);
+    CHECK(p11[24] == 2.537914065252931);
+    CHECK(p11[36] == 0.18);
+    CHECK(p11[48] == -1.0);
+
+    // sparkAuth.ts deriveMotionParams: deriveBytes("<nonce>:<timestamp>",
+    // "motion", 48).
+    const char* challenge = "a1b2c3d4e5f6:1760000000123";
+    uint8_t out[100];
+    CHECK_EQ(estream_spark_derive_bytes(reinterpret_cast<const uint8_t*>(challenge),
+                                        static_cast<int>(std::strlen(challenge)), "motion", out, 48),
+             0);
+    CHECK_EQ(hex(out, 48), std::string("deb79069421bf4cda67f58310ae3bc956e4720f9d2ab845d"
+                                       "360fe8c19a734c25dfb8916a431cf5cea78059320be4bd96"));
+    // Four blocks, the last one partial.
+    const uint8_t short_key[3] = {1, 2, 3};
+    CHECK_EQ(estream_spark_derive_bytes(short_key, 3, "x", out, 100), 0);
+    CHECK_EQ(hex(out, 100), std::string("7ed73089e23b94ed469ff851aa035cb50e67c01972cb247dd62f88e13a93ec45"
+                                        "7fd8318ae33c95ee47a0f952ab045db60f68c11a73cc257ed73089e23b94ed46"
+                                        "80d9328be43d96ef48a1fa53ac055eb71069c21b74cd267fd8318ae33c95ee47"
+                                        "81da338c"));
+    CHECK_EQ(estream_spark_derive_bytes(nullptr, 0, "", out, 5), 0);
+    CHECK_EQ(hex(out, 5), std::string("00d9b28b64"));
+    // info is hashed as UTF-8, like TextEncoder.
+    const uint8_t nine = 9;
+    CHECK_EQ(estream_spark_derive_bytes(&nine, 1, "spark-\xc3\xa9\xe2\x9c\x93", out, 32), 0);
+    CHECK_EQ(hex(out, 32), std::string("74cd267fd8318ae33c95ee47a0f952ab045db60f68c11a73cc257ed73089e23b"));
+
+    CHECK_EQ(estream_spark_derive_bytes(nullptr, 3, "x", out, 5), -1);
+    CHECK_EQ(estream_spark_derive_bytes(short_key, 3, nullptr, out, 5), -1);
+    CHECK_EQ(estream_spark_derive_bytes(short_key, 3, "x", nullptr, 5), -1);
+    CHECK_EQ(estream_spark_motion_key(nullptr, 0, timestamp, key), -1);
+    CHECK_EQ(estream_spark_particle_params(pubkey.data(), 10, timestamp, nullptr), -1);
+}
+
+static void test_live_scan_decides_at_minimum() {
+    const std::vector<uint8_t> pubkey = test_pubkey();
+    spark::ParticleParams params[spark::kParticleCount];
+    derive_params(pubkey, params);
+
+    spark::LivenessVerifier verifier(pubkey.data(), pubkey.size(), kTimestamp);
+    Rng rng;
+    const double start = 5000.0;
+    int frames = 0;
+    while (verifier.decision() == spark::Decision::Pending && frames < 400) {
+        const double ms = frames * 1000.0 / 30.0;
+        const std::vector<float> xy = observe(params, ms, 0.04, 0, rng);
+        verifier.add_frame(start + ms, xy.data(), spark::kParticleCount);
+        ++frames;
+    }
+    CHECK(verifier.decision() == spark::Decision::Live);
+    // 30 fps: the 2 s minimum is reached at frame 61.
+    CHECK_EQ(frames, 61);
+    CHECK(verifier.score() == 1.0);
+    CHECK(verifier.lower_bound() >= 0.8);
+
+    // Decided: later frames are ignored.
+    const std::vector<float> far(2 * spark::kParticleCount, 5.0f);
+    CHECK(verifier.add_frame(start + 9000.0, far.data(), spark::kParticleCount) == spark::Decision::Live);
+    CHECK_EQ(verifier.frames(), 61u);
+}
+
+static void test_wrong_key_is_rejected_early() {
+    std::vector<uint8_t> pubkey = test_pubkey();
+    spark::ParticleParams params[spark::kParticleCount];
+    derive_params(pubkey, params);
+    pubkey[0] ^= 1;  // A different pattern than the one observed.
+
+    spark::LivenessVerifier verifier(pubkey.data(), pubkey.size(), kTimestamp);
+    Rng rng;
+    int frames = 0;
+    while (verifier.decision() == spark::Decision::Pending && frames < 400) {
+        const std::vector<float> xy = observe(params, frames * 33.0, 0.02, 0, rng);
+        verifier.add_frame(frames * 33.0, xy.data(), spark::kParticleCount);
+        ++frames;
+    }
+    CHECK(verifier.decision() == spark::Decision::NotLive);
+    CHECK_EQ(frames, 10);
+}
+
+static void test_score_matches_batch_verify() {
+    // 2 of 12 particles are off in every frame: 83%, close to the
+    // threshold, so nothing is certain until the timeout.
+    const std::vector<uint8_t> pubkey = test_pubkey();
+    spark::ParticleParams params[spark::kParticleCount];
+    derive_params(pubkey, params);
+    spark::LivenessVerifier verifier(pubkey.data(), pubkey.size(), kTimestamp);
+    Rng rng;
+    uint64_t matches = 0;
+    uint64_t total = 0;
+    for (int frame = 0; frame < 90; ++frame) {
+        const double ms = frame * 33.0;
+        const std::vector<float> xy = observe(params, ms, 0.05, 2, rng);
+        verifier.add_frame(ms, xy.data(), xy.size() / 2);
+        // verifyLiveness, per observation.
+        for (int i = 0; i < spark::kParticleCount; ++i) {
+            double x = 0.0;
+            double y = 0.0;
+            spark::expected_position(params[i], ms, &x, &y);
+            const double d = std::sqrt(std::pow(xy[2 * i] - x, 2) + std::pow(xy[2 * i + 1] - y, 2));
+            matches += d < 0.1 ? 1 : 0;
+            ++total;
+        }
+    }
+    CHECK(verifier.decision() == spark::Decision::Pending);
+    CHECK_EQ(verifier.matches(), matches);
+    CHECK_EQ(verifier.observations(), total);
+    CHECK(verifier.finish() == spark::Decision::Live);
+}
+
+static void test_unordered_detector_output() {
+    const std::vector<uint8_t> pubkey = test_pubkey();
+    spark::ParticleParams params[spark::kParticleCount];
+    derive_params(pubkey, params);
+
+    spark::LivenessConfig config;
+    config.ordered = false;
+    spark::LivenessVerifier unordered(pubkey.data(), pubkey.size(), kTimestamp, config);
+    spark::LivenessVerifier ordered(pubkey.data(), pubkey.size(), kTimestamp);
+    Rng rng;
+    for (int frame = 0; frame < 61; ++frame) {
+        const double ms = frame * 1000.0 / 30.0;
+        std::vector<float> xy = observe(params, ms, 0.02, 0, rng);
+        // Reverse the order, as a brightness sort would scramble it, and
+        // drop two particles the detector missed.
+        std::vector<float> shuffled;
+        for (int i = spark::kParticleCount - 1; i >= 2; --i) {
+            shuffled.push_back(xy[2 * i]);
+            shuffled.push_back(xy[2 * i + 1]);
+        }
+        unordered.add_frame(ms, shuffled.data(), shuffled.size() / 2);
+        ordered.add_frame(ms, shuffled.data(), shuffled.size() / 2);
+    }
+    CHECK(unordered.decision() == spark::Decision::Live);
+    CHECK(ordered.decision() == spark::Decision::NotLive);
+}
+
+static void test_c_api() {
+    const std::vector<uint8_t> pubkey = test_pubkey();
+    spark::ParticleParams params[spark::kParticleCount];
+    derive_params(pubkey, params);
+
+    CHECK_EQ(estream_spark_verifier_create(nullptr, 0, kTimestamp, 1), -1);
+    const long verifier = estream_spark_verifier_create(pubkey.data(), static_cast<int>(pubkey.size()), kTimestamp, 1);
+    CHECK(verifier > 0);
+    Rng rng;
+    const std::vector<float> xy = observe(params, 0.0, 0.0, 0, rng);
+    CHECK_EQ(estream_spark_verifier_add_frame(verifier, 100.0, xy.data(), spark::kParticleCount),
+             ESTREAM_SPARK_PENDING);
+    CHECK_EQ(estream_spark_verifier_add_frame(verifier, 100.0, nullptr, 3), -1);
+
+    char* json = estream_spark_verifier_status(verifier);
+    CHECK(json != nullptr);
+    const std::string status(json);
+    estream_app_free_string(json);
+    CHECK(status.find("\"decision\":\"pending\",\"frames\":1,") != std::string::npos);
+    CHECK(status.find("\"matches\":12,\"observations\":12,") != std::string::npos);
+
+    // One frame is short of the minimums.
+    CHECK_EQ(estream_spark_verifier_finish(verifier), ESTREAM_SPARK_NOT_LIVE);
+    estream_spark_verifier_destroy(verifier);
+    CHECK(estream_spark_verifier_status(verifier) == nullptr);
+}
+
+int main() {
+    test_derivation_matches_spark_ts();
+    test_derivation_c_api_matches_mission_control();
+    test_live_scan_decides_at_minimum();
+    test_wrong_key_is_rejected_early();
+    test_score_matches_batch_verify();
+    test_unordered_detector_output();
+    test_c_api();
+    std::puts("spark_liveness_test: OK");
+    return 0;
+}
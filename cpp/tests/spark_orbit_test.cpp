@@ -0,0 +1,141 @@
+#include "check.h"
+#include "fixtures.h"
+#include "spark_liveness.h"
+#include "spark_orbit.h"
+
+#include "estream_app_native.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace estream;
+using test::Rng;
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+}  // namespace
+
+static void test_sincos_matches_libm() {
+    // Quadrant edges, then random values; an odd count exercises the
+    // scalar tail after the two-lane loop.
+    std::vector<double> v = {0.0, -0.0, kPi / 4, -kPi / 4, kPi / 2, kPi, 3 * kPi / 2, 2 * kPi, -kPi / 2, 1e-300};
+    for (int k = -40; k <= 40; ++k) {
+        v.push_back(k * kPi / 4);
+        v.push_back(k * kPi / 4 + 1e-9);
+    }
+    Rng rng;
+    for (int i = 0; i < 20001; ++i) {
+        const double scale = i % 3 == 0 ? 10.0 : (i % 3 == 1 ? 1e3 : 1e5);
+        v.push_back((rng.unit() * 2.0 - 1.0) * scale);
+    }
+    std::vector<double> s(v.size());
+    std::vector<double> c(v.size());
+    spark::sincos(v.data(), v.size(), s.data(), c.data());
+    double worst = 0.0;
+    for (size_t i = 0; i < v.size(); ++i) {
+        // An ulp or two of the result, plus the reduction's error at large
+        // arguments.
+        const double tolerance = 4e-16 * std::max(1.0, std::fabs(v[i]) * 1e-2);
+        const double err = std::max(std::fabs(s[i] - std::sin(v[i])), std::fabs(c[i] - std::cos(v[i])));
+        worst = std::max(worst, err / tolerance);
+        CHECK(err <= tolerance);
+    }
+    CHECK(worst <= 1.0);
+    CHECK(s[0] == 0.0 && c[0] == 1.0);
+}
+
+static void test_spark_orbits_match_expected_position() {
+    uint8_t key[spark::kMotionKeyBytes];
+    const uint8_t pubkey[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    spark::derive_motion_key(pubkey, sizeof(pubkey), 1760000000000, key);
+    const spark::Orbits orbits = spark::spark_orbits(key);
+    CHECK_EQ(orbits.size(), static_cast<size_t>(spark::kParticleCount));
+
+    // Ten seconds at 30 fps in one call.
+    std::vector<double> elapsed;
+    for (int f = 0; f < 300; ++f) {
+        elapsed.push_back(f * 33.333);
+    }
+    std::vector<double> x(elapsed.size() * orbits.size());
+    std::vector<double> y(x.size());
+    spark::orbit_positions(orbits, elapsed.data(), elapsed.size(), x.data(), y.data());
+    for (size_t f = 0; f < elapsed.size(); ++f) {
+        for (int i = 0; i < spark::kParticleCount; ++i) {
+            double ex = 0.0;
+            double ey = 0.0;
+            spark::expected_position(spark::particle_params(key, i), elapsed[f], &ex, &ey);
+            CHECK(std::fabs(x[f * orbits.size() + i] - ex) < 1e-14);
+            CHECK(std::fabs(y[f * orbits.size() + i] - ey) < 1e-14);
+        }
+    }
+}
+
+static void test_odd_count_and_per_particle_wobble() {
+    // Three particles in pixels, each with its own wobble rates.
+    spark::Orbits orbits;
+    orbits.center = 150.0;
+    orbits.add(100.0, 0.7, 0.1, 5.0, 1.1, 3.0, 0.9);
+    orbits.add(80.0, -1.3, 2.0, 0.0, 0.0, 0.0, 0.0);
+    orbits.add(60.0, 0.4, 4.0, 2.5, 3.3, 1.5, 2.7);
+    const double elapsed[2] = {0.0, 61234.5};
+    double x[6];
+    double y[6];
+    spark::orbit_positions(orbits, elapsed, 2, x, y);
+    for (int f = 0; f < 2; ++f) {
+        const double t = elapsed[f] / 1000.0;
+        for (size_t i = 0; i < 3; ++i) {
+            const double angle = orbits.phase[i] + t * orbits.speed[i];
+            const double ex = 150.0 + std::cos(angle) * orbits.radius[i] +
+                              std::sin(t * orbits.wobble_x_rate[i]) * orbits.wobble_x[i];
+            const double ey = 150.0 + std::sin(angle) * orbits.radius[i] +
+                              std::cos(t * orbits.wobble_y_rate[i]) * orbits.wobble_y[i];
+            CHECK(std::fabs(x[f * 3 + i] - ex) < 1e-11);
+            CHECK(std::fabs(y[f * 3 + i] - ey) < 1e-11);
+        }
+    }
+}
+
+static void test_c_api() {
+    spark::Orbits orbits;
+    orbits.center = 150.0;
+    orbits.extent = 300.0;
+    orbits.add(100.0, 0.7, 0.1, 5.0, 2.3, 5.0, 1.7);
+    orbits.add(80.0, -1.3, 2.0, 1.0, 2.3, 1.0, 1.7);
+    orbits.add(60.0, 0.4, 4.0, 2.5, 2.3, 2.5, 1.7);
+    const std::vector<std::vector<double>*> columns = {&orbits.radius,   &orbits.speed,         &orbits.phase,
+                                                       &orbits.wobble_x, &orbits.wobble_x_rate, &orbits.wobble_y,
+                                                       &orbits.wobble_y_rate};
+    CHECK_EQ(columns.size(), static_cast<size_t>(spark::kOrbitColumns));
+    std::vector<double> packed;
+    for (const std::vector<double>* column : columns) {
+        packed.insert(packed.end(), column->begin(), column->end());
+    }
+    const double elapsed[3] = {0.0, 500.0, 1000.0};
+    double x[9];
+    double y[9];
+    double want_x[9];
+    double want_y[9];
+    CHECK_EQ(estream_spark_orbit_positions(packed.data(), 3, 150.0, 300.0, elapsed, 3, x, y), 0);
+    spark::orbit_positions(orbits, elapsed, 3, want_x, want_y);
+    for (int i = 0; i < 9; ++i) {
+        CHECK(x[i] == want_x[i]);
+        CHECK(y[i] == want_y[i]);
+    }
+
+    CHECK_EQ(estream_spark_orbit_positions(nullptr, 3, 150.0, 300.0, elapsed, 3, x, y), -1);
+    CHECK_EQ(estream_spark_orbit_positions(packed.data(), 3, 150.0, 0.0, elapsed, 3, x, y), -1);
+    CHECK_EQ(estream_spark_orbit_positions(packed.data(), 3, 150.0, 300.0, nullptr, 3, x, y), -1);
+    CHECK_EQ(estream_spark_orbit_positions(packed.data(), 3, 150.0, 300.0, nullptr, 0, nullptr, nullptr), 0);
+}
+
+int main() {
+    test_sincos_matches_libm();
+    test_spark_orbits_match_expected_position();
+    test_odd_count_and_per_particle_wobble();
+    test_c_api();
+    std::puts("spark_orbit_test: OK");
+    return 0;
+}
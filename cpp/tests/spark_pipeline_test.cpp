@@ -0,0 +1,183 @@
+#include "check.h"
+#include "fixtures.h"
+#include "spark_pipeline.h"
+
+#include "estream_app_native.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace estream;
+using test::Frame;
+using test::orbit_frame;
+
+namespace {
+
+// Integer field `name` of a status JSON.
+long long field(const std::string& json, const std::string& name) {
+    const size_t at = json.find("\"" + name + "\":");
+    return at == std::string::npos ? -1 : std::atoll(json.c_str() + at + name.size() + 3);
+}
+
+// Poll until every captured frame is accounted for.
+std::string settle(spark::FramePipeline& pipeline) {
+    std::string status;
+    for (int i = 0; i < 2000; ++i) {
+        status = pipeline.status(false);
+        if (field(status, "frames") + field(status, "frames_stale") + field(status, "frames_dropped") ==
+            field(status, "frames_captured")) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return status;
+}
+
+}  // namespace
+
+static void test_controller_holds_target() {
+    spark::PipelineConfig config;
+    config.latency_target_ms = 10.0;
+    config.settle_frames = 4;
+    spark::ResolutionController controller(config);
+
+    // 60 ms at full resolution: coarser until the cost fits.
+    for (int i = 0; i < 100; ++i) {
+        controller.update(60.0 / (controller.scale() * controller.scale()));
+    }
+    CHECK_EQ(controller.scale(), 4);
+    CHECK(std::fabs(controller.detect_ms() - 60.0 / 16) < 1e-9);
+    // Max scale reached: it stays even when over the target.
+    for (int i = 0; i < 50; ++i) {
+        controller.update(50.0);
+    }
+    CHECK_EQ(controller.scale(), 4);
+
+    // The device got faster: back to full resolution, and no further
+    // changes while 4 ms at full resolution fits 10 ms.
+    for (int i = 0; i < 200; ++i) {
+        controller.update(4.0 / (controller.scale() * controller.scale()));
+    }
+    CHECK_EQ(controller.scale(), 1);
+
+    // A cost just over the target at scale 2 is not brought back to 1.
+    spark::ResolutionController edge(config);
+    for (int i = 0; i < 200; ++i) {
+        edge.update(12.0 / (edge.scale() * edge.scale()));
+    }
+    CHECK_EQ(edge.scale(), 2);
+
+    // No target: always full resolution.
+    spark::ResolutionController off{spark::PipelineConfig()};
+    for (int i = 0; i < 20; ++i) {
+        CHECK_EQ(off.update(500.0), 1);
+    }
+}
+
+static void test_threaded_pipeline_accounts_for_frames() {
+    spark::PipelineConfig config;
+    config.latency_target_ms = 1000.0;
+    spark::FramePipeline pipeline(spark::Options(), config);
+    CHECK(pipeline.threaded());
+    std::vector<Frame> frames;
+    for (int i = 0; i < 60; ++i) {
+        frames.push_back(orbit_frame(-0.04 * i));
+    }
+    for (int i = 0; i < 60; ++i) {
+        CHECK(pipeline.submit(frames[i].plane(), i * 33.0));
+        if (i % 3 == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    const std::string status = settle(pipeline);
+    CHECK_EQ(field(status, "frames_captured"), 60);
+    CHECK_EQ(field(status, "frames") + field(status, "frames_stale"), 60);
+    CHECK(field(status, "frames") > 0);
+    CHECK_EQ(field(status, "scale"), 1);
+    CHECK_EQ(field(status, "particles"), 4);
+
+    // After a reset the counts start over and old frames never show up.
+    pipeline.reset();
+    std::string fresh = pipeline.status(false);
+    CHECK_EQ(field(fresh, "frames"), 0);
+    CHECK_EQ(field(fresh, "frames_captured"), 0);
+    CHECK(pipeline.submit(frames[0].plane(), 0.0));
+    fresh = settle(pipeline);
+    CHECK_EQ(field(fresh, "frames_captured"), 1);
+    CHECK_EQ(field(fresh, "frames"), 1);
+}
+
+static void test_slow_detection_lowers_resolution() {
+    // A target no detector can meet: the scale climbs to 4 and the frames
+    // detected there are a quarter of the size in each direction.
+    spark::PipelineConfig config;
+    config.latency_target_ms = 1e-6;
+    config.settle_frames = 2;
+    spark::FramePipeline pipeline(spark::Options(), config);
+    const Frame frame = orbit_frame(0.5);
+    for (int i = 0; i < 40 && pipeline.scale() < 4; ++i) {
+        pipeline.submit(frame.plane(), i * 33.0);
+        settle(pipeline);
+    }
+    CHECK_EQ(pipeline.scale(), 4);
+    pipeline.submit(frame.plane(), 2000.0);
+    const std::string status = settle(pipeline);
+    // Max-pooling keeps the 3x3 particles above the threshold.
+    CHECK_EQ(field(status, "particles"), 4);
+    CHECK_EQ(field(status, "scale"), 4);
+}
+
+static void test_c_api() {
+    const Frame frame = orbit_frame(0.0);
+    CHECK_EQ(estream_spark_engine_create(300, 0.0), -1);
+    const long engine = estream_spark_engine_create(0, 0.0);
+    CHECK(engine > 0);
+    CHECK_EQ(estream_spark_engine_submit(engine, frame.pixels.data(), frame.width, frame.height, frame.width, 1, 0.0),
+             1);
+    CHECK_EQ(estream_spark_engine_submit(engine, frame.pixels.data(), frame.width, frame.height, 10, 1, 0.0), -1);
+
+    const uint8_t pubkey[4] = {1, 2, 3, 4};
+    CHECK_EQ(estream_spark_engine_start_liveness(engine, nullptr, 0, 0), -1);
+    CHECK_EQ(estream_spark_engine_start_liveness(engine, pubkey, 4, 1760000000000), 0);
+
+    char* json = estream_spark_engine_status(engine, 0);
+    CHECK(json != nullptr);
+    std::string status(json);
+    estream_app_free_string(json);
+    CHECK(status.find("\"frames\":1,\"frames_submitted\":1,\"frames_dropped\":0,") != std::string::npos);
+    CHECK(status.find("\"particles\":4,") != std::string::npos);
+    CHECK(status.find("\"direction\":\"insufficient\",\"motion_detected\":false,") != std::string::npos);
+    // Liveness started after the frame was queued still sees it.
+    CHECK(status.find("\"liveness\":{\"decision\":\"pending\",\"frames\":1,") != std::string::npos);
+    CHECK(status.find("\"frames_captured\":1,\"frames_stale\":0,\"scale\":1,") != std::string::npos);
+
+    json = estream_spark_engine_status(engine, 1);
+    status = json;
+    estream_app_free_string(json);
+    CHECK(status.find("\"decision\":\"not_live\"") != std::string::npos);
+
+    CHECK_EQ(estream_spark_engine_reset(engine), 0);
+    json = estream_spark_engine_status(engine, 0);
+    status = json;
+    estream_app_free_string(json);
+    CHECK(status.find("\"frames\":0,") != std::string::npos);
+    CHECK(status.find("\"liveness\":null,") != std::string::npos);
+
+    estream_spark_engine_destroy(engine);
+    CHECK(estream_spark_engine_status(engine, 0) == nullptr);
+    CHECK_EQ(estream_spark_engine_reset(engine), -1);
+}
+
+int main() {
+    test_controller_holds_target();
+    test_threaded_pipeline_accounts_for_frames();
+    test_slow_detection_lowers_resolution();
+    test_c_api();
+    std::puts("spark_pipeline_test: OK");
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include "check.h"
+#include "fixtures.h"
+#include "spark_pyramid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace estream;
+using test::Image;
+
+namespace {
+
+// Eight particles of different sizes and peaks on a circle, turned by
+// `angle`; the canvas is two thirds of the frame height, as when the
+// phone holds the pattern in view.
+Image orbit(double angle) {
+    Image image(640, 480, 16);
+    for (int i = 0; i < 8; ++i) {
+        const double a = angle + i * 0.785398163397448;
+        const double r = (i % 2 == 0 ? 110.0 : 60.0) / 300.0 * 320.0;
+        image.square(0.5 + r * std::cos(a) / image.width, 0.5 + r * std::sin(a) / image.height, 2 + i % 3,
+                     static_cast<uint8_t>(200 + 6 * i));
+    }
+    return image;
+}
+
+std::vector<spark::Particle> sorted(const spark::Particle* particles, size_t count) {
+    std::vector<spark::Particle> out(particles, particles + count);
+    std::sort(out.begin(), out.end(), [](const spark::Particle& a, const spark::Particle& b) {
+        return a.x != b.x ? a.x < b.x : a.y < b.y;
+    });
+    return out;
+}
+
+void check_same(const spark::Particle* got, size_t got_count, const spark::Particle* want, size_t want_count) {
+    CHECK_EQ(got_count, want_count);
+    const std::vector<spark::Particle> a = sorted(got, got_count);
+    const std::vector<spark::Particle> b = sorted(want, want_count);
+    for (size_t i = 0; i < a.size() && i < b.size(); ++i) {
+        CHECK(std::fabs(a[i].x - b[i].x) < 1e-5f);
+        CHECK(std::fabs(a[i].y - b[i].y) < 1e-5f);
+        CHECK(a[i].brightness == b[i].brightness);
+        CHECK_EQ(a[i].area, b[i].area);
+    }
+    for (size_t i = 1; i < got_count; ++i) {
+        CHECK(got[i - 1].brightness >= got[i].brightness);
+    }
+}
+
+}  // namespace
+
+static void test_tracking_matches_full_detector() {
+    spark::PyramidDetector pyramid;
+    spark::Detector full;
+    spark::Particle got[spark::kMaxParticles];
+    spark::Particle want[spark::kMaxParticles];
+    size_t tracked = 0;
+    uint64_t tracked_pixels = 0;
+    for (int i = 0; i < 90; ++i) {
+        // About 5 px per frame on the outer circle.
+        const Image image = orbit(0.04 * i);
+        const size_t n = pyramid.detect(image.plane(), got, spark::kMaxParticles);
+        check_same(got, n, want, full.detect(image.plane(), want, spark::kMaxParticles));
+        CHECK_EQ(n, 8u);
+        if (pyramid.last_tracked()) {
+            ++tracked;
+            tracked_pixels += pyramid.last_pixels();
+        } else {
+            // A search reads the frame once for the coarse level.
+            CHECK(pyramid.last_pixels() > 640u * 480u);
+        }
+    }
+    // One search every refresh_frames, windows in between, at under a
+    // tenth of the frame.
+    CHECK_EQ(tracked, 87u);
+    CHECK(tracked_pixels / tracked < 640u * 480u / 10);
+}
+
+static void test_new_particle_waits_for_search() {
+    spark::PyramidConfig config;
+    config.refresh_frames = 5;
+    spark::PyramidDetector pyramid(spark::Options(), config);
+    spark::Particle out[spark::kMaxParticles];
+    Image image(320, 240);
+    image.square(0.3, 0.5, 3, 220);
+    CHECK_EQ(pyramid.detect(image.plane(), out, spark::kMaxParticles), 1u);
+    CHECK(!pyramid.last_tracked());
+
+    image.square(0.7, 0.5, 3, 250);
+    size_t frames = 0;
+    while (pyramid.detect(image.plane(), out, spark::kMaxParticles) == 1) {
+        CHECK(pyramid.last_tracked());
+        ++frames;
+    }
+    CHECK_EQ(frames, 5u);
+    CHECK(!pyramid.last_tracked());
+    CHECK(out[0].brightness == 250.0f / 255.0f);
+}
+
+static void test_lost_particle_searches_at_once() {
+    spark::PyramidDetector pyramid;
+    spark::Particle out[spark::kMaxParticles];
+    Image before(320, 240);
+    before.square(0.25, 0.25, 3, 220);
+    pyramid.detect(before.plane(), out, spark::kMaxParticles);
+    pyramid.detect(before.plane(), out, spark::kMaxParticles);
+    CHECK(pyramid.last_tracked());
+
+    // Far outside its window: the same frame falls back to a search.
+    Image after(320, 240);
+    after.square(0.75, 0.75, 3, 220);
+    CHECK_EQ(pyramid.detect(after.plane(), out, spark::kMaxParticles), 1u);
+    CHECK(!pyramid.last_tracked());
+    CHECK(std::fabs(out[0].x - 0.75f) < 0.01f);
+    CHECK(std::fabs(out[0].y - 0.75f) < 0.01f);
+}
+
+static void test_component_past_window_is_not_cut() {
+    // A streak longer than any window reaches its window's edge; the
+    // whole frame is detected rather than reporting part of it.
+    spark::PyramidDetector pyramid;
+    spark::Detector full;
+    spark::Particle got[spark::kMaxParticles];
+    spark::Particle want[spark::kMaxParticles];
+    Image image(320, 240);
+    for (int x = 40; x < 280; ++x) {
+        image.pixels[static_cast<size_t>(120) * image.stride + x] = 230;
+    }
+    for (int i = 0; i < 3; ++i) {
+        const size_t n = pyramid.detect(image.plane(), got, spark::kMaxParticles);
+        check_same(got, n, want, full.detect(image.plane(), want, spark::kMaxParticles));
+        CHECK_EQ(got[0].area, 240u);
+    }
+}
+
+static void test_blank_and_invalid_frames() {
+    spark::PyramidDetector pyramid;
+    spark::Particle out[spark::kMaxParticles];
+    const Image blank(320, 240);
+    CHECK_EQ(pyramid.detect(blank.plane(), out, spark::kMaxParticles), 0u);
+    CHECK(!pyramid.last_tracked());
+    // The coarse level and nothing else.
+    CHECK_EQ(pyramid.last_pixels(), 320u * 240u + 80u * 60u);
+    CHECK_EQ(pyramid.detect(spark::Plane(), out, spark::kMaxParticles), 0u);
+
+    // Smaller than one coarse pixel: detected at full resolution.
+    Image tiny(3, 3);
+    tiny.pixels[4] = 255;
+    CHECK_EQ(pyramid.detect(tiny.plane(), out, spark::kMaxParticles), 1u);
+    CHECK(std::fabs(out[0].x - 0.5f) < 1e-6f);
+}
+
+int main() {
+    test_tracking_matches_full_detector();
+    test_new_particle_waits_for_search();
+    test_lost_particle_searches_at_once();
+    test_component_past_window_is_not_cut();
+    test_blank_and_invalid_frames();
+    std::puts("spark_pyramid_test: OK");
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "check.h"
+#include "trace.h"
+
+#include "estream_app_native.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+using namespace estream;
+
+static void test_library_load_marker() {
+    const std::string json = trace::to_chrome_json();
+    CHECK(json.find("\"library_load\"") != std::string::npos);
+}
+
+static void test_spans_and_escaping() {
+    trace::reset();
+    estream_trace_begin("estream_connect");
+    estream_trace_end("estream_connect");
+    estream_trace_instant("quote\"name");
+    CHECK_EQ(trace::event_count(), 3u);
+
+    const std::string json = trace::to_chrome_json();
+    CHECK(json.find("\"ph\":\"B\"") != std::string::npos);
+    CHECK(json.find("\"ph\":\"E\"") != std::string::npos);
+    CHECK(json.find("quote\\\"name") != std::string::npos);
+}
+
+static void test_complete_events() {
+    trace::reset();
+    estream_trace_complete("snapshot_restore", 1500);
+    CHECK_EQ(trace::event_count(), 1u);
+    const std::string json = trace::to_chrome_json();
+    CHECK(json.find("\"ph\":\"X\"") != std::string::npos);
+    CHECK(json.find("\"dur\":1.500") != std::string::npos);
+
+    // Clamped to start no earlier than the library load.
+    trace::reset();
+    estream_trace_complete("forever", UINT64_MAX);
+    CHECK(trace::to_chrome_json().find("\"ts\":0.000,") != std::string::npos);
+}
+
+static void test_truncates_long_names() {
+    trace::reset();
+    const std::string name(100, 'x');
+    estream_trace_instant(name.c_str());
+    const std::string json = trace::to_chrome_json();
+    CHECK(json.find(std::string(trace::kNameCapacity - 1, 'x') + "\"") != std::string::npos);
+}
+
+static void test_overflow_counts_drops() {
+    trace::reset();
+    std::thread a([] { for (size_t i = 0; i < trace::kEventCapacity; ++i) estream_trace_instant("a"); });
+    std::thread b([] { for (size_t i = 0; i < 10; ++i) estream_trace_instant("b"); });
+    a.join();
+    b.join();
+    CHECK_EQ(trace::event_count(), trace::kEventCapacity);
+    CHECK_EQ(trace::dropped_count(), 10u);
+}
+
+static void test_dump_writes_file() {
+    trace::reset();
+    estream_trace_instant("dump");
+    const char* path = "trace_test_dump.json";
+    CHECK_EQ(estream_trace_dump(path), 1);
+
+    std::FILE* f = std::fopen(path, "rb");
+    CHECK(f != nullptr);
+    char buf[256] = {};
+    std::fread(buf, 1, sizeof(buf) - 1, f);
+    std::fclose(f);
+    std::remove(path);
+    CHECK(std::string(buf).rfind("{\"displayTimeUnit\"", 0) == 0);
+
+    CHECK_EQ(estream_trace_dump("/nonexistent-dir/trace.json"), -1);
+}
+
+int main() {
+    test_library_load_marker();
+    test_spans_and_escaping();
+    test_complete_events();
+    test_truncates_long_names();
+    test_overflow_counts_drops();
+    test_dump_writes_file();
+    std::puts("trace_test: OK");
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "check.h"
+#include "spans.h"
+#include "trace_writer.h"
+
+#include "estream_app_native.h"
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace estream;
+
+static std::string read_file(const char* path) {
+    std::string out;
+    std::FILE* f = std::fopen(path, "rb");
+    CHECK(f != nullptr);
+    char buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) {
+        out.append(buf, n);
+    }
+    std::fclose(f);
+    return out;
+}
+
+static size_t count(const std::string& haystack, const std::string& needle) {
+    size_t n = 0;
+    for (size_t pos = haystack.find(needle); pos != std::string::npos;
+         pos = haystack.find(needle, pos + 1)) {
+        ++n;
+    }
+    return n;
+}
+
+static void emit_spans(int n) {
+    for (int i = 0; i < n; ++i) {
+        Span outer("ratchet_encrypt");
+        Span inner("kem_encaps");
+    }
+}
+
+static uint64_t read_varint(const std::string& s, size_t& pos) {
+    uint64_t v = 0;
+    for (int shift = 0; pos < s.size(); shift += 7) {
+        const uint8_t b = static_cast<uint8_t>(s[pos++]);
+        v |= uint64_t{b & 0x7fu} << shift;
+        if ((b & 0x80) == 0) {
+            return v;
+        }
+    }
+    CHECK(false);
+    return 0;
+}
+
+static void test_chrome_json() {
+    const char* path = "trace_writer_test.json";
+    CHECK_EQ(estream_trace_start(path, ESTREAM_TRACE_FORMAT_CHROME_JSON), 0);
+    CHECK_EQ(estream_trace_start(path, ESTREAM_TRACE_FORMAT_CHROME_JSON), -1);
+
+    std::thread a(emit_spans, 100);
+    std::thread b(emit_spans, 100);
+    a.join();
+    b.join();
+    emit_spans(1);
+
+    CHECK_EQ(estream_trace_stop(), 804);
+    CHECK_EQ(estream_trace_stop(), -1);
+
+    const std::string json = read_file(path);
+    std::remove(path);
+    CHECK(json.rfind("{\"displayTimeUnit\"", 0) == 0);
+    CHECK_EQ(count(json, "\"ph\":\"B\""), 402u);
+    CHECK_EQ(count(json, "\"ph\":\"E\""), 402u);
+    CHECK(json.find("\"dropped_events\":0}}") != std::string::npos);
+}
+
+static void test_perfetto_framing() {
+    const char* path = "trace_writer_test.pftrace";
+    CHECK_EQ(estream_trace_start(path, ESTREAM_TRACE_FORMAT_PERFETTO), 0);
+    emit_spans(10);
+    CHECK_EQ(estream_trace_stop(), 40);
+
+    const std::string data = read_file(path);
+    std::remove(path);
+
+    // Every top-level record must be a length-delimited Trace.packet (field 1).
+    size_t pos = 0;
+    size_t packets = 0;
+    while (pos < data.size()) {
+        CHECK_EQ(read_varint(data, pos), (1u << 3) | 2u);
+        const uint64_t len = read_varint(data, pos);
+        pos += len;
+        CHECK(pos <= data.size());
+        ++packets;
+    }
+    CHECK_EQ(packets, 41u);  // one thread descriptor + 40 events
+    CHECK(data.find("kem_encaps") != std::string::npos);
+}
+
+static void test_no_events_after_stop() {
+    const char* path = "trace_writer_test_idle.json";
+    CHECK_EQ(estream_trace_start(path, ESTREAM_TRACE_FORMAT_CHROME_JSON), 0);
+    CHECK_EQ(estream_trace_stop(), 0);
+    emit_spans(5);
+    CHECK(spans::g_hook.load() == nullptr);
+    std::remove(path);
+}
+
+int main() {
+    test_chrome_json();
+    test_perfetto_framing();
+    test_no_events_after_stop();
+    std::puts("trace_writer_test: OK");
+    return 0;
+}
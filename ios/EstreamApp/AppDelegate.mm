@@ -2,16 +2,38 @@
 
 #import <React/RCTBundleURLProvider.h>
 
+#import "estream_app_native.h"
+
 @implementation AppDelegate
 
 - (BOOL)application:(UIApplication *)application didFinishLaunchingWithOptions:(NSDictionary *)launchOptions
 {
+  estream_trace_begin("didFinishLaunchingWithOptions");
+  [self startPrewarm];
   self.moduleName = @"EstreamApp";
   // You can add your custom initial props in the dictionary below.
   // They will be passed down to the ViewController used by React Native.
   self.initialProps = @{};
 
-  return [super application:application didFinishLaunchingWithOptions:launchOptions];
+  BOOL result = [super application:application didFinishLaunchingWithOptions:launchOptions];
+  estream_trace_end("didFinishLaunchingWithOptions");
+  return result;
+}
+
+// Resolve, pre-connect and warm the crypto paths while React Native boots.
+// Configured through EStreamPrewarmNodeAddr / EStreamPrewarmH3Addr in Info.plist.
+- (void)startPrewarm
+{
+  NSDictionary *info = [[NSBundle mainBundle] infoDictionary];
+  NSString *nodeAddr = info[@"EStreamPrewarmNodeAddr"];
+  NSString *h3Addr = info[@"EStreamPrewarmH3Addr"];
+
+  EstreamPrewarmConfig config = {};
+  config.node_addr = nodeAddr.length > 0 ? nodeAddr.UTF8String : NULL;
+  config.h3_addr = h3Addr.length > 0 ? h3Addr.UTF8String : NULL;
+  config.budget_ms = 3000;
+  config.warm_crypto = 1;
+  estream_prewarm(&config);
 }
 
 - (NSURL *)sourceURLForBridge:(RCTBridge *)bridge
@@ -21,11 +43,14 @@
 
 - (NSURL *)bundleURL
 {
+  estream_trace_begin("bundleURL");
 #if DEBUG
-  return [[RCTBundleURLProvider sharedSettings] jsBundleURLForBundleRoot:@"index"];
+  NSURL *url = [[RCTBundleURLProvider sharedSettings] jsBundleURLForBundleRoot:@"index"];
 #else
-  return [[NSBundle mainBundle] URLForResource:@"main" withExtension:@"jsbundle"];
+  NSURL *url = [[NSBundle mainBundle] URLForResource:@"main" withExtension:@"jsbundle"];
 #endif
+  estream_trace_end("bundleURL");
+  return url;
 }
 
 @end
@@ -6,13 +6,12 @@
 //  Collects device-specific timing fingerprints for device verification
 //  and emulator detection.
 //
-//  Uses mach_absolute_time for high-precision timing, Metal for GPU,
-//  and Accelerate framework for vector/matrix operations.
+//  CPU kernels run in the shared native library (estream_etfa_collect);
+//  GPU kernels use Metal, timed with mach_absolute_time.
 //
 
 import Foundation
 import Metal
-import Accelerate
 import CryptoKit
 import UIKit
 
@@ -28,36 +27,24 @@ class ETFAModule: NSObject {
     private static let EVENT_COMPLETE = "onETFAComplete"
     private static let EVENT_ERROR = "onETFAError"
     
-    // MARK: - Pre-allocated Buffers
-    
-    private let memBuffer1M: [UInt8]
-    private let memBuffer4M: [UInt8]
-    private let randomIndices1M: [Int]
-    
     // Metal device (lazy initialized)
     private lazy var metalDevice: MTLDevice? = MTLCreateSystemDefaultDevice()
     
     // Timing conversion
     private var timebaseInfo = mach_timebase_info_data_t()
     
-    // Blackhole to prevent optimization
-    private var blackhole: Any?
-    
     // Event bridge
     private var eventBridge: RCTEventEmitter?
     
+    // Reference fingerprints (estream_etfa_index_*), opened on first use
+    private static let INDEX_FILE = "etfa_references.idx"
+    private static let INDEX_PROBES: Int32 = 8
+    private let indexQueue = DispatchQueue(label: "io.estream.etfa.index")
+    private var referenceIndex = -1
+    
     // MARK: - Initialization
     
     override init() {
-        // Pre-allocate memory buffers
-        self.memBuffer1M = [UInt8](repeating: 0, count: 1024 * 1024)
-        self.memBuffer4M = [UInt8](repeating: 0, count: 4 * 1024 * 1024)
-        
-        // Generate random indices
-        var indices = Array(0..<(1024 * 1024))
-        indices.shuffle()
-        self.randomIndices1M = indices
-        
         super.init()
         
         // Get timebase info for nanosecond conversion
@@ -149,8 +136,12 @@ class ETFAModule: NSObject {
                     // All ratios as array
                     "stableRatios": fingerprint.stableRatios,
                     
+                    // CPU ratios per core cluster, fastest first
+                    "clusters": fingerprint.clusters,
+                    
                     // Device fingerprint hash
-                    "fingerprintHash": fingerprint.hash
+                    "fingerprintHash": fingerprint.hash,
+                    "fingerprintCode": fingerprint.code
                 ]
                 
                 DispatchQueue.main.async {
@@ -167,6 +158,114 @@ class ETFAModule: NSObject {
         }
     }
     
+    // MARK: - Reference Index
+    
+    /// Store the stable ratios of a known device under `id` (replacing any
+    /// previous entry) and persist the index. Resolves with the new size.
+    @objc(addReference:ratios:resolver:rejecter:)
+    func addReference(
+        _ id: String,
+        ratios: [Double],
+        resolver resolve: @escaping RCTPromiseResolveBlock,
+        rejecter reject: @escaping RCTPromiseRejectBlock
+    ) {
+        indexQueue.async {
+            let index = self.openIndex()
+            let status = ratios.withUnsafeBufferPointer {
+                estream_etfa_index_add(index, id, $0.baseAddress, Int32($0.count))
+            }
+            guard status == 0 else {
+                reject("ETFA_INDEX_ERROR", ETFAError.invalidFingerprint.localizedDescription, ETFAError.invalidFingerprint)
+                return
+            }
+            resolve(self.saveIndex(index))
+        }
+    }
+    
+    @objc(removeReference:resolver:rejecter:)
+    func removeReference(
+        _ id: String,
+        resolver resolve: @escaping RCTPromiseResolveBlock,
+        rejecter reject: @escaping RCTPromiseRejectBlock
+    ) {
+        indexQueue.async {
+            let index = self.openIndex()
+            let removed = estream_etfa_index_remove(index, id) == 0
+            if removed {
+                _ = self.saveIndex(index)
+            }
+            resolve(removed)
+        }
+    }
+    
+    /// The `k` stored references closest to `ratios`, closest first. A
+    /// re-measured device matches its reference with a small distance even
+    /// when individual ratios have drifted.
+    @objc(findNearest:k:resolver:rejecter:)
+    func findNearest(
+        _ ratios: [Double],
+        k: Int,
+        resolver resolve: @escaping RCTPromiseResolveBlock,
+        rejecter reject: @escaping RCTPromiseRejectBlock
+    ) {
+        indexQueue.async {
+            let index = self.openIndex()
+            let resultPtr = ratios.withUnsafeBufferPointer {
+                estream_etfa_index_search(index, $0.baseAddress, Int32($0.count),
+                                          Int32(max(k, 1)), ETFAModule.INDEX_PROBES)
+            }
+            guard let resultPtr = resultPtr else {
+                reject("ETFA_INDEX_ERROR", ETFAError.invalidFingerprint.localizedDescription, ETFAError.invalidFingerprint)
+                return
+            }
+            let resultString = String(cString: resultPtr)
+            estream_app_free_string(resultPtr)
+            
+            guard let data = resultString.data(using: .utf8),
+                  let json = try? JSONSerialization.jsonObject(with: data) as? [String: Any],
+                  let payload = json["data"] as? [String: Any] else {
+                reject("ETFA_INDEX_ERROR", ETFAError.invalidFingerprint.localizedDescription, ETFAError.invalidFingerprint)
+                return
+            }
+            resolve([
+                "size": payload["size"] ?? 0,
+                "scanned": payload["scanned"] ?? 0,
+                "matches": payload["matches"] ?? []
+            ])
+        }
+    }
+    
+    private var indexPath: String {
+        let documents = FileManager.default.urls(for: .documentDirectory, in: .userDomainMask)[0]
+        return documents.appendingPathComponent(ETFAModule.INDEX_FILE).path
+    }
+    
+    /// Called on indexQueue.
+    private func openIndex() -> Int {
+        if referenceIndex < 0 {
+            referenceIndex = estream_etfa_index_load(indexPath)
+            if referenceIndex < 0 {
+                referenceIndex = estream_etfa_index_create()
+            }
+            // Switches to coarse cells once the set is large enough to need them
+            estream_etfa_index_train(referenceIndex, 0, 0)
+        }
+        return referenceIndex
+    }
+    
+    /// Retrains when the set has doubled since the last save, then saves.
+    /// Called on indexQueue.
+    private func saveIndex(_ index: Int) -> Int {
+        let size = Int(estream_etfa_index_size(index))
+        if size > 0 && size & (size - 1) == 0 {
+            estream_etfa_index_train(index, 0, 0)
+        }
+        if estream_etfa_index_save(index, indexPath) != 0 {
+            print("[\(ETFAModule.TAG)] Failed to save reference index")
+        }
+        return size
+    }
+    
     // MARK: - Fingerprint Generation
     
     private struct Fingerprint {
@@ -178,14 +277,16 @@ class ETFAModule: NSObject {
         let r18, r19, r22, r24, r25: Double
         let r28, r29: Double
         let stableRatios: [Double]
+        let clusters: [[String: Any]]
         let hash: String
+        let code: String
     }
     
     private func generateFingerprint(
         sampleCount: Int,
         onProgress: @escaping (String, Float) -> Void
     ) throws -> Fingerprint {
-        let totalOps = 25
+        let totalOps = 22
         var completed = 0
         
         func report(_ name: String) {
@@ -193,71 +294,15 @@ class ETFAModule: NSObject {
             onProgress(name, Float(completed) / Float(totalOps))
         }
         
-        // Warmup and GC hint
-        autoreleasepool {
-            _ = memSequential()
-        }
-        Thread.sleep(forTimeInterval: 0.1)
-        
         report("Warmup")
         
-        // Phase 1: Memory operations
-        let memSeq = measureMedian(samples: sampleCount) { memSequential() }
-        report("Memory Sequential")
-        
-        let memRand = measureMedian(samples: sampleCount) { memRandom() }
-        report("Memory Random")
-        
-        let memCopy = measureMedian(samples: sampleCount) { memCopy() }
-        report("Memory Copy")
-        
-        // Phase 1: Compute operations
-        let intMult = measureMedian(samples: sampleCount) { intMultiply() }
-        report("Int Multiply")
-        
-        let floatMult = measureMedian(samples: sampleCount) { floatMultiply() }
-        report("Float Multiply")
-        
-        let vecDot = measureMedian(samples: sampleCount) { vectorDot() }
-        report("Vector Dot")
-        
-        let matrixOp = measureMedian(samples: sampleCount) { matrixOp() }
-        report("Matrix Op")
-        
-        // Phase 2: Memory hierarchy
-        let seq4k = measureMedian(samples: sampleCount) { memSequential4K() }
-        report("Seq 4K")
-        
-        let seq64k = measureMedian(samples: sampleCount) { memSequential64K() }
-        report("Seq 64K")
-        
-        let seq4m = measureMedian(samples: sampleCount) { memSequential4M() }
-        report("Seq 4M")
-        
-        let rand4k = measureMedian(samples: sampleCount) { memRandom4K() }
-        report("Rand 4K")
-        
-        let rand64k = measureMedian(samples: sampleCount) { memRandom64K() }
-        report("Rand 64K")
-        
-        // Phase 3: Precision variants
-        let intMul32 = measureMedian(samples: sampleCount) { intMultiply32() }
-        report("Int Mul 32")
-        
-        let intDiv32 = measureMedian(samples: sampleCount) { intDivide32() }
-        report("Int Div 32")
-        
-        let intDiv64 = measureMedian(samples: sampleCount) { intDivide64() }
-        report("Int Div 64")
-        
-        let addChain = measureMedian(samples: sampleCount) { intAddChain() }
-        report("Add Chain")
-        
-        let addParallel = measureMedian(samples: sampleCount) { intAddParallel() }
-        report("Add Parallel")
-        
-        let bitwise = measureMedian(samples: sampleCount) { bitwiseOps() }
-        report("Bitwise")
+        // Phases 1-3: memory, compute and precision kernels (native, all
+        // core clusters in parallel)
+        let native = try collectNativeRatios(sampleCount: sampleCount) { label, fraction in
+            onProgress(label, (1 + fraction * 18) / Float(totalOps))
+        }
+        let cpuRatios = native.ratios
+        completed += 18
         
         // Phase 4: GPU (fewer samples - slower)
         let gpuSamples = min(sampleCount, 50)
@@ -270,25 +315,28 @@ class ETFAModule: NSObject {
         let gpuLink = measureMedian(samples: gpuSamples) { gpuProgramLink() }
         report("GPU Link")
         
-        // Compute ratios
         func ratio(_ a: UInt64, _ b: UInt64) -> Double {
             b > 0 ? Double(a) / Double(b) : 0.0
         }
         
-        let r5 = ratio(memSeq, memRand)
-        let r6 = ratio(memCopy, memSeq)
-        let r7 = ratio(intMult, floatMult)
-        let r9 = ratio(floatMult, matrixOp)
-        let r10 = ratio(seq4k, seq64k)
-        let r11 = ratio(seq64k, memSeq)
-        let r12 = ratio(memSeq, seq4m)
-        let r13 = ratio(rand4k, rand64k)
-        let r14 = ratio(rand64k, memRand)
-        let r18 = ratio(intMul32, intMult)
-        let r19 = ratio(intDiv32, intDiv64)
-        let r22 = ratio(intMult, intDiv64)
-        let r24 = ratio(addChain, addParallel)
-        let r25 = ratio(intMult, bitwise)
+        func cpu(_ name: String) -> Double {
+            cpuRatios[name] ?? 0.0
+        }
+        
+        let r5 = cpu("r5_mem_seq_to_rand")
+        let r6 = cpu("r6_mem_copy_to_seq")
+        let r7 = cpu("r7_int_to_float")
+        let r9 = cpu("r9_float_to_matrix")
+        let r10 = cpu("r10_seq_4k_to_64k")
+        let r11 = cpu("r11_seq_64k_to_1m")
+        let r12 = cpu("r12_seq_1m_to_4m")
+        let r13 = cpu("r13_rand_4k_to_64k")
+        let r14 = cpu("r14_rand_64k_to_1m")
+        let r18 = cpu("r18_int_mul_32_to_64")
+        let r19 = cpu("r19_int_div_32_to_64")
+        let r22 = cpu("r22_int_mul_to_div")
+        let r24 = cpu("r24_add_chain_to_parallel")
+        let r25 = cpu("r25_int_to_bitwise")
         let r28 = ratio(gpuVertex, gpuFragment)
         let r29 = ratio(gpuVertex, gpuLink)
         
@@ -315,7 +363,9 @@ class ETFAModule: NSObject {
             r18: r18, r19: r19, r22: r22, r24: r24, r25: r25,
             r28: r28, r29: r29,
             stableRatios: stableRatios,
-            hash: hash
+            clusters: native.clusters,
+            hash: hash,
+            code: codeRatios(stableRatios)
         )
     }
     
@@ -329,239 +379,96 @@ class ETFAModule: NSObject {
         return digest.prefix(16).map { String(format: "%02x", $0) }.joined()
     }
     
-    // MARK: - Timing Utilities
-    
-    private func nowNanos() -> UInt64 {
-        let time = mach_absolute_time()
-        return time * UInt64(timebaseInfo.numer) / UInt64(timebaseInfo.denom)
-    }
-    
-    private func measureMedian(samples: Int, operation: () -> UInt64) -> UInt64 {
-        var results = [UInt64](repeating: 0, count: samples)
-        for i in 0..<samples {
-            results[i] = operation()
+    /// Quantized code of the ratios (1/16-octave steps, one byte each). Small
+    /// drift moves single bytes rather than the whole value; use findNearest
+    /// for tolerant matching.
+    private func codeRatios(_ ratios: [Double]) -> String {
+        let codePtr = ratios.withUnsafeBufferPointer {
+            estream_etfa_fingerprint_code($0.baseAddress, Int32($0.count))
         }
-        results.sort()
-        return results[samples / 2]
+        guard let codePtr = codePtr else { return "" }
+        let code = String(cString: codePtr)
+        estream_app_free_string(codePtr)
+        return code
     }
     
-    // MARK: - Memory Operations
+    // MARK: - Native Kernels
     
-    private func memSequential() -> UInt64 {
-        let start = nowNanos()
-        var sum: UInt64 = 0
-        for i in 0..<memBuffer1M.count {
-            sum = sum &+ UInt64(memBuffer1M[i])
+    private final class ProgressBox {
+        let onProgress: (String, Float) -> Void
+        init(_ onProgress: @escaping (String, Float) -> Void) {
+            self.onProgress = onProgress
         }
-        blackhole = sum
-        return nowNanos() - start
     }
     
-    private func memRandom() -> UInt64 {
-        let start = nowNanos()
-        var sum: UInt64 = 0
-        for i in randomIndices1M {
-            sum = sum &+ UInt64(memBuffer1M[i & 0xFFFFF])
-        }
-        blackhole = sum
-        return nowNanos() - start
-    }
+    /// CPU ratios computed natively, in stableRatios order.
+    private static let cpuRatioNames = [
+        "r5_mem_seq_to_rand", "r6_mem_copy_to_seq", "r7_int_to_float", "r9_float_to_matrix",
+        "r10_seq_4k_to_64k", "r11_seq_64k_to_1m", "r12_seq_1m_to_4m", "r13_rand_4k_to_64k",
+        "r14_rand_64k_to_1m", "r18_int_mul_32_to_64", "r19_int_div_32_to_64", "r22_int_mul_to_div",
+        "r24_add_chain_to_parallel", "r25_int_to_bitwise"
+    ]
     
-    private func memCopy() -> UInt64 {
-        var dest = [UInt8](repeating: 0, count: memBuffer1M.count)
-        let start = nowNanos()
-        memBuffer1M.withUnsafeBytes { src in
-            dest.withUnsafeMutableBytes { dst in
-                _ = memcpy(dst.baseAddress!, src.baseAddress!, memBuffer1M.count)
-            }
-        }
-        blackhole = dest[0]
-        return nowNanos() - start
-    }
-    
-    private func memSequential4K() -> UInt64 {
-        let start = nowNanos()
-        var sum: UInt64 = 0
-        for i in 0..<4096 {
-            sum = sum &+ UInt64(memBuffer1M[i])
-        }
-        blackhole = sum
-        return nowNanos() - start
-    }
-    
-    private func memSequential64K() -> UInt64 {
-        let start = nowNanos()
-        var sum: UInt64 = 0
-        for i in 0..<65536 {
-            sum = sum &+ UInt64(memBuffer1M[i])
-        }
-        blackhole = sum
-        return nowNanos() - start
-    }
-    
-    private func memSequential4M() -> UInt64 {
-        let start = nowNanos()
-        var sum: UInt64 = 0
-        for i in 0..<memBuffer4M.count {
-            sum = sum &+ UInt64(memBuffer4M[i])
-        }
-        blackhole = sum
-        return nowNanos() - start
-    }
-    
-    private func memRandom4K() -> UInt64 {
-        let start = nowNanos()
-        var sum: UInt64 = 0
-        for i in 0..<4096 {
-            sum = sum &+ UInt64(memBuffer1M[randomIndices1M[i] & 0xFFF])
-        }
-        blackhole = sum
-        return nowNanos() - start
-    }
-    
-    private func memRandom64K() -> UInt64 {
-        let start = nowNanos()
-        var sum: UInt64 = 0
-        for i in 0..<65536 {
-            sum = sum &+ UInt64(memBuffer1M[randomIndices1M[i] & 0xFFFF])
-        }
-        blackhole = sum
-        return nowNanos() - start
-    }
-    
-    // MARK: - Compute Operations
-    
-    private func intMultiply() -> UInt64 {
-        let start = nowNanos()
-        var result: Int64 = 1
-        var multiplier: Int64 = 7
-        for _ in 0..<1_000_000 {
-            result = result &* multiplier
-            result = result & 0x7FFFFFFFFFFFFFFF
-            multiplier = (multiplier &* 31 &+ 17) & 0x7FFFFFFF
-        }
-        blackhole = result
-        return nowNanos() - start
-    }
-    
-    private func intMultiply32() -> UInt64 {
-        let start = nowNanos()
-        var result: Int32 = 1
-        var multiplier: Int32 = 7
-        for _ in 0..<1_000_000 {
-            result = result &* multiplier
-            result = result & 0x7FFFFFFF
-            multiplier = (multiplier &* 31 &+ 17) & 0x7FFF
-        }
-        blackhole = result
-        return nowNanos() - start
-    }
-    
-    private func intDivide32() -> UInt64 {
-        let start = nowNanos()
-        var result: Int32 = Int32.max
-        var divisor: Int32 = 3
-        for _ in 0..<500_000 {
-            result = result / divisor
-            if result < 1000 { result = Int32.max }
-            divisor = (divisor &* 31 &+ 17) & 0x7FFF
-            if divisor < 2 { divisor = 3 }
-        }
-        blackhole = result
-        return nowNanos() - start
-    }
-    
-    private func intDivide64() -> UInt64 {
-        let start = nowNanos()
-        var result: Int64 = Int64.max
-        var divisor: Int64 = 3
-        for _ in 0..<500_000 {
-            result = result / divisor
-            if result < 1000 { result = Int64.max }
-            divisor = (divisor &* 31 &+ 17) & 0x7FFFFFFF
-            if divisor < 2 { divisor = 3 }
-        }
-        blackhole = result
-        return nowNanos() - start
-    }
-    
-    private func floatMultiply() -> UInt64 {
-        let start = nowNanos()
-        var result: Double = 1.0
-        let multiplier: Double = 1.0000001
-        for _ in 0..<1_000_000 {
-            result *= multiplier
-            if result > 1e100 { result = 1.0 }
+    /// Run the shared C++ CPU kernels on every core cluster at once. Returns
+    /// the fastest cluster's ratios by name and a summary per cluster.
+    private func collectNativeRatios(
+        sampleCount: Int,
+        onProgress: @escaping (String, Float) -> Void
+    ) throws -> (ratios: [String: Double], clusters: [[String: Any]]) {
+        let box = ProgressBox(onProgress)
+        let resultPtr = withExtendedLifetime(box) {
+            estream_etfa_collect_parallel(
+                Int32(max(sampleCount, 1)),
+                0,
+                { ctx, label, progress in
+                    guard let ctx = ctx, let label = label else { return }
+                    let box = Unmanaged<ProgressBox>.fromOpaque(ctx).takeUnretainedValue()
+                    box.onProgress(String(cString: label), progress)
+                },
+                Unmanaged.passUnretained(box).toOpaque()
+            )
         }
-        blackhole = result
-        return nowNanos() - start
-    }
-    
-    private func vectorDot() -> UInt64 {
-        var a = [Float](repeating: 0, count: 65536)
-        var b = [Float](repeating: 0, count: 65536)
-        for i in 0..<65536 {
-            a[i] = Float(i % 100) / 100.0
-            b[i] = Float((i + 37) % 100) / 100.0
+        guard let resultPtr = resultPtr else {
+            throw ETFAError.collectionFailed
         }
+        let resultString = String(cString: resultPtr)
+        estream_app_free_string(resultPtr)
         
-        let start = nowNanos()
-        var result: Float = 0
-        vDSP_dotpr(a, 1, b, 1, &result, vDSP_Length(65536))
-        blackhole = result
-        return nowNanos() - start
-    }
-    
-    private func matrixOp() -> UInt64 {
-        let n = 128
-        var a = [Float](repeating: 0, count: n * n)
-        var b = [Float](repeating: 0, count: n * n)
-        var c = [Float](repeating: 0, count: n * n)
-        
-        for i in 0..<(n * n) {
-            a[i] = Float(i % 100) / 100.0
-            b[i] = Float((i + 17) % 100) / 100.0
+        guard let data = resultString.data(using: .utf8),
+              let json = try? JSONSerialization.jsonObject(with: data) as? [String: Any],
+              let payload = json["data"] as? [String: Any],
+              let ratios = payload["ratios"] as? [String: Double],
+              let nativeClusters = payload["clusters"] as? [[String: Any]] else {
+            throw ETFAError.collectionFailed
         }
         
-        let start = nowNanos()
-        // Using Accelerate for matrix multiply
-        vDSP_mmul(a, 1, b, 1, &c, 1, vDSP_Length(n), vDSP_Length(n), vDSP_Length(n))
-        blackhole = c
-        return nowNanos() - start
-    }
-    
-    private func intAddChain() -> UInt64 {
-        let start = nowNanos()
-        var a: Int64 = 1, b: Int64 = 2, c: Int64 = 3, d: Int64 = 4
-        for _ in 0..<1_000_000 {
-            a = a &+ b; b = b &+ c; c = c &+ d; d = d &+ a
+        let clusters = nativeClusters.map { cluster -> [String: Any] in
+            let clusterRatios = cluster["ratios"] as? [String: Double] ?? [:]
+            return [
+                "id": cluster["id"] ?? 0,
+                "cpuCount": cluster["cpu_count"] ?? 0,
+                "pinned": cluster["pinned"] ?? false,
+                "migratedSamples": cluster["migrated_samples"] ?? 0,
+                "stableRatios": ETFAModule.cpuRatioNames.map { clusterRatios[$0] ?? 0.0 }
+            ]
         }
-        blackhole = a &+ b &+ c &+ d
-        return nowNanos() - start
+        return (ratios, clusters)
     }
     
-    private func intAddParallel() -> UInt64 {
-        let start = nowNanos()
-        var a: Int64 = 1, b: Int64 = 2, c: Int64 = 3, d: Int64 = 4
-        let x: Int64 = 5, y: Int64 = 6, z: Int64 = 7, w: Int64 = 8
-        for _ in 0..<1_000_000 {
-            a = a &+ x; b = b &+ y; c = c &+ z; d = d &+ w
-        }
-        blackhole = a &+ b &+ c &+ d
-        return nowNanos() - start
+    // MARK: - Timing Utilities
+    
+    private func nowNanos() -> UInt64 {
+        let time = mach_absolute_time()
+        return time * UInt64(timebaseInfo.numer) / UInt64(timebaseInfo.denom)
     }
     
-    private func bitwiseOps() -> UInt64 {
-        let start = nowNanos()
-        var a: UInt64 = 0xDEADBEEF
-        var b: UInt64 = 0xCAFEBABE
-        for _ in 0..<1_000_000 {
-            a = a ^ b
-            b = (b & 0xFFFF0000) | (a & 0x0000FFFF)
-            a = (a << 1) | (a >> 63)
+    private func measureMedian(samples: Int, operation: () -> UInt64) -> UInt64 {
+        var results = [UInt64](repeating: 0, count: samples)
+        for i in 0..<samples {
+            results[i] = operation()
         }
-        blackhole = a ^ b
-        return nowNanos() - start
+        results.sort()
+        return results[samples / 2]
     }
     
     // MARK: - GPU Operations (Metal)
@@ -685,6 +592,22 @@ class ETFAModule: NSObject {
     }
 }
 
+// MARK: - ETFA Error
+
+enum ETFAError: Error, LocalizedError {
+    case collectionFailed
+    case invalidFingerprint
+    
+    var errorDescription: String? {
+        switch self {
+        case .collectionFailed:
+            return "Native ETFA kernel collection failed"
+        case .invalidFingerprint:
+            return "Invalid fingerprint ratios"
+        }
+    }
+}
+
 // MARK: - Objective-C Bridge
 
 extension ETFAModule {
@@ -15,6 +15,9 @@
 // eStream Mobile SDK - Post-quantum cryptography
 #import "estream_native.h"
 
+// eStream app native layer - tracing and native helpers (cpp/)
+#import "estream_app_native.h"
+
 #endif /* EstreamApp_Bridging_Header_h */
 
 
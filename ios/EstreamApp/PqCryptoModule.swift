@@ -52,17 +52,22 @@ class PqCryptoModule: NSObject {
     
     private var connectionHandle: Int = 0
     
+    /// Set once the first ratchet encrypt of the process has succeeded
+    private static var firstEncryptTraced = false
+    
     // MARK: - Initialization
     
     override init() {
         super.init()
         // Initialize the SDK (no QUIC, just crypto)
-        connectionHandle = Int(estream_initialize())
+        estream_trace_begin("estream_initialize")
+        connectionHandle = Int(estream_app_initialize())
+        estream_trace_end("estream_initialize")
         print("[PqCrypto] Initialized with handle: \(connectionHandle)")
     }
     
     deinit {
-        estream_dispose(Int(connectionHandle))
+        estream_app_dispose(Int(connectionHandle))
         print("[PqCrypto] Disposed")
     }
     
@@ -74,7 +79,7 @@ class PqCryptoModule: NSObject {
         _ resolve: @escaping RCTPromiseResolveBlock,
         rejecter reject: @escaping RCTPromiseRejectBlock
     ) {
-        let versionPtr = estream_version()
+        let versionPtr = estream_app_version()
         defer { estream_free_string(versionPtr) }
         
         if let ptr = versionPtr {
@@ -94,7 +99,7 @@ class PqCryptoModule: NSObject {
         print("[PqCrypto] generateDeviceKeys for scope: \(appScope)")
         
         let resultPtr = appScope.withCString { scopePtr in
-            estream_generate_device_keys(scopePtr)
+            estream_app_generate_device_keys(scopePtr)
         }
         defer { estream_free_string(resultPtr) }
         
@@ -152,7 +157,7 @@ class PqCryptoModule: NSObject {
         
         let resultPtr = sharedSecret.withUnsafeBytes { ssPtr in
             theirKem.withUnsafeBytes { kemPtr in
-                estream_ratchet_init_sender(
+                estream_app_ratchet_init_sender(
                     ssPtr.baseAddress?.assumingMemoryBound(to: UInt8.self),
                     kemPtr.baseAddress?.assumingMemoryBound(to: UInt8.self),
                     theirKem.count
@@ -180,7 +185,7 @@ class PqCryptoModule: NSObject {
         }
         
         let resultPtr = plaintextData.withUnsafeBytes { ptr in
-            estream_ratchet_encrypt(
+            estream_app_ratchet_encrypt(
                 Int(handle),
                 ptr.baseAddress?.assumingMemoryBound(to: UInt8.self),
                 plaintextData.count
@@ -188,7 +193,11 @@ class PqCryptoModule: NSObject {
         }
         defer { estream_free_string(resultPtr) }
         
-        parseFFIResult(resultPtr, resolve: resolve, reject: reject)
+        let ok = parseFFIResult(resultPtr, resolve: resolve, reject: reject)
+        if ok && !PqCryptoModule.firstEncryptTraced {
+            PqCryptoModule.firstEncryptTraced = true
+            estream_trace_instant("first_ratchet_encrypt")
+        }
     }
     
     /// Decrypt a message with Double Ratchet
@@ -202,7 +211,7 @@ class PqCryptoModule: NSObject {
         print("[PqCrypto] ratchetDecrypt handle=\(Int(handle))")
         
         let resultPtr = messageJson.withCString { msgPtr in
-            estream_ratchet_decrypt(Int(handle), msgPtr)
+            estream_app_ratchet_decrypt(Int(handle), msgPtr)
         }
         defer { estream_free_string(resultPtr) }
         
@@ -213,19 +222,20 @@ class PqCryptoModule: NSObject {
     @objc(ratchetDispose:)
     func ratchetDispose(_ handle: Double) {
         print("[PqCrypto] ratchetDispose handle=\(Int(handle))")
-        estream_ratchet_dispose(Int(handle))
+        estream_app_ratchet_dispose(Int(handle))
     }
     
     // MARK: - Helpers
     
+    @discardableResult
     private func parseFFIResult(
         _ resultPtr: UnsafeMutablePointer<CChar>?,
         resolve: @escaping RCTPromiseResolveBlock,
         reject: @escaping RCTPromiseRejectBlock
-    ) {
+    ) -> Bool {
         guard let ptr = resultPtr else {
             reject("FFI_ERROR", "Null result from FFI", nil)
-            return
+            return false
         }
         
         let jsonString = String(cString: ptr)
@@ -233,14 +243,16 @@ class PqCryptoModule: NSObject {
         guard let jsonData = jsonString.data(using: .utf8),
               let json = try? JSONSerialization.jsonObject(with: jsonData) as? [String: Any] else {
             reject("PARSE_ERROR", "Invalid JSON: \(jsonString)", nil)
-            return
+            return false
         }
         
         if let success = json["success"] as? Bool, success {
             resolve(json["data"] ?? json)
+            return true
         } else {
             let error = json["error"] as? String ?? "Unknown error"
             reject("FFI_ERROR", error, nil)
+            return false
         }
     }
 }
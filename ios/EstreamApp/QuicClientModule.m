@@ -60,5 +60,39 @@ RCT_EXTERN_METHOD(h3IsConnected:(RCTPromiseResolveBlock)resolve
 RCT_EXTERN_METHOD(h3Disconnect:(RCTPromiseResolveBlock)resolve
                   reject:(RCTPromiseRejectBlock)reject)
 
+// Latency
+RCT_EXTERN_METHOD(latencyReport:(RCTPromiseResolveBlock)resolve
+                  reject:(RCTPromiseRejectBlock)reject)
+
+// Runtime Profiling
+RCT_EXTERN_METHOD(setRuntimeProfiling:(BOOL)enabled)
+
+RCT_EXTERN_METHOD(runtimeStats:(RCTPromiseResolveBlock)resolve
+                  reject:(RCTPromiseRejectBlock)reject)
+
+// Resource Accounting
+RCT_EXTERN_METHOD(setResourceAccounting:(BOOL)enabled)
+
+RCT_EXTERN_METHOD(resourceUsage:(RCTPromiseResolveBlock)resolve
+                  reject:(RCTPromiseRejectBlock)reject)
+
+// Pre-warming
+RCT_EXTERN_METHOD(prewarmReport:(RCTPromiseResolveBlock)resolve
+                  reject:(RCTPromiseRejectBlock)reject)
+
+// Startup Tracing
+RCT_EXTERN_METHOD(traceComplete:(NSString *)name
+                  durationMs:(double)durationMs)
+
+RCT_EXTERN_METHOD(dumpTrace:(RCTPromiseResolveBlock)resolve
+                  reject:(RCTPromiseRejectBlock)reject)
+
+RCT_EXTERN_METHOD(traceStart:(NSString *)format
+                  resolve:(RCTPromiseResolveBlock)resolve
+                  reject:(RCTPromiseRejectBlock)reject)
+
+RCT_EXTERN_METHOD(traceStop:(RCTPromiseResolveBlock)resolve
+                  reject:(RCTPromiseRejectBlock)reject)
+
 @end
 
@@ -26,7 +26,11 @@ class QuicClientModule: NSObject {
   @objc
   func initialize(_ resolve: @escaping RCTPromiseResolveBlock,
                   reject: @escaping RCTPromiseRejectBlock) {
-    let handle = estream_initialize()
+    // Adopt the runtime created by estream_prewarm() at launch if it is ready
+    let prewarmed = estream_prewarm_take_handle(250)
+    estream_trace_begin("estream_initialize")
+    let handle = prewarmed >= 0 ? prewarmed : estream_app_initialize()
+    estream_trace_end("estream_initialize")
     
     if handle >= 0 {
       currentHandle = Int(handle)
@@ -48,7 +52,16 @@ class QuicClientModule: NSObject {
                nodeAddr: String,
                resolve: @escaping RCTPromiseResolveBlock,
                reject: @escaping RCTPromiseRejectBlock) {
-    guard let resultPtr = estream_connect(handle, nodeAddr) else {
+    if estream_prewarm_is_connected(handle, nodeAddr) == 1 {
+      estream_trace_instant("estream_connect_prewarmed")
+      resolve(["node_addr": nodeAddr, "prewarmed": true])
+      return
+    }
+    
+    estream_trace_begin("estream_connect")
+    let connectPtr = estream_app_connect(handle, nodeAddr)
+    estream_trace_end("estream_connect")
+    guard let resultPtr = connectPtr else {
       reject("CONNECT_ERROR", "Connection returned null", nil)
       return
     }
@@ -77,7 +90,7 @@ class QuicClientModule: NSObject {
   func generateDeviceKeys(_ appScope: String,
                           resolve: @escaping RCTPromiseResolveBlock,
                           reject: @escaping RCTPromiseRejectBlock) {
-    guard let resultPtr = estream_generate_device_keys(appScope) else {
+    guard let resultPtr = estream_app_generate_device_keys(appScope) else {
       reject("KEYGEN_ERROR", "Key generation returned null", nil)
       return
     }
@@ -111,7 +124,7 @@ class QuicClientModule: NSObject {
    */
   @objc
   func dispose(_ handle: Int) {
-    estream_dispose(handle)
+    estream_app_dispose(handle)
     if currentHandle == handle {
       currentHandle = -1
     }
@@ -136,7 +149,7 @@ class QuicClientModule: NSObject {
   @objc
   func getVersion(_ resolve: @escaping RCTPromiseResolveBlock,
                   reject: @escaping RCTPromiseRejectBlock) {
-    guard let versionPtr = estream_version() else {
+    guard let versionPtr = estream_app_version() else {
       reject("VERSION_ERROR", "Failed to get version", nil)
       return
     }
@@ -156,7 +169,7 @@ class QuicClientModule: NSObject {
   func h3Connect(_ serverAddr: String,
                  resolve: @escaping RCTPromiseResolveBlock,
                  reject: @escaping RCTPromiseRejectBlock) {
-    guard let resultPtr = estream_h3_connect(serverAddr) else {
+    guard let resultPtr = estream_app_h3_connect(serverAddr) else {
       reject("H3_ERROR", "H3 connect returned null", nil)
       return
     }
@@ -186,7 +199,7 @@ class QuicClientModule: NSObject {
               body: String,
               resolve: @escaping RCTPromiseResolveBlock,
               reject: @escaping RCTPromiseRejectBlock) {
-    guard let resultPtr = estream_h3_post(path, body) else {
+    guard let resultPtr = estream_app_h3_post(path, body) else {
       reject("H3_ERROR", "H3 POST returned null", nil)
       return
     }
@@ -214,7 +227,7 @@ class QuicClientModule: NSObject {
   func h3Get(_ path: String,
              resolve: @escaping RCTPromiseResolveBlock,
              reject: @escaping RCTPromiseRejectBlock) {
-    guard let resultPtr = estream_h3_get(path) else {
+    guard let resultPtr = estream_app_h3_get(path) else {
       reject("H3_ERROR", "H3 GET returned null", nil)
       return
     }
@@ -243,7 +256,7 @@ class QuicClientModule: NSObject {
                          trustLevel: String,
                          resolve: @escaping RCTPromiseResolveBlock,
                          reject: @escaping RCTPromiseRejectBlock) {
-    guard let resultPtr = estream_h3_mint_identity_nft(owner, trustLevel) else {
+    guard let resultPtr = estream_app_h3_mint_identity_nft(owner, trustLevel) else {
       reject("H3_ERROR", "H3 mint returned null", nil)
       return
     }
@@ -270,7 +283,7 @@ class QuicClientModule: NSObject {
   @objc
   func h3IsConnected(_ resolve: @escaping RCTPromiseResolveBlock,
                      reject: @escaping RCTPromiseRejectBlock) {
-    let connected = estream_h3_is_connected()
+    let connected = estream_app_h3_is_connected()
     resolve(connected == 1)
   }
   
@@ -280,8 +293,153 @@ class QuicClientModule: NSObject {
   @objc
   func h3Disconnect(_ resolve: @escaping RCTPromiseResolveBlock,
                     reject: @escaping RCTPromiseRejectBlock) {
-    estream_h3_disconnect()
+    estream_app_h3_disconnect()
     resolve(nil)
   }
+  
+  // MARK: - Latency
+  
+  /**
+   * Latency histogram summary (count, p50/p90/p99, ...) per FFI entry point.
+   */
+  @objc
+  func latencyReport(_ resolve: @escaping RCTPromiseResolveBlock,
+                     reject: @escaping RCTPromiseRejectBlock) {
+    guard let reportPtr = estream_latency_report() else {
+      reject("LATENCY_ERROR", "Latency report returned null", nil)
+      return
+    }
+    let report = String(cString: reportPtr)
+    estream_app_free_string(reportPtr)
+    resolve(report)
+  }
+  
+  // MARK: - Runtime Profiling
+  
+  /**
+   * Enable or disable lock contention / FFI concurrency profiling.
+   */
+  @objc
+  func setRuntimeProfiling(_ enabled: Bool) {
+    estream_runtime_profiling(enabled ? 1 : 0)
+  }
+  
+  /**
+   * Lock waits, FFI concurrency and Tokio worker CPU usage.
+   */
+  @objc
+  func runtimeStats(_ resolve: @escaping RCTPromiseResolveBlock,
+                    reject: @escaping RCTPromiseRejectBlock) {
+    guard let statsPtr = estream_runtime_stats() else {
+      reject("RUNTIME_STATS_ERROR", "Runtime stats returned null", nil)
+      return
+    }
+    let stats = String(cString: statsPtr)
+    estream_app_free_string(statsPtr)
+    resolve(stats)
+  }
+  
+  // MARK: - Resource Accounting
+  
+  /**
+   * Enable or disable per-subsystem CPU / wakeup accounting.
+   */
+  @objc
+  func setResourceAccounting(_ enabled: Bool) {
+    estream_resource_accounting(enabled ? 1 : 0)
+  }
+  
+  /**
+   * CPU time and wakeups per subsystem (crypto, transport, h3, ...).
+   */
+  @objc
+  func resourceUsage(_ resolve: @escaping RCTPromiseResolveBlock,
+                     reject: @escaping RCTPromiseRejectBlock) {
+    guard let usagePtr = estream_resource_usage() else {
+      reject("RESOURCE_USAGE_ERROR", "Resource usage returned null", nil)
+      return
+    }
+    let usage = String(cString: usagePtr)
+    estream_app_free_string(usagePtr)
+    resolve(usage)
+  }
+  
+  // MARK: - Pre-warming
+  
+  /**
+   * Per-step timings of the launch pre-warm (see AppDelegate).
+   */
+  @objc
+  func prewarmReport(_ resolve: @escaping RCTPromiseResolveBlock,
+                     reject: @escaping RCTPromiseRejectBlock) {
+    guard let reportPtr = estream_prewarm_report() else {
+      reject("PREWARM_ERROR", "Prewarm report returned null", nil)
+      return
+    }
+    let report = String(cString: reportPtr)
+    estream_app_free_string(reportPtr)
+    resolve(report)
+  }
+  
+  // MARK: - Startup Tracing
+  
+  /**
+   * Record a span timed in JS (e.g. snapshot restore) that ended just now.
+   * One complete event, since separate begin and end calls would run on
+   * different bridge threads.
+   */
+  @objc
+  func traceComplete(_ name: String, durationMs: Double) {
+    estream_trace_complete(name, UInt64(max(0, durationMs) * 1_000_000))
+  }
+  
+  /**
+   * Dump the native trace buffer as Chrome/Perfetto JSON.
+   * Resolves with the file path.
+   */
+  @objc
+  func dumpTrace(_ resolve: @escaping RCTPromiseResolveBlock,
+                 reject: @escaping RCTPromiseRejectBlock) {
+    let path = (NSTemporaryDirectory() as NSString).appendingPathComponent("estream-startup-trace.json")
+    if estream_trace_dump(path) < 0 {
+      reject("TRACE_ERROR", "Failed to write trace to \(path)", nil)
+      return
+    }
+    resolve(path)
+  }
+  
+  /**
+   * Start recording native spans to a trace file.
+   * format: "perfetto" for protobuf, anything else for Chrome JSON.
+   * Resolves with the file path.
+   */
+  @objc
+  func traceStart(_ format: String,
+                  resolve: @escaping RCTPromiseResolveBlock,
+                  reject: @escaping RCTPromiseRejectBlock) {
+    let perfetto = format == "perfetto"
+    let fileName = perfetto ? "estream-trace.pftrace" : "estream-trace.json"
+    let path = (NSTemporaryDirectory() as NSString).appendingPathComponent(fileName)
+    let traceFormat = perfetto ? ESTREAM_TRACE_FORMAT_PERFETTO : ESTREAM_TRACE_FORMAT_CHROME_JSON
+    if estream_trace_start(path, traceFormat) != 0 {
+      reject("TRACE_ERROR", "Trace session already active or \(path) not writable", nil)
+      return
+    }
+    resolve(path)
+  }
+  
+  /**
+   * Stop the trace session. Resolves with the number of events written.
+   */
+  @objc
+  func traceStop(_ resolve: @escaping RCTPromiseResolveBlock,
+                 reject: @escaping RCTPromiseRejectBlock) {
+    let written = estream_trace_stop()
+    if written < 0 {
+      reject("TRACE_ERROR", "No active trace session or write failed", nil)
+      return
+    }
+    resolve(written)
+  }
 }
 
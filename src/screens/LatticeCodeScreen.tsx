@@ -5,7 +5,7 @@
  * Can be used to share identity or verify device registration.
  */
 
-import React, { useRef, useEffect, useState } from 'react';
+import React, { useRef, useEffect, useMemo, useState } from 'react';
 import {
   View,
   Text,
@@ -13,6 +13,9 @@ import {
   TouchableOpacity,
   Dimensions,
   Platform,
+  requireNativeComponent,
+  UIManager,
+  ViewStyle,
 } from 'react-native';
 import { SafeAreaView } from 'react-native-safe-area-context';
 
@@ -29,6 +32,14 @@ import {
 // or react-native-canvas. For now, we render using React Native SVG.
 import Svg, { Circle, Path, G, Text as SvgText, Defs, RadialGradient, Stop } from 'react-native-svg';
 
+import {
+  createOrbitSet,
+  orbitPositions,
+  OrbitPositions,
+  OrbitSet,
+  setOrbit,
+} from '../services/sparkOrbits';
+
 interface LatticeCodeScreenProps {
   publicKey?: Uint8Array;
   displayName?: string;
@@ -37,6 +48,27 @@ interface LatticeCodeScreenProps {
 
 const { width: SCREEN_WIDTH } = Dimensions.get('window');
 const DISPLAY_SIZE = Math.min(SCREEN_WIDTH - 60, 300);
+const FRAME_MS = 50; // 20 FPS
+// Particle positions are evaluated this many frames ahead in one batch
+const BATCH_FRAMES = 20;
+
+// On Android, frames are rasterized natively (LatticeCodeView) and only
+// blitted, instead of re-rendering the SVG through React every tick
+const NATIVE_LATTICE =
+  Platform.OS === 'android' && UIManager.getViewManagerConfig?.('LatticeCodeView') != null;
+
+interface NativeLatticeScene {
+  baseHue: number;
+  ringSpeed: number;
+  heartbeatFreq: number;
+  hexCells: number[];
+  orbits: number[];
+  colors: number[];
+}
+
+const LatticeCodeView = NATIVE_LATTICE
+  ? requireNativeComponent<{ scene: NativeLatticeScene; style?: ViewStyle }>('LatticeCodeView')
+  : null;
 
 export function LatticeCodeScreen({ publicKey, displayName, onClose }: LatticeCodeScreenProps) {
   const [state, setState] = useState<LatticeCodeState | null>(null);
@@ -69,11 +101,14 @@ export function LatticeCodeScreen({ publicKey, displayName, onClose }: LatticeCo
     }
   }, [publicKey, displayName]);
   
-  // Animation loop
+  // Animation loop (the native renderer animates itself)
   useEffect(() => {
+    if (NATIVE_LATTICE) {
+      return;
+    }
     const interval = setInterval(() => {
       setElapsed(Date.now() - startTimeRef.current);
-    }, 50); // 20 FPS
+    }, FRAME_MS);
     
     return () => clearInterval(interval);
   }, []);
@@ -94,7 +129,11 @@ export function LatticeCodeScreen({ publicKey, displayName, onClose }: LatticeCo
       </View>
       
       <View style={styles.latticeContainer}>
-        <LatticeCodeSvg state={state} elapsed={elapsed} size={DISPLAY_SIZE} />
+        {LatticeCodeView ? (
+          <LatticeCodeNative state={state} size={DISPLAY_SIZE} view={LatticeCodeView} />
+        ) : (
+          <LatticeCodeSvg state={state} elapsed={elapsed} size={DISPLAY_SIZE} />
+        )}
       </View>
       
       <View style={styles.infoContainer}>
@@ -131,16 +170,13 @@ function LatticeCodeSvg({ state, elapsed, size }: {
   const CENTER = 150;
   const hue = (state.baseHue + (elapsed / 100) % 360) % 360;
   
-  // Get particle positions
-  const particles = state.particles.map((p, i) => {
-    const t = elapsed / 1000;
-    const angle = p.phase + t * p.orbitSpeed * p.direction;
-    let x = Math.cos(angle) * p.orbitRadius;
-    let y = Math.sin(angle) * p.orbitRadius;
-    x += Math.sin(t * p.pulseFrequency) * state.latticeVector[i % 8] * 5;
-    y += Math.cos(t * p.pulseFrequency) * state.latticeVector[(i + 4) % 8] * 5;
-    return { x: x + CENTER, y: y + CENTER, color: p.color };
-  });
+  // Particle positions for this frame, from a batch evaluated ahead
+  const orbits = useMemo(() => latticeOrbitSet(state, CENTER), [state]);
+  const batchRef = useRef<ParticleBatch | null>(null);
+  const frame = Math.floor(elapsed / FRAME_MS);
+  const batch = particleBatch(batchRef.current, orbits, frame);
+  batchRef.current = batch;
+  const at = (frame - batch.first) * orbits.count;
   
   // Hexagon centers
   const hexCenters = getHexCenters(CENTER);
@@ -176,18 +212,18 @@ function LatticeCodeSvg({ state, elapsed, size }: {
       ))}
       
       {/* Particles */}
-      {particles.map((p, i) => (
+      {state.particles.map((p, i) => (
         <G key={`particle-${i}`}>
           <Circle
-            cx={p.x}
-            cy={p.y}
+            cx={batch.positions.x[at + i]}
+            cy={batch.positions.y[at + i]}
             r={8}
             fill={p.color}
             opacity={0.3}
           />
           <Circle
-            cx={p.x}
-            cy={p.y}
+            cx={batch.positions.x[at + i]}
+            cy={batch.positions.y[at + i]}
             r={4}
             fill="#ffffff"
           />
@@ -209,6 +245,114 @@ function LatticeCodeSvg({ state, elapsed, size }: {
   );
 }
 
+// Native renderer: the pattern is passed once, the label is drawn on top
+function LatticeCodeNative({ state, size, view: NativeView }: {
+  state: LatticeCodeState;
+  size: number;
+  view: NonNullable<typeof LatticeCodeView>;
+}) {
+  const scene = useMemo(() => nativeLatticeScene(state), [state]);
+  const labelColor = `hsl(${state.baseHue % 360}, 70%, 70%)`;
+  return (
+    <View style={{ width: size, height: size }}>
+      <NativeView scene={scene} style={StyleSheet.absoluteFillObject} />
+      <View style={[StyleSheet.absoluteFillObject, styles.centerLabel]} pointerEvents="none">
+        <Text style={[styles.centerLabelText, { color: labelColor, fontSize: 10 * (size / 300) }]}>
+          ◆ eStream ◆
+        </Text>
+      </View>
+    </View>
+  );
+}
+
+function nativeLatticeScene(state: LatticeCodeState): NativeLatticeScene {
+  const set = latticeOrbitSet(state, 150);
+  const orbits: number[] = [];
+  for (const column of [
+    set.radius,
+    set.speed,
+    set.phase,
+    set.wobbleX,
+    set.wobbleXRate,
+    set.wobbleY,
+    set.wobbleYRate,
+  ]) {
+    orbits.push(...column);
+  }
+  return {
+    baseHue: state.baseHue,
+    ringSpeed: state.ringSpeed,
+    heartbeatFreq: state.heartbeatFreq,
+    hexCells: Array.from(state.hexCells, (cell) => cell || 0),
+    orbits,
+    colors: state.particles.map((p) => parseColor(p.color)),
+  };
+}
+
+// 0xRRGGBB of a CSS #rgb, #rrggbb, rgb() or hsl() color; white otherwise
+function parseColor(color: string): number {
+  const hex = /^#([0-9a-f]{3}|[0-9a-f]{6})$/i.exec(color.trim());
+  if (hex) {
+    const digits = hex[1].length === 3 ? hex[1].replace(/./g, '$&$&') : hex[1];
+    return parseInt(digits, 16);
+  }
+  const fn = /^(rgb|hsl)a?\(\s*([-\d.]+)(?:deg)?[\s,]+([-\d.]+)%?[\s,]+([-\d.]+)%?/i.exec(color.trim());
+  if (!fn) {
+    return 0xffffff;
+  }
+  const [a, b, c] = [Number(fn[2]), Number(fn[3]), Number(fn[4])];
+  if (fn[1].toLowerCase() === 'rgb') {
+    return (Math.round(a) << 16) | (Math.round(b) << 8) | Math.round(c);
+  }
+  const s = b / 100;
+  const l = c / 100;
+  const k = (n: number) => (((n + a / 30) % 12) + 12) % 12;
+  const f = (n: number) => l - s * Math.min(l, 1 - l) * Math.max(-1, Math.min(k(n) - 3, 9 - k(n), 1));
+  return (Math.round(f(0) * 255) << 16) | (Math.round(f(8) * 255) << 8) | Math.round(f(4) * 255);
+}
+
+// Orbits of the Lattice Code particles, in canvas pixels
+function latticeOrbitSet(state: LatticeCodeState, center: number): OrbitSet {
+  const set = createOrbitSet(state.particles.length, center, 1);
+  state.particles.forEach((p, i) =>
+    setOrbit(set, i, {
+      radius: p.orbitRadius,
+      speed: p.orbitSpeed * p.direction,
+      phase: p.phase,
+      wobbleX: state.latticeVector[i % 8] * 5,
+      wobbleXRate: p.pulseFrequency,
+      wobbleY: state.latticeVector[(i + 4) % 8] * 5,
+      wobbleYRate: p.pulseFrequency,
+    })
+  );
+  return set;
+}
+
+interface ParticleBatch {
+  orbits: OrbitSet;
+  first: number;
+  times: Float64Array;
+  positions: OrbitPositions;
+}
+
+// Positions of BATCH_FRAMES frames from `frame` on, refilled in place once
+// the animation leaves the current batch
+function particleBatch(batch: ParticleBatch | null, orbits: OrbitSet, frame: number): ParticleBatch {
+  if (batch && batch.orbits === orbits && frame >= batch.first && frame < batch.first + BATCH_FRAMES) {
+    return batch;
+  }
+  const times = batch?.times ?? new Float64Array(BATCH_FRAMES);
+  for (let k = 0; k < BATCH_FRAMES; k++) {
+    times[k] = (frame + k) * FRAME_MS;
+  }
+  return {
+    orbits,
+    first: frame,
+    times,
+    positions: orbitPositions(orbits, times, batch?.positions),
+  };
+}
+
 function TimingRing({ elapsed, hue, ringSpeed }: { 
   elapsed: number; 
   hue: number;
@@ -403,6 +547,13 @@ const styles = StyleSheet.create({
     fontSize: 16,
     color: '#8899aa',
   },
+  centerLabel: {
+    alignItems: 'center',
+    justifyContent: 'center',
+  },
+  centerLabelText: {
+    fontFamily: 'monospace',
+  },
   loadingText: {
     color: '#8899aa',
     fontSize: 16,
@@ -14,6 +14,9 @@
  * - Usage vs plan limits
  * - Cost estimates
  * 
+ * On-device:
+ * - Native crypto/request latency percentiles (estream_latency_report)
+ * 
  * Phase 8 redesign - new screen
  */
 
@@ -29,6 +32,7 @@ import {
 } from 'react-native';
 import { getNetworkEndpoints, getNetworkConfig } from '@estream/react-native';
 import { useAccount } from '@/services/account';
+import { getNativeLatency, NativeLatencyStats } from '@/services/quic/QuicClient';
 
 // ============================================================================
 // Types
@@ -60,6 +64,14 @@ interface UsageData {
   projectedCost: number;
 }
 
+/** Native entry points shown in the latency card */
+const LATENCY_ROWS: { fn: string; label: string }[] = [
+  { fn: 'estream_ratchet_encrypt', label: 'Encrypt' },
+  { fn: 'estream_ratchet_decrypt', label: 'Decrypt' },
+  { fn: 'estream_h3_post', label: 'H3 POST' },
+  { fn: 'estream_h3_get', label: 'H3 GET' },
+];
+
 // ============================================================================
 // Component
 // ============================================================================
@@ -92,6 +104,8 @@ export default function MetricsScreen(): React.JSX.Element {
     projectedCost: 0,
   });
 
+  const [nativeLatency, setNativeLatency] = useState<Record<string, NativeLatencyStats> | null>(null);
+
   const isOperator = account?.roles?.includes('operator') || account?.roles?.includes('admin');
   const networkConfig = getNetworkConfig();
 
@@ -142,6 +156,13 @@ export default function MetricsScreen(): React.JSX.Element {
         console.log('[MetricsScreen] Usage fetch error:', e);
       }
 
+      // On-device latency histograms from the native layer
+      try {
+        setNativeLatency(await getNativeLatency());
+      } catch (e) {
+        console.log('[MetricsScreen] Native latency error:', e);
+      }
+
       // Fetch network metrics (operator view)
       if (isOperator) {
         try {
@@ -355,6 +376,30 @@ export default function MetricsScreen(): React.JSX.Element {
           </Text>
         </View>
 
+        {/* On-Device Latency */}
+        {nativeLatency && (
+          <View style={styles.card}>
+            <Text style={styles.cardTitle}>On-Device Latency</Text>
+            <View style={styles.latencyRow}>
+              <Text style={[styles.latencyLabel, styles.latencyHeader]}>Call</Text>
+              <Text style={[styles.latencyValue, styles.latencyHeader]}>p50 ms</Text>
+              <Text style={[styles.latencyValue, styles.latencyHeader]}>p99 ms</Text>
+              <Text style={[styles.latencyValue, styles.latencyHeader]}>Count</Text>
+            </View>
+            {LATENCY_ROWS.map(({ fn, label }) => {
+              const stats = nativeLatency[fn];
+              return (
+                <View key={fn} style={styles.latencyRow}>
+                  <Text style={styles.latencyLabel}>{label}</Text>
+                  <Text style={styles.latencyValue}>{stats ? (stats.p50_us / 1000).toFixed(2) : '-'}</Text>
+                  <Text style={styles.latencyValue}>{stats ? (stats.p99_us / 1000).toFixed(2) : '-'}</Text>
+                  <Text style={styles.latencyValue}>{stats ? formatNumber(stats.count) : '0'}</Text>
+                </View>
+              );
+            })}
+          </View>
+        )}
+
         {/* Operator Section */}
         {isOperator && (
           <View style={styles.card}>
@@ -549,6 +594,29 @@ const styles = StyleSheet.create({
     marginTop: 12,
     textAlign: 'center',
   },
+  latencyRow: {
+    flexDirection: 'row',
+    alignItems: 'center',
+    paddingVertical: 8,
+    borderBottomWidth: 1,
+    borderBottomColor: '#2a2a2a',
+  },
+  latencyHeader: {
+    color: '#666',
+    fontSize: 12,
+  },
+  latencyLabel: {
+    flex: 2,
+    fontSize: 14,
+    color: '#888',
+  },
+  latencyValue: {
+    flex: 1,
+    fontSize: 14,
+    color: '#fff',
+    fontFamily: 'monospace',
+    textAlign: 'right',
+  },
   operatorRow: {
     flexDirection: 'row',
     justifyContent: 'space-between',
@@ -25,7 +25,7 @@ import {
 } from 'react-native';
 import { QrSigningService } from '@/services/governance';
 import { SparkService, SparkResolution } from '@/services/spark';
-import { RealSparkScanner, createSparkScanner } from '@/services/sparkScanner';
+import { RealSparkScanner, createSparkScanner, CAPTURE_INTERVAL_MS } from '@/services/sparkScanner';
 import { 
   isNativeSparkScannerAvailable, 
   startNativeScanning, 
@@ -468,7 +468,7 @@ function CameraView({ onCodeScanned, onStopCamera }: CameraViewProps): React.JSX
         
         isProcessingRef.current = false;
       }
-    }, 100); // 10 FPS frame analysis
+    }, CAPTURE_INTERVAL_MS);
   };
 
   if (!device) {
@@ -670,8 +670,8 @@ export default function ScanScreen(): React.JSX.Element {
     console.log('[ScanScreen] Processing data:', data.substring(0, 50) + '...');
 
     try {
-      // Try estream-sign:// protocol
-      if (data.startsWith('estream-sign://') || data.startsWith('estream://')) {
+      // Try estream-sign:// protocol (estream-signp:// frames of an animated code, either in upper case for v2)
+      if (/^estream-signp?:\/\//i.test(data) || data.startsWith('estream://')) {
         const success = await QrSigningService.processScannedQr(data);
         if (success) {
           Alert.alert('✅ Request Received', 'Governance request added. Go to Governance tab to approve.');
@@ -14,6 +14,22 @@ const NativeETFA = NativeModules.ETFAModule;
 // Event emitter for progress updates
 const etfaEmitter = NativeETFA ? new NativeEventEmitter(NativeETFA) : null;
 
+/**
+ * CPU ratios measured on one core cluster (big.LITTLE tier / Apple
+ * performance level). Cluster 0 is the fastest and supplies the top-level
+ * r5..r25 ratios.
+ */
+export interface ETFAClusterRatios {
+  id: number;
+  cpuCount: number;
+  // Measuring threads were pinned to the cluster's cores (never on iOS)
+  pinned: boolean;
+  // Samples dropped because the thread migrated off its core
+  migratedSamples: number;
+  // r5..r25 in stableRatios order (no GPU ratios)
+  stableRatios: number[];
+}
+
 /**
  * ETFA Fingerprint result from native collection
  */
@@ -47,8 +63,36 @@ export interface ETFAFingerprint {
   // All stable ratios as array
   stableRatios: number[];
   
+  // CPU ratios per core cluster, fastest first
+  clusters?: ETFAClusterRatios[];
+  
   // Hash of stable ratios for quick comparison
   fingerprintHash: string;
+  
+  // Quantized stable ratios (32 hex digits, one byte per ratio in
+  // 1/16-octave steps); drift changes single bytes, so compare with
+  // findNearest rather than string equality
+  fingerprintCode: string;
+}
+
+/**
+ * A stored reference fingerprint close to a query.
+ */
+export interface ETFAMatch {
+  id: string;
+  // Mean absolute log2 difference of the ratios (octaves)
+  distance: number;
+  // max(0, 1 - distance)
+  similarity: number;
+}
+
+export interface ETFANearestResult {
+  // References stored on this device
+  size: number;
+  // References compared (fewer than size once the index is partitioned)
+  scanned: number;
+  // Closest first
+  matches: ETFAMatch[];
 }
 
 /**
@@ -62,6 +106,7 @@ export interface ETFALatticeRecord {
   
   // Device identification
   deviceId: string;           // Hash of stable fingerprint
+  fingerprintCode?: string;   // Quantized ratios; absent in older records
   deviceModel: string;
   platform: 'android' | 'ios';
   platformVersion: string;
@@ -193,6 +238,48 @@ class ETFAServiceClass {
     }
   }
   
+  /**
+   * Store a fingerprint as the reference for a known device
+   * @returns Number of stored references, or -1 on failure
+   */
+  async addReference(id: string, fingerprint: ETFAFingerprint): Promise<number> {
+    if (!NativeETFA) return -1;
+    try {
+      return await NativeETFA.addReference(id, fingerprint.stableRatios);
+    } catch (e) {
+      console.error('[ETFA] Error adding reference:', e);
+      return -1;
+    }
+  }
+  
+  async removeReference(id: string): Promise<boolean> {
+    if (!NativeETFA) return false;
+    try {
+      return await NativeETFA.removeReference(id);
+    } catch (e) {
+      console.error('[ETFA] Error removing reference:', e);
+      return false;
+    }
+  }
+  
+  /**
+   * Find the stored references closest to a fingerprint (device
+   * re-identification that tolerates noisy ratios)
+   * @param k Number of matches to return
+   */
+  async findNearest(
+    fingerprint: ETFAFingerprint,
+    k: number = 1
+  ): Promise<ETFANearestResult | null> {
+    if (!NativeETFA) return null;
+    try {
+      return await NativeETFA.findNearest(fingerprint.stableRatios, k);
+    } catch (e) {
+      console.error('[ETFA] Error searching references:', e);
+      return null;
+    }
+  }
+  
   /**
    * Convert fingerprint to lattice record format
    */
@@ -206,6 +293,7 @@ class ETFAServiceClass {
       schemaVersion: '1.0.0',
       
       deviceId: fingerprint.fingerprintHash,
+      fingerprintCode: fingerprint.fingerprintCode,
       deviceModel: fingerprint.deviceModel,
       platform: fingerprint.platform,
       platformVersion: fingerprint.platformVersion,
@@ -17,18 +17,55 @@
  * Format:
  * - Request QR: estream-sign://v1/<base58-encoded-request>
  * - Response QR: estream-sig://v1/<base58-encoded-response>
+ *
+ * An ML-DSA-87 response (~4.6 KB signature) is too large for one QR code,
+ * so where the native QR transport is available it is shown as an animated
+ * QR code instead (see QrTransport.ts): an endless run of fountain-coded
+ * parts, any sufficient subset of which rebuilds the same JSON the single
+ * code would carry. Requests may arrive the same way.
+ * - Request part: estream-signp://v1/<base58-encoded-part>
+ * - Response part: estream-sigp://v1/<base58-encoded-part>
+ *
+ * Protocol v2 carries the same fields in a compact binary encoding (see
+ * cpp/src/qr_codec.h) as Base45 text, which QR codes hold in alphanumeric
+ * mode at 5.5 bits per character instead of 8. Scheme and version are
+ * upper case so the whole code stays alphanumeric; schemes are matched
+ * case-insensitively.
+ * - Request QR: ESTREAM-SIGN://V2/<base45-encoded-request>
+ * - Response QR: ESTREAM-SIG://V2/<base45-encoded-response>
+ * - Parts: ESTREAM-SIGNP://V2/..., ESTREAM-SIGP://V2/...
+ * A response uses the version of the request it answers.
  */
 
 import bs58 from 'bs58';
 import { Buffer } from 'buffer';
 import { GovernanceRequest, GovernanceSigningService, SigningResult } from './GovernanceSigningService';
+import {
+  QR_COMPACT_FRAGMENT_BYTES,
+  QR_FRAGMENT_BYTES,
+  QrPartDecoder,
+  QrScanProgress,
+  base45Decode,
+  base45Encode,
+  decodeCompactRequest,
+  encodeCompactResponse,
+  encodeQrParts,
+  isCompactCodecAvailable,
+  isQrTransportAvailable,
+} from './QrTransport';
 
-// QR protocol version
+// QR protocol versions
 const QR_PROTOCOL_VERSION = 1;
+const QR_COMPACT_PROTOCOL_VERSION = 2;
 
 // QR scheme prefixes
 const REQUEST_SCHEME = 'estream-sign';
 const RESPONSE_SCHEME = 'estream-sig';
+const REQUEST_PART_SCHEME = 'estream-signp';
+const RESPONSE_PART_SCHEME = 'estream-sigp';
+
+// Longest single QR code worth showing; larger responses are animated
+const SINGLE_QR_MAX_CHARS = 1000;
 
 /**
  * Parsed signing request from QR code
@@ -61,28 +98,24 @@ export interface QrSigningResponse {
  */
 export function parseSigningRequestQr(qrData: string): QrSigningRequest {
   // Expected format: estream-sign://v1/<base58-data>
-  if (!qrData.startsWith(`${REQUEST_SCHEME}://`)) {
-    throw new Error(`Invalid QR scheme. Expected ${REQUEST_SCHEME}://`);
-  }
-  
-  const parts = qrData.slice(`${REQUEST_SCHEME}://`.length).split('/');
-  if (parts.length !== 2) {
-    throw new Error('Invalid QR format. Expected v1/<data>');
-  }
-  
-  const versionStr = parts[0];
-  if (!versionStr.startsWith('v')) {
-    throw new Error('Invalid version format');
-  }
-  
-  const version = parseInt(versionStr.slice(1), 10);
-  if (version !== QR_PROTOCOL_VERSION) {
-    throw new Error(`Unsupported protocol version: ${version}`);
+  const { version, data } = parseQrData(qrData, REQUEST_SCHEME);
+  return parseSigningRequestMessage(version, data);
+}
+
+/**
+ * Parse a signing request from the bytes a request QR code carries, e.g.
+ * as reassembled from an animated QR code
+ */
+export function parseSigningRequestMessage(version: number, message: Uint8Array): QrSigningRequest {
+  if (version === QR_COMPACT_PROTOCOL_VERSION) {
+    const request = decodeCompactRequest(message);
+    return {
+      ...request,
+      version,
+      metadata: request.metadata ? JSON.parse(request.metadata) : undefined,
+    };
   }
-  
-  // Decode the base58 data
-  const encodedData = parts[1];
-  const jsonData = Buffer.from(bs58.decode(encodedData)).toString('utf-8');
+  const jsonData = Buffer.from(message).toString('utf-8');
   const request = JSON.parse(jsonData);
   
   return {
@@ -101,6 +134,43 @@ export function parseSigningRequestQr(qrData: string): QrSigningRequest {
  * Generate QR code data for a signing response
  */
 export function generateSigningResponseQr(response: QrSigningResponse): string {
+  return formatQrData(RESPONSE_SCHEME, response.version, encodeSigningResponse(response));
+}
+
+/**
+ * Generate animated QR frames for a signing response: `count` parts from
+ * part `firstSeq` (from 1). Keep requesting further parts for as long as
+ * the code is shown; the first `fragmentCount` carry the response as is and
+ * every later one helps a scanner that missed some.
+ */
+export function generateSigningResponseQrFrames(
+  response: QrSigningResponse,
+  firstSeq: number,
+  count: number
+): { fragmentCount: number; frames: string[] } {
+  const fragmentBytes =
+    response.version === QR_COMPACT_PROTOCOL_VERSION ? QR_COMPACT_FRAGMENT_BYTES : QR_FRAGMENT_BYTES;
+  const { fragmentCount, parts } = encodeQrParts(encodeSigningResponse(response), firstSeq, count, fragmentBytes);
+  return {
+    fragmentCount,
+    frames: parts.map((part) => formatQrData(RESPONSE_PART_SCHEME, response.version, part)),
+  };
+}
+
+/**
+ * The bytes a response QR code carries: UTF-8 JSON for v1, the compact
+ * encoding for v2
+ */
+function encodeSigningResponse(response: QrSigningResponse): Uint8Array {
+  if (response.version === QR_COMPACT_PROTOCOL_VERSION) {
+    return encodeCompactResponse(
+      response.requestId,
+      response.signature,
+      response.signerKeyHash,
+      response.algorithm,
+      response.timestamp
+    );
+  }
   const jsonData = JSON.stringify({
     id: response.requestId,
     sig: bs58.encode(response.signature),
@@ -108,9 +178,55 @@ export function generateSigningResponseQr(response: QrSigningResponse): string {
     alg: response.algorithm,
     ts: response.timestamp,
   });
+  return Buffer.from(jsonData, 'utf-8');
+}
+
+/**
+ * `<scheme>://v1/<base58-data>` or `<SCHEME>://V2/<base45-data>`
+ */
+function formatQrData(scheme: string, version: number, data: Uint8Array): string {
+  if (version === QR_COMPACT_PROTOCOL_VERSION) {
+    return `${scheme.toUpperCase()}://V${version}/${base45Encode(data)}`;
+  }
+  return `${scheme}://v${version}/${bs58.encode(data)}`;
+}
+
+/**
+ * Whether `qrData` starts with `<scheme>://`, in either case
+ */
+function hasScheme(qrData: string, scheme: string): boolean {
+  return qrData.slice(0, scheme.length + 3).toLowerCase() === `${scheme}://`;
+}
+
+/**
+ * Split `<scheme>://v<version>/<data>` and decode the data
+ */
+function parseQrData(qrData: string, scheme: string): { version: number; data: Uint8Array } {
+  if (!hasScheme(qrData, scheme)) {
+    throw new Error(`Invalid QR scheme. Expected ${scheme}://`);
+  }
+  
+  // Base45 data may itself contain '/'
+  const rest = qrData.slice(`${scheme}://`.length);
+  const slash = rest.indexOf('/');
+  if (slash < 0) {
+    throw new Error('Invalid QR format. Expected v1/<data>');
+  }
   
-  const encodedData = bs58.encode(Buffer.from(jsonData, 'utf-8'));
-  return `${RESPONSE_SCHEME}://v${response.version}/${encodedData}`;
+  const versionStr = rest.slice(0, slash);
+  if (!/^v\d+$/i.test(versionStr)) {
+    throw new Error('Invalid version format');
+  }
+  
+  const version = parseInt(versionStr.slice(1), 10);
+  const encoded = rest.slice(slash + 1);
+  if (version === QR_PROTOCOL_VERSION) {
+    return { version, data: bs58.decode(encoded) };
+  }
+  if (version === QR_COMPACT_PROTOCOL_VERSION && isCompactCodecAvailable()) {
+    return { version, data: base45Decode(encoded) };
+  }
+  throw new Error(`Unsupported protocol version: ${version}`);
 }
 
 /**
@@ -129,11 +245,12 @@ export function qrToGovernanceRequest(qr: QrSigningRequest): GovernanceRequest {
 }
 
 /**
- * Convert SigningResult to QR response
+ * Convert SigningResult to QR response, in protocol `version` (that of the
+ * request it answers)
  */
-export function signingResultToQr(result: SigningResult): QrSigningResponse {
+export function signingResultToQr(result: SigningResult, version: number = QR_PROTOCOL_VERSION): QrSigningResponse {
   return {
-    version: QR_PROTOCOL_VERSION,
+    version,
     requestId: result.requestId,
     signature: result.signature,
     signerKeyHash: result.signerKeyHash,
@@ -149,15 +266,28 @@ export function signingResultToQr(result: SigningResult): QrSigningResponse {
  */
 class QrSigningServiceImpl {
   private pendingQrResponse: QrSigningResponse | null = null;
+  private partDecoder: QrPartDecoder | null = null;
+  private scanProgress: QrScanProgress | null = null;
+  // Protocol version of each scanned request, by request id
+  private requestVersions = new Map<string, number>();
   
   /**
    * Process a scanned QR code
-   * Returns true if it was a valid signing request
+   * Returns true if it was a valid signing request; a frame of an animated
+   * request returns false until the request is complete
    */
   async processScannedQr(qrData: string): Promise<boolean> {
     try {
+      if (hasScheme(qrData, REQUEST_PART_SCHEME)) {
+        const qrRequest = this.receiveRequestPart(qrData);
+        if (qrRequest) {
+          this.addRequest(qrRequest);
+        }
+        return qrRequest !== null;
+      }
+      
       // Check if it's a signing request
-      if (!qrData.startsWith(`${REQUEST_SCHEME}://`)) {
+      if (!hasScheme(qrData, REQUEST_SCHEME)) {
         console.log('[QrSigning] Not a signing request QR');
         return false;
       }
@@ -165,19 +295,7 @@ class QrSigningServiceImpl {
       console.log('[QrSigning] Processing signing request QR...');
       
       // Parse the request
-      const qrRequest = parseSigningRequestQr(qrData);
-      
-      // Check expiration
-      if (Date.now() > qrRequest.expiresAt) {
-        console.warn('[QrSigning] Request has expired');
-        throw new Error('Signing request has expired');
-      }
-      
-      // Convert to GovernanceRequest and add to pending
-      const govRequest = qrToGovernanceRequest(qrRequest);
-      GovernanceSigningService.addRequest(govRequest);
-      
-      console.log('[QrSigning] Request added for approval:', qrRequest.id);
+      this.addRequest(parseSigningRequestQr(qrData));
       return true;
     } catch (error) {
       console.error('[QrSigning] Failed to process QR:', error);
@@ -185,11 +303,74 @@ class QrSigningServiceImpl {
     }
   }
   
+  /**
+   * Progress of the animated request being scanned, or null if none
+   */
+  getScanProgress(): QrScanProgress | null {
+    return this.scanProgress;
+  }
+  
+  /**
+   * Abandon the animated request being scanned
+   */
+  cancelScan(): void {
+    this.partDecoder?.destroy();
+    this.partDecoder = null;
+    this.scanProgress = null;
+  }
+  
+  /**
+   * Add one frame of an animated request; the request once complete
+   */
+  private receiveRequestPart(qrData: string): QrSigningRequest | null {
+    const { version, data } = parseQrData(qrData, REQUEST_PART_SCHEME);
+    if (!this.partDecoder) {
+      this.partDecoder = new QrPartDecoder();
+    }
+    let progress: QrScanProgress;
+    try {
+      progress = this.partDecoder.receive(data);
+    } catch {
+      // A frame of another request: start over with it
+      this.partDecoder.reset();
+      progress = this.partDecoder.receive(data);
+    }
+    this.scanProgress = progress;
+    if (progress.corrupt) {
+      this.cancelScan();
+      throw new Error('Animated QR request failed its checksum');
+    }
+    const message = progress.complete ? this.partDecoder.message() : null;
+    if (!message) {
+      return null;
+    }
+    console.log(`[QrSigning] Animated request complete after ${progress.partsReceived} frames`);
+    this.cancelScan();
+    return parseSigningRequestMessage(version, message);
+  }
+  
+  private addRequest(qrRequest: QrSigningRequest): void {
+    // Check expiration
+    if (Date.now() > qrRequest.expiresAt) {
+      console.warn('[QrSigning] Request has expired');
+      throw new Error('Signing request has expired');
+    }
+    
+    // Convert to GovernanceRequest and add to pending
+    const govRequest = qrToGovernanceRequest(qrRequest);
+    GovernanceSigningService.addRequest(govRequest);
+    this.requestVersions.set(qrRequest.id, qrRequest.version);
+    
+    console.log('[QrSigning] Request added for approval:', qrRequest.id);
+  }
+  
   /**
    * Set the pending response (called after user signs)
    */
   setPendingResponse(result: SigningResult): void {
-    this.pendingQrResponse = signingResultToQr(result);
+    const version = this.requestVersions.get(result.requestId) ?? QR_PROTOCOL_VERSION;
+    this.requestVersions.delete(result.requestId);
+    this.pendingQrResponse = signingResultToQr(result, version);
     console.log('[QrSigning] Response ready for QR display');
   }
   
@@ -203,6 +384,23 @@ class QrSigningServiceImpl {
     return generateSigningResponseQr(this.pendingQrResponse);
   }
   
+  /**
+   * Get the next `count` frames of the response QR code from frame
+   * `firstSeq` (from 1). A response small enough for one QR code, or any
+   * response where animated codes are unavailable, is the single frame of
+   * getResponseQrData().
+   */
+  getResponseQrFrames(firstSeq: number, count: number): string[] | null {
+    if (!this.pendingQrResponse) {
+      return null;
+    }
+    const single = generateSigningResponseQr(this.pendingQrResponse);
+    if (single.length <= SINGLE_QR_MAX_CHARS || !isQrTransportAvailable()) {
+      return [single];
+    }
+    return generateSigningResponseQrFrames(this.pendingQrResponse, firstSeq, count).frames;
+  }
+  
   /**
    * Clear the pending response
    */
@@ -231,6 +429,9 @@ export const QrSigningService = new QrSigningServiceImpl();
 // Export protocol constants for CLI
 export const QR_PROTOCOL = {
   VERSION: QR_PROTOCOL_VERSION,
+  COMPACT_VERSION: QR_COMPACT_PROTOCOL_VERSION,
   REQUEST_SCHEME,
   RESPONSE_SCHEME,
+  REQUEST_PART_SCHEME,
+  RESPONSE_PART_SCHEME,
 };
@@ -0,0 +1,217 @@
+/**
+ * QR Transport
+ *
+ * Fountain-coded animated QR codes for payloads that do not fit one QR code.
+ * A message is split into K fragments and sent as an endless run of parts,
+ * one per frame: parts 1..K carry the fragments, later parts mix them, and
+ * any K independent parts (typically K + 1 or 2 of those scanned, whatever
+ * was missed) rebuild it.
+ *
+ * Encoding and decoding run natively (QrTransport module, Android only; see
+ * cpp/src/fountain.h for the part format). Callers fall back to single QR
+ * codes where it is unavailable.
+ *
+ * The same module provides the compact protocol v2 encoding of signing
+ * requests and responses (cpp/src/qr_codec.h) and Base45, its text form in
+ * QR alphanumeric mode.
+ */
+
+import { NativeModules, Platform } from 'react-native';
+import { Buffer } from 'buffer';
+
+const { QrTransport } = NativeModules;
+
+/** Fragment size: a base58 part fits a version 10 QR code at level M. */
+export const QR_FRAGMENT_BYTES = 120;
+
+/** Fragment size for v2: a Base45 part fits a version 10 QR code at level M. */
+export const QR_COMPACT_FRAGMENT_BYTES = 176;
+
+/**
+ * Progress of an animated QR scan
+ */
+export interface QrScanProgress {
+  complete: boolean;
+  /** All parts decoded but the message failed its checksum */
+  corrupt: boolean;
+  fragments: number;
+  recovered: number;
+  partsReceived: number;
+  partsDuplicate: number;
+  /** recovered / fragments, 0-1 */
+  progress: number;
+}
+
+/**
+ * Whether animated QR codes can be encoded and decoded here
+ */
+export function isQrTransportAvailable(): boolean {
+  return Platform.OS === 'android' && QrTransport?.encodeParts != null;
+}
+
+/**
+ * Encode `count` consecutive parts of `message` from part `firstSeq` (from
+ * 1). Returns the fragment count K and the binary parts.
+ */
+export function encodeQrParts(
+  message: Uint8Array,
+  firstSeq: number,
+  count: number,
+  fragmentBytes: number = QR_FRAGMENT_BYTES
+): { fragmentCount: number; parts: Uint8Array[] } {
+  if (!isQrTransportAvailable()) {
+    throw new Error('Animated QR transport is not available on this platform');
+  }
+  const result = QrTransport.encodeParts(
+    Buffer.from(message).toString('base64'),
+    fragmentBytes,
+    firstSeq,
+    count
+  );
+  if (result == null) {
+    throw new Error('Failed to encode QR parts');
+  }
+  return {
+    fragmentCount: result.fragmentCount,
+    parts: (result.parts as string[]).map((part) => new Uint8Array(Buffer.from(part, 'base64'))),
+  };
+}
+
+/**
+ * Collects scanned parts until the message is recovered. Call destroy()
+ * when done.
+ */
+export class QrPartDecoder {
+  private handle: number;
+
+  constructor() {
+    if (!isQrTransportAvailable()) {
+      throw new Error('Animated QR transport is not available on this platform');
+    }
+    this.handle = QrTransport.createDecoder();
+  }
+
+  /**
+   * Add a scanned part. Throws if it is malformed or belongs to another
+   * message than the parts before it.
+   */
+  receive(part: Uint8Array): QrScanProgress {
+    const status = QrTransport.decoderReceive(this.handle, Buffer.from(part).toString('base64'));
+    if (status == null) {
+      throw new Error('QR decoder has been destroyed');
+    }
+    if (status.result < 0) {
+      throw new Error('QR part is invalid or from another message');
+    }
+    const { result: _result, ...progress } = status;
+    return progress as QrScanProgress;
+  }
+
+  /**
+   * The recovered message, or null until complete
+   */
+  message(): Uint8Array | null {
+    const base64 = QrTransport.decoderMessage(this.handle);
+    return base64 == null ? null : new Uint8Array(Buffer.from(base64, 'base64'));
+  }
+
+  /**
+   * Drop collected parts, to scan another message
+   */
+  reset(): void {
+    QrTransport.resetDecoder(this.handle);
+  }
+
+  destroy(): void {
+    QrTransport.destroyDecoder(this.handle);
+  }
+}
+
+/**
+ * A signing request as decoded from a v2 message
+ */
+export interface CompactSigningRequest {
+  id: string;
+  operation: string;
+  description: string;
+  payload: Uint8Array;
+  timestamp: number;
+  expiresAt: number;
+  /** JSON text, '' if none */
+  metadata: string;
+}
+
+/**
+ * Whether the compact v2 encoding is available here
+ */
+export function isCompactCodecAvailable(): boolean {
+  return Platform.OS === 'android' && QrTransport?.encodeCompactResponse != null;
+}
+
+/**
+ * Encode a signing response as a v2 message
+ */
+export function encodeCompactResponse(
+  requestId: string,
+  signature: Uint8Array,
+  signerKeyHash: Uint8Array,
+  algorithm: string,
+  timestamp: number
+): Uint8Array {
+  if (!isCompactCodecAvailable()) {
+    throw new Error('Compact QR encoding is not available on this platform');
+  }
+  const base64 = QrTransport.encodeCompactResponse(
+    requestId,
+    Buffer.from(signature).toString('base64'),
+    Buffer.from(signerKeyHash).toString('base64'),
+    algorithm,
+    timestamp
+  );
+  if (base64 == null) {
+    throw new Error('Failed to encode signing response');
+  }
+  return new Uint8Array(Buffer.from(base64, 'base64'));
+}
+
+/**
+ * Decode a v2 signing request message
+ */
+export function decodeCompactRequest(message: Uint8Array): CompactSigningRequest {
+  if (!isCompactCodecAvailable()) {
+    throw new Error('Compact QR encoding is not available on this platform');
+  }
+  const request = QrTransport.decodeCompactRequest(Buffer.from(message).toString('base64'));
+  if (request == null) {
+    throw new Error('Malformed signing request');
+  }
+  return { ...request, payload: new Uint8Array(Buffer.from(request.payload, 'base64')) };
+}
+
+/**
+ * Base45 (RFC 9285) text of `data`
+ */
+export function base45Encode(data: Uint8Array): string {
+  if (!isCompactCodecAvailable()) {
+    throw new Error('Compact QR encoding is not available on this platform');
+  }
+  const text = QrTransport.base45Encode(Buffer.from(data).toString('base64'));
+  if (text == null) {
+    throw new Error('Failed to encode Base45');
+  }
+  return text;
+}
+
+/**
+ * The bytes of Base45 `text`
+ */
+export function base45Decode(text: string): Uint8Array {
+  if (!isCompactCodecAvailable()) {
+    throw new Error('Compact QR encoding is not available on this platform');
+  }
+  const base64 = QrTransport.base45Decode(text);
+  if (base64 == null) {
+    throw new Error('Invalid Base45 data');
+  }
+  return new Uint8Array(Buffer.from(base64, 'base64'));
+}
@@ -7,8 +7,9 @@
  * - Request signing: POST /sign
  * - Check status: GET /status/:requestId
  * 
- * Uses react-native's fetch polyfill for the server-side.
- * In production, this would use a native HTTP server module.
+ * On Android the HTTP server is native (SigningServerModule, backed by
+ * cpp/src/signing_server.cpp): /health and /status are answered without
+ * reaching JS, and /sign requests arrive here as onSigningRequest events.
  */
 
 import { Platform, NativeModules, DeviceEventEmitter, NativeEventEmitter } from 'react-native';
@@ -25,6 +26,8 @@ interface SigningServerNative {
   getPendingRequests(): Promise<string[]>;
   markSigned(requestId: string, signatureB58: string, keyHashB58: string): Promise<boolean>;
   markRejected(requestId: string, reason: string): Promise<boolean>;
+  /** Connection, HTTP and queue counters as JSON, or null when stopped. */
+  getStats(): Promise<string | null>;
 }
 
 const SigningServerNative: SigningServerNative | null = 
@@ -314,6 +317,21 @@ class SigningServerManager {
     };
   }
   
+  /**
+   * Native server counters: connections, keep-alive reuse, per-route
+   * request counts and the request queue. Null when unavailable.
+   */
+  async getServerStats(): Promise<Record<string, unknown> | null> {
+    if (!SigningServerNative) return null;
+    try {
+      const statsJson = await SigningServerNative.getStats();
+      return statsJson ? JSON.parse(statsJson) : null;
+    } catch (error) {
+      console.warn('[SigningServer] Failed to read server stats:', error);
+      return null;
+    }
+  }
+  
   /**
    * Get local IP address for CLI discovery
    */
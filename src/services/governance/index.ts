@@ -25,9 +25,26 @@ export {
   QrSigningService,
   QR_PROTOCOL,
   parseSigningRequestQr,
+  parseSigningRequestMessage,
   generateSigningResponseQr,
+  generateSigningResponseQrFrames,
   qrToGovernanceRequest,
   signingResultToQr,
   type QrSigningRequest,
   type QrSigningResponse,
 } from './QrSigningService';
+
+export {
+  QrPartDecoder,
+  QR_FRAGMENT_BYTES,
+  QR_COMPACT_FRAGMENT_BYTES,
+  encodeQrParts,
+  isQrTransportAvailable,
+  isCompactCodecAvailable,
+  encodeCompactResponse,
+  decodeCompactRequest,
+  base45Encode,
+  base45Decode,
+  type QrScanProgress,
+  type CompactSigningRequest,
+} from './QrTransport';
@@ -5,7 +5,7 @@
  */
 
 import AsyncStorage from '@react-native-async-storage/async-storage';
-import { QuicMessagingClient, PqWireMessage, DevicePublicKeys } from '../quic/QuicClient';
+import { QuicMessagingClient, PqWireMessage, DevicePublicKeys, traceSpan } from '../quic/QuicClient';
 import { Message, Conversation, MessageStatus, MessagingEvent } from './types';
 
 const STORAGE_PREFIX = '@estream:messaging:';
@@ -38,8 +38,11 @@ export class MessagingService {
     await this.quicClient.connect();
     console.log('[MessagingService] QUIC connected to node');
     
-    await this.loadConversations();
-    await this.loadMessageQueue();
+    // Snapshot restore shows up in the native startup trace (iOS)
+    await traceSpan('snapshot_restore', async () => {
+      await this.loadConversations();
+      await this.loadMessageQueue();
+    });
     
     this.startBackgroundSync();
     this.startMessageReceiver();
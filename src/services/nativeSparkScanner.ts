@@ -9,6 +9,19 @@ import { NativeModules, Platform } from 'react-native';
 
 const { SparkScanner } = NativeModules;
 
+/**
+ * Native liveness verification of the scan (startNativeLiveness). The
+ * decision leaves 'pending' as soon as it is statistically certain.
+ */
+export interface LivenessStatus {
+  decision: 'pending' | 'live' | 'not_live';
+  trajectoryScore: number;
+  frames: number;
+  // Confidence interval of the match rate
+  lowerBound: number;
+  upperBound: number;
+}
+
 export interface ScanResult {
   success: boolean;
   sparkDetected: boolean;
@@ -16,6 +29,10 @@ export interface ScanResult {
   durationMs: number;
   motionScore: number;
   direction: 'cw' | 'ccw' | 'mixed' | 'insufficient' | 'no_motion' | 'scanning';
+  // Frames skipped because analysis fell behind the camera (only the
+  // newest frame is analyzed)
+  framesDropped?: number;
+  liveness?: LivenessStatus;
 }
 
 export interface ScanStatus {
@@ -25,6 +42,13 @@ export interface ScanStatus {
   progress: number;
   motionScore: number;
   motionDetected: boolean;
+  framesDropped?: number;
+  // Native analysis runs at 1/analysisScale resolution to hold its
+  // latency target
+  analysisScale?: number;
+  // Capture to result, smoothed
+  latencyMs?: number;
+  liveness?: LivenessStatus;
 }
 
 /**
@@ -45,6 +69,18 @@ export async function startNativeScanning(): Promise<{ success: boolean; status:
   return SparkScanner.startScanning();
 }
 
+/**
+ * Verify the running scan against the Spark pattern of `pubkeyBase64` and
+ * `timestamp` (as in verifyLiveness), frame by frame in native code
+ */
+export async function startNativeLiveness(pubkeyBase64: string, timestamp: number): Promise<boolean> {
+  if (!isNativeSparkScannerAvailable()) {
+    throw new Error('Native SparkScanner not available');
+  }
+  
+  return SparkScanner.startLiveness(pubkeyBase64, timestamp);
+}
+
 /**
  * Stop scanning and get results
  */
@@ -87,6 +123,7 @@ export function useNativeSparkScanner() {
   return {
     isAvailable,
     startScanning: startNativeScanning,
+    startLiveness: startNativeLiveness,
     stopScanning: stopNativeScanning,
     getStatus: getNativeScanStatus,
     reset: resetNativeScanner,
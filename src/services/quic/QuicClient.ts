@@ -272,3 +272,180 @@ export function getH3Client(serverAddr: string = '10.0.0.120:8443'): H3Client {
   return new H3Client(serverAddr);
 }
 
+
+// ============================================================================
+// Native Startup Tracing
+// ============================================================================
+
+/**
+ * Run `fn` and record it in the native trace buffer as one complete
+ * span. Timed here rather than with separate begin/end calls, which
+ * reach native code on different bridge threads and would not pair up.
+ * Just runs `fn` where the native tracing methods are not linked
+ * (Android, tests).
+ */
+export async function traceSpan<T>(name: string, fn: () => Promise<T>): Promise<T> {
+  const start = Date.now();
+  try {
+    return await fn();
+  } finally {
+    NativeQuicClient?.traceComplete?.(name, Date.now() - start);
+  }
+}
+
+/**
+ * Write the native trace buffer as Chrome/Perfetto JSON.
+ * @returns Path of the trace file, or null when tracing is unavailable
+ */
+export async function dumpNativeTrace(): Promise<string | null> {
+  if (!NativeQuicClient?.dumpTrace) {
+    return null;
+  }
+  return NativeQuicClient.dumpTrace();
+}
+
+/**
+ * Start recording native spans to a trace file (iOS).
+ * @returns Path of the trace file, or null when unavailable
+ */
+export async function startNativeTrace(format: 'json' | 'perfetto' = 'perfetto'): Promise<string | null> {
+  if (!NativeQuicClient?.traceStart) {
+    return null;
+  }
+  return NativeQuicClient.traceStart(format);
+}
+
+/**
+ * Stop the native trace session.
+ * @returns Number of events written, or null when unavailable
+ */
+export async function stopNativeTrace(): Promise<number | null> {
+  if (!NativeQuicClient?.traceStop) {
+    return null;
+  }
+  return NativeQuicClient.traceStop();
+}
+
+// ============================================================================
+// Native Latency Histograms
+// ============================================================================
+
+export interface NativeLatencyStats {
+  count: number;
+  min_us: number;
+  mean_us: number;
+  p50_us: number;
+  p90_us: number;
+  p99_us: number;
+  p999_us: number;
+  max_us: number;
+}
+
+/**
+ * Latency histograms per native entry point, keyed by estream_native.h
+ * function name (e.g. "estream_ratchet_encrypt").
+ * @returns Stats per function, or null when unavailable
+ */
+export async function getNativeLatency(): Promise<Record<string, NativeLatencyStats> | null> {
+  if (!NativeQuicClient?.latencyReport) {
+    return null;
+  }
+  const report = JSON.parse(await NativeQuicClient.latencyReport());
+  return report.success ? report.data : null;
+}
+
+// ============================================================================
+// Native Runtime Profiling
+// ============================================================================
+
+export interface NativeLockStats {
+  name: string;
+  acquisitions: number;
+  contended: number;
+  wait_total_us: number;
+  wait_p50_us: number;
+  wait_p99_us: number;
+  wait_max_us: number;
+}
+
+export interface NativeWorkerStats {
+  tid: number;
+  name: string;
+  cpu_us: number;
+  voluntary_switches: number;
+  involuntary_switches: number;
+  /** CPU share since the previous getNativeRuntimeStats() call, 0-1000 */
+  busy_permille?: number;
+}
+
+export interface NativeRuntimeStats {
+  profiling: boolean;
+  locks: NativeLockStats[];
+  ffi: {
+    calls: number;
+    in_flight: number;
+    max_in_flight: number;
+    overlapped_calls: number;
+    busy_us: number;
+  };
+  workers: NativeWorkerStats[];
+  threads: number;
+}
+
+/**
+ * Enable or disable native lock/FFI contention profiling.
+ */
+export function setNativeRuntimeProfiling(enabled: boolean): void {
+  NativeQuicClient?.setRuntimeProfiling?.(enabled);
+}
+
+/**
+ * Lock contention, FFI concurrency and Tokio worker thread statistics.
+ * @returns Stats, or null when unavailable
+ */
+export async function getNativeRuntimeStats(): Promise<NativeRuntimeStats | null> {
+  if (!NativeQuicClient?.runtimeStats) {
+    return null;
+  }
+  const report = JSON.parse(await NativeQuicClient.runtimeStats());
+  return report.success ? report.data : null;
+}
+
+// ============================================================================
+// Native Resource Accounting
+// ============================================================================
+
+export interface NativeCpuUsage {
+  cpu_us: number;
+  /** Voluntary context switches; 0 on iOS */
+  wakeups: number;
+}
+
+export interface NativeResourceUsage {
+  accounting: boolean;
+  subsystems: Record<
+    'crypto' | 'transport' | 'h3',
+    NativeCpuUsage & { scopes: number }
+  >;
+  runtime_workers: NativeCpuUsage & { threads: number };
+  process: NativeCpuUsage;
+}
+
+/**
+ * Enable or disable native per-subsystem CPU accounting.
+ */
+export function setNativeResourceAccounting(enabled: boolean): void {
+  NativeQuicClient?.setResourceAccounting?.(enabled);
+}
+
+/**
+ * CPU time and wakeups per native subsystem.
+ * @returns Usage, or null when unavailable
+ */
+export async function getNativeResourceUsage(): Promise<NativeResourceUsage | null> {
+  if (!NativeQuicClient?.resourceUsage) {
+    return null;
+  }
+  const report = JSON.parse(await NativeQuicClient.resourceUsage());
+  return report.success ? report.data : null;
+}
@@ -8,6 +8,11 @@
  * The derivation must match Mission Control exactly for liveness verification.
  */
 
+import { deriveMotionSeed } from './sparkDerivation';
+import { createOrbitSet, orbitPositions, OrbitSet, setOrbit } from './sparkOrbits';
+
+export { deriveMotionSeed };
+
 const PI = Math.PI;
 const PARTICLE_COUNT = 12;
 const MIN_CAPTURE_DURATION_MS = 2000;
@@ -53,7 +58,7 @@ export interface VerificationResult {
   errors: string[];
 }
 
-interface ParticleParams {
+export interface ParticleParams {
   radius: number;
   speed: number;
   phase: number;
@@ -65,51 +70,6 @@ interface ParticleParams {
 // Motion Derivation (matches Mission Control's spark.ts)
 // ============================================================================
 
-/**
- * Derive motion seed from public key and timestamp
- * This mirrors the Mission Control renderer
- */
-export function deriveMotionSeed(pubkeyBytes: Uint8Array, timestamp: number): Uint8Array {
-  // Use the same deriveBytes function as Mission Control
-  return deriveBytes(pubkeyBytes.slice(0, 64), 'spark-motion-' + timestamp, 64);
-}
-
-/**
- * Simple hash for deterministic derivation (matches Mission Control)
- */
-function simpleHash256(bytes: Uint8Array): Uint8Array {
-  const result = new Uint8Array(32);
-  for (let i = 0; i < 32; i++) {
-    let h = i * 0x9e3779b9;
-    for (let j = 0; j < bytes.length; j++) {
-      h = ((h << 5) + h + bytes[j]) >>> 0;
-    }
-    result[i] = h & 0xff;
-  }
-  return result;
-}
-
-/**
- * Derive bytes using HKDF-like expansion (matches Mission Control)
- */
-function deriveBytes(key: Uint8Array, info: string, length: number): Uint8Array {
-  const result = new Uint8Array(length);
-  const infoBytes = new TextEncoder().encode(info);
-  
-  for (let block = 0; block < Math.ceil(length / 32); block++) {
-    const input = new Uint8Array(key.length + infoBytes.length + 1);
-    input.set(key);
-    input.set(infoBytes, key.length);
-    input[key.length + infoBytes.length] = block;
-    
-    const hash = simpleHash256(input);
-    const offset = block * 32;
-    const toCopy = Math.min(32, length - offset);
-    result.set(hash.slice(0, toCopy), offset);
-  }
-  return result;
-}
-
 /**
  * Derive parameters for a specific particle
  */
@@ -146,6 +106,26 @@ export function getExpectedPosition(params: ParticleParams, elapsedMs: number):
   };
 }
 
+/**
+ * The particles' orbits as an OrbitSet on the 300px canvas, normalized to
+ * 0-1, for evaluating many frames at once (orbitPositions)
+ */
+export function sparkOrbitSet(particles: ParticleParams[]): OrbitSet {
+  const set = createOrbitSet(particles.length, 150, 300);
+  particles.forEach((p, i) =>
+    setOrbit(set, i, {
+      radius: p.radius,
+      speed: p.speed * p.direction,
+      phase: p.phase,
+      wobbleX: p.wobble * 10,
+      wobbleXRate: 2.3,
+      wobbleY: p.wobble * 10,
+      wobbleYRate: 1.7,
+    })
+  );
+  return set;
+}
+
 // ============================================================================
 // Spark Resolver
 // ============================================================================
@@ -188,7 +168,7 @@ export function verifyLiveness(
   const pubkeyBytes = base64ToBytes(pubkeyBase64);
   
   // Derive motion key (matching Mission Control's createParticles)
-  const motionKey = deriveBytes(pubkeyBytes.slice(0, 64), 'spark-motion-' + timestamp, 64);
+  const motionKey = deriveMotionSeed(pubkeyBytes, timestamp);
   
   // Get particle params
   const particles: ParticleParams[] = [];
@@ -216,16 +196,21 @@ export function verifyLiveness(
   
   const startTime = frames[0]?.timestamp || 0;
   
-  for (const frame of frames) {
-    const elapsed = frame.timestamp - startTime;
-    
+  // Every frame's expected positions in one batch
+  const expected = orbitPositions(
+    sparkOrbitSet(particles),
+    Float64Array.from(frames, (frame) => frame.timestamp - startTime)
+  );
+  
+  for (let f = 0; f < frames.length; f++) {
+    const frame = frames[f];
     for (let i = 0; i < Math.min(frame.particles.length, PARTICLE_COUNT); i++) {
       const observed = frame.particles[i];
-      const expected = getExpectedPosition(particles[i], elapsed);
+      const at = f * PARTICLE_COUNT + i;
       
       const distance = Math.sqrt(
-        (observed.x - expected.x) ** 2 +
-        (observed.y - expected.y) ** 2
+        (observed.x - expected.x[at]) ** 2 +
+        (observed.y - expected.y[at]) ** 2
       );
       
       // Match if within 10% of canvas
@@ -19,6 +19,8 @@ import {
   isNativeSparkScannerAvailable,
   ScanResult,
 } from './nativeSparkScanner';
+import { deriveBytes } from './sparkDerivation';
+import { createOrbitSet, orbitPositions, OrbitPositions, setOrbit } from './sparkOrbits';
 
 const { MlDsa87Module } = NativeModules;
 
@@ -99,39 +101,6 @@ export interface SparkAuthResult {
   scanResult?: ScanResult;
 }
 
-/**
- * HKDF-like derivation (matching Console implementation)
- */
-function simpleHash256(bytes: Uint8Array): Uint8Array {
-  const result = new Uint8Array(32);
-  for (let i = 0; i < 32; i++) {
-    let h = i * 0x9e3779b9;
-    for (let j = 0; j < bytes.length; j++) {
-      h = ((h << 5) + h + bytes[j]) >>> 0;
-    }
-    result[i] = h & 0xff;
-  }
-  return result;
-}
-
-function deriveBytes(key: Uint8Array, info: string, length: number): Uint8Array {
-  const result = new Uint8Array(length);
-  const infoBytes = new TextEncoder().encode(info);
-
-  for (let block = 0; block < Math.ceil(length / 32); block++) {
-    const input = new Uint8Array(key.length + infoBytes.length + 1);
-    input.set(key);
-    input.set(infoBytes, key.length);
-    input[key.length + infoBytes.length] = block;
-
-    const hash = simpleHash256(input);
-    const offset = block * 32;
-    const toCopy = Math.min(32, length - offset);
-    result.set(hash.slice(0, toCopy), offset);
-  }
-  return result;
-}
-
 /**
  * Derive motion parameters from challenge (same as Console)
  */
@@ -156,24 +125,21 @@ function deriveMotionParams(nonce: string, timestamp: number): {
 }
 
 /**
- * Compute expected particle positions at a given time
+ * Compute expected particle positions at each of `elapsedMs`, in one
+ * batch (particle i at elapsedMs[f] is at x[f * 12 + i])
  */
 function computeExpectedPositions(
   nonce: string,
   timestamp: number,
-  elapsedMs: number
-): { x: number; y: number }[] {
-  const t = elapsedMs / 1000;
+  elapsedMs: ArrayLike<number>
+): OrbitPositions {
   const { particles } = deriveMotionParams(nonce, timestamp);
-
-  return particles.map((p, i) => {
+  const orbits = createOrbitSet(particles.length, 0.5, 1);
+  particles.forEach((p, i) => {
     const direction = i % 2 === 0 ? 1 : -1; // Alternating direction
-    const angle = p.phase + t * p.speed * direction;
-    return {
-      x: 0.5 + Math.cos(angle) * p.radius,
-      y: 0.5 + Math.sin(angle) * p.radius,
-    };
+    setOrbit(orbits, i, { radius: p.radius, speed: p.speed * direction, phase: p.phase });
   });
+  return orbitPositions(orbits, elapsedMs);
 }
 
 /**
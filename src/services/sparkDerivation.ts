@@ -0,0 +1,143 @@
+/**
+ * Spark Derivation
+ *
+ * Deterministic key derivation shared by the Spark scanner (spark.ts) and
+ * Spark auth (sparkAuth.ts). It must match Mission Control's derivation bit
+ * for bit, or liveness verification fails.
+ *
+ * On Android, derivation runs natively (SparkScanner.motionKey /
+ * deriveBytes, the same code the scan engine verifies with). Elsewhere it
+ * uses the JS implementation below, which hashes its input in a single pass
+ * rather than once per output byte.
+ */
+
+import { NativeModules, Platform } from 'react-native';
+
+const { SparkScanner } = NativeModules;
+
+const HASH_BYTES = 32;
+const HASH_SEED = 0x9e3779b9;
+
+/**
+ * Motion key of a Spark pattern: 64 bytes derived from the first 64 bytes
+ * of the pubkey and the pattern's creation time.
+ */
+export function deriveMotionSeed(pubkeyBytes: Uint8Array, timestamp: number): Uint8Array {
+  const key = pubkeyBytes.subarray(0, 64);
+  if (Number.isSafeInteger(timestamp)) {
+    const native = callNative(() => SparkScanner.motionKey(bytesToBase64(key), timestamp), 64);
+    if (native) {
+      return native;
+    }
+  }
+  return deriveBytesJs(key, 'spark-motion-' + timestamp, 64);
+}
+
+/**
+ * HKDF-like expansion: simpleHash256(key || info || block) for each 32-byte
+ * block of output.
+ */
+export function deriveBytes(key: Uint8Array, info: string, length: number): Uint8Array {
+  const native = callNative(() => SparkScanner.deriveBytes(bytesToBase64(key), info, length), length);
+  return native ?? deriveBytesJs(key, info, length);
+}
+
+/**
+ * 32 multiplicative hashes (h = h * 33 + b) of `bytes`, seeded with
+ * i * 0x9e3779b9; byte i of the result is the low byte of hash i.
+ */
+export function simpleHash256(bytes: Uint8Array): Uint8Array {
+  const state = newHashState();
+  updateHash(state, bytes);
+  const result = new Uint8Array(HASH_BYTES);
+  finishHash(state, result, 0, HASH_BYTES);
+  return result;
+}
+
+function deriveBytesJs(key: Uint8Array, info: string, length: number): Uint8Array {
+  const result = new Uint8Array(length);
+  // Every block hashes key || info, so that prefix is hashed once.
+  const prefix = newHashState();
+  updateHash(prefix, key);
+  updateHash(prefix, new TextEncoder().encode(info));
+  const index = new Uint8Array(1);
+  for (let block = 0; block * HASH_BYTES < length; block++) {
+    const state = { ...prefix };
+    index[0] = block;
+    updateHash(state, index);
+    const offset = block * HASH_BYTES;
+    finishHash(state, result, offset, Math.min(HASH_BYTES, length - offset));
+  }
+  return result;
+}
+
+// ============================================================================
+// Hash
+// ============================================================================
+
+/**
+ * All 32 lanes of simpleHash256 run h -> h * 33 + b over the same bytes and
+ * differ only in their seed, so lane i ends at seed_i * 33^n + sum (mod
+ * 2^32), where sum is the hash started from 0: one pass for all lanes.
+ */
+interface HashState {
+  sum: number;
+  scale: number; // 33^n mod 2^32
+}
+
+function newHashState(): HashState {
+  return { sum: 0, scale: 1 };
+}
+
+function updateHash(state: HashState, bytes: Uint8Array): void {
+  let { sum, scale } = state;
+  for (let j = 0; j < bytes.length; j++) {
+    sum = (Math.imul(sum, 33) + bytes[j]) >>> 0;
+    scale = Math.imul(scale, 33);
+  }
+  state.sum = sum;
+  state.scale = scale;
+}
+
+function finishHash(state: HashState, out: Uint8Array, offset: number, count: number): void {
+  for (let i = 0; i < count; i++) {
+    out[offset + i] = (Math.imul(Math.imul(i, HASH_SEED), state.scale) + state.sum) & 0xff;
+  }
+}
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+function callNative(derive: () => string | null, length: number): Uint8Array | null {
+  if (Platform.OS !== 'android' || SparkScanner?.motionKey == null) {
+    return null;
+  }
+  try {
+    const base64 = derive();
+    if (base64 == null) {
+      return null;
+    }
+    const bytes = base64ToBytes(base64);
+    return bytes.length === length ? bytes : null;
+  } catch {
+    return null;
+  }
+}
+
+function bytesToBase64(bytes: Uint8Array): string {
+  let binary = '';
+  for (let i = 0; i < bytes.length; i++) {
+    binary += String.fromCharCode(bytes[i]);
+  }
+  return btoa(binary);
+}
+
+function base64ToBytes(base64: string): Uint8Array {
+  const binary = atob(base64);
+  const bytes = new Uint8Array(binary.length);
+  for (let i = 0; i < binary.length; i++) {
+    bytes[i] = binary.charCodeAt(i);
+  }
+  return bytes;
+}
@@ -0,0 +1,118 @@
+/**
+ * Spark Orbits
+ *
+ * Batch evaluation of orbiting particle positions, shared by liveness
+ * verification, the Spark auth challenge and the Lattice Code renderer.
+ * An OrbitSet keeps one typed-array column per orbit parameter, and
+ * orbitPositions() evaluates every particle at a whole array of times into
+ * reusable x/y columns instead of allocating a point per particle per frame.
+ *
+ * This runs in JS on every platform: a bridge call would copy and box every
+ * time and position, which costs more than the trig it saves. The native
+ * batch (estream_spark_orbit_positions) serves the C++ liveness verifier and
+ * Lattice Code renderer, which evaluate the same formula without crossing
+ * the bridge.
+ */
+
+/**
+ * Particle i at t = elapsedMs / 1000 seconds is at
+ *
+ *   x = (center + cos(phase + t * speed) * radius + sin(t * wobbleXRate) * wobbleX) / extent
+ *   y = (center + sin(phase + t * speed) * radius + cos(t * wobbleYRate) * wobbleY) / extent
+ *
+ * `speed` is signed: negative orbits turn the other way.
+ */
+export interface OrbitSet {
+  count: number;
+  center: number;
+  extent: number;
+  radius: Float64Array;
+  speed: Float64Array;
+  phase: Float64Array;
+  wobbleX: Float64Array;
+  wobbleXRate: Float64Array;
+  wobbleY: Float64Array;
+  wobbleYRate: Float64Array;
+}
+
+export interface Orbit {
+  radius: number;
+  speed: number;
+  phase: number;
+  wobbleX?: number;
+  wobbleXRate?: number;
+  wobbleY?: number;
+  wobbleYRate?: number;
+}
+
+/**
+ * Frame-major positions: particle i at elapsedMs[f] is at x[f * count + i].
+ */
+export interface OrbitPositions {
+  frames: number;
+  count: number;
+  x: Float64Array;
+  y: Float64Array;
+}
+
+export function createOrbitSet(count: number, center: number = 0, extent: number = 1): OrbitSet {
+  return {
+    count,
+    center,
+    extent,
+    radius: new Float64Array(count),
+    speed: new Float64Array(count),
+    phase: new Float64Array(count),
+    wobbleX: new Float64Array(count),
+    wobbleXRate: new Float64Array(count),
+    wobbleY: new Float64Array(count),
+    wobbleYRate: new Float64Array(count),
+  };
+}
+
+export function setOrbit(set: OrbitSet, i: number, orbit: Orbit): void {
+  set.radius[i] = orbit.radius;
+  set.speed[i] = orbit.speed;
+  set.phase[i] = orbit.phase;
+  set.wobbleX[i] = orbit.wobbleX ?? 0;
+  set.wobbleXRate[i] = orbit.wobbleXRate ?? 0;
+  set.wobbleY[i] = orbit.wobbleY ?? 0;
+  set.wobbleYRate[i] = orbit.wobbleYRate ?? 0;
+}
+
+export function createOrbitPositions(count: number, frames: number): OrbitPositions {
+  return {
+    frames,
+    count,
+    x: new Float64Array(count * frames),
+    y: new Float64Array(count * frames),
+  };
+}
+
+/**
+ * Evaluate `set` at every time in `elapsedMs`. Pass `out` to reuse its
+ * columns; it is replaced only if too small.
+ */
+export function orbitPositions(
+  set: OrbitSet,
+  elapsedMs: ArrayLike<number>,
+  out?: OrbitPositions
+): OrbitPositions {
+  const frames = elapsedMs.length;
+  const result = out && out.x.length >= frames * set.count ? out : createOrbitPositions(set.count, frames);
+  result.frames = frames;
+  result.count = set.count;
+  const { count, center, extent } = set;
+  for (let f = 0; f < frames; f++) {
+    const t = elapsedMs[f] / 1000;
+    const base = f * count;
+    for (let i = 0; i < count; i++) {
+      const angle = set.phase[i] + t * set.speed[i];
+      result.x[base + i] =
+        (center + Math.cos(angle) * set.radius[i] + Math.sin(t * set.wobbleXRate[i]) * set.wobbleX[i]) / extent;
+      result.y[base + i] =
+        (center + Math.sin(angle) * set.radius[i] + Math.cos(t * set.wobbleYRate[i]) * set.wobbleY[i]) / extent;
+    }
+  }
+  return result;
+}
@@ -11,7 +11,9 @@
 import { Image } from 'react-native';
 
 // Detection parameters
-const CAPTURE_INTERVAL_MS = 100; // 10 FPS for analysis
+// 10 FPS for the JS heuristic fallback. The native scanner analyzes at the
+// camera rate and adapts its resolution instead.
+export const CAPTURE_INTERVAL_MS = 100;
 const MIN_FRAMES = 30;
 const MIN_DURATION_MS = 2500;
 const BRIGHTNESS_THRESHOLD = 180;